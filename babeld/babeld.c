@@ -537,8 +537,14 @@ babel_distribute_update (struct distribute *dist)
     struct access_list *alist;
     struct prefix_list *plist;
 
-    if (! dist->ifname)
+    if (! dist->ifname) {
+        struct listnode *node;
+
+        /* Apply the new filters to the routes we already have. */
+        FOR_ALL_INTERFACES(ifp, node)
+            update_interface_metric(ifp);
         return;
+    }
 
     ifp = if_lookup_by_name (dist->ifname);
     if (ifp == NULL)
@@ -585,6 +591,8 @@ babel_distribute_update (struct distribute *dist)
     } else {
         babel_ifp->prefix[BABEL_FILTER_OUT] = NULL;
     }
+
+    update_interface_metric(ifp);
 }
 
 static void
@@ -603,9 +611,14 @@ babel_distribute_update_all (struct prefix_list *notused)
 {
     struct interface *ifp;
     struct listnode *node;
+    struct distribute *dist;
 
     for (ALL_LIST_ELEMENTS_RO (iflist, node, ifp))
         babel_distribute_update_interface (ifp);
+
+    dist = distribute_lookup (NULL);
+    if (dist)
+        babel_distribute_update (dist);
 }
 
 static void
@@ -43,6 +43,9 @@ THE SOFTWARE.
 
 #include <zebra.h>
 #include "if.h"
+#include "hash.h"
+#include "jhash.h"
+#include "pqueue.h"
 
 #include "babel_main.h"
 #include "babeld.h"
@@ -53,14 +56,55 @@ THE SOFTWARE.
 #include "babel_interface.h"
 
 struct timeval resend_time = {0, 0};
-struct resend *to_resend = NULL;
+
+/* Pending resends are indexed by (kind, prefix, plen), and kept in a
+   heap ordered by the time something next needs doing about them:
+   sending them again, or dropping them once they have expired. */
+static struct hash *resends = NULL;
+static struct pqueue *resend_queue = NULL;
+
+static unsigned int
+resend_hash_key(void *arg)
+{
+    struct resend *resend = arg;
+
+    return jhash(resend->prefix, 16, (resend->kind << 8) | resend->plen);
+}
+
+static int
+resend_hash_cmp(const void *arg1, const void *arg2)
+{
+    const struct resend *resend1 = arg1, *resend2 = arg2;
+
+    return (resend1->kind == resend2->kind &&
+            resend1->plen == resend2->plen &&
+            memcmp(resend1->prefix, resend2->prefix, 16) == 0);
+}
 
 static int
-resend_match(struct resend *resend,
-             int kind, const unsigned char *prefix, unsigned char plen)
+resend_queue_cmp(void *arg1, void *arg2)
+{
+    struct resend *resend1 = arg1, *resend2 = arg2;
+
+    return timeval_compare(&resend1->deadline, &resend2->deadline);
+}
+
+static void
+resend_queue_update(void *arg, int position)
 {
-    return (resend->kind == kind &&
-            resend->plen == plen && memcmp(resend->prefix, prefix, 16) == 0);
+    struct resend *resend = arg;
+
+    resend->heap_index = position;
+}
+
+static void
+resend_init(void)
+{
+    resends = hash_create_size(RESEND_HASH_SIZE,
+                               resend_hash_key, resend_hash_cmp);
+    resend_queue = pqueue_create();
+    resend_queue->cmp = resend_queue_cmp;
+    resend_queue->update = resend_queue_update;
 }
 
 /* This is called by neigh.c when a neighbour is flushed */
@@ -72,31 +116,88 @@ flush_resends(struct neighbour *neigh)
 }
 
 static struct resend *
-find_resend(int kind, const unsigned char *prefix, unsigned char plen,
-             struct resend **previous_return)
+find_resend(int kind, const unsigned char *prefix, unsigned char plen)
+{
+    struct resend key;
+
+    if(resends == NULL)
+        return NULL;
+
+    key.kind = kind;
+    memcpy(key.prefix, prefix, 16);
+    key.plen = plen;
+    return hash_lookup(resends, &key);
+}
+
+struct resend *
+find_request(const unsigned char *prefix, unsigned char plen)
 {
-    struct resend *current, *previous;
-
-    previous = NULL;
-    current = to_resend;
-    while(current) {
-        if(resend_match(current, kind, prefix, plen)) {
-            if(previous_return)
-                *previous_return = previous;
-            return current;
+    return find_resend(RESEND_REQUEST, prefix, plen);
+}
+
+/* Recompute the deadline of a resend after any of its timing fields
+   changed, and move it to its new place in the queue. */
+static void
+resend_reschedule(struct resend *resend)
+{
+    switch(resend->kind) {
+    case RESEND_REQUEST:
+        timeval_add_msec(&resend->deadline, &resend->time, REQUEST_TIMEOUT);
+        break;
+    default:
+        if(resend->max <= 0)
+            resend->deadline = resend->time;
+        else
+            resend->deadline.tv_sec = resend->deadline.tv_usec = 0;
+        break;
+    }
+
+    if(resend->delay > 0 && resend->max > 0) {
+        struct timeval timeout;
+        timeval_add_msec(&timeout, &resend->time, resend->delay);
+        timeval_min(&resend->deadline, &timeout);
+    }
+
+    if(resend->deadline.tv_sec == 0) {
+        /* Neither resent nor expired: nothing to schedule. */
+        if(resend->heap_index >= 0) {
+            pqueue_remove_at(resend->heap_index, resend_queue);
+            resend->heap_index = -1;
         }
-        previous = current;
-        current = current->next;
+    } else if(resend->heap_index < 0) {
+        pqueue_enqueue(resend, resend_queue);
+    } else {
+        trickle_up(resend->heap_index, resend_queue);
+        trickle_down(resend->heap_index, resend_queue);
     }
+}
 
-    return NULL;
+static void
+resend_free(struct resend *resend)
+{
+    hash_release(resends, resend);
+    if(resend->heap_index >= 0)
+        pqueue_remove_at(resend->heap_index, resend_queue);
+    free(resend);
 }
 
-struct resend *
-find_request(const unsigned char *prefix, unsigned char plen,
-             struct resend **previous_return)
+/* Take the resends whose deadline has passed off the queue. */
+static struct resend *
+resend_queue_due(void)
 {
-    return find_resend(RESEND_REQUEST, prefix, plen, previous_return);
+    struct resend *resend, *due = NULL;
+
+    while(resend_queue != NULL && resend_queue->size > 0) {
+        resend = resend_queue->array[0];
+        if(timeval_compare(&babel_now, &resend->deadline) < 0)
+            break;
+        pqueue_dequeue(resend_queue);
+        resend->heap_index = -1;
+        resend->next = due;
+        due = resend;
+    }
+
+    return due;
 }
 
 int
@@ -116,7 +217,10 @@ record_resend(int kind, const unsigned char *prefix, unsigned char plen,
     if(delay >= 0xFFFF)
         delay = 0xFFFF;
 
-    resend = find_resend(kind, prefix, plen, NULL);
+    if(resends == NULL)
+        resend_init();
+
+    resend = find_resend(kind, prefix, plen);
     if(resend) {
         if(resend->delay && delay)
             resend->delay = MIN(resend->delay, delay);
@@ -126,6 +230,8 @@ record_resend(int kind, const unsigned char *prefix, unsigned char plen,
         resend->max = RESEND_MAX;
         if(id && memcmp(resend->id, id, 8) == 0 &&
            seqno_compare(resend->seqno, seqno) > 0) {
+            resend_reschedule(resend);
+            recompute_resend_time();
             return 0;
         }
         if(id)
@@ -151,15 +257,12 @@ record_resend(int kind, const unsigned char *prefix, unsigned char plen,
             memset(resend->id, 0, 8);
         resend->ifp = ifp;
         resend->time = babel_now;
-        resend->next = to_resend;
-        to_resend = resend;
+        resend->heap_index = -1;
+        hash_get(resends, resend, hash_alloc_intern);
     }
 
-    if(resend->delay) {
-        struct timeval timeout;
-        timeval_add_msec(&timeout, &resend->time, resend->delay);
-        timeval_min(&resend_time, &timeout);
-    }
+    resend_reschedule(resend);
+    recompute_resend_time();
     return 1;
 }
 
@@ -180,7 +283,7 @@ unsatisfied_request(const unsigned char *prefix, unsigned char plen,
 {
     struct resend *request;
 
-    request = find_request(prefix, plen, NULL);
+    request = find_request(prefix, plen);
     if(request == NULL || resend_expired(request))
         return 0;
 
@@ -199,7 +302,7 @@ request_redundant(struct interface *ifp,
 {
     struct resend *request;
 
-    request = find_request(prefix, plen, NULL);
+    request = find_request(prefix, plen);
     if(request == NULL || resend_expired(request))
         return 0;
 
@@ -227,9 +330,9 @@ satisfy_request(const unsigned char *prefix, unsigned char plen,
                 unsigned short seqno, const unsigned char *id,
                 struct interface *ifp)
 {
-    struct resend *request, *previous;
+    struct resend *request;
 
-    request = find_request(prefix, plen, &previous);
+    request = find_request(prefix, plen);
     if(request == NULL)
         return 0;
 
@@ -238,10 +341,12 @@ satisfy_request(const unsigned char *prefix, unsigned char plen,
 
     if(memcmp(request->id, id, 8) != 0 ||
        seqno_compare(request->seqno, seqno) <= 0) {
-        /* We cannot remove the request, as we may be walking the list right
-           now.  Mark it as expired, so that expire_resend will remove it. */
+        /* We cannot remove the request, as do_resend may be walking the
+           resends that are due right now.  Mark it as expired, so that
+           expire_resend or do_resend will remove it. */
         request->max = 0;
         request->time.tv_sec = 0;
+        resend_reschedule(request);
         recompute_resend_time();
         return 1;
     }
@@ -252,59 +357,49 @@ satisfy_request(const unsigned char *prefix, unsigned char plen,
 void
 expire_resend()
 {
-    struct resend *current, *previous;
-    int recompute = 0;
-
-    previous = NULL;
-    current = to_resend;
-    while(current) {
-        if(resend_expired(current)) {
-            if(previous == NULL) {
-                to_resend = current->next;
-                free(current);
-                current = to_resend;
-            } else {
-                previous->next = current->next;
-                free(current);
-                current = previous->next;
-            }
-            recompute = 1;
-        } else {
-            previous = current;
-            current = current->next;
-        }
+    struct resend *resend, *due;
+
+    due = resend_queue_due();
+    while(due) {
+        resend = due;
+        due = resend->next;
+        if(resend_expired(resend))
+            resend_free(resend);
+        else
+            /* Due to be sent again, leave that to do_resend. */
+            resend_reschedule(resend);
     }
-    if(recompute)
-        recompute_resend_time();
+    recompute_resend_time();
 }
 
 void
 recompute_resend_time()
 {
-    struct resend *request;
-    struct timeval resend = {0, 0};
+    struct resend *resend;
 
-    request = to_resend;
-    while(request) {
-        if(!resend_expired(request) && request->delay > 0 && request->max > 0) {
-            struct timeval timeout;
-            timeval_add_msec(&timeout, &request->time, request->delay);
-            timeval_min(&resend, &timeout);
-        }
-        request = request->next;
+    if(resend_queue == NULL || resend_queue->size == 0) {
+        resend_time.tv_sec = resend_time.tv_usec = 0;
+        return;
     }
 
-    resend_time = resend;
+    resend = resend_queue->array[0];
+    resend_time = resend->deadline;
 }
 
 void
 do_resend()
 {
-    struct resend *resend;
-
-    resend = to_resend;
-    while(resend) {
-        if(!resend_expired(resend) && resend->delay > 0 && resend->max > 0) {
+    struct resend *resend, *due;
+
+    due = resend_queue_due();
+    while(due) {
+        resend = due;
+        due = resend->next;
+        if(resend_expired(resend)) {
+            resend_free(resend);
+            continue;
+        }
+        if(resend->delay > 0 && resend->max > 0) {
             struct timeval timeout;
             timeval_add_msec(&timeout, &resend->time, resend->delay);
             if(timeval_compare(&babel_now, &timeout) >= 0) {
@@ -324,7 +419,7 @@ do_resend()
                 resend->max--;
             }
         }
-        resend = resend->next;
+        resend_reschedule(resend);
     }
     recompute_resend_time();
 }
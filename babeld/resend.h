@@ -38,6 +38,7 @@ THE SOFTWARE.
 
 #define REQUEST_TIMEOUT 65000
 #define RESEND_MAX 3
+#define RESEND_HASH_SIZE 4096
 
 #define RESEND_REQUEST 1
 #define RESEND_UPDATE 2
@@ -52,13 +53,14 @@ struct resend {
     unsigned short seqno;
     unsigned char id[8];
     struct interface *ifp;
+    struct timeval deadline;    /* next resend or expiry */
+    int heap_index;
     struct resend *next;
 };
 
 extern struct timeval resend_time;
 
-struct resend *find_request(const unsigned char *prefix, unsigned char plen,
-                            struct resend **previous_return);
+struct resend *find_request(const unsigned char *prefix, unsigned char plen);
 void flush_resends(struct neighbour *neigh);
 int record_resend(int kind, const unsigned char *prefix, unsigned char plen,
                    unsigned short seqno, const unsigned char *id,
@@ -39,6 +39,9 @@ THE SOFTWARE.
 
 #include <zebra.h>
 #include "if.h"
+#include "prefix.h"
+#include "table.h"
+#include "pqueue.h"
 
 #include "babeld.h"
 #include "util.h"
@@ -53,66 +56,77 @@ THE SOFTWARE.
 
 static void consider_route(struct babel_route *route);
 
-struct babel_route **routes = NULL;
-static int route_slots = 0, max_route_slots = 0;
+static struct route_table *routes = NULL;
+static struct pqueue *route_queue = NULL;
+static struct babel_route *installed_routes = NULL;
+static int installed_route_count = 0;
 int kernel_metric = 0;
 int allow_duplicates = -1;
 int diversity_kind = DIVERSITY_NONE;
 int diversity_factor = 256;     /* in units of 1/256 */
 int keep_unfeasible = 0;
 
-/* We maintain a list of "slots", ordered by prefix.  Every slot
+/* We maintain a table of "slots", indexed by prefix.  Every slot
    contains a linked list of the routes to this prefix, with the
-   installed route, if any, at the head of the list. */
+   installed route, if any, at the head of the list.  Installed routes
+   are also linked together, and all routes are kept in a heap ordered
+   by the time they get old, so that expire_routes only looks at the
+   routes that are about to be flushed. */
+
+static time_t
+route_old_time(const struct babel_route *route)
+{
+    return route->time + route->hold_time * 7 / 8;
+}
 
 static int
-route_compare(const unsigned char *prefix, unsigned char plen,
-               struct babel_route *route)
+route_queue_cmp(void *arg1, void *arg2)
 {
-    int i = memcmp(prefix, route->src->prefix, 16);
-    if(i != 0)
-        return i;
+    time_t t1 = route_old_time(arg1), t2 = route_old_time(arg2);
 
-    if(plen < route->src->plen)
+    if(t1 < t2)
         return -1;
-    else if(plen > route->src->plen)
-        return 1;
-    else
-        return 0;
+    return t1 > t2;
 }
 
-/* Performs binary search, returns -1 in case of failure.  In the latter
-   case, new_return is the place where to insert the new element. */
-
-static int
-find_route_slot(const unsigned char *prefix, unsigned char plen,
-                int *new_return)
+static void
+route_queue_update(void *arg, int position)
 {
-    int p, m, g, c;
+    struct babel_route *route = arg;
 
-    if(route_slots < 1) {
-        if(new_return)
-            *new_return = 0;
-        return -1;
-    }
+    route->heap_index = position;
+}
+
+static void
+route_init(void)
+{
+    routes = route_table_init();
+    route_queue = pqueue_create();
+    route_queue->cmp = route_queue_cmp;
+    route_queue->update = route_queue_update;
+}
 
-    p = 0; g = route_slots - 1;
+static void
+route_prefix(struct prefix *p, const unsigned char *prefix, unsigned char plen)
+{
+    memset(p, 0, sizeof(struct prefix));
+    p->family = AF_INET6;
+    p->prefixlen = plen;
+    memcpy(&p->u.prefix6, prefix, 16);
+}
 
-    do {
-        m = (p + g) / 2;
-        c = route_compare(prefix, plen, routes[m]);
-        if(c == 0)
-            return m;
-        else if(c < 0)
-            g = m - 1;
-        else
-            p = m + 1;
-    } while(p <= g);
+/* Returns the slot of the given prefix, or NULL if there are no routes
+   to it. */
+static struct route_node *
+find_route_slot(const unsigned char *prefix, unsigned char plen)
+{
+    struct prefix p;
 
-    if(new_return)
-        *new_return = p;
+    if(routes == NULL)
+        return NULL;
 
-    return -1;
+    route_prefix(&p, prefix, plen);
+    return route_node_lookup_nolock(routes, &p);
 }
 
 struct babel_route *
@@ -120,12 +134,12 @@ find_route(const unsigned char *prefix, unsigned char plen,
            struct neighbour *neigh, const unsigned char *nexthop)
 {
     struct babel_route *route;
-    int i = find_route_slot(prefix, plen, NULL);
+    struct route_node *rn = find_route_slot(prefix, plen);
 
-    if(i < 0)
+    if(rn == NULL)
         return NULL;
 
-    route = routes[i];
+    route = rn->info;
 
     while(route) {
         if(route->neigh == neigh && memcmp(route->nexthop, nexthop, 16) == 0)
@@ -139,39 +153,51 @@ find_route(const unsigned char *prefix, unsigned char plen,
 struct babel_route *
 find_installed_route(const unsigned char *prefix, unsigned char plen)
 {
-    int i = find_route_slot(prefix, plen, NULL);
+    struct route_node *rn = find_route_slot(prefix, plen);
+    struct babel_route *route;
+
+    if(rn == NULL)
+        return NULL;
 
-    if(i >= 0 && routes[i]->installed)
-        return routes[i];
+    route = rn->info;
+    if(route->installed)
+        return route;
 
     return NULL;
 }
 
-/* Returns an overestimate of the number of installed routes. */
+/* Returns the number of installed routes. */
 int
 installed_routes_estimate(void)
 {
-    return route_slots;
+    return installed_route_count;
 }
 
-static int
-resize_route_table(int new_slots)
+/* Keeps the list of installed routes in step with route->installed. */
+static void
+set_route_installed(struct babel_route *route, int installed)
 {
-    struct babel_route **new_routes;
-    assert(new_slots >= route_slots);
+    if(route->installed == installed)
+        return;
 
-    if(new_slots == 0) {
-        new_routes = NULL;
-        free(routes);
+    route->installed = installed;
+    if(installed) {
+        route->installed_prev = NULL;
+        route->installed_next = installed_routes;
+        if(installed_routes)
+            installed_routes->installed_prev = route;
+        installed_routes = route;
+        installed_route_count++;
     } else {
-        new_routes = realloc(routes, new_slots * sizeof(struct babel_route*));
-        if(new_routes == NULL)
-            return -1;
+        if(route->installed_prev)
+            route->installed_prev->installed_next = route->installed_next;
+        else
+            installed_routes = route->installed_next;
+        if(route->installed_next)
+            route->installed_next->installed_prev = route->installed_prev;
+        route->installed_prev = route->installed_next = NULL;
+        installed_route_count--;
     }
-
-    max_route_slots = new_slots;
-    routes = new_routes;
-    return 1;
 }
 
 /* Insert a route into the table.  If successful, retains the route.
@@ -179,39 +205,38 @@ resize_route_table(int new_slots)
 static struct babel_route *
 insert_route(struct babel_route *route)
 {
-    int i, n;
+    struct route_node *rn;
+    struct prefix p;
 
     assert(!route->installed);
 
-    i = find_route_slot(route->src->prefix, route->src->plen, &n);
+    if(routes == NULL)
+        route_init();
 
-    if(i < 0) {
-        if(route_slots >= max_route_slots)
-            resize_route_table(max_route_slots < 1 ? 8 : 2 * max_route_slots);
-        if(route_slots >= max_route_slots)
-            return NULL;
-        route->next = NULL;
-        if(n < route_slots)
-            memmove(routes + n + 1, routes + n,
-                    (route_slots - n) * sizeof(struct babel_route*));
-        route_slots++;
-        routes[n] = route;
+    route_prefix(&p, route->src->prefix, route->src->plen);
+    rn = route_node_get(routes, &p);
+
+    route->next = NULL;
+    if(rn->info == NULL) {
+        rn->info = route;
     } else {
         struct babel_route *r;
-        r = routes[i];
+        r = rn->info;
         while(r->next)
             r = r->next;
         r->next = route;
-        route->next = NULL;
+        /* Only the first route holds a lock on the slot. */
+        route_unlock_node(rn);
     }
 
+    pqueue_enqueue(route, route_queue);
     return route;
 }
 
 void
 flush_route(struct babel_route *route)
 {
-    int i;
+    struct route_node *rn;
     struct source *src;
     unsigned oldmetric;
     int lost = 0;
@@ -224,28 +249,20 @@ flush_route(struct babel_route *route)
         lost = 1;
     }
 
-    i = find_route_slot(route->src->prefix, route->src->plen, NULL);
-    assert(i >= 0 && i < route_slots);
+    rn = find_route_slot(route->src->prefix, route->src->plen);
+    assert(rn != NULL);
 
-    if(route == routes[i]) {
-        routes[i] = route->next;
+    pqueue_remove_at(route->heap_index, route_queue);
+
+    if(route == rn->info) {
+        rn->info = route->next;
         route->next = NULL;
         free(route);
 
-        if(routes[i] == NULL) {
-            if(i < route_slots - 1)
-                memmove(routes + i, routes + i + 1,
-                        (route_slots - i - 1) * sizeof(struct babel_route*));
-            routes[route_slots - 1] = NULL;
-            route_slots--;
-        }
-
-        if(route_slots == 0)
-            resize_route_table(0);
-        else if(max_route_slots > 8 && route_slots < max_route_slots / 4)
-            resize_route_table(max_route_slots / 2);
+        if(rn->info == NULL)
+            route_unlock_node(rn);
     } else {
-        struct babel_route *r = routes[i];
+        struct babel_route *r = rn->info;
         while(r->next != route)
             r = r->next;
         r->next = route->next;
@@ -262,18 +279,19 @@ flush_route(struct babel_route *route)
 void
 flush_all_routes()
 {
-    int i;
+    struct route_node *rn;
+    struct babel_route *r;
 
-    /* Start from the end, to avoid shifting the table. */
-    i = route_slots - 1;
-    while(i >= 0) {
-        while(i < route_slots) {
-        /* Uninstall first, to avoid calling route_lost. */
-            if(routes[i]->installed)
-                uninstall_route(routes[0]);
-            flush_route(routes[i]);
+    if(routes == NULL)
+        return;
+
+    for(rn = route_top(routes); rn; rn = route_next(rn)) {
+        while((r = rn->info) != NULL) {
+            /* Uninstall first, to avoid calling route_lost. */
+            if(r->installed)
+                uninstall_route(r);
+            flush_route(r);
         }
-        i--;
     }
 
     check_sources_released();
@@ -282,45 +300,42 @@ flush_all_routes()
 void
 flush_neighbour_routes(struct neighbour *neigh)
 {
-    int i;
+    struct route_node *rn;
+    struct babel_route *r;
 
-    i = 0;
-    while(i < route_slots) {
-        struct babel_route *r;
-        r = routes[i];
-        while(r) {
+    if(routes == NULL)
+        return;
+
+    for(rn = route_top(routes); rn; rn = route_next(rn)) {
+    again:
+        for(r = rn->info; r; r = r->next) {
             if(r->neigh == neigh) {
+                /* Flushing may reorder the slot, start it over. */
                 flush_route(r);
                 goto again;
             }
-            r = r->next;
         }
-        i++;
-    again:
-        ;
     }
 }
 
 void
 flush_interface_routes(struct interface *ifp, int v4only)
 {
-    int i;
+    struct route_node *rn;
+    struct babel_route *r;
 
-    i = 0;
-    while(i < route_slots) {
-        struct babel_route *r;
-        r = routes[i];
-        while(r) {
+    if(routes == NULL)
+        return;
+
+    for(rn = route_top(routes); rn; rn = route_next(rn)) {
+    again:
+        for(r = rn->info; r; r = r->next) {
             if(r->neigh->ifp == ifp &&
                (!v4only || v4mapped(r->nexthop))) {
                 flush_route(r);
                 goto again;
             }
-            r = r->next;
         }
-        i++;
-    again:
-        ;
     }
 }
 
@@ -328,25 +343,26 @@ flush_interface_routes(struct interface *ifp, int v4only)
 void
 for_all_routes(void (*f)(struct babel_route*, void*), void *closure)
 {
-    int i;
+    struct route_node *rn;
+    struct babel_route *r;
+
+    if(routes == NULL)
+        return;
 
-    for(i = 0; i < route_slots; i++) {
-        struct babel_route *r = routes[i];
-        while(r) {
+    for(rn = route_top(routes); rn; rn = route_next(rn)) {
+        for(r = rn->info; r; r = r->next)
             (*f)(r, closure);
-            r = r->next;
-        }
     }
 }
 
 void
 for_all_installed_routes(void (*f)(struct babel_route*, void*), void *closure)
 {
-    int i;
+    struct babel_route *r, *next;
 
-    for(i = 0; i < route_slots; i++) {
-        if(routes[i]->installed)
-            (*f)(routes[i], closure);
+    for(r = installed_routes; r; r = next) {
+        next = r->installed_next;
+        (*f)(r, closure);
     }
 }
 
@@ -359,25 +375,27 @@ metric_to_kernel(int metric)
 /* This is used to maintain the invariant that the installed route is at
    the head of the list. */
 static void
-move_installed_route(struct babel_route *route, int i)
+move_installed_route(struct babel_route *route, struct route_node *rn)
 {
-    assert(i >= 0 && i < route_slots);
+    assert(rn != NULL);
     assert(route->installed);
 
-    if(route != routes[i]) {
-        struct babel_route *r = routes[i];
+    if(route != rn->info) {
+        struct babel_route *r = rn->info;
         while(r->next != route)
             r = r->next;
         r->next = route->next;
-        route->next = routes[i];
-        routes[i] = route;
+        route->next = rn->info;
+        rn->info = route;
     }
 }
 
 void
 install_route(struct babel_route *route)
 {
-    int i, rc;
+    struct route_node *rn;
+    struct babel_route *head;
+    int rc;
 
     if(route->installed)
         return;
@@ -386,10 +404,11 @@ install_route(struct babel_route *route)
         zlog_err("WARNING: installing unfeasible route "
                  "(this shouldn't happen).");
 
-    i = find_route_slot(route->src->prefix, route->src->plen, NULL);
-    assert(i >= 0 && i < route_slots);
+    rn = find_route_slot(route->src->prefix, route->src->plen);
+    assert(rn != NULL);
 
-    if(routes[i] != route && routes[i]->installed) {
+    head = rn->info;
+    if(head != route && head->installed) {
         fprintf(stderr, "WARNING: attempting to install duplicate route "
                 "(this shouldn't happen).");
         return;
@@ -405,8 +424,8 @@ install_route(struct babel_route *route)
         if(save != EEXIST)
             return;
     }
-    route->installed = 1;
-    move_installed_route(route, i);
+    set_route_installed(route, 1);
+    move_installed_route(route, rn);
 
 }
 
@@ -425,7 +444,7 @@ uninstall_route(struct babel_route *route)
     if(rc < 0)
         zlog_err("kernel_route(FLUSH): %s", safe_strerror(errno));
 
-    route->installed = 0;
+    set_route_installed(route, 0);
 }
 
 /* This is equivalent to uninstall_route followed with install_route,
@@ -459,10 +478,10 @@ switch_routes(struct babel_route *old, struct babel_route *new)
         return;
     }
 
-    old->installed = 0;
-    new->installed = 1;
-    move_installed_route(new, find_route_slot(new->src->prefix, new->src->plen,
-                                              NULL));
+    set_route_installed(old, 0);
+    set_route_installed(new, 1);
+    move_installed_route(new, find_route_slot(new->src->prefix,
+                                              new->src->plen));
 }
 
 static void
@@ -587,12 +606,12 @@ find_best_route(const unsigned char *prefix, unsigned char plen, int feasible,
                 struct neighbour *exclude)
 {
     struct babel_route *route = NULL, *r = NULL;
-    int i = find_route_slot(prefix, plen, NULL);
+    struct route_node *rn = find_route_slot(prefix, plen);
 
-    if(i < 0)
+    if(rn == NULL)
         return NULL;
 
-    route = routes[i];
+    route = rn->info;
 
     r = route->next;
     while(r) {
@@ -637,15 +656,14 @@ void
 update_neighbour_metric(struct neighbour *neigh, int changed)
 {
 
-    if(changed) {
-        int i;
+    if(changed && routes != NULL) {
+        struct route_node *rn;
+        struct babel_route *r;
 
-        for(i = 0; i < route_slots; i++) {
-            struct babel_route *r = routes[i];
-            while(r) {
+        for(rn = route_top(routes); rn; rn = route_next(rn)) {
+            for(r = rn->info; r; r = r->next) {
                 if(r->neigh == neigh)
                     update_route_metric(r);
-                r = r->next;
             }
         }
     }
@@ -654,14 +672,16 @@ update_neighbour_metric(struct neighbour *neigh, int changed)
 void
 update_interface_metric(struct interface *ifp)
 {
-    int i;
+    struct route_node *rn;
+    struct babel_route *r;
+
+    if(routes == NULL)
+        return;
 
-    for(i = 0; i < route_slots; i++) {
-        struct babel_route *r = routes[i];
-        while(r) {
+    for(rn = route_top(routes); rn; rn = route_next(rn)) {
+        for(r = rn->info; r; r = r->next) {
             if(r->neigh->ifp == ifp)
                 update_route_metric(r);
-            r = r->next;
         }
     }
 }
@@ -741,6 +761,8 @@ update_route(const unsigned char *router_id,
         change_route_metric(route,
                             refmetric, neighbour_cost(neigh), add_metric);
         route->hold_time = hold_time;
+        trickle_up(route->heap_index, route_queue);
+        trickle_down(route->heap_index, route_queue);
 
         route_changed(route, oldsrc, oldmetric);
         if(lost)
@@ -778,6 +800,7 @@ update_route(const unsigned char *router_id,
         route->time = babel_now.tv_sec;
         route->hold_time = hold_time;
         route->installed = 0;
+        route->installed_next = route->installed_prev = NULL;
         memset(&route->channels, 0, sizeof(route->channels));
         if(channels_len > 0)
             memcpy(&route->channels, channels,
@@ -862,11 +885,14 @@ consider_route(struct babel_route *route)
 void
 retract_neighbour_routes(struct neighbour *neigh)
 {
-    int i;
+    struct route_node *rn;
+    struct babel_route *r;
 
-    for(i = 0; i < route_slots; i++) {
-        struct babel_route *r = routes[i];
-        while(r) {
+    if(routes == NULL)
+        return;
+
+    for(rn = route_top(routes); rn; rn = route_next(rn)) {
+        for(r = rn->info; r; r = r->next) {
             if(r->neigh == neigh) {
                 if(r->refmetric != INFINITY) {
                     unsigned short oldmetric = route_metric(r);
@@ -875,9 +901,7 @@ retract_neighbour_routes(struct neighbour *neigh)
                         route_changed(r, r->src, oldmetric);
                 }
             }
-            r = r->next;
         }
-        i++;
     }
 }
 
@@ -982,38 +1006,19 @@ route_lost(struct source *src, unsigned oldmetric)
     }
 }
 
-/* This is called periodically to flush old routes.  It will also send
-   requests for routes that are about to expire. */
+/* This is called periodically to flush old routes.  Only the routes
+   at the top of the heap can be old. */
 void
 expire_routes(void)
 {
     struct babel_route *r;
-    int i;
 
     debugf(BABEL_DEBUG_COMMON,"Expiring old routes.");
 
-    i = 0;
-    while(i < route_slots) {
-        r = routes[i];
-        while(r) {
-            /* Protect against clock being stepped. */
-            if(r->time > babel_now.tv_sec || route_old(r)) {
-                flush_route(r);
-                goto again;
-            }
-
-            update_route_metric(r);
-
-            if(r->installed && r->refmetric < INFINITY) {
-                if(route_old(r))
-                    /* Route about to expire, send a request. */
-                    send_unicast_request(r->neigh,
-                                         r->src->prefix, r->src->plen);
-            }
-            r = r->next;
-        }
-        i++;
-    again:
-        ;
+    while(route_queue != NULL && route_queue->size > 0) {
+        r = route_queue->array[0];
+        if(!route_old(r))
+            break;
+        flush_route(r);
     }
 }
@@ -63,9 +63,10 @@ struct babel_route {
     short installed;
     unsigned char channels[DIVERSITY_HOPS];
     struct babel_route *next;
+    struct babel_route *installed_prev, *installed_next;
+    int heap_index;
 };
 
-extern struct babel_route **routes;
 extern int kernel_metric, allow_duplicates;
 extern int diversity_kind, diversity_factor;
 extern int keep_unfeasible;
@@ -41,6 +41,11 @@ THE SOFTWARE.
 #include <string.h>
 #include <sys/time.h>
 
+#include <zebra.h>
+#include "hash.h"
+#include "jhash.h"
+#include "pqueue.h"
+
 #include "babel_main.h"
 #include "babeld.h"
 #include "util.h"
@@ -48,26 +53,75 @@ THE SOFTWARE.
 #include "babel_interface.h"
 #include "route.h"
 
-struct source *srcs = NULL;
+/* Sources are indexed by (router-id, prefix, plen), and kept in a heap
+   ordered by the time they were last updated so that ageing only
+   looks at the sources that have expired.  A source that expires
+   while still in use by a route is taken off the heap until the last
+   route releases it. */
+static struct hash *sources = NULL;
+static struct pqueue *source_queue = NULL;
+
+static unsigned int
+source_hash_key(void *arg)
+{
+    struct source *src = arg;
+
+    return jhash(src->prefix, 16, jhash(src->id, 8, src->plen));
+}
+
+static int
+source_hash_cmp(const void *arg1, const void *arg2)
+{
+    const struct source *src1 = arg1, *src2 = arg2;
+
+    return (src1->plen == src2->plen &&
+            memcmp(src1->id, src2->id, 8) == 0 &&
+            memcmp(src1->prefix, src2->prefix, 16) == 0);
+}
+
+static int
+source_queue_cmp(void *arg1, void *arg2)
+{
+    struct source *src1 = arg1, *src2 = arg2;
+
+    if(src1->time < src2->time)
+        return -1;
+    return src1->time > src2->time;
+}
+
+static void
+source_queue_update(void *arg, int position)
+{
+    struct source *src = arg;
+
+    src->heap_index = position;
+}
+
+static void
+source_init(void)
+{
+    sources = hash_create_size(SOURCE_HASH_SIZE,
+                               source_hash_key, source_hash_cmp);
+    source_queue = pqueue_create();
+    source_queue->cmp = source_queue_cmp;
+    source_queue->update = source_queue_update;
+}
 
 struct source*
 find_source(const unsigned char *id, const unsigned char *p, unsigned char plen,
             int create, unsigned short seqno)
 {
-    struct source *src;
+    struct source key, *src;
 
-    for(src = srcs; src; src = src->next) {
-        /* This should really be a hash table.  For now, check the
-           last byte first. */
-        if(src->id[7] != id[7])
-            continue;
-        if(memcmp(src->id, id, 8) != 0)
-            continue;
-        if(src->plen != plen)
-            continue;
-        if(memcmp(src->prefix, p, 16) == 0)
-            return src;
-    }
+    if(sources == NULL)
+        source_init();
+
+    memcpy(key.id, id, 8);
+    memcpy(key.prefix, p, 16);
+    key.plen = plen;
+    src = hash_lookup(sources, &key);
+    if(src)
+        return src;
 
     if(!create)
         return NULL;
@@ -85,8 +139,8 @@ find_source(const unsigned char *id, const unsigned char *p, unsigned char plen,
     src->metric = INFINITY;
     src->time = babel_now.tv_sec;
     src->route_count = 0;
-    src->next = srcs;
-    srcs = src;
+    hash_get(sources, src, hash_alloc_intern);
+    pqueue_enqueue(src, source_queue);
     return src;
 }
 
@@ -103,6 +157,9 @@ release_source(struct source *src)
 {
     assert(src->route_count > 0);
     src->route_count--;
+    /* Resume ageing a source that expired while it was in use. */
+    if(src->route_count == 0 && src->heap_index < 0)
+        pqueue_enqueue(src, source_queue);
 }
 
 int
@@ -112,15 +169,9 @@ flush_source(struct source *src)
         /* The source is in use by a route. */
         return 0;
 
-    if(srcs == src) {
-        srcs = src->next;
-    } else {
-        struct source *previous = srcs;
-        while(previous->next != src)
-            previous = previous->next;
-        previous->next = src->next;
-    }
-
+    hash_release(sources, src);
+    if(src->heap_index >= 0)
+        pqueue_remove_at(src->heap_index, source_queue);
     free(src);
     return 1;
 }
@@ -143,6 +194,8 @@ update_source(struct source *src,
         src->metric = metric;
     }
     src->time = babel_now.tv_sec;
+    if(src->heap_index >= 0)
+        trickle_down(src->heap_index, source_queue);
 }
 
 void
@@ -150,31 +203,40 @@ expire_sources()
 {
     struct source *src;
 
-    src = srcs;
-    while(src) {
-        if(src->time > babel_now.tv_sec)
+    if(source_queue == NULL)
+        return;
+
+    while(source_queue->size > 0) {
+        src = source_queue->array[0];
+        if(src->time > babel_now.tv_sec) {
             /* clock stepped */
             src->time = babel_now.tv_sec;
-        if(src->time < babel_now.tv_sec - SOURCE_GC_TIME) {
-            struct source *old = src;
-            src = src->next;
-            flush_source(old);
+            trickle_down(0, source_queue);
             continue;
         }
-        src = src->next;
+        if(src->time >= babel_now.tv_sec - SOURCE_GC_TIME)
+            break;
+        pqueue_dequeue(source_queue);
+        src->heap_index = -1;
+        flush_source(src);
     }
 }
 
+static void
+check_source_released(struct hash_backet *backet, void *arg)
+{
+    struct source *src = backet->data;
+
+    if(src->route_count != 0)
+        fprintf(stderr, "Warning: source %s %s has refcount %d.\n",
+                format_eui64(src->id),
+                format_prefix(src->prefix, src->plen),
+                (int)src->route_count);
+}
+
 void
 check_sources_released(void)
 {
-    struct source *src;
-
-    for(src = srcs; src; src = src->next) {
-        if(src->route_count != 0)
-            fprintf(stderr, "Warning: source %s %s has refcount %d.\n",
-                    format_eui64(src->id),
-                    format_prefix(src->prefix, src->plen),
-                    (int)src->route_count);
-    }
+    if(sources != NULL)
+        hash_iterate(sources, check_source_released, NULL);
 }
@@ -40,9 +40,10 @@ THE SOFTWARE.
 #define BABEL_SOURCE_H
 
 #define SOURCE_GC_TIME 200
+#define SOURCE_HASH_SIZE 4096
 
 struct source {
-    struct source *next;
+    int heap_index;
     unsigned char id[8];
     unsigned char prefix[16];
     unsigned char plen;
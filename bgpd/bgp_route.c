@@ -6098,217 +6098,213 @@ enum bgp_show_type
   bgp_show_type_damp_neighbor
 };
 
+/* Show the routes of one node that pass the filter, returns how many. */
 static int
-bgp_show_table (struct vty *vty, struct bgp_table *table, struct in_addr *router_id,
-	  enum bgp_show_type type, void *output_arg)
+bgp_show_table_node (struct vty *vty, struct bgp_node *rn,
+		     struct in_addr *router_id, enum bgp_show_type type,
+		     void *output_arg, int *header)
 {
   struct bgp_info *ri;
-  struct bgp_node *rn;
-  int header = 1;
   int display;
-  unsigned long output_count;
 
-  /* This is first entry point, so reset total line. */
-  output_count = 0;
+  display = 0;
 
-  /* Start processing of routes. */
-  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn)) 
-    if (rn->info != NULL)
-      {
-	display = 0;
+  for (ri = rn->info; ri; ri = ri->next)
+    {
+      if (type == bgp_show_type_flap_statistics
+	  || type == bgp_show_type_flap_address
+	  || type == bgp_show_type_flap_prefix
+	  || type == bgp_show_type_flap_cidr_only
+	  || type == bgp_show_type_flap_regexp
+	  || type == bgp_show_type_flap_filter_list
+	  || type == bgp_show_type_flap_prefix_list
+	  || type == bgp_show_type_flap_prefix_longer
+	  || type == bgp_show_type_flap_route_map
+	  || type == bgp_show_type_flap_neighbor
+	  || type == bgp_show_type_dampend_paths
+	  || type == bgp_show_type_damp_neighbor)
+	{
+	  if (!(ri->extra && ri->extra->damp_info))
+	    continue;
+	}
+      if (type == bgp_show_type_regexp
+	  || type == bgp_show_type_flap_regexp)
+	{
+	  regex_t *regex = output_arg;
 
-	for (ri = rn->info; ri; ri = ri->next)
-	  {
-	    if (type == bgp_show_type_flap_statistics
-		|| type == bgp_show_type_flap_address
-		|| type == bgp_show_type_flap_prefix
-		|| type == bgp_show_type_flap_cidr_only
-		|| type == bgp_show_type_flap_regexp
-		|| type == bgp_show_type_flap_filter_list
-		|| type == bgp_show_type_flap_prefix_list
-		|| type == bgp_show_type_flap_prefix_longer
-		|| type == bgp_show_type_flap_route_map
-		|| type == bgp_show_type_flap_neighbor
-		|| type == bgp_show_type_dampend_paths
-		|| type == bgp_show_type_damp_neighbor)
-	      {
-		if (!(ri->extra && ri->extra->damp_info))
-		  continue;
-	      }
-	    if (type == bgp_show_type_regexp
-		|| type == bgp_show_type_flap_regexp)
-	      {
-		regex_t *regex = output_arg;
-		    
-		if (bgp_regexec (regex, ri->attr->aspath) == REG_NOMATCH)
-		  continue;
-	      }
-	    if (type == bgp_show_type_prefix_list
-		|| type == bgp_show_type_flap_prefix_list)
-	      {
-		struct prefix_list *plist = output_arg;
-		    
-		if (prefix_list_apply (plist, &rn->p) != PREFIX_PERMIT)
-		  continue;
-	      }
-	    if (type == bgp_show_type_filter_list
-		|| type == bgp_show_type_flap_filter_list)
-	      {
-		struct as_list *as_list = output_arg;
+	  if (bgp_regexec (regex, ri->attr->aspath) == REG_NOMATCH)
+	    continue;
+	}
+      if (type == bgp_show_type_prefix_list
+	  || type == bgp_show_type_flap_prefix_list)
+	{
+	  struct prefix_list *plist = output_arg;
 
-		if (as_list_apply (as_list, ri->attr->aspath) != AS_FILTER_PERMIT)
-		  continue;
-	      }
-	    if (type == bgp_show_type_route_map
-		|| type == bgp_show_type_flap_route_map)
-	      {
-		struct route_map *rmap = output_arg;
-		struct bgp_info binfo;
-		struct attr dummy_attr = { 0 }; 
-		int ret;
-
-		bgp_attr_dup (&dummy_attr, ri->attr);
-		binfo.peer = ri->peer;
-		binfo.attr = &dummy_attr;
-
-		ret = route_map_apply (rmap, &rn->p, RMAP_BGP, &binfo);
-		
-		bgp_attr_extra_free (&dummy_attr);
-		
-		if (ret == RMAP_DENYMATCH)
-		  continue;
-	      }
-	    if (type == bgp_show_type_neighbor
-		|| type == bgp_show_type_flap_neighbor
-		|| type == bgp_show_type_damp_neighbor)
-	      {
-		union sockunion *su = output_arg;
+	  if (prefix_list_apply (plist, &rn->p) != PREFIX_PERMIT)
+	    continue;
+	}
+      if (type == bgp_show_type_filter_list
+	  || type == bgp_show_type_flap_filter_list)
+	{
+	  struct as_list *as_list = output_arg;
 
-		if (ri->peer->su_remote == NULL || ! sockunion_same(ri->peer->su_remote, su))
-		  continue;
-	      }
-	    if (type == bgp_show_type_cidr_only
-		|| type == bgp_show_type_flap_cidr_only)
-	      {
-		u_int32_t destination;
-
-		destination = ntohl (rn->p.u.prefix4.s_addr);
-		if (IN_CLASSC (destination) && rn->p.prefixlen == 24)
-		  continue;
-		if (IN_CLASSB (destination) && rn->p.prefixlen == 16)
-		  continue;
-		if (IN_CLASSA (destination) && rn->p.prefixlen == 8)
-		  continue;
-	      }
-	    if (type == bgp_show_type_prefix_longer
-		|| type == bgp_show_type_flap_prefix_longer)
-	      {
-		struct prefix *p = output_arg;
+	  if (as_list_apply (as_list, ri->attr->aspath) != AS_FILTER_PERMIT)
+	    continue;
+	}
+      if (type == bgp_show_type_route_map
+	  || type == bgp_show_type_flap_route_map)
+	{
+	  struct route_map *rmap = output_arg;
+	  struct bgp_info binfo;
+	  struct attr dummy_attr = { 0 }; 
+	  int ret;
 
-		if (! prefix_match (p, &rn->p))
-		  continue;
-	      }
-	    if (type == bgp_show_type_community_all)
-	      {
-		if (! ri->attr->community)
-		  continue;
-	      }
-	    if (type == bgp_show_type_community)
-	      {
-		struct community *com = output_arg;
+	  bgp_attr_dup (&dummy_attr, ri->attr);
+	  binfo.peer = ri->peer;
+	  binfo.attr = &dummy_attr;
 
-		if (! ri->attr->community ||
-		    ! community_match (ri->attr->community, com))
-		  continue;
-	      }
-	    if (type == bgp_show_type_community_exact)
-	      {
-		struct community *com = output_arg;
+	  ret = route_map_apply (rmap, &rn->p, RMAP_BGP, &binfo);
 
-		if (! ri->attr->community ||
-		    ! community_cmp (ri->attr->community, com))
-		  continue;
-	      }
-	    if (type == bgp_show_type_community_list)
-	      {
-		struct community_list *list = output_arg;
+	  bgp_attr_extra_free (&dummy_attr);
 
-		if (! community_list_match (ri->attr->community, list))
-		  continue;
-	      }
-	    if (type == bgp_show_type_community_list_exact)
-	      {
-		struct community_list *list = output_arg;
+	  if (ret == RMAP_DENYMATCH)
+	    continue;
+	}
+      if (type == bgp_show_type_neighbor
+	  || type == bgp_show_type_flap_neighbor
+	  || type == bgp_show_type_damp_neighbor)
+	{
+	  union sockunion *su = output_arg;
 
-		if (! community_list_exact_match (ri->attr->community, list))
-		  continue;
-	      }
-	    if (type == bgp_show_type_flap_address
-		|| type == bgp_show_type_flap_prefix)
-	      {
-		struct prefix *p = output_arg;
+	  if (ri->peer->su_remote == NULL || ! sockunion_same(ri->peer->su_remote, su))
+	    continue;
+	}
+      if (type == bgp_show_type_cidr_only
+	  || type == bgp_show_type_flap_cidr_only)
+	{
+	  u_int32_t destination;
 
-		if (! prefix_match (&rn->p, p))
-		  continue;
+	  destination = ntohl (rn->p.u.prefix4.s_addr);
+	  if (IN_CLASSC (destination) && rn->p.prefixlen == 24)
+	    continue;
+	  if (IN_CLASSB (destination) && rn->p.prefixlen == 16)
+	    continue;
+	  if (IN_CLASSA (destination) && rn->p.prefixlen == 8)
+	    continue;
+	}
+      if (type == bgp_show_type_prefix_longer
+	  || type == bgp_show_type_flap_prefix_longer)
+	{
+	  struct prefix *p = output_arg;
 
-		if (type == bgp_show_type_flap_prefix)
-		  if (p->prefixlen != rn->p.prefixlen)
-		    continue;
-	      }
-	    if (type == bgp_show_type_dampend_paths
-		|| type == bgp_show_type_damp_neighbor)
-	      {
-		if (! CHECK_FLAG (ri->flags, BGP_INFO_DAMPED)
-		    || CHECK_FLAG (ri->flags, BGP_INFO_HISTORY))
-		  continue;
-	      }
+	  if (! prefix_match (p, &rn->p))
+	    continue;
+	}
+      if (type == bgp_show_type_community_all)
+	{
+	  if (! ri->attr->community)
+	    continue;
+	}
+      if (type == bgp_show_type_community)
+	{
+	  struct community *com = output_arg;
 
-	    if (header)
-	      {
-		vty_out (vty, "BGP table version is 0, local router ID is %s%s", inet_ntoa (*router_id), VTY_NEWLINE);
-		vty_out (vty, BGP_SHOW_SCODE_HEADER, VTY_NEWLINE, VTY_NEWLINE);
-		vty_out (vty, BGP_SHOW_OCODE_HEADER, VTY_NEWLINE, VTY_NEWLINE);
-		if (type == bgp_show_type_dampend_paths
-		    || type == bgp_show_type_damp_neighbor)
-		  vty_out (vty, BGP_SHOW_DAMP_HEADER, VTY_NEWLINE);
-		else if (type == bgp_show_type_flap_statistics
-			 || type == bgp_show_type_flap_address
-			 || type == bgp_show_type_flap_prefix
-			 || type == bgp_show_type_flap_cidr_only
-			 || type == bgp_show_type_flap_regexp
-			 || type == bgp_show_type_flap_filter_list
-			 || type == bgp_show_type_flap_prefix_list
-			 || type == bgp_show_type_flap_prefix_longer
-			 || type == bgp_show_type_flap_route_map
-			 || type == bgp_show_type_flap_neighbor)
-		  vty_out (vty, BGP_SHOW_FLAP_HEADER, VTY_NEWLINE);
-		else
-		  vty_out (vty, BGP_SHOW_HEADER, VTY_NEWLINE);
-		header = 0;
-	      }
+	  if (! ri->attr->community ||
+	      ! community_match (ri->attr->community, com))
+	    continue;
+	}
+      if (type == bgp_show_type_community_exact)
+	{
+	  struct community *com = output_arg;
 
-	    if (type == bgp_show_type_dampend_paths
-		|| type == bgp_show_type_damp_neighbor)
-	      damp_route_vty_out (vty, &rn->p, ri, display, SAFI_UNICAST);
-	    else if (type == bgp_show_type_flap_statistics
-		     || type == bgp_show_type_flap_address
-		     || type == bgp_show_type_flap_prefix
-		     || type == bgp_show_type_flap_cidr_only
-		     || type == bgp_show_type_flap_regexp
-		     || type == bgp_show_type_flap_filter_list
-		     || type == bgp_show_type_flap_prefix_list
-		     || type == bgp_show_type_flap_prefix_longer
-		     || type == bgp_show_type_flap_route_map
-		     || type == bgp_show_type_flap_neighbor)
-	      flap_route_vty_out (vty, &rn->p, ri, display, SAFI_UNICAST);
-	    else
-	      route_vty_out (vty, &rn->p, ri, display, SAFI_UNICAST);
-	    display++;
-	  }
-	if (display)
-	  output_count++;
-      }
+	  if (! ri->attr->community ||
+	      ! community_cmp (ri->attr->community, com))
+	    continue;
+	}
+      if (type == bgp_show_type_community_list)
+	{
+	  struct community_list *list = output_arg;
+
+	  if (! community_list_match (ri->attr->community, list))
+	    continue;
+	}
+      if (type == bgp_show_type_community_list_exact)
+	{
+	  struct community_list *list = output_arg;
+
+	  if (! community_list_exact_match (ri->attr->community, list))
+	    continue;
+	}
+      if (type == bgp_show_type_flap_address
+	  || type == bgp_show_type_flap_prefix)
+	{
+	  struct prefix *p = output_arg;
+
+	  if (! prefix_match (&rn->p, p))
+	    continue;
 
+	  if (type == bgp_show_type_flap_prefix)
+	    if (p->prefixlen != rn->p.prefixlen)
+	      continue;
+	}
+      if (type == bgp_show_type_dampend_paths
+	  || type == bgp_show_type_damp_neighbor)
+	{
+	  if (! CHECK_FLAG (ri->flags, BGP_INFO_DAMPED)
+	      || CHECK_FLAG (ri->flags, BGP_INFO_HISTORY))
+	    continue;
+	}
+
+      if (*header)
+	{
+	  vty_out (vty, "BGP table version is 0, local router ID is %s%s", inet_ntoa (*router_id), VTY_NEWLINE);
+	  vty_out (vty, BGP_SHOW_SCODE_HEADER, VTY_NEWLINE, VTY_NEWLINE);
+	  vty_out (vty, BGP_SHOW_OCODE_HEADER, VTY_NEWLINE, VTY_NEWLINE);
+	  if (type == bgp_show_type_dampend_paths
+	      || type == bgp_show_type_damp_neighbor)
+	    vty_out (vty, BGP_SHOW_DAMP_HEADER, VTY_NEWLINE);
+	  else if (type == bgp_show_type_flap_statistics
+		   || type == bgp_show_type_flap_address
+		   || type == bgp_show_type_flap_prefix
+		   || type == bgp_show_type_flap_cidr_only
+		   || type == bgp_show_type_flap_regexp
+		   || type == bgp_show_type_flap_filter_list
+		   || type == bgp_show_type_flap_prefix_list
+		   || type == bgp_show_type_flap_prefix_longer
+		   || type == bgp_show_type_flap_route_map
+		   || type == bgp_show_type_flap_neighbor)
+	    vty_out (vty, BGP_SHOW_FLAP_HEADER, VTY_NEWLINE);
+	  else
+	    vty_out (vty, BGP_SHOW_HEADER, VTY_NEWLINE);
+	  *header = 0;
+	}
+
+      if (type == bgp_show_type_dampend_paths
+	  || type == bgp_show_type_damp_neighbor)
+	damp_route_vty_out (vty, &rn->p, ri, display, SAFI_UNICAST);
+      else if (type == bgp_show_type_flap_statistics
+	       || type == bgp_show_type_flap_address
+	       || type == bgp_show_type_flap_prefix
+	       || type == bgp_show_type_flap_cidr_only
+	       || type == bgp_show_type_flap_regexp
+	       || type == bgp_show_type_flap_filter_list
+	       || type == bgp_show_type_flap_prefix_list
+	       || type == bgp_show_type_flap_prefix_longer
+	       || type == bgp_show_type_flap_route_map
+	       || type == bgp_show_type_flap_neighbor)
+	flap_route_vty_out (vty, &rn->p, ri, display, SAFI_UNICAST);
+      else
+	route_vty_out (vty, &rn->p, ri, display, SAFI_UNICAST);
+      display++;
+    }
+
+  return display;
+}
+
+static void
+bgp_show_table_total (struct vty *vty, enum bgp_show_type type,
+		      unsigned long output_count)
+{
   /* No route is displayed */
   if (output_count == 0)
     {
@@ -6318,30 +6314,203 @@ bgp_show_table (struct vty *vty, struct bgp_table *table, struct in_addr *router
   else
     vty_out (vty, "%sTotal number of prefixes %ld%s",
 	     VTY_NEWLINE, output_count, VTY_NEWLINE);
+}
+
+static int
+bgp_show_table (struct vty *vty, struct bgp_table *table, struct in_addr *router_id,
+	  enum bgp_show_type type, void *output_arg)
+{
+  struct bgp_node *rn;
+  int header = 1;
+  unsigned long output_count;
+
+  /* This is first entry point, so reset total line. */
+  output_count = 0;
+
+  /* Start processing of routes. */
+  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn)) 
+    if (rn->info != NULL)
+      if (bgp_show_table_node (vty, rn, router_id, type, output_arg, &header))
+	output_count++;
+
+  bgp_show_table_total (vty, type, output_count);
 
   return CMD_SUCCESS;
 }
 
+/* The table is shown a few nodes at a time as the vty wants more, see
+   vty_walk ().  The filter argument goes along with the walk: either
+   the walk owns it, or it is a named list that the configuration may
+   delete in the meantime, and is looked up again before each slice. */
+struct bgp_show_walk
+{
+  struct bgp_table *table;
+  struct bgp_node *rn;
+  struct in_addr router_id;
+  enum bgp_show_type type;
+  void *output_arg;
+  char *list_name;
+  afi_t afi;
+  int header;
+  unsigned long output_count;
+};
+
+#define BGP_SHOW_WALK_NODES 32
+
+/* Free a filter argument owned by a walk. */
+static void
+bgp_show_arg_free (enum bgp_show_type type, void *output_arg)
+{
+  switch (type)
+    {
+    case bgp_show_type_regexp:
+    case bgp_show_type_flap_regexp:
+      bgp_regex_free (output_arg);
+      break;
+    case bgp_show_type_prefix_longer:
+    case bgp_show_type_flap_prefix_longer:
+    case bgp_show_type_flap_address:
+    case bgp_show_type_flap_prefix:
+      prefix_free (output_arg);
+      break;
+    case bgp_show_type_community:
+    case bgp_show_type_community_exact:
+      community_free (output_arg);
+      break;
+    case bgp_show_type_neighbor:
+    case bgp_show_type_flap_neighbor:
+    case bgp_show_type_damp_neighbor:
+      sockunion_free (output_arg);
+      break;
+    default:
+      break;
+    }
+}
+
+/* Look up the named list a walk filters on, NULL if it is gone. */
+static void *
+bgp_show_list_lookup (enum bgp_show_type type, afi_t afi, const char *name)
+{
+  switch (type)
+    {
+    case bgp_show_type_prefix_list:
+    case bgp_show_type_flap_prefix_list:
+      return prefix_list_lookup (afi, name);
+    case bgp_show_type_filter_list:
+    case bgp_show_type_flap_filter_list:
+      return as_list_lookup (name);
+    case bgp_show_type_route_map:
+    case bgp_show_type_flap_route_map:
+      return route_map_lookup_by_name (name);
+    case bgp_show_type_community_list:
+    case bgp_show_type_community_list_exact:
+      return community_list_lookup (bgp_clist, name, COMMUNITY_LIST_MASTER);
+    default:
+      return NULL;
+    }
+}
+
+static void
+bgp_show_walk_free (void *arg)
+{
+  struct bgp_show_walk *walk = arg;
+
+  if (walk->rn)
+    bgp_unlock_node (walk->rn);
+  bgp_table_unlock (walk->table);
+  if (walk->output_arg)
+    bgp_show_arg_free (walk->type, walk->output_arg);
+  if (walk->list_name)
+    XFREE (MTYPE_TMP, walk->list_name);
+  XFREE (MTYPE_TMP, walk);
+}
+
 static int
-bgp_show (struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
-         enum bgp_show_type type, void *output_arg)
+bgp_show_walk (struct vty *vty, void *arg)
+{
+  struct bgp_show_walk *walk = arg;
+  void *output_arg = walk->output_arg;
+  int n;
+
+  if (walk->list_name)
+    {
+      output_arg = bgp_show_list_lookup (walk->type, walk->afi,
+					 walk->list_name);
+      if (output_arg == NULL)
+	{
+	  vty_out (vty, "%% %s has been deleted%s", walk->list_name,
+		   VTY_NEWLINE);
+	  return 0;
+	}
+    }
+
+  for (n = 0; walk->rn && n < BGP_SHOW_WALK_NODES;
+       n++, walk->rn = bgp_route_next (walk->rn))
+    if (walk->rn->info != NULL)
+      if (bgp_show_table_node (vty, walk->rn, &walk->router_id, walk->type,
+			       output_arg, &walk->header))
+	walk->output_count++;
+
+  if (walk->rn)
+    return 1;
+
+  bgp_show_table_total (vty, walk->type, walk->output_count);
+  return 0;
+}
+
+/* Start streaming a table.  OUTPUT_ARG, if any, is owned by the walk
+   from here on; LIST_NAME, if any, names the list to filter on. */
+static int
+bgp_show_start (struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
+		enum bgp_show_type type, void *output_arg,
+		const char *list_name)
 {
   struct bgp_table *table;
+  struct bgp_show_walk *walk;
 
-  if (bgp == NULL) {
+  if (bgp == NULL)
     bgp = bgp_get_default ();
-  }
 
   if (bgp == NULL)
     {
       vty_out (vty, "No BGP process is configured%s", VTY_NEWLINE);
+      if (output_arg)
+	bgp_show_arg_free (type, output_arg);
       return CMD_WARNING;
     }
 
-
   table = bgp->rib[afi][safi];
 
-  return bgp_show_table (vty, table, &bgp->router_id, type, output_arg);
+  walk = XCALLOC (MTYPE_TMP, sizeof (struct bgp_show_walk));
+  walk->table = table;
+  bgp_table_lock (table);
+  walk->rn = bgp_table_top (table);
+  walk->router_id = bgp->router_id;
+  walk->type = type;
+  walk->output_arg = output_arg;
+  if (list_name)
+    walk->list_name = XSTRDUP (MTYPE_TMP, list_name);
+  walk->afi = afi;
+  walk->header = 1;
+  return vty_walk (vty, bgp_show_walk, bgp_show_walk_free, walk);
+}
+
+/* Show the routes that pass the filter.  OUTPUT_ARG, if any, is
+   freed once the output is complete. */
+static int
+bgp_show (struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
+         enum bgp_show_type type, void *output_arg)
+{
+  return bgp_show_start (vty, bgp, afi, safi, type, output_arg, NULL);
+}
+
+/* Show the routes that pass the named list, which is looked up again as
+   the output streams. */
+static int
+bgp_show_list (struct vty *vty, afi_t afi, safi_t safi,
+	       enum bgp_show_type type, const char *list_name)
+{
+  return bgp_show_start (vty, NULL, afi, safi, type, NULL, list_name);
 }
 
 /* Header of detailed BGP route information */
@@ -7047,7 +7216,6 @@ bgp_show_regexp (struct vty *vty, int argc, const char **argv, afi_t afi,
   char *regstr;
   int first;
   regex_t *regex;
-  int rc;
   
   first = 0;
   b = buffer_new (1024);
@@ -7078,9 +7246,7 @@ bgp_show_regexp (struct vty *vty, int argc, const char **argv, afi_t afi,
       return CMD_WARNING;
     }
 
-  rc = bgp_show (vty, NULL, afi, safi, type, regex);
-  bgp_regex_free (regex);
-  return rc;
+  return bgp_show (vty, NULL, afi, safi, type, regex);
 }
 
 DEFUN (show_ip_bgp_regexp, 
@@ -7195,7 +7361,7 @@ bgp_show_prefix_list (struct vty *vty, const char *prefix_list_str, afi_t afi,
       return CMD_WARNING;
     }
 
-  return bgp_show (vty, NULL, afi, safi, type, plist);
+  return bgp_show_list (vty, afi, safi, type, prefix_list_str);
 }
 
 DEFUN (show_ip_bgp_prefix_list, 
@@ -7309,7 +7475,7 @@ bgp_show_filter_list (struct vty *vty, const char *filter, afi_t afi,
       return CMD_WARNING;
     }
 
-  return bgp_show (vty, NULL, afi, safi, type, as_list);
+  return bgp_show_list (vty, afi, safi, type, filter);
 }
 
 DEFUN (show_ip_bgp_filter_list, 
@@ -7424,7 +7590,7 @@ bgp_show_route_map (struct vty *vty, const char *rmap_str, afi_t afi,
       return CMD_WARNING;
     }
 
-  return bgp_show (vty, NULL, afi, safi, type, rmap);
+  return bgp_show_list (vty, afi, safi, type, rmap_str);
 }
 
 DEFUN (show_ip_bgp_route_map, 
@@ -8823,9 +8989,9 @@ bgp_show_community_list (struct vty *vty, const char *com, int exact,
       return CMD_WARNING;
     }
 
-  return bgp_show (vty, NULL, afi, safi,
-                   (exact ? bgp_show_type_community_list_exact :
-		            bgp_show_type_community_list), list);
+  return bgp_show_list (vty, afi, safi,
+			(exact ? bgp_show_type_community_list_exact :
+			 bgp_show_type_community_list), com);
 }
 
 DEFUN (show_ip_bgp_community_list,
@@ -9009,12 +9175,11 @@ bgp_show_prefix_longer (struct vty *vty, const char *prefix, afi_t afi,
   if (! ret)
     {
       vty_out (vty, "%% Malformed Prefix%s", VTY_NEWLINE);
+      prefix_free (p);
       return CMD_WARNING;
     }
 
-  ret = bgp_show (vty, NULL, afi, safi, type, p);
-  prefix_free(p);
-  return ret;
+  return bgp_show (vty, NULL, afi, safi, type, p);
 }
 
 DEFUN (show_ip_bgp_prefix_longer,
@@ -10451,7 +10616,8 @@ bgp_show_neighbor_route (struct vty *vty, struct peer *peer, afi_t afi,
       return CMD_WARNING;
     }
  
-  return bgp_show (vty, peer->bgp, afi, safi, type, &peer->su);
+  return bgp_show (vty, peer->bgp, afi, safi, type,
+		   sockunion_dup (&peer->su));
 }
 
 DEFUN (show_ip_bgp_neighbor_routes,
@@ -47,6 +47,7 @@
 #define freenode dict_freenode
 #define context dict_context
 #define dupes dict_dupes
+#define gen dict_gen
 
 #define dictptr dict_dictptr
 
@@ -57,6 +58,16 @@
 static dnode_t *dnode_alloc(void *context);
 static void dnode_free(dnode_t *node, void *context);
 
+/*
+ * Every change to a dictionary's membership stamps it with a new value
+ * of this counter, so that users can cheaply tell whether anything was
+ * inserted or deleted since they last looked.
+ */
+
+static unsigned long dict_gen_counter;
+
+#define dict_changed(D) ((D)->gen = ++dict_gen_counter)
+
 /*
  * Perform a ``left rotation'' adjustment on the tree.  The given node P and
  * its right child C are rearranged so that the P instead becomes the left
@@ -251,6 +262,7 @@ dict_t *dict_create(dictcount_t maxcount, dict_comp_t comp)
 	new->nilnode.parent = &new->nilnode;
 	new->nilnode.color = dnode_black;
 	new->dupes = 0;
+	dict_changed(new);
     }
     return new;
 }
@@ -293,6 +305,7 @@ void dict_free_nodes(dict_t *dict)
     dict->nodecount = 0;
     dict->nilnode.left = &dict->nilnode;
     dict->nilnode.right = &dict->nilnode;
+    dict_changed(dict);
 }
 
 /*
@@ -321,6 +334,7 @@ dict_t *dict_init(dict_t *dict, dictcount_t maxcount, dict_comp_t comp)
     dict->nilnode.parent = &dict->nilnode;
     dict->nilnode.color = dnode_black;
     dict->dupes = 0;
+    dict_changed(dict);
     return dict;
 }
 
@@ -341,6 +355,7 @@ void dict_init_like(dict_t *dict, const dict_t *template)
     dict->nilnode.parent = &dict->nilnode;
     dict->nilnode.color = dnode_black;
     dict->dupes = template->dupes;
+    dict_changed(dict);
 
     assert (dict_similar(dict, template));
 }
@@ -355,6 +370,7 @@ static void dict_clear(dict_t *dict)
     dict->nilnode.left = &dict->nilnode;
     dict->nilnode.right = &dict->nilnode;
     dict->nilnode.parent = &dict->nilnode;
+    dict_changed(dict);
     assert (dict->nilnode.color == dnode_black);
 }
 
@@ -540,6 +556,8 @@ void dict_insert(dict_t *dict, dnode_t *node, const void *key)
     assert (!dict_contains(dict, node));
     assert (!dnode_is_in_a_dict(node));
 
+    dict_changed(dict);
+
     /* basic binary tree insert */
 
     while (where != nil) {
@@ -634,6 +652,8 @@ dnode_t *dict_delete(dict_t *dict, dnode_t *delete)
     assert (!dict_isempty(dict));
     assert (dict_contains(dict, delete));
 
+    dict_changed(dict);
+
     /*
      * If the node being deleted has two children, then we replace it with its
      * successor (i.e. the leftmost node in the right subtree.) By doing this,
@@ -1041,6 +1061,7 @@ void dict_load_next(dict_load_t *load, dnode_t *newnode, const void *key)
     nil->right = newnode;
     newnode->left = nil;
     dict->nodecount++;
+    dict_changed(dict);
 }
 
 void dict_load_end(dict_load_t *load)
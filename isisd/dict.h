@@ -62,6 +62,7 @@ typedef struct dict_t {
     dnode_free_t dict_freenode;
     void *dict_context;
     int dict_dupes;
+    unsigned long dict_gen;
 } dict_t;
 
 typedef void (*dnode_process_t)(dict_t *, dnode_t *, void *);
@@ -112,6 +113,7 @@ extern void dict_merge(dict_t *, dict_t *);
 #define dict_isfull(D) ((D)->dict_nodecount == (D)->dict_maxcount)
 #define dict_count(D) ((D)->dict_nodecount)
 #define dict_isempty(D) ((D)->dict_nodecount == 0)
+#define dict_generation(D) ((D)->dict_gen)
 #define dnode_get(N) ((N)->dict_data)
 #define dnode_getkey(N) ((N)->dict_key)
 #define dnode_put(N, X) ((N)->dict_data = (X))
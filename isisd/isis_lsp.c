@@ -459,6 +459,7 @@ lsp_update_data (struct isis_lsp *lsp, struct stream *stream,
                  struct isis_area *area, int level)
 {
   uint32_t expected = 0, found;
+  struct tlv_view view;
   int retval;
 
   /* free the old lsp data */
@@ -500,12 +501,21 @@ lsp_update_data (struct isis_lsp *lsp, struct stream *stream,
   expected |= TLVFLAG_IPV6_REACHABILITY;
 #endif /* HAVE_IPV6 */
 
-  retval = parse_tlvs (area->area_tag, STREAM_DATA (lsp->pdu) +
-                       ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN,
-                       ntohs (lsp->lsp_header->pdu_len) -
-                       ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN,
-                       &expected, &found, &lsp->tlv_data,
-                       NULL);
+  /*
+   * Only the single valued TLVs are kept, the others are walked in the
+   * PDU when needed, see lsp_tlv_view().
+   */
+  retval = parse_tlv_view (area->area_tag, STREAM_DATA (lsp->pdu) +
+                           ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN,
+                           ntohs (lsp->lsp_header->pdu_len) -
+                           ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN,
+                           &expected, &found, &view, NULL);
+  lsp->tlv_data.checksum = view.checksum;
+  lsp->tlv_data.hostname = view.hostname;
+  lsp->tlv_data.nlpids = view.nlpids;
+  lsp->tlv_data.router_id = view.router_id;
+  memcpy (&lsp->tlv_data.auth_info, &view.auth_info,
+          sizeof (struct isis_passwd));
   if (retval != ISIS_OK)
     {
       zlog_warn ("Could not parse LSP");
@@ -522,6 +532,19 @@ lsp_update_data (struct isis_lsp *lsp, struct stream *stream,
   return;
 }
 
+/*
+ * The TLVs of an LSP, to be walked in place with TLV_VIEW_FOREACH.  Those
+ * received were checked by lsp_update_data(), our own are built right.
+ */
+void
+lsp_tlv_view (struct isis_lsp *lsp, struct tlv_view *view)
+{
+  tlv_view_init (view, STREAM_DATA (lsp->pdu) +
+                 ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN,
+                 ntohs (lsp->lsp_header->pdu_len) -
+                 ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN);
+}
+
 void
 lsp_update (struct isis_lsp *lsp, struct stream *stream,
             struct isis_area *area, int level)
@@ -823,7 +846,8 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
 {
   struct area_addr *area_addr;
   int i;
-  struct listnode *lnode;
+  struct tlv_view view;
+  struct tlv_iter iter;
   struct is_neigh *is_neigh;
   struct te_is_neigh *te_is_neigh;
   struct ipv4_reachability *ipv4_reach;
@@ -842,10 +866,10 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
 
   lspid_print (lsp->lsp_header->lsp_id, LSPid, dynhost, 1);
   lsp_print (lsp, vty, dynhost);
+  lsp_tlv_view (lsp, &view);
 
   /* for all area address */
-  if (lsp->tlv_data.area_addrs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.area_addrs, lnode, area_addr))
+  TLV_VIEW_FOREACH (&view, iter, AREA_ADDRESSES, area_addr)
       {
 	vty_out (vty, "  Area Address: %s%s",
 		 isonet_print (area_addr->area_addr, area_addr->addr_len),
@@ -897,16 +921,14 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
       vty_out (vty, "  Router ID   : %s%s", ipv4_address, VTY_NEWLINE);
     }
 
-  if (lsp->tlv_data.ipv4_addrs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_addrs, lnode, ipv4_addr))
+  TLV_VIEW_FOREACH (&view, iter, IPV4_ADDR, ipv4_addr)
       {
         memcpy (ipv4_address, inet_ntoa (*ipv4_addr), sizeof (ipv4_address));
         vty_out (vty, "  IPv4 Address: %s%s", ipv4_address, VTY_NEWLINE);
       }
 
   /* for the IS neighbor tlv */
-  if (lsp->tlv_data.is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, lnode, is_neigh))
+  TLV_VIEW_FOREACH (&view, iter, IS_NEIGHBOURS, is_neigh)
       {
 	lspid_print (is_neigh->neigh_id, LSPid, dynhost, 0);
 	vty_out (vty, "  Metric      : %-8d IS            : %s%s",
@@ -914,9 +936,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
       }
   
   /* for the internal reachable tlv */
-  if (lsp->tlv_data.ipv4_int_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_int_reachs, lnode,
-			       ipv4_reach))
+  TLV_VIEW_FOREACH (&view, iter, IPV4_INT_REACHABILITY, ipv4_reach)
     {
       memcpy (ipv4_reach_prefix, inet_ntoa (ipv4_reach->prefix),
 	      sizeof (ipv4_reach_prefix));
@@ -928,9 +948,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
     }
 
   /* for the external reachable tlv */
-  if (lsp->tlv_data.ipv4_ext_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_ext_reachs, lnode, 
-			       ipv4_reach))
+  TLV_VIEW_FOREACH (&view, iter, IPV4_EXT_REACHABILITY, ipv4_reach)
     {
       memcpy (ipv4_reach_prefix, inet_ntoa (ipv4_reach->prefix),
 	      sizeof (ipv4_reach_prefix));
@@ -943,8 +961,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
   
   /* IPv6 tlv */
 #ifdef HAVE_IPV6
-  if (lsp->tlv_data.ipv6_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv6_reachs, lnode, ipv6_reach))
+  TLV_VIEW_FOREACH (&view, iter, IPV6_REACHABILITY, ipv6_reach)
     {
       memset (&in6, 0, sizeof (in6));
       memcpy (in6.s6_addr, ipv6_reach->prefix,
@@ -962,26 +979,28 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
     }
 #endif
 
-  /* TE IS neighbor tlv */
-  if (lsp->tlv_data.te_is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, lnode, te_is_neigh))
+  /* The TE TLVs are only looked at with wide metrics, as
+     lsp_update_data() does. */
+  if (lsp->area && lsp->area->newmetric)
     {
-      lspid_print (te_is_neigh->neigh_id, LSPid, dynhost, 0);
-      vty_out (vty, "  Metric      : %-8d IS-Extended   : %s%s",
-	       GET_TE_METRIC(te_is_neigh), LSPid, VTY_NEWLINE);
-    }
+      /* TE IS neighbor tlv */
+      TLV_VIEW_FOREACH (&view, iter, TE_IS_NEIGHBOURS, te_is_neigh)
+	{
+	  lspid_print (te_is_neigh->neigh_id, LSPid, dynhost, 0);
+	  vty_out (vty, "  Metric      : %-8d IS-Extended   : %s%s",
+		   GET_TE_METRIC(te_is_neigh), LSPid, VTY_NEWLINE);
+	}
 
-  /* TE IPv4 tlv */
-  if (lsp->tlv_data.te_ipv4_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_ipv4_reachs, lnode,
-			       te_ipv4_reach))
-    {
-      /* FIXME: There should be better way to output this stuff. */
-      vty_out (vty, "  Metric      : %-8d IPv4-Extended : %s/%d%s",
-	       ntohl (te_ipv4_reach->te_metric),
-	       inet_ntoa (newprefix2inaddr (&te_ipv4_reach->prefix_start,
-					    te_ipv4_reach->control)),
-	       te_ipv4_reach->control & 0x3F, VTY_NEWLINE);
+      /* TE IPv4 tlv */
+      TLV_VIEW_FOREACH (&view, iter, TE_IPV4_REACHABILITY, te_ipv4_reach)
+	{
+	  /* FIXME: There should be better way to output this stuff. */
+	  vty_out (vty, "  Metric      : %-8d IPv4-Extended : %s/%d%s",
+		   ntohl (te_ipv4_reach->te_metric),
+		   inet_ntoa (newprefix2inaddr (&te_ipv4_reach->prefix_start,
+						te_ipv4_reach->control)),
+		   te_ipv4_reach->control & 0x3F, VTY_NEWLINE);
+	}
     }
   vty_out (vty, "%s", VTY_NEWLINE);
 
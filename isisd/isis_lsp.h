@@ -102,6 +102,7 @@ void lsp_purge_non_exist (struct isis_link_state_hdr *lsp_hdr,
 int lsp_id_cmp (u_char * id1, u_char * id2);
 int lsp_compare (char *areatag, struct isis_lsp *lsp, u_int32_t seq_num,
 		 u_int16_t checksum, u_int16_t rem_lifetime);
+void lsp_tlv_view (struct isis_lsp *lsp, struct tlv_view *view);
 void lsp_update (struct isis_lsp *lsp, struct stream *stream,
                  struct isis_area *area, int level);
 void lsp_inc_seqnum (struct isis_lsp *lsp, u_int32_t seq_num);
@@ -71,17 +71,18 @@ static u_char maskbit[] = {
  */
 
 /*
- * Compares two sets of area addresses
+ * Compares our area addresses with those of a PDU
  */
 static int
-area_match (struct list *left, struct list *right)
+area_match (struct list *left, struct tlv_view *right)
 {
   struct area_addr *addr1, *addr2;
-  struct listnode *node1, *node2;
+  struct listnode *node1;
+  struct tlv_iter iter;
 
   for (ALL_LIST_ELEMENTS_RO (left, node1, addr1))
   {
-    for (ALL_LIST_ELEMENTS_RO (right, node2, addr2))
+    TLV_VIEW_FOREACH (right, iter, AREA_ADDRESSES, addr2)
     {
       if (addr1->addr_len == addr2->addr_len &&
 	  !memcmp (addr1->area_addr, addr2->area_addr, (int) addr1->addr_len))
@@ -132,18 +133,19 @@ ip_same_subnet (struct prefix_ipv4 *ip1, struct in_addr *ip2)
  *                1   match;
  */
 static int
-ip_match (struct list *left, struct list *right)
+ip_match (struct list *left, struct tlv_view *right)
 {
   struct prefix_ipv4 *ip1;
   struct in_addr *ip2;
-  struct listnode *node1, *node2;
+  struct listnode *node1;
+  struct tlv_iter iter;
 
-  if ((left == NULL) || (right == NULL))
+  if (left == NULL)
     return 0;
   
   for (ALL_LIST_ELEMENTS_RO (left, node1, ip1))
   {
-    for (ALL_LIST_ELEMENTS_RO (right, node2, ip2))
+    TLV_VIEW_FOREACH (right, iter, IPV4_ADDR, ip2)
     {
       if (ip_same_subnet (ip1, ip2))
 	{
@@ -226,16 +228,17 @@ lsp_authentication_check (struct stream *stream, struct isis_area *area,
   struct isis_link_state_hdr *hdr;
   uint32_t expected = 0, found = 0, auth_tlv_offset = 0;
   uint16_t checksum, rem_lifetime, pdu_len;
-  struct tlvs tlvs;
+  struct tlv_view tlvs;
   int retval = ISIS_OK;
 
   hdr = (struct isis_link_state_hdr *) (STREAM_PNT (stream));
   pdu_len = ntohs (hdr->pdu_len);
   expected |= TLVFLAG_AUTH_INFO;
   auth_tlv_offset = stream_get_getp (stream) + ISIS_LSP_HDR_LEN;
-  retval = parse_tlvs (area->area_tag, STREAM_PNT (stream) + ISIS_LSP_HDR_LEN,
-                       pdu_len - ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN,
-                       &expected, &found, &tlvs, &auth_tlv_offset);
+  retval = parse_tlv_view (area->area_tag,
+                           STREAM_PNT (stream) + ISIS_LSP_HDR_LEN,
+                           pdu_len - ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN,
+                           &expected, &found, &tlvs, &auth_tlv_offset);
 
   if (retval != ISIS_OK)
     {
@@ -289,9 +292,9 @@ del_addr (void *val)
 }
 
 static void
-tlvs_to_adj_area_addrs (struct tlvs *tlvs, struct isis_adjacency *adj)
+tlvs_to_adj_area_addrs (struct tlv_view *tlvs, struct isis_adjacency *adj)
 {
-  struct listnode *node;
+  struct tlv_iter iter;
   struct area_addr *area_addr, *malloced;
 
   if (adj->area_addrs)
@@ -300,19 +303,16 @@ tlvs_to_adj_area_addrs (struct tlvs *tlvs, struct isis_adjacency *adj)
       list_delete (adj->area_addrs);
     }
   adj->area_addrs = list_new ();
-  if (tlvs->area_addrs)
-    {
-      for (ALL_LIST_ELEMENTS_RO (tlvs->area_addrs, node, area_addr))
-      {
-	malloced = XMALLOC (MTYPE_ISIS_TMP, sizeof (struct area_addr));
-	memcpy (malloced, area_addr, sizeof (struct area_addr));
-	listnode_add (adj->area_addrs, malloced);
-      }
-    }
+  TLV_VIEW_FOREACH (tlvs, iter, AREA_ADDRESSES, area_addr)
+  {
+    malloced = XMALLOC (MTYPE_ISIS_TMP, sizeof (struct area_addr));
+    memcpy (malloced, area_addr, sizeof (struct area_addr));
+    listnode_add (adj->area_addrs, malloced);
+  }
 }
 
 static void
-tlvs_to_adj_nlpids (struct tlvs *tlvs, struct isis_adjacency *adj)
+tlvs_to_adj_nlpids (struct tlv_view *tlvs, struct isis_adjacency *adj)
 {
   int i;
   struct nlpids *tlv_nlpids;
@@ -332,9 +332,9 @@ tlvs_to_adj_nlpids (struct tlvs *tlvs, struct isis_adjacency *adj)
 }
 
 static void
-tlvs_to_adj_ipv4_addrs (struct tlvs *tlvs, struct isis_adjacency *adj)
+tlvs_to_adj_ipv4_addrs (struct tlv_view *tlvs, struct isis_adjacency *adj)
 {
-  struct listnode *node;
+  struct tlv_iter iter;
   struct in_addr *ipv4_addr, *malloced;
 
   if (adj->ipv4_addrs)
@@ -343,22 +343,19 @@ tlvs_to_adj_ipv4_addrs (struct tlvs *tlvs, struct isis_adjacency *adj)
       list_delete (adj->ipv4_addrs);
     }
   adj->ipv4_addrs = list_new ();
-  if (tlvs->ipv4_addrs)
-    {
-      for (ALL_LIST_ELEMENTS_RO (tlvs->ipv4_addrs, node, ipv4_addr))
-      {
-	malloced = XMALLOC (MTYPE_ISIS_TMP, sizeof (struct in_addr));
-	memcpy (malloced, ipv4_addr, sizeof (struct in_addr));
-	listnode_add (adj->ipv4_addrs, malloced);
-      }
-    }
+  TLV_VIEW_FOREACH (tlvs, iter, IPV4_ADDR, ipv4_addr)
+  {
+    malloced = XMALLOC (MTYPE_ISIS_TMP, sizeof (struct in_addr));
+    memcpy (malloced, ipv4_addr, sizeof (struct in_addr));
+    listnode_add (adj->ipv4_addrs, malloced);
+  }
 }
 
 #ifdef HAVE_IPV6
 static void
-tlvs_to_adj_ipv6_addrs (struct tlvs *tlvs, struct isis_adjacency *adj)
+tlvs_to_adj_ipv6_addrs (struct tlv_view *tlvs, struct isis_adjacency *adj)
 {
-  struct listnode *node;
+  struct tlv_iter iter;
   struct in6_addr *ipv6_addr, *malloced;
 
   if (adj->ipv6_addrs)
@@ -367,16 +364,12 @@ tlvs_to_adj_ipv6_addrs (struct tlvs *tlvs, struct isis_adjacency *adj)
       list_delete (adj->ipv6_addrs);
     }
   adj->ipv6_addrs = list_new ();
-  if (tlvs->ipv6_addrs)
-    {
-      for (ALL_LIST_ELEMENTS_RO (tlvs->ipv6_addrs, node, ipv6_addr))
-      {
-	malloced = XMALLOC (MTYPE_ISIS_TMP, sizeof (struct in6_addr));
-	memcpy (malloced, ipv6_addr, sizeof (struct in6_addr));
-	listnode_add (adj->ipv6_addrs, malloced);
-      }
-    }
-
+  TLV_VIEW_FOREACH (tlvs, iter, IPV6_ADDR, ipv6_addr)
+  {
+    malloced = XMALLOC (MTYPE_ISIS_TMP, sizeof (struct in6_addr));
+    memcpy (malloced, ipv6_addr, sizeof (struct in6_addr));
+    listnode_add (adj->ipv6_addrs, malloced);
+  }
 }
 #endif /* HAVE_IPV6 */
 
@@ -398,7 +391,7 @@ process_p2p_hello (struct isis_circuit *circuit)
   struct isis_adjacency *adj;
   u_int32_t expected = 0, found = 0, auth_tlv_offset = 0;
   uint16_t pdu_len;
-  struct tlvs tlvs;
+  struct tlv_view tlvs;
 
   if (isis->debugs & DEBUG_ADJ_PACKETS)
     {
@@ -470,22 +463,20 @@ process_p2p_hello (struct isis_circuit *circuit)
   expected |= TLVFLAG_IPV6_ADDR;
 
   auth_tlv_offset = stream_get_getp (circuit->rcv_stream);
-  retval = parse_tlvs (circuit->area->area_tag,
-		       STREAM_PNT (circuit->rcv_stream),
-		       pdu_len - ISIS_P2PHELLO_HDRLEN - ISIS_FIXED_HDR_LEN,
-                       &expected, &found, &tlvs, &auth_tlv_offset);
+  retval = parse_tlv_view (circuit->area->area_tag,
+			   STREAM_PNT (circuit->rcv_stream),
+			   pdu_len - ISIS_P2PHELLO_HDRLEN - ISIS_FIXED_HDR_LEN,
+                           &expected, &found, &tlvs, &auth_tlv_offset);
 
   if (retval > ISIS_WARNING)
     {
-      zlog_warn ("parse_tlvs() failed");
-      free_tlvs (&tlvs);
+      zlog_warn ("parse_tlv_view() failed");
       return retval;
     };
 
   if (!(found & TLVFLAG_AREA_ADDRS))
     {
       zlog_warn ("No Area addresses TLV in P2P IS to IS hello");
-      free_tlvs (&tlvs);
       return ISIS_WARNING;
     }
 
@@ -499,7 +490,6 @@ process_p2p_hello (struct isis_circuit *circuit)
           isis_event_auth_failure (circuit->area->area_tag,
                                    "P2P hello authentication failure",
                                    hdr->source_id);
-          free_tlvs (&tlvs);
           return ISIS_OK;
         }
     }
@@ -508,11 +498,10 @@ process_p2p_hello (struct isis_circuit *circuit)
    * check if it's own interface ip match iih ip addrs
    */
   if ((found & TLVFLAG_IPV4_ADDR) == 0 ||
-      ip_match (circuit->ip_addrs, tlvs.ipv4_addrs) == 0)
+      ip_match (circuit->ip_addrs, &tlvs) == 0)
     {
       zlog_warn ("ISIS-Adj: No usable IP interface addresses "
                  "in LAN IIH from %s\n", circuit->interface->name);
-      free_tlvs (&tlvs);
       return ISIS_WARNING;
     }
 
@@ -564,7 +553,7 @@ process_p2p_hello (struct isis_circuit *circuit)
 		   (long) adj->hold_time);
 
   /* 8.2.5.2 a) a match was detected */
-  if (area_match (circuit->area->area_addrs, tlvs.area_addrs))
+  if (area_match (circuit->area->area_addrs, &tlvs))
     {
       /* 8.2.5.2 a) 2) If the system is L1 - table 5 */
       if (circuit->area->is_type == IS_LEVEL_1)
@@ -590,7 +579,6 @@ process_p2p_hello (struct isis_circuit *circuit)
 		{
 		  /* (7) reject - wrong system type event */
 		  zlog_warn ("wrongSystemType");
-                  free_tlvs (&tlvs);
 		  return ISIS_WARNING;	/* Reject */
 		}
 	      else if (adj->adj_usage == ISIS_ADJ_LEVEL1)
@@ -677,7 +665,6 @@ process_p2p_hello (struct isis_circuit *circuit)
 		{
 		  /* (5) reject - wrong system type event */
 		  zlog_warn ("wrongSystemType");
-                  free_tlvs (&tlvs);
 		  return ISIS_WARNING;	/* Reject */
 		}
 	      else if ((adj->adj_usage == ISIS_ADJ_LEVEL1AND2) ||
@@ -736,7 +723,6 @@ process_p2p_hello (struct isis_circuit *circuit)
 		{
 		  /* (6) reject - Area Mismatch event */
 		  zlog_warn ("AreaMismatch");
-                  free_tlvs (&tlvs);
 		  return ISIS_WARNING;	/* Reject */
 		}
 	      else if (adj->adj_usage == ISIS_ADJ_LEVEL1)
@@ -827,8 +813,6 @@ process_p2p_hello (struct isis_circuit *circuit)
 		  circuit->circuit_id, pdu_len);
     }
 
-  free_tlvs (&tlvs);
-
   return retval;
 }
 
@@ -842,9 +826,9 @@ process_lan_hello (int level, struct isis_circuit *circuit, u_char * ssnpa)
   struct isis_lan_hello_hdr hdr;
   struct isis_adjacency *adj;
   u_int32_t expected = 0, found = 0, auth_tlv_offset = 0;
-  struct tlvs tlvs;
+  struct tlv_view tlvs;
+  struct tlv_iter iter;
   u_char *snpa;
-  struct listnode *node;
 
   if (isis->debugs & DEBUG_ADJ_PACKETS)
     {
@@ -947,15 +931,15 @@ process_lan_hello (int level, struct isis_circuit *circuit, u_char * ssnpa)
   expected |= TLVFLAG_IPV6_ADDR;
 
   auth_tlv_offset = stream_get_getp (circuit->rcv_stream);
-  retval = parse_tlvs (circuit->area->area_tag,
-                       STREAM_PNT (circuit->rcv_stream),
-                       hdr.pdu_len - ISIS_LANHELLO_HDRLEN - ISIS_FIXED_HDR_LEN,
-                       &expected, &found, &tlvs,
-                       &auth_tlv_offset);
+  retval = parse_tlv_view (circuit->area->area_tag,
+                           STREAM_PNT (circuit->rcv_stream),
+                           hdr.pdu_len - ISIS_LANHELLO_HDRLEN -
+                           ISIS_FIXED_HDR_LEN,
+                           &expected, &found, &tlvs, &auth_tlv_offset);
 
   if (retval > ISIS_WARNING)
     {
-      zlog_warn ("parse_tlvs() failed");
+      zlog_warn ("parse_tlv_view() failed");
       goto out;
     }
 
@@ -988,7 +972,7 @@ process_lan_hello (int level, struct isis_circuit *circuit, u_char * ssnpa)
    */
   if (listcount (circuit->area->area_addrs) == 0 ||
       (level == IS_LEVEL_1 &&
-       area_match (circuit->area->area_addrs, tlvs.area_addrs) == 0))
+       area_match (circuit->area->area_addrs, &tlvs) == 0))
     {
       if (isis->debugs & DEBUG_ADJ_PACKETS)
 	{
@@ -1016,7 +1000,7 @@ process_lan_hello (int level, struct isis_circuit *circuit, u_char * ssnpa)
    * check if it's own interface ip match iih ip addrs
    */
   if ((found & TLVFLAG_IPV4_ADDR) == 0 ||
-      ip_match (circuit->ip_addrs, tlvs.ipv4_addrs) == 0)
+      ip_match (circuit->ip_addrs, &tlvs) == 0)
     {
       zlog_debug ("ISIS-Adj: No usable IP interface addresses "
                   "in LAN IIH from %s\n", circuit->interface->name);
@@ -1118,7 +1102,7 @@ process_lan_hello (int level, struct isis_circuit *circuit, u_char * ssnpa)
   {
     if (adj->adj_state != ISIS_ADJ_UP)
     {
-      for (ALL_LIST_ELEMENTS_RO (tlvs.lan_neighs, node, snpa))
+      TLV_VIEW_FOREACH (&tlvs, iter, LAN_NEIGHBOURS, snpa)
       {
         if (!memcmp (snpa, circuit->u.bc.snpa, ETH_ALEN))
         {
@@ -1130,7 +1114,7 @@ process_lan_hello (int level, struct isis_circuit *circuit, u_char * ssnpa)
     else
     {
       int found = 0;
-      for (ALL_LIST_ELEMENTS_RO (tlvs.lan_neighs, node, snpa))
+      TLV_VIEW_FOREACH (&tlvs, iter, LAN_NEIGHBOURS, snpa)
         if (!memcmp (snpa, circuit->u.bc.snpa, ETH_ALEN))
         {
           found = 1;
@@ -1159,8 +1143,6 @@ out:
 		  stream_get_endp (circuit->rcv_stream));
     }
 
-  free_tlvs (&tlvs);
-
   return retval;
 }
 
@@ -1531,9 +1513,10 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
   uint32_t found = 0, expected = 0, auth_tlv_offset = 0;
   struct isis_lsp *lsp;
   struct lsp_entry *entry;
-  struct listnode *node, *nnode;
+  struct listnode *node;
   struct listnode *node2, *nnode2;
-  struct tlvs tlvs;
+  struct tlv_view tlvs;
+  struct tlv_iter iter;
   struct list *lsp_list = NULL;
   struct isis_passwd *passwd;
 
@@ -1654,22 +1637,19 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 
   /* 7.3.15.2 a) 9 - Passwords for level 2 - not implemented  */
 
-  memset (&tlvs, 0, sizeof (struct tlvs));
-
   /* parse the SNP */
   expected |= TLVFLAG_LSP_ENTRIES;
   expected |= TLVFLAG_AUTH_INFO;
 
   auth_tlv_offset = stream_get_getp (circuit->rcv_stream);
-  retval = parse_tlvs (circuit->area->area_tag,
-		       STREAM_PNT (circuit->rcv_stream),
-		       pdu_len - stream_get_getp (circuit->rcv_stream),
-		       &expected, &found, &tlvs, &auth_tlv_offset);
+  retval = parse_tlv_view (circuit->area->area_tag,
+			   STREAM_PNT (circuit->rcv_stream),
+			   pdu_len - stream_get_getp (circuit->rcv_stream),
+			   &expected, &found, &tlvs, &auth_tlv_offset);
 
   if (retval > ISIS_WARNING)
     {
       zlog_warn ("something went very wrong processing SNP");
-      free_tlvs (&tlvs);
       return retval;
     }
 
@@ -1690,7 +1670,6 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
                                        "SNP authentication" " failure",
                                        phdr ? phdr->source_id :
                                        chdr->source_id);
-              free_tlvs (&tlvs);
               return ISIS_OK;
             }
         }
@@ -1703,9 +1682,9 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 		  circuit->area->area_tag,
 		  level,
 		  typechar, snpa_print (ssnpa), circuit->interface->name);
-      if (tlvs.lsp_entries)
+      if (found & TLVFLAG_LSP_ENTRIES)
 	{
-	  for (ALL_LIST_ELEMENTS_RO (tlvs.lsp_entries, node, entry))
+	  TLV_VIEW_FOREACH (&tlvs, iter, LSP_ENTRIES, entry)
 	  {
 	    zlog_debug ("ISIS-Snp (%s):         %cSNP entry %s, seq 0x%08x,"
 			" cksum 0x%04x, lifetime %us",
@@ -1719,9 +1698,9 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
     }
 
   /* 7.3.15.2 b) Actions on LSP_ENTRIES reported */
-  if (tlvs.lsp_entries)
+  if (found & TLVFLAG_LSP_ENTRIES)
     {
-      for (ALL_LIST_ELEMENTS_RO (tlvs.lsp_entries, node, entry))
+      TLV_VIEW_FOREACH (&tlvs, iter, LSP_ENTRIES, entry)
       {
 	lsp = lsp_search (entry->lsp_id, circuit->area->lspdb[level - 1]);
 	own_lsp = !memcmp (entry->lsp_id, isis->sysid, ISIS_SYS_ID_LEN);
@@ -1788,9 +1767,9 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 				 lsp_list, circuit->area->lspdb[level - 1]);
 
       /* Fixme: Find a better solution */
-      if (tlvs.lsp_entries)
+      if (found & TLVFLAG_LSP_ENTRIES)
 	{
-	  for (ALL_LIST_ELEMENTS (tlvs.lsp_entries, node, nnode, entry))
+	  TLV_VIEW_FOREACH (&tlvs, iter, LSP_ENTRIES, entry)
 	  {
 	    for (ALL_LIST_ELEMENTS (lsp_list, node2, nnode2, lsp))
 	    {
@@ -1810,7 +1789,6 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 
     }
 
-  free_tlvs (&tlvs);
   return retval;
 }
 
@@ -2456,51 +2434,79 @@ send_p2p_hello (struct thread *thread)
   return ISIS_OK;
 }
 
+/*
+ * Encoded CSNPs are cached per level and per number of LSP entries that
+ * fit in a PDU, and shared by all circuits of the area with that PDU
+ * size.  The cache keeps the LSPs each fragment covers; it is brought
+ * up to date when the LSP database has had LSPs inserted or deleted,
+ * re-encoding only from the first fragment whose LSPs changed.  The
+ * remaining lifetime ticks every second, and sequence numbers and
+ * checksums change in place, so those are copied into the entries (and
+ * the HMAC computed) each time a fragment is sent.
+ */
+struct isis_csnp_frag
+{
+  struct stream *pdu;
+  struct isis_lsp **lsps;	/* in the order of the entries */
+  unsigned int count;
+  unsigned long entries;	/* offset of the first LSP entry */
+  unsigned long auth_tlv_offset;	/* HMAC MD5 TLV, or 0 */
+  u_char stop[ISIS_SYS_ID_LEN + 2];
+};
+
+struct isis_csnp_cache
+{
+  u_char num_lsps;
+  dict_t *lspdb;
+  unsigned long generation;
+  u_char sysid[ISIS_SYS_ID_LEN];
+  struct isis_passwd passwd;
+  struct list *frags;
+};
+
+#define LSP_ENTRIES_PER_TLV (255 / LSP_ENTRIES_LEN)
+
 static int
 build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
-	    struct isis_circuit *circuit)
+	    struct isis_area *area, struct isis_csnp_frag *frag)
 {
   struct isis_fixed_hdr fixed_hdr;
   struct isis_passwd *passwd;
+  struct stream *s = frag->pdu;
   unsigned long lenp;
   u_int16_t length;
   unsigned char hmac_md5_hash[ISIS_AUTH_MD5_SIZE];
-  unsigned long auth_tlv_offset = 0;
   int retval = ISIS_OK;
 
-  if (circuit->snd_stream == NULL)
-    circuit->snd_stream = stream_new (ISO_MTU (circuit));
-  else
-    stream_reset (circuit->snd_stream);
+  stream_reset (s);
+  frag->auth_tlv_offset = 0;
 
   if (level == IS_LEVEL_1)
-    fill_fixed_hdr_andstream (&fixed_hdr, L1_COMPLETE_SEQ_NUM,
-			      circuit->snd_stream);
+    fill_fixed_hdr_andstream (&fixed_hdr, L1_COMPLETE_SEQ_NUM, s);
   else
-    fill_fixed_hdr_andstream (&fixed_hdr, L2_COMPLETE_SEQ_NUM,
-			      circuit->snd_stream);
+    fill_fixed_hdr_andstream (&fixed_hdr, L2_COMPLETE_SEQ_NUM, s);
 
   /*
    * Fill Level 1 or 2 Complete Sequence Numbers header
    */
 
-  lenp = stream_get_endp (circuit->snd_stream);
-  stream_putw (circuit->snd_stream, 0);	/* PDU length - when we know it */
+  lenp = stream_get_endp (s);
+  stream_putw (s, 0);		/* PDU length - when we know it */
   /* no need to send the source here, it is always us if we csnp */
-  stream_put (circuit->snd_stream, isis->sysid, ISIS_SYS_ID_LEN);
+  stream_put (s, isis->sysid, ISIS_SYS_ID_LEN);
   /* with zero circuit id - ref 9.10, 9.11 */
-  stream_putc (circuit->snd_stream, 0x00);
+  stream_putc (s, 0x00);
 
-  stream_put (circuit->snd_stream, start, ISIS_SYS_ID_LEN + 2);
-  stream_put (circuit->snd_stream, stop, ISIS_SYS_ID_LEN + 2);
+  stream_put (s, start, ISIS_SYS_ID_LEN + 2);
+  stream_put (s, stop, ISIS_SYS_ID_LEN + 2);
 
   /*
    * And TLVs
    */
   if (level == IS_LEVEL_1)
-    passwd = &circuit->area->area_passwd;
+    passwd = &area->area_passwd;
   else
-    passwd = &circuit->area->domain_passwd;
+    passwd = &area->domain_passwd;
 
   if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND))
   {
@@ -2509,17 +2515,17 @@ build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
       /* Cleartext */
       case ISIS_PASSWD_TYPE_CLEARTXT:
         if (tlv_add_authinfo (ISIS_PASSWD_TYPE_CLEARTXT, passwd->len,
-                              passwd->passwd, circuit->snd_stream))
+                              passwd->passwd, s))
           return ISIS_WARNING;
         break;
 
         /* HMAC MD5 */
       case ISIS_PASSWD_TYPE_HMAC_MD5:
         /* Remember where TLV is written so we can later overwrite the MD5 hash */
-        auth_tlv_offset = stream_get_endp (circuit->snd_stream);
+        frag->auth_tlv_offset = stream_get_endp (s);
         memset(&hmac_md5_hash, 0, ISIS_AUTH_MD5_SIZE);
         if (tlv_add_authinfo (ISIS_PASSWD_TYPE_HMAC_MD5, ISIS_AUTH_MD5_SIZE,
-                              hmac_md5_hash, circuit->snd_stream))
+                              hmac_md5_hash, s))
           return ISIS_WARNING;
         break;
 
@@ -2528,28 +2534,62 @@ build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
     }
   }
 
-  retval = tlv_add_lsp_entries (lsps, circuit->snd_stream);
+  /* Past the TLV header. */
+  frag->entries = stream_get_endp (s) + 2;
+  retval = tlv_add_lsp_entries (lsps, s);
   if (retval != ISIS_OK)
     return retval;
 
-  length = (u_int16_t) stream_get_endp (circuit->snd_stream);
+  length = (u_int16_t) stream_get_endp (s);
   /* Update PU length */
-  stream_putw_at (circuit->snd_stream, lenp, length);
+  stream_putw_at (s, lenp, length);
+
+  /* The MD5 hash is computed when the PDU is sent. */
+  return retval;
+}
+
+static u_char *
+csnp_frag_entry (struct isis_csnp_frag *frag, unsigned int i)
+{
+  return STREAM_DATA (frag->pdu) + frag->entries
+    + (i / LSP_ENTRIES_PER_TLV) * MAX_LSP_ENTRIES_TLV_SIZE
+    + (i % LSP_ENTRIES_PER_TLV) * LSP_ENTRIES_LEN;
+}
+
+/*
+ * Bring the changing parts of a cached CSNP up to date before sending it.
+ */
+static void
+csnp_frag_refresh (struct isis_csnp_frag *frag, struct isis_passwd *passwd)
+{
+  struct isis_lsp *lsp;
+  unsigned char hmac_md5_hash[ISIS_AUTH_MD5_SIZE];
+  u_char *pos;
+  unsigned int i;
+
+  for (i = 0; i < frag->count; i++)
+    {
+      lsp = frag->lsps[i];
+      pos = csnp_frag_entry (frag, i);
+      memcpy (pos, &lsp->lsp_header->rem_lifetime, 2);
+      pos += 2 + ISIS_SYS_ID_LEN + 2;
+      memcpy (pos, &lsp->lsp_header->seq_num, 4);
+      pos += 4;
+      memcpy (pos, &lsp->lsp_header->checksum, 2);
+    }
 
   /* For HMAC MD5 we need to compute the md5 hash and store it */
-  if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND) &&
-      passwd->type == ISIS_PASSWD_TYPE_HMAC_MD5)
+  if (frag->auth_tlv_offset)
     {
-      hmac_md5 (STREAM_DATA (circuit->snd_stream),
-                stream_get_endp(circuit->snd_stream),
+      memset (STREAM_DATA (frag->pdu) + frag->auth_tlv_offset + 3, 0,
+	      ISIS_AUTH_MD5_SIZE);
+      hmac_md5 (STREAM_DATA (frag->pdu), stream_get_endp (frag->pdu),
                 (unsigned char *) &passwd->passwd, passwd->len,
                 (caddr_t) &hmac_md5_hash);
       /* Copy the hash into the stream */
-      memcpy (STREAM_DATA (circuit->snd_stream) + auth_tlv_offset + 3,
+      memcpy (STREAM_DATA (frag->pdu) + frag->auth_tlv_offset + 3,
               hmac_md5_hash, ISIS_AUTH_MD5_SIZE);
     }
-
-  return retval;
 }
 
 /*
@@ -2634,65 +2674,282 @@ max_lsps_per_snp (int snp_type, int level, struct isis_circuit *circuit)
   return lsp_count;
 }
 
+static void
+csnp_frag_free (void *arg)
+{
+  struct isis_csnp_frag *frag = arg;
+
+  stream_free (frag->pdu);
+  if (frag->lsps)
+    XFREE (MTYPE_ISIS_CSNP, frag->lsps);
+  XFREE (MTYPE_ISIS_CSNP, frag);
+}
+
+static void
+csnp_cache_free (void *arg)
+{
+  struct isis_csnp_cache *cache = arg;
+
+  list_delete (cache->frags);
+  XFREE (MTYPE_ISIS_CSNP, cache);
+}
+
+void
+isis_csnp_cache_flush (struct isis_area *area, int level)
+{
+  if (area->csnp_cache[level - 1])
+    {
+      list_delete (area->csnp_cache[level - 1]);
+      area->csnp_cache[level - 1] = NULL;
+    }
+}
+
+static int
+csnp_passwd_same (struct isis_passwd *p1, struct isis_passwd *p2)
+{
+  return (p1->type == p2->type && p1->len == p2->len
+	  && p1->snp_auth == p2->snp_auth
+	  && memcmp (p1->passwd, p2->passwd, p1->len) == 0);
+}
+
 /*
- * FIXME: support multiple CSNPs
+ * Whether the LSPs of a cached fragment are still the ones the database
+ * would give, starting from *dnode; moves *dnode past them.  LSPs that
+ * went away may have been freed, so compare IDs too.
  */
+static int
+csnp_frag_valid (struct isis_csnp_frag *frag, u_char num_lsps,
+		 dict_t * lspdb, dnode_t ** dnode)
+{
+  struct isis_lsp *lsp;
+  unsigned int i;
 
-int
-send_csnp (struct isis_circuit *circuit, int level)
+  for (i = 0; i < frag->count; i++)
+    {
+      if (*dnode == NULL)
+	return 0;
+      lsp = dnode_get (*dnode);
+      if (lsp != frag->lsps[i]
+	  || memcmp (csnp_frag_entry (frag, i) + 2, lsp->lsp_header->lsp_id,
+		     ISIS_SYS_ID_LEN + 2))
+	return 0;
+      *dnode = dict_next (lspdb, *dnode);
+    }
+
+  /* A short fragment ended the database. */
+  return frag->count == num_lsps || *dnode == NULL;
+}
+
+/*
+ * Encode CSNP fragments from start to the end of the database, as
+ * send_csnp always did, and append them to the cache.
+ */
+static int
+csnp_cache_build (struct isis_csnp_cache *cache, struct isis_circuit *circuit,
+		  int level, u_char * start)
 {
-  u_char start[ISIS_SYS_ID_LEN + 2];
   u_char stop[ISIS_SYS_ID_LEN + 2];
-  struct list *list = NULL;
+  struct isis_csnp_frag *frag;
+  struct list *list;
   struct listnode *node;
   struct isis_lsp *lsp;
-  u_char num_lsps, loop = 1;
+  u_char loop = 1;
   int i, retval = ISIS_OK;
 
-  if (circuit->area->lspdb[level - 1] == NULL ||
-      dict_count (circuit->area->lspdb[level - 1]) == 0)
-    return retval;
-
-  memset (start, 0x00, ISIS_SYS_ID_LEN + 2);
-  memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
-
-  num_lsps = max_lsps_per_snp (ISIS_SNP_CSNP_FLAG, level, circuit);
-
   while (loop)
     {
+      memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
       list = list_new ();
-      lsp_build_list (start, stop, num_lsps, list,
-                      circuit->area->lspdb[level - 1]);
+      lsp_build_list (start, stop, cache->num_lsps, list, cache->lspdb);
       /*
        * Update the stop lsp_id before encoding this CSNP.
        */
-      if (listcount (list) < num_lsps)
-        {
-          memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
-        }
-      else
+      if (listcount (list) >= cache->num_lsps)
         {
           node = listtail (list);
           lsp = listgetdata (node);
           memcpy (stop, lsp->lsp_header->lsp_id, ISIS_SYS_ID_LEN + 2);
         }
 
-      retval = build_csnp (level, start, stop, list, circuit);
+      frag = XCALLOC (MTYPE_ISIS_CSNP, sizeof (struct isis_csnp_frag));
+      frag->pdu = stream_new (stream_get_size (circuit->snd_stream));
+      memcpy (frag->stop, stop, ISIS_SYS_ID_LEN + 2);
+      if (listcount (list))
+        frag->lsps = XMALLOC (MTYPE_ISIS_CSNP,
+                              listcount (list) * sizeof (struct isis_lsp *));
+      for (ALL_LIST_ELEMENTS_RO (list, node, lsp))
+        frag->lsps[frag->count++] = lsp;
+
+      retval = build_csnp (level, start, stop, list, circuit->area, frag);
+      list_delete (list);
       if (retval != ISIS_OK)
         {
-          zlog_err ("ISIS-Snp (%s): Build L%d CSNP on %s failed",
-                    circuit->area->area_tag, level, circuit->interface->name);
-          list_delete (list);
+          csnp_frag_free (frag);
           return retval;
         }
+      listnode_add (cache->frags, frag);
+
+      /*
+       * Start lsp_id of the next CSNP should be one plus the
+       * stop lsp_id in this current CSNP.
+       */
+      memcpy (start, stop, ISIS_SYS_ID_LEN + 2);
+      loop = 0;
+      for (i = ISIS_SYS_ID_LEN + 1; i >= 0; --i)
+        {
+          if (start[i] < (u_char)0xff)
+            {
+              start[i] += 1;
+              loop = 1;
+              break;
+            }
+        }
+    }
+
+  return retval;
+}
+
+/*
+ * Find the CSNPs for a circuit's PDU size, updating them to the
+ * current LSP database.
+ */
+static struct isis_csnp_cache *
+csnp_cache_get (struct isis_circuit *circuit, int level, u_char num_lsps)
+{
+  struct isis_area *area = circuit->area;
+  dict_t *lspdb = area->lspdb[level - 1];
+  struct isis_passwd *passwd;
+  struct isis_csnp_cache *cache = NULL;
+  struct isis_csnp_frag *frag;
+  struct listnode *node, *nnode;
+  dnode_t *dnode;
+  u_char start[ISIS_SYS_ID_LEN + 2];
+  int i, resume;
+
+  if (level == IS_LEVEL_1)
+    passwd = &area->area_passwd;
+  else
+    passwd = &area->domain_passwd;
+
+  if (area->csnp_cache[level - 1] == NULL)
+    {
+      area->csnp_cache[level - 1] = list_new ();
+      area->csnp_cache[level - 1]->del = csnp_cache_free;
+    }
+  for (ALL_LIST_ELEMENTS_RO (area->csnp_cache[level - 1], node, cache))
+    if (cache->num_lsps == num_lsps)
+      break;
+  if (node == NULL)
+    {
+      cache = XCALLOC (MTYPE_ISIS_CSNP, sizeof (struct isis_csnp_cache));
+      cache->num_lsps = num_lsps;
+      cache->frags = list_new ();
+      cache->frags->del = csnp_frag_free;
+      listnode_add (area->csnp_cache[level - 1], cache);
+    }
+
+  /* The header and authentication are the same in every fragment. */
+  if (cache->lspdb != lspdb
+      || memcmp (cache->sysid, isis->sysid, ISIS_SYS_ID_LEN)
+      || ! csnp_passwd_same (&cache->passwd, passwd))
+    {
+      list_delete_all_node (cache->frags);
+      cache->lspdb = lspdb;
+      memcpy (cache->sysid, isis->sysid, ISIS_SYS_ID_LEN);
+      cache->passwd = *passwd;
+    }
+  else if (cache->generation == dict_generation (lspdb))
+    return cache;
+
+  /* Keep the fragments up to the first one whose LSPs changed. */
+  memset (start, 0x00, ISIS_SYS_ID_LEN + 2);
+  resume = 1;
+  dnode = dict_first (lspdb);
+  for (ALL_LIST_ELEMENTS (cache->frags, node, nnode, frag))
+    {
+      if (! csnp_frag_valid (frag, num_lsps, lspdb, &dnode))
+	{
+	  while (node)
+	    {
+	      nnode = listnextnode (node);
+	      csnp_frag_free (listgetdata (node));
+	      list_delete_node (cache->frags, node);
+	      node = nnode;
+	    }
+	  break;
+	}
+
+      memcpy (start, frag->stop, ISIS_SYS_ID_LEN + 2);
+      resume = 0;
+      for (i = ISIS_SYS_ID_LEN + 1; i >= 0; --i)
+	if (start[i] < (u_char) 0xff)
+	  {
+	    start[i] += 1;
+	    resume = 1;
+	    break;
+	  }
+    }
+
+  if (resume && csnp_cache_build (cache, circuit, level, start) != ISIS_OK)
+    {
+      list_delete_all_node (cache->frags);
+      cache->lspdb = NULL;
+      return NULL;
+    }
+
+  cache->generation = dict_generation (lspdb);
+  return cache;
+}
+
+int
+send_csnp (struct isis_circuit *circuit, int level)
+{
+  struct isis_csnp_cache *cache;
+  struct isis_csnp_frag *frag;
+  struct isis_passwd *passwd;
+  struct listnode *node;
+  struct isis_lsp *lsp;
+  u_char num_lsps;
+  unsigned int i;
+  int retval = ISIS_OK;
+
+  if (circuit->area->lspdb[level - 1] == NULL ||
+      dict_count (circuit->area->lspdb[level - 1]) == 0)
+    return retval;
+
+  if (circuit->snd_stream == NULL)
+    circuit->snd_stream = stream_new (ISO_MTU (circuit));
+
+  if (level == IS_LEVEL_1)
+    passwd = &circuit->area->area_passwd;
+  else
+    passwd = &circuit->area->domain_passwd;
+
+  num_lsps = max_lsps_per_snp (ISIS_SNP_CSNP_FLAG, level, circuit);
+
+  cache = csnp_cache_get (circuit, level, num_lsps);
+  if (cache == NULL)
+    {
+      zlog_err ("ISIS-Snp (%s): Build L%d CSNP on %s failed",
+                circuit->area->area_tag, level, circuit->interface->name);
+      return ISIS_WARNING;
+    }
+
+  for (ALL_LIST_ELEMENTS_RO (cache->frags, node, frag))
+    {
+      csnp_frag_refresh (frag, passwd);
+      stream_reset (circuit->snd_stream);
+      stream_put (circuit->snd_stream, STREAM_DATA (frag->pdu),
+                  stream_get_endp (frag->pdu));
 
       if (isis->debugs & DEBUG_SNP_PACKETS)
         {
           zlog_debug ("ISIS-Snp (%s): Sent L%d CSNP on %s, length %ld",
                       circuit->area->area_tag, level, circuit->interface->name,
                       stream_get_endp (circuit->snd_stream));
-          for (ALL_LIST_ELEMENTS_RO (list, node, lsp))
+          for (i = 0; i < frag->count; i++)
             {
+              lsp = frag->lsps[i];
               zlog_debug ("ISIS-Snp (%s):         CSNP entry %s, seq 0x%08x,"
                           " cksum 0x%04x, lifetime %us",
                           circuit->area->area_tag,
@@ -2712,27 +2969,8 @@ send_csnp (struct isis_circuit *circuit, int level)
           zlog_err ("ISIS-Snp (%s): Send L%d CSNP on %s failed",
                     circuit->area->area_tag, level,
                     circuit->interface->name);
-          list_delete (list);
           return retval;
         }
-
-      /*
-       * Start lsp_id of the next CSNP should be one plus the
-       * stop lsp_id in this current CSNP.
-       */
-      memcpy (start, stop, ISIS_SYS_ID_LEN + 2);
-      loop = 0;
-      for (i = ISIS_SYS_ID_LEN + 1; i >= 0; --i)
-        {
-          if (start[i] < (u_char)0xff)
-            {
-              start[i] += 1;
-              loop = 1;
-              break;
-            }
-        }
-      memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
-      list_delete (list);
     }
 
   return retval;
@@ -715,7 +715,9 @@ isis_spf_process_lsp (struct isis_spftree *spftree, struct isis_lsp *lsp,
 		      uint32_t cost, uint16_t depth, int family,
 		      u_char *root_sysid, struct isis_vertex *parent)
 {
-  struct listnode *node, *fragnode = NULL;
+  struct listnode *fragnode = NULL;
+  struct tlv_view view;
+  struct tlv_iter iter;
   uint32_t dist;
   struct is_neigh *is_neigh;
   struct te_is_neigh *te_is_neigh;
@@ -742,29 +744,28 @@ lspfragloop:
       zlog_debug ("ISIS-Spf: process_lsp %s", print_sys_hostname(lsp->lsp_header->lsp_id));
 #endif /* EXTREME_DEBUG */
 
+  /* The neighbours and prefixes are walked in the PDU itself */
+  lsp_tlv_view (lsp, &view);
+
   if (!ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits))
   {
-    if (lsp->tlv_data.is_neighs)
+    TLV_VIEW_FOREACH (&view, iter, IS_NEIGHBOURS, is_neigh)
     {
-      for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, node, is_neigh))
-      {
-        /* C.2.6 a) */
-        /* Two way connectivity */
-        if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
-          continue;
-        if (!memcmp (is_neigh->neigh_id, null_sysid, ISIS_SYS_ID_LEN))
-          continue;
-        dist = cost + is_neigh->metrics.metric_default;
-        vtype = LSP_PSEUDO_ID (is_neigh->neigh_id) ? VTYPE_PSEUDO_IS
-          : VTYPE_NONPSEUDO_IS;
-        process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
-            depth + 1, family, parent);
-      }
+      /* C.2.6 a) */
+      /* Two way connectivity */
+      if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
+        continue;
+      if (!memcmp (is_neigh->neigh_id, null_sysid, ISIS_SYS_ID_LEN))
+        continue;
+      dist = cost + is_neigh->metrics.metric_default;
+      vtype = LSP_PSEUDO_ID (is_neigh->neigh_id) ? VTYPE_PSEUDO_IS
+        : VTYPE_NONPSEUDO_IS;
+      process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
+          depth + 1, family, parent);
     }
-    if (lsp->tlv_data.te_is_neighs)
+    if (spftree->area->newmetric)
     {
-      for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, node,
-            te_is_neigh))
+      TLV_VIEW_FOREACH (&view, iter, TE_IS_NEIGHBOURS, te_is_neigh)
       {
         if (!memcmp (te_is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
           continue;
@@ -779,10 +780,10 @@ lspfragloop:
     }
   }
 
-  if (family == AF_INET && lsp->tlv_data.ipv4_int_reachs)
+  if (family == AF_INET)
   {
     prefix.family = AF_INET;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_int_reachs, node, ipreach))
+    TLV_VIEW_FOREACH (&view, iter, IPV4_INT_REACHABILITY, ipreach)
     {
       dist = cost + ipreach->metrics.metric_default;
       vtype = VTYPE_IPREACH_INTERNAL;
@@ -793,10 +794,10 @@ lspfragloop:
                  family, parent);
     }
   }
-  if (family == AF_INET && lsp->tlv_data.ipv4_ext_reachs)
+  if (family == AF_INET)
   {
     prefix.family = AF_INET;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_ext_reachs, node, ipreach))
+    TLV_VIEW_FOREACH (&view, iter, IPV4_EXT_REACHABILITY, ipreach)
     {
       dist = cost + ipreach->metrics.metric_default;
       vtype = VTYPE_IPREACH_EXTERNAL;
@@ -807,11 +808,10 @@ lspfragloop:
                  family, parent);
     }
   }
-  if (family == AF_INET && lsp->tlv_data.te_ipv4_reachs)
+  if (family == AF_INET && spftree->area->newmetric)
   {
     prefix.family = AF_INET;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_ipv4_reachs,
-                               node, te_ipv4_reach))
+    TLV_VIEW_FOREACH (&view, iter, TE_IPV4_REACHABILITY, te_ipv4_reach)
     {
       dist = cost + ntohl (te_ipv4_reach->te_metric);
       vtype = VTYPE_IPREACH_TE;
@@ -824,10 +824,10 @@ lspfragloop:
     }
   }
 #ifdef HAVE_IPV6
-  if (family == AF_INET6 && lsp->tlv_data.ipv6_reachs)
+  if (family == AF_INET6)
   {
     prefix.family = AF_INET6;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv6_reachs, node, ip6reach))
+    TLV_VIEW_FOREACH (&view, iter, IPV6_REACHABILITY, ip6reach)
     {
       dist = cost + ip6reach->metric;
       vtype = (ip6reach->control_info & CTRL_INFO_DISTRIBUTION) ?
@@ -863,7 +863,9 @@ isis_spf_process_pseudo_lsp (struct isis_spftree *spftree,
 			     u_char *root_sysid,
 			     struct isis_vertex *parent)
 {
-  struct listnode *node, *fragnode = NULL;
+  struct listnode *fragnode = NULL;
+  struct tlv_view view;
+  struct tlv_iter iter;
   struct is_neigh *is_neigh;
   struct te_is_neigh *te_is_neigh;
   enum vertextype vtype;
@@ -885,8 +887,9 @@ pseudofragloop:
 
   /* RFC3787 section 4 SHOULD ignore overload bit in pseudo LSPs */
 
-  if (lsp->tlv_data.is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, node, is_neigh))
+  lsp_tlv_view (lsp, &view);
+
+  TLV_VIEW_FOREACH (&view, iter, IS_NEIGHBOURS, is_neigh)
       {
 	/* Two way connectivity */
 	if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
@@ -897,8 +900,8 @@ pseudofragloop:
         process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
             depth + 1, family, parent);
       }
-  if (lsp->tlv_data.te_is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, node, te_is_neigh))
+  if (spftree->area->newmetric)
+    TLV_VIEW_FOREACH (&view, iter, TE_IS_NEIGHBOURS, te_is_neigh)
       {
 	/* Two way connectivity */
 	if (!memcmp (te_is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
@@ -92,6 +92,17 @@ free_tlvs (struct tlvs *tlvs)
   return;
 }
 
+/*
+ * An item running past the end of its TLV, the rest of which is skipped.
+ */
+static int
+tlv_item_overrun (char *areatag, u_char type, u_char length)
+{
+  zlog_warn ("ISIS-TLV (%s): TLV (type %d, length %d) has an item "
+	     "exceeding its length", areatag, type, length);
+  return ISIS_WARNING;
+}
+
 /*
  * Parses the tlvs found in the variant length part of the PDU.
  * Caller tells with flags in "expected" which TLV's it is interested in.
@@ -116,8 +127,8 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
   int prefix_octets;
 #endif /* HAVE_IPV6 */
   u_char virtual;
-  int value_len, retval = ISIS_OK;
-  u_char *start = stream, *pnt = stream;
+  int value_len, item_len, retval = ISIS_OK;
+  u_char *start = stream, *pnt = stream, *tlv_end;
 
   *found = 0;
   memset (tlvs, 0, sizeof (struct tlvs));
@@ -135,6 +146,7 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	  retval = ISIS_WARNING;
 	  break;
 	}
+      tlv_end = pnt + length;
       switch (type)
 	{
 	case AREA_ADDRESSES:
@@ -154,6 +166,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  area_addr = (struct area_addr *) pnt;
+		  if (area_addr->addr_len + 1 > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  value_len += area_addr->addr_len + 1;
 		  pnt += area_addr->addr_len + 1;
 		  if (!tlvs->area_addrs)
@@ -198,6 +215,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  is_nei = (struct is_neigh *) pnt;
+		  if (IS_NEIGHBOURS_LEN > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  value_len += 4 + ISIS_SYS_ID_LEN + 1;
 		  pnt += 4 + ISIS_SYS_ID_LEN + 1;
 		  if (!tlvs->is_neighs)
@@ -231,6 +253,12 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  te_is_nei = (struct te_is_neigh *) pnt;
+		  if (11 > length - value_len ||
+		      11 + te_is_nei->sub_tlvs_length > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  value_len += 11;
 		  pnt += 11;
 		  /* FIXME - subtlvs are handled here, for now we skip */
@@ -308,6 +336,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  lan_nei = (struct lan_neigh *) pnt;
+		  if (ETH_ALEN > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  if (!tlvs->lan_neighs)
 		    tlvs->lan_neighs = list_new ();
 		  listnode_add (tlvs->lan_neighs, lan_nei);
@@ -348,6 +381,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  lsp_entry = (struct lsp_entry *) pnt;
+		  if (LSP_ENTRIES_LEN > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  value_len += 10 + ISIS_SYS_ID_LEN;
 		  pnt += 10 + ISIS_SYS_ID_LEN;
 		  if (!tlvs->lsp_entries)
@@ -412,6 +450,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  ipv4_addr = (struct in_addr *) pnt;
+		  if (4 > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 #ifdef EXTREME_TLV_DEBUG
 		  zlog_debug ("ISIS-TLV (%s) : IP ADDR %s, pnt %p", areatag,
 			      inet_ntoa (*ipv4_addr), pnt);
@@ -515,6 +558,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  ipv4_reach = (struct ipv4_reachability *) pnt;
+		  if (IPV4_REACH_LEN > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  if (!tlvs->ipv4_int_reachs)
 		    tlvs->ipv4_int_reachs = list_new ();
 		  listnode_add (tlvs->ipv4_int_reachs, ipv4_reach);
@@ -554,6 +602,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  ipv4_reach = (struct ipv4_reachability *) pnt;
+		  if (IPV4_REACH_LEN > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  if (!tlvs->ipv4_ext_reachs)
 		    tlvs->ipv4_ext_reachs = list_new ();
 		  listnode_add (tlvs->ipv4_ext_reachs, ipv4_reach);
@@ -589,15 +642,28 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  te_ipv4_reach = (struct te_ipv4_reachability *) pnt;
+		  if (5 > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
+		  item_len = 5 + ((te_ipv4_reach->control & 0x3F) ?
+				  ((((te_ipv4_reach->control & 0x3F) -
+				     1) >> 3) + 1) : 0);
+		  /* sub-TLVs follow the prefix, after their total length */
+		  if (te_ipv4_reach->control & 0x40)
+		    item_len += 1 + (item_len < length - value_len ?
+				     pnt[item_len] : 0);
+		  if (item_len > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  if (!tlvs->te_ipv4_reachs)
 		    tlvs->te_ipv4_reachs = list_new ();
 		  listnode_add (tlvs->te_ipv4_reachs, te_ipv4_reach);
-		  /* this trickery is permitable since no subtlvs are defined */
-		  value_len += 5 + ((te_ipv4_reach->control & 0x3F) ?
-				    ((((te_ipv4_reach->control & 0x3F) -
-				       1) >> 3) + 1) : 0);
-		  pnt += 5 + ((te_ipv4_reach->control & 0x3F) ?
-		              ((((te_ipv4_reach->control & 0x3F) - 1) >> 3) + 1) : 0);
+		  value_len += item_len;
+		  pnt += item_len;
 		}
 	    }
 	  else
@@ -623,6 +689,11 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  ipv6_addr = (struct in6_addr *) pnt;
+		  if (16 > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  if (!tlvs->ipv6_addrs)
 		    tlvs->ipv6_addrs = list_new ();
 		  listnode_add (tlvs->ipv6_addrs, ipv6_addr);
@@ -653,10 +724,24 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	      while (length > value_len)
 		{
 		  ipv6_reach = (struct ipv6_reachability *) pnt;
+		  if (6 > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
 		  prefix_octets = ((ipv6_reach->prefix_len + 7) / 8);
-		  value_len += prefix_octets + 6;
-		  pnt += prefix_octets + 6;
-		  /* FIXME: sub-tlvs */
+		  item_len = prefix_octets + 6;
+		  /* sub-TLVs follow the prefix, after their total length */
+		  if (ipv6_reach->control_info & CTRL_INFO_SUBTLVS)
+		    item_len += 1 + (item_len < length - value_len ?
+				     pnt[item_len] : 0);
+		  if (item_len > length - value_len)
+		    {
+		      retval = tlv_item_overrun (areatag, type, length);
+		      break;
+		    }
+		  value_len += item_len;
+		  pnt += item_len;
 		  if (!tlvs->ipv6_reachs)
 		    tlvs->ipv6_reachs = list_new ();
 		  listnode_add (tlvs->ipv6_reachs, ipv6_reach);
@@ -684,9 +769,7 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	  *found |= TLVFLAG_3WAY_HELLO;
 	  if (*expected & TLVFLAG_3WAY_HELLO)
 	    {
-	      while (length > value_len)
-		{
-		  /* FIXME: make this work */
+	      /* FIXME: make this work */
 /*           Adjacency State (one octet):
               0 = Up
               1 = Initializing
@@ -695,14 +778,8 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
             Neighbor System ID if known (zero to eight octets)
             Neighbor Extended Local Circuit ID (four octets, if Neighbor
               System ID is present) */
-		  pnt += length;
-		}
 	    }
-	  else
-	    {
-	      pnt += length;
-	    }
-
+	  pnt += length;
 	  break;
 	case GRACEFUL_RESTART:
 	  /* +-------+-------+-------+-------+-------+-------+-------+-------+
@@ -729,11 +806,322 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	  pnt += length;
 	  break;
 	}
+
+      /* Whatever was made of the items, go on with the next TLV */
+      pnt = tlv_end;
     }
 
   return retval;
 }
 
+/*
+ * Length of the item of a TLV of the given type at pnt, with left octets
+ * of the TLV remaining, or 0 if it does not fit.  Must agree with the item
+ * walks of parse_tlvs() above.
+ */
+static int
+tlv_item_len (u_char type, u_char * pnt, int left)
+{
+  int len;
+
+  switch (type)
+    {
+    case AREA_ADDRESSES:
+      len = ((struct area_addr *) pnt)->addr_len + 1;
+      break;
+    case IS_NEIGHBOURS:
+      len = IS_NEIGHBOURS_LEN;
+      break;
+    case TE_IS_NEIGHBOURS:
+      if (left < 11)
+	return 0;
+      len = 11 + ((struct te_is_neigh *) pnt)->sub_tlvs_length;
+      break;
+    case LAN_NEIGHBOURS:
+      len = ETH_ALEN;
+      break;
+    case LSP_ENTRIES:
+      len = LSP_ENTRIES_LEN;
+      break;
+    case IPV4_ADDR:
+      len = 4;
+      break;
+    case IPV4_INT_REACHABILITY:
+    case IPV4_EXT_REACHABILITY:
+      len = IPV4_REACH_LEN;
+      break;
+    case TE_IPV4_REACHABILITY:
+      if (left < 5)
+	return 0;
+      len = 5 + ((pnt[4] & 0x3F) ? (((pnt[4] & 0x3F) - 1) >> 3) + 1 : 0);
+      if (pnt[4] & 0x40)
+	len += 1 + (len < left ? pnt[len] : 0);
+      break;
+#ifdef HAVE_IPV6
+    case IPV6_ADDR:
+      len = 16;
+      break;
+    case IPV6_REACHABILITY:
+      if (left < 6)
+	return 0;
+      len = 6 + (pnt[5] + 7) / 8;
+      if (pnt[4] & CTRL_INFO_SUBTLVS)
+	len += 1 + (len < left ? pnt[len] : 0);
+      break;
+#endif /* HAVE_IPV6 */
+    default:
+      return 0;
+    }
+
+  return len <= left ? len : 0;
+}
+
+/* Whether the items of a TLV all fit in it */
+static int
+tlv_items_fit (u_char type, u_char * value, u_char length)
+{
+  u_char *pnt = value, *end = value + length;
+  int len;
+
+  /* the virtual flag */
+  if (type == IS_NEIGHBOURS)
+    pnt++;
+
+  while (pnt < end)
+    {
+      if ((len = tlv_item_len (type, pnt, end - pnt)) == 0)
+	return 0;
+      pnt += len;
+    }
+
+  return 1;
+}
+
+/*
+ * Same as parse_tlvs(), with the same checks and result, but without
+ * allocating anything: the repeated items are left in the PDU for the
+ * caller to walk with TLV_VIEW_FOREACH.
+ */
+int
+parse_tlv_view (char *areatag, u_char * stream, int size,
+		u_int32_t * expected, u_int32_t * found,
+		struct tlv_view *view, u_int32_t * auth_tlv_offset)
+{
+  u_char type, length, *value;
+  u_char *pnt = stream;
+  u_int32_t flag;
+  int items, retval = ISIS_OK;
+
+  *found = 0;
+  tlv_view_init (view, stream, size);
+
+  while (pnt < stream + size - 2)
+    {
+      type = *pnt;
+      length = *(pnt + 1);
+      value = pnt + 2;
+      if (value + length > stream + size)
+	{
+	  zlog_warn ("ISIS-TLV (%s): TLV (type %d, length %d) exceeds packet "
+		     "boundaries", areatag, type, length);
+	  retval = ISIS_WARNING;
+	  break;
+	}
+
+      items = 0;
+      switch (type)
+	{
+	case AREA_ADDRESSES:
+	  flag = TLVFLAG_AREA_ADDRS;
+	  items = 1;
+	  break;
+	case IS_NEIGHBOURS:
+	  flag = TLVFLAG_IS_NEIGHS;
+	  items = 1;
+	  break;
+	case TE_IS_NEIGHBOURS:
+	  flag = TLVFLAG_TE_IS_NEIGHS;
+	  items = 1;
+	  break;
+	case ES_NEIGHBOURS:
+	  flag = TLVFLAG_ES_NEIGHS;
+	  break;
+	case LAN_NEIGHBOURS:
+	  flag = TLVFLAG_LAN_NEIGHS;
+	  items = 1;
+	  break;
+	case PADDING:
+	  flag = 0;
+	  break;
+	case LSP_ENTRIES:
+	  flag = TLVFLAG_LSP_ENTRIES;
+	  items = 1;
+	  break;
+	case CHECKSUM:
+	  flag = TLVFLAG_CHECKSUM;
+	  if (*expected & flag)
+	    view->checksum = (struct checksum *) value;
+	  break;
+	case PROTOCOLS_SUPPORTED:
+	  flag = TLVFLAG_NLPID;
+	  if (*expected & flag)
+	    view->nlpids = (struct nlpids *) (value - 1);
+	  break;
+	case IPV4_ADDR:
+	  flag = TLVFLAG_IPV4_ADDR;
+	  items = 1;
+	  break;
+	case AUTH_INFO:
+	  flag = TLVFLAG_AUTH_INFO;
+	  if (*expected & flag)
+	    {
+	      view->auth_info.type = *value;
+	      if (length == 0)
+		{
+		  *found |= flag;
+		  zlog_warn ("ISIS-TLV (%s): TLV (type %d, length %d) "
+			     "incorrect.", areatag, type, length);
+		  /* the TLVs before this one only */
+		  view->end = value;
+		  return ISIS_WARNING;
+		}
+	      view->auth_info.len = length - 1;
+	      memcpy (view->auth_info.passwd, value + 1, length - 1);
+	      /* offset of the TLV, for computing the MD5 (RFC 5304, 2) */
+	      if (auth_tlv_offset)
+		*auth_tlv_offset += (pnt - stream);
+	    }
+	  break;
+	case DYNAMIC_HOSTNAME:
+	  flag = TLVFLAG_DYN_HOSTNAME;
+	  if (*expected & flag)
+	    view->hostname = (struct hostname *) (value - 1);
+	  break;
+	case TE_ROUTER_ID:
+	  flag = TLVFLAG_TE_ROUTER_ID;
+	  if (*expected & flag)
+	    view->router_id = (struct te_router_id *) value;
+	  break;
+	case IPV4_INT_REACHABILITY:
+	  flag = TLVFLAG_IPV4_INT_REACHABILITY;
+	  items = 1;
+	  break;
+	case IPV4_EXT_REACHABILITY:
+	  flag = TLVFLAG_IPV4_EXT_REACHABILITY;
+	  items = 1;
+	  break;
+	case TE_IPV4_REACHABILITY:
+	  flag = TLVFLAG_TE_IPV4_REACHABILITY;
+	  items = 1;
+	  break;
+#ifdef HAVE_IPV6
+	case IPV6_ADDR:
+	  flag = TLVFLAG_IPV6_ADDR;
+	  items = 1;
+	  break;
+	case IPV6_REACHABILITY:
+	  flag = TLVFLAG_IPV6_REACHABILITY;
+	  items = 1;
+	  break;
+#endif /* HAVE_IPV6 */
+	case WAY3_HELLO:
+	  flag = TLVFLAG_3WAY_HELLO;
+	  break;
+	case GRACEFUL_RESTART:
+	  flag = TLVFLAG_GRACEFUL_RESTART;
+	  break;
+	default:
+	  zlog_warn ("ISIS-TLV (%s): unsupported TLV type %d, length %d",
+		     areatag, type, length);
+	  flag = 0;
+	  retval = ISIS_WARNING;
+	  break;
+	}
+
+      *found |= flag;
+      if (items && (*expected & flag) && !tlv_items_fit (type, value, length))
+	retval = tlv_item_overrun (areatag, type, length);
+
+      pnt = value + length;
+    }
+
+  return retval;
+}
+
+/*
+ * Sets up a view of TLVs already checked by parse_tlvs() or
+ * parse_tlv_view(), such as those of the LSPs in the database, without
+ * going through them again.
+ */
+void
+tlv_view_init (struct tlv_view *view, u_char * stream, int size)
+{
+  memset (view, 0, sizeof (struct tlv_view));
+  view->start = stream;
+  view->end = stream + size;
+}
+
+void
+tlv_iter_init (struct tlv_iter *iter, struct tlv_view *view, u_char type)
+{
+  memset (iter, 0, sizeof (struct tlv_iter));
+  iter->type = type;
+  iter->pnt = view->start;
+  iter->end = view->end;
+}
+
+/*
+ * Returns the next item of the type walked, pointing into the PDU, or
+ * NULL once past the last one.  Items overrunning their TLV, which the
+ * parsing has warned about, end the walk of that TLV.
+ */
+void *
+tlv_iter_next (struct tlv_iter *iter)
+{
+  u_char *item;
+  int len;
+
+  while (1)
+    {
+      if (iter->item < iter->tlv_end)
+	{
+	  item = iter->item;
+	  len = tlv_item_len (iter->type, item, iter->tlv_end - item);
+	  iter->item = len ? item + len : iter->tlv_end;
+	  if (len)
+	    return item;
+	}
+
+      /* on to the next TLV of the type, stopping where parsing did */
+      while (iter->pnt < iter->end - 2 &&
+	     iter->pnt + *(iter->pnt + 1) + 2 <= iter->end &&
+	     *iter->pnt != iter->type)
+	iter->pnt += *(iter->pnt + 1) + 2;
+      if (iter->pnt >= iter->end - 2 ||
+	  iter->pnt + *(iter->pnt + 1) + 2 > iter->end)
+	return NULL;
+
+      item = iter->pnt + 2;
+      iter->tlv_end = item + *(iter->pnt + 1);
+      iter->pnt = iter->tlv_end;
+
+      switch (iter->type)
+	{
+	case IS_NEIGHBOURS:
+	  /* the virtual flag */
+	  iter->item = item + 1;
+	  break;
+	case ES_NEIGHBOURS:
+	  /* the metrics and the first neighbour of each TLV */
+	  iter->item = iter->tlv_end;
+	  return item;
+	default:
+	  iter->item = item;
+	  break;
+	}
+    }
+}
+
 int
 add_tlv (u_char tag, u_char len, u_char * value, struct stream *stream)
 {
@@ -263,6 +263,38 @@ struct tlvs
   struct isis_passwd auth_info;
 };
 
+/*
+ * The TLVs of a PDU left where they are, filled by parse_tlv_view().  The
+ * single valued TLVs are pointed to as in struct tlvs; the repeated items
+ * (area addresses, neighbours, LSP entries, reachabilities...) are not
+ * collected but walked in the PDU with a tlv_iter.  Only valid as long as
+ * the PDU buffer is.
+ */
+struct tlv_view
+{
+  struct checksum *checksum;
+  struct hostname *hostname;
+  struct nlpids *nlpids;
+  struct te_router_id *router_id;
+  struct isis_passwd auth_info;
+  u_char *start;		/* first TLV */
+  u_char *end;			/* end of the TLVs parsed */
+};
+
+/* Walks the items of all the TLVs of one type in a tlv_view */
+struct tlv_iter
+{
+  u_char type;
+  u_char *pnt;			/* next TLV */
+  u_char *end;
+  u_char *item;			/* next item in the current TLV */
+  u_char *tlv_end;
+};
+
+#define TLV_VIEW_FOREACH(view, iter, type, item) \
+  for (tlv_iter_init (&(iter), (view), (type)); \
+       ((item) = tlv_iter_next (&(iter))) != NULL; )
+
 /*
  * Own definitions - used to bitmask found and expected
  */
@@ -295,6 +327,13 @@ void free_tlvs (struct tlvs *tlvs);
 int parse_tlvs (char *areatag, u_char * stream, int size,
 		u_int32_t * expected, u_int32_t * found, struct tlvs *tlvs,
                 u_int32_t * auth_tlv_offset);
+int parse_tlv_view (char *areatag, u_char * stream, int size,
+		    u_int32_t * expected, u_int32_t * found,
+		    struct tlv_view *view, u_int32_t * auth_tlv_offset);
+void tlv_view_init (struct tlv_view *view, u_char * stream, int size);
+void tlv_iter_init (struct tlv_iter *iter, struct tlv_view *view,
+		    u_char type);
+void *tlv_iter_next (struct tlv_iter *iter);
 int add_tlv (u_char, u_char, u_char *, struct stream *);
 void free_tlv (void *val);
 
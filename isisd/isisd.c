@@ -252,6 +252,8 @@ isis_area_destroy (struct vty *vty, const char *area_tag)
       lsp_db_destroy (area->lspdb[1]);
       area->lspdb[1] = NULL;
     }
+  isis_csnp_cache_flush (area, IS_LEVEL_1);
+  isis_csnp_cache_flush (area, IS_LEVEL_2);
 
   spftree_area_del (area);
 
@@ -1310,6 +1312,138 @@ DEFUN (show_isis_summary,
   return CMD_SUCCESS;
 }
 
+/*
+ * "show isis database [detail]" streams its output, walking the LSP
+ * databases of each area and level a few LSPs at a time, see
+ * vty_walk ().  LSPs may come and go between slices, so the walk
+ * remembers the ID of the last LSP shown rather than the LSP itself.
+ */
+struct show_database_walk
+{
+  int ui_level;
+  struct isis_area *area;
+  int areapos;
+  int level;
+  int started;
+  int lsp_count;
+  u_char lspid[ISIS_SYS_ID_LEN + 2];
+};
+
+#define SHOW_DATABASE_WALK_LSPS 32
+
+/* Return the area after the one just shown, or the one now at its
+   position if it has gone away. */
+static struct isis_area *
+show_database_walk_next_area (struct show_database_walk *walk)
+{
+  struct listnode *node;
+  int pos;
+
+  for (node = listhead (isis->area_list), pos = 0; node;
+       node = listnextnode (node), pos++)
+    if (listgetdata (node) == walk->area)
+      break;
+  if (node)
+    {
+      node = listnextnode (node);
+      pos++;
+    }
+  else
+    for (node = listhead (isis->area_list), pos = 0;
+         node && pos < walk->areapos; node = listnextnode (node))
+      pos++;
+  walk->areapos = pos;
+
+  return node ? listgetdata (node) : NULL;
+}
+
+static void
+show_database_walk_free (void *arg)
+{
+  XFREE (MTYPE_TMP, arg);
+}
+
+static int
+show_database_walk (struct vty *vty, void *arg)
+{
+  struct show_database_walk *walk = arg;
+  struct isis_area *area;
+  struct isis_lsp *lsp;
+  struct listnode *node;
+  dict_t *lspdb;
+  dnode_t *dnode;
+  int n = 0;
+
+  for (node = listhead (isis->area_list); node; node = listnextnode (node))
+    if (listgetdata (node) == walk->area)
+      break;
+  area = node ? walk->area : NULL;
+
+  while (n < SHOW_DATABASE_WALK_LSPS)
+    {
+      if (area == NULL || walk->level >= ISIS_LEVELS)
+        {
+          area = show_database_walk_next_area (walk);
+          walk->area = area;
+          if (area == NULL)
+            return 0;
+
+          vty_out (vty, "Area %s:%s",
+                   area->area_tag ? area->area_tag : "null", VTY_NEWLINE);
+          walk->level = 0;
+          walk->started = 0;
+        }
+
+      lspdb = area->lspdb[walk->level];
+      if (! walk->started)
+        {
+          if (lspdb == NULL || dict_count (lspdb) == 0)
+            {
+              walk->level++;
+              continue;
+            }
+
+          vty_out (vty, "IS-IS Level-%d link-state database:%s",
+                   walk->level + 1, VTY_NEWLINE);
+          vty_out (vty, "LSP ID                  PduLen  "
+                   "SeqNumber   Chksum  Holdtime  ATT/P/OL%s",
+                   VTY_NEWLINE);
+          walk->started = 1;
+          walk->lsp_count = 0;
+          dnode = dict_first (lspdb);
+        }
+      else if (lspdb == NULL)
+        dnode = NULL;
+      else
+        {
+          dnode = dict_lower_bound (lspdb, walk->lspid);
+          if (dnode && memcmp (dnode_getkey (dnode), walk->lspid,
+                               ISIS_SYS_ID_LEN + 2) == 0)
+            dnode = dict_next (lspdb, dnode);
+        }
+
+      if (dnode == NULL)
+        {
+          vty_out (vty, "    %u LSPs%s%s",
+                   walk->lsp_count, VTY_NEWLINE, VTY_NEWLINE);
+          walk->started = 0;
+          walk->level++;
+          continue;
+        }
+
+      lsp = dnode_get (dnode);
+      if (walk->ui_level == ISIS_UI_LEVEL_DETAIL)
+        lsp_print_detail (lsp, vty, area->dynhostname);
+      else
+        lsp_print (lsp, vty, area->dynhostname);
+      memcpy (walk->lspid, lsp->lsp_header->lsp_id, ISIS_SYS_ID_LEN + 2);
+      walk->lsp_count++;
+      n++;
+    }
+
+  return 1;
+}
+
 /*
  * This function supports following display options:
  * [ show isis database [detail] ]
@@ -1333,15 +1467,24 @@ show_isis_database (struct vty *vty, const char *argv, int ui_level)
   struct isis_area *area;
   struct isis_lsp *lsp;
   struct isis_dynhn *dynhn;
+  struct show_database_walk *walk;
   const char *pos = argv;
   u_char lspid[ISIS_SYS_ID_LEN+2];
   char sysid[255];
   u_char number[3];
-  int level, lsp_count;
+  int level;
 
   if (isis->area_list->count == 0)
     return CMD_SUCCESS;
 
+  if (argv == NULL)
+    {
+      walk = XCALLOC (MTYPE_TMP, sizeof (struct show_database_walk));
+      walk->ui_level = ui_level;
+      return vty_walk (vty, show_database_walk, show_database_walk_free,
+                       walk);
+    }
+
   memset (&lspid, 0, ISIS_SYS_ID_LEN);
   memset (&sysid, 0, 255);
 
@@ -1354,9 +1497,8 @@ show_isis_database (struct vty *vty, const char *argv, int ui_level)
    * Where systemid is in the form:
    * xxxx.xxxx.xxxx
    */
-  if (argv)
-     strncpy (sysid, argv, 254);
-  if (argv && strlen (argv) > 3)
+  strncpy (sysid, argv, 254);
+  if (strlen (argv) > 3)
     {
       pos = argv + strlen (argv) - 3;
       if (strncmp (pos, "-", 1) == 0)
@@ -1384,30 +1526,27 @@ show_isis_database (struct vty *vty, const char *argv, int ui_level)
         {
           if (area->lspdb[level] && dict_count (area->lspdb[level]) > 0)
             {
+              /*
+               * Try to find the lsp-id if the argv string is in
+               * the form hostname.<pseudo-id>-<fragment>
+               */
               lsp = NULL;
-              if (argv != NULL)
+              if (sysid2buff (lspid, sysid))
                 {
-                  /*
-                   * Try to find the lsp-id if the argv string is in
-                   * the form hostname.<pseudo-id>-<fragment>
-                   */
-                  if (sysid2buff (lspid, sysid))
-                    {
-                      lsp = lsp_search (lspid, area->lspdb[level]);
-                    }
-                  else if ((dynhn = dynhn_find_by_name (sysid)))
-                    {
-                      memcpy (lspid, dynhn->id, ISIS_SYS_ID_LEN);
-                      lsp = lsp_search (lspid, area->lspdb[level]);
-                    }
-                  else if (strncmp(unix_hostname (), sysid, 15) == 0)
-                    {
-                      memcpy (lspid, isis->sysid, ISIS_SYS_ID_LEN);
-                      lsp = lsp_search (lspid, area->lspdb[level]);
-                    }
+                  lsp = lsp_search (lspid, area->lspdb[level]);
+                }
+              else if ((dynhn = dynhn_find_by_name (sysid)))
+                {
+                  memcpy (lspid, dynhn->id, ISIS_SYS_ID_LEN);
+                  lsp = lsp_search (lspid, area->lspdb[level]);
+                }
+              else if (strncmp(unix_hostname (), sysid, 15) == 0)
+                {
+                  memcpy (lspid, isis->sysid, ISIS_SYS_ID_LEN);
+                  lsp = lsp_search (lspid, area->lspdb[level]);
                 }
 
-              if (lsp != NULL || argv == NULL)
+              if (lsp != NULL)
                 {
                   vty_out (vty, "IS-IS Level-%d link-state database:%s",
                            level + 1, VTY_NEWLINE);
@@ -1416,24 +1555,12 @@ show_isis_database (struct vty *vty, const char *argv, int ui_level)
                   vty_out (vty, "LSP ID                  PduLen  "
                            "SeqNumber   Chksum  Holdtime  ATT/P/OL%s",
                            VTY_NEWLINE);
-                }
 
-              if (lsp)
-                {
                   if (ui_level == ISIS_UI_LEVEL_DETAIL)
                     lsp_print_detail (lsp, vty, area->dynhostname);
                   else
                     lsp_print (lsp, vty, area->dynhostname);
                 }
-              else if (argv == NULL)
-                {
-                  lsp_count = lsp_print_all (vty, area->lspdb[level],
-                                             ui_level,
-                                             area->dynhostname);
-
-                  vty_out (vty, "    %u LSPs%s%s",
-                           lsp_count, VTY_NEWLINE, VTY_NEWLINE);
-                }
             }
         }
     }
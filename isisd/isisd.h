@@ -97,6 +97,7 @@ struct isis_area
   struct thread *t_tick;	/* LSP walker */
   struct thread *t_lsp_refresh[ISIS_LEVELS];
   int lsp_regenerate_pending[ISIS_LEVELS];
+  struct list *csnp_cache[ISIS_LEVELS];	/* encoded CSNPs, by PDU size */
 
   /*
    * Configurables 
@@ -9,56 +9,385 @@
 #include <zebra.h>
 #include "checksum.h"
 
+/*
+ * Both checksums have an SSE2 and an AVX2 variant on x86, picked at
+ * runtime from what the CPU supports.  The variants only differ in the
+ * inner accumulation loop; padding, folding and the final reduction
+ * are shared, so every variant returns exactly the same values.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || \
+     (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define CHECKSUM_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Fletcher Checksum -- Refer to RFC1008. */
+#define MODX                 4102   /* 5802 should be fine */
+
+/* Bytes summed by the vector loops before reducing modulo 255, small
+   enough that no 32-bit lane can overflow. */
+#define FLETCHER_SIMD_CHUNK  4096
+
+/* Bytes summed by the in_cksum vector loops before adding up the lanes:
+   32768 words of at most 0xffff, so even the sum of all lanes fits in
+   32 bits. */
+#define IN_CKSUM_SIMD_CHUNK  65536
+
+struct checksum_ops
+{
+  const char *name;
+  int (*supported) (void);
+  /* Add LEN bytes at P to the running sums, both kept below 255. */
+  void (*fletcher) (const u_char *p, size_t len, u_int32_t *c0,
+		    u_int32_t *c1);
+  /* Sum of the 16-bit words in the first NBYTES & ~1 bytes at P. */
+  u_int64_t (*in_sum) (const u_char *p, int nbytes);
+};
+
+static void
+fletcher_accumulate_scalar (const u_char *p, size_t len,
+			    u_int32_t *c0p, u_int32_t *c1p)
+{
+  u_int32_t c0 = *c0p, c1 = *c1p;
+  size_t partial_len, i;
+
+  while (len != 0)
+    {
+      partial_len = MIN(len, MODX);
+
+      for (i = 0; i < partial_len; i++)
+	{
+	  c0 = c0 + *(p++);
+	  c1 += c0;
+	}
+
+      c0 = c0 % 255;
+      c1 = c1 % 255;
+
+      len -= partial_len;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+}
+
+static u_int64_t
+in_sum_scalar (const u_char *p, int nbytes)
+{
+  const u_short *ptr = (const u_short *) p;
+  u_int64_t sum = 0;
+
+  while (nbytes > 1)
+    {
+      sum += *ptr++;
+      nbytes -= 2;
+    }
+  return sum;
+}
+
+static int
+checksum_scalar_supported (void)
+{
+  return 1;
+}
+
+#ifdef CHECKSUM_X86_SIMD
+static inline u_int32_t __attribute__ ((target ("sse2"), always_inline))
+hsum_epi32_sse2 (__m128i v)
+{
+  v = _mm_add_epi32 (v, _mm_shuffle_epi32 (v, _MM_SHUFFLE (1, 0, 3, 2)));
+  v = _mm_add_epi32 (v, _mm_shuffle_epi32 (v, _MM_SHUFFLE (2, 3, 0, 1)));
+  return (u_int32_t) _mm_cvtsi128_si32 (v);
+}
+
+/*
+ * Within a chunk of k blocks of B bytes, c1 grows by
+ *   k * B * c0 + B * (sum of the byte sums of the preceding blocks)
+ *              + sum over each block of (B - i) * byte[i],
+ * which the loops keep in vps and vs2; vs1 is the plain byte sum.
+ */
+static void __attribute__ ((target ("sse2")))
+fletcher_accumulate_sse2 (const u_char *p, size_t len,
+			  u_int32_t *c0p, u_int32_t *c1p)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i wlo = _mm_set_epi16 (9, 10, 11, 12, 13, 14, 15, 16);
+  const __m128i whi = _mm_set_epi16 (1, 2, 3, 4, 5, 6, 7, 8);
+  u_int64_t c0 = *c0p, c1 = *c1p;
+
+  while (len >= 16)
+    {
+      size_t n = MIN(len, FLETCHER_SIMD_CHUNK) & ~(size_t) 15;
+      const u_char *end = p + n;
+      __m128i vs1 = zero, vps = zero, vs2 = zero;
+
+      for (; p < end; p += 16)
+	{
+	  __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+
+	  vps = _mm_add_epi32 (vps, vs1);
+	  vs1 = _mm_add_epi32 (vs1, _mm_sad_epu8 (v, zero));
+	  vs2 = _mm_add_epi32 (vs2,
+			       _mm_madd_epi16 (_mm_unpacklo_epi8 (v, zero), wlo));
+	  vs2 = _mm_add_epi32 (vs2,
+			       _mm_madd_epi16 (_mm_unpackhi_epi8 (v, zero), whi));
+	}
+
+      c1 = (c1 + n * c0 + 16 * (u_int64_t) hsum_epi32_sse2 (vps)
+	    + hsum_epi32_sse2 (vs2)) % 255;
+      c0 = (c0 + hsum_epi32_sse2 (vs1)) % 255;
+      len -= n;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+  fletcher_accumulate_scalar (p, len, c0p, c1p);
+}
+
+static u_int64_t __attribute__ ((target ("sse2")))
+in_sum_sse2 (const u_char *p, int nbytes)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  u_int64_t sum = 0;
+
+  while (nbytes >= 16)
+    {
+      int n = MIN(nbytes, IN_CKSUM_SIMD_CHUNK) & ~15;
+      const u_char *end = p + n;
+      __m128i acc = zero;
+
+      for (; p < end; p += 16)
+	{
+	  __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+
+	  acc = _mm_add_epi32 (acc, _mm_unpacklo_epi16 (v, zero));
+	  acc = _mm_add_epi32 (acc, _mm_unpackhi_epi16 (v, zero));
+	}
+      sum += hsum_epi32_sse2 (acc);
+      nbytes -= n;
+    }
+
+  return sum + in_sum_scalar (p, nbytes);
+}
+
+static int
+checksum_sse2_supported (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("sse2");
+}
+
+/* Kept apart from hsum_epi32_sse2() so that it is VEX encoded too:
+   mixing legacy SSE code into the AVX2 loops is very slow. */
+static inline u_int32_t __attribute__ ((target ("avx2"), always_inline))
+hsum_epi32_avx2 (__m256i v)
+{
+  __m128i h = _mm_add_epi32 (_mm256_castsi256_si128 (v),
+			     _mm256_extracti128_si256 (v, 1));
+
+  h = _mm_add_epi32 (h, _mm_shuffle_epi32 (h, _MM_SHUFFLE (1, 0, 3, 2)));
+  h = _mm_add_epi32 (h, _mm_shuffle_epi32 (h, _MM_SHUFFLE (2, 3, 0, 1)));
+  return (u_int32_t) _mm_cvtsi128_si32 (h);
+}
+
+static void __attribute__ ((target ("avx2")))
+fletcher_accumulate_avx2 (const u_char *p, size_t len,
+			  u_int32_t *c0p, u_int32_t *c1p)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i ones = _mm256_set1_epi16 (1);
+  const __m256i w = _mm256_set_epi8 (1, 2, 3, 4, 5, 6, 7, 8,
+				     9, 10, 11, 12, 13, 14, 15, 16,
+				     17, 18, 19, 20, 21, 22, 23, 24,
+				     25, 26, 27, 28, 29, 30, 31, 32);
+  u_int64_t c0 = *c0p, c1 = *c1p;
+
+  while (len >= 32)
+    {
+      size_t n = MIN(len, FLETCHER_SIMD_CHUNK) & ~(size_t) 31;
+      const u_char *end = p + n;
+      __m256i vs1 = zero, vps = zero, vs2 = zero;
+
+      for (; p < end; p += 32)
+	{
+	  __m256i v = _mm256_loadu_si256 ((const __m256i *) p);
+
+	  vps = _mm256_add_epi32 (vps, vs1);
+	  vs1 = _mm256_add_epi32 (vs1, _mm256_sad_epu8 (v, zero));
+	  vs2 = _mm256_add_epi32 (vs2,
+				  _mm256_madd_epi16 (_mm256_maddubs_epi16 (v, w),
+						     ones));
+	}
+
+      c1 = (c1 + n * c0 + 32 * (u_int64_t) hsum_epi32_avx2 (vps)
+	    + hsum_epi32_avx2 (vs2)) % 255;
+      c0 = (c0 + hsum_epi32_avx2 (vs1)) % 255;
+      len -= n;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+  fletcher_accumulate_scalar (p, len, c0p, c1p);
+}
+
+static u_int64_t __attribute__ ((target ("avx2")))
+in_sum_avx2 (const u_char *p, int nbytes)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  u_int64_t sum = 0;
+
+  while (nbytes >= 32)
+    {
+      int n = MIN(nbytes, IN_CKSUM_SIMD_CHUNK) & ~31;
+      const u_char *end = p + n;
+      __m256i acc = zero;
+
+      for (; p < end; p += 32)
+	{
+	  __m256i v = _mm256_loadu_si256 ((const __m256i *) p);
+
+	  acc = _mm256_add_epi32 (acc, _mm256_unpacklo_epi16 (v, zero));
+	  acc = _mm256_add_epi32 (acc, _mm256_unpackhi_epi16 (v, zero));
+	}
+      sum += hsum_epi32_avx2 (acc);
+      nbytes -= n;
+    }
+
+  return sum + in_sum_scalar (p, nbytes);
+}
+
+static int
+checksum_avx2_supported (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("avx2");
+}
+#endif /* CHECKSUM_X86_SIMD */
+
+/* In order of preference. */
+static const struct checksum_ops checksum_ops_list[] =
+{
+#ifdef CHECKSUM_X86_SIMD
+  { "avx2", checksum_avx2_supported, fletcher_accumulate_avx2, in_sum_avx2 },
+  { "sse2", checksum_sse2_supported, fletcher_accumulate_sse2, in_sum_sse2 },
+#endif
+  { "scalar", checksum_scalar_supported, fletcher_accumulate_scalar,
+    in_sum_scalar },
+  { NULL, NULL, NULL, NULL }
+};
+
+static const struct checksum_ops *checksum_ops;
+
+static const struct checksum_ops *
+checksum_ops_get (void)
+{
+  const struct checksum_ops *ops;
+
+  if (checksum_ops)
+    return checksum_ops;
+
+  for (ops = checksum_ops_list; ops->name; ops++)
+    if (ops->supported ())
+      break;
+  assert (ops->name);
+  checksum_ops = ops;
+  return ops;
+}
+
+/* Name of the implementation in use. */
+const char *
+checksum_impl (void)
+{
+  return checksum_ops_get ()->name;
+}
+
+/* Force an implementation, mainly for testing.  NULL restores the
+   default choice.  Returns -1 if it is unknown or not supported. */
+int
+checksum_impl_set (const char *name)
+{
+  const struct checksum_ops *ops;
+
+  if (name == NULL)
+    {
+      checksum_ops = NULL;
+      return 0;
+    }
+
+  for (ops = checksum_ops_list; ops->name; ops++)
+    if (strcmp (ops->name, name) == 0)
+      {
+	if (!ops->supported ())
+	  return -1;
+	checksum_ops = ops;
+	return 0;
+      }
+  return -1;
+}
+
 int			/* return checksum in low-order 16 bits */
 in_cksum(void *parg, int nbytes)
 {
-	u_short *ptr = parg;
-	register long		sum;		/* assumes long == 32 bits */
+	u_char *ptr = parg;
+	u_int64_t		sum;
 	u_short			oddbyte;
 	register u_short	answer;		/* assumes u_short == 16 bits */
 
 	/*
-	 * Our algorithm is simple, using a 32-bit accumulator (sum),
+	 * Our algorithm is simple, using a wide accumulator (sum),
 	 * we add sequential 16-bit words to it, and at the end, fold back
-	 * all the carry bits from the top 16 bits into the lower 16 bits.
+	 * all the carry bits from the top bits into the lower 16 bits.
 	 */
 
-	sum = 0;
-	while (nbytes > 1)  {
-		sum += *ptr++;
-		nbytes -= 2;
-	}
+	sum = checksum_ops_get ()->in_sum (ptr, nbytes);
 
 				/* mop up an odd byte, if necessary */
-	if (nbytes == 1) {
+	if (nbytes > 0 && (nbytes & 1)) {
 		oddbyte = 0;		/* make sure top half is zero */
-		*((u_char *) &oddbyte) = *(u_char *)ptr;   /* one byte only */
+		*((u_char *) &oddbyte) = ptr[nbytes - 1];   /* one byte only */
 		sum += oddbyte;
 	}
 
 	/*
-	 * Add back carry outs from top 16 bits to low 16 bits.
+	 * Add back carry outs from top bits to low 16 bits.
 	 */
 
-	sum  = (sum >> 16) + (sum & 0xffff);	/* add high-16 to low-16 */
-	sum += (sum >> 16);			/* add carry */
+	while (sum >> 16)
+		sum = (sum >> 16) + (sum & 0xffff);
 	answer = ~sum;		/* ones-complement, then truncate to 16 bits */
 	return(answer);
 }
 
-/* Fletcher Checksum -- Refer to RFC1008. */
-#define MODX                 4102   /* 5802 should be fine */
+/* Turn the running sums into the two checksum bytes. */
+static void
+fletcher_reduce (const size_t len, const uint16_t offset,
+		 int c0, int c1, int *xp, int *yp)
+{
+  int x, y;
+
+  /* The cast is important, to ensure the mod is taken as a signed value. */
+  x = (int)((len - offset - 1) * c0 - c1) % 255;
+
+  if (x <= 0)
+    x += 255;
+  y = 510 - c0 - x;
+  if (y > 255)
+    y -= 255;
+
+  *xp = x;
+  *yp = y;
+}
 
 /* To be consistent, offset is 0-based index, rather than the 1-based 
    index required in the specification ISO 8473, Annex C.1 */
 u_int16_t
 fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
 {
-  u_int8_t *p;
-  int x, y, c0, c1;
+  int x, y;
+  u_int32_t c0, c1;
   u_int16_t checksum;
   u_int16_t *csum;
-  size_t partial_len, i, left = len;
   
   checksum = 0;
 
@@ -70,34 +399,11 @@ fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
   csum = (u_int16_t *) (buffer + offset);
   *(csum) = 0;
 
-  p = buffer;
   c0 = 0;
   c1 = 0;
+  checksum_ops_get ()->fletcher (buffer, len, &c0, &c1);
 
-  while (left != 0)
-    {
-      partial_len = MIN(left, MODX);
-
-      for (i = 0; i < partial_len; i++)
-	{
-	  c0 = c0 + *(p++);
-	  c1 += c0;
-	}
-
-      c0 = c0 % 255;
-      c1 = c1 % 255;
-
-      left -= partial_len;
-    }
-  
-  /* The cast is important, to ensure the mod is taken as a signed value. */
-  x = (int)((len - offset - 1) * c0 - c1) % 255;
-
-  if (x <= 0)
-    x += 255;
-  y = 510 - c0 - x;
-  if (y > 255)  
-    y -= 255;
+  fletcher_reduce (len, offset, c0, c1, &x, &y);
   
   /*
    * Now we write this to the packet.
@@ -112,3 +418,58 @@ fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
 
   return checksum;
 }
+
+/* Same value as fletcher_checksum(), but the buffer is left alone: the
+   bytes at offset are taken out of the sums instead of being zeroed. */
+u_int16_t
+fletcher_checksum_compute (const u_char *buffer, const size_t len,
+			   const uint16_t offset)
+{
+  int x, y;
+  u_int32_t c0, c1;
+  long v0, v1, s0, s1;
+
+  assert ((size_t) offset + 1 < len);
+
+  c0 = 0;
+  c1 = 0;
+  checksum_ops_get ()->fletcher (buffer, len, &c0, &c1);
+
+  /* the byte at index i added itself to c0 once and to c1 len - i times */
+  v0 = buffer[offset];
+  v1 = buffer[offset + 1];
+  s0 = ((long) c0 - v0 - v1) % 255;
+  s1 = ((long) c1 - v0 * (long) ((len - offset) % 255)
+	- v1 * (long) ((len - offset - 1) % 255)) % 255;
+  if (s0 < 0)
+    s0 += 255;
+  if (s1 < 0)
+    s1 += 255;
+
+  fletcher_reduce (len, offset, s0, s1, &x, &y);
+
+  return htons((x << 8) | (y & 0xFF));
+}
+
+/* Check the stored checksum of every item, as fletcher_checksum_compute()
+   would.  Sets each item's valid flag and returns the number of bad ones. */
+unsigned int
+fletcher_checksum_verify_batch (struct fletcher_item *items,
+				unsigned int count)
+{
+  unsigned int i, bad = 0;
+
+  for (i = 0; i < count; i++)
+    {
+      struct fletcher_item *item = &items[i];
+      u_int16_t stored;
+
+      memcpy (&stored, item->buf + item->offset, sizeof (stored));
+      item->valid = (fletcher_checksum_compute (item->buf, item->len,
+						item->offset) == stored);
+      if (!item->valid)
+	bad++;
+    }
+
+  return bad;
+}
@@ -1,2 +1,17 @@
+/* Items checked in one call to fletcher_checksum_verify_batch(). */
+struct fletcher_item
+{
+  const u_char *buf;
+  size_t len;
+  u_int16_t offset;	/* of the stored checksum */
+  u_char valid;		/* set by the check */
+};
+
 extern int in_cksum(void *, int);
 extern u_int16_t fletcher_checksum(u_char *, const size_t len, const uint16_t offset);
+extern u_int16_t fletcher_checksum_compute (const u_char *, const size_t len,
+					    const uint16_t offset);
+extern unsigned int fletcher_checksum_verify_batch (struct fletcher_item *,
+						    unsigned int count);
+extern const char *checksum_impl (void);
+extern int checksum_impl_set (const char *);
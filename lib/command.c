@@ -27,6 +27,7 @@ Boston, MA 02111-1307, USA.  */
 #include <lib/version.h>
 #include "thread.h"
 #include "vector.h"
+#include "hash.h"
 #include "vty.h"
 #include "command.h"
 #include "workqueue.h"
@@ -188,6 +189,198 @@ argv_concat (const char **argv, int argc, int shift)
   return str;
 }
 
+/* Keyword index.
+
+   When a token is exactly one of the keywords allowed at its position,
+   cmd_filter_by_completion and cmd_filter_by_string both rate it
+   exact_match, and is_cmd_ambiguous then keeps precisely the commands
+   offering that keyword there.  Which commands survive such a token
+   depends only on the commands that survived the tokens before it, so
+   the survivors can be looked up instead of computed: each trie node
+   holds the commands left after a path of exact keywords, and its
+   children are keyed by the keywords at the next position.  Matching
+   walks the trie as far as the line goes in exact keywords and runs
+   the usual filters over what is left, which gives the same result as
+   filtering the whole node while touching only the candidates.
+
+   Children are built the first time a trie node is walked through, so
+   only the paths configurations actually use take memory.  A node's
+   trie is thrown away when its commands change. */
+struct cmd_trie
+{
+  /* Keyword leading here from the parent. */
+  char *word;
+
+  /* Token position the children are keyed on. */
+  unsigned int index;
+
+  /* Commands still in the running, in installation order. */
+  vector cmds;
+
+  /* Children by keyword at position index, NULL until first use. */
+  struct hash *children;
+};
+
+static int cmd_trie_enabled = 1;
+
+/* Whether desc can only be matched by typing it: everything but the
+   variable forms, which the filters never rate exact_match. */
+static int
+cmd_desc_keyword (const char *str)
+{
+  return ! (CMD_VARARG (str) || CMD_OPTION (str) || CMD_VARIABLE (str));
+}
+
+static unsigned int
+cmd_trie_hash_key (void *p)
+{
+  struct cmd_trie *trie = p;
+
+  return string_hash_make (trie->word);
+}
+
+static int
+cmd_trie_hash_cmp (const void *p1, const void *p2)
+{
+  const struct cmd_trie *t1 = p1;
+  const struct cmd_trie *t2 = p2;
+
+  return strcmp (t1->word, t2->word) == 0;
+}
+
+static void *
+cmd_trie_hash_alloc (void *p)
+{
+  struct cmd_trie *key = p;
+  struct cmd_trie *trie;
+
+  trie = XCALLOC (MTYPE_CMD_TRIE, sizeof (struct cmd_trie));
+  trie->word = XSTRDUP (MTYPE_CMD_TRIE, key->word);
+  trie->index = key->index;
+  trie->cmds = vector_init (VECTOR_MIN_SIZE);
+  return trie;
+}
+
+static void
+cmd_trie_free (void *p)
+{
+  struct cmd_trie *trie = p;
+
+  if (trie->children)
+    {
+      hash_clean (trie->children, cmd_trie_free);
+      hash_free (trie->children);
+    }
+  vector_free (trie->cmds);
+  if (trie->word)
+    XFREE (MTYPE_CMD_TRIE, trie->word);
+  XFREE (MTYPE_CMD_TRIE, trie);
+}
+
+/* Drop a node's index, for when its commands change. */
+static void
+cmd_trie_reset (struct cmd_node *cnode)
+{
+  if (cnode->trie)
+    {
+      cmd_trie_free (cnode->trie);
+      cnode->trie = NULL;
+    }
+}
+
+/* Sort the commands of trie by the keywords they offer at its index. */
+static void
+cmd_trie_expand (struct cmd_trie *trie)
+{
+  unsigned int i, j;
+  struct cmd_element *cmd_element;
+  struct cmd_trie key, *child;
+  vector descvec;
+  struct desc *desc;
+
+  trie->children = hash_create_size (vector_active (trie->cmds) + 1,
+				     cmd_trie_hash_key, cmd_trie_hash_cmp);
+  key.index = trie->index + 1;
+
+  for (i = 0; i < vector_active (trie->cmds); i++)
+    if ((cmd_element = vector_slot (trie->cmds, i)) != NULL
+	&& trie->index < vector_active (cmd_element->strvec))
+      {
+	descvec = vector_slot (cmd_element->strvec, trie->index);
+
+	for (j = 0; j < vector_active (descvec); j++)
+	  if ((desc = vector_slot (descvec, j)) != NULL
+	      && cmd_desc_keyword (desc->cmd))
+	    {
+	      key.word = desc->cmd;
+	      child = hash_get (trie->children, &key, cmd_trie_hash_alloc);
+
+	      /* The same keyword twice in one descvec. */
+	      if (vector_active (child->cmds)
+		  && vector_slot (child->cmds,
+				  vector_active (child->cmds) - 1) == cmd_element)
+		continue;
+	      vector_set (child->cmds, cmd_element);
+	    }
+      }
+}
+
+/* Follow the leading exact keywords of vline through the node's index.
+   Returns a copy of the commands surviving them, for the caller to
+   filter further; *index is set to the number of tokens consumed. */
+static vector
+cmd_trie_candidates (enum node_type ntype, vector vline, unsigned int *index)
+{
+  struct cmd_node *cnode = vector_slot (cmdvec, ntype);
+  struct cmd_trie *trie, *child, key;
+  char *command;
+
+  *index = 0;
+
+  if (! cmd_trie_enabled)
+    return vector_copy (cnode->cmd_vector);
+
+  if (cnode->trie == NULL)
+    {
+      cnode->trie = XCALLOC (MTYPE_CMD_TRIE, sizeof (struct cmd_trie));
+      cnode->trie->cmds = vector_copy (cnode->cmd_vector);
+    }
+  trie = cnode->trie;
+
+  /* Empty tokens are skipped by the filters; leave them to those. */
+  while (*index < vector_active (vline)
+	 && (command = vector_slot (vline, *index)) != NULL)
+    {
+      if (trie->children == NULL)
+	cmd_trie_expand (trie);
+
+      key.word = command;
+      if ((child = hash_lookup (trie->children, &key)) == NULL)
+	break;
+
+      trie = child;
+      (*index)++;
+    }
+
+  return vector_copy (trie->cmds);
+}
+
+/* Turn the keyword index on or off, mostly to compare it against the
+   plain matcher. */
+void
+cmd_trie_enable (int enable)
+{
+  unsigned int i;
+  struct cmd_node *cnode;
+
+  cmd_trie_enabled = enable;
+
+  if (! enable && cmdvec)
+    for (i = 0; i < vector_active (cmdvec); i++)
+      if ((cnode = vector_slot (cmdvec, i)) != NULL)
+	cmd_trie_reset (cnode);
+}
+
 /* Install top node of command vector. */
 void
 install_node (struct cmd_node *node, 
@@ -196,6 +389,7 @@ install_node (struct cmd_node *node,
   vector_set_index (cmdvec, node->node, node);
   node->func = func;
   node->cmd_vector = vector_init (VECTOR_MIN_SIZE);
+  node->trie = NULL;
 }
 
 /* Compare two command's string.  Used in sort_node (). */
@@ -232,6 +426,7 @@ sort_node ()
 	vector cmd_vector = cnode->cmd_vector;
 	qsort (cmd_vector->index, vector_active (cmd_vector), 
 	       sizeof (void *), cmp_node);
+	cmd_trie_reset (cnode);
 
 	for (j = 0; j < vector_active (cmd_vector); j++)
 	  if ((cmd_element = vector_slot (cmd_vector, j)) != NULL
@@ -499,6 +694,7 @@ install_element (enum node_type ntype, struct cmd_element *cmd)
     }
 
   vector_set (cnode->cmd_vector, cmd);
+  cmd_trie_reset (cnode);
 
   if (cmd->strvec == NULL)
     cmd->strvec = cmd_make_descvec (cmd->string, cmd->doc);
@@ -609,6 +805,14 @@ config_write_host (struct vty *vty)
     vty_out (vty, "log timestamp precision %d%s",
 	     zlog_default->timestamp_precision, VTY_NEWLINE);
 
+  if (zlog_default->ring)
+    {
+      vty_out (vty, "log async");
+      if (zlog_async_size (zlog_default) != ZLOG_ASYNC_SIZE_DEFAULT)
+	vty_out (vty, " %lu", (u_long) zlog_async_size (zlog_default) / 1024);
+      vty_out (vty, "%s", VTY_NEWLINE);
+    }
+
   if (host.advanced)
     vty_out (vty, "service advanced-vty%s", VTY_NEWLINE);
 
@@ -2018,10 +2222,12 @@ cmd_execute_command_real (vector vline, struct vty *vty,
   int varflag;
   char *command;
 
-  /* Make copy of command elements. */
-  cmd_vector = vector_copy (cmd_node_vector (cmdvec, vty->node));
+  /* Commands left after the leading keywords of the line. */
+  cmd_vector = cmd_trie_candidates (vty->node, vline, &index);
+  if (index)
+    match = exact_match;
 
-  for (index = 0; index < vector_active (vline); index++)
+  for (; index < vector_active (vline); index++)
     if ((command = vector_slot (vline, index)))
       {
 	int ret;
@@ -2201,10 +2407,12 @@ cmd_execute_command_strict (vector vline, struct vty *vty,
   enum match_type match = 0;
   char *command;
 
-  /* Make copy of command element */
-  cmd_vector = vector_copy (cmd_node_vector (cmdvec, vty->node));
+  /* Commands left after the leading keywords of the line. */
+  cmd_vector = cmd_trie_candidates (vty->node, vline, &index);
+  if (index)
+    match = exact_match;
 
-  for (index = 0; index < vector_active (vline); index++)
+  for (; index < vector_active (vline); index++)
     if ((command = vector_slot (vline, index)))
       {
 	int ret;
@@ -3131,6 +3339,15 @@ DEFUN (show_logging,
   	   (zl->record_priority ? "enabled" : "disabled"), VTY_NEWLINE);
   vty_out (vty, "Timestamp precision: %d%s",
 	   zl->timestamp_precision, VTY_NEWLINE);
+  vty_out (vty, "Asynchronous logging: ");
+  if (!zl->ring)
+    vty_out (vty, "disabled");
+  else
+    vty_out (vty, "%lu kbytes, %lu bytes queued",
+	     (u_long) zlog_async_size (zl) / 1024,
+	     (u_long) zlog_async_used (zl));
+  vty_out (vty, "%s", VTY_NEWLINE);
+  vty_out (vty, "Messages dropped: %lu%s", zl->dropped, VTY_NEWLINE);
 
   return CMD_SUCCESS;
 }
@@ -3486,6 +3703,57 @@ DEFUN (no_config_log_timestamp_precision,
   return CMD_SUCCESS;
 }
 
+DEFUN (config_log_async,
+       config_log_async_cmd,
+       "log async",
+       "Logging control\n"
+       "Queue messages and write them out in the background\n")
+{
+  size_t size = ZLOG_ASYNC_SIZE_DEFAULT;
+
+  if (argc == 1)
+    {
+      u_int32_t kbytes;
+
+      VTY_GET_INTEGER_RANGE ("Logging ring size", kbytes, argv[0], 16, 65536);
+      size = kbytes * 1024;
+    }
+
+  if (!zlog_async_enable (NULL, size))
+    {
+      vty_out (vty, "%% Asynchronous logging is not available%s",
+	       VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  return CMD_SUCCESS;
+}
+
+ALIAS (config_log_async,
+       config_log_async_size_cmd,
+       "log async <16-65536>",
+       "Logging control\n"
+       "Queue messages and write them out in the background\n"
+       "Size of the message ring in kilobytes\n")
+
+DEFUN (no_config_log_async,
+       no_config_log_async_cmd,
+       "no log async",
+       NO_STR
+       "Logging control\n"
+       "Queue messages and write them out in the background\n")
+{
+  zlog_async_disable (NULL);
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_config_log_async,
+       no_config_log_async_size_cmd,
+       "no log async <16-65536>",
+       NO_STR
+       "Logging control\n"
+       "Queue messages and write them out in the background\n"
+       "Size of the message ring in kilobytes\n")
+
 DEFUN (banner_motd_file,
        banner_motd_file_cmd,
        "banner motd file [FILE]",
@@ -3659,6 +3927,10 @@ cmd_init (int terminal)
       install_element (CONFIG_NODE, &no_config_log_record_priority_cmd);
       install_element (CONFIG_NODE, &config_log_timestamp_precision_cmd);
       install_element (CONFIG_NODE, &no_config_log_timestamp_precision_cmd);
+      install_element (CONFIG_NODE, &config_log_async_cmd);
+      install_element (CONFIG_NODE, &config_log_async_size_cmd);
+      install_element (CONFIG_NODE, &no_config_log_async_cmd);
+      install_element (CONFIG_NODE, &no_config_log_async_size_cmd);
       install_element (CONFIG_NODE, &service_password_encrypt_cmd);
       install_element (CONFIG_NODE, &no_service_password_encrypt_cmd);
       install_element (CONFIG_NODE, &banner_motd_default_cmd);
@@ -3670,6 +3942,12 @@ cmd_init (int terminal)
       install_element (VIEW_NODE, &show_thread_cpu_cmd);
       install_element (ENABLE_NODE, &show_thread_cpu_cmd);
       install_element (RESTRICTED_NODE, &show_thread_cpu_cmd);
+      install_element (VIEW_NODE, &show_thread_latency_cmd);
+      install_element (ENABLE_NODE, &show_thread_latency_cmd);
+      install_element (RESTRICTED_NODE, &show_thread_latency_cmd);
+      install_element (VIEW_NODE, &show_thread_latency_dump_cmd);
+      install_element (ENABLE_NODE, &show_thread_latency_dump_cmd);
+      install_element (RESTRICTED_NODE, &show_thread_latency_dump_cmd);
       
       install_element (ENABLE_NODE, &clear_thread_cpu_cmd);
       install_element (VIEW_NODE, &show_work_queues_cmd);
@@ -3692,6 +3970,7 @@ cmd_terminate ()
       for (i = 0; i < vector_active (cmdvec); i++) 
         if ((cmd_node = vector_slot (cmdvec, i)) != NULL)
           {
+            cmd_trie_reset (cmd_node);
             cmd_node_v = cmd_node->cmd_vector;
 
             for (j = 0; j < vector_active (cmd_node_v); j++)
@@ -141,6 +141,9 @@ struct cmd_node
 
   /* Vector of this node's command list. */
   vector cmd_vector;	
+
+  /* Keyword index over cmd_vector, built on first use. */
+  struct cmd_trie *trie;
 };
 
 enum
@@ -364,6 +367,7 @@ struct desc
 extern void install_node (struct cmd_node *, int (*) (struct vty *));
 extern void install_default (enum node_type);
 extern void install_element (enum node_type, struct cmd_element *);
+extern void cmd_trie_enable (int);
 extern void sort_node (void);
 
 /* Concatenates argv[shift] through argv[argc-1] into a single NUL-terminated
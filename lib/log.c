@@ -27,6 +27,7 @@
 #include "log.h"
 #include "memory.h"
 #include "command.h"
+#include "thread.h"
 #ifndef SUNOS_5
 #include <sys/un.h>
 #endif
@@ -151,6 +152,288 @@ time_print(FILE *fp, struct timestamp_control *ctl)
 }
   
 
+/* Asynchronous logging.  The ring holds variable length records, a
+   header followed by the rendered timestamp and the message text, both
+   NUL terminated.  A record never wraps: when one doesn't fit at the
+   end of the buffer, the rest of the buffer is filled with a padding
+   record and it goes at the start.  Only the daemon's own thread ever
+   touches the ring, so there is no locking. */
+struct zlog_ring
+{
+  char *buf;
+  size_t size;
+  size_t head;			/* next record is put here */
+  size_t tail;			/* oldest record */
+  size_t used;
+  int writing;			/* in zlog_ring_write () */
+  unsigned long reported;	/* drops already logged */
+  struct thread *t_write;
+};
+
+struct zlog_record
+{
+  u_int32_t size;		/* of the whole record, rounded up */
+  u_int16_t textlen;
+  u_char priority;
+  u_char dests;			/* bit per zlog_dest_t, none if padding */
+};
+
+#define ZLOG_RECORD_ALIGN	8
+#define ZLOG_RECORD_ROUNDUP(x) \
+  (((x) + ZLOG_RECORD_ALIGN - 1) & ~(ZLOG_RECORD_ALIGN - 1))
+#define ZLOG_RECORD_TS(rec) ((char *)(rec) + sizeof (struct zlog_record))
+
+/* Longer messages are written out synchronously. */
+#define ZLOG_RECORD_TEXT_MAX	1024
+#define ZLOG_RECORD_MAX \
+  ZLOG_RECORD_ROUNDUP (sizeof (struct zlog_record) \
+		       + sizeof (((struct timestamp_control *)0)->buf) \
+		       + ZLOG_RECORD_TEXT_MAX + 1)
+
+/* Records written out each time the writer thread runs. */
+#define ZLOG_RING_BATCH		256
+
+static struct thread_master *zlog_master = NULL;
+
+static void zlog_ring_write (struct zlog *, unsigned int);
+
+/* Make room for a record, NULL if the ring is full. */
+static struct zlog_record *
+zlog_ring_reserve (struct zlog_ring *ring, size_t size)
+{
+  struct zlog_record *rec;
+
+  if (ring->used == 0)
+    ring->head = ring->tail = 0;
+
+  if (ring->size - ring->used < size)
+    return NULL;
+
+  if (ring->head >= ring->tail && ring->size - ring->head < size)
+    {
+      if (ring->tail < size)
+	return NULL;
+      rec = (struct zlog_record *) (ring->buf + ring->head);
+      rec->size = ring->size - ring->head;
+      rec->dests = 0;
+      ring->used += rec->size;
+      ring->head = 0;
+    }
+
+  rec = (struct zlog_record *) (ring->buf + ring->head);
+  rec->size = size;
+  ring->used += size;
+  ring->head += size;
+  if (ring->head == ring->size)
+    ring->head = 0;
+
+  return rec;
+}
+
+static int
+zlog_ring_writer (struct thread *thread)
+{
+  struct zlog *zl = THREAD_ARG (thread);
+
+  zl->ring->t_write = NULL;
+  zlog_ring_write (zl, ZLOG_RING_BATCH);
+
+  if (zl->ring->used && zlog_master)
+    zl->ring->t_write = thread_add_background (zlog_master, zlog_ring_writer,
+					       zl, 0);
+  return 0;
+}
+
+/* Queue a message with its timestamp.  Returns 0 if it has to be
+   written out synchronously instead. */
+static int
+zlog_ring_put (struct zlog *zl, int priority, u_char dests,
+	       const char *text, size_t textlen)
+{
+  struct zlog_ring *ring = zl->ring;
+  struct zlog_record *rec;
+  char ts[sizeof (((struct timestamp_control *)0)->buf)];
+  size_t tslen, size;
+
+  tslen = quagga_timestamp (zl->timestamp_precision, ts, sizeof (ts));
+  size = ZLOG_RECORD_ROUNDUP (sizeof (struct zlog_record)
+			      + tslen + 1 + textlen + 1);
+
+  if ((rec = zlog_ring_reserve (ring, size)) == NULL)
+    {
+      /* Full: debugging and informational messages are dropped, the
+         others wait for the ring to be written out, or are written out
+         right away if logged while it is. */
+      if (priority >= LOG_INFO)
+	{
+	  zl->dropped++;
+	  return 1;
+	}
+      if (ring->writing)
+	return 0;
+      zlog_async_flush (zl);
+      if ((rec = zlog_ring_reserve (ring, size)) == NULL)
+	return 0;
+    }
+
+  rec->textlen = textlen;
+  rec->priority = priority;
+  rec->dests = dests;
+  memcpy (ZLOG_RECORD_TS (rec), ts, tslen + 1);
+  memcpy (ZLOG_RECORD_TS (rec) + tslen + 1, text, textlen);
+  ZLOG_RECORD_TS (rec)[tslen + 1 + textlen] = '\0';
+
+  if (! ring->t_write && zlog_master)
+    ring->t_write = thread_add_background (zlog_master, zlog_ring_writer,
+					   zl, 0);
+  return 1;
+}
+
+/* Destinations a message goes to, as a bit mask. */
+static u_char
+zlog_dests (struct zlog *zl, int priority)
+{
+  u_char dests = 0;
+
+  if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
+    dests |= (1 << ZLOG_DEST_SYSLOG);
+  if ((priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp)
+    dests |= (1 << ZLOG_DEST_FILE);
+  if (priority <= zl->maxlvl[ZLOG_DEST_STDOUT])
+    dests |= (1 << ZLOG_DEST_STDOUT);
+  if ((priority <= zl->maxlvl[ZLOG_DEST_MONITOR]) && vty_log_active ())
+    dests |= (1 << ZLOG_DEST_MONITOR);
+
+  return dests;
+}
+
+static int
+zlog_ring_append (struct zlog *zl, int priority, const char *format,
+		  va_list args)
+{
+  char text[ZLOG_RECORD_TEXT_MAX];
+  u_char dests;
+  va_list ac;
+  int len;
+
+  if ((dests = zlog_dests (zl, priority)) == 0)
+    return 1;
+
+  va_copy (ac, args);
+  len = vsnprintf (text, sizeof (text), format, ac);
+  va_end (ac);
+
+  if (len < 0 || (size_t) len >= sizeof (text))
+    {
+      /* Keep the order of messages. */
+      zlog_async_flush (zl);
+      return 0;
+    }
+
+  return zlog_ring_put (zl, priority, dests, text, len);
+}
+
+static void
+zlog_vty_log (const char *level, const char *proto_str,
+	      struct timestamp_control *ctl, const char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  vty_log (level, proto_str, format, ctl, args);
+  va_end (args);
+}
+
+/* Write out up to max records, in order. */
+static void
+zlog_ring_write (struct zlog *zl, unsigned int max)
+{
+  struct zlog_ring *ring = zl->ring;
+  struct zlog_record *rec;
+  struct timestamp_control tsctl;
+  const char *ts, *text, *level;
+  const char *proto = zlog_proto_names[zl->protocol];
+  int file = 0, out = 0;
+  unsigned int n = 0;
+  size_t tslen;
+
+  ring->writing = 1;
+
+  while (ring->used && n < max)
+    {
+      rec = (struct zlog_record *) (ring->buf + ring->tail);
+
+      if (rec->dests)
+	{
+	  ts = ZLOG_RECORD_TS (rec);
+	  tslen = strlen (ts);
+	  text = ts + tslen + 1;
+	  level = zl->record_priority ? zlog_priority[rec->priority] : NULL;
+
+	  if (rec->dests & (1 << ZLOG_DEST_SYSLOG))
+	    syslog (rec->priority|zlog_default->facility, "%s", text);
+
+	  if ((rec->dests & (1 << ZLOG_DEST_FILE)) && zl->fp)
+	    {
+	      if (level)
+		fprintf (zl->fp, "%s %s: %s: ", ts, level, proto);
+	      else
+		fprintf (zl->fp, "%s %s: ", ts, proto);
+	      fwrite (text, 1, rec->textlen, zl->fp);
+	      putc ('\n', zl->fp);
+	      file = 1;
+	    }
+
+	  if (rec->dests & (1 << ZLOG_DEST_STDOUT))
+	    {
+	      if (level)
+		fprintf (stdout, "%s %s: %s: ", ts, level, proto);
+	      else
+		fprintf (stdout, "%s %s: ", ts, proto);
+	      fwrite (text, 1, rec->textlen, stdout);
+	      putc ('\n', stdout);
+	      out = 1;
+	    }
+
+	  if (rec->dests & (1 << ZLOG_DEST_MONITOR))
+	    {
+	      tsctl.len = tslen;
+	      tsctl.precision = zl->timestamp_precision;
+	      tsctl.already_rendered = 1;
+	      memcpy (tsctl.buf, ts, tslen + 1);
+	      zlog_vty_log (level, proto, &tsctl, "%s", text);
+	    }
+	  n++;
+	}
+
+      ring->tail += rec->size;
+      if (ring->tail == ring->size)
+	ring->tail = 0;
+      ring->used -= rec->size;
+    }
+
+  if (file && zl->fp)
+    fflush (zl->fp);
+  if (out)
+    fflush (stdout);
+
+  ring->writing = 0;
+
+  if (zl->dropped != ring->reported)
+    {
+      char text[64];
+      int len;
+
+      len = snprintf (text, sizeof (text),
+		      "%lu log messages dropped, logging ring full",
+		      zl->dropped - ring->reported);
+      ring->reported = zl->dropped;
+      if (zlog_dests (zl, LOG_WARNING))
+	zlog_ring_put (zl, LOG_WARNING, zlog_dests (zl, LOG_WARNING),
+		       text, len);
+    }
+}
+
 /* va_list version of zlog. */
 static void
 vzlog (struct zlog *zl, int priority, const char *format, va_list args)
@@ -177,6 +460,10 @@ vzlog (struct zlog *zl, int priority, const char *format, va_list args)
     }
   tsctl.precision = zl->timestamp_precision;
 
+  /* Queue it if logging is asynchronous. */
+  if (zl->ring && zlog_ring_append (zl, priority, format, args))
+    return;
+
   /* Syslog output */
   if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
     {
@@ -359,6 +646,55 @@ open_crashlog(void)
 #undef CRASHLOG_PREFIX
 }
 
+/* Write out the messages still queued for the log file, using only
+   async-signal-safe functions.  The lines look the same as those
+   written by zlog_ring_write(), priority included. */
+static void
+zlog_ring_dump_sigsafe (int fd)
+{
+  struct zlog_ring *ring;
+  struct zlog_record *rec;
+  struct iovec iov[3];
+  char prefix[sizeof(" notifications: : ") + 20];
+  char *s;
+  size_t pos, used, tslen;
+
+  if (! zlog_default || (ring = zlog_default->ring) == NULL)
+    return;
+
+  for (pos = ring->tail, used = ring->used; used; used -= rec->size)
+    {
+      rec = (struct zlog_record *) (ring->buf + pos);
+      if (rec->dests & (1 << ZLOG_DEST_FILE))
+	{
+#define LOC s,prefix+sizeof(prefix)-s
+	  s = prefix;
+	  s = str_append (LOC, " ");
+	  if (zlog_default->record_priority)
+	    {
+	      s = str_append (LOC, zlog_priority[rec->priority]);
+	      s = str_append (LOC, ": ");
+	    }
+	  s = str_append (LOC, zlog_proto_names[zlog_default->protocol]);
+	  s = str_append (LOC, ": ");
+#undef LOC
+	  tslen = strlen (ZLOG_RECORD_TS (rec));
+	  iov[0].iov_base = ZLOG_RECORD_TS (rec);
+	  iov[0].iov_len = tslen;
+	  iov[1].iov_base = prefix;
+	  iov[1].iov_len = s - prefix;
+	  iov[2].iov_base = ZLOG_RECORD_TS (rec) + tslen + 1;
+	  iov[2].iov_len = rec->textlen + 1;
+	  ZLOG_RECORD_TS (rec)[tslen + 1 + rec->textlen] = '\n';
+	  writev (fd, iov, 3);
+	}
+      pos += rec->size;
+      if (pos == ring->size)
+	pos = 0;
+    }
+  ring->used = 0;
+}
+
 /* Note: the goal here is to use only async-signal-safe functions. */
 void
 zlog_signal(int signo, const char *action
@@ -407,7 +743,10 @@ zlog_signal(int signo, const char *action
 #define DUMP(FD) write(FD, buf, s-buf);
   /* If no file logging configured, try to write to fallback log file. */
   if ((logfile_fd >= 0) || ((logfile_fd = open_crashlog()) >= 0))
-    DUMP(logfile_fd)
+    {
+      zlog_ring_dump_sigsafe(logfile_fd);
+      DUMP(logfile_fd)
+    }
   if (!zlog_default)
     DUMP(STDERR_FILENO)
   else
@@ -476,7 +815,10 @@ zlog_backtrace_sigsafe(int priority, void *program_counter)
   s = str_append(LOC," stack frames:\n");
 
   if ((logfile_fd >= 0) || ((logfile_fd = open_crashlog()) >= 0))
-    DUMP(logfile_fd)
+    {
+      zlog_ring_dump_sigsafe(logfile_fd);
+      DUMP(logfile_fd)
+    }
   if (!zlog_default)
     DUMP(STDERR_FILENO)
   else
@@ -621,6 +963,8 @@ _zlog_assert_failed (const char *assertion, const char *file,
   zlog(NULL, LOG_CRIT, "Assertion `%s' failed in file %s, line %u, function %s",
        assertion,file,line,(function ? function : "?"));
   zlog_backtrace(LOG_CRIT);
+  if (zlog_default)
+    zlog_async_flush(zlog_default);
   abort();
 }
 
@@ -654,6 +998,7 @@ openzlog (const char *progname, zlog_proto_t protocol,
 void
 closezlog (struct zlog *zl)
 {
+  zlog_async_disable (zl);
   closelog();
 
   if (zl->fp != NULL)
@@ -711,6 +1056,7 @@ zlog_reset_file (struct zlog *zl)
   if (zl == NULL)
     zl = zlog_default;
 
+  zlog_async_flush (zl);
   if (zl->fp)
     fclose (zl->fp);
   zl->fp = NULL;
@@ -733,6 +1079,7 @@ zlog_rotate (struct zlog *zl)
   if (zl == NULL)
     zl = zlog_default;
 
+  zlog_async_flush (zl);
   if (zl->fp)
     fclose (zl->fp);
   zl->fp = NULL;
@@ -762,6 +1109,97 @@ zlog_rotate (struct zlog *zl)
   return 1;
 }
 
+/* Thread master the asynchronous log writer runs on. */
+void
+zlog_async_init (struct thread_master *master)
+{
+  zlog_master = master;
+}
+
+static void
+zlog_async_exit (void)
+{
+  if (zlog_default)
+    zlog_async_flush (zlog_default);
+}
+
+/* Make logging asynchronous, or change the size of the ring. */
+int
+zlog_async_enable (struct zlog *zl, size_t size)
+{
+  static int registered = 0;
+
+  if (zl == NULL)
+    zl = zlog_default;
+
+  if (! zlog_master)
+    return 0;
+
+  size = ZLOG_RECORD_ROUNDUP (size);
+  if (size < 4 * ZLOG_RECORD_MAX)
+    size = 4 * ZLOG_RECORD_MAX;
+
+  if (zl->ring && zl->ring->size == size)
+    return 1;
+  zlog_async_disable (zl);
+
+  zl->ring = XCALLOC (MTYPE_ZLOG, sizeof (struct zlog_ring));
+  zl->ring->buf = XMALLOC (MTYPE_ZLOG, size);
+  zl->ring->size = size;
+  zl->ring->reported = zl->dropped;
+
+  /* Don't lose what is still queued when the daemon exits. */
+  if (! registered)
+    {
+      atexit (zlog_async_exit);
+      registered = 1;
+    }
+  return 1;
+}
+
+/* Back to synchronous logging. */
+void
+zlog_async_disable (struct zlog *zl)
+{
+  if (zl == NULL)
+    zl = zlog_default;
+
+  if (! zl->ring)
+    return;
+
+  zlog_async_flush (zl);
+  if (zl->ring->t_write)
+    thread_cancel (zl->ring->t_write);
+  XFREE (MTYPE_ZLOG, zl->ring->buf);
+  XFREE (MTYPE_ZLOG, zl->ring);
+}
+
+/* Write out everything queued. */
+void
+zlog_async_flush (struct zlog *zl)
+{
+  if (zl == NULL)
+    zl = zlog_default;
+
+  if (! zl->ring || zl->ring->writing)
+    return;
+
+  while (zl->ring->used)
+    zlog_ring_write (zl, UINT_MAX);
+}
+
+size_t
+zlog_async_size (struct zlog *zl)
+{
+  return zl->ring ? zl->ring->size : 0;
+}
+
+size_t
+zlog_async_used (struct zlog *zl)
+{
+  return zl->ring ? zl->ring->used : 0;
+}
+
 /* Message lookup function. */
 const char *
 lookup (const struct message *mes, int key)
@@ -855,6 +1293,11 @@ static const struct zebra_desc_table command_types[] = {
   DESC_ENTRY	(ZEBRA_LINKMETRICS_METRICS),
   DESC_ENTRY	(ZEBRA_LINKMETRICS_STATUS),
   DESC_ENTRY	(ZEBRA_LINKMETRICS_METRICS_REQUEST),
+  DESC_ENTRY	(ZEBRA_IPV4_ROUTE_BULK_ADD),
+  DESC_ENTRY	(ZEBRA_IPV4_ROUTE_BULK_DELETE),
+  DESC_ENTRY	(ZEBRA_IPV6_ROUTE_BULK_ADD),
+  DESC_ENTRY	(ZEBRA_IPV6_ROUTE_BULK_DELETE),
+  DESC_ENTRY	(ZEBRA_LINKMETRICS_METRICS_BATCH),
 };
 #undef DESC_ENTRY
 
@@ -75,6 +75,9 @@ typedef enum
 } zlog_dest_t;
 #define ZLOG_NUM_DESTS		(ZLOG_DEST_FILE+1)
 
+struct thread_master;
+struct zlog_ring;
+
 struct zlog 
 {
   const char *ident;	/* daemon name (first arg to openlog) */
@@ -89,6 +92,9 @@ struct zlog
   			   priority of the message? */
   int syslog_options;	/* 2nd arg to openlog */
   int timestamp_precision;	/* # of digits of subsecond precision */
+  struct zlog_ring *ring;	/* messages waiting to be written out, if
+  				   logging is asynchronous */
+  unsigned long dropped;	/* messages lost to a full ring */
 };
 
 /* Message structure. */
@@ -152,6 +158,20 @@ extern int zlog_reset_file (struct zlog *zl);
 /* Rotate log. */
 extern int zlog_rotate (struct zlog *);
 
+/* Asynchronous logging.  Messages are queued in a ring of the given
+   size in bytes and written out by a background thread, in batches.
+   When the ring is full, debugging and informational messages are
+   dropped and counted, more severe ones flush the ring first (or go
+   out synchronously if it is being flushed already).
+   zlog_async_init gives the thread master to run the writer on. */
+#define ZLOG_ASYNC_SIZE_DEFAULT	(256 * 1024)
+extern void zlog_async_init (struct thread_master *);
+extern int zlog_async_enable (struct zlog *, size_t size);
+extern void zlog_async_disable (struct zlog *);
+extern void zlog_async_flush (struct zlog *);
+extern size_t zlog_async_size (struct zlog *);
+extern size_t zlog_async_used (struct zlog *);
+
 /* For hackey massage lookup and check */
 #define LOOKUP(x, y) mes_lookup(x, x ## _max, y, "(no item found)", #x)
 
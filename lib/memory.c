@@ -246,18 +246,19 @@ static struct
 } mstat [MTYPE_MAX];
 #endif /* MEMORY_LOG */
 
-/* Increment allocation counter. */
+/* Increment allocation counter.  Daemons may allocate from helper
+   threads, so the update has to be atomic. */
 static void
 alloc_inc (int type)
 {
-  mstat[type].alloc++;
+  __sync_fetch_and_add (&mstat[type].alloc, 1);
 }
 
 /* Decrement allocation counter. */
 static void
 alloc_dec (int type)
 {
-  mstat[type].alloc--;
+  __sync_fetch_and_sub (&mstat[type].alloc, 1);
 }
 
 /* Looking up memory status from vty interface. */
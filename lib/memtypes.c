@@ -56,6 +56,7 @@ struct memory_list memory_list_lib[] =
   { MTYPE_ROUTE_MAP_RULE_STR,	"Route map rule str"		},
   { MTYPE_ROUTE_MAP_COMPILED,	"Route map compiled"		},
   { MTYPE_DESC,			"Command desc"			},
+  { MTYPE_CMD_TRIE,		"Command index"			},
   { MTYPE_KEY,			"Key"				},
   { MTYPE_KEYCHAIN,		"Key chain"			},
   { MTYPE_IF_RMAP,		"Interface route map"		},
@@ -83,6 +84,7 @@ struct memory_list memory_list_zebra[] =
   { MTYPE_RIB_QUEUE,		"RIB process work queue"	},
   { MTYPE_STATIC_IPV4,		"Static IPv4 route"		},
   { MTYPE_STATIC_IPV6,		"Static IPv6 route"		},
+  { MTYPE_LINKMETRICS_BATCH,	"Link metrics batch"		},
   { -1, NULL },
 };
 
@@ -161,6 +163,7 @@ struct memory_list memory_list_rip[] =
   { MTYPE_RIP_PEER,           "RIP peer"			},
   { MTYPE_RIP_OFFSET_LIST,    "RIP offset list"			},
   { MTYPE_RIP_DISTANCE,       "RIP distance"			},
+  { MTYPE_RIP_OUT_CLASS,      "RIP update class"		},
   { -1, NULL }
 };
 
@@ -172,6 +175,7 @@ struct memory_list memory_list_ripng[] =
   { MTYPE_RIPNG_PEER,         "RIPng peer"			},
   { MTYPE_RIPNG_OFFSET_LIST,  "RIPng offset lst"		},
   { MTYPE_RIPNG_RTE_DATA,     "RIPng rte data"			},
+  { MTYPE_RIPNG_OUT_CLASS,    "RIPng update class"		},
   { -1, NULL }
 };
 
@@ -239,6 +243,7 @@ struct memory_list memory_list_isis[] =
   { MTYPE_ISIS_TMP,           "ISIS TMP"			},
   { MTYPE_ISIS_CIRCUIT,       "ISIS circuit"			},
   { MTYPE_ISIS_LSP,           "ISIS LSP"			},
+  { MTYPE_ISIS_CSNP,          "ISIS CSNP cache"			},
   { MTYPE_ISIS_ADJACENCY,     "ISIS adjacency"			},
   { MTYPE_ISIS_AREA,          "ISIS area"			},
   { MTYPE_ISIS_AREA_ADDR,     "ISIS area address"		},
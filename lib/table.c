@@ -192,9 +192,12 @@ route_unlock_node (struct route_node *node)
     route_node_delete (node);
 }
 
-/* Find matched prefix. */
+/* Find matched prefix without taking a reference on the result.  The
+   caller must not hold on to the node past any change to the table;
+   this is what allows several readers to share an unchanging table. */
 struct route_node *
-route_node_match (const struct route_table *table, const struct prefix *p)
+route_node_match_nolock (const struct route_table *table,
+			 const struct prefix *p)
 {
   struct route_node *node;
   struct route_node *matched;
@@ -216,8 +219,17 @@ route_node_match (const struct route_table *table, const struct prefix *p)
       node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
     }
 
+  return matched;
+}
+
+/* Find matched prefix. */
+struct route_node *
+route_node_match (const struct route_table *table, const struct prefix *p)
+{
+  struct route_node *matched;
+
   /* If matched route found, return it. */
-  if (matched)
+  if ((matched = route_node_match_nolock (table, p)) != NULL)
     return route_lock_node (matched);
 
   return NULL;
@@ -253,9 +265,11 @@ route_node_match_ipv6 (const struct route_table *table,
 }
 #endif /* HAVE_IPV6 */
 
-/* Lookup same prefix node.  Return NULL when we can't find route. */
+/* Lookup same prefix node without taking a reference on it, see
+   route_node_match_nolock(). */
 struct route_node *
-route_node_lookup (struct route_table *table, struct prefix *p)
+route_node_lookup_nolock (const struct route_table *table,
+			  const struct prefix *p)
 {
   struct route_node *node;
 
@@ -265,7 +279,7 @@ route_node_lookup (struct route_table *table, struct prefix *p)
 	 prefix_match (&node->p, p))
     {
       if (node->p.prefixlen == p->prefixlen)
-        return node->info ? route_lock_node (node) : NULL;
+        return node->info ? node : NULL;
 
       node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
     }
@@ -273,6 +287,18 @@ route_node_lookup (struct route_table *table, struct prefix *p)
   return NULL;
 }
 
+/* Lookup same prefix node.  Return NULL when we can't find route. */
+struct route_node *
+route_node_lookup (struct route_table *table, struct prefix *p)
+{
+  struct route_node *node;
+
+  if ((node = route_node_lookup_nolock (table, p)) != NULL)
+    return route_lock_node (node);
+
+  return NULL;
+}
+
 /* Add node to routing table. */
 struct route_node *
 route_node_get (struct route_table *table, struct prefix *p)
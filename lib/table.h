@@ -65,9 +65,13 @@ extern struct route_node *route_node_get (struct route_table *,
                                           struct prefix *);
 extern struct route_node *route_node_lookup (struct route_table *,
                                              struct prefix *);
+extern struct route_node *route_node_lookup_nolock (const struct route_table *,
+                                                    const struct prefix *);
 extern struct route_node *route_lock_node (struct route_node *node);
 extern struct route_node *route_node_match (const struct route_table *,
                                             const struct prefix *);
+extern struct route_node *route_node_match_nolock (const struct route_table *,
+                                                   const struct prefix *);
 extern struct route_node *route_node_match_ipv4 (const struct route_table *,
 						 const struct in_addr *);
 #ifdef HAVE_IPV6
@@ -270,6 +270,56 @@ cpu_record_hash_free (void *a)
   XFREE (MTYPE_THREAD_STATS, hist);
 }
 
+/* Parse a "rwtexb" thread type filter string. */
+static int
+thread_filter_parse (struct vty *vty, const char *arg, thread_type *filter)
+{
+  int i = 0;
+
+  *filter = 0;
+  while (arg[i] != '\0')
+    {
+      switch ( arg[i] )
+	{
+	case 'r':
+	case 'R':
+	  *filter |= (1 << THREAD_READ);
+	  break;
+	case 'w':
+	case 'W':
+	  *filter |= (1 << THREAD_WRITE);
+	  break;
+	case 't':
+	case 'T':
+	  *filter |= (1 << THREAD_TIMER);
+	  break;
+	case 'e':
+	case 'E':
+	  *filter |= (1 << THREAD_EVENT);
+	  break;
+	case 'x':
+	case 'X':
+	  *filter |= (1 << THREAD_EXECUTE);
+	  break;
+	case 'b':
+	case 'B':
+	  *filter |= (1 << THREAD_BACKGROUND);
+	  break;
+	default:
+	  break;
+	}
+      ++i;
+    }
+  if (*filter == 0)
+    {
+      vty_out(vty, "Invalid filter \"%s\" specified,"
+	      " must contain at least one of 'RWTEXB'%s",
+	      arg, VTY_NEWLINE);
+      return -1;
+    }
+  return 0;
+}
+
 static void 
 vty_out_cpu_thread_history(struct vty* vty,
 			   struct cpu_thread_history *a)
@@ -353,53 +403,10 @@ DEFUN(show_thread_cpu,
       "Thread CPU usage\n"
       "Display filter (rwtexb)\n")
 {
-  int i = 0;
   thread_type filter = (thread_type) -1U;
 
-  if (argc > 0)
-    {
-      filter = 0;
-      while (argv[0][i] != '\0')
-	{
-	  switch ( argv[0][i] )
-	    {
-	    case 'r':
-	    case 'R':
-	      filter |= (1 << THREAD_READ);
-	      break;
-	    case 'w':
-	    case 'W':
-	      filter |= (1 << THREAD_WRITE);
-	      break;
-	    case 't':
-	    case 'T':
-	      filter |= (1 << THREAD_TIMER);
-	      break;
-	    case 'e':
-	    case 'E':
-	      filter |= (1 << THREAD_EVENT);
-	      break;
-	    case 'x':
-	    case 'X':
-	      filter |= (1 << THREAD_EXECUTE);
-	      break;
-	    case 'b':
-	    case 'B':
-	      filter |= (1 << THREAD_BACKGROUND);
-	      break;
-	    default:
-	      break;
-	    }
-	  ++i;
-	}
-      if (filter == 0)
-	{
-	  vty_out(vty, "Invalid filter \"%s\" specified,"
-                  " must contain at least one of 'RWTEXB'%s",
-		  argv[0], VTY_NEWLINE);
-	  return CMD_WARNING;
-	}
-    }
+  if (argc > 0 && thread_filter_parse (vty, argv[0], &filter) < 0)
+    return CMD_WARNING;
 
   cpu_record_print(vty, filter);
   return CMD_SUCCESS;
@@ -436,55 +443,216 @@ DEFUN(clear_thread_cpu,
       "Thread CPU usage\n"
       "Display filter (rwtexb)\n")
 {
-  int i = 0;
   thread_type filter = (thread_type) -1U;
 
-  if (argc > 0)
+  if (argc > 0 && thread_filter_parse (vty, argv[0], &filter) < 0)
+    return CMD_WARNING;
+
+  cpu_record_clear (filter);
+  return CMD_SUCCESS;
+}
+
+/* Latency histograms. */
+void
+thread_hist_add (struct thread_hist *h, unsigned long usec)
+{
+  unsigned int i = 0;
+
+  while (i < THREAD_HIST_BUCKETS - 1 && (usec >> i) != 0)
+    i++;
+  h->bucket[i]++;
+  h->count++;
+  if (h->max < usec)
+    h->max = usec;
+}
+
+static void
+thread_hist_merge (struct thread_hist *to, const struct thread_hist *from)
+{
+  unsigned int i;
+
+  for (i = 0; i < THREAD_HIST_BUCKETS; i++)
+    to->bucket[i] += from->bucket[i];
+  to->count += from->count;
+  if (to->max < from->max)
+    to->max = from->max;
+}
+
+/* Upper bound of the bucket holding the given quantile (in parts per
+   thousand), clamped to the largest value seen. */
+unsigned long
+thread_hist_quantile (const struct thread_hist *h, unsigned int permille)
+{
+  unsigned long rank, seen = 0;
+  unsigned int i;
+
+  if (h->count == 0)
+    return 0;
+
+  rank = (h->count * permille + 999) / 1000;
+  if (rank == 0)
+    rank = 1;
+
+  for (i = 0; i < THREAD_HIST_BUCKETS; i++)
     {
-      filter = 0;
-      while (argv[0][i] != '\0')
-	{
-	  switch ( argv[0][i] )
-	    {
-	    case 'r':
-	    case 'R':
-	      filter |= (1 << THREAD_READ);
-	      break;
-	    case 'w':
-	    case 'W':
-	      filter |= (1 << THREAD_WRITE);
-	      break;
-	    case 't':
-	    case 'T':
-	      filter |= (1 << THREAD_TIMER);
-	      break;
-	    case 'e':
-	    case 'E':
-	      filter |= (1 << THREAD_EVENT);
-	      break;
-	    case 'x':
-	    case 'X':
-	      filter |= (1 << THREAD_EXECUTE);
-	      break;
-	    case 'b':
-	    case 'B':
-	      filter |= (1 << THREAD_BACKGROUND);
-	      break;
-	    default:
-	      break;
-	    }
-	  ++i;
-	}
-      if (filter == 0)
-	{
-	  vty_out(vty, "Invalid filter \"%s\" specified,"
-                  " must contain at least one of 'RWTEXB'%s",
-		  argv[0], VTY_NEWLINE);
-	  return CMD_WARNING;
-	}
+      seen += h->bucket[i];
+      if (seen >= rank)
+	break;
     }
+  if (i == 0)
+    return 0;
+  if (i >= THREAD_HIST_BUCKETS - 1 || ((1UL << i) - 1) > h->max)
+    return h->max;
+  return (1UL << i) - 1;
+}
 
-  cpu_record_clear (filter);
+/* One "name count p50 p99 p99.9 max" line of a histogram table, as
+   shown by the link metrics statistics in zebra and ospf6d. */
+void
+vty_out_thread_hist_row (struct vty *vty, const char *name,
+			 const struct thread_hist *h)
+{
+  vty_out (vty, "  %-18s %8lu %8lu %8lu %8lu %8lu%s", name, h->count,
+	   thread_hist_quantile (h, 500), thread_hist_quantile (h, 990),
+	   thread_hist_quantile (h, 999), h->max, VTY_NEWLINE);
+}
+
+static void
+vty_out_thread_hist (struct vty *vty, const struct thread_hist *h)
+{
+  vty_out (vty, " %7lu %7lu %7lu %8lu",
+	   thread_hist_quantile (h, 500), thread_hist_quantile (h, 990),
+	   thread_hist_quantile (h, 999), h->max);
+}
+
+static void
+vty_out_thread_types (struct vty *vty, thread_type types)
+{
+  vty_out (vty, "%c%c%c%c%c%c",
+	   types & (1 << THREAD_READ) ? 'R':' ',
+	   types & (1 << THREAD_WRITE) ? 'W':' ',
+	   types & (1 << THREAD_TIMER) ? 'T':' ',
+	   types & (1 << THREAD_EVENT) ? 'E':' ',
+	   types & (1 << THREAD_EXECUTE) ? 'X':' ',
+	   types & (1 << THREAD_BACKGROUND) ? 'B' : ' ');
+}
+
+static void
+vty_out_thread_latency (struct vty *vty, struct cpu_thread_history *a)
+{
+  vty_out (vty, "%9u", a->total_calls);
+  vty_out_thread_hist (vty, &a->runtime);
+  vty_out_thread_hist (vty, &a->lag);
+  vty_out (vty, "  ");
+  vty_out_thread_types (vty, a->types);
+  vty_out (vty, " %s%s", a->funcname, VTY_NEWLINE);
+}
+
+static void
+vty_out_thread_hist_dump (struct vty *vty, const char *name,
+			  const struct thread_hist *h)
+{
+  int i, last;
+
+  vty_out (vty, " %s_count=%lu %s_p50=%lu %s_p99=%lu %s_p999=%lu %s_max=%lu",
+	   name, h->count,
+	   name, thread_hist_quantile (h, 500),
+	   name, thread_hist_quantile (h, 990),
+	   name, thread_hist_quantile (h, 999),
+	   name, h->max);
+
+  /* Raw log2 buckets, trailing empty ones omitted. */
+  for (last = THREAD_HIST_BUCKETS - 1; last > 0; last--)
+    if (h->bucket[last])
+      break;
+  vty_out (vty, " %s_hist=", name);
+  for (i = 0; i <= last; i++)
+    vty_out (vty, "%s%u", i ? "," : "", h->bucket[i]);
+}
+
+static void
+vty_out_thread_latency_dump (struct vty *vty, struct cpu_thread_history *a)
+{
+  vty_out (vty, "thread=%s types=", a->funcname);
+  vty_out_thread_types (vty, a->types);
+  vty_out (vty, " calls=%u", a->total_calls);
+  vty_out_thread_hist_dump (vty, "run", &a->runtime);
+  vty_out_thread_hist_dump (vty, "lag", &a->lag);
+  vty_out (vty, "%s", VTY_NEWLINE);
+}
+
+static void
+cpu_record_hash_latency (struct hash_backet *bucket, void *args[])
+{
+  struct cpu_thread_history *totals = args[0];
+  struct vty *vty = args[1];
+  thread_type *filter = args[2];
+  void (*print) (struct vty *, struct cpu_thread_history *) = args[3];
+  struct cpu_thread_history *a = bucket->data;
+
+  if ( !(a->types & *filter) )
+    return;
+  print (vty, a);
+  totals->total_calls += a->total_calls;
+  totals->types |= a->types;
+  thread_hist_merge (&totals->runtime, &a->runtime);
+  thread_hist_merge (&totals->lag, &a->lag);
+}
+
+static void
+cpu_record_latency (struct vty *vty, thread_type filter,
+		    void (*print) (struct vty *, struct cpu_thread_history *))
+{
+  struct cpu_thread_history tmp;
+  void *args[4] = {&tmp, vty, &filter, print};
+
+  memset (&tmp, 0, sizeof tmp);
+  tmp.funcname = (char *)"TOTAL";
+
+  hash_iterate (cpu_record,
+		(void (*) (struct hash_backet *, void *))cpu_record_hash_latency,
+		args);
+
+  if (tmp.total_calls > 0)
+    print (vty, &tmp);
+}
+
+DEFUN(show_thread_latency,
+      show_thread_latency_cmd,
+      "show thread latency [FILTER]",
+      SHOW_STR
+      "Thread information\n"
+      "Thread run time and scheduling lag distribution\n"
+      "Display filter (rwtexb)\n")
+{
+  thread_type filter = (thread_type) -1U;
+
+  if (argc > 0 && thread_filter_parse (vty, argv[0], &filter) < 0)
+    return CMD_WARNING;
+
+  vty_out (vty, "%9s %33s %33s%s",
+	   "", "Run time (usec):", "Scheduling lag (usec):", VTY_NEWLINE);
+  vty_out (vty, "  Invoked     p50     p99    p999      Max"
+	   "     p50     p99    p999      Max  Type   Thread%s", VTY_NEWLINE);
+  cpu_record_latency (vty, filter, vty_out_thread_latency);
+  return CMD_SUCCESS;
+}
+
+DEFUN(show_thread_latency_dump,
+      show_thread_latency_dump_cmd,
+      "show thread latency dump [FILTER]",
+      SHOW_STR
+      "Thread information\n"
+      "Thread run time and scheduling lag distribution\n"
+      "Machine readable output, one key=value line per thread\n"
+      "Display filter (rwtexb)\n")
+{
+  thread_type filter = (thread_type) -1U;
+
+  if (argc > 0 && thread_filter_parse (vty, argv[0], &filter) < 0)
+    return CMD_WARNING;
+
+  cpu_record_latency (vty, filter, vty_out_thread_latency_dump);
   return CMD_SUCCESS;
 }
 
@@ -883,6 +1051,8 @@ funcname_thread_add_event (struct thread_master *m,
 
   thread = thread_get (m, THREAD_EVENT, func, arg, funcname);
   thread->u.val = val;
+  quagga_get_relative (NULL);
+  thread->queued = relative_time;
   thread_list_add (&m->event, thread);
 
   return thread;
@@ -995,6 +1165,8 @@ thread_process_fd (struct thread_list *list, fd_set *fdset, fd_set *mfdset)
           thread_list_delete (list, thread);
           thread_list_add (&thread->master->ready, thread);
           thread->type = THREAD_READY;
+          /* relative_time was refreshed right after select() */
+          thread->queued = relative_time;
           ready++;
         }
     }
@@ -1212,6 +1384,30 @@ thread_call (struct thread *thread)
 
   GETRUSAGE (&thread->ru);
 
+  /* Scheduling lag: how late a timer fired, or how long an event or
+   * ready fd waited before being run.  Executed threads run inline.
+   */
+  switch (thread->add_type)
+    {
+    case THREAD_TIMER:
+    case THREAD_BACKGROUND:
+      thread_hist_add (&thread->hist->lag,
+		       timeval_cmp (thread->ru.real, thread->u.sands) > 0
+		       ? timeval_elapsed (thread->ru.real, thread->u.sands)
+		       : 0);
+      break;
+    case THREAD_EVENT:
+    case THREAD_READ:
+    case THREAD_WRITE:
+      thread_hist_add (&thread->hist->lag,
+		       timeval_cmp (thread->ru.real, thread->queued) > 0
+		       ? timeval_elapsed (thread->ru.real, thread->queued)
+		       : 0);
+      break;
+    default:
+      break;
+    }
+
   (*thread->func) (thread);
 
   GETRUSAGE (&ru);
@@ -1220,6 +1416,7 @@ thread_call (struct thread *thread)
   thread->hist->real.total += realtime;
   if (thread->hist->real.max < realtime)
     thread->hist->real.max = realtime;
+  thread_hist_add (&thread->hist->runtime, realtime);
 #ifdef HAVE_RUSAGE
   thread->hist->cpu.total += cputime;
   if (thread->hist->cpu.max < cputime)
@@ -89,11 +89,25 @@ struct thread
     struct timeval sands;	/* rest of time sands value. */
   } u;
   RUSAGE_T ru;			/* Indepth usage info.  */
+  struct timeval queued;	/* when the event was added or the fd
+				   became ready, for scheduling lag */
   struct cpu_thread_history *hist; /* cache pointer to cpu_history */
   char* funcname;
   void *data;
 };
 
+/* Log2 latency histogram, in microseconds.  Bucket 0 counts zero,
+ * bucket i (i > 0) counts values in [2^(i-1), 2^i), and the last
+ * bucket also takes everything larger. */
+#define THREAD_HIST_BUCKETS 32
+
+struct thread_hist
+{
+  unsigned long count;
+  unsigned long max;
+  unsigned int bucket[THREAD_HIST_BUCKETS];
+};
+
 struct cpu_thread_history 
 {
   int (*func)(struct thread *);
@@ -107,6 +121,8 @@ struct cpu_thread_history
   struct time_stats cpu;
 #endif
   thread_type types;
+  struct thread_hist runtime;	/* wall-clock run time per call */
+  struct thread_hist lag;	/* timer lateness / ready queue wait */
 };
 
 /* Clocks supported by Quagga */
@@ -219,6 +235,16 @@ extern int thread_should_yield (struct thread *);
 extern void thread_getrusage (RUSAGE_T *);
 extern struct cmd_element show_thread_cpu_cmd;
 extern struct cmd_element clear_thread_cpu_cmd;
+extern struct cmd_element show_thread_latency_cmd;
+extern struct cmd_element show_thread_latency_dump_cmd;
+
+/* Latency histograms, also usable outside the thread statistics. */
+extern void thread_hist_add (struct thread_hist *, unsigned long);
+extern unsigned long thread_hist_quantile (const struct thread_hist *,
+					   unsigned int);
+struct vty;
+extern void vty_out_thread_hist_row (struct vty *, const char *,
+				     const struct thread_hist *);
 
 /* replacements for the system gettimeofday(), clock_gettime() and
  * time() functions, providing support for non-decrementing clock on
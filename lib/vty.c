@@ -272,6 +272,59 @@ vty_prompt (struct vty *vty)
     }
 }
 
+/* Stream the output of a show command.  Rather than rendering a whole
+   table at once, the command hands over a walker that outputs the next
+   few entries each time it is called, keeping its position in arg, and
+   returns nonzero while there is more to come.  The vty calls it again
+   whenever what it output so far has been written out, so the output
+   buffer stays small and the daemon keeps running other threads in
+   between.  walk_free, if given, releases arg once the walk is over or
+   abandoned. */
+int
+vty_walk (struct vty *vty, int (*walk) (struct vty *, void *),
+	  void (*walk_free) (void *), void *arg)
+{
+  if ((vty->type == VTY_TERM || vty->type == VTY_SHELL_SERV) && !vty->walk)
+    {
+      vty->walk = walk;
+      vty->walk_free = walk_free;
+      vty->walk_arg = arg;
+      return CMD_SUCCESS;
+    }
+
+  /* Nothing to resume from: run it through. */
+  while ((*walk) (vty, arg))
+    ;
+  if (walk_free)
+    (*walk_free) (arg);
+  return CMD_SUCCESS;
+}
+
+static void
+vty_walk_stop (struct vty *vty)
+{
+  if (!vty->walk)
+    return;
+
+  if (vty->walk_free)
+    (*vty->walk_free) (vty->walk_arg);
+  vty->walk = NULL;
+  vty->walk_free = NULL;
+  vty->walk_arg = NULL;
+}
+
+/* Pull the next slice of a streaming show command into the output
+   buffer.  Returns 0 once the walk is over. */
+static int
+vty_walk_fill (struct vty *vty)
+{
+  while (vty->walk && buffer_pending (vty->obuf) < VTY_WALK_SLICE)
+    if (!(*vty->walk) (vty, vty->walk_arg))
+      vty_walk_stop (vty);
+
+  return (vty->walk != NULL);
+}
+
 /* Send WILL TELOPT_ECHO to remote server. */
 static void
 vty_will_echo (struct vty *vty)
@@ -1300,7 +1353,8 @@ vty_execute (struct vty *vty)
   vty->cp = vty->length = 0;
   vty_clear_buf (vty);
 
-  if (vty->status != VTY_CLOSE )
+  /* A streaming show command puts out the prompt when it is done. */
+  if (vty->status != VTY_CLOSE && !vty->walk)
     vty_prompt (vty);
 
   return ret;
@@ -1341,6 +1395,7 @@ vty_escape_map (unsigned char c, struct vty *vty)
 static void
 vty_buffer_reset (struct vty *vty)
 {
+  vty_walk_stop (vty);
   buffer_reset (vty->obuf);
   vty_prompt (vty);
   vty_redraw_line (vty);
@@ -1431,6 +1486,14 @@ vty_read (struct thread *thread)
 	  continue;
 	}
 
+      /* Only an interrupt is taken while a show command streams. */
+      if (vty->walk)
+	{
+	  if (buf[i] == CONTROL('C'))
+	    vty_buffer_reset (vty);
+	  continue;
+	}
+
       /* Escape character. */
       if (vty->escape == VTY_ESCAPE)
 	{
@@ -1577,6 +1640,11 @@ vty_flush (struct thread *thread)
   /* Function execution continue. */
   erase = ((vty->status == VTY_MORE || vty->status == VTY_MORELINE));
 
+  /* Next slice of a streaming show command, the prompt follows the
+     last one. */
+  if (vty->walk && !vty_walk_fill (vty))
+    vty_prompt (vty);
+
   /* N.B. if width is 0, that means we don't know the window size. */
   if ((vty->lines == 0) || (vty->width == 0))
     flushrc = buffer_flush_available(vty->obuf, vty->fd);
@@ -1605,6 +1673,8 @@ vty_flush (struct thread *thread)
 	  vty->status = VTY_NORMAL;
 	  if (vty->lines == 0)
 	    vty_event (VTY_READ, vty_sock, vty);
+	  if (vty->walk)
+	    vty_event (VTY_WRITE, vty_sock, vty);
 	}
       break;
     case BUFFER_PENDING:
@@ -2055,6 +2125,8 @@ vtysh_flush(struct vty *vty)
       return -1;
       break;
     case BUFFER_EMPTY:
+      if (vty->walk)
+	vty_event(VTYSH_WRITE, vty->fd, vty);
       break;
     }
   return 0;
@@ -2117,8 +2189,13 @@ vtysh_read (struct thread *thread)
 	  printf ("vtysh node: %d\n", vty->node);
 #endif /* VTYSH_DEBUG */
 
-	  header[3] = ret;
-	  buffer_put(vty->obuf, header, 4);
+	  /* The result of a streaming show command follows its output,
+	     see vtysh_write (). */
+	  if (!vty->walk)
+	    {
+	      header[3] = ret;
+	      buffer_put(vty->obuf, header, 4);
+	    }
 
 	  if (!vty->t_write && (vtysh_flush(vty) < 0))
 	    /* Try to flush results; exit if a write error occurs. */
@@ -2137,6 +2214,12 @@ vtysh_write (struct thread *thread)
   struct vty *vty = THREAD_ARG (thread);
 
   vty->t_write = NULL;
+  if (vty->walk && !vty_walk_fill (vty))
+    {
+      u_char header[4] = {0, 0, 0, CMD_SUCCESS};
+
+      buffer_put(vty->obuf, header, 4);
+    }
   vtysh_flush(vty);
   return 0;
 }
@@ -2185,6 +2268,9 @@ vty_close (struct vty *vty)
   if (vty->t_timeout)
     thread_cancel (vty->t_timeout);
 
+  /* Abandon a streaming show command. */
+  vty_walk_stop (vty);
+
   /* Flush buffer. */
   buffer_flush_all (vty->obuf, vty->fd);
 
@@ -2460,6 +2546,22 @@ vty_log (const char *level, const char *proto_str,
 	}
 }
 
+/* Is any vty monitoring the log? */
+int
+vty_log_active (void)
+{
+  unsigned int i;
+  struct vty *vty;
+
+  if (!vtyvec)
+    return 0;
+
+  for (i = 0; i < vector_active (vtyvec); i++)
+    if ((vty = vector_slot (vtyvec, i)) != NULL && vty->monitor)
+      return 1;
+  return 0;
+}
+
 /* Async-signal-safe version of vty_log for fixed strings. */
 void
 vty_log_fixed (const char *buf, size_t len)
@@ -2971,6 +3073,7 @@ vty_init (struct thread_master *master_thread)
   vtyvec = vector_init (VECTOR_MIN_SIZE);
 
   master = master_thread;
+  zlog_async_init (master_thread);
 
   /* Initilize server thread vector. */
   Vvty_serv_thread = vector_init (VECTOR_MIN_SIZE);
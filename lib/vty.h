@@ -118,11 +118,20 @@ struct vty
   /* Timeout seconds and thread. */
   unsigned long v_timeout;
   struct thread *t_timeout;
+
+  /* Show command streaming its output, see vty_walk (). */
+  int (*walk) (struct vty *, void *);
+  void (*walk_free) (void *);
+  void *walk_arg;
 };
 
 /* Integrated configuration file. */
 #define INTEGRATE_DEFAULT_CONFIG "Quagga.conf"
 
+/* Output a streaming show command pulls into the vty buffer at a time.
+   Walkers should output no more than this in a single call. */
+#define VTY_WALK_SLICE 16384
+
 /* Small macro to determine newline is newline only or linefeed needed. */
 #define VTY_NEWLINE  ((vty->type == VTY_TERM) ? "\r\n" : "\n")
 #define VNL VTY_NEWLINE
@@ -221,9 +230,14 @@ extern int vty_config_unlock (struct vty *);
 extern int vty_shell (struct vty *);
 extern int vty_shell_serv (struct vty *);
 extern void vty_hello (struct vty *);
+extern int vty_walk (struct vty *, int (*walk) (struct vty *, void *),
+                     void (*walk_free) (void *), void *arg);
 
 /* Send a fixed-size message to all vty terminal monitors; this should be
    an async-signal-safe function. */
 extern void vty_log_fixed (const char *buf, size_t len);
 
+/* Is any vty terminal monitoring the log? */
+extern int vty_log_active (void);
+
 #endif /* _ZEBRA_VTY_H */
@@ -32,12 +32,14 @@
 #include "zclient.h"
 #include "memory.h"
 #include "table.h"
+#include "zebra_linkmetrics.h"
 
 /* Zebra client events. */
 enum event {ZCLIENT_SCHEDULE, ZCLIENT_READ, ZCLIENT_CONNECT};
 
 /* Prototype for event manager. */
 static void zclient_event (enum event, struct zclient *);
+static int zclient_read_resume (struct thread *);
 
 extern struct thread_master *master;
 
@@ -53,7 +55,7 @@ zclient_new ()
   struct zclient *zclient;
   zclient = XCALLOC (MTYPE_ZCLIENT, sizeof (struct zclient));
 
-  zclient->ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  zclient->ibuf = stream_new (ZEBRA_READ_BUFSIZ);
   zclient->obuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   zclient->wb = buffer_new(0);
 
@@ -72,6 +74,8 @@ zclient_free (struct zclient *zclient)
     stream_free(zclient->ibuf);
   if (zclient->obuf)
     stream_free(zclient->obuf);
+  if (zclient->bulk_ibuf)
+    stream_free(zclient->bulk_ibuf);
   if (zclient->wb)
     buffer_free(zclient->wb);
 
@@ -129,6 +133,9 @@ zclient_stop (struct zclient *zclient)
   /* Empty the write buffer. */
   buffer_reset(zclient->wb);
 
+  /* Capabilities are renegotiated on every connection. */
+  zclient->capabilities = 0;
+
   /* Close socket. */
   if (zclient->sock >= 0)
     {
@@ -330,6 +337,7 @@ zebra_hello_send (struct zclient *zclient)
 
       zclient_create_header (s, ZEBRA_HELLO);
       stream_putc (s, zclient->redist_default);
+      stream_putc (s, ZEBRA_CAPABILITY_ALL);
       stream_putw_at (s, 0, stream_get_endp (s));
       return zclient_send_message(zclient);
     }
@@ -461,30 +469,10 @@ zclient_connect (struct thread *t)
   *
   * XXX: No attention paid to alignment.
   */ 
-int
-zapi_ipv4_route (u_char cmd, struct zclient *zclient, struct prefix_ipv4 *p,
-                 struct zapi_ipv4 *api)
+static void
+zapi_ipv4_put_nexthops (struct stream *s, struct zapi_ipv4 *api)
 {
   int i;
-  int psize;
-  struct stream *s;
-
-  /* Reset stream. */
-  s = zclient->obuf;
-  stream_reset (s);
-  
-  zclient_create_header (s, cmd);
-  
-  /* Put type and nexthop. */
-  stream_putc (s, api->type);
-  stream_putc (s, api->flags);
-  stream_putc (s, api->message);
-  stream_putw (s, api->safi);
-
-  /* Put prefix information. */
-  psize = PSIZE (p->prefixlen);
-  stream_putc (s, p->prefixlen);
-  stream_write (s, (u_char *) & p->prefix, psize);
 
   /* Nexthop, ifindex, distance and metric information. */
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_NEXTHOP))
@@ -515,38 +503,138 @@ zapi_ipv4_route (u_char cmd, struct zclient *zclient, struct prefix_ipv4 *p,
     stream_putc (s, api->distance);
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_METRIC))
     stream_putl (s, api->metric);
-
-  /* Put length at the first point of the stream. */
-  stream_putw_at (s, 0, stream_get_endp (s));
-
-  return zclient_send_message(zclient);
 }
 
-#ifdef HAVE_IPV6
 int
-zapi_ipv6_route (u_char cmd, struct zclient *zclient, struct prefix_ipv6 *p,
-	       struct zapi_ipv6 *api)
+zapi_ipv4_route (u_char cmd, struct zclient *zclient, struct prefix_ipv4 *p,
+                 struct zapi_ipv4 *api)
 {
-  int i;
   int psize;
   struct stream *s;
 
   /* Reset stream. */
   s = zclient->obuf;
   stream_reset (s);
-
+  
   zclient_create_header (s, cmd);
-
+  
   /* Put type and nexthop. */
   stream_putc (s, api->type);
   stream_putc (s, api->flags);
   stream_putc (s, api->message);
   stream_putw (s, api->safi);
-  
+
   /* Put prefix information. */
   psize = PSIZE (p->prefixlen);
   stream_putc (s, p->prefixlen);
-  stream_write (s, (u_char *)&p->prefix, psize);
+  stream_write (s, (u_char *) & p->prefix, psize);
+
+  zapi_ipv4_put_nexthops (s, api);
+
+  /* Put length at the first point of the stream. */
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zclient_send_message(zclient);
+}
+
+/*
+ * Bulk variant of the ZEBRA_IPV{4,6}_ROUTE_{ADD,DELETE} messages, used
+ * when zebra has agreed to ZEBRA_CAPABILITY_BULK_ROUTE.  Many prefixes
+ * share one set of nexthops, distance and metric:
+ *
+ *  0 1 2 3 4 5 6 7 8 9 A B C D E F 0 1 2 3 4 5 6 7 8 9 A B C D E F
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * | Route Type    | ZEBRA Flags   | Message Flags |     SAFI      :
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * :               |        Prefix count           |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * followed by "Prefix count" (prefix length, prefix) pairs encoded as
+ * in the single-route message, and then the nexthop, distance and
+ * metric fields exactly as they follow the prefix in that message.
+ * Each frame is bounded by ZEBRA_MAX_PACKET_SIZ; longer prefix vectors
+ * are split across as many frames as needed.
+ */
+static size_t
+zapi_route_bulk_start (struct stream *s, u_char cmd, u_char type,
+                       u_char flags, u_char message, safi_t safi)
+{
+  size_t countp;
+
+  stream_reset (s);
+  zclient_create_header (s, cmd);
+
+  stream_putc (s, type);
+  stream_putc (s, flags);
+  stream_putc (s, message);
+  stream_putw (s, safi);
+
+  /* Prefix count placeholder. */
+  countp = stream_get_endp (s);
+  stream_putw (s, 0);
+
+  return countp;
+}
+
+int
+zapi_ipv4_route_bulk (u_char cmd, struct zclient *zclient,
+                      struct prefix_ipv4 **p, u_int32_t count,
+                      struct zapi_ipv4 *api)
+{
+  u_int32_t i, n;
+  size_t countp, tail_size;
+  int psize;
+  u_char bulk_cmd;
+  struct stream *s;
+
+  /* Older zebra: one message per prefix. */
+  if (! CHECK_FLAG (zclient->capabilities, ZEBRA_CAPABILITY_BULK_ROUTE))
+    {
+      for (i = 0; i < count; i++)
+        if (zapi_ipv4_route (cmd, zclient, p[i], api) < 0)
+          return -1;
+      return 0;
+    }
+
+  bulk_cmd = (cmd == ZEBRA_IPV4_ROUTE_ADD) ?
+    ZEBRA_IPV4_ROUTE_BULK_ADD : ZEBRA_IPV4_ROUTE_BULK_DELETE;
+
+  /* Size of the shared nexthop part, reserved in every frame. */
+  s = zclient->obuf;
+  stream_reset (s);
+  zapi_ipv4_put_nexthops (s, api);
+  tail_size = stream_get_endp (s);
+
+  for (i = 0; i < count; i += n)
+    {
+      countp = zapi_route_bulk_start (s, bulk_cmd, api->type, api->flags,
+                                      api->message, api->safi);
+
+      for (n = 0; i + n < count && n < UINT16_MAX; n++)
+        {
+          psize = PSIZE (p[i + n]->prefixlen);
+          if (STREAM_WRITEABLE (s) < 1 + psize + tail_size)
+            break;
+          stream_putc (s, p[i + n]->prefixlen);
+          stream_write (s, (u_char *) &p[i + n]->prefix, psize);
+        }
+
+      stream_putw_at (s, countp, n);
+      zapi_ipv4_put_nexthops (s, api);
+      stream_putw_at (s, 0, stream_get_endp (s));
+
+      if (zclient_send_message (zclient) < 0)
+        return -1;
+    }
+
+  return 0;
+}
+
+#ifdef HAVE_IPV6
+static void
+zapi_ipv6_put_nexthops (struct stream *s, struct zapi_ipv6 *api)
+{
+  int i;
 
   /* Nexthop, ifindex, distance and metric information. */
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_NEXTHOP))
@@ -569,12 +657,93 @@ zapi_ipv6_route (u_char cmd, struct zclient *zclient, struct prefix_ipv6 *p,
     stream_putc (s, api->distance);
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_METRIC))
     stream_putl (s, api->metric);
+}
+
+int
+zapi_ipv6_route (u_char cmd, struct zclient *zclient, struct prefix_ipv6 *p,
+	       struct zapi_ipv6 *api)
+{
+  int psize;
+  struct stream *s;
+
+  /* Reset stream. */
+  s = zclient->obuf;
+  stream_reset (s);
+
+  zclient_create_header (s, cmd);
+
+  /* Put type and nexthop. */
+  stream_putc (s, api->type);
+  stream_putc (s, api->flags);
+  stream_putc (s, api->message);
+  stream_putw (s, api->safi);
+  
+  /* Put prefix information. */
+  psize = PSIZE (p->prefixlen);
+  stream_putc (s, p->prefixlen);
+  stream_write (s, (u_char *)&p->prefix, psize);
+
+  zapi_ipv6_put_nexthops (s, api);
 
   /* Put length at the first point of the stream. */
   stream_putw_at (s, 0, stream_get_endp (s));
 
   return zclient_send_message(zclient);
 }
+
+int
+zapi_ipv6_route_bulk (u_char cmd, struct zclient *zclient,
+                      struct prefix_ipv6 **p, u_int32_t count,
+                      struct zapi_ipv6 *api)
+{
+  u_int32_t i, n;
+  size_t countp, tail_size;
+  int psize;
+  u_char bulk_cmd;
+  struct stream *s;
+
+  /* Older zebra: one message per prefix. */
+  if (! CHECK_FLAG (zclient->capabilities, ZEBRA_CAPABILITY_BULK_ROUTE))
+    {
+      for (i = 0; i < count; i++)
+        if (zapi_ipv6_route (cmd, zclient, p[i], api) < 0)
+          return -1;
+      return 0;
+    }
+
+  bulk_cmd = (cmd == ZEBRA_IPV6_ROUTE_ADD) ?
+    ZEBRA_IPV6_ROUTE_BULK_ADD : ZEBRA_IPV6_ROUTE_BULK_DELETE;
+
+  /* Size of the shared nexthop part, reserved in every frame. */
+  s = zclient->obuf;
+  stream_reset (s);
+  zapi_ipv6_put_nexthops (s, api);
+  tail_size = stream_get_endp (s);
+
+  for (i = 0; i < count; i += n)
+    {
+      countp = zapi_route_bulk_start (s, bulk_cmd, api->type, api->flags,
+                                      api->message, api->safi);
+
+      for (n = 0; i + n < count && n < UINT16_MAX; n++)
+        {
+          psize = PSIZE (p[i + n]->prefixlen);
+          if (STREAM_WRITEABLE (s) < 1 + psize + tail_size)
+            break;
+          stream_putc (s, p[i + n]->prefixlen);
+          stream_write (s, (u_char *) &p[i + n]->prefix, psize);
+        }
+
+      stream_putw_at (s, countp, n);
+      zapi_ipv6_put_nexthops (s, api);
+      stream_putw_at (s, 0, stream_get_endp (s));
+
+      if (zclient_send_message (zclient) < 0)
+        return -1;
+    }
+
+  return 0;
+}
 #endif /* HAVE_IPV6 */
 
 /* 
@@ -874,97 +1043,166 @@ zebra_interface_address_read (int type, struct stream *s)
 }
 
 
-/* Zebra client message read function. */
+/* Zebra's answer to our hello: the capabilities it agreed to. */
+static void
+zclient_hello_read (struct zclient *zclient, uint16_t length)
+{
+  if (length >= 1)
+    zclient->capabilities = stream_getc (zclient->ibuf) & ZEBRA_CAPABILITY_ALL;
+
+  if (zclient_debug)
+    zlog_debug ("zclient zebra capabilities 0x%x", zclient->capabilities);
+}
+
+/* Hand a bulk route message from zebra to the ordinary per-route
+   callback, one prefix at a time, rebuilt in the single-route layout
+   zebra uses towards its clients (no SAFI field). */
 static int
-zclient_read (struct thread *thread)
+zclient_route_bulk_read (uint16_t command, struct zclient *zclient,
+			 uint16_t length)
 {
-  size_t already;
-  uint16_t length, command;
-  uint8_t marker, version;
-  struct zclient *zclient;
+  int (*func) (int, struct zclient *, uint16_t);
+  struct stream *ibuf, *s;
+  uint16_t route_cmd, count, i;
+  u_char type, flags, message, plen, maxlen;
+  size_t prefixp, tailp, endp, p;
 
-  /* Get socket to zebra. */
-  zclient = THREAD_ARG (thread);
-  zclient->t_read = NULL;
+  switch (command)
+    {
+    case ZEBRA_IPV4_ROUTE_BULK_ADD:
+      route_cmd = ZEBRA_IPV4_ROUTE_ADD;
+      func = zclient->ipv4_route_add;
+      maxlen = IPV4_MAX_PREFIXLEN;
+      break;
+    case ZEBRA_IPV4_ROUTE_BULK_DELETE:
+      route_cmd = ZEBRA_IPV4_ROUTE_DELETE;
+      func = zclient->ipv4_route_delete;
+      maxlen = IPV4_MAX_PREFIXLEN;
+      break;
+    case ZEBRA_IPV6_ROUTE_BULK_ADD:
+      route_cmd = ZEBRA_IPV6_ROUTE_ADD;
+      func = zclient->ipv6_route_add;
+      maxlen = IPV6_MAX_PREFIXLEN;
+      break;
+    case ZEBRA_IPV6_ROUTE_BULK_DELETE:
+      route_cmd = ZEBRA_IPV6_ROUTE_DELETE;
+      func = zclient->ipv6_route_delete;
+      maxlen = IPV6_MAX_PREFIXLEN;
+      break;
+    default:
+      return -1;
+    }
 
-  /* Read zebra header (if we don't have it already). */
-  if ((already = stream_get_endp(zclient->ibuf)) < ZEBRA_HEADER_SIZE)
+  if (! func)
+    return 0;
+
+  ibuf = zclient->ibuf;
+  if (STREAM_READABLE (ibuf) < 7)
+    return -1;
+
+  type = stream_getc (ibuf);
+  flags = stream_getc (ibuf);
+  message = stream_getc (ibuf);
+  stream_getw (ibuf);		/* SAFI */
+  count = stream_getw (ibuf);
+
+  /* Find the shared tail, checking every prefix lies within the frame. */
+  prefixp = p = stream_get_getp (ibuf);
+  endp = stream_get_endp (ibuf);
+  for (i = 0; i < count; i++)
     {
-      ssize_t nbyte;
-      if (((nbyte = stream_read_try(zclient->ibuf, zclient->sock,
-				     ZEBRA_HEADER_SIZE-already)) == 0) ||
-	  (nbyte == -1))
-	{
-	  if (zclient_debug)
-	   zlog_debug ("zclient connection closed socket [%d].", zclient->sock);
-	  return zclient_failed(zclient);
-	}
-      if (nbyte != (ssize_t)(ZEBRA_HEADER_SIZE-already))
+      if (p >= endp || (plen = ibuf->data[p]) > maxlen
+	  || p + 1 + PSIZE (plen) > endp)
 	{
-	  /* Try again later. */
-	  zclient_event (ZCLIENT_READ, zclient);
-	  return 0;
+	  zlog_warn ("%s: malformed %s, prefix %u of %u",
+		     __func__, zserv_command_string (command), i, count);
+	  return -1;
 	}
-      already = ZEBRA_HEADER_SIZE;
+      p += 1 + PSIZE (plen);
     }
+  tailp = p;
 
-  /* Reset to read from the beginning of the incoming packet. */
-  stream_set_getp(zclient->ibuf, 0);
+  if (! zclient->bulk_ibuf)
+    zclient->bulk_ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  s = zclient->bulk_ibuf;
 
-  /* Fetch header values. */
-  length = stream_getw (zclient->ibuf);
-  marker = stream_getc (zclient->ibuf);
-  version = stream_getc (zclient->ibuf);
-  command = stream_getw (zclient->ibuf);
-  
-  if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION)
+  for (i = 0, p = prefixp; i < count; i++)
     {
-      zlog_err("%s: socket %d version mismatch, marker %d, version %d",
-               __func__, zclient->sock, marker, version);
-      return zclient_failed(zclient);
-    }
-  
-  if (length < ZEBRA_HEADER_SIZE) 
-    {
-      zlog_err("%s: socket %d message length %u is less than %d ",
-	       __func__, zclient->sock, length, ZEBRA_HEADER_SIZE);
-      return zclient_failed(zclient);
-    }
+      plen = ibuf->data[p];
 
-  /* Length check. */
-  if (length > STREAM_SIZE(zclient->ibuf))
-    {
-      struct stream *ns;
-      zlog_warn("%s: message size %u exceeds buffer size %lu, expanding...",
-	        __func__, length, (u_long)STREAM_SIZE(zclient->ibuf));
-      ns = stream_new(length);
-      stream_copy(ns, zclient->ibuf);
-      stream_free (zclient->ibuf);
-      zclient->ibuf = ns;
+      stream_reset (s);
+      stream_putc (s, type);
+      stream_putc (s, flags);
+      stream_putc (s, message);
+      stream_put (s, ibuf->data + p, 1 + PSIZE (plen));
+      stream_put (s, ibuf->data + tailp, endp - tailp);
+      p += 1 + PSIZE (plen);
+
+      zclient->ibuf = s;
+      (*func) (route_cmd, zclient, stream_get_endp (s));
+      zclient->ibuf = ibuf;
+
+      if (zclient->sock < 0)
+	{
+	  /* The connection was reset under the scratch buffer. */
+	  stream_reset (ibuf);
+	  return -1;
+	}
     }
 
-  /* Read rest of zebra packet. */
-  if (already < length)
+  return 0;
+}
+
+/* Hand a link metrics batch to the daemon's batch callback, or failing
+   that to its per-neighbor callback one entry at a time. */
+static int
+zclient_linkmetrics_batch_read (uint16_t command, struct zclient *zclient,
+				uint16_t length)
+{
+  struct zebra_linkmetrics metrics[ZAPI_LINKMETRICS_BATCH_MAX];
+  struct stream *ibuf, *s;
+  struct timeval stamp;
+  u_int16_t count, i;
+
+  if (zclient->linkmetrics_batch)
+    return (*zclient->linkmetrics_batch) (command, zclient, length);
+
+  if (! zclient->linkmetrics)
+    return 0;
+
+  ibuf = zclient->ibuf;
+  if (zapi_read_linkmetrics_batch (metrics, &count, &stamp, ibuf, length))
+    return -1;
+
+  if (! zclient->bulk_ibuf)
+    zclient->bulk_ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  s = zclient->bulk_ibuf;
+
+  for (i = 0; i < count; i++)
     {
-      ssize_t nbyte;
-      if (((nbyte = stream_read_try(zclient->ibuf, zclient->sock,
-				     length-already)) == 0) ||
-	  (nbyte == -1))
-	{
-	  if (zclient_debug)
-	    zlog_debug("zclient connection closed socket [%d].", zclient->sock);
-	  return zclient_failed(zclient);
-	}
-      if (nbyte != (ssize_t)(length-already))
+      zapi_write_linkmetrics (s, &metrics[i]);
+      stream_forward_getp (s, ZEBRA_HEADER_SIZE);
+
+      zclient->ibuf = s;
+      (*zclient->linkmetrics) (ZEBRA_LINKMETRICS_METRICS, zclient,
+			       ZAPI_LINKMETRICS_LEN);
+      zclient->ibuf = ibuf;
+
+      if (zclient->sock < 0)
 	{
-	  /* Try again later. */
-	  zclient_event (ZCLIENT_READ, zclient);
-	  return 0;
+	  /* The connection was reset under the scratch buffer. */
+	  stream_reset (ibuf);
+	  return -1;
 	}
     }
 
-  length -= ZEBRA_HEADER_SIZE;
+  return 0;
+}
 
+/* Hand one message to the daemon's callback. */
+static void
+zclient_dispatch (struct zclient *zclient, uint16_t command, uint16_t length)
+{
   if (zclient_debug)
     zlog_debug("zclient 0x%p command 0x%x \n", zclient, command);
 
@@ -1018,6 +1256,9 @@ zclient_read (struct thread *thread)
       if (zclient->linkmetrics)
         (*zclient->linkmetrics) (command, zclient, length);
       break;
+    case ZEBRA_LINKMETRICS_METRICS_BATCH:
+      zclient_linkmetrics_batch_read (command, zclient, length);
+      break;
     case ZEBRA_LINKMETRICS_METRICS_REQUEST:
       if (zclient->linkmetrics_request)
         (*zclient->linkmetrics_request) (command, zclient, length);
@@ -1026,21 +1267,144 @@ zclient_read (struct thread *thread)
       if (zclient->linkstatus)
         (*zclient->linkstatus) (command, zclient, length);
       break;
+    case ZEBRA_IPV4_ROUTE_BULK_ADD:
+    case ZEBRA_IPV4_ROUTE_BULK_DELETE:
+    case ZEBRA_IPV6_ROUTE_BULK_ADD:
+    case ZEBRA_IPV6_ROUTE_BULK_DELETE:
+      zclient_route_bulk_read (command, zclient, length);
+      break;
+    case ZEBRA_HELLO:
+      zclient_hello_read (zclient, length);
+      break;
     default:
       break;
     }
+}
 
-  if (zclient->sock < 0)
-    /* Connection was closed during packet processing. */
-    return -1;
+/* Handle every complete message buffered in zclient->ibuf, in place.
+   Each callback sees a stream ending with its own message.  If this
+   takes longer than the thread time slot, the rest is left for an
+   event so other threads get to run; otherwise the remaining partial
+   message is moved to the front of the buffer and reading resumes. */
+static int
+zclient_process (struct zclient *zclient, struct thread *thread)
+{
+  struct stream *s;
+  size_t frame, endp, need = 0;
+  uint16_t length, command;
+  uint8_t marker, version;
+
+  s = zclient->ibuf;
+
+  while (STREAM_READABLE (s) >= ZEBRA_HEADER_SIZE)
+    {
+      /* Fetch header values. */
+      frame = stream_get_getp (s);
+      length = stream_getw_from (s, frame);
+      marker = stream_getc_from (s, frame + 2);
+      version = stream_getc_from (s, frame + 3);
+      command = stream_getw_from (s, frame + 4);
+
+      if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION)
+	{
+	  zlog_err("%s: socket %d version mismatch, marker %d, version %d",
+		   __func__, zclient->sock, marker, version);
+	  return zclient_failed(zclient);
+	}
+
+      if (length < ZEBRA_HEADER_SIZE)
+	{
+	  zlog_err("%s: socket %d message length %u is less than %d ",
+		   __func__, zclient->sock, length, ZEBRA_HEADER_SIZE);
+	  return zclient_failed(zclient);
+	}
+
+      /* Wait for the rest of the message. */
+      if (length > STREAM_READABLE (s))
+	{
+	  need = length;
+	  break;
+	}
+
+      endp = stream_get_endp (s);
+      stream_set_getp (s, frame + ZEBRA_HEADER_SIZE);
+      stream_set_endp (s, frame + length);
+
+      zclient_dispatch (zclient, command, length - ZEBRA_HEADER_SIZE);
+
+      if (zclient->sock < 0)
+	/* Connection was closed during packet processing. */
+	return -1;
+
+      /* Step over the message, whatever the callback consumed. */
+      stream_set_getp (s, frame + length);
+      stream_forward_endp (s, endp - (frame + length));
+
+      if (STREAM_READABLE (s) >= ZEBRA_HEADER_SIZE
+	  && thread_should_yield (thread))
+	{
+	  zclient->t_read =
+	    thread_add_event (master, zclient_read_resume, zclient, 0);
+	  return 0;
+	}
+    }
+
+  stream_pulldown (s);
+
+  /* Length check. */
+  if (need > STREAM_SIZE(s))
+    {
+      struct stream *ns;
+      zlog_warn("%s: message size %u exceeds buffer size %lu, expanding...",
+	        __func__, (unsigned) need, (u_long)STREAM_SIZE(s));
+      ns = stream_new(need);
+      stream_copy(ns, s);
+      stream_free (s);
+      zclient->ibuf = ns;
+    }
 
   /* Register read thread. */
-  stream_reset(zclient->ibuf);
   zclient_event (ZCLIENT_READ, zclient);
 
   return 0;
 }
 
+/* Continue with messages left over when zclient_process() yielded. */
+static int
+zclient_read_resume (struct thread *thread)
+{
+  struct zclient *zclient;
+
+  zclient = THREAD_ARG (thread);
+  zclient->t_read = NULL;
+
+  return zclient_process (zclient, thread);
+}
+
+/* Zebra client message read function.  Reads as much as the socket has
+   and the buffer can take, so a burst of messages costs one read. */
+static int
+zclient_read (struct thread *thread)
+{
+  ssize_t nbyte;
+  struct zclient *zclient;
+
+  /* Get socket to zebra. */
+  zclient = THREAD_ARG (thread);
+  zclient->t_read = NULL;
+
+  nbyte = stream_read_try (zclient->ibuf, zclient->sock,
+			   STREAM_WRITEABLE (zclient->ibuf));
+  if (nbyte == 0 || nbyte == -1)
+    {
+      if (zclient_debug)
+	zlog_debug ("zclient connection closed socket [%d].", zclient->sock);
+      return zclient_failed(zclient);
+    }
+
+  return zclient_process (zclient, thread);
+}
+
 void
 zclient_redistribute (int command, struct zclient *zclient, int type)
 {
@@ -31,9 +31,21 @@
 /* For input/output buffer to zebra. */
 #define ZEBRA_MAX_PACKET_SIZ          4096
 
+/* Receive buffer size.  Room for many messages, so that one read can
+   pick up a whole burst of them. */
+#define ZEBRA_READ_BUFSIZ             (ZEBRA_MAX_PACKET_SIZ * 16)
+
 /* Zebra header size. */
 #define ZEBRA_HEADER_SIZE             6
 
+/* Optional capabilities, negotiated through ZEBRA_HELLO.  A client
+   appends the capabilities it understands to its hello, and zebra
+   answers with the subset it supports. */
+#define ZEBRA_CAPABILITY_BULK_ROUTE   0x01
+#define ZEBRA_CAPABILITY_LINKMETRICS_BATCH 0x02
+#define ZEBRA_CAPABILITY_ALL          (ZEBRA_CAPABILITY_BULK_ROUTE | \
+                                       ZEBRA_CAPABILITY_LINKMETRICS_BATCH)
+
 /* Structure for the zebra client. */
 struct zclient
 {
@@ -52,6 +64,10 @@ struct zclient
   /* Input buffer for zebra message. */
   struct stream *ibuf;
 
+  /* Scratch buffer used to hand bulk route messages to the per-route
+     callbacks one prefix at a time. */
+  struct stream *bulk_ibuf;
+
   /* Output buffer for zebra message. */
   struct stream *obuf;
 
@@ -72,6 +88,9 @@ struct zclient
   /* Redistribute defauilt. */
   u_char default_information;
 
+  /* Capabilities zebra agreed to in its hello reply. */
+  u_char capabilities;
+
   /* Pointer to the callback functions. */
   int (*router_id_update) (int, struct zclient *, uint16_t);
   int (*interface_add) (int, struct zclient *, uint16_t);
@@ -88,6 +107,9 @@ struct zclient
   u_char linkmetrics_subscribe;
   /* link metrics callback functions */
   int (*linkmetrics) (int, struct zclient *, uint16_t);
+  /* optional; without it a batch is handed to linkmetrics one
+     neighbor at a time */
+  int (*linkmetrics_batch) (int, struct zclient *, uint16_t);
   int (*linkmetrics_request) (int, struct zclient *, uint16_t);
   int (*linkstatus) (int, struct zclient *, uint16_t);
 };
@@ -169,6 +191,9 @@ extern void zebra_interface_if_set_value (struct stream *, struct interface *);
 extern void zebra_router_id_update_read (struct stream *s, struct prefix *rid);
 extern int zapi_ipv4_route (u_char, struct zclient *, struct prefix_ipv4 *, 
                             struct zapi_ipv4 *);
+extern int zapi_ipv4_route_bulk (u_char, struct zclient *,
+                                 struct prefix_ipv4 **, u_int32_t,
+                                 struct zapi_ipv4 *);
 
 #ifdef HAVE_IPV6
 /* IPv6 prefix add and delete function prototype. */
@@ -196,6 +221,9 @@ struct zapi_ipv6
 
 extern int zapi_ipv6_route (u_char cmd, struct zclient *zclient, 
                      struct prefix_ipv6 *p, struct zapi_ipv6 *api);
+extern int zapi_ipv6_route_bulk (u_char cmd, struct zclient *zclient,
+                                 struct prefix_ipv6 **p, u_int32_t count,
+                                 struct zapi_ipv6 *api);
 #endif /* HAVE_IPV6 */
 
 extern int zclient_send_linkmetrics_subscribe (struct zclient *zclient,
@@ -423,7 +423,12 @@ struct in_pktinfo
 #define ZEBRA_LINKMETRICS_METRICS         26
 #define ZEBRA_LINKMETRICS_STATUS          27
 #define ZEBRA_LINKMETRICS_METRICS_REQUEST 28
-#define ZEBRA_MESSAGE_MAX                 29
+#define ZEBRA_IPV4_ROUTE_BULK_ADD         29
+#define ZEBRA_IPV4_ROUTE_BULK_DELETE      30
+#define ZEBRA_IPV6_ROUTE_BULK_ADD         31
+#define ZEBRA_IPV6_ROUTE_BULK_DELETE      32
+#define ZEBRA_LINKMETRICS_METRICS_BATCH   33
+#define ZEBRA_MESSAGE_MAX                 34
 
 /* Marker value used in new Zserv, in the byte location corresponding
  * the command value in the old zserv header. To allow old and new
@@ -102,6 +102,99 @@ zapi_read_linkmetrics (struct zebra_linkmetrics *metrics,
   return 0;
 }
 
+/* serialize up to ZAPI_LINKMETRICS_BATCH_MAX link metrics structures
+   that share the ifindex of the first one */
+int
+zapi_write_linkmetrics_batch (struct stream *s, const struct timeval *stamp,
+                              const struct zebra_linkmetrics *metrics,
+                              u_int16_t count)
+{
+  u_int16_t i;
+
+  if (count == 0 || count > ZAPI_LINKMETRICS_BATCH_MAX)
+    {
+      zlog_err ("%s: invalid count: %u", __func__, count);
+      return -1;
+    }
+
+  /* initialize the stream */
+  stream_reset (s);
+  zclient_create_header (s, ZEBRA_LINKMETRICS_METRICS_BATCH);
+
+  stream_putl (s, metrics[0].ifindex);
+  stream_putl (s, stamp->tv_sec);
+  stream_putl (s, stamp->tv_usec);
+  stream_putw (s, count);
+
+  for (i = 0; i < count; i++)
+    {
+      stream_put_in_addr (s, &metrics[i].nbr_addr4);
+      stream_write (s, &metrics[i].nbr_addr6, sizeof (metrics[i].nbr_addr6));
+
+      stream_putl (s, metrics[i].metrics.flags);
+      stream_putc (s, metrics[i].metrics.rlq);
+      stream_putc (s, metrics[i].metrics.resource);
+      stream_putw (s, metrics[i].metrics.latency);
+      stream_putq (s, metrics[i].metrics.current_datarate);
+      stream_putq (s, metrics[i].metrics.max_datarate);
+    }
+
+  /* put length at beginning of stream */
+  if (stream_putw_at (s, 0, stream_get_endp (s)) != 2)
+    zlog_err ("%s: stream_putw_at() failed for setting length", __func__);
+
+  return 0;
+}
+
+/* unserialize a link metrics batch; metrics must have room for
+   ZAPI_LINKMETRICS_BATCH_MAX structures */
+int
+zapi_read_linkmetrics_batch (struct zebra_linkmetrics *metrics,
+                             u_int16_t *count, struct timeval *stamp,
+                             struct stream *s, u_short length)
+{
+  u_int32_t ifindex;
+  u_int16_t i, n;
+
+  if (length < ZAPI_LINKMETRICS_BATCH_HDR_LEN)
+    {
+      zlog_err ("%s: invalid length: %u", __func__, length);
+      return -1;
+    }
+
+  ifindex = stream_getl (s);
+  stamp->tv_sec = stream_getl (s);
+  stamp->tv_usec = stream_getl (s);
+  n = stream_getw (s);
+
+  if (n > ZAPI_LINKMETRICS_BATCH_MAX ||
+      length != ZAPI_LINKMETRICS_BATCH_HDR_LEN +
+      n * ZAPI_LINKMETRICS_BATCH_ENTRY_LEN)
+    {
+      zlog_err ("%s: invalid length %u for %u entries",
+                __func__, length, n);
+      return -1;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      metrics[i].ifindex = ifindex;
+      metrics[i].nbr_addr4.s_addr = stream_get_ipv4 (s);
+      stream_get (&metrics[i].nbr_addr6, s, sizeof (metrics[i].nbr_addr6));
+
+      metrics[i].metrics.flags = stream_getl (s);
+      metrics[i].metrics.rlq = stream_getc (s);
+      metrics[i].metrics.resource = stream_getc (s);
+      metrics[i].metrics.latency = stream_getw (s);
+      metrics[i].metrics.current_datarate = stream_getq (s);
+      metrics[i].metrics.max_datarate = stream_getq (s);
+    }
+
+  *count = n;
+
+  return 0;
+}
+
 /* log the link status structure as a debug message */
 void
 zebra_linkstatus_logdebug (const struct zebra_linkstatus *status)
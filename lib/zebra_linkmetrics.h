@@ -51,6 +51,16 @@ struct zebra_linkmetrics
 };
 #define ZAPI_LINKMETRICS_LEN (24 + ZAPI_RFC4938_LINKMETRICS_LEN)
 
+/* A link metrics batch carries the metrics of several neighbors on
+   one interface, stamped with the wall clock time zebra learned the
+   oldest of them: ifindex, stamp (sec, usec), count, then count
+   entries laid out like a link metrics message without the ifindex. */
+#define ZAPI_LINKMETRICS_BATCH_HDR_LEN 14
+#define ZAPI_LINKMETRICS_BATCH_ENTRY_LEN (ZAPI_LINKMETRICS_LEN - 4)
+#define ZAPI_LINKMETRICS_BATCH_MAX \
+  ((ZEBRA_MAX_PACKET_SIZ - ZEBRA_HEADER_SIZE - \
+    ZAPI_LINKMETRICS_BATCH_HDR_LEN) / ZAPI_LINKMETRICS_BATCH_ENTRY_LEN)
+
 struct zebra_linkstatus
 {
   u_int32_t ifindex;         /* local interface index (if known) */
@@ -69,12 +79,20 @@ struct zebra_linkmetrics_request
 #define ZAPI_LINKMETRICS_REQUEST_LEN 24
 
 struct stream;
+struct timeval;
 
 void zebra_linkmetrics_logdebug (const struct zebra_linkmetrics *metrics);
 int zapi_write_linkmetrics (struct stream *s,
                             const struct zebra_linkmetrics *metrics);
 int zapi_read_linkmetrics (struct zebra_linkmetrics *metrics,
 			   struct stream *s, u_short length);
+int zapi_write_linkmetrics_batch (struct stream *s,
+                                  const struct timeval *stamp,
+                                  const struct zebra_linkmetrics *metrics,
+                                  u_int16_t count);
+int zapi_read_linkmetrics_batch (struct zebra_linkmetrics *metrics,
+                                 u_int16_t *count, struct timeval *stamp,
+                                 struct stream *s, u_short length);
 
 void zebra_linkstatus_logdebug (const struct zebra_linkstatus *status);
 
@@ -479,6 +479,17 @@ ospf6_area_show (struct vty *vty, struct ospf6_area *oa)
     vty_out (vty, " %s", oi->interface->name);
   
   vty_out (vty, "%s", VNL);
+
+  vty_out (vty, "     Intra-area route calculations: %u full, %u partial%s",
+           oa->intra_full_calc, oa->intra_partial_calc, VNL);
+  vty_out (vty, "       Last: %u vertices changed, %u Intra-Prefix LSAs "
+           "examined, %u/%u/%u routes added/changed/removed%s",
+           oa->intra_last_vertices, oa->intra_last_lsas,
+           oa->intra_last_churn.added, oa->intra_last_churn.changed,
+           oa->intra_last_churn.removed, VNL);
+  vty_out (vty, "       Total: %u/%u/%u routes added/changed/removed%s",
+           oa->intra_total_churn.added, oa->intra_total_churn.changed,
+           oa->intra_total_churn.removed, VNL);
 }
 
 #define OSPF6_CMD_AREA_LOOKUP(str, oa)                     \
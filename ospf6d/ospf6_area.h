@@ -24,6 +24,14 @@
 
 #include "ospf6_top.h"
 
+/* Route table churn of an intra-area route calculation */
+struct ospf6_route_churn
+{
+  u_int32_t added;
+  u_int32_t changed;
+  u_int32_t removed;
+};
+
 struct ospf6_area
 {
   /* Reference to Top data structure */
@@ -61,6 +69,14 @@ struct ospf6_area
   unsigned int spf_delay_msec;
   unsigned int spf_holdtime_msec;
 
+  /* Intra-area route calculation statistics */
+  u_int32_t intra_full_calc;
+  u_int32_t intra_partial_calc;
+  u_int32_t intra_last_vertices;   /* SPF vertices changed last time */
+  u_int32_t intra_last_lsas;       /* Intra-Area-Prefix-LSAs re-examined */
+  struct ospf6_route_churn intra_last_churn;
+  struct ospf6_route_churn intra_total_churn;
+
   struct thread *thread_router_lsa;
   struct thread *thread_intra_prefix_lsa;
   u_int32_t router_lsa_size_limit;
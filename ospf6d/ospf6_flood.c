@@ -855,7 +855,6 @@ ospf6_receive_lsa (struct ospf6_lsa_header *lsa_header,
 {
   struct ospf6_lsa *new = NULL, *old = NULL, *rem = NULL;
   int ismore_recent;
-  unsigned short cksum, cksum1;
   int is_debug = 0;
 
   ismore_recent = 1;
@@ -872,17 +871,7 @@ ospf6_receive_lsa (struct ospf6_lsa_header *lsa_header,
       ospf6_lsa_header_print (new);
     }
 
-  /* (1) LSA Checksum */
-  cksum = ntohs (new->header->checksum);
-  cksum1 = ntohs (ospf6_lsa_checksum (new->header));
-  if (cksum1 != cksum)
-    {
-      if (is_debug)
-        zlog_debug ("Wrong LSA Checksum, discard header %x compute %x",
-          cksum, cksum1);
-      ospf6_lsa_delete (new);
-      return;
-    }
+  /* (1) LSA Checksum: checked for the whole LSUpdate by the caller */
 
   /* (2) Examine the LSA's LS type. 
      RFC2470 3.5.1. Receiving Link State Update packets  */
@@ -1080,7 +1069,7 @@ ospf6_receive_lsa (struct ospf6_lsa_header *lsa_header,
         zlog_debug ("The same instance as database copy (neither recent)");
 
       if (from->ospf6_if->type == OSPF6_IFTYPE_MDR &&
-          old->backupWaitTimer && ospf6_lsa_compare (new, old) == 0)
+          old->backupwait && ospf6_lsa_compare (new, old) == 0)
         {
           struct listnode *node, *nnode;
           u_int32_t *id;
@@ -1095,7 +1084,7 @@ ospf6_receive_lsa (struct ospf6_lsa_header *lsa_header,
             {
               for (ALL_LIST_ELEMENTS (from->mdr.rnl, node, nnode, id))
                 {
-                  if (!old->backupWaitTimer)
+                  if (!old->backupwait)
                     break;
                   if (*id == from->ospf6_if->area->ospf6->router_id)
                     continue;
@@ -1172,7 +1161,7 @@ ospf6_receive_lsa (struct ospf6_lsa_header *lsa_header,
 
 	  // suppressing stale LSA responses
 	  // when the LSA will be sent pushBack algorithm
-	  if (old->backupWaitTimer)
+	  if (old->backupwait)
 	    {
 	      ospf6_lsa_delete (new);
 	      return;
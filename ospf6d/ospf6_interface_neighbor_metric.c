@@ -49,6 +49,12 @@ struct ospf6_interface_neighbor_metric {
   void (*nbrops_remove) (struct ospf6_interface *oi,
 			 struct ospf6_neighbor_operations *ops);
   void *data;
+
+  /* set while a batch of updates is applied */
+  int batch;
+  int batch_router_lsa;
+  int batch_spf;
+  unsigned int batch_changes;
 };
 
 static int
@@ -195,6 +201,7 @@ __ospf6_interface_update_neighbor_metric (struct ospf6_neighbor *on,
   if (update)
     {
       on->cost = newmetric;
+      nbrmetric->batch_changes++;
 
       if (on->state == OSPF6_NEIGHBOR_FULL ||
 	  (oi->type == OSPF6_IFTYPE_MDR && on->mdr.adv))
@@ -205,17 +212,59 @@ __ospf6_interface_update_neighbor_metric (struct ospf6_neighbor *on,
 			"router lsa", __func__, on->name, delta,
 			nbrmetric->metric_update_hysteresis);
 
-	  ospf6_router_lsa_schedule (oi->area);
+	  if (nbrmetric->batch)
+	    nbrmetric->batch_router_lsa = 1;
+	  else
+	    ospf6_router_lsa_schedule (oi->area);
 	}
 
       if (on->state == OSPF6_NEIGHBOR_FULL ||
 	  (oi->type == OSPF6_IFTYPE_MDR && on->state >= OSPF6_NEIGHBOR_TWOWAY))
-	ospf6_spf_schedule (oi->area);
+	{
+	  if (nbrmetric->batch)
+	    nbrmetric->batch_spf = 1;
+	  else
+	    ospf6_spf_schedule (oi->area);
+	}
     }
 
   return 0;
 }
 
+void
+ospf6_interface_neighbor_metric_batch_start (struct ospf6_interface *oi)
+{
+  struct ospf6_interface_neighbor_metric *nbrmetric;
+
+  nbrmetric = ospf6_get_interface_data (oi, neighbor_metric_data_id);
+  if (nbrmetric == NULL)
+    return;
+
+  nbrmetric->batch = 1;
+  nbrmetric->batch_router_lsa = 0;
+  nbrmetric->batch_spf = 0;
+  nbrmetric->batch_changes = 0;
+}
+
+unsigned int
+ospf6_interface_neighbor_metric_batch_end (struct ospf6_interface *oi)
+{
+  struct ospf6_interface_neighbor_metric *nbrmetric;
+
+  nbrmetric = ospf6_get_interface_data (oi, neighbor_metric_data_id);
+  if (nbrmetric == NULL || !nbrmetric->batch)
+    return 0;
+
+  nbrmetric->batch = 0;
+
+  if (nbrmetric->batch_router_lsa)
+    ospf6_router_lsa_schedule (oi->area);
+  if (nbrmetric->batch_spf)
+    ospf6_spf_schedule (oi->area);
+
+  return nbrmetric->batch_changes;
+}
+
 int
 ospf6_interface_update_neighbor_metric (struct ospf6_neighbor *on,
 					u_int16_t newmetric, unsigned int id)
@@ -167,6 +167,32 @@ int
 ospf6_interface_update_neighbor_metric (struct ospf6_neighbor *on,
 					u_int16_t newmetric, unsigned int id);
 
+/**
+ * Start applying a batch of neighbor cost updates
+ *
+ * Until ospf6_interface_neighbor_metric_batch_end() is called, cost
+ * changes on the interface only note that a router-LSA origination
+ * or SPF calculation is needed.
+ *
+ * @param oi The ospf interface.
+ */
+void
+ospf6_interface_neighbor_metric_batch_start (struct ospf6_interface *oi);
+
+/**
+ * Finish applying a batch of neighbor cost updates
+ *
+ * Schedule the router-LSA origination and SPF calculation needed by
+ * the cost changes made since
+ * ospf6_interface_neighbor_metric_batch_start(), once each.
+ *
+ * @param oi The ospf interface.
+ *
+ * @return The number of neighbor cost changes in the batch.
+ */
+unsigned int
+ospf6_interface_neighbor_metric_batch_end (struct ospf6_interface *oi);
+
 /**
  * Reset the cost metric of all neighbors
  *
@@ -49,6 +49,7 @@
 #include "ospf6_mdr.h"
 #include "ospf6_af.h"
 #include "ospf6_flood.h"
+#include "ospf6_zebra_linkmetrics.h"
 
 #define LSA_SCHEDULE_DELAY_MSEC 100
 
@@ -349,6 +350,8 @@ ospf6_router_lsa_originate (struct thread *thread)
       ospf6_lsa_purge (lsa);
     }
 
+  ospf6_linkmetrics_stage_done (OSPF6_LINKMETRICS_STAGE_ROUTER_LSA);
+
   return 0;
 }
 
@@ -1606,7 +1609,8 @@ ospf6_intra_prefix_lsa_remove (struct ospf6_lsa *lsa)
 }
 
 static void
-__ospf6_intra_process_route_table (struct ospf6_route_table *route_table)
+__ospf6_intra_process_route_table (struct ospf6_route_table *route_table,
+				   struct ospf6_route_churn *churn)
 {
   int pass, numpass = 2;
 
@@ -1630,6 +1634,8 @@ __ospf6_intra_process_route_table (struct ospf6_route_table *route_table)
 	      /* remove route */
 	      ospf6_route_remove (route, route_table);
 	      UNSET_FLAG (route->flag, OSPF6_ROUTE_REMOVE);
+	      if (churn)
+		churn->removed++;
 	    }
 	  else if (CHECK_FLAG (route->flag, OSPF6_ROUTE_ADD) ||
 		   CHECK_FLAG (route->flag, OSPF6_ROUTE_CHANGE))
@@ -1690,6 +1696,13 @@ __ospf6_intra_process_route_table (struct ospf6_route_table *route_table)
 
 	      if (routablenexthop)
 		{
+		  if (churn)
+		    {
+		      if (CHECK_FLAG (route->flag, OSPF6_ROUTE_CHANGE))
+			churn->changed++;
+		      else
+			churn->added++;
+		    }
 		  if (route_table->hook_add)
 		    (*route_table->hook_add) (route);
 		  UNSET_FLAG (route->flag, OSPF6_ROUTE_ADD);
@@ -1731,6 +1744,8 @@ __ospf6_intra_process_route_table (struct ospf6_route_table *route_table)
 		  if (pass == numpass - 1)
 		    {
 		      ospf6_route_remove (route, route_table);
+		      if (churn)
+			churn->removed++;
 		      UNSET_FLAG (route->flag, OSPF6_ROUTE_ADD);
 		      UNSET_FLAG (route->flag, OSPF6_ROUTE_CHANGE);
 		    }
@@ -1785,7 +1800,7 @@ ospf6_intra_prefix_lsa_replace (struct ospf6_lsa *old, struct ospf6_lsa *new)
   oa->route_table->hook_remove = hook_remove;
 
   if (numchange > 0)
-    __ospf6_intra_process_route_table (oa->route_table);
+    __ospf6_intra_process_route_table (oa->route_table, NULL);
 }
 
 /**
@@ -1797,12 +1812,18 @@ ospf6_intra_prefix_lsa_replace (struct ospf6_lsa *old, struct ospf6_lsa *new)
  * appropriate interface as the nexthop.
  *
  * @param oa The area to consider.
+ * @param numold The number of connected routes marked for removal
+ * beforehand.
+ *
+ * @return Nonzero if the set of connected routes changed.
  */
-static void
-ospf6_intra_route_calculation_connected (struct ospf6_area *oa)
+static int
+ospf6_intra_route_calculation_connected (struct ospf6_area *oa,
+					 unsigned int numold)
 {
   struct listnode *node;
   struct ospf6_interface *oi;
+  unsigned int numnew = 0, numsame = 0;
 
   for (ALL_LIST_ELEMENTS_RO (oa->if_list, node, oi))
     {
@@ -1825,7 +1846,7 @@ ospf6_intra_route_calculation_connected (struct ospf6_area *oa)
       for (route = ospf6_route_head (oi->route_connected); route;
 	   route = ospf6_route_next (route))
 	{
-	  struct ospf6_route *copy;
+	  struct ospf6_route *copy, *existing;
 
 	  if (ospf6_af_validate_prefix (oa->ospf6, &route->prefix.u.prefix6,
 					route->prefix.prefixlen, false))
@@ -1844,6 +1865,12 @@ ospf6_intra_route_calculation_connected (struct ospf6_area *oa)
 	  copy = ospf6_route_copy (route);
 	  apply_mask (&copy->prefix);
 
+	  existing = ospf6_route_lookup_identical (copy, oa->route_table);
+	  if (existing == NULL)
+	    numnew++;
+	  else if (!CHECK_FLAG (existing->flag, OSPF6_ROUTE_ADD))
+	    numsame++;
+
 	  if (IS_OSPF6_DEBUG_EXAMIN (INTRA_PREFIX))
 	    {
 	      char buf[PREFIXSTRLEN];
@@ -1855,6 +1882,8 @@ ospf6_intra_route_calculation_connected (struct ospf6_area *oa)
 	  ospf6_route_add (copy, oa->route_table);
 	}
     }
+
+  return numnew != 0 || numsame != numold;
 }
 
 /**
@@ -1954,17 +1983,104 @@ ospf6_intra_route_calculation_link (struct ospf6_area *oa)
     }
 }
 
+/* Routes not derived from another router's Intra-Area-Prefix-LSA:
+   connected, link-local and self-originated prefixes. */
+#define OSPF6_INTRA_ROUTE_IS_LOCAL(oa, route)                             \
+  ((route)->path.origin.type != htons (OSPF6_LSTYPE_INTRA_PREFIX) ||      \
+   (route)->path.origin.adv_router == (oa)->ospf6->router_id)
+
+static void
+ospf6_intra_route_mark_remove (struct ospf6_route *route)
+{
+  UNSET_FLAG (route->flag, OSPF6_ROUTE_ADD);
+  UNSET_FLAG (route->flag, OSPF6_ROUTE_CHANGE);
+  SET_FLAG (route->flag, OSPF6_ROUTE_REMOVE);
+}
+
+/* Re-examine the Intra-Area-Prefix-LSAs that reference a changed SPF
+   vertex.  Such LSAs are originated by the router the vertex belongs
+   to (for a transit network, its DR). */
+static unsigned int
+ospf6_intra_route_calculation_vertex (struct ospf6_area *oa,
+				      struct prefix *ls_prefix)
+{
+  u_int32_t adv_router, id;
+  u_int16_t type;
+  struct ospf6_lsa *lsa;
+  unsigned int numlsa = 0;
+
+  adv_router = ospf6_adv_router_in_prefix (ls_prefix);
+  id = ospf6_linkstate_prefix_id (ls_prefix);
+
+  /* routes advertised by this router are handled as connected routes */
+  if (adv_router == oa->ospf6->router_id)
+    return 0;
+
+  type = htons (OSPF6_LSTYPE_INTRA_PREFIX);
+  for (lsa = ospf6_lsdb_type_router_head (type, adv_router, oa->lsdb); lsa;
+       lsa = ospf6_lsdb_type_router_next (type, adv_router, lsa))
+    {
+      struct ospf6_intra_prefix_lsa *intra_prefix_lsa;
+
+      intra_prefix_lsa = (struct ospf6_intra_prefix_lsa *)
+	OSPF6_LSA_HEADER_END (lsa->header);
+      if (intra_prefix_lsa->ref_adv_router != adv_router)
+	continue;
+      if (intra_prefix_lsa->ref_type == htons (OSPF6_LSTYPE_ROUTER))
+	{
+	  if (id != htonl (0))
+	    continue;
+	}
+      else if (intra_prefix_lsa->ref_type == htons (OSPF6_LSTYPE_NETWORK))
+	{
+	  if (intra_prefix_lsa->ref_id != id)
+	    continue;
+	}
+      else
+	continue;
+
+      __ospf6_intra_prefix_lsa_remove (lsa, __ospf6_route_remove_mark);
+      __ospf6_intra_prefix_lsa_add (lsa);
+      numlsa++;
+    }
+
+  return numlsa;
+}
+
+/**
+ * Recalculate the intra-area routes of an area after SPF
+ *
+ * Connected and link-local routes are always re-examined.  If the
+ * set of SPF vertices whose path changed is known, only the
+ * Intra-Area-Prefix-LSAs anchored on those vertices are parsed
+ * again; changes to the LSAs themselves are applied as they arrive
+ * by ospf6_intra_prefix_lsa_add/remove/replace().  Otherwise, or
+ * when the connected prefixes changed (those mask LSA prefixes), all
+ * Intra-Area-Prefix-LSAs are re-examined.
+ *
+ * @param oa The area to consider.
+ * @param changed Linkstate prefixes of the changed SPF vertices, or
+ * NULL to recalculate everything.
+ */
 void
-ospf6_intra_route_calculation (struct ospf6_area *oa)
+ospf6_intra_route_calculation (struct ospf6_area *oa,
+			       struct route_table *changed)
 {
   struct ospf6_route *route;
   u_int16_t type;
   struct ospf6_lsa *lsa;
   void (*hook_add) (struct ospf6_route *) = NULL;
   void (*hook_remove) (struct ospf6_route *) = NULL;
+  struct ospf6_route_churn churn = {0, 0, 0};
+  unsigned int numconnected = 0, numvertices = 0, numlsas = 0;
+  int full;
+
+  full = (changed == NULL ||
+	  (oa->intra_full_calc == 0 && oa->intra_partial_calc == 0));
 
   if (IS_OSPF6_DEBUG_EXAMIN (INTRA_PREFIX))
-    zlog_debug ("Re-examin intra-routes for area %s", oa->name);
+    zlog_debug ("Re-examin intra-routes for area %s (%s)", oa->name,
+		full ? "full" : "partial");
 
   hook_add = oa->route_table->hook_add;
   hook_remove = oa->route_table->hook_remove;
@@ -1974,36 +2090,81 @@ ospf6_intra_route_calculation (struct ospf6_area *oa)
   for (route = ospf6_route_head (oa->route_table); route;
        route = ospf6_route_next (route))
     {
-      UNSET_FLAG (route->flag, OSPF6_ROUTE_ADD);
-      UNSET_FLAG (route->flag, OSPF6_ROUTE_CHANGE);
-      SET_FLAG (route->flag, OSPF6_ROUTE_REMOVE);
+      if (!full && !OSPF6_INTRA_ROUTE_IS_LOCAL (oa, route))
+	continue;
+
+      ospf6_intra_route_mark_remove (route);
+      if (route->path.origin.type == 0)
+	numconnected++;
     }
 
   /* add routes for prefixes associated with all ospf interfaces */
-  ospf6_intra_route_calculation_connected (oa);
+  if (ospf6_intra_route_calculation_connected (oa, numconnected) && !full)
+    {
+      if (IS_OSPF6_DEBUG_EXAMIN (INTRA_PREFIX))
+	zlog_debug ("Connected prefixes changed, re-examin all "
+		    "intra-routes for area %s", oa->name);
+
+      full = 1;
+      for (route = ospf6_route_head (oa->route_table); route;
+	   route = ospf6_route_next (route))
+	if (!OSPF6_INTRA_ROUTE_IS_LOCAL (oa, route))
+	  ospf6_intra_route_mark_remove (route);
+    }
 
   /* add link local address routes */
   if (ospf6_af_is_ipv4 (oa->ospf6))
     ospf6_intra_route_calculation_link (oa);
 
-  type = htons (OSPF6_LSTYPE_INTRA_PREFIX);
-  for (lsa = ospf6_lsdb_type_head (type, oa->lsdb); lsa;
-       lsa = ospf6_lsdb_type_next (type, lsa))
+  if (full)
     {
-      /* routes advertised by this router were already added */
-      if (lsa->header->adv_router == oa->ospf6->router_id)
-	continue;
+      type = htons (OSPF6_LSTYPE_INTRA_PREFIX);
+      for (lsa = ospf6_lsdb_type_head (type, oa->lsdb); lsa;
+	   lsa = ospf6_lsdb_type_next (type, lsa))
+	{
+	  /* routes advertised by this router were already added */
+	  if (lsa->header->adv_router == oa->ospf6->router_id)
+	    continue;
 
-      ospf6_intra_prefix_lsa_add (lsa);
+	  __ospf6_intra_prefix_lsa_add (lsa);
+	  numlsas++;
+	}
+    }
+  else
+    {
+      struct route_node *rn;
+
+      for (rn = route_top (changed); rn; rn = route_next (rn))
+	{
+	  if (rn->info == NULL)
+	    continue;
+	  numvertices++;
+	  numlsas += ospf6_intra_route_calculation_vertex (oa, &rn->p);
+	}
     }
 
   oa->route_table->hook_add = hook_add;
   oa->route_table->hook_remove = hook_remove;
 
-  __ospf6_intra_process_route_table (oa->route_table);
+  __ospf6_intra_process_route_table (oa->route_table, &churn);
+
+  if (full)
+    oa->intra_full_calc++;
+  else
+    oa->intra_partial_calc++;
+  oa->intra_last_vertices = numvertices;
+  oa->intra_last_lsas = numlsas;
+  oa->intra_last_churn = churn;
+  oa->intra_total_churn.added += churn.added;
+  oa->intra_total_churn.changed += churn.changed;
+  oa->intra_total_churn.removed += churn.removed;
 
   if (IS_OSPF6_DEBUG_EXAMIN (INTRA_PREFIX))
-    zlog_debug ("Re-examin intra-routes for area %s: Done", oa->name);
+    zlog_debug ("Re-examin intra-routes for area %s: Done (%s, "
+		"%u vertices changed, %u LSAs examined, "
+		"%u added, %u changed, %u removed)", oa->name,
+		full ? "full" : "partial", numvertices, numlsas,
+		churn.added, churn.changed, churn.removed);
 }
 
 static void
@@ -172,7 +172,9 @@ extern void ospf6_intra_prefix_lsa_remove (struct ospf6_lsa *lsa);
 extern void ospf6_intra_prefix_lsa_replace (struct ospf6_lsa *old,
 					    struct ospf6_lsa *new);
 
-extern void ospf6_intra_route_calculation (struct ospf6_area *oa);
+struct route_table;
+extern void ospf6_intra_route_calculation (struct ospf6_area *oa,
+                                           struct route_table *changed);
 extern void ospf6_intra_brouter_calculation (struct ospf6_area *oa);
 
 extern void ospf6_intra_init (void);
@@ -29,6 +29,7 @@
 #include "command.h"
 #include "memory.h"
 #include "thread.h"
+#include "checksum.h"
 
 #include "ospf6_proto.h"
 #include "ospf6_lsa.h"
@@ -511,7 +512,7 @@ ospf6_lsa_create (struct ospf6_lsa_header *header)
   /* calculate birth of this lsa */
   ospf6_lsa_age_set (lsa);
 
-  lsa->backupWaitTimer = NULL;
+  lsa->backupwait = NULL;
 
   return lsa;
 }
@@ -699,47 +700,42 @@ ospf6_lsa_refresh (struct thread *thread)
 
 
 
-/* enhanced Fletcher checksum algorithm, RFC1008 7.2 */
-#define MODX                4102
-#define LSA_CHECKSUM_OFFSET   15
+/* The checksum covers the whole LSA except the LS age field. */
+static u_char *
+ospf6_lsa_checksum_area (struct ospf6_lsa_header *lsa_header,
+                         u_int16_t *len, u_int16_t *checksum_offset)
+{
+  u_char *buffer = (u_char *) &lsa_header->type;
+  int type_offset = buffer - (u_char *) &lsa_header->age; /* should be 2 */
+
+  *len = ntohs (lsa_header->length) - type_offset;
+
+  /* Offset from the "type" field, 14 rather than 16. */
+  *checksum_offset = (u_char *) &lsa_header->checksum - buffer;
+
+  return buffer;
+}
 
 unsigned short
 ospf6_lsa_checksum (struct ospf6_lsa_header *lsa_header)
 {
-  u_char *sp, *ep, *p, *q;
-  int c0 = 0, c1 = 0;
-  int x, y;
-  u_int16_t length;
-
-  lsa_header->checksum = 0;
-  length = ntohs (lsa_header->length) - 2;
-  sp = (u_char *) &lsa_header->type;
+  u_char *buffer;
+  u_int16_t len, checksum_offset;
 
-  for (ep = sp + length; sp < ep; sp = q)
-    {
-      q = sp + MODX;
-      if (q > ep)
-        q = ep;
-      for (p = sp; p < q; p++)
-        {
-          c0 += *p;
-          c1 += c0;
-        }
-      c0 %= 255;
-      c1 %= 255;
-    }
-
-  /* r = (c1 << 8) + c0; */
-  x = ((length - LSA_CHECKSUM_OFFSET) * c0 - c1) % 255;
-  if (x <= 0)
-    x += 255;
-  y = 510 - c0 - x;
-  if (y > 255)
-    y -= 255;
+  buffer = ospf6_lsa_checksum_area (lsa_header, &len, &checksum_offset);
+  return fletcher_checksum (buffer, len, checksum_offset);
+}
 
-  lsa_header->checksum = htons ((x << 8) + y);
+/* Describe a received LSA for fletcher_checksum_verify_batch(). */
+void
+ospf6_lsa_checksum_item (struct ospf6_lsa_header *lsa_header,
+                         struct fletcher_item *item)
+{
+  u_int16_t len;
 
-  return (lsa_header->checksum);
+  item->buf = ospf6_lsa_checksum_area (lsa_header, &len, &item->offset);
+  item->len = len;
+  item->valid = 0;
 }
 
 void
@@ -137,8 +137,7 @@ struct ospf6_lsa
   struct ospf6_lsa_header *header;
 
   struct timeval rxmt_time;     /* start of rxmt interval */
-  struct thread *backupWaitTimer;
-  struct list *backupwait_neighbor_list;
+  struct ospf6_backupwait *backupwait;  /* MDR backup wait, per interface */
 };
 
 #define OSPF6_LSA_HEADERONLY 0x01
@@ -256,6 +255,9 @@ extern int ospf6_lsa_expire (struct thread *);
 extern int ospf6_lsa_refresh (struct thread *);
 
 extern unsigned short ospf6_lsa_checksum (struct ospf6_lsa_header *);
+struct fletcher_item;
+extern void ospf6_lsa_checksum_item (struct ospf6_lsa_header *,
+                                     struct fletcher_item *);
 extern int ospf6_lsa_prohibited_duration (u_int16_t type, u_int32_t id,
                                           u_int32_t adv_router, void *scope);
 
@@ -327,6 +327,63 @@ ospf6_lsdb_lookup_next (u_int16_t type, u_int32_t id, u_int32_t adv_router,
   return (struct ospf6_lsa *) node->info;
 }
 
+/* Return the first LSA after the given key in LSDB order, whether or
+   not the key itself is in LSDB.  The LSA returned is not locked. */
+struct ospf6_lsa *
+ospf6_lsdb_lookup_after (u_int16_t type, u_int32_t id, u_int32_t adv_router,
+                         struct ospf6_lsdb *lsdb)
+{
+  struct route_node *node;
+  struct route_node *next = NULL;
+  struct prefix_ipv6 key;
+  unsigned int bit;
+  u_char i;
+
+  if (lsdb == NULL)
+    return NULL;
+
+  memset (&key, 0, sizeof (key));
+  ospf6_lsdb_set_key (&key, &type, sizeof (type));
+  ospf6_lsdb_set_key (&key, &adv_router, sizeof (adv_router));
+  ospf6_lsdb_set_key (&key, &id, sizeof (id));
+
+  /* Walk down towards the key, remembering the last subtree passed on
+     the right: its entries are the closest ones after the key. */
+  node = lsdb->table->top;
+  while (node)
+    {
+      if (! prefix_match (&node->p, (struct prefix *) &key))
+        {
+          /* The whole subtree sorts either before or after the key. */
+          for (i = 0; prefix_bit (&node->p.u.prefix, i) ==
+                      prefix_bit ((u_char *) &key.prefix, i); i++)
+            ;
+          if (prefix_bit (&node->p.u.prefix, i))
+            next = node;
+          break;
+        }
+      if (node->p.prefixlen >= key.prefixlen)
+        break;
+
+      bit = prefix_bit ((u_char *) &key.prefix, node->p.prefixlen);
+      if (bit == 0 && node->link[1])
+        next = node->link[1];
+      node = node->link[bit];
+    }
+
+  if (next == NULL)
+    return NULL;
+
+  route_lock_node (next);
+  while (next && next->info == NULL)
+    next = route_next (next);
+  if (next == NULL)
+    return NULL;
+
+  route_unlock_node (next);
+  return (struct ospf6_lsa *) next->info;
+}
+
 /* Iteration function */
 struct ospf6_lsa *
 ospf6_lsdb_head (struct ospf6_lsdb *lsdb)
@@ -478,12 +535,10 @@ ospf6_lsdb_remove_all (struct ospf6_lsdb *lsdb)
     ospf6_lsdb_remove (lsa, lsdb);
 }
 
+/* Function showing a single LSA at the given show level. */
 void
-ospf6_lsdb_show (struct vty *vty, int level,
-                 u_int16_t *type, u_int32_t *id, u_int32_t *adv_router,
-                 struct ospf6_lsdb *lsdb)
+(*ospf6_lsdb_show_func (int level)) (struct vty *, struct ospf6_lsa *)
 {
-  struct ospf6_lsa *lsa;
   void (*showfunc) (struct vty *, struct ospf6_lsa *) = NULL;
 
   if (level == OSPF6_LSDB_SHOW_LEVEL_NORMAL)
@@ -495,6 +550,19 @@ ospf6_lsdb_show (struct vty *vty, int level,
   else if (level == OSPF6_LSDB_SHOW_LEVEL_DUMP)
     showfunc = ospf6_lsa_show_dump;
 
+  return showfunc;
+}
+
+void
+ospf6_lsdb_show (struct vty *vty, int level,
+                 u_int16_t *type, u_int32_t *id, u_int32_t *adv_router,
+                 struct ospf6_lsdb *lsdb)
+{
+  struct ospf6_lsa *lsa;
+  void (*showfunc) (struct vty *, struct ospf6_lsa *);
+
+  showfunc = ospf6_lsdb_show_func (level);
+
   if (type && id && adv_router)
     {
       lsa = ospf6_lsdb_lookup (*type, *id, *adv_router, lsdb);
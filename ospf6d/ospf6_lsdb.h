@@ -69,6 +69,10 @@ extern struct ospf6_lsa *ospf6_lsdb_lookup (u_int16_t type, u_int32_t id,
 extern struct ospf6_lsa *ospf6_lsdb_lookup_next (u_int16_t type, u_int32_t id,
                                                  u_int32_t adv_router,
                                                  struct ospf6_lsdb *lsdb);
+extern struct ospf6_lsa *ospf6_lsdb_lookup_after (u_int16_t type,
+                                                  u_int32_t id,
+                                                  u_int32_t adv_router,
+                                                  struct ospf6_lsdb *lsdb);
 
 extern void ospf6_lsdb_add (struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb);
 extern void ospf6_lsdb_remove (struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb);
@@ -95,6 +99,8 @@ extern void ospf6_lsdb_remove_all (struct ospf6_lsdb *lsdb);
 #define OSPF6_LSDB_SHOW_LEVEL_INTERNAL 2
 #define OSPF6_LSDB_SHOW_LEVEL_DUMP     3
 
+extern void (*ospf6_lsdb_show_func (int level)) (struct vty *,
+                                                 struct ospf6_lsa *);
 extern void ospf6_lsdb_show (struct vty *vty, int level, u_int16_t *type,
                              u_int32_t *id, u_int32_t *adv_router,
                              struct ospf6_lsdb *lsdb);
@@ -25,6 +25,7 @@
 
 #include "log.h"
 #include "thread.h"
+#include "memory.h"
 
 #include "ospf6d.h"
 #include "ospf6_neighbor.h"
@@ -46,6 +47,8 @@ ospf6_flood_interface_mdr (struct ospf6_neighbor *from,
   int is_debug = 0;
   struct list *flood_neighbors = list_new ();
   bool flood_lsa = true;
+  ospf6_mdr_ack_bitmap acked;
+  bool any_acked;
 
   if (IS_OSPF6_DEBUG_FLOODING ||
       IS_OSPF6_DEBUG_FLOOD_TYPE (lsa->header->type))
@@ -54,6 +57,9 @@ ospf6_flood_interface_mdr (struct ospf6_neighbor *from,
       zlog_debug ("Flooding on %s: %s", oi->interface->name, lsa->name);
     }
 
+  /* neighbors that already sent a multicast ack for this LSA */
+  any_acked = ospf6_mdr_acked_neighbors (oi, lsa, acked);
+
   /* (1) For each neighbor */
   for (ALL_LIST_ELEMENTS (oi->neighbor_list, node, nnode, on))
     {
@@ -144,7 +150,7 @@ ospf6_flood_interface_mdr (struct ospf6_neighbor *from,
          i) check whether neighbor sent a multicast ACK for it already
          ii) whether I am an active relay for this originator */
       /* Has LSA been acked previously with multicast ack? */
-      if (ospf6_mdr_neighbor_has_acked (on, lsa))
+      if (any_acked && OSPF6_MDR_ACK_ISSET (acked, on))
         {                       //Don't add LSA to neighbor's retransmission list
           if (is_debug)
             zlog_debug ("Existing multicast ACK from neighbor %s found "
@@ -320,189 +326,361 @@ ospf6_mdr_acknowledge_lsa_allother (struct ospf6_lsa *lsa,
     }
 }
 
-static void
-ospf6_refresh_lsa_backupwait_list (struct ospf6_lsa *lsa)
+/* Backup-wait engine.  Each interface keeps the LSAs it is holding
+   back in time buckets of OSPF6_BACKUPWAIT_BUCKET_MSEC, ordered by
+   expiry, with a single timer for the earliest bucket.  An LSA has one
+   entry per interface, holding the neighbors still to be covered as a
+   bitmap of ack cache slots.  All entries of a bucket are handled in
+   one pass, which ends with a single LSUpdate for the interface. */
+struct ospf6_backupwait
 {
-  struct listnode *node, *nnode;
-  struct ospf6_neighbor *on;
+  struct ospf6_lsa *lsa;
   struct ospf6_interface *oi;
-  struct ospf6_backupwait_neighbor *obn;
+  struct ospf6_backupwait *next_lsa;    // other interfaces, same LSA
+  struct ospf6_backupwait_bucket *bucket;
+  struct ospf6_backupwait *prev, *next; // same bucket
+  ospf6_mdr_ack_bitmap neighbors;
+  u_int16_t untracked;                  // neighbors without a slot
+};
+
+struct ospf6_backupwait_bucket
+{
+  u_int64_t expire;                     // msec, monotonic
+  struct ospf6_backupwait *head;
+  struct ospf6_backupwait_bucket *prev, *next;
+};
+
+#define OSPF6_BACKUPWAIT_BUCKET_MSEC	10
+
+static u_int64_t
+ospf6_backupwait_now (void)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (u_int64_t) now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+static bool
+ospf6_backupwait_is_empty (struct ospf6_backupwait *bw)
+{
+  int i;
+
+  if (bw->untracked)
+    return false;
+  for (i = 0; i < OSPF6_MDR_ACK_WORDS; i++)
+    if (bw->neighbors[i])
+      return false;
+  return true;
+}
+
+static int ospf6_backupwait_expiration (struct thread *thread);
 
-  //The neighbor state of backupwait neighbors could have changed
-  //remove those backupwait neighbors in a state below EXCHANGE
+static void
+ospf6_backupwait_schedule (struct ospf6_interface *oi)
+{
+  u_int64_t now;
+  long msec;
 
-  if (!lsa->backupwait_neighbor_list)
+  THREAD_OFF (oi->mdr.thread_backupwait);
+  if (oi->mdr.backupwait_buckets == NULL)
     return;
 
-  for (ALL_LIST_ELEMENTS (lsa->backupwait_neighbor_list, node, nnode, obn))
-    {
-      oi = ospf6_interface_lookup_by_ifindex (obn->ifindex);
-      on = ospf6_neighbor_lookup (obn->router_id, oi);
-
-      //For SICDS, delete neighbors that are below TWOWAY.
-      if (!on || on->state < OSPF6_NEIGHBOR_TWOWAY)
-        {                       //backupwait neighbor fell below state TWOWAY
-          listnode_delete (lsa->backupwait_neighbor_list, obn);
-          free (obn);
-        }
-    }
-  //there are no backupwait neigbors left, cancel the backupwait timer
-  if (lsa->backupwait_neighbor_list->count == 0)
+  now = ospf6_backupwait_now ();
+  msec = 0;
+  if (oi->mdr.backupwait_buckets->expire > now)
+    msec = oi->mdr.backupwait_buckets->expire - now;
+  oi->mdr.thread_backupwait =
+    thread_add_timer_msec (master, ospf6_backupwait_expiration, oi, msec);
+}
+
+/* Put an entry in the bucket for its expiry time.  Expiry times are
+   mostly increasing, so the search starts from the latest bucket. */
+static void
+ospf6_backupwait_bucket_add (struct ospf6_interface *oi,
+			     struct ospf6_backupwait *bw, u_int64_t expire)
+{
+  struct ospf6_backupwait_bucket *bucket, *last;
+
+  expire += OSPF6_BACKUPWAIT_BUCKET_MSEC - 1;
+  expire -= expire % OSPF6_BACKUPWAIT_BUCKET_MSEC;
+
+  for (last = oi->mdr.backupwait_buckets; last && last->next;
+       last = last->next)
+    ;
+  for (bucket = last; bucket && bucket->expire > expire;
+       bucket = bucket->prev)
+    ;
+
+  if (bucket == NULL || bucket->expire != expire)
     {
-      ospf6_backupwait_lsa_delete (lsa);
+      struct ospf6_backupwait_bucket *new;
+
+      new = XCALLOC (MTYPE_OSPF6_MDR, sizeof (*new));
+      new->expire = expire;
+      new->prev = bucket;
+      if (bucket)
+	{
+	  new->next = bucket->next;
+	  bucket->next = new;
+	}
+      else
+	{
+	  new->next = oi->mdr.backupwait_buckets;
+	  oi->mdr.backupwait_buckets = new;
+	}
+      if (new->next)
+	new->next->prev = new;
+      bucket = new;
+
+      if (oi->mdr.backupwait_buckets == new)
+	ospf6_backupwait_schedule (oi);
     }
+
+  bw->bucket = bucket;
+  bw->prev = NULL;
+  bw->next = bucket->head;
+  if (bucket->head)
+    bucket->head->prev = bw;
+  bucket->head = bw;
 }
 
-static int
-ospf6_backupwait_expiration (struct thread *thread)
+static void
+ospf6_backupwait_bucket_remove (struct ospf6_backupwait *bw)
+{
+  struct ospf6_backupwait_bucket *bucket = bw->bucket;
+  struct ospf6_interface *oi = bw->oi;
+
+  if (bw->prev)
+    bw->prev->next = bw->next;
+  else
+    bucket->head = bw->next;
+  if (bw->next)
+    bw->next->prev = bw->prev;
+  bw->bucket = NULL;
+
+  if (bucket->head)
+    return;
+
+  if (bucket->prev)
+    bucket->prev->next = bucket->next;
+  else
+    oi->mdr.backupwait_buckets = bucket->next;
+  if (bucket->next)
+    bucket->next->prev = bucket->prev;
+  XFREE (MTYPE_OSPF6_MDR, bucket);
+
+  if (oi->mdr.backupwait_buckets == NULL)
+    THREAD_OFF (oi->mdr.thread_backupwait);
+}
+
+static void
+ospf6_backupwait_free (struct ospf6_backupwait *bw)
+{
+  struct ospf6_backupwait **prev;
+
+  for (prev = &bw->lsa->backupwait; *prev != bw; prev = &(*prev)->next_lsa)
+    ;
+  *prev = bw->next_lsa;
+
+  if (bw->bucket)
+    ospf6_backupwait_bucket_remove (bw);
+  bw->oi->mdr.backupwait_count--;
+  XFREE (MTYPE_OSPF6_MDR, bw);
+}
+
+static struct ospf6_backupwait *
+ospf6_backupwait_lookup (struct ospf6_lsa *lsa, struct ospf6_interface *oi)
 {
-  struct ospf6_lsa *lsa = (struct ospf6_lsa *) THREAD_ARG (thread);
-  struct listnode *node, *nnode, *i;
-  struct list *eligible_interfaces;
-  struct ospf6_backupwait_neighbor *obn;
+  struct ospf6_backupwait *bw;
+
+  for (bw = lsa->backupwait; bw; bw = bw->next_lsa)
+    if (bw->oi == oi)
+      return bw;
+  return NULL;
+}
+
+/* BackupWait Timer Expiration, RFC 5614 8.1.2.1 */
+static void
+ospf6_backupwait_flood (struct ospf6_lsa *lsa, struct ospf6_interface *oi)
+{
+  struct listnode *node;
   struct ospf6_neighbor *on;
-  struct ospf6_interface *oi;
   struct ospf6_lsa *rxmt_lsa;
   struct ospf6_lsa *ack_lsa;
 
-  lsa->backupWaitTimer = NULL;
-  ospf6_refresh_lsa_backupwait_list (lsa);
-  if (!lsa->backupwait_neighbor_list)
-    return 0;
+  if (IS_OSPF6_DEBUG_FLOODING)
+    zlog_info ("  Add copy of %s to lsupdate_list of %s",
+	       lsa->name, oi->interface->name);
 
-  eligible_interfaces = list_new ();
-  for (ALL_LIST_ELEMENTS (lsa->backupwait_neighbor_list, node, nnode, obn))
+  //BackupWait Timer Expiration 8.1.2.1.b
+  //if LSA is on ack list, this will count as an implict ack
+  //remove LSA from ack list (MANET always on interface ack list)
+  ack_lsa = ospf6_lsdb_lookup (lsa->header->type, lsa->header->id,
+			       lsa->header->adv_router, oi->lsack_list);
+  if (ack_lsa)
+    ospf6_lsdb_remove (ack_lsa, oi->lsack_list);
+
+  //BackupWait Timer Expiration 8.1.2.1.c
+  for (ALL_LIST_ELEMENTS_RO (oi->neighbor_list, node, on))
     {
-      //neighbor should exist because backupwait list was just refreshed
-      oi = ospf6_interface_lookup_by_ifindex (obn->ifindex);
-      on = ospf6_neighbor_lookup (obn->router_id, oi);
-      assert (on);
-      if (!listnode_lookup (eligible_interfaces, oi))
-        listnode_add (eligible_interfaces, oi);
-
-      //BackupWait Timer Expiration 8.1.2.2
-      ospf6_backupwait_lsa_neighbor_delete (lsa, on);
+      // Reset rxmt time if LSA is in retrans list.
+      rxmt_lsa = ospf6_lsdb_lookup (lsa->header->type, lsa->header->id,
+				    lsa->header->adv_router, on->retrans_list);
+      if (rxmt_lsa)
+	quagga_gettime (QUAGGA_CLK_MONOTONIC, &rxmt_lsa->rxmt_time);
     }
 
-  for (ALL_LIST_ELEMENTS_RO (eligible_interfaces, i, oi))
+  //BackupWait Timer Expiration 8.1.2.1.a
+  ospf6_lsdb_add (ospf6_lsa_copy (lsa), oi->lsupdate_list);
+}
+
+static int
+ospf6_backupwait_expiration (struct thread *thread)
+{
+  struct ospf6_interface *oi = THREAD_ARG (thread);
+  struct ospf6_backupwait_bucket *bucket;
+  struct ospf6_backupwait *bw;
+  struct ospf6_neighbor *on;
+  struct listnode *node;
+  ospf6_mdr_ack_bitmap twoway;
+  u_int64_t now;
+  unsigned int flooded = 0;
+  int i;
+
+  oi->mdr.thread_backupwait = NULL;
+
+  //Only neighbors still at least TWOWAY need to be covered.
+  memset (twoway, 0, sizeof (twoway));
+  for (ALL_LIST_ELEMENTS_RO (oi->neighbor_list, node, on))
+    if (on->state >= OSPF6_NEIGHBOR_TWOWAY && on->mdr.ack_slot >= 0)
+      twoway[on->mdr.ack_slot / 32] |= 1U << (on->mdr.ack_slot % 32);
+
+  now = ospf6_backupwait_now ();
+  // freeing the last entry of a bucket also frees the bucket
+  while ((bucket = oi->mdr.backupwait_buckets) != NULL &&
+	 bucket->expire <= now)
     {
-      if (IS_OSPF6_DEBUG_FLOODING)
-        zlog_info ("  Add copy of %s to lsupdate_list of %s",
-                   lsa->name, oi->interface->name);
-
-      //BackupWait Timer Expiration 8.1.2.1.b
-      //if LSA is on ack list, this will count as an implict ack
-      //remove LSA from ack list (MANET always on interface ack list)
-      ack_lsa =
-        ospf6_lsdb_lookup (lsa->header->type, lsa->header->id,
-                           lsa->header->adv_router, oi->lsack_list);
-      if (ack_lsa)
-        ospf6_lsdb_remove (ack_lsa, oi->lsack_list);
-
-      //BackupWait Timer Expiration 8.1.2.1.c
-      for (ALL_LIST_ELEMENTS_RO (oi->neighbor_list, node, on))
-        {
-          // Reset rxmt time if LSA is in retrans list.
-          rxmt_lsa =
-            ospf6_lsdb_lookup (lsa->header->type, lsa->header->id,
-                               lsa->header->adv_router, on->retrans_list);
-          if (rxmt_lsa)
-	    quagga_gettime (QUAGGA_CLK_MONOTONIC, &rxmt_lsa->rxmt_time);
+      bw = bucket->head;
+      for (i = 0; i < OSPF6_MDR_ACK_WORDS; i++)
+	bw->neighbors[i] &= twoway[i];
+      if (!ospf6_backupwait_is_empty (bw))
+	{
+	  ospf6_backupwait_flood (bw->lsa, oi);
+	  flooded++;
 	}
+      ospf6_backupwait_free (bw);
+    }
 
-      //BackupWait Timer Expiration 8.1.2.1.a
-      ospf6_lsdb_add (ospf6_lsa_copy (lsa), oi->lsupdate_list);
+  if (flooded)
+    {
+      if (IS_OSPF6_DEBUG_FLOODING)
+	zlog_debug ("Backup wait expired for %u LSAs on %s",
+		    flooded, oi->interface->name);
       //XXX BOEING LSAs after this are gone from the perspective of backupwait
       //with delay equal to 1msec no coalescing takes place
       //with a higher delay backupWaitInterval is effectively increased
       oi->thread_send_lsupdate =
-        ospf6_send_lsupdate_delayed_msec (master,
-                                          ospf6_lsupdate_send_interface, oi,
-                                          1, oi->thread_send_lsupdate);
+	ospf6_send_lsupdate_delayed_msec (master,
+					  ospf6_lsupdate_send_interface, oi,
+					  1, oi->thread_send_lsupdate);
     }
-  list_delete (eligible_interfaces);
+
+  ospf6_backupwait_schedule (oi);
   return 0;
 }
 
 void
 ospf6_backupwait_lsa_add (struct ospf6_lsa *lsa, struct ospf6_neighbor *on)
 {
-  struct listnode *n;
-  struct ospf6_backupwait_neighbor *obn = NULL;
+  struct ospf6_interface *oi = on->ospf6_if;
+  struct ospf6_backupwait *bw;
+  int slot = on->mdr.ack_slot;
 
-  if (on->ospf6_if->type != OSPF6_IFTYPE_MDR)
+  if (oi->type != OSPF6_IFTYPE_MDR)
     return;
 
-  ospf6_refresh_lsa_backupwait_list (lsa);
-
-  //create the backupwait list and schedule expiration
-  if (lsa->backupWaitTimer == NULL)
+  //create the backupwait entry and schedule expiration
+  bw = ospf6_backupwait_lookup (lsa, oi);
+  if (bw == NULL)
     {
       unsigned int msec;
 
-      msec = on->ospf6_if->mdr.BackupWaitInterval +
-	ospf6_random (on->ospf6_if->mdr.BackupWaitInterval);
-
-      lsa->backupWaitTimer =
-        thread_add_timer_msec (master, ospf6_backupwait_expiration, lsa, msec);
-      lsa->backupwait_neighbor_list = list_new ();
-    }
+      msec = oi->mdr.BackupWaitInterval +
+	ospf6_random (oi->mdr.BackupWaitInterval);
 
-  //Is this neighbor already on the push back list?
-  for (ALL_LIST_ELEMENTS_RO (lsa->backupwait_neighbor_list, n, obn))
-    {
-      if (on->router_id == obn->router_id &&
-          on->ospf6_if->interface->ifindex == obn->ifindex)
-        return;                 //already in the list
+      bw = XCALLOC (MTYPE_OSPF6_MDR, sizeof (struct ospf6_backupwait));
+      bw->lsa = lsa;
+      bw->oi = oi;
+      bw->next_lsa = lsa->backupwait;
+      lsa->backupwait = bw;
+      oi->mdr.backupwait_count++;
+      ospf6_backupwait_bucket_add (oi, bw, ospf6_backupwait_now () + msec);
     }
 
   //put the backupwait neighbor on the backupwait list
-  obn = (struct ospf6_backupwait_neighbor *)
-    malloc (sizeof (struct ospf6_backupwait_neighbor));
-  obn->router_id = on->router_id;
-  obn->ifindex = on->ospf6_if->interface->ifindex;
-  listnode_add (lsa->backupwait_neighbor_list, obn);
+  if (slot >= 0)
+    bw->neighbors[slot / 32] |= 1U << (slot % 32);
+  else
+    bw->untracked = 1;
 }
 
 void
 ospf6_backupwait_lsa_neighbor_delete (struct ospf6_lsa *lsa,
                                       struct ospf6_neighbor *on)
 {
-  struct listnode *node, *nnode;
-  struct ospf6_backupwait_neighbor *obn;
+  struct ospf6_backupwait *bw;
+  int slot = on->mdr.ack_slot;
 
-  //Find backupwait neighbor, if found remove
-  for (ALL_LIST_ELEMENTS (lsa->backupwait_neighbor_list, node, nnode, obn))
-    {
-      if (on->router_id == obn->router_id &&
-          on->ospf6_if->interface->ifindex == obn->ifindex)
-        {
-          listnode_delete (lsa->backupwait_neighbor_list, obn);
-          free (obn);
-          break;
-        }
-    }
-  //clean out old neighbors and cancel backupwait thread if backupwait
-  //no more backupwait neighbors
-  ospf6_refresh_lsa_backupwait_list (lsa);
+  bw = ospf6_backupwait_lookup (lsa, on->ospf6_if);
+  if (bw == NULL || slot < 0)
+    return;
+
+  bw->neighbors[slot / 32] &= ~(1U << (slot % 32));
+  //cancel backupwait if there are no more backupwait neighbors
+  if (ospf6_backupwait_is_empty (bw))
+    ospf6_backupwait_free (bw);
 }
 
+/* The neighbor fell below TWOWAY or is going away: it no longer needs
+   to be covered by any LSA held back on its interface. */
 void
-ospf6_backupwait_lsa_delete (struct ospf6_lsa *lsa)
+ospf6_backupwait_neighbor_clear (struct ospf6_neighbor *on)
 {
-  struct listnode *node, *nnode;
-  struct ospf6_backupwait_neighbor *obn;
+  struct ospf6_backupwait_bucket *bucket, *next_bucket;
+  struct ospf6_backupwait *bw, *next;
+  int slot = on->mdr.ack_slot;
 
-  //cancel backupwait thread
-  THREAD_OFF (lsa->backupWaitTimer);
-  lsa->backupWaitTimer = NULL;
+  if (slot < 0)
+    return;
 
-  //clean up backupwait neighbor list
-  if (lsa->backupwait_neighbor_list)
+  for (bucket = on->ospf6_if->mdr.backupwait_buckets; bucket;
+       bucket = next_bucket)
     {
-      for (ALL_LIST_ELEMENTS (lsa->backupwait_neighbor_list, node, nnode, obn))
-        free (obn);
-      list_delete (lsa->backupwait_neighbor_list);
-      lsa->backupwait_neighbor_list = NULL;
+      next_bucket = bucket->next;
+      for (bw = bucket->head; bw; bw = next)
+	{
+	  next = bw->next;
+	  bw->neighbors[slot / 32] &= ~(1U << (slot % 32));
+	  if (ospf6_backupwait_is_empty (bw))
+	    ospf6_backupwait_free (bw);
+	}
     }
 }
+
+void
+ospf6_backupwait_interface_clear (struct ospf6_interface *oi)
+{
+  struct ospf6_backupwait_bucket *bucket;
+
+  while ((bucket = oi->mdr.backupwait_buckets) != NULL)
+    ospf6_backupwait_free (bucket->head);
+  assert (oi->mdr.backupwait_count == 0);
+}
+
+void
+ospf6_backupwait_lsa_delete (struct ospf6_lsa *lsa)
+{
+  while (lsa->backupwait)
+    ospf6_backupwait_free (lsa->backupwait);
+}
@@ -24,15 +24,6 @@
 #ifndef OSPF6_MDR_FLOOD_H
 #define OSPF6_MDR_FLOOD_H
 
-struct ospf6_backupwait_neighbor
-{
-  /* Neighbor Router ID */
-  u_int32_t router_id;
-
-  /* Neighbor Interface ID */
-  u_int32_t ifindex;
-};
-
 struct ospf6_neighbor;
 struct ospf6_lsa;
 struct ospf6_interface;
@@ -48,5 +39,7 @@ extern void ospf6_backupwait_lsa_add (struct ospf6_lsa *lsa,
 extern void ospf6_backupwait_lsa_neighbor_delete (struct ospf6_lsa *lsa,
 						  struct ospf6_neighbor *on);
 extern void ospf6_backupwait_lsa_delete (struct ospf6_lsa *lsa);
+extern void ospf6_backupwait_neighbor_clear (struct ospf6_neighbor *on);
+extern void ospf6_backupwait_interface_clear (struct ospf6_interface *oi);
 
 #endif	/* OSPF6_MDR_FLOOD_H */
@@ -34,6 +34,7 @@
 #include "ospf6_lsdb.h"
 #include "ospf6_flood.h"
 #include "ospf6_mdr_interface.h"
+#include "ospf6_mdr_flood.h"
 
 void
 ospf6_mdr_interface_create (struct ospf6_interface *oi)
@@ -51,6 +52,8 @@ ospf6_mdr_interface_create (struct ospf6_interface *oi)
   oi->mdr.MDRConstraint = 3;        // constraint h for MPN, should be 2 or 3.
   oi->mdr.consec_hello_threshold = 1;
 
+  ospf6_mdr_ack_cache_create (oi);
+
   oi->mdr.lnl = list_new ();
   oi->mdr.hsn = 0;
   oi->mdr.full_hello_count = 0;
@@ -86,6 +89,9 @@ ospf6_mdr_interface_delete (struct ospf6_interface *oi)
   struct ospf6_lnl_element *lnl_element;
   struct listnode *node, *nnode;
 
+  ospf6_backupwait_interface_clear (oi);
+  ospf6_mdr_ack_cache_delete (oi);
+
   if (!oi->mdr.lnl)
     return;
 
@@ -119,6 +125,9 @@ ospf6_mdr_interface_show (struct vty *vty, struct ospf6_interface *oi)
       break;
     }
   vty_out (vty, "    Router is an %s router%s", type, VTY_NEWLINE);
+  ospf6_mdr_ack_cache_show (vty, oi);
+  vty_out (vty, "    Backup wait: %u LSAs pending%s",
+	   oi->mdr.backupwait_count, VNL);
 
   if (oi->mdr.parent)
     {
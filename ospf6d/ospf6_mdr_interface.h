@@ -53,12 +53,19 @@ typedef enum
   OSPF6_LSA_FULLNESS_FULL       //full LSAs (all routable neighbors)
 } ospf6_LSAFullness;
 
+struct ospf6_mdr_ack_cache;
+struct ospf6_backupwait_bucket;
+
 struct ospf6_mdr_interface
 {
   long ackInterval;
   int ack_cache_timeout;
+  struct ospf6_mdr_ack_cache *ack_cache;
   bool nonflooding_mdr;
   long BackupWaitInterval;
+  struct ospf6_backupwait_bucket *backupwait_buckets;
+  struct thread *thread_backupwait;
+  unsigned int backupwait_count;
   int **cost_matrix;
   int **adj_matrix;             // RGO2. Indicates which nbr pairs are adjacent
   int **san_matrix;             // RGO2. Selected advertised nbr matrix
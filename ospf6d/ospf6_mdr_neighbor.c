@@ -25,6 +25,9 @@
 
 #include "command.h"
 #include "memory.h"
+#include "hash.h"
+#include "jhash.h"
+#include "thread.h"
 
 #include "ospf6d.h"
 #include "ospf6_af.h"
@@ -35,6 +38,10 @@
 #include "ospf6_lsdb.h"
 #include "ospf6_mdr.h"
 #include "ospf6_mdr_neighbor.h"
+#include "ospf6_mdr_flood.h"
+
+static void ospf6_mdr_ack_slot_alloc (struct ospf6_neighbor *on);
+static void ospf6_mdr_ack_slot_free (struct ospf6_neighbor *on);
 
 static struct ospf6_lnl_element *
 ospf6_mdr_lookup_lnl_element (struct ospf6_neighbor *on)
@@ -70,7 +77,7 @@ ospf6_mdr_neighbor_create (struct ospf6_neighbor *on)
   on->mdr.list_type = 0;
   on->mdr.consec_hellos = 0;
 
-  on->mdr.ack_list = ospf6_lsdb_create (on);
+  ospf6_mdr_ack_slot_alloc (on);
 }
 
 static void
@@ -117,9 +124,8 @@ ospf6_mdr_neighbor_delete (struct ospf6_neighbor *on)
   ospf6_mdr_delete_neighbor_list (on->mdr.dnl);
   ospf6_mdr_delete_neighbor_list (on->mdr.sanl);
 
-  THREAD_OFF (on->mdr.thread_ack_list_expire);
-  ospf6_lsdb_remove_all (on->mdr.ack_list);
-  ospf6_lsdb_delete (on->mdr.ack_list);
+  ospf6_backupwait_neighbor_clear (on);
+  ospf6_mdr_ack_slot_free (on);
 }
 
 void
@@ -133,6 +139,7 @@ ospf6_mdr_neighbor_state_change (struct ospf6_neighbor *on,
   if (prev_state >= OSPF6_NEIGHBOR_TWOWAY &&
       next_state < OSPF6_NEIGHBOR_TWOWAY)
     {
+      ospf6_backupwait_neighbor_clear (on);
       ospf6_calculate_mdr (oi);
       ospf6_update_adjacencies (oi);
       ospf6_mdr_update_lsa (oi);
@@ -337,90 +344,374 @@ ospf6_mdr_neighbor_init (void)
   install_element (VIEW_NODE, &show_ipv6_ospf6_neighbor_mdr_cmd);
 }
 
-static struct ospf6_lsa *
-ospf6_mdr_neighbor_lookup_ack (struct ospf6_neighbor *on,
-			       struct ospf6_lsa *lsa)
+/* Ack cache: every LSA acked by a neighbor has an entry in the
+   interface hash, with one record per acked instance holding a bitmap
+   of neighbor slots.  A neighbor keeps only its most recent ack per
+   LSA.  Each ack also goes on a ring in receive order, so expiring
+   the oldest acks never needs to look at the rest of the cache. */
+struct ospf6_mdr_ack_lsa
+{
+  u_int16_t type;
+  u_int32_t id;
+  u_int32_t adv_router;
+  struct ospf6_mdr_ack *instances;
+};
+
+struct ospf6_mdr_ack
+{
+  struct ospf6_mdr_ack *next;
+  struct ospf6_mdr_ack_lsa *lsa;
+  u_int32_t seqnum;
+  u_int16_t checksum;
+  u_char maxage;
+  unsigned int refcnt;          // ring records pointing here
+  ospf6_mdr_ack_bitmap acked;
+};
+
+struct ospf6_mdr_ack_record
 {
-  return ospf6_lsdb_lookup (lsa->header->type, lsa->header->id,
-			    lsa->header->adv_router, on->mdr.ack_list);
+  struct ospf6_mdr_ack *ack;
+  int slot;                     // -1 once the neighbor is gone
+  struct timeval received;
+};
+
+struct ospf6_mdr_ack_cache
+{
+  struct ospf6_interface *oi;
+  struct hash *lsas;
+  ospf6_mdr_ack_bitmap slots;   // neighbor slots in use
+
+  struct ospf6_mdr_ack_record *ring;
+  unsigned int ring_size;
+  unsigned int ring_head;
+  unsigned int ring_count;
+  struct thread *thread_expire;
+
+  unsigned int instances;
+};
+
+#define OSPF6_MDR_ACK_RING_MIN		64
+#define OSPF6_MDR_ACK_RING(cache, i) \
+  ((cache)->ring[((cache)->ring_head + (i)) % (cache)->ring_size])
+
+static unsigned int
+ospf6_mdr_ack_lsa_hash (void *p)
+{
+  struct ospf6_mdr_ack_lsa *entry = p;
+
+  return jhash_3words (entry->type, entry->id, entry->adv_router, 0);
 }
 
 static int
-ospf6_mdr_neighbor_ack_list_expire (struct thread *thread)
+ospf6_mdr_ack_lsa_cmp (const void *p1, const void *p2)
 {
-  struct ospf6_neighbor *on;
+  const struct ospf6_mdr_ack_lsa *a = p1, *b = p2;
+
+  return (a->type == b->type && a->id == b->id &&
+	  a->adv_router == b->adv_router);
+}
+
+static void *
+ospf6_mdr_ack_lsa_alloc (void *p)
+{
+  struct ospf6_mdr_ack_lsa *key = p, *entry;
+
+  entry = XCALLOC (MTYPE_OSPF6_MDR, sizeof (struct ospf6_mdr_ack_lsa));
+  entry->type = key->type;
+  entry->id = key->id;
+  entry->adv_router = key->adv_router;
+  return entry;
+}
+
+static struct ospf6_mdr_ack_lsa *
+ospf6_mdr_ack_lsa_lookup (struct ospf6_mdr_ack_cache *cache,
+			  struct ospf6_lsa *lsa, bool create)
+{
+  struct ospf6_mdr_ack_lsa key;
+
+  key.type = lsa->header->type;
+  key.id = lsa->header->id;
+  key.adv_router = lsa->header->adv_router;
+  if (create)
+    return hash_get (cache->lsas, &key, ospf6_mdr_ack_lsa_alloc);
+  return hash_lookup (cache->lsas, &key);
+}
+
+/* Same sense as ospf6_lsa_compare(): negative if the acked instance
+   is more recent than the LSA.  Acks are not kept long enough for the
+   MaxAgeDiff rule to matter. */
+static int
+ospf6_mdr_ack_compare (struct ospf6_mdr_ack *ack, struct ospf6_lsa *lsa)
+{
+  int seqnum = (int) ntohl (lsa->header->seqnum);
+  u_int16_t checksum = ntohs (lsa->header->checksum);
+  u_char maxage = (ospf6_lsa_age_current (lsa) == MAXAGE);
+
+  if ((int) ack->seqnum != seqnum)
+    return (int) ack->seqnum > seqnum ? -1 : 1;
+  if (ack->checksum != checksum)
+    return ack->checksum > checksum ? -1 : 1;
+  if (ack->maxage != maxage)
+    return ack->maxage ? -1 : 1;
+  return 0;
+}
+
+static void
+ospf6_mdr_ack_unref (struct ospf6_mdr_ack_cache *cache,
+		     struct ospf6_mdr_ack *ack)
+{
+  struct ospf6_mdr_ack_lsa *entry = ack->lsa;
+  struct ospf6_mdr_ack **prev;
+
+  assert (ack->refcnt > 0);
+  if (--ack->refcnt > 0)
+    return;
+
+  for (prev = &entry->instances; *prev != ack; prev = &(*prev)->next)
+    ;
+  *prev = ack->next;
+  XFREE (MTYPE_OSPF6_MDR, ack);
+  cache->instances--;
+
+  if (entry->instances == NULL)
+    {
+      hash_release (cache->lsas, entry);
+      XFREE (MTYPE_OSPF6_MDR, entry);
+    }
+}
+
+static void
+ospf6_mdr_ack_ring_push (struct ospf6_mdr_ack_cache *cache,
+			 struct ospf6_mdr_ack *ack, int slot)
+{
+  struct ospf6_mdr_ack_record *rec;
+
+  if (cache->ring_count == cache->ring_size)
+    {
+      struct ospf6_mdr_ack_record *ring;
+      unsigned int i, size;
+
+      size = cache->ring_size ? cache->ring_size * 2 : OSPF6_MDR_ACK_RING_MIN;
+      ring = XMALLOC (MTYPE_OSPF6_MDR, size * sizeof (*ring));
+      for (i = 0; i < cache->ring_count; i++)
+	ring[i] = OSPF6_MDR_ACK_RING (cache, i);
+      if (cache->ring)
+	XFREE (MTYPE_OSPF6_MDR, cache->ring);
+      cache->ring = ring;
+      cache->ring_size = size;
+      cache->ring_head = 0;
+    }
+
+  rec = &OSPF6_MDR_ACK_RING (cache, cache->ring_count);
+  rec->ack = ack;
+  rec->slot = slot;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &rec->received);
+  ack->refcnt++;
+  cache->ring_count++;
+}
+
+static int
+ospf6_mdr_ack_cache_expire (struct thread *thread)
+{
+  struct ospf6_mdr_ack_cache *cache;
+  struct ospf6_mdr_ack_record *rec;
   struct timeval now;
-  int ack_cache_timeout;
-  struct ospf6_lsa *ack;
-  unsigned int remaining;
+  long timeout, age;
 
-  on = THREAD_ARG (thread);
-  on->mdr.thread_ack_list_expire = NULL;
+  cache = THREAD_ARG (thread);
+  cache->thread_expire = NULL;
 
   quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
-  ack_cache_timeout = on->ospf6_if->mdr.ack_cache_timeout;
-  remaining = 0;
+  timeout = cache->oi->mdr.ack_cache_timeout;
 
-  for (ack = ospf6_lsdb_head (on->mdr.ack_list); ack != NULL;
-       ack = ospf6_lsdb_next (ack))
+  while (cache->ring_count > 0)
     {
-      if (timersub_sec (&now, &ack->received) > ack_cache_timeout)
-	{
-	  assert (ack->lock == 2);
-	  ospf6_lsdb_remove (ack, on->mdr.ack_list);
-	}
-      else
+      rec = &OSPF6_MDR_ACK_RING (cache, 0);
+      age = timersub_sec (&now, &rec->received);
+      if (age <= timeout)
 	{
-	  remaining++;
+	  cache->thread_expire =
+	    thread_add_timer (master, ospf6_mdr_ack_cache_expire,
+			      cache, timeout - age + 1);
+	  break;
 	}
-  }
 
-  if (remaining > 0)
-    on->mdr.thread_ack_list_expire =
-      thread_add_timer (master, ospf6_mdr_neighbor_ack_list_expire,
-			on, ack_cache_timeout);
+      if (rec->slot >= 0)
+	rec->ack->acked[rec->slot / 32] &= ~(1U << (rec->slot % 32));
+      ospf6_mdr_ack_unref (cache, rec->ack);
+      cache->ring_head = (cache->ring_head + 1) % cache->ring_size;
+      cache->ring_count--;
+    }
 
   return 0;
 }
 
+void
+ospf6_mdr_ack_cache_create (struct ospf6_interface *oi)
+{
+  struct ospf6_mdr_ack_cache *cache;
+
+  cache = XCALLOC (MTYPE_OSPF6_MDR, sizeof (struct ospf6_mdr_ack_cache));
+  cache->oi = oi;
+  cache->lsas = hash_create (ospf6_mdr_ack_lsa_hash, ospf6_mdr_ack_lsa_cmp);
+  oi->mdr.ack_cache = cache;
+}
+
+void
+ospf6_mdr_ack_cache_delete (struct ospf6_interface *oi)
+{
+  struct ospf6_mdr_ack_cache *cache = oi->mdr.ack_cache;
+
+  if (cache == NULL)
+    return;
+
+  THREAD_OFF (cache->thread_expire);
+  while (cache->ring_count > 0)
+    {
+      ospf6_mdr_ack_unref (cache, OSPF6_MDR_ACK_RING (cache, 0).ack);
+      cache->ring_head = (cache->ring_head + 1) % cache->ring_size;
+      cache->ring_count--;
+    }
+  assert (cache->lsas->count == 0);
+  hash_free (cache->lsas);
+  if (cache->ring)
+    XFREE (MTYPE_OSPF6_MDR, cache->ring);
+  XFREE (MTYPE_OSPF6_MDR, cache);
+  oi->mdr.ack_cache = NULL;
+}
+
+void
+ospf6_mdr_ack_cache_show (struct vty *vty, struct ospf6_interface *oi)
+{
+  struct ospf6_mdr_ack_cache *cache = oi->mdr.ack_cache;
+
+  vty_out (vty, "    Ack cache: %lu LSAs, %u instances, %u acks%s",
+	   cache->lsas->count, cache->instances, cache->ring_count, VNL);
+}
+
+static void
+ospf6_mdr_ack_slot_alloc (struct ospf6_neighbor *on)
+{
+  struct ospf6_mdr_ack_cache *cache = on->ospf6_if->mdr.ack_cache;
+  int slot;
+
+  on->mdr.ack_slot = -1;
+  for (slot = 0; slot < OSPF6_MDR_ACK_MAX_NEIGHBORS; slot++)
+    if (!(cache->slots[slot / 32] & (1U << (slot % 32))))
+      {
+	cache->slots[slot / 32] |= 1U << (slot % 32);
+	on->mdr.ack_slot = slot;
+	return;
+      }
+}
+
+static void
+ospf6_mdr_ack_slot_free (struct ospf6_neighbor *on)
+{
+  struct ospf6_mdr_ack_cache *cache = on->ospf6_if->mdr.ack_cache;
+  struct ospf6_mdr_ack_record *rec;
+  int slot = on->mdr.ack_slot;
+  unsigned int i;
+
+  if (slot < 0)
+    return;
+
+  /* forget this neighbor's acks before the slot is handed out again */
+  for (i = 0; i < cache->ring_count; i++)
+    {
+      rec = &OSPF6_MDR_ACK_RING (cache, i);
+      if (rec->slot == slot)
+	{
+	  rec->ack->acked[slot / 32] &= ~(1U << (slot % 32));
+	  rec->slot = -1;
+	}
+    }
+  cache->slots[slot / 32] &= ~(1U << (slot % 32));
+  on->mdr.ack_slot = -1;
+}
+
 // Section 3.4.3 bullet 2
 void
 ospf6_mdr_neighbor_store_ack (struct ospf6_neighbor *on,
 			      struct ospf6_lsa *lsa)
 {
-  struct ospf6_lsa *ack;
+  struct ospf6_mdr_ack_cache *cache = on->ospf6_if->mdr.ack_cache;
+  struct ospf6_mdr_ack_lsa *entry;
+  struct ospf6_mdr_ack *ack, *match;
+  int slot = on->mdr.ack_slot;
+  u_int32_t bit;
 
   assert (on->ospf6_if->type == OSPF6_IFTYPE_MDR);
 
-  ack = ospf6_mdr_neighbor_lookup_ack (on, lsa);
-  if (ack == NULL || ospf6_lsa_compare (lsa, ack) < 0)
+  if (slot < 0)
+    return;
+  bit = 1U << (slot % 32);
+
+  entry = ospf6_mdr_ack_lsa_lookup (cache, lsa, true);
+  match = NULL;
+  for (ack = entry->instances; ack; ack = ack->next)
     {
-      /* no existing ack or this ack is for a more recent lsa */
-      ack = ospf6_lsa_create_headeronly (lsa->header);
-      quagga_gettime (QUAGGA_CLK_MONOTONIC, &ack->received);
+      int cmp = ospf6_mdr_ack_compare (ack, lsa);
 
-      ospf6_lsdb_add (ack, on->mdr.ack_list);
+      if (cmp == 0)
+	match = ack;
+      if (ack->acked[slot / 32] & bit)
+	{
+	  /* keep an existing ack unless this one is more recent */
+	  if (cmp <= 0)
+	    return;
+	  ack->acked[slot / 32] &= ~bit;
+	}
+    }
 
-      if (on->mdr.thread_ack_list_expire == NULL)
-	on->mdr.thread_ack_list_expire =
-	  thread_add_timer (master, ospf6_mdr_neighbor_ack_list_expire,
-			    on, on->ospf6_if->mdr.ack_cache_timeout);
+  if (match == NULL)
+    {
+      match = XCALLOC (MTYPE_OSPF6_MDR, sizeof (struct ospf6_mdr_ack));
+      match->lsa = entry;
+      match->seqnum = ntohl (lsa->header->seqnum);
+      match->checksum = ntohs (lsa->header->checksum);
+      match->maxage = (ospf6_lsa_age_current (lsa) == MAXAGE);
+      match->next = entry->instances;
+      entry->instances = match;
+      cache->instances++;
     }
+
+  match->acked[slot / 32] |= bit;
+  ospf6_mdr_ack_ring_push (cache, match, slot);
+
+  if (cache->thread_expire == NULL)
+    cache->thread_expire =
+      thread_add_timer (master, ospf6_mdr_ack_cache_expire,
+			cache, on->ospf6_if->mdr.ack_cache_timeout + 1);
 }
 
+/* Fill in the neighbors that acked this instance of the LSA, or a
+   more recent one.  Returns whether there are any. */
 bool
-ospf6_mdr_neighbor_has_acked (struct ospf6_neighbor *on, struct ospf6_lsa *lsa)
+ospf6_mdr_acked_neighbors (struct ospf6_interface *oi, struct ospf6_lsa *lsa,
+			   ospf6_mdr_ack_bitmap acked)
 {
-  struct ospf6_lsa *ack;
+  struct ospf6_mdr_ack_lsa *entry;
+  struct ospf6_mdr_ack *ack;
+  bool found = false;
+  int i;
 
-  assert (on->ospf6_if->type == OSPF6_IFTYPE_MDR);
+  memset (acked, 0, sizeof (ospf6_mdr_ack_bitmap));
 
-  ack = ospf6_mdr_neighbor_lookup_ack (on, lsa);
+  entry = ospf6_mdr_ack_lsa_lookup (oi->mdr.ack_cache, lsa, false);
+  if (entry == NULL)
+    return false;
 
-  if (ack != NULL && ospf6_lsa_compare (ack, lsa) <= 0)
-    return true;
+  for (ack = entry->instances; ack; ack = ack->next)
+    if (ospf6_mdr_ack_compare (ack, lsa) <= 0)
+      for (i = 0; i < OSPF6_MDR_ACK_WORDS; i++)
+	{
+	  acked[i] |= ack->acked[i];
+	  if (ack->acked[i])
+	    found = true;
+	}
 
-  return false;
+  return found;
 }
 
 void
@@ -30,10 +30,22 @@
 
 #include "linklist.h"
 
+/* Multicast acks received on an MDR interface are cached per interface,
+   one entry per LSA instance with a bitmap of the neighbors that acked
+   it.  Neighbors beyond the bitmap size are never considered to have
+   acked anything. */
+#define OSPF6_MDR_ACK_MAX_NEIGHBORS	256
+#define OSPF6_MDR_ACK_WORDS		(OSPF6_MDR_ACK_MAX_NEIGHBORS / 32)
+
+typedef u_int32_t ospf6_mdr_ack_bitmap[OSPF6_MDR_ACK_WORDS];
+
+#define OSPF6_MDR_ACK_ISSET(bitmap, on) \
+  ((on)->mdr.ack_slot >= 0 && \
+   ((bitmap)[(on)->mdr.ack_slot / 32] & (1U << ((on)->mdr.ack_slot % 32))))
+
 struct ospf6_mdr_neighbor
 {
-  struct ospf6_lsdb *ack_list;
-  struct thread *thread_ack_list_expire;
+  int ack_slot;                 // bit in the interface ack cache, or -1
 
   bool routable;
   bool dependent;
@@ -71,6 +83,7 @@ struct ospf6_lls_header;
 struct ospf6_lsa_header;
 struct ospf6_interface;
 struct ospf6_lsa;
+struct vty;
 
 extern void ospf6_mdr_neighbor_init (void);
 extern void ospf6_mdr_neighbor_create (struct ospf6_neighbor *on);
@@ -91,9 +104,14 @@ extern void ospf6_mdr_delete_lnl_element (struct ospf6_interface *,
 extern bool ospf6_mdr_delete_neighbor (struct list *, u_int32_t);
 extern void ospf6_mdr_add_neighbor (struct list *, u_int32_t);
 extern void ospf6_mdr_delete_all_neighbors (struct list *);
+extern void ospf6_mdr_ack_cache_create (struct ospf6_interface *oi);
+extern void ospf6_mdr_ack_cache_delete (struct ospf6_interface *oi);
+extern void ospf6_mdr_ack_cache_show (struct vty *vty,
+				      struct ospf6_interface *oi);
 extern void ospf6_mdr_neighbor_store_ack (struct ospf6_neighbor *on,
 					  struct ospf6_lsa *lsa);
-extern bool ospf6_mdr_neighbor_has_acked (struct ospf6_neighbor *on,
-					  struct ospf6_lsa *lsa);
+extern bool ospf6_mdr_acked_neighbors (struct ospf6_interface *oi,
+				       struct ospf6_lsa *lsa,
+				       ospf6_mdr_ack_bitmap acked);
 
 #endif	/* OSPF6_MDR_NEIGHBOR_H */
@@ -27,6 +27,7 @@
 #include "command.h"
 #include "thread.h"
 #include "linklist.h"
+#include "checksum.h"
 
 #include "ospf6_proto.h"
 #include "ospf6_lsa.h"
@@ -1442,6 +1443,34 @@ ospf6_rxpacket_examin (struct ospf6_interface *oi, struct ospf6_header *oh, cons
   return MSG_OK;
 }
 
+/* LSAs of one LSUpdate whose checksums are verified together. */
+#define OSPF6_LSUPDATE_CHECKSUM_BATCH 32
+
+static void
+ospf6_lsupdate_recv_lsas (struct ospf6_lsa_header **lsas,
+                          struct fletcher_item *items, unsigned int count,
+                          struct ospf6_neighbor *on, struct in6_addr *dst)
+{
+  unsigned int i;
+
+  fletcher_checksum_verify_batch (items, count);
+
+  for (i = 0; i < count; i++)
+    {
+      if (! items[i].valid)
+        {
+          if (IS_OSPF6_DEBUG_FLOODING ||
+              IS_OSPF6_DEBUG_FLOOD_TYPE (lsas[i]->type))
+            zlog_debug ("Wrong LSA Checksum %#06x from %s, discard",
+                        ntohs (lsas[i]->checksum), on->name);
+          continue;
+        }
+
+      // Pass in dst address in case it is multicast
+      ospf6_receive_lsa (lsas[i], on, dst);
+    }
+}
+
 static void
 ospf6_lsupdate_recv (struct in6_addr *src, struct in6_addr *dst,
                      struct ospf6_interface *oi, struct ospf6_header *oh)
@@ -1449,6 +1478,9 @@ ospf6_lsupdate_recv (struct in6_addr *src, struct in6_addr *dst,
   struct ospf6_neighbor *on;
   struct ospf6_lsupdate *lsupdate;
   char *p;
+  struct ospf6_lsa_header *lsas[OSPF6_LSUPDATE_CHECKSUM_BATCH];
+  struct fletcher_item items[OSPF6_LSUPDATE_CHECKSUM_BATCH];
+  unsigned int count = 0;
 
   on = ospf6_neighbor_lookup (oh->router_id, oi);
   if (on == NULL)
@@ -1493,9 +1525,16 @@ ospf6_lsupdate_recv (struct in6_addr *src, struct in6_addr *dst,
        p + OSPF6_LSA_SIZE (p) <= OSPF6_MESSAGE_END (oh);
        p += OSPF6_LSA_SIZE (p))
     {
-      // Pass in dst address in case it is multicast
-      ospf6_receive_lsa ((struct ospf6_lsa_header *) p, on, dst);
+      lsas[count] = (struct ospf6_lsa_header *) p;
+      ospf6_lsa_checksum_item (lsas[count], &items[count]);
+      if (++count == OSPF6_LSUPDATE_CHECKSUM_BATCH)
+        {
+          ospf6_lsupdate_recv_lsas (lsas, items, count, on, dst);
+          count = 0;
+        }
     }
+  if (count)
+    ospf6_lsupdate_recv_lsas (lsas, items, count, on, dst);
 
   assert (p == OSPF6_MESSAGE_END (oh));
 
@@ -1593,7 +1632,7 @@ ospf6_lsack_recv (struct in6_addr *src, struct in6_addr *dst,
 
       // Delete backupwait neighbor corresponding to source of LSAck
       if (on->ospf6_if->type == OSPF6_IFTYPE_MDR &&
-          mine->backupWaitTimer && ospf6_lsa_compare (his, mine) == 0)
+          mine->backupwait && ospf6_lsa_compare (his, mine) == 0)
         {
           ospf6_backupwait_lsa_neighbor_delete (mine, on);
         }
@@ -31,6 +31,7 @@
 #include "pqueue.h"
 #include "linklist.h"
 #include "thread.h"
+#include "table.h"
 
 #include "ospf6_lsa.h"
 #include "ospf6_lsdb.h"
@@ -44,6 +45,7 @@
 #include "ospf6_af.h"
 #include "ospf6_proto.h"
 #include "ospf6_mdr.h"
+#include "ospf6_zebra_linkmetrics.h"
 
 unsigned char conf_debug_ospf6_spf = 0;
 
@@ -850,11 +852,101 @@ ospf6_spf_log_database (struct ospf6_area *oa)
   zlog_debug ("%s", buffer);
 }
 
+/* Collect the linkstate prefixes of vertices that appeared, vanished
+   or whose path or nexthops changed between two SPF results.  Nodes
+   of the changed table only carry a non-NULL info marker. */
+static unsigned int
+ospf6_spf_table_diff (struct ospf6_route_table *old_table,
+		      struct ospf6_route_table *new_table,
+		      struct route_table *changed)
+{
+  struct ospf6_route *route, *other;
+  struct route_node *rn;
+  unsigned int numchanged = 0;
+
+  for (route = ospf6_route_head (new_table); route;
+       route = ospf6_route_next (route))
+    {
+      other = ospf6_route_lookup (&route->prefix, old_table);
+      if (other && ospf6_route_is_identical (route, other))
+	continue;
+
+      rn = route_node_get (changed, &route->prefix);
+      if (rn->info)
+	{
+	  route_unlock_node (rn);
+	  continue;
+	}
+      rn->info = changed;	/* only membership matters */
+      numchanged++;
+    }
+
+  for (route = ospf6_route_head (old_table); route;
+       route = ospf6_route_next (route))
+    {
+      if (ospf6_route_lookup (&route->prefix, new_table))
+	continue;
+
+      rn = route_node_get (changed, &route->prefix);
+      if (rn->info)
+	{
+	  route_unlock_node (rn);
+	  continue;
+	}
+      rn->info = changed;
+      numchanged++;
+    }
+
+  return numchanged;
+}
+
+/* Run SPF for an area into a fresh table and update the intra-area
+   and border router tables from the vertices that changed. */
+static void
+ospf6_spf_route_calculation (struct ospf6_area *oa, struct timeval *runtime)
+{
+  struct ospf6_route_table *old_table;
+  struct route_table *changed;
+  struct timeval start, end;
+  unsigned int numchanged;
+
+  old_table = oa->spf_table;
+  oa->spf_table = OSPF6_ROUTE_TABLE_CREATE (AREA, SPF_RESULTS);
+  oa->spf_table->scope = oa;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  ospf6_spf_calculation (oa->ospf6->router_id, oa->spf_table, oa);
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &end);
+  if (runtime)
+    timersub (&end, &start, runtime);
+
+  changed = route_table_init ();
+  numchanged = ospf6_spf_table_diff (old_table, oa->spf_table, changed);
+
+  ospf6_spf_table_finish (old_table);
+  ospf6_route_table_delete (old_table);
+
+  ospf6_intra_route_calculation (oa, changed);
+
+  /* border routers are copied from the SPF results */
+  if (numchanged)
+    ospf6_intra_brouter_calculation (oa);
+
+  route_table_finish (changed);
+
+  if (IS_OSPF6_DEBUG_SPF (PROCESS))
+    zlog_debug ("SPF for Area %s: %u vertices changed, "
+		"%u LSAs examined, routes %u added %u changed %u removed",
+		oa->name, numchanged, oa->intra_last_lsas,
+		oa->intra_last_churn.added, oa->intra_last_churn.changed,
+		oa->intra_last_churn.removed);
+}
+
 static int
 ospf6_spf_calculation_thread (struct thread *t)
 {
   struct ospf6_area *oa;
-  struct timeval start, end, runtime;
+  struct timeval runtime;
   struct listnode *node;
   struct ospf6_interface *oi;
   int change;
@@ -868,18 +960,12 @@ ospf6_spf_calculation_thread (struct thread *t)
     ospf6_spf_log_database (oa);
 
   /* execute SPF calculation */
-  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
-  ospf6_spf_calculation (oa->ospf6->router_id, oa->spf_table, oa);
-  quagga_gettime (QUAGGA_CLK_MONOTONIC, &end);
-  timersub (&end, &start, &runtime);
+  ospf6_spf_route_calculation (oa, &runtime);
 
   if (IS_OSPF6_DEBUG_SPF (PROCESS) || IS_OSPF6_DEBUG_SPF (TIME))
     zlog_debug ("SPF runtime: %ld sec %ld usec",
 		runtime.tv_sec, runtime.tv_usec);
 
-  ospf6_intra_route_calculation (oa);
-  ospf6_intra_brouter_calculation (oa);
-
   quagga_gettime (QUAGGA_CLK_MONOTONIC, &oa->last_spftime);
 
   change = 0;
@@ -896,11 +982,9 @@ ospf6_spf_calculation_thread (struct thread *t)
 
   // rerun spf if the set of routable neighbors has changed
   if (change)
-    {
-      ospf6_spf_calculation (oa->ospf6->router_id, oa->spf_table, oa);
-      ospf6_intra_route_calculation (oa);
-      ospf6_intra_brouter_calculation (oa);
-    }
+    ospf6_spf_route_calculation (oa, NULL);
+
+  ospf6_linkmetrics_stage_done (OSPF6_LINKMETRICS_STAGE_SPF);
 
   return 0;
 }
@@ -195,6 +195,9 @@ ospf6_delete (struct ospf6 *o)
 
   ospf6_asbr_delete (o);
 
+  /* send the withdrawals still queued */
+  ospf6_zebra_route_flush ();
+
   XFREE (MTYPE_OSPF6_TOP, o);
 }
 
@@ -1007,6 +1010,7 @@ config_write_ospf6 (struct vty *vty)
   if (ospf6->min_lsa_interval != MIN_LS_INTERVAL)
     vty_out (vty, " min-lsa-interval %u%s", ospf6->min_lsa_interval, VNL);
 
+  ospf6_zebra_config_write (vty);
   ospf6_redistribute_config_write (vty);
   ospf6_area_config_write (vty);
 
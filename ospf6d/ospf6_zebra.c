@@ -28,6 +28,9 @@
 #include "stream.h"
 #include "zclient.h"
 #include "memory.h"
+#include "linklist.h"
+#include "table.h"
+#include "thread.h"
 
 #include "ospf6_proto.h"
 #include "ospf6_top.h"
@@ -444,7 +447,7 @@ typedef enum
   ROUTE_REMOVE,
 } ospf6_zebra_route_update_t;
 
-static void
+static int
 __ospf6_zebra_route_update (ospf6_zebra_route_update_t update,
                             struct ospf6_route *route)
 {
@@ -476,7 +479,7 @@ __ospf6_zebra_route_update (ospf6_zebra_route_update_t update,
           prefix2str (&route->prefix, buf, sizeof (buf));
 	  zlog_warn ("%s: error converting destination prefix: %s",
 		     __func__, buf);
-          return;
+          return 0;
         }
 
       p = &prefix;
@@ -497,7 +500,7 @@ __ospf6_zebra_route_update (ospf6_zebra_route_update_t update,
     {
       if (IS_OSPF6_DEBUG_ZEBRA (SEND))
         zlog_debug ("  No nexthop, ignore");
-      return;
+      return 0;
     }
 
   message = 0;
@@ -673,6 +676,362 @@ __ospf6_zebra_route_update (ospf6_zebra_route_update_t update,
   stream_putw_at (s, 0, stream_get_endp (s));
 
   zclient_send_message (zclient);
+  return 1;
+}
+
+/* FIB update queue.
+ *
+ * Route table hooks do not talk to zebra directly.  Updates are kept
+ * per prefix and sent when the queue is flushed, after a short delay
+ * or once enough prefixes are pending, so that a path going
+ * add/change/remove/add in quick succession costs at most one ZAPI
+ * message.  Prefixes that keep flapping can optionally be damped: a
+ * penalty is charged for every withdrawal (and half of it for a path
+ * change), decays with the configured half-life, and while it is above
+ * the suppress threshold updates for the prefix are held back until it
+ * decays below the reuse threshold.  The FIB then keeps its last state.
+ */
+struct ospf6_zebra_fib_entry
+{
+  struct route_node *rn;
+
+  /* zebra has a route for this prefix */
+  u_char installed;
+
+  /* pending update and the path to send with it */
+  u_char pending;
+  struct ospf6_route *route;
+  u_char queued;
+
+  /* flap damping */
+  u_char suppressed;
+  u_int32_t penalty;
+  time_t penalty_updated;
+};
+
+#define OSPF6_FIB_DELAY_DEFAULT         50    /* msec */
+#define OSPF6_FIB_HIGH_WATER_DEFAULT    1000  /* prefixes */
+#define OSPF6_FIB_DAMP_HALF_LIFE_DEFAULT 15   /* sec */
+#define OSPF6_FIB_DAMP_REUSE_DEFAULT    750
+#define OSPF6_FIB_DAMP_SUPPRESS_DEFAULT 2000
+#define OSPF6_FIB_DAMP_PENALTY          1000
+#define OSPF6_FIB_DAMP_REUSE_INTERVAL   1     /* sec */
+
+static struct
+{
+  /* configuration */
+  unsigned int delay;
+  unsigned int high_water;
+  int damping;
+  unsigned int half_life;
+  unsigned int reuse;
+  unsigned int suppress;
+
+  struct route_table *table;
+  struct list *queue;
+  struct list *damped;
+  struct thread *t_flush;
+  struct thread *t_reuse;
+
+  /* statistics */
+  unsigned long requested;
+  unsigned long coalesced;
+  unsigned long cancelled;
+  unsigned long sent_add;
+  unsigned long sent_remove;
+  unsigned long flushes;
+  unsigned long high_water_flushes;
+  unsigned long suppressions;
+  unsigned long held;
+} fib =
+{
+  .delay = OSPF6_FIB_DELAY_DEFAULT,
+  .high_water = OSPF6_FIB_HIGH_WATER_DEFAULT,
+  .half_life = OSPF6_FIB_DAMP_HALF_LIFE_DEFAULT,
+  .reuse = OSPF6_FIB_DAMP_REUSE_DEFAULT,
+  .suppress = OSPF6_FIB_DAMP_SUPPRESS_DEFAULT,
+};
+
+static time_t
+ospf6_zebra_fib_now (void)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return now.tv_sec;
+}
+
+/* Exponential decay, linear within a half-life. */
+static void
+ospf6_zebra_fib_decay (struct ospf6_zebra_fib_entry *entry, time_t now)
+{
+  time_t elapsed = now - entry->penalty_updated;
+
+  entry->penalty_updated = now;
+  if (entry->penalty == 0 || elapsed <= 0)
+    return;
+
+  if (elapsed / fib.half_life >= 32)
+    entry->penalty = 0;
+  else
+    {
+      entry->penalty >>= elapsed / fib.half_life;
+      entry->penalty -= (u_int32_t)
+        ((unsigned long long) entry->penalty * (elapsed % fib.half_life) /
+         (2 * fib.half_life));
+    }
+}
+
+static void
+ospf6_zebra_fib_entry_free (struct ospf6_zebra_fib_entry *entry)
+{
+  if (entry->route)
+    ospf6_route_delete (entry->route);
+  entry->rn->info = NULL;
+  route_unlock_node (entry->rn);
+  XFREE (MTYPE_OSPF6_OTHER, entry);
+}
+
+/* Drop state that no longer matters, including a flap history that
+   is too small to lead to suppression soon. */
+static void
+ospf6_zebra_fib_entry_gc (struct ospf6_zebra_fib_entry *entry)
+{
+  if (entry->installed || entry->pending != NONE || entry->queued ||
+      entry->suppressed)
+    return;
+  if (entry->penalty)
+    {
+      ospf6_zebra_fib_decay (entry, ospf6_zebra_fib_now ());
+      if (fib.damping && entry->penalty >= fib.reuse)
+        return;
+    }
+  ospf6_zebra_fib_entry_free (entry);
+}
+
+static void
+ospf6_zebra_fib_send (struct ospf6_zebra_fib_entry *entry)
+{
+  if (entry->pending == ROUTE_ADD)
+    {
+      if (__ospf6_zebra_route_update (ROUTE_ADD, entry->route))
+        {
+          entry->installed = 1;
+          fib.sent_add++;
+        }
+    }
+  else if (entry->pending == ROUTE_REMOVE)
+    {
+      if (entry->installed)
+        {
+          __ospf6_zebra_route_update (ROUTE_REMOVE, entry->route);
+          entry->installed = 0;
+          fib.sent_remove++;
+        }
+      else
+        fib.cancelled++;
+    }
+
+  entry->pending = NONE;
+  if (entry->route)
+    {
+      ospf6_route_delete (entry->route);
+      entry->route = NULL;
+    }
+}
+
+/* Send every queued update that is not held back by damping. */
+void
+ospf6_zebra_route_flush (void)
+{
+  struct ospf6_zebra_fib_entry *entry;
+
+  THREAD_OFF (fib.t_flush);
+
+  if (fib.queue == NULL || listcount (fib.queue) == 0)
+    return;
+
+  fib.flushes++;
+  while (listcount (fib.queue))
+    {
+      entry = listgetdata (listhead (fib.queue));
+      list_delete_node (fib.queue, listhead (fib.queue));
+      entry->queued = 0;
+
+      if (!entry->suppressed)
+        {
+          if (zclient->sock < 0)
+            {
+              /* zebra forgets our routes when the connection closes */
+              entry->installed = 0;
+              entry->pending = NONE;
+            }
+          else
+            ospf6_zebra_fib_send (entry);
+        }
+
+      ospf6_zebra_fib_entry_gc (entry);
+    }
+
+  ospf6_linkmetrics_stage_done (OSPF6_LINKMETRICS_STAGE_FIB);
+}
+
+/* Number of route updates requested so far. */
+unsigned long
+ospf6_zebra_route_requests (void)
+{
+  return fib.requested;
+}
+
+static int
+ospf6_zebra_fib_flush_timer (struct thread *thread)
+{
+  fib.t_flush = NULL;
+  ospf6_zebra_route_flush ();
+  return 0;
+}
+
+static void
+ospf6_zebra_fib_queue (struct ospf6_zebra_fib_entry *entry)
+{
+  if (!entry->queued)
+    {
+      listnode_add (fib.queue, entry);
+      entry->queued = 1;
+    }
+
+  if (fib.delay == 0)
+    ospf6_zebra_route_flush ();
+  else if (listcount (fib.queue) >= fib.high_water)
+    {
+      fib.high_water_flushes++;
+      ospf6_zebra_route_flush ();
+    }
+  else if (fib.t_flush == NULL)
+    fib.t_flush = thread_add_timer_msec (master, ospf6_zebra_fib_flush_timer,
+                                         NULL, fib.delay);
+}
+
+/* Release prefixes whose penalty has decayed below the reuse
+   threshold, sending whatever update is pending for them. */
+static int
+ospf6_zebra_fib_reuse_timer (struct thread *thread)
+{
+  struct listnode *node, *nnode;
+  struct ospf6_zebra_fib_entry *entry;
+  time_t now = ospf6_zebra_fib_now ();
+
+  fib.t_reuse = NULL;
+
+  for (ALL_LIST_ELEMENTS (fib.damped, node, nnode, entry))
+    {
+      ospf6_zebra_fib_decay (entry, now);
+      if (fib.damping && entry->penalty >= fib.reuse)
+        continue;
+
+      if (IS_OSPF6_DEBUG_ZEBRA (SEND))
+        {
+          char buf[PREFIXSTRLEN];
+
+          ospf6_prefix2str (ospf6, &entry->rn->p, buf, sizeof (buf));
+          zlog_debug ("FIB damping: reuse %s", buf);
+        }
+
+      entry->suppressed = 0;
+      list_delete_node (fib.damped, node);
+      if (entry->pending != NONE)
+        ospf6_zebra_fib_queue (entry);
+      else
+        ospf6_zebra_fib_entry_gc (entry);
+    }
+
+  if (listcount (fib.damped))
+    fib.t_reuse = thread_add_timer (master, ospf6_zebra_fib_reuse_timer,
+                                    NULL, OSPF6_FIB_DAMP_REUSE_INTERVAL);
+  return 0;
+}
+
+static void
+ospf6_zebra_fib_penalize (struct ospf6_zebra_fib_entry *entry,
+                          ospf6_zebra_route_update_t update)
+{
+  u_int32_t penalty, ceiling;
+
+  if (update == ROUTE_REMOVE)
+    penalty = OSPF6_FIB_DAMP_PENALTY;
+  else if (entry->installed || entry->pending == ROUTE_ADD)
+    penalty = OSPF6_FIB_DAMP_PENALTY / 2;
+  else
+    return;
+
+  ospf6_zebra_fib_decay (entry, ospf6_zebra_fib_now ());
+
+  /* keep a prefix from being suppressed forever */
+  ceiling = fib.suppress * 4;
+  entry->penalty += penalty;
+  if (entry->penalty > ceiling)
+    entry->penalty = ceiling;
+
+  if (!entry->suppressed && entry->penalty > fib.suppress)
+    {
+      if (IS_OSPF6_DEBUG_ZEBRA (SEND))
+        {
+          char buf[PREFIXSTRLEN];
+
+          ospf6_prefix2str (ospf6, &entry->rn->p, buf, sizeof (buf));
+          zlog_debug ("FIB damping: suppress %s, penalty %u",
+                      buf, entry->penalty);
+        }
+
+      entry->suppressed = 1;
+      fib.suppressions++;
+      listnode_add (fib.damped, entry);
+      if (fib.t_reuse == NULL)
+        fib.t_reuse = thread_add_timer (master, ospf6_zebra_fib_reuse_timer,
+                                        NULL, OSPF6_FIB_DAMP_REUSE_INTERVAL);
+    }
+}
+
+static void
+ospf6_zebra_fib_update (ospf6_zebra_route_update_t update,
+                        struct ospf6_route *request)
+{
+  struct route_node *rn;
+  struct ospf6_zebra_fib_entry *entry;
+
+  fib.requested++;
+
+  rn = route_node_get (fib.table, &request->prefix);
+  if (rn->info)
+    {
+      entry = rn->info;
+      route_unlock_node (rn);
+    }
+  else
+    {
+      entry = XCALLOC (MTYPE_OSPF6_OTHER, sizeof (*entry));
+      entry->rn = rn;
+      entry->pending = NONE;
+      rn->info = entry;
+    }
+
+  if (fib.damping)
+    ospf6_zebra_fib_penalize (entry, update);
+
+  if (entry->pending != NONE)
+    fib.coalesced++;
+  if (entry->route)
+    ospf6_route_delete (entry->route);
+  entry->pending = update;
+  entry->route = ospf6_route_copy (request);
+
+  if (entry->suppressed)
+    {
+      fib.held++;
+      return;
+    }
+
+  ospf6_zebra_fib_queue (entry);
 }
 
 static void
@@ -726,7 +1085,7 @@ ospf6_zebra_route_update (ospf6_zebra_route_update_t update,
       return;
     }
 
-  __ospf6_zebra_route_update (update, request);
+  ospf6_zebra_fib_update (update, request);
 }
 
 void
@@ -741,6 +1100,165 @@ ospf6_zebra_route_update_remove (struct ospf6_route *request)
   ospf6_zebra_route_update (ROUTE_REMOVE, request);
 }
 
+DEFUN (ospf6_fib_update_delay,
+       ospf6_fib_update_delay_cmd,
+       "fib-update delay <0-10000>",
+       "Route updates sent to zebra\n"
+       "Delay before sending queued updates\n"
+       "Milliseconds (0 sends updates immediately)\n")
+{
+  VTY_GET_INTEGER_RANGE ("delay", fib.delay, argv[0], 0, 10000);
+  if (fib.delay == 0)
+    ospf6_zebra_route_flush ();
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_ospf6_fib_update_delay,
+       no_ospf6_fib_update_delay_cmd,
+       "no fib-update delay",
+       NO_STR
+       "Route updates sent to zebra\n"
+       "Delay before sending queued updates\n")
+{
+  fib.delay = OSPF6_FIB_DELAY_DEFAULT;
+  return CMD_SUCCESS;
+}
+
+DEFUN (ospf6_fib_update_high_water,
+       ospf6_fib_update_high_water_cmd,
+       "fib-update high-water <1-1000000>",
+       "Route updates sent to zebra\n"
+       "Send queued updates at once when this many prefixes are pending\n"
+       "Number of prefixes\n")
+{
+  VTY_GET_INTEGER_RANGE ("high-water", fib.high_water, argv[0], 1, 1000000);
+  if (fib.queue && listcount (fib.queue) >= fib.high_water)
+    ospf6_zebra_route_flush ();
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_ospf6_fib_update_high_water,
+       no_ospf6_fib_update_high_water_cmd,
+       "no fib-update high-water",
+       NO_STR
+       "Route updates sent to zebra\n"
+       "Send queued updates at once when this many prefixes are pending\n")
+{
+  fib.high_water = OSPF6_FIB_HIGH_WATER_DEFAULT;
+  return CMD_SUCCESS;
+}
+
+DEFUN (ospf6_fib_update_damping,
+       ospf6_fib_update_damping_cmd,
+       "fib-update damping <1-3600> <1-20000> <1-20000>",
+       "Route updates sent to zebra\n"
+       "Hold back updates for flapping prefixes\n"
+       "Half-life in seconds\n"
+       "Penalty below which updates resume\n"
+       "Penalty above which updates are held back\n")
+{
+  unsigned int half_life, reuse, suppress;
+
+  half_life = OSPF6_FIB_DAMP_HALF_LIFE_DEFAULT;
+  reuse = OSPF6_FIB_DAMP_REUSE_DEFAULT;
+  suppress = OSPF6_FIB_DAMP_SUPPRESS_DEFAULT;
+  if (argc == 3)
+    {
+      VTY_GET_INTEGER_RANGE ("half-life", half_life, argv[0], 1, 3600);
+      VTY_GET_INTEGER_RANGE ("reuse", reuse, argv[1], 1, 20000);
+      VTY_GET_INTEGER_RANGE ("suppress", suppress, argv[2], 1, 20000);
+    }
+  if (reuse >= suppress)
+    {
+      vty_out (vty, "Suppress penalty must be above the reuse penalty%s",
+               VNL);
+      return CMD_WARNING;
+    }
+
+  fib.damping = 1;
+  fib.half_life = half_life;
+  fib.reuse = reuse;
+  fib.suppress = suppress;
+  return CMD_SUCCESS;
+}
+
+ALIAS (ospf6_fib_update_damping,
+       ospf6_fib_update_damping_default_cmd,
+       "fib-update damping",
+       "Route updates sent to zebra\n"
+       "Hold back updates for flapping prefixes\n")
+
+DEFUN (no_ospf6_fib_update_damping,
+       no_ospf6_fib_update_damping_cmd,
+       "no fib-update damping",
+       NO_STR
+       "Route updates sent to zebra\n"
+       "Hold back updates for flapping prefixes\n")
+{
+  fib.damping = 0;
+  fib.half_life = OSPF6_FIB_DAMP_HALF_LIFE_DEFAULT;
+  fib.reuse = OSPF6_FIB_DAMP_REUSE_DEFAULT;
+  fib.suppress = OSPF6_FIB_DAMP_SUPPRESS_DEFAULT;
+
+  /* release everything held back */
+  if (fib.damped && listcount (fib.damped))
+    {
+      THREAD_OFF (fib.t_reuse);
+      fib.t_reuse = thread_add_event (master, ospf6_zebra_fib_reuse_timer,
+                                      NULL, 0);
+    }
+  return CMD_SUCCESS;
+}
+
+void
+ospf6_zebra_config_write (struct vty *vty)
+{
+  if (fib.delay != OSPF6_FIB_DELAY_DEFAULT)
+    vty_out (vty, " fib-update delay %u%s", fib.delay, VNL);
+  if (fib.high_water != OSPF6_FIB_HIGH_WATER_DEFAULT)
+    vty_out (vty, " fib-update high-water %u%s", fib.high_water, VNL);
+  if (fib.damping)
+    {
+      if (fib.half_life == OSPF6_FIB_DAMP_HALF_LIFE_DEFAULT &&
+          fib.reuse == OSPF6_FIB_DAMP_REUSE_DEFAULT &&
+          fib.suppress == OSPF6_FIB_DAMP_SUPPRESS_DEFAULT)
+        vty_out (vty, " fib-update damping%s", VNL);
+      else
+        vty_out (vty, " fib-update damping %u %u %u%s",
+                 fib.half_life, fib.reuse, fib.suppress, VNL);
+    }
+}
+
+DEFUN (show_ipv6_ospf6_zebra,
+       show_ipv6_ospf6_zebra_cmd,
+       "show ipv6 ospf6 zebra",
+       SHOW_STR
+       IPV6_STR
+       OSPF6_STR
+       "Zebra information\n")
+{
+  vty_out (vty, "Zebra connection: %s%s",
+           zclient->sock < 0 ? "down" : "up", VNL);
+  vty_out (vty, "FIB update queue: delay %u msec, high-water %u, "
+           "%u prefixes pending%s", fib.delay, fib.high_water,
+           fib.queue ? listcount (fib.queue) : 0, VNL);
+  vty_out (vty, "  Updates requested: %lu, coalesced: %lu, "
+           "cancelled: %lu%s", fib.requested, fib.coalesced,
+           fib.cancelled, VNL);
+  vty_out (vty, "  Sent to zebra: %lu add, %lu remove in %lu flushes "
+           "(%lu at high-water)%s", fib.sent_add, fib.sent_remove,
+           fib.flushes, fib.high_water_flushes, VNL);
+  if (fib.damping)
+    vty_out (vty, "FIB damping: half-life %u sec, reuse %u, "
+             "suppress %u%s", fib.half_life, fib.reuse, fib.suppress, VNL);
+  else
+    vty_out (vty, "FIB damping: disabled%s", VNL);
+  vty_out (vty, "  Prefixes suppressed: %u now, %lu total; "
+           "updates held: %lu%s", fib.damped ? listcount (fib.damped) : 0,
+           fib.suppressions, fib.held, VNL);
+  return CMD_SUCCESS;
+}
+
 void
 ospf6_zebra_init (void)
 {
@@ -760,8 +1278,25 @@ ospf6_zebra_init (void)
   zclient->ipv6_route_delete = ospf6_zebra_read_ipv6;
   zclient->linkmetrics_subscribe = 1; /* XXX this could be made configurable */
   zclient->linkmetrics = ospf6_zebra_linkmetrics;
+  zclient->linkmetrics_batch = ospf6_zebra_linkmetrics_batch;
   zclient->linkstatus = ospf6_zebra_linkstatus;
 
+  fib.table = route_table_init ();
+  fib.queue = list_new ();
+  fib.damped = list_new ();
+
+  install_element (VIEW_NODE, &show_ipv6_ospf6_zebra_cmd);
+  install_element (ENABLE_NODE, &show_ipv6_ospf6_zebra_cmd);
+  install_element (OSPF6_NODE, &ospf6_fib_update_delay_cmd);
+  install_element (OSPF6_NODE, &no_ospf6_fib_update_delay_cmd);
+  install_element (OSPF6_NODE, &ospf6_fib_update_high_water_cmd);
+  install_element (OSPF6_NODE, &no_ospf6_fib_update_high_water_cmd);
+  install_element (OSPF6_NODE, &ospf6_fib_update_damping_cmd);
+  install_element (OSPF6_NODE, &ospf6_fib_update_damping_default_cmd);
+  install_element (OSPF6_NODE, &no_ospf6_fib_update_damping_cmd);
+
+  ospf6_zebra_linkmetrics_cmd_init ();
+
   /* redistribute connected route by default */
   /* ospf6_zebra_redistribute (ZEBRA_ROUTE_CONNECT); */
 
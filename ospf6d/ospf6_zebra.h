@@ -42,6 +42,9 @@ struct vty;
 
 extern void ospf6_zebra_route_update_add (struct ospf6_route *request);
 extern void ospf6_zebra_route_update_remove (struct ospf6_route *request);
+extern void ospf6_zebra_route_flush (void);
+extern unsigned long ospf6_zebra_route_requests (void);
+extern void ospf6_zebra_config_write (struct vty *vty);
 
 extern void ospf6_zebra_redistribute (int);
 extern void ospf6_zebra_no_redistribute (int);
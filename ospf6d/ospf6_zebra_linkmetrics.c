@@ -24,10 +24,13 @@
 #include "zebra.h"
 #include "zclient.h"
 #include "log.h"
+#include "command.h"
+#include "thread.h"
 
 #include "ospf6_zebra.h"
 #include "ospf6_neighbor.h"
 #include "ospf6_interface.h"
+#include "ospf6_interface_neighbor_metric.h"
 #include "ospf6_message.h"
 #include "ospf6_af.h"
 #include "ospf6d.h"
@@ -40,6 +43,100 @@
 static struct list *ospf6_linkmetrics_hooks;
 static struct list *ospf6_linkstatus_hooks;
 
+/* link metrics receive statistics */
+static struct
+{
+  unsigned long singles;	/* single updates received */
+  unsigned long batches;	/* batches received */
+  unsigned long updates;	/* updates received in batches */
+  unsigned long unknown;	/* batched updates for unknown neighbors */
+  unsigned long changes;	/* neighbor cost changes from batches */
+  struct thread_hist size;	/* updates per batch */
+  struct thread_hist apply;	/* usec spent applying a batch */
+  struct thread_hist latency;	/* usec from zebra receipt to applied */
+  unsigned long unrouted;	/* cost changes that changed no route */
+  struct thread_hist stage[OSPF6_LINKMETRICS_STAGE_MAX];
+} lmstats;
+
+static const char *ospf6_linkmetrics_stage_name[OSPF6_LINKMETRICS_STAGE_MAX] =
+{
+  "Cost change",
+  "Router-LSA",
+  "SPF",
+  "FIB update",
+};
+
+/* The oldest link metrics event each stage is still to complete for,
+   and the route update count when the SPF stage was entered.  Each
+   stage is entered when the one before it completes. */
+static struct timeval lmstage[OSPF6_LINKMETRICS_STAGE_MAX];
+static unsigned long lmstage_route_requests;
+
+static void
+ospf6_linkmetrics_stage_add (enum ospf6_linkmetrics_stage stage,
+			     const struct timeval *stamp)
+{
+  struct timeval now;
+  long usec;
+
+  quagga_gettime (QUAGGA_CLK_REALTIME, &now);
+  usec = (now.tv_sec - stamp->tv_sec) * 1000000L +
+    (now.tv_usec - stamp->tv_usec);
+  thread_hist_add (&lmstats.stage[stage], usec > 0 ? usec : 0);
+}
+
+static void
+ospf6_linkmetrics_stage_enter (enum ospf6_linkmetrics_stage stage,
+			       const struct timeval *stamp)
+{
+  /* keep timing from an older event still waiting for this stage */
+  if (timerisset (&lmstage[stage]))
+    return;
+
+  lmstage[stage] = *stamp;
+  if (stage == OSPF6_LINKMETRICS_STAGE_SPF)
+    lmstage_route_requests = ospf6_zebra_route_requests ();
+}
+
+/* A link metrics event stamped with the given wall clock time changed
+   neighbor costs. */
+static void
+ospf6_linkmetrics_stage_start (const struct timeval *stamp)
+{
+  ospf6_linkmetrics_stage_add (OSPF6_LINKMETRICS_STAGE_COST, stamp);
+  ospf6_linkmetrics_stage_enter (OSPF6_LINKMETRICS_STAGE_ROUTER_LSA, stamp);
+}
+
+void
+ospf6_linkmetrics_stage_done (enum ospf6_linkmetrics_stage stage)
+{
+  struct timeval stamp = lmstage[stage];
+
+  if (!timerisset (&stamp))
+    return;
+
+  timerclear (&lmstage[stage]);
+  ospf6_linkmetrics_stage_add (stage, &stamp);
+
+  switch (stage)
+    {
+    case OSPF6_LINKMETRICS_STAGE_ROUTER_LSA:
+      ospf6_linkmetrics_stage_enter (OSPF6_LINKMETRICS_STAGE_SPF, &stamp);
+      break;
+
+    case OSPF6_LINKMETRICS_STAGE_SPF:
+      /* the FIB is only timed when the calculation changed routes */
+      if (ospf6_zebra_route_requests () != lmstage_route_requests)
+	ospf6_linkmetrics_stage_enter (OSPF6_LINKMETRICS_STAGE_FIB, &stamp);
+      else
+	lmstats.unrouted++;
+      break;
+
+    default:
+      break;
+    }
+}
+
 static void __attribute__((constructor))
 ospf6_zebra_linkmetrics_init (void)
 {
@@ -159,6 +256,7 @@ ospf6_zebra_linkmetrics (int command, struct zclient *zclient,
   struct zebra_linkmetrics metrics;
   struct ospf6_interface *oi;
   struct ospf6_neighbor *on;
+  struct timeval stamp;
 
   assert (command == ZEBRA_LINKMETRICS_METRICS);
 
@@ -168,6 +266,8 @@ ospf6_zebra_linkmetrics (int command, struct zclient *zclient,
       return -1;
     }
 
+  lmstats.singles++;
+
   if (IS_OSPF6_DEBUG_ZEBRA (RECV))
     {
       zlog_debug ("%s: received link metrics update", __func__);
@@ -197,7 +297,89 @@ ospf6_zebra_linkmetrics (int command, struct zclient *zclient,
       return -1;
     }
 
+  quagga_gettime (QUAGGA_CLK_REALTIME, &stamp);
+  ospf6_interface_neighbor_metric_batch_start (oi);
   ospf6_zebra_update_linkmetrics (on, &metrics);
+  if (ospf6_interface_neighbor_metric_batch_end (oi))
+    ospf6_linkmetrics_stage_start (&stamp);
+
+  return 0;
+}
+
+/* Apply a vector of link metrics updates for one interface, deferring
+   router-LSA origination and SPF scheduling to the end of the batch. */
+int
+ospf6_zebra_linkmetrics_batch (int command, struct zclient *zclient,
+			       zebra_size_t length)
+{
+  struct zebra_linkmetrics metrics[ZAPI_LINKMETRICS_BATCH_MAX];
+  struct ospf6_interface *oi;
+  struct ospf6_neighbor *on;
+  struct timeval stamp, start, end, now;
+  u_int16_t count, i;
+  unsigned int changes;
+  long latency;
+
+  assert (command == ZEBRA_LINKMETRICS_METRICS_BATCH);
+
+  if (zapi_read_linkmetrics_batch (metrics, &count, &stamp,
+				   zclient->ibuf, length))
+    {
+      zlog_err ("%s: zapi_read_linkmetrics_batch() failed", __func__);
+      return -1;
+    }
+
+  if (count == 0)
+    return 0;
+
+  if (IS_OSPF6_DEBUG_ZEBRA (RECV))
+    zlog_debug ("%s: received %u link metrics updates for ifindex %u",
+		__func__, count, metrics[0].ifindex);
+
+  lmstats.batches++;
+  lmstats.updates += count;
+  thread_hist_add (&lmstats.size, count);
+
+  oi = ospf6_interface_lookup_by_ifindex (metrics[0].ifindex);
+  if (oi == NULL)
+    {
+      zlog_err ("%s: unknown interface index: %d",
+		__func__, metrics[0].ifindex);
+      return -1;
+    }
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  ospf6_interface_neighbor_metric_batch_start (oi);
+
+  for (i = 0; i < count; i++)
+    {
+      if (IS_OSPF6_DEBUG_ZEBRA (RECV))
+	zebra_linkmetrics_logdebug (&metrics[i]);
+
+      on = ospf6_neighbor_lookup_by_ifaddr (&metrics[i].nbr_addr6, oi);
+      if (on == NULL)
+	{
+	  lmstats.unknown++;
+	  continue;
+	}
+
+      ospf6_zebra_update_linkmetrics (on, &metrics[i]);
+    }
+
+  changes = ospf6_interface_neighbor_metric_batch_end (oi);
+  lmstats.changes += changes;
+  if (changes)
+    ospf6_linkmetrics_stage_start (&stamp);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &end);
+  thread_hist_add (&lmstats.apply, (end.tv_sec - start.tv_sec) * 1000000L +
+		   (end.tv_usec - start.tv_usec));
+
+  /* zebra stamps batches with the wall clock */
+  quagga_gettime (QUAGGA_CLK_REALTIME, &now);
+  latency = (now.tv_sec - stamp.tv_sec) * 1000000L +
+    (now.tv_usec - stamp.tv_usec);
+  thread_hist_add (&lmstats.latency, latency > 0 ? latency : 0);
 
   return 0;
 }
@@ -250,3 +432,57 @@ ospf6_zebra_linkstatus (int command, struct zclient *zclient,
 
   return 0;
 }
+
+DEFUN (show_ipv6_ospf6_linkmetrics_statistics,
+       show_ipv6_ospf6_linkmetrics_statistics_cmd,
+       "show ipv6 ospf6 linkmetrics statistics",
+       SHOW_STR
+       IP6_STR
+       OSPF6_STR
+       "Link metrics information\n"
+       "Link metrics receive statistics\n")
+{
+  int stage;
+
+  vty_out (vty, "Link metrics from zebra%s", VNL);
+  vty_out (vty, "  Single updates %lu%s", lmstats.singles, VNL);
+  vty_out (vty, "  Batches %lu, with %lu updates, %lu for unknown "
+	   "neighbors, %lu neighbor cost changes%s", lmstats.batches,
+	   lmstats.updates, lmstats.unknown, lmstats.changes, VNL);
+  vty_out (vty, "  %-18s %8s %8s %8s %8s %8s%s", "",
+	   "count", "p50", "p99", "p99.9", "max", VNL);
+  vty_out_thread_hist_row (vty, "Batch size", &lmstats.size);
+  vty_out_thread_hist_row (vty, "Apply time (usec)", &lmstats.apply);
+  vty_out_thread_hist_row (vty, "Latency (usec)", &lmstats.latency);
+  vty_out (vty, "Cost pipeline latency (usec) from link metrics event, "
+	   "%lu cost changes without route changes%s", lmstats.unrouted, VNL);
+  vty_out (vty, "  %-18s %8s %8s %8s %8s %8s%s", "",
+	   "count", "p50", "p99", "p99.9", "max", VNL);
+  for (stage = 0; stage < OSPF6_LINKMETRICS_STAGE_MAX; stage++)
+    vty_out_thread_hist_row (vty, ospf6_linkmetrics_stage_name[stage],
+			     &lmstats.stage[stage]);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (clear_ipv6_ospf6_linkmetrics_statistics,
+       clear_ipv6_ospf6_linkmetrics_statistics_cmd,
+       "clear ipv6 ospf6 linkmetrics statistics",
+       CLEAR_STR
+       IP6_STR
+       OSPF6_STR
+       "Link metrics information\n"
+       "Link metrics receive statistics\n")
+{
+  memset (&lmstats, 0, sizeof (lmstats));
+  memset (lmstage, 0, sizeof (lmstage));
+  return CMD_SUCCESS;
+}
+
+void
+ospf6_zebra_linkmetrics_cmd_init (void)
+{
+  install_element (VIEW_NODE, &show_ipv6_ospf6_linkmetrics_statistics_cmd);
+  install_element (ENABLE_NODE, &show_ipv6_ospf6_linkmetrics_statistics_cmd);
+  install_element (ENABLE_NODE, &clear_ipv6_ospf6_linkmetrics_statistics_cmd);
+}
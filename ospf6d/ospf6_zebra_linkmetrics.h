@@ -30,6 +30,17 @@ struct zebra_linkmetrics;
 struct zebra_linkstatus;
 struct zclient;
 
+/* Stages of the cost pipeline, timed from the link metrics event that
+   changed a neighbor cost. */
+enum ospf6_linkmetrics_stage
+{
+  OSPF6_LINKMETRICS_STAGE_COST = 0,
+  OSPF6_LINKMETRICS_STAGE_ROUTER_LSA,
+  OSPF6_LINKMETRICS_STAGE_SPF,
+  OSPF6_LINKMETRICS_STAGE_FIB,
+  OSPF6_LINKMETRICS_STAGE_MAX,
+};
+
 typedef void (*linkmetrics_hook_t) (struct ospf6_neighbor *,
 				    struct zebra_linkmetrics *);
 typedef void (*linkstatus_hook_t) (struct ospf6_interface *,
@@ -44,10 +55,16 @@ int ospf6_remove_linkstatus_hook (linkstatus_hook_t hook);
 
 int ospf6_zebra_linkmetrics (int command, struct zclient *zclient,
 			     zebra_size_t length);
+int ospf6_zebra_linkmetrics_batch (int command, struct zclient *zclient,
+				   zebra_size_t length);
 int ospf6_zebra_linkstatus (int command, struct zclient *zclient,
 			    zebra_size_t length);
 
 void ospf6_zebra_update_linkmetrics (struct ospf6_neighbor *on,
 				     struct zebra_linkmetrics *linkmetrics);
 
+void ospf6_linkmetrics_stage_done (enum ospf6_linkmetrics_stage stage);
+
+void ospf6_zebra_linkmetrics_cmd_init (void);
+
 #endif	/* _OSPF6_ZEBRA_LINKMETRICS_H_ */
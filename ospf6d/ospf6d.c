@@ -22,6 +22,7 @@
 #include <zebra.h>
 
 #include "thread.h"
+#include "memory.h"
 #include "linklist.h"
 #include "vty.h"
 #include "command.h"
@@ -165,46 +166,223 @@ parse_type_spec (int argc, const char *argv[])
   return type;
 }
 
-DEFUN (show_ipv6_ospf6_database,
-       show_ipv6_ospf6_database_cmd,
-       "show ipv6 ospf6 database",
-       SHOW_STR
-       IPV6_STR
-       OSPF6_STR
-       "Display Link state database\n"
-      )
+/* "show ipv6 ospf6 database" streams its output, walking the area,
+   interface and AS scoped databases in turn a few LSAs at a time, see
+   vty_walk ().  Nothing is held between steps: the walk keeps the area
+   ID, the ifindex and the key of the last LSA shown, and looks them up
+   again each time, so areas, interfaces and LSAs may come and go in
+   between. */
+struct show_database_walk
 {
   int level;
-  struct listnode *i, *j;
-  struct ospf6 *o = ospf6;
-  struct ospf6_area *oa;
-  struct ospf6_interface *oi;
+  void (*showfunc) (struct vty *, struct ospf6_lsa *);
+  int scope;
+  u_int32_t area_id;
+  unsigned int ifindex;
+  int ifpos;
+  u_int16_t type;
+  u_int32_t id;
+  u_int32_t adv_router;
+};
 
-  OSPF6_CMD_CHECK_RUNNING ();
+#define SHOW_DATABASE_WALK_NONE   0
+#define SHOW_DATABASE_WALK_AREA   1
+#define SHOW_DATABASE_WALK_IF     2
+#define SHOW_DATABASE_WALK_AS     3
 
-  level = parse_show_level (argc, argv);
+#define SHOW_DATABASE_WALK_LSAS 32
 
-  for (ALL_LIST_ELEMENTS_RO (o->area_list, i, oa))
+/* Return the database being walked, if it is still there. */
+static struct ospf6_lsdb *
+show_database_walk_lsdb (struct show_database_walk *walk)
+{
+  struct ospf6_area *oa;
+  struct ospf6_interface *oi;
+
+  switch (walk->scope)
     {
-      vty_out (vty, AREA_LSDB_TITLE_FORMAT, VNL, oa->name, VNL, VNL);
-      ospf6_lsdb_show (vty, level, NULL, NULL, NULL, oa->lsdb);
+    case SHOW_DATABASE_WALK_AREA:
+      oa = ospf6_area_lookup (walk->area_id, ospf6);
+      return oa ? oa->lsdb : NULL;
+    case SHOW_DATABASE_WALK_IF:
+      oi = ospf6_interface_lookup_by_ifindex (walk->ifindex);
+      return oi ? oi->lsdb : NULL;
+    case SHOW_DATABASE_WALK_AS:
+      return ospf6->lsdb;
     }
 
-  for (ALL_LIST_ELEMENTS_RO (o->area_list, i, oa))
+  return NULL;
+}
+
+/* Return the first area after the one the walk is in, areas being kept
+   sorted by ID. */
+static struct ospf6_area *
+show_database_walk_next_area (struct show_database_walk *walk, int first)
+{
+  struct listnode *node;
+  struct ospf6_area *oa;
+
+  for (ALL_LIST_ELEMENTS_RO (ospf6->area_list, node, oa))
+    if (first || ntohl (oa->area_id) > ntohl (walk->area_id))
+      return oa;
+  return NULL;
+}
+
+/* Return the interface of OA that follows the one the walk is on, or
+   its first one if ifpos is -1.  Should the walk's interface have gone,
+   the one now at its position is next. */
+static struct ospf6_interface *
+show_database_walk_next_if (struct show_database_walk *walk,
+                            struct ospf6_area *oa)
+{
+  struct listnode *node;
+  struct ospf6_interface *oi;
+  int pos = 0;
+
+  if (walk->ifpos >= 0)
+    for (ALL_LIST_ELEMENTS_RO (oa->if_list, node, oi))
+      {
+        if (oi->interface->ifindex == walk->ifindex)
+          {
+            walk->ifpos = pos + 1;
+            break;
+          }
+        pos++;
+      }
+  else
+    walk->ifpos = 0;
+
+  pos = 0;
+  for (ALL_LIST_ELEMENTS_RO (oa->if_list, node, oi))
+    if (pos++ == walk->ifpos)
+      return oi;
+  return NULL;
+}
+
+/* Move on to the next database and output its title.  Returns 0 once
+   all of them have been shown. */
+static int
+show_database_walk_next (struct vty *vty, struct show_database_walk *walk)
+{
+  struct ospf6_area *oa;
+  struct ospf6_interface *oi;
+
+  switch (walk->scope)
     {
-      for (ALL_LIST_ELEMENTS_RO (oa->if_list, j, oi))
+    case SHOW_DATABASE_WALK_NONE:
+    case SHOW_DATABASE_WALK_AREA:
+      oa = show_database_walk_next_area (walk,
+                                         walk->scope == SHOW_DATABASE_WALK_NONE);
+      if (oa)
+        {
+          walk->scope = SHOW_DATABASE_WALK_AREA;
+          walk->area_id = oa->area_id;
+          vty_out (vty, AREA_LSDB_TITLE_FORMAT, VNL, oa->name, VNL, VNL);
+          break;
+        }
+      /* Interfaces start over from the first area. */
+      oa = show_database_walk_next_area (walk, 1);
+      walk->scope = SHOW_DATABASE_WALK_IF;
+      walk->ifpos = -1;
+      if (oa)
+        walk->area_id = oa->area_id;
+      /* fall through */
+    case SHOW_DATABASE_WALK_IF:
+      oi = NULL;
+      oa = ospf6_area_lookup (walk->area_id, ospf6);
+      if (oa)
+        oi = show_database_walk_next_if (walk, oa);
+      while (oi == NULL && (oa = show_database_walk_next_area (walk, 0)))
         {
+          walk->area_id = oa->area_id;
+          walk->ifpos = -1;
+          oi = show_database_walk_next_if (walk, oa);
+        }
+      if (oi)
+        {
+          walk->ifindex = oi->interface->ifindex;
           vty_out (vty, IF_LSDB_TITLE_FORMAT, VNL,
                    oi->interface->name, oa->name, VNL, VNL);
-          ospf6_lsdb_show (vty, level, NULL, NULL, NULL, oi->lsdb);
+          break;
         }
+      walk->scope = SHOW_DATABASE_WALK_AS;
+      vty_out (vty, AS_LSDB_TITLE_FORMAT, VNL, VNL, VNL);
+      break;
+    case SHOW_DATABASE_WALK_AS:
+      return 0;
     }
 
-  vty_out (vty, AS_LSDB_TITLE_FORMAT, VNL, VNL, VNL);
-  ospf6_lsdb_show (vty, level, NULL, NULL, NULL, o->lsdb);
+  if (walk->level == OSPF6_LSDB_SHOW_LEVEL_NORMAL)
+    ospf6_lsa_show_summary_header (vty);
 
-  vty_out (vty, "%s", VNL);
-  return CMD_SUCCESS;
+  /* No LSA has type 0, so the database is walked from its head. */
+  walk->type = 0;
+  walk->id = 0;
+  walk->adv_router = 0;
+  return 1;
+}
+
+static void
+show_database_walk_free (void *arg)
+{
+  XFREE (MTYPE_TMP, arg);
+}
+
+static int
+show_database_walk (struct vty *vty, void *arg)
+{
+  struct show_database_walk *walk = arg;
+  struct ospf6_lsdb *lsdb;
+  struct ospf6_lsa *lsa;
+  int n = 0;
+
+  if (ospf6 == NULL)
+    return 0;
+
+  lsdb = show_database_walk_lsdb (walk);
+  while (n < SHOW_DATABASE_WALK_LSAS)
+    {
+      lsa = ospf6_lsdb_lookup_after (walk->type, walk->id,
+                                     walk->adv_router, lsdb);
+      if (lsa == NULL)
+        {
+          if (! show_database_walk_next (vty, walk))
+            {
+              vty_out (vty, "%s", VNL);
+              return 0;
+            }
+          lsdb = show_database_walk_lsdb (walk);
+          continue;
+        }
+
+      (*walk->showfunc) (vty, lsa);
+      walk->type = lsa->header->type;
+      walk->id = lsa->header->id;
+      walk->adv_router = lsa->header->adv_router;
+      n++;
+    }
+
+  return 1;
+}
+
+DEFUN (show_ipv6_ospf6_database,
+       show_ipv6_ospf6_database_cmd,
+       "show ipv6 ospf6 database",
+       SHOW_STR
+       IPV6_STR
+       OSPF6_STR
+       "Display Link state database\n"
+      )
+{
+  struct show_database_walk *walk;
+
+  OSPF6_CMD_CHECK_RUNNING ();
+
+  walk = XCALLOC (MTYPE_TMP, sizeof (struct show_database_walk));
+  walk->level = parse_show_level (argc, argv);
+  walk->showfunc = ospf6_lsdb_show_func (walk->level);
+
+  return vty_walk (vty, show_database_walk, show_database_walk_free, walk);
 }
 
 ALIAS (show_ipv6_ospf6_database,
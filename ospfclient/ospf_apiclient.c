@@ -421,6 +421,46 @@ out:
   return rc;
 }
 
+/*
+ * Synchronous request to synchronize with OSPF's LSDB in bulk.
+ * Same as above, but the LSDB and later changes to it are
+ * received packed into bulk messages.
+ */
+int
+ospf_apiclient_sync_lsdb_bulk (struct ospf_apiclient *oclient)
+{
+  struct msg *msg;
+  int rc;
+  struct lsa_filter_type filter;
+
+  filter.typemask = 0xFFFF;	/* all LSAs */
+  filter.origin = ANY_ORIGIN;
+  filter.num_areas = 0;		/* all Areas. */
+
+  msg = new_msg_register_event (ospf_apiclient_get_seqnr (), &filter);
+  if (!msg)
+    {
+      fprintf (stderr, "new_msg_register_event failed\n");
+      return -1;
+    }
+  rc = ospf_apiclient_send_request (oclient, msg);
+
+  if (rc != 0)
+    goto out;
+
+  msg = new_msg_sync_lsdb_bulk (ospf_apiclient_get_seqnr (), &filter);
+  if (!msg)
+    {
+      fprintf (stderr, "new_msg_sync_lsdb_bulk failed\n");
+      return -1;
+    }
+  oclient->bulk_synced = 0;
+  rc = ospf_apiclient_send_request (oclient, msg);
+
+out:
+  return rc;
+}
+
 /* 
  * Synchronous request to originate or update an LSA.
  */
@@ -634,6 +674,75 @@ ospf_apiclient_handle_lsa_delete (struct ospf_apiclient *oclient,
   XFREE (MTYPE_OSPF_APICLIENT, lsa);
 }
 
+static void
+ospf_apiclient_handle_lsa_bulk (struct ospf_apiclient *oclient,
+				struct msg *msg)
+{
+  struct msg_lsa_bulk_notify *bn;
+  struct msg_lsa_bulk_entry *be;
+  u_char *p, *end;
+  u_int32_t watermark;
+  u_int16_t lsalen;
+  int len;
+  int count;
+
+  if (ntohs (msg->hdr.msglen) < sizeof (struct msg_lsa_bulk_notify))
+    {
+      fprintf (stderr, "LSA bulk: Message too short\n");
+      return;
+    }
+
+  bn = (struct msg_lsa_bulk_notify *) STREAM_DATA (msg->s);
+  watermark = ntohl (bn->watermark);
+
+  /* Changes are only meaningful on top of the snapshot they follow. */
+  if (!(bn->flags & OSPF_API_BULK_SNAPSHOT) && oclient->bulk_synced
+      && watermark != oclient->bulk_watermark + 1)
+    fprintf (stderr, "LSA bulk: Watermark %u follows %u, resync needed\n",
+	     watermark, oclient->bulk_watermark);
+  oclient->bulk_watermark = watermark;
+
+  p = (u_char *) (bn + 1);
+  end = STREAM_DATA (msg->s) + ntohs (msg->hdr.msglen);
+
+  /* The LSAs are handed to the callbacks in place, entries are
+     aligned to four octets. */
+  for (count = ntohs (bn->count); count > 0; count--)
+    {
+      be = (struct msg_lsa_bulk_entry *) p;
+      if (p + sizeof (struct msg_lsa_bulk_entry) > end)
+	break;
+      lsalen = ntohs (be->data.length);
+      len = (sizeof (struct msg_lsa_bulk_entry) - sizeof (struct lsa_header)
+	     + lsalen + 3) & ~3;
+      if (lsalen < OSPF_LSA_HEADER_SIZE || p + len > end)
+	break;
+
+      if (be->msgtype == MSG_LSA_DELETE_NOTIFY)
+	{
+	  if (oclient->delete_notify)
+	    (oclient->delete_notify) (be->ifaddr, be->area_id,
+				      be->is_self_originated, &be->data);
+	}
+      else if (oclient->update_notify)
+	(oclient->update_notify) (be->ifaddr, be->area_id,
+				  be->is_self_originated, &be->data);
+
+      p += len;
+    }
+
+  if (count > 0)
+    fprintf (stderr, "LSA bulk: Truncated message, %d LSA(s) lost\n",
+	     count);
+
+  if (bn->flags & OSPF_API_BULK_SNAPSHOT_END)
+    {
+      oclient->bulk_synced = 1;
+      if (oclient->sync_done)
+	(oclient->sync_done) (watermark);
+    }
+}
+
 static void
 ospf_apiclient_msghandle (struct ospf_apiclient *oclient, struct msg *msg)
 {
@@ -661,6 +770,9 @@ ospf_apiclient_msghandle (struct ospf_apiclient *oclient, struct msg *msg)
     case MSG_LSA_DELETE_NOTIFY:
       ospf_apiclient_handle_lsa_delete (oclient, msg);
       break;
+    case MSG_LSA_BULK_NOTIFY:
+      ospf_apiclient_handle_lsa_bulk (oclient, msg);
+      break;
     default:
       fprintf (stderr, "ospf_apiclient_read: Unknown message type: %d\n",
 	       msg->hdr.msgtype);
@@ -717,6 +829,15 @@ ospf_apiclient_register_callback (struct ospf_apiclient *oclient,
   oclient->delete_notify = delete_notify;
 }
 
+void
+ospf_apiclient_register_sync_done (struct ospf_apiclient *oclient,
+				   void (*sync_done) (u_int32_t watermark))
+{
+  assert (oclient);
+
+  oclient->sync_done = sync_done;
+}
+
 /* -----------------------------------------------------------
  * Asynchronous message handling
  * -----------------------------------------------------------
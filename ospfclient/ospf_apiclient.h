@@ -48,6 +48,12 @@ struct ospf_apiclient
   void (*delete_notify) (struct in_addr ifaddr, struct in_addr area_id,
 			 u_char self_origin,
 			 struct lsa_header * lsa);
+  void (*sync_done) (u_int32_t watermark);
+
+  /* Watermark of the last bulk LSA message received, and whether a
+     bulk snapshot was completed. */
+  u_int32_t bulk_watermark;
+  u_char bulk_synced;
 };
 
 
@@ -113,6 +119,18 @@ void ospf_apiclient_register_callback (struct ospf_apiclient *oclient,
 /* Synchronous request to synchronize LSDB. */
 int ospf_apiclient_sync_lsdb (struct ospf_apiclient *oclient);
 
+/* Synchronous request to synchronize LSDB in bulk.  The snapshot and
+   the changes after it arrive as bulk messages on the async channel,
+   ospf_apiclient_handle_async() hands their LSAs one by one to the
+   update and delete callbacks, and calls sync_done once the snapshot
+   is complete. */
+int ospf_apiclient_sync_lsdb_bulk (struct ospf_apiclient *oclient);
+
+/* Register callback for the end of a bulk LSDB snapshot. */
+void ospf_apiclient_register_sync_done (struct ospf_apiclient *oclient,
+					void (*sync_done) (u_int32_t
+							   watermark));
+
 /* Synchronous request to originate or update opaque LSA. */
 int
 ospf_apiclient_lsa_originate(struct ospf_apiclient *oclient,
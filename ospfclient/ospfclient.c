@@ -196,6 +196,13 @@ lsa_delete_callback (struct in_addr ifaddr, struct in_addr area_id,
   ospf_lsa_header_dump (lsa);
 }
 
+static void
+sync_done_callback (u_int32_t watermark)
+{
+  printf ("sync_done_callback: LSDB snapshot complete at watermark %u\n",
+	  watermark);
+}
+
 static void
 ready_callback (u_char lsa_type, u_char opaque_type, struct in_addr addr)
 {
@@ -310,13 +317,14 @@ main (int argc, char *argv[])
 				    nsm_change_callback,
 				    lsa_update_callback, 
 				    lsa_delete_callback);
+  ospf_apiclient_register_sync_done (oclient, sync_done_callback);
 
   /* Register LSA type and opaque type. */
   ospf_apiclient_register_opaque_type (oclient, atoi (args[2]),
 				       atoi (args[3]));
 
-  /* Synchronize database with OSPF daemon. */
-  ospf_apiclient_sync_lsdb (oclient);
+  /* Synchronize database with OSPF daemon, LSAs arrive in bulk. */
+  ospf_apiclient_sync_lsdb_bulk (oclient);
 
   /* Schedule thread that handles asynchronous messages */
   thread_add_read (master, lsa_read, oclient, oclient->fd_async);
@@ -145,6 +145,7 @@ ospf_api_typename (int msgtype)
     { MSG_SYNC_LSDB,             "Sync LSDB",              },
     { MSG_ORIGINATE_REQUEST,     "Originate request",      },
     { MSG_DELETE_REQUEST,        "Delete request",         },
+    { MSG_SYNC_LSDB_BULK,        "Bulk sync LSDB",         },
     { MSG_REPLY,                 "Reply",                  },
     { MSG_READY_NOTIFY,          "Ready notify",           },
     { MSG_LSA_UPDATE_NOTIFY,     "LSA update notify",      },
@@ -153,6 +154,7 @@ ospf_api_typename (int msgtype)
     { MSG_DEL_IF,                "Del interface",          },
     { MSG_ISM_CHANGE,            "ISM change",             },
     { MSG_NSM_CHANGE,            "NSM change",             },
+    { MSG_LSA_BULK_NOTIFY,       "LSA bulk notify",        },
   };
 
   int i, n = sizeof (NameTab) / sizeof (NameTab[0]);
@@ -344,7 +346,7 @@ msg_read (int fd)
 {
   struct msg *msg;
   struct apimsghdr hdr;
-  u_char buf[OSPF_API_MAX_MSG_SIZE];
+  u_char buf[OSPF_API_MAX_BULK_SIZE];
   int bodylen;
   int rlen;
 
@@ -376,6 +378,11 @@ msg_read (int fd)
 
   /* Determine body length. */
   bodylen = ntohs (hdr.msglen);
+  if (bodylen > (int) sizeof (buf))
+    {
+      zlog_warn ("msg_read: Message body too long (%d)", bodylen);
+      return NULL;
+    }
   if (bodylen > 0)
     {
 
@@ -407,7 +414,7 @@ msg_read (int fd)
 int
 msg_write (int fd, struct msg *msg)
 {
-  u_char buf[OSPF_API_MAX_MSG_SIZE];
+  u_char buf[sizeof (struct apimsghdr) + OSPF_API_MAX_BULK_SIZE];
   int l;
   int wlen;
 
@@ -416,6 +423,11 @@ msg_write (int fd, struct msg *msg)
 
   /* Length of message including header */
   l = sizeof (struct apimsghdr) + ntohs (msg->hdr.msglen);
+  if (l > (int) sizeof (buf))
+    {
+      zlog_warn ("msg_write: Message too long (%d)", l);
+      return -1;
+    }
 
   /* Make contiguous memory buffer for message */
   memcpy (buf, &msg->hdr, sizeof (struct apimsghdr));
@@ -475,8 +487,9 @@ new_msg_register_event (u_int32_t seqnum, struct lsa_filter_type *filter)
   return msg_new (MSG_REGISTER_EVENT, emsg, seqnum, len);
 }
 
-struct msg *
-new_msg_sync_lsdb (u_int32_t seqnum, struct lsa_filter_type *filter)
+static struct msg *
+new_msg_sync_lsdb_type (u_char msgtype, u_int32_t seqnum,
+			struct lsa_filter_type *filter)
 {
   u_char buf[OSPF_API_MAX_MSG_SIZE];
   struct msg_sync_lsdb *smsg;
@@ -488,7 +501,19 @@ new_msg_sync_lsdb (u_int32_t seqnum, struct lsa_filter_type *filter)
   smsg->filter.typemask = htons (filter->typemask);
   smsg->filter.origin = filter->origin;
   smsg->filter.num_areas = filter->num_areas;
-  return msg_new (MSG_SYNC_LSDB, smsg, seqnum, len);
+  return msg_new (msgtype, smsg, seqnum, len);
+}
+
+struct msg *
+new_msg_sync_lsdb (u_int32_t seqnum, struct lsa_filter_type *filter)
+{
+  return new_msg_sync_lsdb_type (MSG_SYNC_LSDB, seqnum, filter);
+}
+
+struct msg *
+new_msg_sync_lsdb_bulk (u_int32_t seqnum, struct lsa_filter_type *filter)
+{
+  return new_msg_sync_lsdb_type (MSG_SYNC_LSDB_BULK, seqnum, filter);
 }
 
 
@@ -638,4 +663,75 @@ new_msg_lsa_change_notify (u_char msgtype,
   return msg_new (msgtype, nmsg, seqnum, len);
 }
 
+/* Start an empty bulk LSA message.  Its stream has room for
+   OSPF_API_MAX_BULK_SIZE octets, msg_dup() makes a compact copy. */
+struct msg *
+new_msg_lsa_bulk_notify (u_int32_t seqnum, u_int32_t watermark,
+			 u_char flags)
+{
+  struct msg *new;
+
+  new = XCALLOC (MTYPE_OSPF_API_MSG, sizeof (struct msg));
+
+  new->hdr.version = OSPF_API_VERSION;
+  new->hdr.msgtype = MSG_LSA_BULK_NOTIFY;
+  new->hdr.msgseq = htonl (seqnum);
+
+  new->s = stream_new (OSPF_API_MAX_BULK_SIZE);
+  stream_putl (new->s, watermark);
+  stream_putw (new->s, 0);
+  stream_putc (new->s, flags);
+  stream_putc (new->s, 0);
+  new->hdr.msglen = htons (stream_get_endp (new->s));
+
+  return new;
+}
+
+int
+msg_lsa_bulk_add (struct msg *msg, u_char msgtype, struct in_addr ifaddr,
+		  struct in_addr area_id, u_char is_self_originated,
+		  struct lsa_header *data)
+{
+  size_t lsalen, len;
+
+  assert (msg->hdr.msgtype == MSG_LSA_BULK_NOTIFY);
+
+  lsalen = ntohs (data->length);
+  len = sizeof (struct msg_lsa_bulk_entry) - sizeof (struct lsa_header)
+    + lsalen;
+  len = (len + 3) & ~3;
+
+  if (STREAM_WRITEABLE (msg->s) < len)
+    return -1;
+
+  stream_put_in_addr (msg->s, &ifaddr);
+  stream_put_in_addr (msg->s, &area_id);
+  stream_putc (msg->s, msgtype);
+  stream_putc (msg->s, is_self_originated);
+  stream_putw (msg->s, 0);
+  stream_put (msg->s, data, lsalen);
+  while (stream_get_endp (msg->s) & 3)
+    stream_putc (msg->s, 0);
+
+  stream_putw_at (msg->s, offsetof (struct msg_lsa_bulk_notify, count),
+		  msg_lsa_bulk_count (msg) + 1);
+  msg->hdr.msglen = htons (stream_get_endp (msg->s));
+
+  return 0;
+}
+
+u_int16_t
+msg_lsa_bulk_count (struct msg *msg)
+{
+  return stream_getw_from (msg->s,
+			   offsetof (struct msg_lsa_bulk_notify, count));
+}
+
+void
+msg_lsa_bulk_set_flags (struct msg *msg, u_char flags)
+{
+  stream_putc_at (msg->s, offsetof (struct msg_lsa_bulk_notify, flags),
+		  flags);
+}
+
 #endif /* SUPPORT_OSPF_API */
@@ -116,6 +116,7 @@ extern void msg_fifo_free (struct msg_fifo *fifo);
 #define MSG_SYNC_LSDB             4
 #define MSG_ORIGINATE_REQUEST     5
 #define MSG_DELETE_REQUEST        6
+#define MSG_SYNC_LSDB_BULK        7
 
 /* Messages from OSPF daemon. */
 #define MSG_REPLY                10
@@ -126,6 +127,7 @@ extern void msg_fifo_free (struct msg_fifo *fifo);
 #define MSG_DEL_IF               15
 #define MSG_ISM_CHANGE           16
 #define MSG_NSM_CHANGE           17
+#define MSG_LSA_BULK_NOTIFY      18
 
 struct msg_register_opaque_type
 {
@@ -274,6 +276,36 @@ struct msg_nsm_change
   u_char pad[3];
 };
 
+/* Bulk LSA message, sent in reply to MSG_SYNC_LSDB_BULK and from then
+   on in place of individual update and delete notifies.  The header is
+   followed by "count" entries of struct msg_lsa_bulk_entry, each
+   carrying a complete LSA and padded to four octets.  The watermark
+   is incremented by one with every bulk message sent to a client, the
+   snapshot ends with the message flagged OSPF_API_BULK_SNAPSHOT_END
+   and the changes that follow carry the watermarks after it. */
+struct msg_lsa_bulk_notify
+{
+  u_int32_t watermark;		/* Bulk message sequence number */
+  u_int16_t count;		/* Number of entries */
+  u_char flags;
+#define OSPF_API_BULK_SNAPSHOT      0x01	/* Part of an LSDB snapshot */
+#define OSPF_API_BULK_SNAPSHOT_END  0x02	/* Last snapshot message */
+  u_char pad;
+};
+
+struct msg_lsa_bulk_entry
+{
+  struct in_addr ifaddr;	/* Used for LSA type 9 otherwise ignored */
+  struct in_addr area_id;	/* Not valid for AS-External and Opaque11 */
+  u_char msgtype;		/* MSG_LSA_UPDATE_NOTIFY or _DELETE_NOTIFY */
+  u_char is_self_originated;	/* 1 if self originated. */
+  u_char pad[2];
+  struct lsa_header data;
+};
+
+/* Bulk messages may grow past OSPF_API_MAX_MSG_SIZE, up to this. */
+#define OSPF_API_MAX_BULK_SIZE  16384
+
 /* We make use of a union to define a structure that covers all
    possible API messages. This allows us to find out how much memory
    needs to be reserved for the largest API message. */
@@ -294,6 +326,7 @@ struct apimsg
     struct msg_ism_change ism_change;
     struct msg_nsm_change nsm_change;
     struct msg_lsa_change_notify lsa_change_notify;
+    struct msg_lsa_bulk_notify lsa_bulk_notify;
   }
   u;
 };
@@ -315,6 +348,8 @@ extern struct msg *new_msg_register_event (u_int32_t seqnum,
 					   struct lsa_filter_type *filter);
 extern struct msg *new_msg_sync_lsdb (u_int32_t seqnum,
 				      struct lsa_filter_type *filter);
+extern struct msg *new_msg_sync_lsdb_bulk (u_int32_t seqnum,
+					   struct lsa_filter_type *filter);
 extern struct msg *new_msg_originate_request (u_int32_t seqnum,
 					      struct in_addr ifaddr,
 					      struct in_addr area_id,
@@ -354,6 +389,18 @@ extern struct msg *new_msg_lsa_change_notify (u_char msgtype,
 					      u_char is_self_originated,
 					      struct lsa_header *data);
 
+/* Bulk LSA messages are built up one LSA at a time.  msg_lsa_bulk_add
+   returns -1 when the LSA does not fit anymore. */
+extern struct msg *new_msg_lsa_bulk_notify (u_int32_t seqnum,
+					    u_int32_t watermark,
+					    u_char flags);
+extern int msg_lsa_bulk_add (struct msg *msg, u_char msgtype,
+			     struct in_addr ifaddr, struct in_addr area_id,
+			     u_char is_self_originated,
+			     struct lsa_header *data);
+extern u_int16_t msg_lsa_bulk_count (struct msg *msg);
+extern void msg_lsa_bulk_set_flags (struct msg *msg, u_char flags);
+
 /* string printing functions */
 extern const char *ospf_api_errname (int errcode);
 extern const char *ospf_api_typename (int msgtype);
@@ -38,6 +38,7 @@
 #include "log.h"
 #include "thread.h"
 #include "hash.h"
+#include "jhash.h"
 #include "sockunion.h"		/* for inet_aton() */
 #include "buffer.h"
 
@@ -62,6 +63,8 @@
 #include "ospfd/ospf_api.h"
 #include "ospfd/ospf_apiserver.h"
 
+static void apiserver_delta_clear (struct ospf_apiserver *apiserv);
+
 /* This is an implementation of an API to the OSPF daemon that allows
  * external applications to access the OSPF daemon through socket
  * connections. The application can use this API to inject its own
@@ -288,6 +291,13 @@ ospf_apiserver_new (int fd_sync, int fd_async)
   new->t_sync_write = NULL;
   new->t_async_write = NULL;
 
+  new->bulk = 0;
+  new->bulk_watermark = 0;
+  new->delta_hash = NULL;
+  new->delta_list = NULL;
+  new->delta_coalesced = 0;
+  new->t_delta_flush = NULL;
+
   new->filter->typemask = 0;	/* filter all LSAs */
   new->filter->origin = ANY_ORIGIN;
   new->filter->num_areas = 0;
@@ -363,6 +373,13 @@ ospf_apiserver_free (struct ospf_apiserver *apiserv)
       thread_cancel (apiserv->t_async_write);
     }
 
+  /* Drop LSA changes not sent yet. */
+  apiserver_delta_clear (apiserv);
+  if (apiserv->delta_hash)
+    hash_free (apiserv->delta_hash);
+  if (apiserv->delta_list)
+    list_delete (apiserv->delta_list);
+
   /* Unregister all opaque types that application registered 
      and flush opaque LSAs if still in LSDB. */
 
@@ -791,6 +808,7 @@ ospf_apiserver_send_msg (struct ospf_apiserver *apiserv, struct msg *msg)
     case MSG_DEL_IF:
     case MSG_ISM_CHANGE:
     case MSG_NSM_CHANGE:
+    case MSG_LSA_BULK_NOTIFY:
       fifo = apiserv->out_async_fifo;
       fd = apiserv->fd_async;
       event = OSPF_APISERVER_ASYNC_WRITE;
@@ -862,6 +880,9 @@ ospf_apiserver_handle_msg (struct ospf_apiserver *apiserv, struct msg *msg)
     case MSG_SYNC_LSDB:
       rc = ospf_apiserver_handle_sync_lsdb (apiserv, msg);
       break;
+    case MSG_SYNC_LSDB_BULK:
+      rc = ospf_apiserver_handle_sync_lsdb_bulk (apiserv, msg);
+      break;
     case MSG_ORIGINATE_REQUEST:
       rc = ospf_apiserver_handle_originate_request (apiserv, msg);
       break;
@@ -1335,19 +1356,14 @@ out:
   return rc;
 }
 
-int
-ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
-				 struct msg *msg)
+/* Call the given function for every LSA selected by the LSDB sync
+   request's area list and type mask. */
+static void
+apiserver_sync_lsdb_walk (struct msg_sync_lsdb *smsg,
+			  int (*callback) (struct ospf_lsa *, void *, int),
+			  void *p_arg, int int_arg)
 {
   struct listnode *node, *nnode;
-  u_int32_t seqnum;
-  int rc = 0;
-  struct msg_sync_lsdb *smsg;
-  struct ospf_apiserver_param_t
-  {
-    struct ospf_apiserver *apiserv;
-    struct lsa_filter_type *filter;
-  } param;
   u_int16_t mask;
   struct route_node *rn;
   struct ospf_lsa *lsa;
@@ -1356,15 +1372,6 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 
   ospf = ospf_lookup ();
 
-  /* Get request sequence number */
-  seqnum = msg_get_seq (msg);
-  /* Set sync msg. */
-  smsg = (struct msg_sync_lsdb *) STREAM_DATA (msg->s);
-
-  /* Set parameter struct. */
-  param.apiserv = apiserv;
-  param.filter = &smsg->filter;
-
   /* Remember mask. */
   mask = ntohs (smsg->filter.typemask);
 
@@ -1401,22 +1408,22 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 	  /* Check msg type. */
 	  if (mask & Power2[OSPF_ROUTER_LSA])
 	    LSDB_LOOP (ROUTER_LSDB (area), rn, lsa)
-	      apiserver_sync_callback(lsa, (void *) &param, seqnum);
+	      callback (lsa, p_arg, int_arg);
 	  if (mask & Power2[OSPF_NETWORK_LSA])
             LSDB_LOOP (NETWORK_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
+              callback (lsa, p_arg, int_arg);
 	  if (mask & Power2[OSPF_SUMMARY_LSA])
             LSDB_LOOP (SUMMARY_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
+              callback (lsa, p_arg, int_arg);
 	  if (mask & Power2[OSPF_ASBR_SUMMARY_LSA])
             LSDB_LOOP (ASBR_SUMMARY_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
+              callback (lsa, p_arg, int_arg);
 	  if (mask & Power2[OSPF_OPAQUE_LINK_LSA])
             LSDB_LOOP (OPAQUE_LINK_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
+              callback (lsa, p_arg, int_arg);
 	  if (mask & Power2[OSPF_OPAQUE_AREA_LSA])
             LSDB_LOOP (OPAQUE_AREA_LSDB (area), rn, lsa)
-              apiserver_sync_callback(lsa, (void *) &param, seqnum);
+              callback (lsa, p_arg, int_arg);
 	}
     }
 
@@ -1425,7 +1432,7 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
     {
       if (mask & Power2[OSPF_AS_EXTERNAL_LSA])
 	LSDB_LOOP (EXTERNAL_LSDB (ospf), rn, lsa)
-	  apiserver_sync_callback(lsa, (void *) &param, seqnum);
+	  callback (lsa, p_arg, int_arg);
     }
 
   /* For AS-external opaque LSAs */
@@ -1433,8 +1440,33 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
     {
       if (mask & Power2[OSPF_OPAQUE_AS_LSA])
 	LSDB_LOOP (OPAQUE_AS_LSDB (ospf), rn, lsa)
-	  apiserver_sync_callback(lsa, (void *) &param, seqnum);
+	  callback (lsa, p_arg, int_arg);
     }
+}
+
+int
+ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
+				 struct msg *msg)
+{
+  u_int32_t seqnum;
+  int rc = 0;
+  struct msg_sync_lsdb *smsg;
+  struct ospf_apiserver_param_t
+  {
+    struct ospf_apiserver *apiserv;
+    struct lsa_filter_type *filter;
+  } param;
+
+  /* Get request sequence number */
+  seqnum = msg_get_seq (msg);
+  /* Set sync msg. */
+  smsg = (struct msg_sync_lsdb *) STREAM_DATA (msg->s);
+
+  /* Set parameter struct. */
+  param.apiserv = apiserv;
+  param.filter = &smsg->filter;
+
+  apiserver_sync_lsdb_walk (smsg, apiserver_sync_callback, &param, seqnum);
 
   /* Send a reply back to client with return code */
   rc = ospf_apiserver_send_reply (apiserv, seqnum, rc);
@@ -1442,6 +1474,268 @@ ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 }
 
 
+/* -----------------------------------------------------------
+ * Followings are functions for bulk LSDB synchronization.
+ * -----------------------------------------------------------
+ */
+
+/* An LSA change waiting to be sent to a bulk client. */
+struct apiserver_delta
+{
+  u_char msgtype;
+  u_char is_self_originated;
+  struct in_addr ifaddr;
+  struct in_addr area_id;
+  struct lsa_header *data;	/* Copy of the latest instance */
+};
+
+static unsigned int
+apiserver_delta_hash_key (void *p)
+{
+  struct apiserver_delta *delta = p;
+
+  return jhash_3words (delta->data->id.s_addr,
+		       delta->data->adv_router.s_addr,
+		       delta->area_id.s_addr ^ delta->ifaddr.s_addr,
+		       delta->data->type);
+}
+
+static int
+apiserver_delta_hash_cmp (const void *p1, const void *p2)
+{
+  const struct apiserver_delta *d1 = p1;
+  const struct apiserver_delta *d2 = p2;
+
+  return (d1->data->type == d2->data->type
+	  && IPV4_ADDR_SAME (&d1->data->id, &d2->data->id)
+	  && IPV4_ADDR_SAME (&d1->data->adv_router, &d2->data->adv_router)
+	  && IPV4_ADDR_SAME (&d1->area_id, &d2->area_id)
+	  && IPV4_ADDR_SAME (&d1->ifaddr, &d2->ifaddr));
+}
+
+static void
+apiserver_delta_free (struct apiserver_delta *delta)
+{
+  XFREE (MTYPE_OSPF_APISERVER, delta->data);
+  XFREE (MTYPE_OSPF_APISERVER, delta);
+}
+
+/* Forget all pending changes. */
+static void
+apiserver_delta_clear (struct ospf_apiserver *apiserv)
+{
+  struct listnode *node, *nnode;
+  struct apiserver_delta *delta;
+
+  if (apiserv->t_delta_flush)
+    {
+      thread_cancel (apiserv->t_delta_flush);
+      apiserv->t_delta_flush = NULL;
+    }
+
+  if (!apiserv->delta_list)
+    return;
+
+  hash_clean (apiserv->delta_hash, NULL);
+  for (ALL_LIST_ELEMENTS (apiserv->delta_list, node, nnode, delta))
+    apiserver_delta_free (delta);
+  list_delete_all_node (apiserv->delta_list);
+}
+
+/* Queue an outgoing bulk message and start a new one after it. */
+static struct msg *
+apiserver_bulk_next (struct ospf_apiserver *apiserv, struct msg *msg,
+		     u_char flags)
+{
+  u_int32_t seqnum = msg_get_seq (msg);
+
+  ospf_apiserver_send_msg (apiserv, msg);
+  msg_free (msg);
+
+  return new_msg_lsa_bulk_notify (seqnum, ++apiserv->bulk_watermark, flags);
+}
+
+/* Add an LSA to the bulk message, sending it first when full. */
+static struct msg *
+apiserver_bulk_add (struct ospf_apiserver *apiserv, struct msg *msg,
+		    u_char msgtype, struct in_addr ifaddr,
+		    struct in_addr area_id, u_char is_self_originated,
+		    struct lsa_header *data, u_char flags)
+{
+  if (msg_lsa_bulk_add (msg, msgtype, ifaddr, area_id,
+			is_self_originated, data) < 0)
+    {
+      msg = apiserver_bulk_next (apiserv, msg, flags);
+      if (msg_lsa_bulk_add (msg, msgtype, ifaddr, area_id,
+			    is_self_originated, data) < 0)
+	zlog_warn ("apiserver_bulk_add: LSA type %d id %s does not fit",
+		   data->type, inet_ntoa (data->id));
+    }
+  return msg;
+}
+
+/* Send all pending changes in as few bulk messages as possible. */
+static int
+apiserver_delta_flush (struct thread *thread)
+{
+  struct ospf_apiserver *apiserv;
+  struct listnode *node, *nnode;
+  struct apiserver_delta *delta;
+  struct msg *msg;
+
+  apiserv = THREAD_ARG (thread);
+  apiserv->t_delta_flush = NULL;
+
+  if (!apiserv->delta_list || !listcount (apiserv->delta_list))
+    return 0;
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("API: Sending %d LSA change(s) to apiserv(%p), "
+		"%lu coalesced so far", listcount (apiserv->delta_list),
+		apiserv, apiserv->delta_coalesced);
+
+  msg = new_msg_lsa_bulk_notify (0, ++apiserv->bulk_watermark, 0);
+
+  for (ALL_LIST_ELEMENTS (apiserv->delta_list, node, nnode, delta))
+    msg = apiserver_bulk_add (apiserv, msg, delta->msgtype, delta->ifaddr,
+			      delta->area_id, delta->is_self_originated,
+			      delta->data, 0);
+
+  ospf_apiserver_send_msg (apiserv, msg);
+  msg_free (msg);
+
+  /* Timer is already cleared above. */
+  apiserver_delta_clear (apiserv);
+  return 0;
+}
+
+/* Queue a change of an LSA for a bulk client.  A change that is still
+   pending for the same LSA is replaced, so that only the latest
+   instance is sent. */
+static void
+apiserver_delta_queue (struct ospf_apiserver *apiserv, u_char msgtype,
+		       struct ospf_lsa *lsa, struct in_addr ifaddr,
+		       struct in_addr area_id)
+{
+  struct apiserver_delta key, *delta;
+  u_int16_t lsalen = ntohs (lsa->data->length);
+
+  key.ifaddr = ifaddr;
+  key.area_id = area_id;
+  key.data = lsa->data;
+
+  delta = hash_lookup (apiserv->delta_hash, &key);
+  if (delta)
+    {
+      XFREE (MTYPE_OSPF_APISERVER, delta->data);
+      apiserv->delta_coalesced++;
+    }
+  else
+    {
+      delta = XCALLOC (MTYPE_OSPF_APISERVER, sizeof (struct apiserver_delta));
+      delta->ifaddr = ifaddr;
+      delta->area_id = area_id;
+      listnode_add (apiserv->delta_list, delta);
+    }
+
+  delta->msgtype = msgtype;
+  delta->is_self_originated = lsa->flags & OSPF_LSA_SELF;
+  delta->data = XMALLOC (MTYPE_OSPF_APISERVER, lsalen);
+  memcpy (delta->data, lsa->data, lsalen);
+
+  /* The hash key is taken from the copy, so insert only now. */
+  hash_get (apiserv->delta_hash, delta, hash_alloc_intern);
+
+  if (listcount (apiserv->delta_list) >= OSPF_APISERVER_DELTA_MAX)
+    {
+      if (apiserv->t_delta_flush)
+	thread_cancel (apiserv->t_delta_flush);
+      apiserv->t_delta_flush =
+	thread_add_event (master, apiserver_delta_flush, apiserv, 0);
+    }
+  else if (!apiserv->t_delta_flush)
+    apiserv->t_delta_flush =
+      thread_add_timer_msec (master, apiserver_delta_flush, apiserv,
+			     OSPF_APISERVER_DELTA_DELAY);
+}
+
+struct apiserver_sync_bulk_param
+{
+  struct ospf_apiserver *apiserv;
+  struct lsa_filter_type *filter;
+  struct msg *msg;		/* Bulk message being filled */
+};
+
+static int
+apiserver_sync_bulk_callback (struct ospf_lsa *lsa, void *p_arg, int int_arg)
+{
+  struct apiserver_sync_bulk_param *param = p_arg;
+  struct in_addr area_id = { .s_addr = 0L };
+  struct in_addr ifaddr = { .s_addr = 0L };
+
+  /* Check origin in filter. */
+  if ((param->filter->origin != ANY_ORIGIN) &&
+      (param->filter->origin != (lsa->flags & OSPF_LSA_SELF)))
+    return 0;
+
+  if (lsa->area)
+    area_id = lsa->area->area_id;
+  if (lsa->data->type == OSPF_OPAQUE_LINK_LSA)
+    ifaddr = lsa->oi->address->u.prefix4;
+
+  param->msg = apiserver_bulk_add (param->apiserv, param->msg,
+				   MSG_LSA_UPDATE_NOTIFY, ifaddr, area_id,
+				   lsa->flags & OSPF_LSA_SELF, lsa->data,
+				   OSPF_API_BULK_SNAPSHOT);
+  return 0;
+}
+
+/* Send the selected part of the LSDB packed into as few bulk messages
+   as possible, the last one flagged as the end of the snapshot.  From
+   then on changes to LSAs are coalesced and sent in bulk as well. */
+int
+ospf_apiserver_handle_sync_lsdb_bulk (struct ospf_apiserver *apiserv,
+				      struct msg *msg)
+{
+  u_int32_t seqnum;
+  struct msg_sync_lsdb *smsg;
+  struct apiserver_sync_bulk_param param;
+
+  seqnum = msg_get_seq (msg);
+  smsg = (struct msg_sync_lsdb *) STREAM_DATA (msg->s);
+
+  /* Pending changes are superseded by the snapshot. */
+  if (!apiserv->bulk)
+    {
+      apiserv->delta_hash = hash_create_size (OSPF_APISERVER_DELTA_MAX,
+					      apiserver_delta_hash_key,
+					      apiserver_delta_hash_cmp);
+      apiserv->delta_list = list_new ();
+      apiserv->bulk = 1;
+    }
+  apiserver_delta_clear (apiserv);
+
+  param.apiserv = apiserv;
+  param.filter = &smsg->filter;
+  param.msg = new_msg_lsa_bulk_notify (seqnum, ++apiserv->bulk_watermark,
+				       OSPF_API_BULK_SNAPSHOT);
+
+  apiserver_sync_lsdb_walk (smsg, apiserver_sync_bulk_callback, &param,
+			    seqnum);
+
+  msg_lsa_bulk_set_flags (param.msg,
+			  OSPF_API_BULK_SNAPSHOT | OSPF_API_BULK_SNAPSHOT_END);
+  ospf_apiserver_send_msg (apiserv, param.msg);
+  msg_free (param.msg);
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("API: Bulk LSDB snapshot to apiserv(%p) ends at %u",
+		apiserv, apiserv->bulk_watermark);
+
+  return ospf_apiserver_send_reply (apiserv, seqnum, OSPF_API_OK);
+}
+
+
 /* -----------------------------------------------------------
  * Followings are functions to originate or update LSA
  * from an application.
@@ -2568,7 +2862,11 @@ apiserver_clients_lsa_change_notify (u_char msgtype, struct ospf_lsa *lsa)
 	      if ((filter->origin == ANY_ORIGIN) ||
 		  (filter->origin == IS_LSA_SELF (lsa)))
 		{
-		  ospf_apiserver_send_msg (apiserv, msg);
+		  if (apiserv->bulk)
+		    apiserver_delta_queue (apiserv, msgtype, lsa,
+					   ifaddr, area_id);
+		  else
+		    ospf_apiserver_send_msg (apiserv, msg);
 		}
 	    }
 	}
@@ -27,6 +27,11 @@
 #define MTYPE_OSPF_APISERVER MTYPE_TMP
 #define MTYPE_OSPF_APISERVER_MSGFILTER MTYPE_TMP
 
+/* Delay before coalesced LSA changes are sent to a bulk client, and
+   the number of pending changes that causes them to be sent at once. */
+#define OSPF_APISERVER_DELTA_DELAY     100	/* msec */
+#define OSPF_APISERVER_DELTA_MAX       4096
+
 /* List of opaque types that application registered */
 struct registered_opaque_type
 {
@@ -69,6 +74,16 @@ struct ospf_apiserver
 #endif /* USE_ASYNC_READ */
   struct thread *t_sync_write;
   struct thread *t_async_write;
+
+  /* Once the client asked for a bulk LSDB snapshot, LSA changes are
+     queued here, a later change to an LSA replacing the pending one,
+     and sent in bulk messages by t_delta_flush. */
+  u_char bulk;
+  u_int32_t bulk_watermark;	/* Watermark of the last bulk message */
+  struct hash *delta_hash;	/* Pending changes by LSA */
+  struct list *delta_list;	/* Pending changes in order of arrival */
+  unsigned long delta_coalesced;	/* Changes replaced before sending */
+  struct thread *t_delta_flush;
 };
 
 enum event
@@ -144,6 +159,8 @@ extern int ospf_apiserver_handle_delete_request (struct ospf_apiserver *apiserv,
 					  struct msg *msg);
 extern int ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 				     struct msg *msg);
+extern int ospf_apiserver_handle_sync_lsdb_bulk (struct ospf_apiserver *apiserv,
+					  struct msg *msg);
 
 
 /* -----------------------------------------------------------
@@ -22,6 +22,10 @@
 
 #include <zebra.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif /* HAVE_PTHREAD */
+
 #include "thread.h"
 #include "memory.h"
 #include "hash.h"
@@ -31,6 +35,7 @@
 #include "table.h"
 #include "vty.h"
 #include "log.h"
+#include "jhash.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_interface.h"
@@ -59,12 +64,12 @@ ospf_find_asbr_route (struct ospf *ospf,
   if (rtrs == NULL)
     return NULL;
 
-  rn = route_node_lookup (rtrs, (struct prefix *) asbr);
+  /* This may run on an ASE calculation thread, so do not touch the
+     node's reference count. */
+  rn = route_node_lookup_nolock (rtrs, (struct prefix *) asbr);
   if (! rn)
     return NULL;
 
-  route_unlock_node (rn);
-
   chosen = list_new ();
 
   /* First try to find intra-area non-bb paths. */
@@ -241,14 +246,15 @@ ospf_ase_calculate_asbr_route (struct ospf *ospf,
 
 static struct ospf_route *
 ospf_ase_calculate_new_route (struct ospf_lsa *lsa,
-			      struct ospf_route *asbr_route, u_int32_t metric)
+			      struct ospf_route *asbr_route, u_int32_t metric,
+			      time_t now)
 {
   struct as_external_lsa *al;
   struct ospf_route *new;
 
   al = (struct as_external_lsa *) lsa->data;
 
-  new = ospf_route_new ();
+  new = ospf_route_new_stamped (now);
 
   /* Set redistributed type -- does make sense? */
   /* new->type = type; */
@@ -283,8 +289,18 @@ ospf_ase_calculate_new_route (struct ospf_lsa *lsa,
 
 #define OSPF_ASE_CALC_INTERVAL 1
 
-int
-ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
+/* Calculate the route described by one external LSA into the table
+   RT.  The intra- and inter-area results in ospf->new_table and
+   ospf->new_rtrs are only read, without locking any of their nodes,
+   so several of these may run at once as long as each has its own
+   RT and no two of them look at LSAs for the same destination.
+   Only debugging, which keeps the calculation serial, logs from here;
+   intra/inter-area nodes found without a route are counted in
+   *NULL_INFO for the caller to report. */
+static int
+ospf_ase_calculate_route_table (struct ospf *ospf, struct ospf_lsa *lsa,
+				struct route_table *rt, time_t now,
+				unsigned long *null_info)
 {
   u_int32_t metric;
   struct as_external_lsa *al;
@@ -404,19 +420,16 @@ ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
       asbr.prefix = al->e[0].fwd_addr;
       asbr.prefixlen = IPV4_MAX_BITLEN;
 
-      rn = route_node_match (ospf->new_table, (struct prefix *) &asbr);
+      rn = route_node_match_nolock (ospf->new_table,
+				    (struct prefix *) &asbr);
       
       if (rn == NULL || (asbr_route = rn->info) == NULL)
 	{
 	  if (IS_DEBUG_OSPF (lsa, LSA))
 	    zlog_debug ("Route[External]: Can't find route to forwarding "
 			"address");
-	  if (rn)
-	    route_unlock_node (rn);
 	  return 0;
 	}
-
-      route_unlock_node (rn);
     }
 
   /* (4) Let X be the cost specified by the preferred routing table
@@ -434,7 +447,7 @@ ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
 	 external metric type is 2, the path-type is set to type 2
 	 external, the link state component of the route's cost is X,
 	 and the type 2 cost is Y. */
-  new = ospf_ase_calculate_new_route (lsa, asbr_route, metric);
+  new = ospf_ase_calculate_new_route (lsa, asbr_route, metric, now);
 
   /* (6) Compare the AS external path described by the LSA with the
          existing paths in N's routing table entry, as follows. If
@@ -450,20 +463,18 @@ ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
 
   /* if there is a Intra/Inter area route to the N
      do not install external route */
-  if ((rn = route_node_lookup (ospf->new_table,
-			      (struct prefix *) &p)))
+  if ((rn = route_node_lookup_nolock (ospf->new_table,
+				     (struct prefix *) &p)))
     {
-      route_unlock_node(rn);
       if (rn->info == NULL)
-	zlog_info ("Route[External]: rn->info NULL");
+	(*null_info)++;
       if (new)
 	ospf_route_free (new);
       return 0;
     }
   /* Find a route to the same dest */
   /* If there is no route, create new one. */
-  if ((rn = route_node_lookup (ospf->new_external_route,
-			       (struct prefix *) &p)))
+  if ((rn = route_node_lookup (rt, (struct prefix *) &p)))
       route_unlock_node(rn);
 
   if (!rn || (or = rn->info) == NULL)
@@ -472,7 +483,7 @@ ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
 	zlog_debug ("Route[External]: Adding a new route %s/%d",
 		    inet_ntoa (p.prefix), p.prefixlen);
 
-      ospf_route_add (ospf->new_external_route, &p, new, asbr_route);
+      ospf_route_add (rt, &p, new, asbr_route);
 
       if (al->e[0].fwd_addr.s_addr)
 	ospf_ase_complete_direct_routes (new, al->e[0].fwd_addr);
@@ -543,6 +554,25 @@ ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
   return 0;
 }
 
+static void
+ospf_ase_log_null_info (unsigned long null_info)
+{
+  if (null_info)
+    zlog_info ("Route[External]: rn->info NULL (%lu times)", null_info);
+}
+
+int
+ospf_ase_calculate_route (struct ospf *ospf, struct ospf_lsa * lsa)
+{
+  unsigned long null_info = 0;
+  int ret;
+
+  ret = ospf_ase_calculate_route_table (ospf, lsa, ospf->new_external_route,
+					quagga_time (NULL), &null_info);
+  ospf_ase_log_null_info (null_info);
+  return ret;
+}
+
 static int
 ospf_ase_route_match_same (struct route_table *rt, struct prefix *prefix,
 			   struct ospf_route *newor)
@@ -628,14 +658,167 @@ ospf_ase_compare_tables (struct route_table *new_external_route,
   return 0;
 }
 
+/* Below this many LSAs starting threads costs more than it saves. */
+#define OSPF_ASE_PARALLEL_MIN_LSAS 1024
+
+/* A share of the external LSAs and the partial routing table
+   calculated from them. */
+struct ospf_ase_shard
+{
+  struct ospf *ospf;
+  struct route_table *rt;
+  struct ospf_lsa **lsas;
+  unsigned long count;
+  time_t now;
+  unsigned long null_info;
+#ifdef HAVE_PTHREAD
+  pthread_t thread;
+  int started;
+#endif /* HAVE_PTHREAD */
+};
+
+static void
+ospf_ase_calculate_shard (struct ospf_ase_shard *shard)
+{
+  unsigned long i;
+
+  for (i = 0; i < shard->count; i++)
+    ospf_ase_calculate_route_table (shard->ospf, shard->lsas[i], shard->rt,
+				    shard->now, &shard->null_info);
+}
+
+#ifdef HAVE_PTHREAD
+static void *
+ospf_ase_calculate_shard_thread (void *arg)
+{
+  ospf_ase_calculate_shard (arg);
+  return NULL;
+}
+
+/* LSAs for the same destination compete with each other in
+   ospf_ase_calculate_route_table(), so they have to land in the same
+   shard.  Key on the masked destination. */
+static unsigned int
+ospf_ase_shard_index (struct ospf_lsa *lsa, unsigned int nshards)
+{
+  struct as_external_lsa *al = (struct as_external_lsa *) lsa->data;
+
+  return jhash_2words (al->header.id.s_addr & al->mask.s_addr,
+		       al->mask.s_addr, 0) % nshards;
+}
+
+/* Move the routes calculated by a shard into the main table.  Shards
+   never share a destination, so every node taken here is empty. */
+static void
+ospf_ase_merge_table (struct route_table *to, struct route_table *from)
+{
+  struct route_node *rn, *rn2;
+
+  for (rn = route_top (from); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+	rn2 = route_node_get (to, &rn->p);
+	assert (rn2->info == NULL);
+	rn2->info = rn->info;
+
+	rn->info = NULL;
+	route_unlock_node (rn);
+      }
+
+  route_table_finish (from);
+}
+
+/* Split the LSAs over ospf->ase_threads shards, calculate each into
+   its own table, and merge the results into ospf->new_external_route.
+   LSAs keep their relative order within a shard, so the outcome is
+   the same as calculating them one after the other.  Returns the
+   number of shards used. */
+static unsigned int
+ospf_ase_calculate_parallel (struct ospf *ospf, struct ospf_lsa **lsas,
+			     unsigned long count)
+{
+  struct ospf_ase_shard *shards;
+  struct ospf_lsa **sorted;
+  unsigned int nshards = ospf->ase_threads;
+  unsigned int i;
+  unsigned long j, *fill;
+  time_t now = quagga_time (NULL);
+
+  shards = XCALLOC (MTYPE_TMP, sizeof (struct ospf_ase_shard) * nshards);
+  fill = XCALLOC (MTYPE_TMP, sizeof (unsigned long) * nshards);
+  sorted = XMALLOC (MTYPE_TMP, sizeof (struct ospf_lsa *) * count);
+
+  for (j = 0; j < count; j++)
+    shards[ospf_ase_shard_index (lsas[j], nshards)].count++;
+
+  for (i = 0, j = 0; i < nshards; j += shards[i].count, i++)
+    {
+      shards[i].ospf = ospf;
+      shards[i].rt = route_table_init ();
+      shards[i].lsas = sorted + j;
+      shards[i].now = now;
+    }
+
+  for (j = 0; j < count; j++)
+    {
+      i = ospf_ase_shard_index (lsas[j], nshards);
+      shards[i].lsas[fill[i]++] = lsas[j];
+    }
+
+  /* The first shard is done here while the others run. */
+  for (i = 1; i < nshards; i++)
+    if (pthread_create (&shards[i].thread, NULL,
+			ospf_ase_calculate_shard_thread, &shards[i]) == 0)
+      shards[i].started = 1;
+
+  ospf_ase_calculate_shard (&shards[0]);
+
+  for (i = 1; i < nshards; i++)
+    if (shards[i].started)
+      pthread_join (shards[i].thread, NULL);
+    else
+      ospf_ase_calculate_shard (&shards[i]);
+
+  for (i = 0; i < nshards; i++)
+    {
+      ospf_ase_merge_table (ospf->new_external_route, shards[i].rt);
+      ospf_ase_log_null_info (shards[i].null_info);
+    }
+
+  XFREE (MTYPE_TMP, sorted);
+  XFREE (MTYPE_TMP, fill);
+  XFREE (MTYPE_TMP, shards);
+
+  return nshards;
+}
+
+/* Whether the calculation may be spread over several threads.  zlog
+   is not safe to call off the main thread, so any of the debugging
+   that the calculation does keeps it serial. */
+static int
+ospf_ase_parallel_allowed (struct ospf *ospf, unsigned long count)
+{
+  if (ospf->ase_threads < 2 || count < OSPF_ASE_PARALLEL_MIN_LSAS)
+    return 0;
+
+  if (IS_DEBUG_OSPF (lsa, LSA) || IS_DEBUG_OSPF_NSSA || IS_DEBUG_OSPF_EVENT)
+    return 0;
+
+  return 1;
+}
+#endif /* HAVE_PTHREAD */
+
 static int
 ospf_ase_calculate_timer (struct thread *t)
 {
   struct ospf *ospf;
   struct ospf_lsa *lsa;
+  struct ospf_lsa **lsas;
   struct route_node *rn;
   struct listnode *node;
   struct ospf_area *area;
+  struct timeval start, stop, result;
+  unsigned long count, i;
 
   ospf = THREAD_ARG (t);
   ospf->t_ase_calc = NULL;
@@ -644,9 +827,22 @@ ospf_ase_calculate_timer (struct thread *t)
     {
       ospf->ase_calc = 0;
 
-      /* Calculate external route for each AS-external-LSA */
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+
+      /* Gather every AS-external-LSA, and the Type-7 LSAs of all NSSA
+	 areas, in the order they are to be examined. */
+      count = ospf_lsdb_count (ospf->lsdb, OSPF_AS_EXTERNAL_LSA)
+	      + ospf_lsdb_count (ospf->lsdb, OSPF_AS_NSSA_LSA);
+      if (ospf->anyNSSA)
+	for (ALL_LIST_ELEMENTS_RO (ospf->areas, node, area))
+	  if (area->external_routing == OSPF_AREA_NSSA)
+	    count += ospf_lsdb_count (area->lsdb, OSPF_AS_NSSA_LSA);
+
+      lsas = XMALLOC (MTYPE_TMP, sizeof (struct ospf_lsa *) * (count + 1));
+      i = 0;
+
       LSDB_LOOP (EXTERNAL_LSDB (ospf), rn, lsa)
-	ospf_ase_calculate_route (ospf, lsa);
+	lsas[i++] = lsa;
 
       /*  This version simple adds to the table all NSSA areas  */
       if (ospf->anyNSSA)
@@ -658,11 +854,28 @@ ospf_ase_calculate_timer (struct thread *t)
 
 	    if (area->external_routing == OSPF_AREA_NSSA)
 	      LSDB_LOOP (NSSA_LSDB (area), rn, lsa)
-		ospf_ase_calculate_route (ospf, lsa);
+		lsas[i++] = lsa;
 	  }
       /* kevinm: And add the NSSA routes in ospf_top */
       LSDB_LOOP (NSSA_LSDB (ospf),rn,lsa)
-      		ospf_ase_calculate_route(ospf,lsa);
+	lsas[i++] = lsa;
+
+      assert (i == count);
+
+      /* Calculate external route for each of them */
+#ifdef HAVE_PTHREAD
+      if (ospf_ase_parallel_allowed (ospf, count))
+	ospf->ase_calc_shards = ospf_ase_calculate_parallel (ospf, lsas,
+							     count);
+      else
+#endif /* HAVE_PTHREAD */
+	{
+	  for (i = 0; i < count; i++)
+	    ospf_ase_calculate_route (ospf, lsas[i]);
+	  ospf->ase_calc_shards = 1;
+	}
+
+      XFREE (MTYPE_TMP, lsas);
 
       /* Compare old and new external routing table and install the
 	 difference info zebra/kernel */
@@ -673,6 +886,16 @@ ospf_ase_calculate_timer (struct thread *t)
       ospf_route_table_free (ospf->old_external_route);
       ospf->old_external_route = ospf->new_external_route;
       ospf->new_external_route = route_table_init ();
+
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &stop);
+      result = tv_sub (stop, start);
+
+      ospf->ase_calc_count++;
+      ospf->ase_calc_lsas = count;
+      ospf->ase_calc_last_usec = result.tv_sec * 1000000L + result.tv_usec;
+      ospf->ase_calc_total_usec += ospf->ase_calc_last_usec;
+      if (ospf->ase_calc_last_usec > ospf->ase_calc_max_usec)
+	ospf->ase_calc_max_usec = ospf->ase_calc_last_usec;
     }
   return 0;
 }
@@ -40,14 +40,17 @@
 #include "ospfd/ospf_zebra.h"
 #include "ospfd/ospf_dump.h"
 
+/* Create a route stamped with the given time.  Unlike ospf_route_new()
+   this does not touch the shared clock, so it may be used off the
+   main thread. */
 struct ospf_route *
-ospf_route_new ()
+ospf_route_new_stamped (time_t now)
 {
   struct ospf_route *new;
 
   new = XCALLOC (MTYPE_OSPF_ROUTE, sizeof (struct ospf_route));
 
-  new->ctime = quagga_time (NULL);
+  new->ctime = now;
   new->mtime = new->ctime;
   new->paths = list_new ();
   new->paths->del = (void (*) (void *))ospf_path_free;
@@ -55,6 +58,12 @@ ospf_route_new ()
   return new;
 }
 
+struct ospf_route *
+ospf_route_new ()
+{
+  return ospf_route_new_stamped (quagga_time (NULL));
+}
+
 void
 ospf_route_free (struct ospf_route *or)
 {
@@ -125,6 +125,7 @@ extern struct ospf_path *ospf_path_new (void);
 extern void ospf_path_free (struct ospf_path *);
 extern struct ospf_path *ospf_path_lookup (struct list *, struct ospf_path *);
 extern struct ospf_route *ospf_route_new (void);
+extern struct ospf_route *ospf_route_new_stamped (time_t);
 extern void ospf_route_free (struct ospf_route *);
 extern void ospf_route_delete (struct route_table *);
 extern void ospf_route_table_free (struct route_table *);
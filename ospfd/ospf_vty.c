@@ -2479,6 +2479,54 @@ ALIAS (no_ospf_refresh_timer,
        "Adjust refresh parameters\n"
        "Unset refresh timer\n")
 
+DEFUN (ospf_ase_calculation_threads,
+       ospf_ase_calculation_threads_cmd,
+       "ase-calculation threads <1-32>",
+       "AS-external route calculation\n"
+       "Number of threads to spread the calculation over\n"
+       "Number of threads\n")
+{
+  struct ospf *ospf = vty->index;
+  unsigned int threads;
+
+  VTY_GET_INTEGER_RANGE ("threads", threads, argv[0],
+			 1, OSPF_ASE_THREADS_MAX);
+
+#ifndef HAVE_PTHREAD
+  if (threads > 1)
+    {
+      vty_out (vty, "%% Thread support is not compiled in%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+#endif /* HAVE_PTHREAD */
+
+  ospf->ase_threads = threads;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_ospf_ase_calculation_threads,
+       no_ospf_ase_calculation_threads_cmd,
+       "no ase-calculation threads",
+       NO_STR
+       "AS-external route calculation\n"
+       "Number of threads to spread the calculation over\n")
+{
+  struct ospf *ospf = vty->index;
+
+  ospf->ase_threads = OSPF_ASE_THREADS_DEFAULT;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_ospf_ase_calculation_threads,
+       no_ospf_ase_calculation_threads_val_cmd,
+       "no ase-calculation threads <1-32>",
+       NO_STR
+       "AS-external route calculation\n"
+       "Number of threads to spread the calculation over\n"
+       "Number of threads\n")
+
 DEFUN (ospf_auto_cost_reference_bandwidth,
        ospf_auto_cost_reference_bandwidth_cmd,
        "auto-cost reference-bandwidth <1-4294967>",
@@ -2758,6 +2806,23 @@ DEFUN (show_ip_ospf,
            (ospf->t_spf_calc ? "due in " : "is "),
            ospf_timer_dump (ospf->t_spf_calc, timebuf, sizeof (timebuf)),
            VTY_NEWLINE);
+
+  /* Show AS-external route calculation statistics. */
+  vty_out (vty, " AS-external route calculation uses up to %u thread(s)%s",
+           ospf->ase_threads, VTY_NEWLINE);
+  if (ospf->ase_calc_count)
+    vty_out (vty, " AS-external routes calculated %lu times, "
+                  "average %llu usecs, maximum %lu usecs%s"
+                  " Last calculation took %lu usecs for %lu LSA(s)"
+                  " in %u shard(s)%s",
+             ospf->ase_calc_count,
+             ospf->ase_calc_total_usec / ospf->ase_calc_count,
+             ospf->ase_calc_max_usec, VTY_NEWLINE,
+             ospf->ase_calc_last_usec, ospf->ase_calc_lsas,
+             ospf->ase_calc_shards, VTY_NEWLINE);
+  else
+    vty_out (vty, " AS-external routes have not been calculated%s",
+             VTY_NEWLINE);
   
   /* Show refresh parameters. */
   vty_out (vty, " Refresh timer %d secs%s",
@@ -8026,6 +8091,11 @@ ospf_config_write (struct vty *vty)
 	vty_out (vty, " refresh timer %d%s",
 		 ospf->lsa_refresh_interval, VTY_NEWLINE);
 
+      /* AS-external route calculation threads print. */
+      if (ospf->ase_threads != OSPF_ASE_THREADS_DEFAULT)
+	vty_out (vty, " ase-calculation threads %u%s",
+		 ospf->ase_threads, VTY_NEWLINE);
+
       /* Redistribute information print. */
       config_write_ospf_redistribute (vty, ospf);
 
@@ -8495,6 +8565,11 @@ ospf_vty_init (void)
   install_element (OSPF_NODE, &ospf_refresh_timer_cmd);
   install_element (OSPF_NODE, &no_ospf_refresh_timer_val_cmd);
   install_element (OSPF_NODE, &no_ospf_refresh_timer_cmd);
+
+  /* AS-external route calculation commands */
+  install_element (OSPF_NODE, &ospf_ase_calculation_threads_cmd);
+  install_element (OSPF_NODE, &no_ospf_ase_calculation_threads_cmd);
+  install_element (OSPF_NODE, &no_ospf_ase_calculation_threads_val_cmd);
   
   /* max-metric commands */
   install_element (OSPF_NODE, &ospf_max_metric_router_lsa_admin_cmd);
@@ -197,6 +197,7 @@ ospf_new (void)
   new->spf_holdtime = OSPF_SPF_HOLDTIME_DEFAULT;
   new->spf_max_holdtime = OSPF_SPF_MAX_HOLDTIME_DEFAULT;
   new->spf_hold_multiplier = 1;
+  new->ase_threads = OSPF_ASE_THREADS_DEFAULT;
 
   /* MaxAge init. */
   new->maxage_delay = OSFP_LSA_MAXAGE_REMOVE_DELAY_DEFAULT;
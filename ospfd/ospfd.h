@@ -90,6 +90,10 @@
 #define OSPF_SPF_HOLDTIME_DEFAULT           1000
 #define OSPF_SPF_MAX_HOLDTIME_DEFAULT	    10000
 
+/* AS-external route calculation threads. */
+#define OSPF_ASE_THREADS_DEFAULT            1
+#define OSPF_ASE_THREADS_MAX                32
+
 /* OSPF interface default values. */
 #define OSPF_OUTPUT_COST_DEFAULT           10
 #define OSPF_OUTPUT_COST_INFINITE	   UINT16_MAX
@@ -201,6 +205,15 @@ struct ospf
   unsigned int spf_holdtime;		/* SPF hold time. */
   unsigned int spf_max_holdtime;	/* SPF maximum-holdtime */
   unsigned int spf_hold_multiplier;	/* Adaptive multiplier for hold time */
+
+  /* AS-external route calculation parameters and statistics. */
+  unsigned int ase_threads;		/* Number of calculation threads. */
+  unsigned long ase_calc_count;		/* Number of full calculations. */
+  unsigned long ase_calc_lsas;		/* LSAs examined by the last one. */
+  unsigned int ase_calc_shards;		/* Shards used by the last one. */
+  unsigned long ase_calc_last_usec;	/* Duration of the last one. */
+  unsigned long ase_calc_max_usec;	/* Longest one so far. */
+  unsigned long long ase_calc_total_usec; /* Sum of all of them. */
   
   int default_originate;		/* Default information originate. */
 #define DEFAULT_ORIGINATE_NONE		0
@@ -240,6 +240,9 @@ route_match_interface (void *rule, struct prefix *prefix,
 
       rinfo = object;
 
+      /* The result depends on the interface sent on. */
+      rinfo->ifindex_out_used = 1;
+
       if (rinfo->ifindex_out == ifp->ifindex || rinfo->ifindex == ifp->ifindex)
 	return RMAP_MATCH;
       else
@@ -625,6 +628,7 @@ route_set_ip_nexthop (void *rule, struct prefix *prefix,
     
       /* Set next hop value. */ 
       rinfo->nexthop_out = *address;
+      rinfo->nexthop_set = 1;
     }
 
   return RMAP_OKAY;
@@ -23,10 +23,12 @@
 
 #include "command.h"
 #include "prefix.h"
+#include "table.h"
 #include "stream.h"
 #include "routemap.h"
 #include "zclient.h"
 #include "log.h"
+#include "memory.h"
 #include "ripd/ripd.h"
 #include "ripd/rip_debug.h"
 #include "ripd/rip_interface.h"
@@ -91,6 +93,64 @@ rip_zebra_ipv4_delete (struct prefix_ipv4 *p, struct in_addr *nexthop,
     }
 }
 
+static int
+rip_info_nexthop_cmp (const void *a, const void *b)
+{
+  const struct rip_info *ra = *(struct rip_info * const *) a;
+  const struct rip_info *rb = *(struct rip_info * const *) b;
+
+  if (ntohl (ra->nexthop.s_addr) < ntohl (rb->nexthop.s_addr))
+    return -1;
+  if (ntohl (ra->nexthop.s_addr) > ntohl (rb->nexthop.s_addr))
+    return 1;
+  return 0;
+}
+
+/* Delete many routes at once, as when they time out together.  Routes
+   through the same nexthop share one message. */
+void
+rip_zebra_ipv4_delete_batch (struct rip_info **rinfo, unsigned int count)
+{
+  struct rip_info **sorted;
+  struct prefix_ipv4 **prefixes;
+  struct in_addr *nexthop;
+  struct zapi_ipv4 api;
+  unsigned int i, j, n;
+
+  if (! zclient->redist[ZEBRA_ROUTE_RIP] || count == 0)
+    return;
+
+  sorted = XMALLOC (MTYPE_TMP, count * sizeof (struct rip_info *));
+  prefixes = XMALLOC (MTYPE_TMP, count * sizeof (struct prefix_ipv4 *));
+  memcpy (sorted, rinfo, count * sizeof (struct rip_info *));
+  qsort (sorted, count, sizeof (struct rip_info *), rip_info_nexthop_cmp);
+
+  api.type = ZEBRA_ROUTE_RIP;
+  api.flags = 0;
+  api.message = 0;
+  api.safi = SAFI_UNICAST;
+  SET_FLAG (api.message, ZAPI_MESSAGE_NEXTHOP);
+  api.nexthop_num = 1;
+  api.nexthop = &nexthop;
+  api.ifindex_num = 0;
+
+  for (i = 0; i < count; i = j)
+    {
+      nexthop = &sorted[i]->nexthop;
+      for (j = i, n = 0;
+           j < count && sorted[j]->nexthop.s_addr == nexthop->s_addr; j++)
+        prefixes[n++] = (struct prefix_ipv4 *) &sorted[j]->rp->p;
+
+      zapi_ipv4_route_bulk (ZEBRA_IPV4_ROUTE_DELETE, zclient, prefixes, n,
+                            &api);
+    }
+
+  rip_global_route_changes += count;
+
+  XFREE (MTYPE_TMP, prefixes);
+  XFREE (MTYPE_TMP, sorted);
+}
+
 /* Zebra route add and delete treatment. */
 static int
 rip_zebra_read_ipv4 (int command, struct zclient *zclient, zebra_size_t length)
@@ -121,18 +121,111 @@ rip_info_free (struct rip_info *rinfo)
   XFREE (MTYPE_RIP_INFO, rinfo);
 }
 
-/* RIP route garbage collect timer. */
-static int
-rip_garbage_collect (struct thread *t)
+/* Route timeouts and garbage collection run off a wheel of one-second
+   slots rather than two timer threads per route.  A route sits in the
+   slot of its deadline, or of an earlier one: refreshing a route only
+   moves its start time, and the route is moved to its new slot when
+   the old one comes round.  A single thread turns the wheel and handles
+   all the routes that expired in the same second together. */
+static time_t
+rip_age_deadline (struct rip_info *rinfo)
 {
-  struct rip_info *rinfo;
-  struct route_node *rp;
+  if (rinfo->age_state == RIP_AGE_GARBAGE)
+    return rinfo->age_start + rip->garbage_time;
+  return rinfo->age_start + rip->timeout_time;
+}
+
+static int rip_age_tick (struct thread *);
+static int rip_age_ticking = 0;
+
+static void
+rip_age_link (struct rip_info *rinfo, time_t deadline)
+{
+  int slot;
+
+  /* The wheel is empty unless it turns; resume it from now. */
+  if (! rip->t_age && ! rip_age_ticking)
+    {
+      rip->age_clock = recent_relative_time ().tv_sec;
+      rip->t_age = thread_add_timer (master, rip_age_tick, NULL, 1);
+    }
+
+  if (deadline <= rip->age_clock)
+    deadline = rip->age_clock + 1;
+
+  slot = deadline % RIP_AGE_SLOTS;
+  rinfo->age_slot = slot;
+  rinfo->age_prev = NULL;
+  rinfo->age_next = rip->age_slot[slot];
+  if (rinfo->age_next)
+    rinfo->age_next->age_prev = rinfo;
+  rip->age_slot[slot] = rinfo;
+  rip->age_count++;
+}
+
+static void
+rip_age_unlink (struct rip_info *rinfo)
+{
+  if (rinfo->age_prev)
+    rinfo->age_prev->age_next = rinfo->age_next;
+  else
+    rip->age_slot[rinfo->age_slot] = rinfo->age_next;
+  if (rinfo->age_next)
+    rinfo->age_next->age_prev = rinfo->age_prev;
+  rinfo->age_prev = rinfo->age_next = NULL;
+
+  if (--rip->age_count == 0 && ! rip_age_ticking)
+    RIP_TIMER_OFF (rip->t_age);
+}
+
+/* Stop the timeout or garbage collection of a route. */
+static void
+rip_timers_off (struct rip_info *rinfo)
+{
+  if (rinfo->age_state == RIP_AGE_NONE)
+    return;
+
+  rip_age_unlink (rinfo);
+  rinfo->age_state = RIP_AGE_NONE;
+}
+
+/* Start the garbage collection of a route, unless already started. */
+static void
+rip_garbage_update (struct rip_info *rinfo)
+{
+  if (rinfo->age_state == RIP_AGE_GARBAGE)
+    return;
+
+  rip_timers_off (rinfo);
+  rinfo->age_state = RIP_AGE_GARBAGE;
+  rinfo->age_start = recent_relative_time ().tv_sec;
+  rip_age_link (rinfo, rip_age_deadline (rinfo));
+}
+
+static void
+rip_timeout_update (struct rip_info *rinfo)
+{
+  if (rinfo->metric != RIP_METRIC_INFINITY)
+    {
+      if (rinfo->age_state != RIP_AGE_TIMEOUT)
+        {
+          rip_timers_off (rinfo);
+          rinfo->age_state = RIP_AGE_TIMEOUT;
+          rinfo->age_start = recent_relative_time ().tv_sec;
+          rip_age_link (rinfo, rip_age_deadline (rinfo));
+        }
+      else
+        rinfo->age_start = recent_relative_time ().tv_sec;
+    }
+}
 
-  rinfo = THREAD_ARG (t);
-  rinfo->t_garbage_collect = NULL;
+/* RIP route garbage collect. */
+static void
+rip_garbage_collect (struct rip_info *rinfo)
+{
+  struct route_node *rp;
 
-  /* Off timeout timer. */
-  RIP_TIMER_OFF (rinfo->t_timeout);
+  rip_timers_off (rinfo);
   
   /* Get route_node pointer. */
   rp = rinfo->rp;
@@ -143,28 +236,17 @@ rip_garbage_collect (struct thread *t)
 
   /* Free RIP routing information. */
   rip_info_free (rinfo);
-
-  return 0;
 }
 
-/* Timeout RIP routes. */
-static int
-rip_timeout (struct thread *t)
+/* Timeout RIP routes.  Deleting the routes from zebra and triggering
+   an update is left to the caller, to be done once for all the routes
+   timed out together. */
+static void
+rip_timeout (struct rip_info *rinfo)
 {
-  struct rip_info *rinfo;
-  struct route_node *rn;
-
-  rinfo = THREAD_ARG (t);
-  rinfo->t_timeout = NULL;
-
-  rn = rinfo->rp;
-
   /* - The garbage-collection timer is set for 120 seconds. */
-  RIP_TIMER_ON (rinfo->t_garbage_collect, rip_garbage_collect, 
-		rip->garbage_time);
+  rip_garbage_update (rinfo);
 
-  rip_zebra_ipv4_delete ((struct prefix_ipv4 *)&rn->p, &rinfo->nexthop,
-			 rinfo->metric);
   /* - The metric for the route is set to 16 (infinity).  This causes
      the route to be removed from service. */
   rinfo->metric = RIP_METRIC_INFINITY;
@@ -173,21 +255,86 @@ rip_timeout (struct thread *t)
   /* - The route change flag is to indicate that this entry has been
      changed. */
   rinfo->flags |= RIP_RTF_CHANGED;
-
-  /* - The output process is signalled to trigger a response. */
-  rip_event (RIP_TRIGGERED_UPDATE, 0);
-
-  return 0;
 }
 
-static void
-rip_timeout_update (struct rip_info *rinfo)
+static int
+rip_age_tick (struct thread *t)
 {
-  if (rinfo->metric != RIP_METRIC_INFINITY)
+  time_t now, deadline;
+  struct rip_info *rinfo, *next;
+  struct rip_info **timedout = NULL;
+  unsigned int count = 0, size = 0;
+
+  rip->t_age = NULL;
+  rip_age_ticking = 1;
+  now = recent_relative_time ().tv_sec;
+
+  /* Every route on the wheel is looked at once per turn. */
+  if (now - rip->age_clock > RIP_AGE_SLOTS)
+    rip->age_clock = now - RIP_AGE_SLOTS;
+
+  while (rip->age_clock < now)
     {
-      RIP_TIMER_OFF (rinfo->t_timeout);
-      RIP_TIMER_ON (rinfo->t_timeout, rip_timeout, rip->timeout_time);
+      int slot;
+
+      rip->age_clock++;
+      slot = rip->age_clock % RIP_AGE_SLOTS;
+
+      /* Take the whole slot off the wheel, routes put back into it
+         are a turn away. */
+      rinfo = rip->age_slot[slot];
+      rip->age_slot[slot] = NULL;
+
+      for (; rinfo; rinfo = next)
+        {
+          next = rinfo->age_next;
+          rinfo->age_prev = rinfo->age_next = NULL;
+          rip->age_count--;
+
+          deadline = rip_age_deadline (rinfo);
+          if (deadline > now)
+            {
+              /* Refreshed since it was put here, or a later turn. */
+              rip_age_link (rinfo, deadline);
+              continue;
+            }
+
+          if (rinfo->age_state == RIP_AGE_GARBAGE)
+            {
+              rinfo->age_state = RIP_AGE_NONE;
+              rip_garbage_collect (rinfo);
+              continue;
+            }
+
+          if (count == size)
+            {
+              size = size ? size * 2 : 64;
+              timedout = XREALLOC (MTYPE_TMP, timedout,
+                                   size * sizeof (struct rip_info *));
+            }
+          timedout[count++] = rinfo;
+
+          rinfo->age_state = RIP_AGE_NONE;
+          rip_timeout (rinfo);
+        }
     }
+
+  rip_age_ticking = 0;
+
+  if (count)
+    {
+      /* Delete this route from the kernel, in one go for all of them. */
+      rip_zebra_ipv4_delete_batch (timedout, count);
+      XFREE (MTYPE_TMP, timedout);
+
+      /* - The output process is signalled to trigger a response. */
+      rip_event (RIP_TRIGGERED_UPDATE, 0);
+    }
+
+  if (rip->age_count)
+    rip->t_age = thread_add_timer (master, rip_age_tick, NULL, 1);
+
+  return 0;
 }
 
 static int
@@ -495,8 +642,7 @@ rip_rte_process (struct rte *rte, struct sockaddr_in *from,
             }
           else
             {
-              RIP_TIMER_OFF (rinfo->t_timeout);
-              RIP_TIMER_OFF (rinfo->t_garbage_collect);
+              rip_timers_off (rinfo);
                                                                                 
               rp->info = NULL;
               if (rip_route_rte (rinfo))
@@ -624,7 +770,7 @@ rip_rte_process (struct rte *rte, struct sockaddr_in *from,
               rinfo->type = ZEBRA_ROUTE_RIP;
               rinfo->sub_type = RIP_ROUTE_RTE;
 
-              RIP_TIMER_OFF (rinfo->t_garbage_collect);
+              rip_timers_off (rinfo);
 
               if (!IPV4_ADDR_SAME (&rinfo->nexthop, nexthop))
                 IPV4_ADDR_COPY (&rinfo->nexthop, nexthop);
@@ -664,9 +810,7 @@ rip_rte_process (struct rte *rte, struct sockaddr_in *from,
               if (oldmetric != RIP_METRIC_INFINITY)
                 {
                   /* - The garbage-collection timer is set for 120 seconds. */
-                  RIP_TIMER_ON (rinfo->t_garbage_collect,
-                                rip_garbage_collect, rip->garbage_time);
-                  RIP_TIMER_OFF (rinfo->t_timeout);
+                  rip_garbage_update (rinfo);
 
                   /* - The metric for the route is set to 16
                      (infinity).  This causes the route to be removed
@@ -1553,8 +1697,7 @@ rip_redistribute_add (int type, int sub_type, struct prefix_ipv4 *p,
 	    }
 	}
 
-      RIP_TIMER_OFF (rinfo->t_timeout);
-      RIP_TIMER_OFF (rinfo->t_garbage_collect);
+      rip_timers_off (rinfo);
 
       if (rip_route_rte (rinfo))
 	rip_zebra_ipv4_delete ((struct prefix_ipv4 *)&rp->p, &rinfo->nexthop,
@@ -1623,9 +1766,7 @@ rip_redistribute_delete (int type, int sub_type, struct prefix_ipv4 *p,
 	{
 	  /* Perform poisoned reverse. */
 	  rinfo->metric = RIP_METRIC_INFINITY;
-	  RIP_TIMER_ON (rinfo->t_garbage_collect, 
-			rip_garbage_collect, rip->garbage_time);
-	  RIP_TIMER_OFF (rinfo->t_timeout);
+	  rip_garbage_update (rinfo);
 	  rinfo->flags |= RIP_RTF_CHANGED;
 
           if (IS_RIP_DEBUG_EVENT)
@@ -2130,6 +2271,390 @@ rip_write_rte (int num, struct stream *s, struct prefix_ipv4 *p,
   return ++num;
 }
 
+/* Routes going out on the interfaces sending alike.
+
+   What rip_output_process () sends on an interface depends on the
+   interface through its settings (version, distribute-lists,
+   route-map, offset-list, the mask of RIPv1 subnets) and, route by
+   route, through which interface it is: split horizon, keeping a next
+   hop learnt on the interface and route-maps matching on it.  The
+   routes are filtered and encoded once per set of settings during an
+   update, and the interfaces sharing them only patch the rest in. */
+struct rip_out_class
+{
+  /* Settings of the interfaces in the class. */
+  u_char version;
+  int route_type;
+  struct access_list *alist;
+  struct prefix_list *plist;
+  struct route_map *routemap;
+  struct rip_offset_list *offset;
+  int subnetted;
+  struct prefix_ipv4 ifaddrclass;
+  u_char prefixlen;
+
+  /* Routes passing the filters, in table order, and their RTEs, as
+     sent on an interface none of them is learnt on. */
+  struct rip_out_route *routes;
+  int count;
+  int size;
+  struct stream *rtes;
+
+  /* Packets of an interface with nothing to patch, for the next such
+     one with the same authentication. */
+  struct list *packets;
+  int auth_type;
+  u_char md5_auth_len;
+  u_char key_id;
+  char auth_str[RIP_AUTH_SIMPLE_SIZE];
+};
+
+struct rip_out_route
+{
+  struct route_node *rp;
+  struct rip_info *rinfo;
+
+  /* The next hop was set by a route-map. */
+#define RIP_OUT_NEXTHOP_SET	1
+  /* A route-map matched on the interface: redone per interface. */
+#define RIP_OUT_PER_INTERFACE	2
+  u_char flags;
+};
+
+/* Whether announcing the route on ifc would send it back where it came
+   from: RIP routes learnt on the interface and connected routes
+   covering the address used as source. */
+static int
+rip_split_horizon_route (struct connected *ifc, struct prefix_ipv4 *p,
+			 struct rip_info *rinfo)
+{
+  if (rinfo->type == ZEBRA_ROUTE_RIP
+      && rinfo->ifindex == ifc->ifp->ifindex)
+    return 1;
+  if (rinfo->type == ZEBRA_ROUTE_CONNECT
+      && prefix_match ((struct prefix *) p, ifc->address))
+    return 1;
+  return 0;
+}
+
+/* Filters the route for output on ifc, leaving what to send in the
+   _out fields of rinfo.  Returns -1 if it is not sent.  If shared by a
+   class, split horizon and the next hop learnt on ifc are left out. */
+static int
+rip_output_route (struct connected *ifc, struct rip_interface *ri,
+		  struct prefix_ipv4 *p, struct rip_info *rinfo,
+		  int route_type, int shared)
+{
+  int ret;
+
+  /* Apply output filters. */
+  ret = rip_outgoing_filter (p, ri);
+  if (ret < 0)
+    return -1;
+
+  /* Changed route only output. */
+  if (route_type == rip_changed_route &&
+      (! (rinfo->flags & RIP_RTF_CHANGED)))
+    return -1;
+
+  /* Split horizon. */
+  /* if (split_horizon == rip_split_horizon) */
+  if (! shared && ri->split_horizon == RIP_SPLIT_HORIZON
+      && rip_split_horizon_route (ifc, p, rinfo))
+    return -1;
+
+  /* Preparation for route-map. */
+  rinfo->metric_set = 0;
+  rinfo->nexthop_set = 0;
+  rinfo->ifindex_out_used = 0;
+  rinfo->nexthop_out.s_addr = 0;
+  rinfo->metric_out = rinfo->metric;
+  rinfo->tag_out = rinfo->tag;
+  rinfo->ifindex_out = shared ? 0 : ifc->ifp->ifindex;
+
+  /* In order to avoid some local loops,
+   * if the RIP route has a nexthop via this interface, keep the nexthop,
+   * otherwise set it to 0. The nexthop should not be propagated
+   * beyond the local broadcast/multicast area in order
+   * to avoid an IGP multi-level recursive look-up.
+   * see (4.4)
+   */
+  if (! shared && rinfo->ifindex == ifc->ifp->ifindex)
+    rinfo->nexthop_out = rinfo->nexthop;
+
+  /* Interface route-map */
+  if (ri->routemap[RIP_FILTER_OUT])
+    {
+      ret = route_map_apply (ri->routemap[RIP_FILTER_OUT], 
+			     (struct prefix *) p, RMAP_RIP, 
+			     rinfo);
+
+      if (ret == RMAP_DENYMATCH)
+	{
+	  if (IS_RIP_DEBUG_PACKET)
+	    zlog_debug ("RIP %s/%d is filtered by route-map out",
+		       inet_ntoa (p->prefix), p->prefixlen);
+	  return -1;
+	}
+    }
+           
+  /* Apply redistribute route map - continue, if deny */
+  if (rip->route_map[rinfo->type].name
+      && rinfo->sub_type != RIP_ROUTE_INTERFACE)
+    {
+      ret = route_map_apply (rip->route_map[rinfo->type].map,
+			     (struct prefix *)p, RMAP_RIP, rinfo);
+
+      if (ret == RMAP_DENYMATCH) 
+	{
+	  if (IS_RIP_DEBUG_PACKET)
+	    zlog_debug ("%s/%d is filtered by route-map",
+		       inet_ntoa (p->prefix), p->prefixlen);
+	  return -1;
+	}
+    }
+
+  /* When route-map does not set metric. */
+  if (! rinfo->metric_set)
+    {
+      /* If redistribute metric is set. */
+      if (rip->route_map[rinfo->type].metric_config
+	  && rinfo->metric != RIP_METRIC_INFINITY)
+	{
+	  rinfo->metric_out = rip->route_map[rinfo->type].metric;
+	}
+      else
+	{
+	  /* If the route is not connected or localy generated
+	     one, use default-metric value*/
+	  if (rinfo->type != ZEBRA_ROUTE_RIP 
+	      && rinfo->type != ZEBRA_ROUTE_CONNECT
+	      && rinfo->metric != RIP_METRIC_INFINITY)
+	    rinfo->metric_out = rip->default_metric;
+	}
+    }
+
+  /* Apply offset-list */
+  if (rinfo->metric != RIP_METRIC_INFINITY)
+    rip_offset_list_apply_out (p, ifc->ifp, &rinfo->metric_out);
+
+  if (rinfo->metric_out > RIP_METRIC_INFINITY)
+    rinfo->metric_out = RIP_METRIC_INFINITY;
+
+  /* Perform split-horizon with poisoned reverse 
+   * for RIP and connected routes.
+   **/
+  if (! shared && ri->split_horizon == RIP_SPLIT_HORIZON_POISONED_REVERSE
+      && rip_split_horizon_route (ifc, p, rinfo))
+    rinfo->metric_out = RIP_METRIC_INFINITY;
+
+  return 0;
+}
+
+/* For RIPv1, if we are subnetted, output subnets in our network that
+   have the same mask as the output "interface".  For other networks,
+   only the classfull version is output. */
+static int
+rip_output_v1_route (struct rip_out_class *class, struct route_node *rp)
+{
+  struct prefix_ipv4 classfull;
+
+  if (IS_RIP_DEBUG_PACKET)
+    zlog_debug("RIPv1 mask check, %s/%d considered for output",
+	       inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
+
+  if (class->subnetted &&
+      prefix_match ((struct prefix *) &class->ifaddrclass, &rp->p))
+    {
+      if ((class->prefixlen != rp->p.prefixlen) &&
+	  (rp->p.prefixlen != 32))
+	return 0;
+    }
+  else
+    {
+      memcpy (&classfull, &rp->p, sizeof(struct prefix_ipv4));
+      apply_classful_mask_ipv4(&classfull);
+      if (rp->p.u.prefix4.s_addr != 0 &&
+	  classfull.prefixlen != rp->p.prefixlen)
+	return 0;
+    }
+
+  if (IS_RIP_DEBUG_PACKET)
+    zlog_debug("RIPv1 mask check, %s/%d made it through",
+	       inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
+  return 1;
+}
+
+static void
+rip_out_class_free (void *arg)
+{
+  struct rip_out_class *class = arg;
+
+  if (class->packets)
+    list_delete (class->packets);
+  if (class->routes)
+    XFREE (MTYPE_RIP_OUT_CLASS, class->routes);
+  stream_free (class->rtes);
+  XFREE (MTYPE_RIP_OUT_CLASS, class);
+}
+
+/* Fill in the class settings of ifc. */
+static void
+rip_out_class_set (struct rip_out_class *class, struct connected *ifc,
+		   int route_type, u_char version)
+{
+  struct rip_interface *ri = ifc->ifp->info;
+
+  memset (class, 0, sizeof (struct rip_out_class));
+  class->version = version;
+  class->route_type = route_type;
+  class->alist = ri->list[RIP_FILTER_OUT];
+  class->plist = ri->prefix[RIP_FILTER_OUT];
+  class->routemap = ri->routemap[RIP_FILTER_OUT];
+  class->offset = rip_offset_list_out (ifc->ifp);
+
+  if (version == RIPv1)
+    {
+      memcpy (&class->ifaddrclass, ifc->address, sizeof (struct prefix_ipv4));
+      apply_classful_mask_ipv4 (&class->ifaddrclass);
+      if (ifc->address->prefixlen > class->ifaddrclass.prefixlen)
+	{
+	  class->subnetted = 1;
+	  class->prefixlen = ifc->address->prefixlen;
+	}
+    }
+}
+
+static int
+rip_out_class_same (struct rip_out_class *a, struct rip_out_class *b)
+{
+  return a->version == b->version
+    && a->route_type == b->route_type
+    && a->alist == b->alist
+    && a->plist == b->plist
+    && a->routemap == b->routemap
+    && a->offset == b->offset
+    && a->subnetted == b->subnetted
+    && a->prefixlen == b->prefixlen
+    && (! a->subnetted
+	|| prefix_same ((struct prefix *) &a->ifaddrclass,
+			(struct prefix *) &b->ifaddrclass));
+}
+
+/* Filter and encode the routes for the class of ifc. */
+static void
+rip_out_class_build (struct rip_out_class *class, struct connected *ifc)
+{
+  struct rip_interface *ri = ifc->ifp->info;
+  struct route_node *rp;
+  struct rip_info *rinfo;
+  struct rip_out_route *route;
+  int ret;
+
+  class->rtes = stream_new (RIP_RTE_SIZE * 64);
+
+  for (rp = route_top (rip->table); rp; rp = route_next (rp))
+    if ((rinfo = rp->info) != NULL)
+      {
+	if (class->version == RIPv1 && ! rip_output_v1_route (class, rp))
+	  continue;
+
+	ret = rip_output_route (ifc, ri, (struct prefix_ipv4 *) &rp->p,
+				rinfo, class->route_type, 1);
+	if (ret < 0 && ! rinfo->ifindex_out_used)
+	  continue;
+
+	if (class->count == class->size)
+	  {
+	    class->size = class->size ? class->size * 2 : 64;
+	    class->routes = XREALLOC (MTYPE_RIP_OUT_CLASS, class->routes,
+				      class->size *
+				      sizeof (struct rip_out_route));
+	  }
+	route = &class->routes[class->count++];
+	route->rp = rp;
+	route->rinfo = rinfo;
+	route->flags = 0;
+	if (rinfo->ifindex_out_used)
+	  route->flags |= RIP_OUT_PER_INTERFACE;
+	if (rinfo->nexthop_set)
+	  route->flags |= RIP_OUT_NEXTHOP_SET;
+
+	if (STREAM_WRITEABLE (class->rtes) < RIP_RTE_SIZE)
+	  stream_resize (class->rtes, STREAM_SIZE (class->rtes) * 2);
+	rip_write_rte (0, class->rtes, (struct prefix_ipv4 *) &rp->p,
+		       class->version, rinfo);
+      }
+}
+
+/* The routes for ifc, shared with the interfaces in the same class if
+   an update is under way. */
+static struct rip_out_class *
+rip_out_class_get (struct connected *ifc, int route_type, u_char version)
+{
+  struct rip_out_class key, *class;
+  struct listnode *node;
+
+  rip_out_class_set (&key, ifc, route_type, version);
+
+  if (rip->out_classes)
+    for (ALL_LIST_ELEMENTS_RO (rip->out_classes, node, class))
+      if (rip_out_class_same (class, &key))
+	return class;
+
+  class = XMALLOC (MTYPE_RIP_OUT_CLASS, sizeof (struct rip_out_class));
+  memcpy (class, &key, sizeof (struct rip_out_class));
+  rip_out_class_build (class, ifc);
+
+  if (rip->out_classes)
+    listnode_add (rip->out_classes, class);
+  return class;
+}
+
+/* Whether anything of the class must be patched for ifc. */
+static int
+rip_out_class_patched (struct rip_out_class *class, struct connected *ifc)
+{
+  struct rip_interface *ri = ifc->ifp->info;
+  struct rip_out_route *route;
+  int i;
+
+  for (i = 0; i < class->count; i++)
+    {
+      route = &class->routes[i];
+      if (route->flags & RIP_OUT_PER_INTERFACE)
+	return 1;
+      if (class->version == RIPv2
+	  && ! (route->flags & RIP_OUT_NEXTHOP_SET)
+	  && route->rinfo->ifindex == ifc->ifp->ifindex)
+	return 1;
+      if (ri->split_horizon != RIP_NO_SPLIT_HORIZON
+	  && rip_split_horizon_route (ifc,
+				      (struct prefix_ipv4 *) &route->rp->p,
+				      route->rinfo))
+	return 1;
+    }
+  return 0;
+}
+
+/* Whether the packets kept in the class were authenticated as ifc's
+   would be. */
+static int
+rip_out_class_auth_same (struct rip_out_class *class,
+			 struct rip_interface *ri, struct key *key,
+			 char *auth_str)
+{
+  if (class->auth_type != ri->auth_type)
+    return 0;
+  if (ri->auth_type == RIP_NO_AUTH || class->version == RIPv1)
+    return 1;
+  if (memcmp (class->auth_str, auth_str, RIP_AUTH_SIMPLE_SIZE))
+    return 0;
+  return ri->auth_type != RIP_AUTH_MD5
+    || (class->md5_auth_len == ri->md5_auth_len
+	&& class->key_id == (key ? key->index % 256 : 1));
+}
+
 /* Send update to the ifp or spcified neighbor. */
 void
 rip_output_process (struct connected *ifc, struct sockaddr_in *to, 
@@ -2137,12 +2662,13 @@ rip_output_process (struct connected *ifc, struct sockaddr_in *to,
 {
   int ret;
   struct stream *s;
-  struct route_node *rp;
   struct rip_info *rinfo;
   struct rip_interface *ri;
   struct prefix_ipv4 *p;
-  struct prefix_ipv4 classfull;
-  struct prefix_ipv4 ifaddrclass;
+  struct rip_out_class *class;
+  struct rip_out_route *route;
+  struct listnode *node;
+  struct list *packets = NULL;
   struct key *key = NULL;
   /* this might need to made dynamic if RIP ever supported auth methods
      with larger key string sizes */
@@ -2150,7 +2676,7 @@ rip_output_process (struct connected *ifc, struct sockaddr_in *to,
   size_t doff = 0; /* offset of digest offset field */
   int num = 0;
   int rtemax;
-  int subnetted = 0;
+  int i, sh;
 
   /* Logging output event. */
   if (IS_RIP_DEBUG_EVENT)
@@ -2184,6 +2710,7 @@ rip_output_process (struct connected *ifc, struct sockaddr_in *to,
 
   /* If output interface is in simple password authentication mode
      and string or keychain is specified we need space for auth. data */
+  memset (auth_str, 0, RIP_AUTH_SIMPLE_SIZE);
   if (ri->auth_type != RIP_NO_AUTH)
     {
       if (ri->key_chain)
@@ -2198,212 +2725,112 @@ rip_output_process (struct connected *ifc, struct sockaddr_in *to,
       rip_auth_prepare_str_send (ri, key, auth_str, RIP_AUTH_SIMPLE_SIZE);
     }
 
-  if (version == RIPv1)
-    {
-      memcpy (&ifaddrclass, ifc->address, sizeof (struct prefix_ipv4));
-      apply_classful_mask_ipv4 (&ifaddrclass);
-      subnetted = 0;
-      if (ifc->address->prefixlen > ifaddrclass.prefixlen)
-        subnetted = 1;
-    }
-
-  for (rp = route_top (rip->table); rp; rp = route_next (rp))
-    if ((rinfo = rp->info) != NULL)
-      {
-	/* For RIPv1, if we are subnetted, output subnets in our network    */
-	/* that have the same mask as the output "interface". For other     */
-	/* networks, only the classfull version is output.                  */
-	
-	if (version == RIPv1)
-	  {
-	    p = (struct prefix_ipv4 *) &rp->p;
-
-	    if (IS_RIP_DEBUG_PACKET)
-	      zlog_debug("RIPv1 mask check, %s/%d considered for output",
-			inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
-
-	    if (subnetted &&
-		prefix_match ((struct prefix *) &ifaddrclass, &rp->p))
-	      {
-		if ((ifc->address->prefixlen != rp->p.prefixlen) &&
-		    (rp->p.prefixlen != 32))
-		  continue;
-	      }
-	    else
-	      {
-		memcpy (&classfull, &rp->p, sizeof(struct prefix_ipv4));
-		apply_classful_mask_ipv4(&classfull);
-		if (rp->p.u.prefix4.s_addr != 0 &&
-		    classfull.prefixlen != rp->p.prefixlen)
-		  continue;
-	      }
-	    if (IS_RIP_DEBUG_PACKET)
-	      zlog_debug("RIPv1 mask check, %s/%d made it through",
-			inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
-	  }
-	else 
-	  p = (struct prefix_ipv4 *) &rp->p;
+  class = rip_out_class_get (ifc, route_type, version);
 
-	/* Apply output filters. */
-	ret = rip_outgoing_filter (p, ri);
-	if (ret < 0)
-	  continue;
-
-	/* Changed route only output. */
-	if (route_type == rip_changed_route &&
-	    (! (rinfo->flags & RIP_RTF_CHANGED)))
-	  continue;
-
-	/* Split horizon. */
-	/* if (split_horizon == rip_split_horizon) */
-	if (ri->split_horizon == RIP_SPLIT_HORIZON)
-	  {
-	    /* 
-	     * We perform split horizon for RIP and connected route. 
-	     * For rip routes, we want to suppress the route if we would
-             * end up sending the route back on the interface that we
-             * learned it from, with a higher metric. For connected routes,
-             * we suppress the route if the prefix is a subset of the
-             * source address that we are going to use for the packet 
-             * (in order to handle the case when multiple subnets are
-             * configured on the same interface).
-             */
-	    if (rinfo->type == ZEBRA_ROUTE_RIP  &&
-                 rinfo->ifindex == ifc->ifp->ifindex) 
-	      continue;
-	    if (rinfo->type == ZEBRA_ROUTE_CONNECT &&
-                 prefix_match((struct prefix *)p, ifc->address))
-	      continue;
-	  }
-
-	/* Preparation for route-map. */
-	rinfo->metric_set = 0;
-	rinfo->nexthop_out.s_addr = 0;
-	rinfo->metric_out = rinfo->metric;
-	rinfo->tag_out = rinfo->tag;
-	rinfo->ifindex_out = ifc->ifp->ifindex;
-
-	/* In order to avoid some local loops,
-	 * if the RIP route has a nexthop via this interface, keep the nexthop,
-	 * otherwise set it to 0. The nexthop should not be propagated
-	 * beyond the local broadcast/multicast area in order
-	 * to avoid an IGP multi-level recursive look-up.
-	 * see (4.4)
-	 */
-	if (rinfo->ifindex == ifc->ifp->ifindex)
-	  rinfo->nexthop_out = rinfo->nexthop;
-
-	/* Interface route-map */
-	if (ri->routemap[RIP_FILTER_OUT])
-	  {
-	    ret = route_map_apply (ri->routemap[RIP_FILTER_OUT], 
-				     (struct prefix *) p, RMAP_RIP, 
-				     rinfo);
-
-	    if (ret == RMAP_DENYMATCH)
-	      {
-	        if (IS_RIP_DEBUG_PACKET)
-	          zlog_debug ("RIP %s/%d is filtered by route-map out",
-			     inet_ntoa (p->prefix), p->prefixlen);
-		  continue;
-	      }
-	  }
-           
-	/* Apply redistribute route map - continue, if deny */
-	if (rip->route_map[rinfo->type].name
-	    && rinfo->sub_type != RIP_ROUTE_INTERFACE)
-	  {
-	    ret = route_map_apply (rip->route_map[rinfo->type].map,
-				   (struct prefix *)p, RMAP_RIP, rinfo);
+  /* Nothing to patch: the packets of the class are ours, if they were
+     authenticated alike, or are kept for the next interface. */
+  if (rip->out_classes && ! rip_out_class_patched (class, ifc))
+    {
+      if (class->packets
+	  && rip_out_class_auth_same (class, ri, key, auth_str))
+	{
+	  for (ALL_LIST_ELEMENTS_RO (class->packets, node, s))
+	    {
+	      ret = rip_send_packet (STREAM_DATA (s), stream_get_endp (s),
+				     to, ifc);
 
-	    if (ret == RMAP_DENYMATCH) 
-	      {
-		if (IS_RIP_DEBUG_PACKET)
-		  zlog_debug ("%s/%d is filtered by route-map",
-			     inet_ntoa (p->prefix), p->prefixlen);
-		continue;
-	      }
-	  }
+	      if (ret >= 0 && IS_RIP_DEBUG_SEND)
+		rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
+				 stream_get_endp (s), "SEND");
+	    }
+	  ri->sent_updates++;
+	  return;
+	}
 
-	/* When route-map does not set metric. */
-	if (! rinfo->metric_set)
-	  {
-	    /* If redistribute metric is set. */
-	    if (rip->route_map[rinfo->type].metric_config
-		&& rinfo->metric != RIP_METRIC_INFINITY)
-	      {
-		rinfo->metric_out = rip->route_map[rinfo->type].metric;
-	      }
-	    else
-	      {
-		/* If the route is not connected or localy generated
-		   one, use default-metric value*/
-		if (rinfo->type != ZEBRA_ROUTE_RIP 
-		    && rinfo->type != ZEBRA_ROUTE_CONNECT
-		    && rinfo->metric != RIP_METRIC_INFINITY)
-		  rinfo->metric_out = rip->default_metric;
-	      }
-	  }
+      if (class->packets)
+	list_delete_all_node (class->packets);
+      else
+	{
+	  class->packets = list_new ();
+	  class->packets->del = (void (*) (void *)) stream_free;
+	}
+      packets = class->packets;
+      class->auth_type = ri->auth_type;
+      class->md5_auth_len = ri->md5_auth_len;
+      class->key_id = key ? key->index % 256 : 1;
+      memcpy (class->auth_str, auth_str, RIP_AUTH_SIMPLE_SIZE);
+    }
 
-	/* Apply offset-list */
-	if (rinfo->metric != RIP_METRIC_INFINITY)
-	  rip_offset_list_apply_out (p, ifc->ifp, &rinfo->metric_out);
-
-	if (rinfo->metric_out > RIP_METRIC_INFINITY)
-	  rinfo->metric_out = RIP_METRIC_INFINITY;
-
-	/* Perform split-horizon with poisoned reverse 
-	 * for RIP and connected routes.
-	 **/
-	if (ri->split_horizon == RIP_SPLIT_HORIZON_POISONED_REVERSE) {
-	    /* 
-	     * We perform split horizon for RIP and connected route. 
-	     * For rip routes, we want to suppress the route if we would
-             * end up sending the route back on the interface that we
-             * learned it from, with a higher metric. For connected routes,
-             * we suppress the route if the prefix is a subset of the
-             * source address that we are going to use for the packet 
-             * (in order to handle the case when multiple subnets are
-             * configured on the same interface).
-             */
-	  if (rinfo->type == ZEBRA_ROUTE_RIP  &&
-	       rinfo->ifindex == ifc->ifp->ifindex)
-	       rinfo->metric_out = RIP_METRIC_INFINITY;
-	  if (rinfo->type == ZEBRA_ROUTE_CONNECT &&
-              prefix_match((struct prefix *)p, ifc->address))
-	       rinfo->metric_out = RIP_METRIC_INFINITY;
+  for (i = 0; i < class->count; i++)
+    {
+      route = &class->routes[i];
+      rinfo = route->rinfo;
+      p = (struct prefix_ipv4 *) &route->rp->p;
+
+      /* Split horizon, and route-maps matching on the interface, are
+         for each interface to apply. */
+      sh = 0;
+      if (route->flags & RIP_OUT_PER_INTERFACE)
+	{
+	  if (rip_output_route (ifc, ri, p, rinfo, route_type, 0) < 0)
+	    continue;
 	}
-	
-	/* Prepare preamble, auth headers, if needs be */
-	if (num == 0)
-	  {
-	    stream_putc (s, RIP_RESPONSE);
-	    stream_putc (s, version);
-	    stream_putw (s, 0);
+      else if (ri->split_horizon != RIP_NO_SPLIT_HORIZON
+	       && rip_split_horizon_route (ifc, p, rinfo))
+	{
+	  if (ri->split_horizon == RIP_SPLIT_HORIZON)
+	    continue;
+	  sh = 1;
+	}
+
+      /* Prepare preamble, auth headers, if needs be */
+      if (num == 0)
+	{
+	  stream_putc (s, RIP_RESPONSE);
+	  stream_putc (s, version);
+	  stream_putw (s, 0);
 	    
-	    /* auth header for !v1 && !no_auth */
-            if ( (ri->auth_type != RIP_NO_AUTH) && (version != RIPv1) )
-              doff = rip_auth_header_write (s, ri, key, auth_str, 
-                                              RIP_AUTH_SIMPLE_SIZE);
-          }
-        
-	/* Write RTE to the stream. */
-	num = rip_write_rte (num, s, p, version, rinfo);
-	if (num == rtemax)
-	  {
-	    if (version == RIPv2 && ri->auth_type == RIP_AUTH_MD5)
-              rip_auth_md5_set (s, ri, doff, auth_str, RIP_AUTH_SIMPLE_SIZE);
+	  /* auth header for !v1 && !no_auth */
+	  if ( (ri->auth_type != RIP_NO_AUTH) && (version != RIPv1) )
+	    doff = rip_auth_header_write (s, ri, key, auth_str, 
+					  RIP_AUTH_SIMPLE_SIZE);
+	}
 
-	    ret = rip_send_packet (STREAM_DATA (s), stream_get_endp (s),
-				   to, ifc);
+      /* Write RTE to the stream, with what differs on this interface:
+         the next hop learnt on it and poisoned reverse. */
+      if (route->flags & RIP_OUT_PER_INTERFACE)
+	num = rip_write_rte (num, s, p, version, rinfo);
+      else
+	{
+	  stream_put (s, STREAM_DATA (class->rtes) + i * RIP_RTE_SIZE,
+		      RIP_RTE_SIZE);
+	  num++;
+	  if (version == RIPv2
+	      && ! (route->flags & RIP_OUT_NEXTHOP_SET)
+	      && rinfo->ifindex == ifc->ifp->ifindex)
+	    memcpy (STREAM_DATA (s) + stream_get_endp (s) - 8,
+		    &rinfo->nexthop, sizeof (struct in_addr));
+	  if (sh)
+	    stream_putl_at (s, stream_get_endp (s) - 4, RIP_METRIC_INFINITY);
+	}
 
-	    if (ret >= 0 && IS_RIP_DEBUG_SEND)
-	      rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
-			       stream_get_endp(s), "SEND");
-	    num = 0;
-	    stream_reset (s);
-	  }
-      }
+      if (num == rtemax)
+	{
+	  if (version == RIPv2 && ri->auth_type == RIP_AUTH_MD5)
+	    rip_auth_md5_set (s, ri, doff, auth_str, RIP_AUTH_SIMPLE_SIZE);
+
+	  ret = rip_send_packet (STREAM_DATA (s), stream_get_endp (s),
+				 to, ifc);
+
+	  if (ret >= 0 && IS_RIP_DEBUG_SEND)
+	    rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
+			     stream_get_endp(s), "SEND");
+	  if (packets)
+	    listnode_add (packets, stream_dup (s));
+	  num = 0;
+	  stream_reset (s);
+	}
+    }
 
   /* Flush unwritten RTE. */
   if (num != 0)
@@ -2416,10 +2843,15 @@ rip_output_process (struct connected *ifc, struct sockaddr_in *to,
       if (ret >= 0 && IS_RIP_DEBUG_SEND)
 	rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
 			 stream_get_endp (s), "SEND");
+      if (packets)
+	listnode_add (packets, stream_dup (s));
       num = 0;
       stream_reset (s);
     }
 
+  if (! rip->out_classes)
+    rip_out_class_free (class);
+
   /* Statistics updates. */
   ri->sent_updates++;
 }
@@ -2483,6 +2915,9 @@ rip_update_process (int route_type)
   struct sockaddr_in to;
   struct prefix_ipv4 *p;
 
+  rip->out_classes = list_new ();
+  rip->out_classes->del = rip_out_class_free;
+
   /* Send RIP update to each interface. */
   for (ALL_LIST_ELEMENTS_RO (iflist, node, ifp))
     {
@@ -2556,6 +2991,9 @@ rip_update_process (int route_type)
 	/* RIP version is rip's configuration. */
 	rip_output_process (connected, &to, route_type, rip->version_send);
       }
+
+  list_delete (rip->out_classes);
+  rip->out_classes = NULL;
 }
 
 /* RIP's periodical timer. */
@@ -2674,9 +3112,7 @@ rip_redistribute_withdraw (int type)
 	  {
 	    /* Perform poisoned reverse. */
 	    rinfo->metric = RIP_METRIC_INFINITY;
-	    RIP_TIMER_ON (rinfo->t_garbage_collect, 
-			  rip_garbage_collect, rip->garbage_time);
-	    RIP_TIMER_OFF (rinfo->t_timeout);
+	    rip_garbage_update (rinfo);
 	    rinfo->flags |= RIP_RTF_CHANGED;
 
 	    if (IS_RIP_DEBUG_EVENT) {
@@ -3379,18 +3815,12 @@ rip_vty_out_uptime (struct vty *vty, struct rip_info *rinfo)
   struct tm *tm;
 #define TIME_BUF 25
   char timebuf [TIME_BUF];
-  struct thread *thread;
 
-  if ((thread = rinfo->t_timeout) != NULL)
-    {
-      clock = thread_timer_remain_second (thread);
-      tm = gmtime (&clock);
-      strftime (timebuf, TIME_BUF, "%M:%S", tm);
-      vty_out (vty, "%5s", timebuf);
-    }
-  else if ((thread = rinfo->t_garbage_collect) != NULL)
+  if (rinfo->age_state != RIP_AGE_NONE)
     {
-      clock = thread_timer_remain_second (thread);
+      clock = rip_age_deadline (rinfo) - recent_relative_time ().tv_sec;
+      if (clock < 0)
+        clock = 0;
       tm = gmtime (&clock);
       strftime (timebuf, TIME_BUF, "%M:%S", tm);
       vty_out (vty, "%5s", timebuf);
@@ -3805,8 +4235,7 @@ rip_clean (void)
 	      rip_zebra_ipv4_delete ((struct prefix_ipv4 *)&rp->p,
 				     &rinfo->nexthop, rinfo->metric);
 	
-	    RIP_TIMER_OFF (rinfo->t_timeout);
-	    RIP_TIMER_OFF (rinfo->t_garbage_collect);
+	    rip_timers_off (rinfo);
 
 	    rp->info = NULL;
 	    route_unlock_node (rp);
@@ -3816,6 +4245,7 @@ rip_clean (void)
 
       /* Cancel RIP related timers. */
       RIP_TIMER_OFF (rip->t_update);
+      RIP_TIMER_OFF (rip->t_age);
       RIP_TIMER_OFF (rip->t_triggered_update);
       RIP_TIMER_OFF (rip->t_triggered_interval);
 
@@ -64,6 +64,9 @@
 /* RIP peer timeout value. */
 #define RIP_PEER_TIMER_DEFAULT         180
 
+/* Slots of the route ageing wheel, one second each. */
+#define RIP_AGE_SLOTS                  256
+
 /* RIP port number. */
 #define RIP_PORT_DEFAULT               520
 #define RIP_VTY_PORT                  2602
@@ -132,6 +135,12 @@ struct rip
   unsigned long timeout_time;
   unsigned long garbage_time;
 
+  /* Route timeout and garbage collection, see rip_age_tick (). */
+  struct rip_info *age_slot[RIP_AGE_SLOTS];
+  unsigned long age_count;
+  time_t age_clock;
+  struct thread *t_age;
+
   /* RIP default metric. */
   int default_metric;
 
@@ -151,6 +160,10 @@ struct rip
     int metric_config;
     u_int32_t metric;
   } route_map[ZEBRA_ROUTE_MAX];
+
+  /* Routes filtered and encoded for the interfaces sending alike,
+     during an update, see rip_output_process (). */
+  struct list *out_classes;
 };
 
 /* RIP routing table entry which belong to rip_packet. */
@@ -212,12 +225,20 @@ struct rip_info
 #define RIP_RTF_CHANGED  2
   u_char flags;
 
-  /* Garbage collect timer. */
-  struct thread *t_timeout;
-  struct thread *t_garbage_collect;
+  /* Timeout or garbage collect ageing, and the ageing wheel slot. */
+#define RIP_AGE_NONE     0
+#define RIP_AGE_TIMEOUT  1
+#define RIP_AGE_GARBAGE  2
+  u_char age_state;
+  time_t age_start;
+  int age_slot;
+  struct rip_info *age_prev;
+  struct rip_info *age_next;
 
   /* Route-map futures - this variables can be changed. */
   struct in_addr nexthop_out;
+  u_char nexthop_set;
+  u_char ifindex_out_used;
   u_char metric_set;
   u_int32_t metric_out;
   u_short tag_out;
@@ -403,6 +424,7 @@ extern void rip_redistribute_delete (int, int, struct prefix_ipv4 *, unsigned in
 extern void rip_redistribute_withdraw (int);
 extern void rip_zebra_ipv4_add (struct prefix_ipv4 *, struct in_addr *, u_int32_t, u_char);
 extern void rip_zebra_ipv4_delete (struct prefix_ipv4 *, struct in_addr *, u_int32_t);
+extern void rip_zebra_ipv4_delete_batch (struct rip_info **, unsigned int);
 extern void rip_interface_multicast_set (int, struct connected *);
 extern void rip_distribute_update_interface (struct interface *);
 extern void rip_if_rmap_update_interface (struct interface *);
@@ -421,6 +443,7 @@ extern struct rip_peer *rip_peer_lookup_next (struct in_addr *);
 
 extern int rip_offset_list_apply_in (struct prefix_ipv4 *, struct interface *, u_int32_t *);
 extern int rip_offset_list_apply_out (struct prefix_ipv4 *, struct interface *, u_int32_t *);
+extern struct rip_offset_list *rip_offset_list_out (struct interface *);
 extern void rip_offset_clean (void);
 
 extern void rip_info_free (struct rip_info *);
@@ -48,6 +48,7 @@ struct ripng_rte_data {
   struct prefix_ipv6 *p;
   struct ripng_info *rinfo;
   struct ripng_aggregate *aggregate;
+  unsigned int seq;
 };
 
 void _ripng_rte_del(struct ripng_rte_data *A);
@@ -65,7 +66,6 @@ ripng_rte_new(void) {
   struct list *rte;
 
   rte = list_new();
-  rte->cmp = (int (*)(void *, void *)) _ripng_rte_cmp;
   rte->del = (void (*)(void *)) _ripng_rte_del;
 
   return rte;
@@ -92,7 +92,20 @@ _ripng_rte_cmp(struct ripng_rte_data *A, struct ripng_rte_data *B) {
   return addr6_cmp(NEXTHOP_OUT_PTR(A), NEXTHOP_OUT_PTR(B));
 }
 
-/* Add routing table entry */
+/* Order RTEs by nexthop, and as they were added for the same nexthop. */
+static int
+_ripng_rte_sort_cmp(const void *a, const void *b) {
+  struct ripng_rte_data *A = *(struct ripng_rte_data * const *) a;
+  struct ripng_rte_data *B = *(struct ripng_rte_data * const *) b;
+  int ret;
+
+  ret = _ripng_rte_cmp(A, B);
+  if (ret)
+    return ret;
+  return (A->seq > B->seq) - (A->seq < B->seq);
+}
+
+/* Add routing table entry, ripng_rte_send() sorts them */
 void
 ripng_rte_add(struct list *ripng_rte_list, struct prefix_ipv6 *p,
               struct ripng_info *rinfo, struct ripng_aggregate *aggregate) {
@@ -106,8 +119,9 @@ ripng_rte_add(struct list *ripng_rte_list, struct prefix_ipv6 *p,
   data->p     = p;
   data->rinfo = rinfo;
   data->aggregate = aggregate;
+  data->seq = listcount(ripng_rte_list);
 
-  listnode_add_sort(ripng_rte_list, data);
+  listnode_add(ripng_rte_list, data);
 } 
 
 /* Send the RTE with the nexthop support
@@ -117,7 +131,9 @@ ripng_rte_send(struct list *ripng_rte_list, struct interface *ifp,
                struct sockaddr_in6 *to) {
 
   struct ripng_rte_data *data;
-  struct listnode *node, *nnode;
+  struct ripng_rte_data **sorted;
+  struct listnode *node;
+  unsigned int i, count;
 
   struct in6_addr last_nexthop;
   struct in6_addr myself_nexthop;
@@ -154,7 +170,17 @@ ripng_rte_send(struct list *ripng_rte_list, struct interface *ifp,
 	    sizeof (struct ripng_packet) +
 	    sizeof (struct rte)) / sizeof (struct rte);
 
-  for (ALL_LIST_ELEMENTS (ripng_rte_list, node, nnode, data)) {
+  /* Sorted once, rather than as each RTE is added */
+  count = listcount(ripng_rte_list);
+  sorted = XMALLOC(MTYPE_RIPNG_RTE_DATA, (count + 1) * sizeof(*sorted));
+  i = 0;
+  for (ALL_LIST_ELEMENTS_RO (ripng_rte_list, node, data))
+    sorted[i++] = data;
+  qsort(sorted, count, sizeof(*sorted), _ripng_rte_sort_cmp);
+
+  for (i = 0; i < count; i++) {
+    data = sorted[i];
+
     /* (2.1) Next hop support */
     if (!IPV6_ADDR_SAME(&last_nexthop, NEXTHOP_OUT_PTR(data))) {
 
@@ -201,6 +227,8 @@ ripng_rte_send(struct list *ripng_rte_list, struct interface *ifp,
     }
   }
 
+  XFREE(MTYPE_RIPNG_RTE_DATA, sorted);
+
   /* If unwritten RTE exist, flush it. */
   if (num != 0) {
     ret = ripng_send_packet ((caddr_t) STREAM_DATA (s), stream_get_endp (s),
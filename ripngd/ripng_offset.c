@@ -248,32 +248,36 @@ ripng_offset_list_apply_in (struct prefix_ipv6 *p, struct interface *ifp,
   return 0;
 }
 
-/* If metric is modifed return 1. */
-int
-ripng_offset_list_apply_out (struct prefix_ipv6 *p, struct interface *ifp,
-			     u_char *metric)
+/* The offset-list applied to updates sent on ifp, if any.  Updates on
+   interfaces getting the same one are offset alike. */
+struct ripng_offset_list *
+ripng_offset_list_out (struct interface *ifp)
 {
   struct ripng_offset_list *offset;
-  struct access_list *alist;
 
   /* Look up offset-list with interface name. */
   offset = ripng_offset_list_lookup (ifp->name);
   if (offset && OFFSET_LIST_OUT_NAME (offset))
-    {
-      alist = access_list_lookup (AFI_IP6, OFFSET_LIST_OUT_NAME (offset));
-
-      if (alist 
-	  && access_list_apply (alist, (struct prefix *)p) == FILTER_PERMIT)
-	{
-	  *metric += OFFSET_LIST_OUT_METRIC (offset);
-	  return 1;
-	}
-      return 0;
-    }
+    return offset;
 
   /* Look up offset-list without interface name. */
   offset = ripng_offset_list_lookup (NULL);
   if (offset && OFFSET_LIST_OUT_NAME (offset))
+    return offset;
+
+  return NULL;
+}
+
+/* If metric is modifed return 1. */
+int
+ripng_offset_list_apply_out (struct prefix_ipv6 *p, struct interface *ifp,
+			     u_char *metric)
+{
+  struct ripng_offset_list *offset;
+  struct access_list *alist;
+
+  offset = ripng_offset_list_out (ifp);
+  if (offset)
     {
       alist = access_list_lookup (AFI_IP6, OFFSET_LIST_OUT_NAME (offset));
 
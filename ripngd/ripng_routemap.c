@@ -403,6 +403,7 @@ route_set_ipv6_nexthop_local (void *rule, struct prefix *prefix,
     
       /* Set next hop value. */ 
       rinfo->nexthop_out = *address;
+      rinfo->nexthop_set = 1;
     }
 
   return RMAP_OKAY;
@@ -24,10 +24,12 @@
 
 #include "command.h"
 #include "prefix.h"
+#include "table.h"
 #include "stream.h"
 #include "routemap.h"
 #include "zclient.h"
 #include "log.h"
+#include "memory.h"
 
 #include "ripngd/ripngd.h"
 
@@ -90,6 +92,71 @@ ripng_zebra_ipv6_delete (struct prefix_ipv6 *p, struct in6_addr *nexthop,
     }
 }
 
+static int
+ripng_info_nexthop_cmp (const void *a, const void *b)
+{
+  const struct ripng_info *ra = *(struct ripng_info * const *) a;
+  const struct ripng_info *rb = *(struct ripng_info * const *) b;
+  int ret;
+
+  ret = memcmp (&ra->nexthop, &rb->nexthop, sizeof (struct in6_addr));
+  if (ret)
+    return ret;
+  if (ra->ifindex < rb->ifindex)
+    return -1;
+  if (ra->ifindex > rb->ifindex)
+    return 1;
+  return 0;
+}
+
+/* Delete many routes at once, as when they time out together.  Routes
+   through the same nexthop and interface share one message. */
+void
+ripng_zebra_ipv6_delete_batch (struct ripng_info **rinfo, unsigned int count)
+{
+  struct ripng_info **sorted;
+  struct prefix_ipv6 **prefixes;
+  struct in6_addr *nexthop;
+  unsigned int ifindex;
+  struct zapi_ipv6 api;
+  unsigned int i, j, n;
+
+  if (! zclient->redist[ZEBRA_ROUTE_RIPNG] || count == 0)
+    return;
+
+  sorted = XMALLOC (MTYPE_TMP, count * sizeof (struct ripng_info *));
+  prefixes = XMALLOC (MTYPE_TMP, count * sizeof (struct prefix_ipv6 *));
+  memcpy (sorted, rinfo, count * sizeof (struct ripng_info *));
+  qsort (sorted, count, sizeof (struct ripng_info *), ripng_info_nexthop_cmp);
+
+  api.type = ZEBRA_ROUTE_RIPNG;
+  api.flags = 0;
+  api.message = 0;
+  api.safi = SAFI_UNICAST;
+  SET_FLAG (api.message, ZAPI_MESSAGE_NEXTHOP);
+  api.nexthop_num = 1;
+  api.nexthop = &nexthop;
+  SET_FLAG (api.message, ZAPI_MESSAGE_IFINDEX);
+  api.ifindex_num = 1;
+  api.ifindex = &ifindex;
+
+  for (i = 0; i < count; i = j)
+    {
+      nexthop = &sorted[i]->nexthop;
+      ifindex = sorted[i]->ifindex;
+      for (j = i, n = 0;
+           j < count && ripng_info_nexthop_cmp (&sorted[i], &sorted[j]) == 0;
+           j++)
+        prefixes[n++] = (struct prefix_ipv6 *) &sorted[j]->rp->p;
+
+      zapi_ipv6_route_bulk (ZEBRA_IPV6_ROUTE_DELETE, zclient, prefixes, n,
+                            &api);
+    }
+
+  XFREE (MTYPE_TMP, prefixes);
+  XFREE (MTYPE_TMP, sorted);
+}
+
 /* Zebra route add and delete treatment. */
 static int
 ripng_zebra_read_ipv6 (int command, struct zclient *zclient,
@@ -62,6 +62,9 @@ ripng_output_process (struct interface *, struct sockaddr_in6 *, int);
 int
 ripng_triggered_update (struct thread *);
 
+static void
+ripng_out_class_free (void *);
+
 /* RIPng next hop specification. */
 struct ripng_nexthop
 {
@@ -404,18 +407,111 @@ ripng_lladdr_check (struct interface *ifp, struct in6_addr *addr)
   return 0;
 }
 
-/* RIPng route garbage collect timer. */
-static int
-ripng_garbage_collect (struct thread *t)
+/* Route timeouts and garbage collection run off a wheel of one-second
+   slots rather than two timer threads per route.  A route sits in the
+   slot of its deadline, or of an earlier one: refreshing a route only
+   moves its start time, and the route is moved to its new slot when
+   the old one comes round.  A single thread turns the wheel and handles
+   all the routes that expired in the same second together. */
+static time_t
+ripng_age_deadline (struct ripng_info *rinfo)
 {
-  struct ripng_info *rinfo;
-  struct route_node *rp;
+  if (rinfo->age_state == RIPNG_AGE_GARBAGE)
+    return rinfo->age_start + ripng->garbage_time;
+  return rinfo->age_start + ripng->timeout_time;
+}
+
+static int ripng_age_tick (struct thread *);
+static int ripng_age_ticking = 0;
+
+static void
+ripng_age_link (struct ripng_info *rinfo, time_t deadline)
+{
+  int slot;
 
-  rinfo = THREAD_ARG (t);
-  rinfo->t_garbage_collect = NULL;
+  /* The wheel is empty unless it turns; resume it from now. */
+  if (! ripng->t_age && ! ripng_age_ticking)
+    {
+      ripng->age_clock = recent_relative_time ().tv_sec;
+      ripng->t_age = thread_add_timer (master, ripng_age_tick, NULL, 1);
+    }
 
-  /* Off timeout timer. */
-  RIPNG_TIMER_OFF (rinfo->t_timeout);
+  if (deadline <= ripng->age_clock)
+    deadline = ripng->age_clock + 1;
+
+  slot = deadline % RIPNG_AGE_SLOTS;
+  rinfo->age_slot = slot;
+  rinfo->age_prev = NULL;
+  rinfo->age_next = ripng->age_slot[slot];
+  if (rinfo->age_next)
+    rinfo->age_next->age_prev = rinfo;
+  ripng->age_slot[slot] = rinfo;
+  ripng->age_count++;
+}
+
+static void
+ripng_age_unlink (struct ripng_info *rinfo)
+{
+  if (rinfo->age_prev)
+    rinfo->age_prev->age_next = rinfo->age_next;
+  else
+    ripng->age_slot[rinfo->age_slot] = rinfo->age_next;
+  if (rinfo->age_next)
+    rinfo->age_next->age_prev = rinfo->age_prev;
+  rinfo->age_prev = rinfo->age_next = NULL;
+
+  if (--ripng->age_count == 0 && ! ripng_age_ticking)
+    RIPNG_TIMER_OFF (ripng->t_age);
+}
+
+/* Stop the timeout or garbage collection of a route. */
+static void
+ripng_timers_off (struct ripng_info *rinfo)
+{
+  if (rinfo->age_state == RIPNG_AGE_NONE)
+    return;
+
+  ripng_age_unlink (rinfo);
+  rinfo->age_state = RIPNG_AGE_NONE;
+}
+
+/* Start the garbage collection of a route, unless already started. */
+static void
+ripng_garbage_update (struct ripng_info *rinfo)
+{
+  if (rinfo->age_state == RIPNG_AGE_GARBAGE)
+    return;
+
+  ripng_timers_off (rinfo);
+  rinfo->age_state = RIPNG_AGE_GARBAGE;
+  rinfo->age_start = recent_relative_time ().tv_sec;
+  ripng_age_link (rinfo, ripng_age_deadline (rinfo));
+}
+
+static void
+ripng_timeout_update (struct ripng_info *rinfo)
+{
+  if (rinfo->metric != RIPNG_METRIC_INFINITY)
+    {
+      if (rinfo->age_state != RIPNG_AGE_TIMEOUT)
+        {
+          ripng_timers_off (rinfo);
+          rinfo->age_state = RIPNG_AGE_TIMEOUT;
+          rinfo->age_start = recent_relative_time ().tv_sec;
+          ripng_age_link (rinfo, ripng_age_deadline (rinfo));
+        }
+      else
+        rinfo->age_start = recent_relative_time ().tv_sec;
+    }
+}
+
+/* RIPng route garbage collect. */
+static void
+ripng_garbage_collect (struct ripng_info *rinfo)
+{
+  struct route_node *rp;
+
+  ripng_timers_off (rinfo);
   
   /* Get route_node pointer. */
   rp = rinfo->rp;
@@ -426,56 +522,108 @@ ripng_garbage_collect (struct thread *t)
 
   /* Free RIPng routing information. */
   ripng_info_free (rinfo);
-
-  return 0;
 }
 
-/* Timeout RIPng routes. */
-static int
-ripng_timeout (struct thread *t)
+/* Timeout RIPng routes.  Deleting the routes from zebra and triggering
+   an update is left to the caller, to be done once for all the routes
+   timed out together. */
+static void
+ripng_timeout (struct ripng_info *rinfo)
 {
-  struct ripng_info *rinfo;
-  struct route_node *rp;
-
-  rinfo = THREAD_ARG (t);
-  rinfo->t_timeout = NULL;
-
-  /* Get route_node pointer. */
-  rp = rinfo->rp;
-
   /* - The garbage-collection timer is set for 120 seconds. */
-  RIPNG_TIMER_ON (rinfo->t_garbage_collect, ripng_garbage_collect, 
-		  ripng->garbage_time);
+  ripng_garbage_update (rinfo);
 
-  /* Delete this route from the kernel. */
-  ripng_zebra_ipv6_delete ((struct prefix_ipv6 *)&rp->p, &rinfo->nexthop,
-				rinfo->ifindex);
   /* - The metric for the route is set to 16 (infinity).  This causes
      the route to be removed from service. */
   rinfo->metric = RIPNG_METRIC_INFINITY;
   rinfo->flags &= ~RIPNG_RTF_FIB;
 
   /* Aggregate count decrement. */
-  ripng_aggregate_decrement (rp, rinfo);
+  ripng_aggregate_decrement (rinfo->rp, rinfo);
 
   /* - The route change flag is to indicate that this entry has been
      changed. */
   rinfo->flags |= RIPNG_RTF_CHANGED;
+}
 
-  /* - The output process is signalled to trigger a response. */
-  ripng_event (RIPNG_TRIGGERED_UPDATE, 0);
+static int
+ripng_age_tick (struct thread *t)
+{
+  time_t now, deadline;
+  struct ripng_info *rinfo, *next;
+  struct ripng_info **timedout = NULL;
+  unsigned int count = 0, size = 0;
+
+  ripng->t_age = NULL;
+  ripng_age_ticking = 1;
+  now = recent_relative_time ().tv_sec;
+
+  /* Every route on the wheel is looked at once per turn. */
+  if (now - ripng->age_clock > RIPNG_AGE_SLOTS)
+    ripng->age_clock = now - RIPNG_AGE_SLOTS;
+
+  while (ripng->age_clock < now)
+    {
+      int slot;
+
+      ripng->age_clock++;
+      slot = ripng->age_clock % RIPNG_AGE_SLOTS;
+
+      /* Take the whole slot off the wheel, routes put back into it
+         are a turn away. */
+      rinfo = ripng->age_slot[slot];
+      ripng->age_slot[slot] = NULL;
+
+      for (; rinfo; rinfo = next)
+        {
+          next = rinfo->age_next;
+          rinfo->age_prev = rinfo->age_next = NULL;
+          ripng->age_count--;
+
+          deadline = ripng_age_deadline (rinfo);
+          if (deadline > now)
+            {
+              /* Refreshed since it was put here, or a later turn. */
+              ripng_age_link (rinfo, deadline);
+              continue;
+            }
+
+          if (rinfo->age_state == RIPNG_AGE_GARBAGE)
+            {
+              rinfo->age_state = RIPNG_AGE_NONE;
+              ripng_garbage_collect (rinfo);
+              continue;
+            }
+
+          if (count == size)
+            {
+              size = size ? size * 2 : 64;
+              timedout = XREALLOC (MTYPE_TMP, timedout,
+                                   size * sizeof (struct ripng_info *));
+            }
+          timedout[count++] = rinfo;
+
+          rinfo->age_state = RIPNG_AGE_NONE;
+          ripng_timeout (rinfo);
+        }
+    }
 
-  return 0;
-}
+  ripng_age_ticking = 0;
 
-static void
-ripng_timeout_update (struct ripng_info *rinfo)
-{
-  if (rinfo->metric != RIPNG_METRIC_INFINITY)
+  if (count)
     {
-      RIPNG_TIMER_OFF (rinfo->t_timeout);
-      RIPNG_TIMER_ON (rinfo->t_timeout, ripng_timeout, ripng->timeout_time);
+      /* Delete this route from the kernel, in one go for all of them. */
+      ripng_zebra_ipv6_delete_batch (timedout, count);
+      XFREE (MTYPE_TMP, timedout);
+
+      /* - The output process is signalled to trigger a response. */
+      ripng_event (RIPNG_TRIGGERED_UPDATE, 0);
     }
+
+  if (ripng->age_count)
+    ripng->t_age = thread_add_timer (master, ripng_age_tick, NULL, 1);
+
+  return 0;
 }
 
 static int
@@ -841,7 +989,7 @@ ripng_route_process (struct rte *rte, struct sockaddr_in6 *from,
 	      rinfo->type = ZEBRA_ROUTE_RIPNG;
 	      rinfo->sub_type = RIPNG_ROUTE_RTE;
 
-	      RIPNG_TIMER_OFF (rinfo->t_garbage_collect);
+	      ripng_timers_off (rinfo);
 
 	      if (! IPV6_ADDR_SAME (&rinfo->nexthop, nexthop))
 		IPV6_ADDR_COPY (&rinfo->nexthop, nexthop);
@@ -884,9 +1032,7 @@ ripng_route_process (struct rte *rte, struct sockaddr_in6 *from,
 	      if (oldmetric != RIPNG_METRIC_INFINITY)
 		{
 		  /* - The garbage-collection timer is set for 120 seconds. */
-		  RIPNG_TIMER_ON (rinfo->t_garbage_collect, 
-				  ripng_garbage_collect, ripng->garbage_time);
-		  RIPNG_TIMER_OFF (rinfo->t_timeout);
+		  ripng_garbage_update (rinfo);
 
 		  /* - The metric for the route is set to 16
 		     (infinity).  This causes the route to be removed
@@ -963,8 +1109,7 @@ ripng_redistribute_add (int type, int sub_type, struct prefix_ipv6 *p,
 	}
       }
       
-      RIPNG_TIMER_OFF (rinfo->t_timeout);
-      RIPNG_TIMER_OFF (rinfo->t_garbage_collect);
+      ripng_timers_off (rinfo);
 
       /* Tells the other daemons about the deletion of
        * this RIPng route
@@ -1048,9 +1193,7 @@ ripng_redistribute_delete (int type, int sub_type, struct prefix_ipv6 *p,
 	{
 	  /* Perform poisoned reverse. */
 	  rinfo->metric = RIPNG_METRIC_INFINITY;
-	  RIPNG_TIMER_ON (rinfo->t_garbage_collect, 
-			ripng_garbage_collect, ripng->garbage_time);
-	  RIPNG_TIMER_OFF (rinfo->t_timeout);
+	  ripng_garbage_update (rinfo);
 
 	  /* Aggregate count decrement. */
 	  ripng_aggregate_decrement (rp, rinfo);
@@ -1085,9 +1228,7 @@ ripng_redistribute_withdraw (int type)
 	  {
 	    /* Perform poisoned reverse. */
 	    rinfo->metric = RIPNG_METRIC_INFINITY;
-	    RIPNG_TIMER_ON (rinfo->t_garbage_collect, 
-			  ripng_garbage_collect, ripng->garbage_time);
-	    RIPNG_TIMER_OFF (rinfo->t_timeout);
+	    ripng_garbage_update (rinfo);
 
 	    /* Aggregate count decrement. */
 	    ripng_aggregate_decrement (rp, rinfo);
@@ -1446,6 +1587,9 @@ ripng_update (struct thread *t)
   if (IS_RIPNG_DEBUG_EVENT)
     zlog_debug ("RIPng update timer expired!");
 
+  ripng->out_classes = list_new ();
+  ripng->out_classes->del = ripng_out_class_free;
+
   /* Supply routes to each interface. */
   for (ALL_LIST_ELEMENTS_RO (iflist, node, ifp))
     {
@@ -1476,6 +1620,9 @@ ripng_update (struct thread *t)
       ripng_output_process (ifp, NULL, ripng_all_route);
     }
 
+  list_delete (ripng->out_classes);
+  ripng->out_classes = NULL;
+
   /* Triggered updates may be suppressed if a regular update is due by
      the time the triggered update would be sent. */
   if (ripng->t_triggered_interval)
@@ -1530,6 +1677,9 @@ ripng_triggered_update (struct thread *t)
 
   /* Split Horizon processing is done when generating triggered
      updates as well as normal updates (see section 2.6). */
+  ripng->out_classes = list_new ();
+  ripng->out_classes->del = ripng_out_class_free;
+
   for (ALL_LIST_ELEMENTS_RO (iflist, node, ifp))
     {
       ri = ifp->info;
@@ -1548,6 +1698,9 @@ ripng_triggered_update (struct thread *t)
       ripng_output_process (ifp, NULL, ripng_changed_route);
     }
 
+  list_delete (ripng->out_classes);
+  ripng->out_classes = NULL;
+
   /* Once all of the triggered updates have been generated, the route
      change flags should be cleared. */
   ripng_clear_changed_flag ();
@@ -1593,228 +1746,418 @@ ripng_write_rte (int num, struct stream *s, struct prefix_ipv6 *p,
   return ++num;
 }
 
-/* Send RESPONSE message to specified destination. */
-void
-ripng_output_process (struct interface *ifp, struct sockaddr_in6 *to,
-		      int route_type)
+/* Routes going out on the interfaces sending alike.
+
+   What ripng_output_process () sends on an interface depends on its
+   distribute-lists, route-map and offset-list, and, route by route, on
+   which interface it is: split horizon and keeping a next hop learnt on
+   the interface.  The routes are filtered once per set of settings
+   during an update, and the interfaces sharing them only patch the
+   rest in. */
+struct ripng_out_class
+{
+  /* Settings of the interfaces in the class. */
+  int route_type;
+  struct access_list *alist;
+  struct prefix_list *plist;
+  struct route_map *routemap;
+  struct ripng_offset_list *offset;
+
+  /* Routes and aggregates passing the filters, in table order, as
+     sent on an interface none of them is learnt on. */
+  struct ripng_out_route *routes;
+  int count;
+  int size;
+};
+
+struct ripng_out_route
 {
-  int ret;
   struct route_node *rp;
   struct ripng_info *rinfo;
-  struct ripng_interface *ri;
   struct ripng_aggregate *aggregate;
-  struct prefix_ipv6 *p;
-  struct list * ripng_rte_list;
+  struct in6_addr nexthop;
+  u_short tag;
+  u_char metric;
 
-  if (IS_RIPNG_DEBUG_EVENT) {
-    if (to)
-      zlog_debug ("RIPng update routes to neighbor %s",
-                 inet6_ntoa(to->sin6_addr));
-    else
-      zlog_debug ("RIPng update routes on interface %s", ifp->name);
+  /* The next hop was set by a route-map. */
+#define RIPNG_OUT_NEXTHOP_SET	1
+  u_char flags;
+};
+
+/* Filters the route for output on ifp, leaving what to send in the
+   _out fields of rinfo.  Returns -1 if it is not sent.  If shared by a
+   class, split horizon and the next hop learnt on ifp are left out. */
+static int
+ripng_output_route (struct interface *ifp, struct prefix_ipv6 *p,
+		    struct ripng_info *rinfo, int route_type, int shared)
+{
+  struct ripng_interface *ri = ifp->info;
+  int ret;
+
+  /* If no route-map are applied, the RTE will be these following
+   * informations.
+   */
+  rinfo->metric_out = rinfo->metric;
+  rinfo->tag_out    = rinfo->tag;
+  memset(&rinfo->nexthop_out, 0, sizeof(rinfo->nexthop_out));
+  /* In order to avoid some local loops,
+   * if the RIPng route has a nexthop via this interface, keep the nexthop,
+   * otherwise set it to 0. The nexthop should not be propagated
+   * beyond the local broadcast/multicast area in order
+   * to avoid an IGP multi-level recursive look-up.
+   */
+  if (! shared && rinfo->ifindex == ifp->ifindex)
+    rinfo->nexthop_out = rinfo->nexthop;
+
+  /* Apply output filters. */
+  ret = ripng_outgoing_filter (p, ri);
+  if (ret < 0)
+    return -1;
+
+  /* Changed route only output. */
+  if (route_type == ripng_changed_route &&
+      (! (rinfo->flags & RIPNG_RTF_CHANGED)))
+    return -1;
+
+  /* Split horizon. */
+  if (! shared && ri->split_horizon == RIPNG_SPLIT_HORIZON)
+  {
+    /* We perform split horizon for RIPng routes. */
+    if ((rinfo->type == ZEBRA_ROUTE_RIPNG) &&
+	rinfo->ifindex == ifp->ifindex)
+      return -1;
   }
 
-  /* Get RIPng interface. */
-  ri = ifp->info;
- 
-  ripng_rte_list = ripng_rte_new();
- 
-  for (rp = route_top (ripng->table); rp; rp = route_next (rp))
+  /* Preparation for route-map. */
+  rinfo->metric_set = 0;
+  rinfo->nexthop_set = 0;
+  /* nexthop_out,
+   * metric_out
+   * and tag_out are already initialized.
+   */
+
+  /* Interface route-map */
+  if (ri->routemap[RIPNG_FILTER_OUT])
     {
-      if ((rinfo = rp->info) != NULL && rinfo->suppress == 0)
+      ret = route_map_apply (ri->routemap[RIPNG_FILTER_OUT], 
+			     (struct prefix *) p, RMAP_RIPNG, 
+			     rinfo);
+
+      if (ret == RMAP_DENYMATCH)
 	{
-	  /* If no route-map are applied, the RTE will be these following
-	   * informations.
-	   */
-	  p = (struct prefix_ipv6 *) &rp->p;
-	  rinfo->metric_out = rinfo->metric;
-	  rinfo->tag_out    = rinfo->tag;
-	  memset(&rinfo->nexthop_out, 0, sizeof(rinfo->nexthop_out));
-	  /* In order to avoid some local loops,
-	   * if the RIPng route has a nexthop via this interface, keep the nexthop,
-	   * otherwise set it to 0. The nexthop should not be propagated
-	   * beyond the local broadcast/multicast area in order
-	   * to avoid an IGP multi-level recursive look-up.
-	   */
-	  if (rinfo->ifindex == ifp->ifindex)
-	    rinfo->nexthop_out = rinfo->nexthop;
-
-	  /* Apply output filters. */
-	  ret = ripng_outgoing_filter (p, ri);
-	  if (ret < 0)
-	    continue;
+	  if (IS_RIPNG_DEBUG_PACKET)
+	    zlog_debug ("RIPng %s/%d is filtered by route-map out",
+		       inet6_ntoa (p->prefix), p->prefixlen);
+	  return -1;
+	}
 
-	  /* Changed route only output. */
-	  if (route_type == ripng_changed_route &&
-	      (! (rinfo->flags & RIPNG_RTF_CHANGED)))
-	    continue;
+    }
 
-	  /* Split horizon. */
-	  if (ri->split_horizon == RIPNG_SPLIT_HORIZON)
-	  {
-	    /* We perform split horizon for RIPng routes. */
-	    if ((rinfo->type == ZEBRA_ROUTE_RIPNG) &&
-		rinfo->ifindex == ifp->ifindex)
-	      continue;
-	  }
+  /* Redistribute route-map. */
+  if (ripng->route_map[rinfo->type].name)
+    {
+      ret = route_map_apply (ripng->route_map[rinfo->type].map,
+			     (struct prefix *) p, RMAP_RIPNG,
+			     rinfo);
+
+      if (ret == RMAP_DENYMATCH)
+	{
+	  if (IS_RIPNG_DEBUG_PACKET)
+	    zlog_debug ("RIPng %s/%d is filtered by route-map",
+		       inet6_ntoa (p->prefix), p->prefixlen);
+	  return -1;
+	}
+    }
 
-	  /* Preparation for route-map. */
-	  rinfo->metric_set = 0;
-	  /* nexthop_out,
-	   * metric_out
-	   * and tag_out are already initialized.
-	   */
+  /* When the route-map does not set metric. */
+  if (! rinfo->metric_set)
+    {
+      /* If the redistribute metric is set. */
+      if (ripng->route_map[rinfo->type].metric_config
+	  && rinfo->metric != RIPNG_METRIC_INFINITY)
+	{
+	  rinfo->metric_out = ripng->route_map[rinfo->type].metric;
+	}
+      else
+	{
+	  /* If the route is not connected or localy generated
+	     one, use default-metric value */
+	  if (rinfo->type != ZEBRA_ROUTE_RIPNG
+	      && rinfo->type != ZEBRA_ROUTE_CONNECT
+	      && rinfo->metric != RIPNG_METRIC_INFINITY)
+	    rinfo->metric_out = ripng->default_metric;
+	}
+    }
 
-	  /* Interface route-map */
-	  if (ri->routemap[RIPNG_FILTER_OUT])
-	    {
-	      int ret;
+  /* Apply offset-list */
+  if (rinfo->metric_out != RIPNG_METRIC_INFINITY)
+    ripng_offset_list_apply_out (p, ifp, &rinfo->metric_out);
 
-	      ret = route_map_apply (ri->routemap[RIPNG_FILTER_OUT], 
-				     (struct prefix *) p, RMAP_RIPNG, 
-				     rinfo);
+  if (rinfo->metric_out > RIPNG_METRIC_INFINITY)
+    rinfo->metric_out = RIPNG_METRIC_INFINITY;
 
-	      if (ret == RMAP_DENYMATCH)
-		{
-		  if (IS_RIPNG_DEBUG_PACKET)
-		    zlog_debug ("RIPng %s/%d is filtered by route-map out",
-			       inet6_ntoa (p->prefix), p->prefixlen);
-		  continue;
-		}
+  /* Perform split-horizon with poisoned reverse 
+   * for RIPng routes.
+   **/
+  if (! shared && ri->split_horizon == RIPNG_SPLIT_HORIZON_POISONED_REVERSE) {
+    if ((rinfo->type == ZEBRA_ROUTE_RIPNG) &&
+	 rinfo->ifindex == ifp->ifindex)
+	 rinfo->metric_out = RIPNG_METRIC_INFINITY;
+  }
 
-	    }
+  return 0;
+}
 
-	  /* Redistribute route-map. */
-	  if (ripng->route_map[rinfo->type].name)
-	    {
-	      int ret;
+/* Same for the aggregated RTE, which does not depend on which interface
+   it goes out on. */
+static int
+ripng_output_aggregate (struct interface *ifp, struct prefix_ipv6 *p,
+			struct ripng_aggregate *aggregate, int route_type)
+{
+  struct ripng_interface *ri = ifp->info;
+  int ret;
 
-	      ret = route_map_apply (ripng->route_map[rinfo->type].map,
-				     (struct prefix *) p, RMAP_RIPNG,
-				     rinfo);
+  /* If no route-map are applied, the RTE will be these following
+   * informations.
+   */
+  aggregate->metric_set = 0;
+  aggregate->metric_out = aggregate->metric;
+  aggregate->tag_out    = aggregate->tag;
+  memset(&aggregate->nexthop_out, 0, sizeof(aggregate->nexthop_out));
 
-	      if (ret == RMAP_DENYMATCH)
-		{
-		  if (IS_RIPNG_DEBUG_PACKET)
-		    zlog_debug ("RIPng %s/%d is filtered by route-map",
-			       inet6_ntoa (p->prefix), p->prefixlen);
-		  continue;
-		}
-	    }
+  /* Apply output filters.*/
+  ret = ripng_outgoing_filter (p, ri);
+  if (ret < 0)
+    return -1;
 
-	  /* When the route-map does not set metric. */
-	  if (! rinfo->metric_set)
-	    {
-	      /* If the redistribute metric is set. */
-	      if (ripng->route_map[rinfo->type].metric_config
-		  && rinfo->metric != RIPNG_METRIC_INFINITY)
-		{
-		  rinfo->metric_out = ripng->route_map[rinfo->type].metric;
-		}
-	      else
-		{
-		  /* If the route is not connected or localy generated
-		     one, use default-metric value */
-		  if (rinfo->type != ZEBRA_ROUTE_RIPNG
-		      && rinfo->type != ZEBRA_ROUTE_CONNECT
-		      && rinfo->metric != RIPNG_METRIC_INFINITY)
-		    rinfo->metric_out = ripng->default_metric;
-		}
-	    }
+  /* Interface route-map */
+  if (ri->routemap[RIPNG_FILTER_OUT])
+    {
+      struct ripng_info newinfo;
 
-          /* Apply offset-list */
-	  if (rinfo->metric_out != RIPNG_METRIC_INFINITY)
-            ripng_offset_list_apply_out (p, ifp, &rinfo->metric_out);
+      /* let's cast the aggregate structure to ripng_info */
+      memset (&newinfo, 0, sizeof (struct ripng_info));
+      /* the nexthop is :: */
+      newinfo.metric = aggregate->metric;
+      newinfo.metric_out = aggregate->metric_out;
+      newinfo.tag = aggregate->tag;
+      newinfo.tag_out = aggregate->tag_out;
 
-          if (rinfo->metric_out > RIPNG_METRIC_INFINITY)
-            rinfo->metric_out = RIPNG_METRIC_INFINITY;
+      ret = route_map_apply (ri->routemap[RIPNG_FILTER_OUT], 
+			     (struct prefix *) p, RMAP_RIPNG, 
+			     &newinfo);
 
-	  /* Perform split-horizon with poisoned reverse 
-	   * for RIPng routes.
-	   **/
-	  if (ri->split_horizon == RIPNG_SPLIT_HORIZON_POISONED_REVERSE) {
-	    if ((rinfo->type == ZEBRA_ROUTE_RIPNG) &&
-	         rinfo->ifindex == ifp->ifindex)
-	         rinfo->metric_out = RIPNG_METRIC_INFINITY;
-	  }
+      if (ret == RMAP_DENYMATCH)
+	{
+	  if (IS_RIPNG_DEBUG_PACKET)
+	    zlog_debug ("RIPng %s/%d is filtered by route-map out",
+		       inet6_ntoa (p->prefix), p->prefixlen);
+	  return -1;
+	}
+
+      aggregate->metric_out = newinfo.metric_out;
+      aggregate->tag_out = newinfo.tag_out;
+      if (IN6_IS_ADDR_LINKLOCAL(&newinfo.nexthop_out))
+	aggregate->nexthop_out = newinfo.nexthop_out;
+    }
+
+  /* There is no redistribute routemap for the aggregated RTE */
+
+  /* Changed route only output. */
+  /* XXX, vincent, in order to increase time convergence,
+   * it should be announced if a child has changed.
+   */
+  if (route_type == ripng_changed_route)
+    return -1;
+
+  /* Apply offset-list */
+  if (aggregate->metric_out != RIPNG_METRIC_INFINITY)
+    ripng_offset_list_apply_out (p, ifp, &aggregate->metric_out);
+
+  if (aggregate->metric_out > RIPNG_METRIC_INFINITY)
+    aggregate->metric_out = RIPNG_METRIC_INFINITY;
+
+  return 0;
+}
+
+static void
+ripng_out_class_free (void *arg)
+{
+  struct ripng_out_class *class = arg;
+
+  if (class->routes)
+    XFREE (MTYPE_RIPNG_OUT_CLASS, class->routes);
+  XFREE (MTYPE_RIPNG_OUT_CLASS, class);
+}
+
+static struct ripng_out_route *
+ripng_out_class_add (struct ripng_out_class *class, struct route_node *rp)
+{
+  struct ripng_out_route *route;
+
+  if (class->count == class->size)
+    {
+      class->size = class->size ? class->size * 2 : 64;
+      class->routes = XREALLOC (MTYPE_RIPNG_OUT_CLASS, class->routes,
+				class->size * sizeof (struct ripng_out_route));
+    }
+  route = &class->routes[class->count++];
+  memset (route, 0, sizeof (struct ripng_out_route));
+  route->rp = rp;
+  return route;
+}
 
-	  /* Add RTE to the list */
-	  ripng_rte_add(ripng_rte_list, p, rinfo, NULL);
+/* Filter the routes for the class of ifp. */
+static void
+ripng_out_class_build (struct ripng_out_class *class, struct interface *ifp)
+{
+  struct route_node *rp;
+  struct ripng_info *rinfo;
+  struct ripng_aggregate *aggregate;
+  struct ripng_out_route *route;
+  struct prefix_ipv6 *p;
+
+  for (rp = route_top (ripng->table); rp; rp = route_next (rp))
+    {
+      p = (struct prefix_ipv6 *) &rp->p;
+
+      if ((rinfo = rp->info) != NULL && rinfo->suppress == 0)
+	{
+	  /* The aggregate is not sent either then. */
+	  if (ripng_output_route (ifp, p, rinfo, class->route_type, 1) < 0)
+	    continue;
+
+	  route = ripng_out_class_add (class, rp);
+	  route->rinfo = rinfo;
+	  route->nexthop = rinfo->nexthop_out;
+	  route->tag = rinfo->tag_out;
+	  route->metric = rinfo->metric_out;
+	  if (rinfo->nexthop_set)
+	    route->flags |= RIPNG_OUT_NEXTHOP_SET;
 	}
 
       /* Process the aggregated RTE entry */
       if ((aggregate = rp->aggregate) != NULL && 
 	  aggregate->count > 0 && 
-	  aggregate->suppress == 0)
+	  aggregate->suppress == 0
+	  && ripng_output_aggregate (ifp, p, aggregate,
+				     class->route_type) == 0)
 	{
-	  /* If no route-map are applied, the RTE will be these following
-	   * informations.
-	   */
-	  p = (struct prefix_ipv6 *) &rp->p;
-	  aggregate->metric_set = 0;
-	  aggregate->metric_out = aggregate->metric;
-	  aggregate->tag_out    = aggregate->tag;
-	  memset(&aggregate->nexthop_out, 0, sizeof(aggregate->nexthop_out));
-
-	  /* Apply output filters.*/
-	  ret = ripng_outgoing_filter (p, ri);
-	  if (ret < 0)
-	    continue;
+	  route = ripng_out_class_add (class, rp);
+	  route->aggregate = aggregate;
+	  route->nexthop = aggregate->nexthop_out;
+	  route->tag = aggregate->tag_out;
+	  route->metric = aggregate->metric_out;
+	}
+    }
+}
 
-	  /* Interface route-map */
-	  if (ri->routemap[RIPNG_FILTER_OUT])
-	    {
-	      int ret;
-	      struct ripng_info newinfo;
-
-	      /* let's cast the aggregate structure to ripng_info */
-	      memset (&newinfo, 0, sizeof (struct ripng_info));
-	      /* the nexthop is :: */
-	      newinfo.metric = aggregate->metric;
-	      newinfo.metric_out = aggregate->metric_out;
-	      newinfo.tag = aggregate->tag;
-	      newinfo.tag_out = aggregate->tag_out;
-
-	      ret = route_map_apply (ri->routemap[RIPNG_FILTER_OUT], 
-				     (struct prefix *) p, RMAP_RIPNG, 
-				     &newinfo);
-
-	      if (ret == RMAP_DENYMATCH)
-		{
-		  if (IS_RIPNG_DEBUG_PACKET)
-		    zlog_debug ("RIPng %s/%d is filtered by route-map out",
-			       inet6_ntoa (p->prefix), p->prefixlen);
-		  continue;
-		}
+/* The routes for ifp, shared with the interfaces in the same class if
+   an update is under way. */
+static struct ripng_out_class *
+ripng_out_class_get (struct interface *ifp, int route_type)
+{
+  struct ripng_interface *ri = ifp->info;
+  struct ripng_out_class *class;
+  struct ripng_offset_list *offset;
+  struct listnode *node;
 
-	      aggregate->metric_out = newinfo.metric_out;
-	      aggregate->tag_out = newinfo.tag_out;
-	      if (IN6_IS_ADDR_LINKLOCAL(&newinfo.nexthop_out))
-		aggregate->nexthop_out = newinfo.nexthop_out;
-	    }
+  offset = ripng_offset_list_out (ifp);
 
-	  /* There is no redistribute routemap for the aggregated RTE */
+  if (ripng->out_classes)
+    for (ALL_LIST_ELEMENTS_RO (ripng->out_classes, node, class))
+      if (class->route_type == route_type
+	  && class->alist == ri->list[RIPNG_FILTER_OUT]
+	  && class->plist == ri->prefix[RIPNG_FILTER_OUT]
+	  && class->routemap == ri->routemap[RIPNG_FILTER_OUT]
+	  && class->offset == offset)
+	return class;
 
-	  /* Changed route only output. */
-	  /* XXX, vincent, in order to increase time convergence,
-	   * it should be announced if a child has changed.
-	   */
-	  if (route_type == ripng_changed_route)
-	    continue;
+  class = XCALLOC (MTYPE_RIPNG_OUT_CLASS, sizeof (struct ripng_out_class));
+  class->route_type = route_type;
+  class->alist = ri->list[RIPNG_FILTER_OUT];
+  class->plist = ri->prefix[RIPNG_FILTER_OUT];
+  class->routemap = ri->routemap[RIPNG_FILTER_OUT];
+  class->offset = offset;
+  ripng_out_class_build (class, ifp);
+
+  if (ripng->out_classes)
+    listnode_add (ripng->out_classes, class);
+  return class;
+}
+
+/* Send RESPONSE message to specified destination. */
+void
+ripng_output_process (struct interface *ifp, struct sockaddr_in6 *to,
+		      int route_type)
+{
+  struct ripng_info *rinfo;
+  struct ripng_interface *ri;
+  struct ripng_out_class *class;
+  struct ripng_out_route *route;
+  struct route_node *skip = NULL;
+  struct list * ripng_rte_list;
+  int i, sh;
+
+  if (IS_RIPNG_DEBUG_EVENT) {
+    if (to)
+      zlog_debug ("RIPng update routes to neighbor %s",
+                 inet6_ntoa(to->sin6_addr));
+    else
+      zlog_debug ("RIPng update routes on interface %s", ifp->name);
+  }
+
+  /* Get RIPng interface. */
+  ri = ifp->info;
+ 
+  class = ripng_out_class_get (ifp, route_type);
 
-	  /* Apply offset-list */
-	  if (aggregate->metric_out != RIPNG_METRIC_INFINITY)
-	    ripng_offset_list_apply_out (p, ifp, &aggregate->metric_out);
+  ripng_rte_list = ripng_rte_new();
+ 
+  for (i = 0; i < class->count; i++)
+    {
+      route = &class->routes[i];
 
-	  if (aggregate->metric_out > RIPNG_METRIC_INFINITY)
-	    aggregate->metric_out = RIPNG_METRIC_INFINITY;
+      if ((rinfo = route->rinfo) == NULL)
+	{
+	  if (route->rp == skip)
+	    continue;
 
-	  /* Add RTE to the list */
-	  ripng_rte_add(ripng_rte_list, p, NULL, aggregate);
+	  route->aggregate->metric_out = route->metric;
+	  route->aggregate->tag_out = route->tag;
+	  route->aggregate->nexthop_out = route->nexthop;
+	  ripng_rte_add(ripng_rte_list, (struct prefix_ipv6 *) &route->rp->p,
+			NULL, route->aggregate);
+	  continue;
 	}
 
+      /* Split horizon and the next hop learnt on this interface are for
+         each interface to apply. */
+      sh = ((rinfo->type == ZEBRA_ROUTE_RIPNG) &&
+	    rinfo->ifindex == ifp->ifindex);
+      if (sh && ri->split_horizon == RIPNG_SPLIT_HORIZON)
+	{
+	  skip = route->rp;
+	  continue;
+	}
+
+      rinfo->metric_out = route->metric;
+      rinfo->tag_out = route->tag;
+      rinfo->nexthop_out = route->nexthop;
+      if (! (route->flags & RIPNG_OUT_NEXTHOP_SET)
+	  && rinfo->ifindex == ifp->ifindex)
+	rinfo->nexthop_out = rinfo->nexthop;
+      if (sh && ri->split_horizon == RIPNG_SPLIT_HORIZON_POISONED_REVERSE)
+	rinfo->metric_out = RIPNG_METRIC_INFINITY;
+
+      /* Add RTE to the list */
+      ripng_rte_add(ripng_rte_list, (struct prefix_ipv6 *) &route->rp->p,
+		    rinfo, NULL);
     }
 
+  if (! ripng->out_classes)
+    ripng_out_class_free (class);
+
   /* Flush the list */
   ripng_rte_send(ripng_rte_list, ifp, to);
   ripng_rte_free(ripng_rte_list);
@@ -1938,18 +2281,10 @@ ripng_vty_out_uptime (struct vty *vty, struct ripng_info *rinfo)
   struct tm *tm;
 #define TIME_BUF 25
   char timebuf [TIME_BUF];
-  struct thread *thread;
   
-  if ((thread = rinfo->t_timeout) != NULL)
-    {
-      clock = thread_timer_remain_second (thread);
-      tm = gmtime (&clock);
-      strftime (timebuf, TIME_BUF, "%M:%S", tm);
-      vty_out (vty, "%5s", timebuf);
-    }
-  else if ((thread = rinfo->t_garbage_collect) != NULL)
+  if (rinfo->age_state != RIPNG_AGE_NONE)
     {
-      clock = thread_timer_remain_second (thread);
+      clock = ripng_age_deadline (rinfo) - recent_relative_time ().tv_sec;
       tm = gmtime (&clock);
       strftime (timebuf, TIME_BUF, "%M:%S", tm);
       vty_out (vty, "%5s", timebuf);
@@ -2785,8 +3120,7 @@ ripng_clean()
           ripng_zebra_ipv6_delete ((struct prefix_ipv6 *)&rp->p,
                                    &rinfo->nexthop, rinfo->metric);
 
-        RIPNG_TIMER_OFF (rinfo->t_timeout);
-        RIPNG_TIMER_OFF (rinfo->t_garbage_collect);
+        ripng_timers_off (rinfo);
 
         rp->info = NULL;
         route_unlock_node (rp);
@@ -2796,6 +3130,7 @@ ripng_clean()
     }
 
     /* Cancel the RIPng timers */
+    RIPNG_TIMER_OFF (ripng->t_age);
     RIPNG_TIMER_OFF (ripng->t_update);
     RIPNG_TIMER_OFF (ripng->t_triggered_update);
     RIPNG_TIMER_OFF (ripng->t_triggered_interval);
@@ -50,6 +50,9 @@
 /* RIPng peer timeout value. */
 #define RIPNG_PEER_TIMER_DEFAULT       180
 
+/* Slots of the route ageing wheel, one second each. */
+#define RIPNG_AGE_SLOTS                256
+
 /* Default config file name. */
 #define RIPNG_DEFAULT_CONFIG "ripngd.conf"
 
@@ -117,6 +120,12 @@ struct ripng
   /* RIPng aggregate route information. */
   struct route_table *aggregate;
 
+  /* Route timeout and garbage collection, see ripng_age_tick (). */
+  struct ripng_info *age_slot[RIPNG_AGE_SLOTS];
+  unsigned long age_count;
+  time_t age_clock;
+  struct thread *t_age;
+
   /* RIPng threads. */
   struct thread *t_read;
   struct thread *t_write;
@@ -137,6 +146,10 @@ struct ripng
     int metric_config;
     u_int32_t metric;
   } route_map[ZEBRA_ROUTE_MAX];
+
+  /* Routes filtered for the interfaces sending alike, during an
+     update, see ripng_output_process (). */
+  struct list *out_classes;
 };
 
 /* Routing table entry. */
@@ -189,12 +202,19 @@ struct ripng_info
 #define RIPNG_RTF_CHANGED  2
   u_char flags;
 
-  /* Garbage collect timer. */
-  struct thread *t_timeout;
-  struct thread *t_garbage_collect;
+  /* Timeout or garbage collect ageing, and the ageing wheel slot. */
+#define RIPNG_AGE_NONE     0
+#define RIPNG_AGE_TIMEOUT  1
+#define RIPNG_AGE_GARBAGE  2
+  u_char age_state;
+  time_t age_start;
+  int age_slot;
+  struct ripng_info *age_prev;
+  struct ripng_info *age_next;
 
   /* Route-map features - this variables can be changed. */
   struct in6_addr nexthop_out;
+  u_char nexthop_set;
   u_char metric_set;
   u_char metric_out;
   u_short tag_out;
@@ -374,6 +394,7 @@ extern int ripng_offset_list_apply_in (struct prefix_ipv6 *,
                                        struct interface *, u_char *);
 extern int ripng_offset_list_apply_out (struct prefix_ipv6 *,
                                         struct interface *, u_char *);
+extern struct ripng_offset_list *ripng_offset_list_out (struct interface *);
 extern void ripng_offset_clean (void);
 
 extern struct ripng_info * ripng_info_new (void);
@@ -395,6 +416,8 @@ extern void ripng_zebra_ipv6_add (struct prefix_ipv6 *p,
 extern void ripng_zebra_ipv6_delete (struct prefix_ipv6 *p,
                                      struct in6_addr *nexthop,
                                      unsigned int ifindex);
+extern void ripng_zebra_ipv6_delete_batch (struct ripng_info **,
+                                           unsigned int);
 
 extern void ripng_redistribute_clean (void);
 extern int ripng_redistribute_check (int);
@@ -0,0 +1,295 @@
+/*
+ * Stress test for the babeld source and resend tables.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "thread.h"
+#include "privs.h"
+#include "command.h"
+#include "if.h"
+#include "distribute.h"
+
+#include "babeld/babel_main.h"
+#include "babeld/babeld.h"
+#include "babeld/util.h"
+#include "babeld/source.h"
+#include "babeld/neighbour.h"
+#include "babeld/resend.h"
+
+#include "timing.h"
+
+/* Globals normally provided by babel_main.c */
+struct thread_master *master;
+struct timeval babel_now;
+unsigned char myid[8];
+int debug = 0;
+int resend_delay = -1;
+const unsigned char zeroes[16] = {0};
+const unsigned char ones[16] =
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+unsigned char protocol_group[16];
+int protocol_port;
+int protocol_socket = -1;
+struct zebra_privs_t babeld_privs;
+
+void
+babel_load_state_file (void)
+{
+}
+
+void
+show_babel_main_configuration (struct vty *vty)
+{
+}
+
+static struct cmd_node babel_node = { BABEL_NODE, "", 1 };
+
+#define DEFAULT_PREFIXES 20000
+
+static int failed = 0;
+
+static void
+make_prefix (unsigned char *prefix, int i)
+{
+  memset (prefix, 0, 16);
+  prefix[0] = 0x20;
+  prefix[1] = 0x01;
+  prefix[4] = (i >> 16) & 0xff;
+  prefix[5] = (i >> 8) & 0xff;
+  prefix[6] = i & 0xff;
+}
+
+static void
+make_id (unsigned char *id, int i)
+{
+  memset (id, 0, 8);
+  id[7] = i % 7;
+}
+
+static void
+test_sources (int n)
+{
+  unsigned char prefix[16], id[8];
+  struct source **srcs;
+  struct timeval start;
+  int i;
+
+  srcs = calloc (n, sizeof (struct source *));
+  assert (srcs != NULL);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      srcs[i] = find_source (id, prefix, 48, 1, i & 0xffff);
+      assert (srcs[i] != NULL);
+    }
+  printf ("%d sources created in %lu usec\n", n, elapsed_usec (&start));
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      if (find_source (id, prefix, 48, 0, 0) != srcs[i])
+        {
+          printf ("FAILED: source %d not found\n", i);
+          failed++;
+        }
+      /* Same prefix, other router-id or length. */
+      id[7] += 7;
+      if (find_source (id, prefix, 48, 0, 0) != NULL)
+        {
+          printf ("FAILED: source %d found with the wrong id\n", i);
+          failed++;
+        }
+      id[7] -= 7;
+      if (find_source (id, prefix, 64, 0, 0) != NULL)
+        {
+          printf ("FAILED: source %d found with the wrong length\n", i);
+          failed++;
+        }
+    }
+  printf ("%d source lookups in %lu usec\n", 3 * n, elapsed_usec (&start));
+
+  /* Keep the odd sources fresh, and hold a route on every fourth. */
+  babel_now.tv_sec += SOURCE_GC_TIME / 2;
+  for (i = 0; i < n; i++)
+    {
+      if (i & 1)
+        update_source (srcs[i], (i + 1) & 0xffff, 96);
+      if (i % 4 == 0)
+        retain_source (srcs[i]);
+    }
+
+  babel_now.tv_sec += SOURCE_GC_TIME / 2 + 1;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  expire_sources ();
+  printf ("sources expired in %lu usec\n", elapsed_usec (&start));
+
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      if ((i & 1) || i % 4 == 0)
+        {
+          if (find_source (id, prefix, 48, 0, 0) != srcs[i])
+            {
+              printf ("FAILED: source %d expired too early\n", i);
+              failed++;
+            }
+        }
+      else if (find_source (id, prefix, 48, 0, 0) != NULL)
+        {
+          printf ("FAILED: source %d did not expire\n", i);
+          failed++;
+        }
+    }
+
+  /* Released sources that expired meanwhile go with the next sweep. */
+  for (i = 0; i < n; i += 4)
+    release_source (srcs[i]);
+  babel_now.tv_sec += SOURCE_GC_TIME + 1;
+  expire_sources ();
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      if (find_source (id, prefix, 48, 0, 0) != NULL)
+        {
+          printf ("FAILED: source %d survived\n", i);
+          failed++;
+        }
+    }
+
+  free (srcs);
+}
+
+static void
+test_resends (int n)
+{
+  unsigned char prefix[16], id[8];
+  struct timeval start;
+  int i, unsatisfied;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      if (record_resend (RESEND_REQUEST, prefix, 48, 10, id, NULL, 0) != 1)
+        {
+          printf ("FAILED: request %d not recorded\n", i);
+          failed++;
+        }
+    }
+  printf ("%d requests recorded in %lu usec\n", n, elapsed_usec (&start));
+  if (resend_time.tv_sec == 0)
+    {
+      printf ("FAILED: no expiry scheduled\n");
+      failed++;
+    }
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < n; i += 2)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      if (satisfy_request (prefix, 48, 10, id, NULL) != 1)
+        {
+          printf ("FAILED: request %d not satisfied\n", i);
+          failed++;
+        }
+    }
+  unsatisfied = 0;
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      make_id (id, i);
+      unsatisfied += unsatisfied_request (prefix, 48, 11, id);
+    }
+  printf ("%d request lookups in %lu usec\n", n + n / 2, elapsed_usec (&start));
+  if (unsatisfied != n / 2)
+    {
+      printf ("FAILED: %d unsatisfied requests, expected %d\n",
+              unsatisfied, n / 2);
+      failed++;
+    }
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  expire_resend ();
+  printf ("satisfied requests expired in %lu usec\n", elapsed_usec (&start));
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      if ((find_request (prefix, 48) != NULL) != (i & 1))
+        {
+          printf ("FAILED: request %d %s\n",
+                  i, (i & 1) ? "missing" : "not expired");
+          failed++;
+        }
+    }
+
+  babel_now.tv_sec += REQUEST_TIMEOUT / 1000 + 1;
+  expire_resend ();
+  for (i = 0; i < n; i++)
+    {
+      make_prefix (prefix, i);
+      if (find_request (prefix, 48) != NULL)
+        {
+          printf ("FAILED: request %d not expired\n", i);
+          failed++;
+        }
+    }
+  if (resend_time.tv_sec != 0)
+    {
+      printf ("FAILED: resend time still set\n");
+      failed++;
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  int n = DEFAULT_PREFIXES;
+
+  if (argc > 1)
+    n = atoi (argv[1]);
+  if (n < 4)
+    n = 4;
+
+  /* record_resend looks up the distribute lists. */
+  cmd_init (1);
+  install_node (&babel_node, NULL);
+  if_init ();
+  distribute_list_init (BABEL_NODE);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &babel_now);
+  babel_now.tv_sec += 1000;
+
+  test_sources (n);
+  test_resends (n);
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
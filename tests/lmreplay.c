@@ -0,0 +1,434 @@
+/*
+ * Link metrics replay tool
+ *
+ * Stands in for a radio driver: replays a recorded or synthetic trace
+ * of RFC 4938 link metrics and link status events straight into
+ * zebra's zserv socket, which forwards them to ospf6d as if they had
+ * arrived over generic netlink.  In benchmark mode it also listens
+ * for the OSPF6 routes zebra redistributes and reports the latency
+ * from each event to the first FIB update that follows it.
+ *
+ * Trace lines, with times in milliseconds from the start of the trace:
+ *
+ *   <msec> metrics <ifname|ifindex> <neighbor> <rlq> <resource> \
+ *          <latency> <current-datarate> <max-datarate> [receive-only]
+ *   <msec> status <ifname|ifindex> <neighbor> (up|down)
+ *
+ * where neighbor is the link-local address of the neighbor's
+ * interface.  Lines starting with '#' are ignored.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "thread.h"
+#include "if.h"
+#include "log.h"
+#include "memory.h"
+#include "stream.h"
+#include "zclient.h"
+#include "zebra_linkmetrics.h"
+#include "lmgenl.h"
+
+struct thread_master *master;
+
+struct lm_event
+{
+  unsigned long msec;
+  int status;			/* link status instead of metrics */
+  char ifname[INTERFACE_NAMSIZ];
+  struct zebra_linkmetrics metrics;
+  struct zebra_linkstatus linkstatus;
+};
+
+static struct zclient *zclient;
+
+static struct lm_event *events;
+static unsigned int nevents, next_event;
+
+static int benchmark;
+static double speed = 1.0;
+static unsigned long wait_msec = 2000;
+static unsigned long timeout_msec = 1000;
+
+/* benchmark state */
+static struct timeval sent;
+static int outstanding;
+static unsigned long matched, unmatched, routes;
+static struct thread_hist latency;
+
+static void
+usage (const char *progname, int status)
+{
+  fprintf (status ? stderr : stdout,
+	   "usage: %s [-b] [-z zserv-path] [-w wait-msec] [-x speed] "
+	   "-f trace-file\n"
+	   "       %s [-b] [-z zserv-path] [-w wait-msec] [-t interval-msec] "
+	   "[-c rounds] -i interface -n neighbor [-n neighbor...]\n",
+	   progname, progname);
+  exit (status);
+}
+
+static struct lm_event *
+event_new (void)
+{
+  events = XREALLOC (MTYPE_TMP, events, (nevents + 1) * sizeof (*events));
+  memset (&events[nevents], 0, sizeof (*events));
+  return &events[nevents++];
+}
+
+static int
+parse_neighbor (const char *str, struct in6_addr *addr)
+{
+  if (inet_pton (AF_INET6, str, addr) != 1 || !IN6_IS_ADDR_LINKLOCAL (addr))
+    {
+      fprintf (stderr, "invalid link-local address: %s\n", str);
+      return -1;
+    }
+  return 0;
+}
+
+static void
+trace_read (const char *path)
+{
+  FILE *fp;
+  char line[512];
+  unsigned int lineno = 0;
+
+  if ((fp = fopen (path, "r")) == NULL)
+    {
+      fprintf (stderr, "%s: %s\n", path, safe_strerror (errno));
+      exit (1);
+    }
+
+  while (fgets (line, sizeof (line), fp))
+    {
+      struct lm_event *ev;
+      char type[16], ifname[INTERFACE_NAMSIZ], nbr[INET6_ADDRSTRLEN];
+      char extra[16];
+      unsigned long msec, rlq, resource, lat;
+      unsigned long long cdr, mdr;
+      int n;
+
+      lineno++;
+      if (line[strspn (line, " \t")] == '#' ||
+	  line[strspn (line, " \t\r\n")] == '\0')
+	continue;
+
+      if (sscanf (line, "%lu %15s %15s %45s", &msec, type, ifname, nbr) != 4)
+	goto bad;
+
+      ev = event_new ();
+      ev->msec = msec;
+      strncpy (ev->ifname, ifname, sizeof (ev->ifname) - 1);
+
+      if (strcmp (type, "metrics") == 0)
+	{
+	  extra[0] = '\0';
+	  n = sscanf (line, "%*u %*s %*s %*s %lu %lu %lu %llu %llu %15s",
+		      &rlq, &resource, &lat, &cdr, &mdr, extra);
+	  if (n < 5 || rlq > 100 || resource > 100 || lat > UINT16_MAX ||
+	      cdr > mdr || parse_neighbor (nbr, &ev->metrics.nbr_addr6))
+	    goto bad;
+	  ev->metrics.metrics.rlq = rlq;
+	  ev->metrics.metrics.resource = resource;
+	  ev->metrics.metrics.latency = lat;
+	  ev->metrics.metrics.current_datarate = cdr;
+	  ev->metrics.metrics.max_datarate = mdr;
+	  if (strcmp (extra, "receive-only") == 0)
+	    ev->metrics.metrics.flags |= RECEIVE_ONLY;
+	}
+      else if (strcmp (type, "status") == 0)
+	{
+	  ev->status = 1;
+	  if (sscanf (line, "%*u %*s %*s %*s %15s", extra) != 1 ||
+	      parse_neighbor (nbr, &ev->linkstatus.nbr_addr6))
+	    goto bad;
+	  if (strcmp (extra, "up") == 0)
+	    ev->linkstatus.status = LM_STATUS_UP;
+	  else if (strcmp (extra, "down") == 0)
+	    ev->linkstatus.status = LM_STATUS_DOWN;
+	  else
+	    goto bad;
+	}
+      else
+	goto bad;
+
+      if (nevents > 1 && ev->msec < events[nevents - 2].msec)
+	{
+	  fprintf (stderr, "%s:%u: time goes backwards\n", path, lineno);
+	  exit (1);
+	}
+      continue;
+
+    bad:
+      fprintf (stderr, "%s:%u: malformed trace line\n", path, lineno);
+      exit (1);
+    }
+
+  fclose (fp);
+}
+
+/* Alternate every neighbor between a good and a degraded link, so
+   that each round changes the neighbor costs whatever the weights. */
+static void
+trace_synthesize (const char *ifname, struct in6_addr *nbrs,
+		  unsigned int nnbrs, unsigned int rounds,
+		  unsigned long interval)
+{
+  unsigned int r, i;
+
+  for (r = 0; r < rounds; r++)
+    for (i = 0; i < nnbrs; i++)
+      {
+	struct lm_event *ev = event_new ();
+
+	ev->msec = r * interval;
+	strncpy (ev->ifname, ifname, sizeof (ev->ifname) - 1);
+	ev->metrics.nbr_addr6 = nbrs[i];
+	ev->metrics.metrics.rlq = (r & 1) ? 50 : 100;
+	ev->metrics.metrics.resource = (r & 1) ? 50 : 100;
+	ev->metrics.metrics.latency = (r & 1) ? 100 : 10;
+	ev->metrics.metrics.max_datarate = 100000;
+	ev->metrics.metrics.current_datarate = (r & 1) ? 25000 : 100000;
+      }
+}
+
+static u_int32_t
+event_ifindex (const struct lm_event *ev)
+{
+  struct interface *ifp;
+  char *end;
+  unsigned long ifindex;
+
+  ifindex = strtoul (ev->ifname, &end, 10);
+  if (*end == '\0' && ifindex > 0)
+    return ifindex;
+
+  ifp = if_lookup_by_name (ev->ifname);
+  if (ifp == NULL || ifp->ifindex == IFINDEX_INTERNAL)
+    {
+      fprintf (stderr, "unknown interface: %s\n", ev->ifname);
+      return 0;
+    }
+  return ifp->ifindex;
+}
+
+static void
+event_send (struct lm_event *ev)
+{
+  u_int32_t ifindex = event_ifindex (ev);
+
+  if (ifindex == 0)
+    return;
+
+  if (ev->status)
+    {
+      ev->linkstatus.ifindex = ifindex;
+      zapi_write_linkstatus (zclient->obuf, &ev->linkstatus);
+    }
+  else
+    {
+      ev->metrics.ifindex = ifindex;
+      zapi_write_linkmetrics (zclient->obuf, &ev->metrics);
+    }
+
+  if (zclient_send_message (zclient))
+    {
+      fprintf (stderr, "lost connection to zebra\n");
+      exit (1);
+    }
+}
+
+static void
+report (void)
+{
+  printf ("%u events replayed\n", nevents);
+  if (!benchmark)
+    return;
+
+  printf ("%lu OSPF6 route updates, %lu event groups followed by a FIB "
+	  "update, %lu not\n", routes, matched, unmatched);
+  printf ("event to FIB latency (usec): p50 %lu p99 %lu p99.9 %lu max %lu\n",
+	  thread_hist_quantile (&latency, 500),
+	  thread_hist_quantile (&latency, 990),
+	  thread_hist_quantile (&latency, 999), latency.max);
+}
+
+static int
+replay_done (struct thread *thread)
+{
+  if (outstanding)
+    unmatched++;
+  report ();
+  exit (0);
+}
+
+/* Send every event due at the time of the next one, then wait for
+   the next group. */
+static int
+replay_next (struct thread *thread)
+{
+  unsigned long msec;
+
+  if (next_event >= nevents)
+    return 0;
+
+  if (outstanding)
+    unmatched++;
+
+  msec = events[next_event].msec;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &sent);
+  outstanding = 1;
+
+  while (next_event < nevents && events[next_event].msec == msec)
+    event_send (&events[next_event++]);
+
+  if (next_event < nevents)
+    thread_add_timer_msec (master, replay_next, NULL,
+			   (events[next_event].msec - msec) / speed);
+  else
+    thread_add_timer_msec (master, replay_done, NULL,
+			   benchmark ? timeout_msec : 100);
+
+  return 0;
+}
+
+static int
+lmreplay_interface_add (int command, struct zclient *zclient,
+			zebra_size_t length)
+{
+  zebra_interface_add_read (zclient->ibuf);
+  return 0;
+}
+
+static int
+lmreplay_route (int command, struct zclient *zclient, zebra_size_t length)
+{
+  struct timeval now;
+
+  if (stream_getc (zclient->ibuf) != ZEBRA_ROUTE_OSPF6)
+    return 0;
+
+  routes++;
+  if (!outstanding)
+    return 0;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  thread_hist_add (&latency, (now.tv_sec - sent.tv_sec) * 1000000L +
+		   (now.tv_usec - sent.tv_usec));
+  matched++;
+  outstanding = 0;
+
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  struct thread thread;
+  struct in6_addr nbrs[64];
+  unsigned int nnbrs = 0, rounds = 10;
+  unsigned long interval = 1000;
+  const char *trace = NULL, *ifname = NULL;
+  int opt;
+
+  while ((opt = getopt (argc, argv, "bc:f:hi:n:t:w:x:z:")) != -1)
+    {
+      switch (opt)
+	{
+	case 'b':
+	  benchmark = 1;
+	  break;
+	case 'c':
+	  rounds = strtoul (optarg, NULL, 10);
+	  break;
+	case 'f':
+	  trace = optarg;
+	  break;
+	case 'i':
+	  ifname = optarg;
+	  break;
+	case 'n':
+	  if (nnbrs == sizeof (nbrs) / sizeof (nbrs[0]) ||
+	      parse_neighbor (optarg, &nbrs[nnbrs]))
+	    usage (argv[0], 1);
+	  nnbrs++;
+	  break;
+	case 't':
+	  interval = strtoul (optarg, NULL, 10);
+	  break;
+	case 'w':
+	  wait_msec = strtoul (optarg, NULL, 10);
+	  break;
+	case 'x':
+	  speed = strtod (optarg, NULL);
+	  if (speed <= 0)
+	    usage (argv[0], 1);
+	  break;
+	case 'z':
+	  zclient_serv_path_set (optarg);
+	  break;
+	case 'h':
+	  usage (argv[0], 0);
+	  break;
+	default:
+	  usage (argv[0], 1);
+	  break;
+	}
+    }
+
+  if (trace)
+    trace_read (trace);
+  else if (ifname && nnbrs)
+    trace_synthesize (ifname, nbrs, nnbrs, rounds, interval);
+  else
+    usage (argv[0], 1);
+
+  if (nevents == 0)
+    {
+      fprintf (stderr, "nothing to replay\n");
+      return 1;
+    }
+
+  if (trace == NULL)
+    timeout_msec = interval;
+
+  master = thread_master_create ();
+  if_init ();
+
+  zclient = zclient_new ();
+  zclient_init (zclient, ZEBRA_ROUTE_SYSTEM);
+  zclient->interface_add = lmreplay_interface_add;
+  if (benchmark)
+    {
+      zclient->ipv6_route_add = lmreplay_route;
+      zclient->ipv6_route_delete = lmreplay_route;
+      zclient_redistribute (ZEBRA_REDISTRIBUTE_ADD, zclient,
+			    ZEBRA_ROUTE_OSPF6);
+    }
+
+  /* give zebra time to send interfaces and the current routes */
+  thread_add_timer_msec (master, replay_next, NULL, wait_msec);
+
+  while (thread_fetch (master, &thread))
+    thread_call (&thread);
+
+  return 0;
+}
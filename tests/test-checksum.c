@@ -486,19 +486,190 @@ in_cksum_rfc(void *parg, int count)
 }
 
 
+/* Every implementation the lib can pick must give the same results. */
+static const char *impls[] = { "scalar", "sse2", "avx2", NULL };
+
+static void
+check_impls (u_char *buffer, int len)
+{
+  u_int16_t in_ref = 0, fl_ref = 0, fl, fl_compute;
+  struct fletcher_item item;
+  int i, align, off;
+
+  /* random alignment and checksum offset */
+  align = random () % 32;
+  memmove (buffer + align, buffer, len + sizeof (u_int16_t));
+  off = len ? random () % len : 0;
+
+  for (i = 0; impls[i]; i++)
+    {
+      if (checksum_impl_set (impls[i]))
+        continue;
+
+      fl = fletcher_checksum (buffer + align, len + sizeof (u_int16_t), off);
+      fl_compute = fletcher_checksum_compute (buffer + align,
+                                              len + sizeof (u_int16_t), off);
+      item.buf = buffer + align;
+      item.len = len + sizeof (u_int16_t);
+      item.offset = off;
+      if (i == 0)
+        {
+          in_ref = in_cksum (buffer + align, len);
+          fl_ref = fl;
+        }
+
+      if (in_cksum (buffer + align, len) != in_ref)
+        printf ("verify: in_cksum %s differs from scalar, len:%d align:%d\n",
+                impls[i], len, align);
+      if (fl != fl_ref || fl_compute != fl_ref)
+        printf ("verify: fletcher %s differs from scalar (%04x/%04x vs "
+                "%04x), len:%d align:%d offset:%d\n", impls[i], fl,
+                fl_compute, fl_ref, len, align, off);
+      if (fletcher_checksum_verify_batch (&item, 1) || !item.valid)
+        printf ("verify: fletcher batch %s failed, len:%d\n", impls[i], len);
+
+      /* a single flipped bit must not verify */
+      buffer[align + (off + 2) % (len + 2)] ^= 1;
+      if (fletcher_checksum_verify_batch (&item, 1) != 1 || item.valid)
+        printf ("verify: fletcher batch %s missed a bad checksum, len:%d\n",
+                impls[i], len);
+      buffer[align + (off + 2) % (len + 2)] ^= 1;
+    }
+  checksum_impl_set (NULL);
+  memmove (buffer, buffer + align, len + sizeof (u_int16_t));
+}
+
+/* A buffer of 0xff bytes larger than 128KB gets the lanes of the vector
+   in_cksum loops as full as they get: all must agree with the scalar
+   sum still. */
+static void
+check_in_cksum_large (void)
+{
+  static u_char buffer[192 * 1024];
+  u_int16_t ref = 0, sum;
+  int i;
+
+  memset (buffer, 0xff, sizeof (buffer));
+  for (i = 0; impls[i]; i++)
+    {
+      if (checksum_impl_set (impls[i]))
+        continue;
+
+      sum = in_cksum (buffer, sizeof (buffer));
+      if (i == 0)
+        ref = sum;
+      else if (sum != ref)
+        {
+          printf ("verify: in_cksum %s differs from scalar (%04x vs %04x), "
+                  "len:%zu of 0xff\n", impls[i], sum, ref, sizeof (buffer));
+          exit (1);
+        }
+    }
+  checksum_impl_set (NULL);
+}
+
+static double
+bench_rate (struct timeval *start, size_t bytes)
+{
+  struct timeval end;
+  double secs;
+
+  gettimeofday (&end, NULL);
+  secs = (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+  return secs > 0 ? bytes / secs / 1e6 : 0;
+}
+
+/* Throughput of each implementation, in MB/s. */
+static void
+bench (void)
+{
+  static const int sizes[] = { 64, 1500, 65535, 0 };
+  static u_char buffer[65535 + 2];
+  struct timeval start;
+  size_t total = 64 * 1024 * 1024, done;
+  int i, j;
+  volatile u_int16_t sink;
+
+  for (i = 0; i < 65535 + 2; i++)
+    buffer[i] = random ();
+
+  printf ("%-8s %6s %12s %12s %12s\n",
+          "impl", "size", "in_cksum", "fletcher", "verify");
+  for (i = 0; impls[i]; i++)
+    {
+      if (checksum_impl_set (impls[i]))
+        {
+          printf ("%-8s not supported\n", impls[i]);
+          continue;
+        }
+      for (j = 0; sizes[j]; j++)
+        {
+          struct fletcher_item items[32];
+          double r_in, r_fl, r_ver;
+          int k;
+
+          gettimeofday (&start, NULL);
+          for (done = 0; done < total; done += sizes[j])
+            sink = in_cksum (buffer, sizes[j]);
+          r_in = bench_rate (&start, done);
+
+          gettimeofday (&start, NULL);
+          for (done = 0; done < total; done += sizes[j])
+            sink = fletcher_checksum (buffer, sizes[j], 14);
+          r_fl = bench_rate (&start, done);
+
+          for (k = 0; k < 32; k++)
+            {
+              items[k].buf = buffer;
+              items[k].len = sizes[j];
+              items[k].offset = 14;
+            }
+          gettimeofday (&start, NULL);
+          for (done = 0; done < total; done += 32 * sizes[j])
+            sink = fletcher_checksum_verify_batch (items, 32);
+          r_ver = bench_rate (&start, done);
+
+          printf ("%-8s %6d %7.0f MB/s %7.0f MB/s %7.0f MB/s\n", impls[i],
+                  sizes[j], r_in, r_fl, r_ver);
+        }
+    }
+  (void) sink;
+  checksum_impl_set (NULL);
+}
+
 int
 main(int argc, char **argv)
 {
 /* 60017 65629 702179 */
 #define MAXDATALEN 60017
 #define BUFSIZE MAXDATALEN + sizeof(u_int16_t)
-  u_char buffer[BUFSIZE];
+  static u_char buffer[BUFSIZE + 32];
   int exercise = 0;
+  long iterations = -1;
+  int opt;
 #define EXERCISESTEP 257
   
   srandom (time (NULL));
+
+  /* -b: throughput of each implementation; -n N: stop after N rounds */
+  while ((opt = getopt (argc, argv, "bn:")) != -1)
+    switch (opt)
+      {
+      case 'b':
+        printf ("default implementation: %s\n", checksum_impl ());
+        bench ();
+        exit (0);
+      case 'n':
+        iterations = atol (optarg);
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-b] [-n iterations]\n", argv[0]);
+        exit (1);
+      }
+
+  check_in_cksum_large ();
   
-  while (1) {
+  while (iterations < 0 || iterations-- > 0) {
     u_int16_t ospfd, isisd, lib, in_csum, in_csum_res, in_csum_rfc;
     int i,j;
 
@@ -520,6 +691,8 @@ main(int argc, char **argv)
 	      "in_csum_rfc %x, len:%d\n", 
 	      in_csum, in_csum_res, in_csum_rfc, exercise);
 
+    check_impls (buffer, exercise);
+
     ospfd = ospfd_checksum (buffer, exercise + sizeof(u_int16_t), exercise);
     if (verify (buffer, exercise + sizeof(u_int16_t)))
       printf ("verify: ospfd failed\n");
@@ -564,4 +737,5 @@ main(int argc, char **argv)
       exit (1);
     }
   }
+  return 0;
 }
@@ -0,0 +1,378 @@
+/*
+ * Benchmark of configuration parsing, with and without the keyword index.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Checks that the keyword index picks the same command, or fails the
+ * same way, as the plain matcher for a set of lines and every
+ * abbreviation of their keywords.  Then generates a configuration of
+ * prefix-lists, access-lists and route-maps and reports how long it
+ * takes to load, with the index and without, and how long matching
+ * its lines takes without running them.
+ *
+ * Usage: testcmdparse [lines [file]]
+ */
+#include <zebra.h>
+
+#include "thread.h"
+#include "vty.h"
+#include "buffer.h"
+#include "command.h"
+#include "vector.h"
+#include "prefix.h"
+#include "plist.h"
+#include "filter.h"
+#include "routemap.h"
+#include "keychain.h"
+
+#include "timing.h"
+
+#define DEFAULT_LINES 100000
+
+struct thread_master *master;
+
+static int failed = 0;
+
+/* Lines to match, with the line entering their node from CONFIG_NODE. */
+static const struct
+{
+  const char *enter;
+  const char *line;
+} seeds[] =
+{
+  { NULL, "ip prefix-list PL seq 5 permit 10.0.0.0/8 le 24" },
+  { NULL, "ip prefix-list PL seq 10 deny any" },
+  { NULL, "ip prefix-list PL permit 192.0.2.0/24 ge 25 le 32" },
+  { NULL, "ip prefix-list PL description some words here" },
+  { NULL, "ip prefix-list PL seq 15 permit 10.0.0.0/8 ge" },
+  { NULL, "ip prefix-list PL seq x permit any" },
+  { NULL, "ip prefix-list sequence-number" },
+  { NULL, "no ip prefix-list PL seq 10 deny any" },
+  { NULL, "ipv6 prefix-list PL6 seq 5 permit 2001:db8::/32 le 64" },
+  { NULL, "access-list 1 permit 10.0.0.0 0.255.255.255" },
+  { NULL, "access-list 100 permit ip 10.0.0.0 0.0.0.255 any" },
+  { NULL, "access-list NAME deny 10.0.0.0/8 exact-match" },
+  { NULL, "access-list NAME remark a remark" },
+  { NULL, "ipv6 access-list NAME6 permit any" },
+  { NULL, "route-map RM permit 10" },
+  { NULL, "no route-map RM deny 20" },
+  { NULL, "key chain KC" },
+  { NULL, "hostname router" },
+  { NULL, "line vty" },
+  { NULL, "ip" },
+  { NULL, "no" },
+  { NULL, "" },
+  { NULL, "nonsense command" },
+  { "route-map RM permit 10", "description a route map" },
+  { "route-map RM permit 10", "on-match goto 20" },
+  { "route-map RM permit 10", "continue 30" },
+  { "route-map RM permit 10", "call OTHER" },
+  { "route-map RM permit 10", "no description" },
+  { "key chain KC", "key 1" },
+};
+
+struct result
+{
+  int ret;
+  struct cmd_element *cmd;
+};
+
+extern vector cmdvec;
+
+/* Commands flagged as some daemon's are only looked up, as in vtysh,
+   so that matching a line twice does not run it twice. */
+static void
+set_daemon (int daemon)
+{
+  unsigned int i, j;
+  struct cmd_node *cnode;
+  struct cmd_element *cmd;
+
+  for (i = 0; i < vector_active (cmdvec); i++)
+    if ((cnode = vector_slot (cmdvec, i)) != NULL)
+      for (j = 0; j < vector_active (cnode->cmd_vector); j++)
+	if ((cmd = vector_slot (cnode->cmd_vector, j)) != NULL)
+	  cmd->daemon = daemon;
+}
+
+/* Commands in a sub-node need the object entering it set up. */
+static void
+enter (const char *line, struct vty *vty)
+{
+  vector vline;
+
+  vty->node = CONFIG_NODE;
+  if (line == NULL)
+    return;
+
+  vline = cmd_make_strvec (line);
+  if (cmd_execute_command_strict (vline, vty, NULL) != CMD_SUCCESS)
+    {
+      printf ("FAILED: cannot enter '%s'\n", line);
+      failed++;
+    }
+  cmd_free_strvec (vline);
+}
+
+static void
+run (const char *entry, vector vline, struct vty *vty, int strict,
+     struct result *res)
+{
+  res->cmd = NULL;
+  enter (entry, vty);
+  set_daemon (1);
+  if (strict)
+    res->ret = cmd_execute_command_strict (vline, vty, &res->cmd);
+  else
+    res->ret = cmd_execute_command (vline, vty, &res->cmd, 1);
+  set_daemon (0);
+  buffer_reset (vty->obuf);
+}
+
+static void
+compare (const char *entry, const char *line, struct vty *vty)
+{
+  struct result plain, indexed;
+  vector vline;
+  int strict;
+
+  vline = cmd_make_strvec (line);
+  if (vline == NULL)
+    return;
+
+  for (strict = 0; strict <= 1; strict++)
+    {
+      cmd_trie_enable (0);
+      run (entry, vline, vty, strict, &plain);
+      cmd_trie_enable (1);
+      run (entry, vline, vty, strict, &indexed);
+
+      if (plain.ret != indexed.ret || plain.cmd != indexed.cmd)
+	{
+	  printf ("FAILED: %s '%s': %d/%s plain, %d/%s indexed\n",
+		  strict ? "strict" : "completion", line,
+		  plain.ret, plain.cmd ? plain.cmd->string : "-",
+		  indexed.ret, indexed.cmd ? indexed.cmd->string : "-");
+	  failed++;
+	}
+    }
+  cmd_free_strvec (vline);
+}
+
+/* The line, and the line with each token cut short in turn. */
+static unsigned int
+compare_abbreviations (const char *entry, const char *line,
+		       struct vty *vty)
+{
+  char buf[256], out[256];
+  char *tokens[32];
+  unsigned int ntokens = 0, i, j, len, count = 0;
+  char *p;
+
+  compare (entry, line, vty);
+  count++;
+
+  snprintf (buf, sizeof (buf), "%s", line);
+  for (p = strtok (buf, " "); p && ntokens < 32; p = strtok (NULL, " "))
+    tokens[ntokens++] = p;
+
+  for (i = 0; i < ntokens; i++)
+    for (len = 1; len < strlen (tokens[i]); len++)
+      {
+	out[0] = '\0';
+	for (j = 0; j < ntokens; j++)
+	  {
+	    if (j)
+	      strcat (out, " ");
+	    strncat (out, tokens[j], j == i ? len : strlen (tokens[j]));
+	  }
+	compare (entry, out, vty);
+	count++;
+      }
+  /* Trailing space, as left by completion. */
+  snprintf (out, sizeof (out), "%s ", line);
+  compare (entry, out, vty);
+  return count + 1;
+}
+
+static void
+generate (const char *path, int n)
+{
+  FILE *fp;
+  int i;
+
+  if ((fp = fopen (path, "w")) == NULL)
+    {
+      printf ("cannot create %s\n", path);
+      exit (1);
+    }
+
+  for (i = 0; i < n; i++)
+    switch (i % 8)
+      {
+      case 0:
+      case 1:
+      case 2:
+	fprintf (fp, "ip prefix-list PL%d seq %d permit 10.%d.%d.0/24 le 32\n",
+		 i / 64, (i % 64 + 1) * 5, (i >> 16) & 0xff, (i >> 8) & 0xff);
+	break;
+      case 3:
+	fprintf (fp, "ipv6 prefix-list PL%d seq %d deny 2001:db8:%x::/48\n",
+		 i / 64, (i % 64 + 1) * 5, i & 0xffff);
+	break;
+      case 4:
+	fprintf (fp, "access-list ACL%d permit 10.%d.%d.0/24\n",
+		 i / 64, (i >> 16) & 0xff, (i >> 8) & 0xff);
+	break;
+      case 5:
+	fprintf (fp, "route-map RM%d permit %d\n", i / 64, i % 64 + 1);
+	break;
+      case 6:
+	fprintf (fp, " description entry %d of the generated map\n", i);
+	break;
+      case 7:
+	fprintf (fp, " on-match next\n");
+	break;
+      }
+  fclose (fp);
+}
+
+static unsigned long
+load (const char *path, struct vty *vty)
+{
+  struct timeval start;
+  unsigned long usec;
+  FILE *fp;
+  int ret;
+
+  if ((fp = fopen (path, "r")) == NULL)
+    {
+      printf ("cannot open %s\n", path);
+      exit (1);
+    }
+
+  vty->node = CONFIG_NODE;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  ret = config_from_file (vty, fp);
+  usec = elapsed_usec (&start);
+  fclose (fp);
+
+  if (ret != CMD_SUCCESS)
+    {
+      printf ("FAILED: error %d loading '%s'\n", ret, vty->buf);
+      failed++;
+    }
+  buffer_reset (vty->obuf);
+  return usec;
+}
+
+/* Match every line of the file without running it.  Indented lines
+   are route-map clauses. */
+static unsigned long
+match (const char *path, struct vty *vty)
+{
+  struct timeval start;
+  unsigned long usec;
+  char buf[VTY_BUFSIZ];
+  vector vline;
+  FILE *fp;
+  int ret;
+
+  if ((fp = fopen (path, "r")) == NULL)
+    {
+      printf ("cannot open %s\n", path);
+      exit (1);
+    }
+
+  set_daemon (1);
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  while (fgets (buf, sizeof (buf), fp))
+    {
+      vline = cmd_make_strvec (buf);
+      vty->node = buf[0] == ' ' ? RMAP_NODE : CONFIG_NODE;
+      ret = cmd_execute_command_strict (vline, vty, NULL);
+      cmd_free_strvec (vline);
+      if (ret != CMD_SUCCESS_DAEMON)
+	{
+	  printf ("FAILED: error %d matching '%s'\n", ret, buf);
+	  failed++;
+	  break;
+	}
+    }
+  usec = elapsed_usec (&start);
+  set_daemon (0);
+  fclose (fp);
+  return usec;
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *path = "/tmp/testcmdparse.conf";
+  struct vty *vty;
+  unsigned long plain, indexed;
+  unsigned int i, count = 0;
+  int n = DEFAULT_LINES;
+
+  if (argc > 1)
+    n = atoi (argv[1]);
+  if (argc > 2)
+    path = argv[2];
+
+  master = thread_master_create ();
+  cmd_init (1);
+  vty_init (master);
+  prefix_list_init ();
+  access_list_init ();
+  route_map_init ();
+  route_map_init_vty ();
+  keychain_init ();
+  sort_node ();
+
+  vty = vty_new ();
+  vty->type = VTY_TERM;
+
+  for (i = 0; i < sizeof (seeds) / sizeof (seeds[0]); i++)
+    count += compare_abbreviations (seeds[i].enter, seeds[i].line, vty);
+  printf ("%u lines matched alike with and without the index\n", count);
+
+  generate (path, n);
+
+  cmd_trie_enable (0);
+  plain = load (path, vty);
+  prefix_list_reset ();
+  access_list_reset ();
+
+  cmd_trie_enable (1);
+  indexed = load (path, vty);
+
+  printf ("%d lines loaded in %lu usec without the index, "
+	  "%lu usec with it\n", n, plain, indexed);
+
+  cmd_trie_enable (0);
+  plain = match (path, vty);
+  cmd_trie_enable (1);
+  indexed = match (path, vty);
+  printf ("%d lines matched in %lu usec without the index, "
+	  "%lu usec with it\n", n, plain, indexed);
+  unlink (path);
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
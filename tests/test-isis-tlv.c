@@ -0,0 +1,469 @@
+/*
+ * Cross-check of the two isisd TLV parsers.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Generates the TLV part of PDUs carrying every TLV isisd knows, and some
+ * it does not, then damages part of them: flipped octets, TLV lengths
+ * changed, truncation.  Each is parsed with parse_tlvs() and with
+ * parse_tlv_view(), which must agree on the result, the TLVs found, the
+ * single valued TLVs and authentication, and the items of each repeated
+ * TLV, in the same order.  Then reports how long parsing a typical LSP
+ * and walking its items takes each way.
+ *
+ * Usage: testisistlv [pdus [seed]]
+ */
+#include <zebra.h>
+
+#include "thread.h"
+#include "log.h"
+#include "linklist.h"
+#include "stream.h"
+#include "memory.h"
+#include "prefix.h"
+#include "vty.h"
+#include "if.h"
+
+#include "isisd/dict.h"
+#include "isisd/isis_constants.h"
+#include "isisd/isis_common.h"
+#include "isisd/isis_flags.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isis_tlv.h"
+
+#include "timing.h"
+
+#define DEFAULT_PDUS 20000
+#define LSP_WALKS 20000
+
+struct thread_master *master;
+
+static int failed = 0;
+
+/* parse_tlvs() takes the area tag as a plain char * */
+static char areatag[] = "test";
+
+/* The repeated TLVs, and where parse_tlvs() lists their items */
+static const struct
+{
+  u_char type;
+  u_int32_t flag;
+  size_t offset;
+  const char *name;
+} repeated[] =
+{
+  { AREA_ADDRESSES, TLVFLAG_AREA_ADDRS,
+    offsetof (struct tlvs, area_addrs), "area addresses" },
+  { IS_NEIGHBOURS, TLVFLAG_IS_NEIGHS,
+    offsetof (struct tlvs, is_neighs), "IS neighbours" },
+  { TE_IS_NEIGHBOURS, TLVFLAG_TE_IS_NEIGHS,
+    offsetof (struct tlvs, te_is_neighs), "TE IS neighbours" },
+  { ES_NEIGHBOURS, TLVFLAG_ES_NEIGHS,
+    offsetof (struct tlvs, es_neighs), "ES neighbours" },
+  { LAN_NEIGHBOURS, TLVFLAG_LAN_NEIGHS,
+    offsetof (struct tlvs, lan_neighs), "LAN neighbours" },
+  { LSP_ENTRIES, TLVFLAG_LSP_ENTRIES,
+    offsetof (struct tlvs, lsp_entries), "LSP entries" },
+  { IPV4_ADDR, TLVFLAG_IPV4_ADDR,
+    offsetof (struct tlvs, ipv4_addrs), "IPv4 addresses" },
+  { IPV4_INT_REACHABILITY, TLVFLAG_IPV4_INT_REACHABILITY,
+    offsetof (struct tlvs, ipv4_int_reachs), "IPv4 internal reachability" },
+  { IPV4_EXT_REACHABILITY, TLVFLAG_IPV4_EXT_REACHABILITY,
+    offsetof (struct tlvs, ipv4_ext_reachs), "IPv4 external reachability" },
+  { TE_IPV4_REACHABILITY, TLVFLAG_TE_IPV4_REACHABILITY,
+    offsetof (struct tlvs, te_ipv4_reachs), "TE IPv4 reachability" },
+#ifdef HAVE_IPV6
+  { IPV6_ADDR, TLVFLAG_IPV6_ADDR,
+    offsetof (struct tlvs, ipv6_addrs), "IPv6 addresses" },
+  { IPV6_REACHABILITY, TLVFLAG_IPV6_REACHABILITY,
+    offsetof (struct tlvs, ipv6_reachs), "IPv6 reachability" },
+#endif /* HAVE_IPV6 */
+};
+
+#define REPEATED (sizeof (repeated) / sizeof (repeated[0]))
+
+static int
+rnd (int n)
+{
+  return random () % n;
+}
+
+static void
+rnd_fill (u_char *p, int len)
+{
+  while (len--)
+    *p++ = random ();
+}
+
+/* Appends a TLV of the given type with random, well formed contents, if
+   they fit in a TLV and in room.  Returns the octets added. */
+static int
+put_tlv (u_char *pnt, int room, u_char type)
+{
+  /* room for the longest TLVs generated, which are then dropped */
+  u_char value[1024];
+  int len = 0, n, i, item;
+
+  switch (type)
+    {
+    case AREA_ADDRESSES:
+      for (n = 1 + rnd (3); n; n--)
+	{
+	  item = 1 + rnd (13);
+	  value[len] = item;
+	  rnd_fill (value + len + 1, item);
+	  len += item + 1;
+	}
+      break;
+    case IS_NEIGHBOURS:
+      value[len++] = 0;
+      len += IS_NEIGHBOURS_LEN * rnd (20);
+      rnd_fill (value + 1, len - 1);
+      break;
+    case TE_IS_NEIGHBOURS:
+      for (n = rnd (12); n; n--)
+	{
+	  item = rnd (10);
+	  rnd_fill (value + len, 10);
+	  value[len + 10] = item;
+	  rnd_fill (value + len + 11, item);
+	  len += 11 + item;
+	}
+      break;
+    case ES_NEIGHBOURS:
+      len = 4 + ISIS_SYS_ID_LEN * rnd (10);
+      rnd_fill (value, len);
+      break;
+    case LAN_NEIGHBOURS:
+      len = ETH_ALEN * rnd (30);
+      rnd_fill (value, len);
+      break;
+    case PADDING:
+      len = rnd (256);
+      memset (value, 0, len);
+      break;
+    case LSP_ENTRIES:
+      len = LSP_ENTRIES_LEN * rnd (16);
+      rnd_fill (value, len);
+      break;
+    case AUTH_INFO:
+      value[0] = rnd (2) ? ISIS_PASSWD_TYPE_CLEARTXT
+	: ISIS_PASSWD_TYPE_HMAC_MD5;
+      len = 1 + (value[0] == ISIS_PASSWD_TYPE_CLEARTXT ? 1 + rnd (20) : 16);
+      rnd_fill (value + 1, len - 1);
+      break;
+    case CHECKSUM:
+      len = 2;
+      rnd_fill (value, len);
+      break;
+    case PROTOCOLS_SUPPORTED:
+      value[len++] = NLPID_IP;
+      if (rnd (2))
+	value[len++] = NLPID_IPV6;
+      break;
+    case IPV4_ADDR:
+      len = 4 * (1 + rnd (5));
+      rnd_fill (value, len);
+      break;
+    case DYNAMIC_HOSTNAME:
+      len = 1 + rnd (30);
+      for (i = 0; i < len; i++)
+	value[i] = 'a' + rnd (26);
+      break;
+    case TE_ROUTER_ID:
+      len = 4;
+      rnd_fill (value, len);
+      break;
+    case IPV4_INT_REACHABILITY:
+    case IPV4_EXT_REACHABILITY:
+      len = IPV4_REACH_LEN * rnd (21);
+      rnd_fill (value, len);
+      break;
+    case TE_IPV4_REACHABILITY:
+      for (n = rnd (25); n; n--)
+	{
+	  rnd_fill (value + len, 4);
+	  item = rnd (33);
+	  value[len + 4] = item | (rnd (4) ? 0 : 0x40) | (rnd (2) ? 0x80 : 0);
+	  item = item ? ((item - 1) >> 3) + 1 : 0;
+	  rnd_fill (value + len + 5, item);
+	  len += 5 + item;
+	  if (value[len - item - 1] & 0x40)
+	    {
+	      item = rnd (8);
+	      value[len] = item;
+	      rnd_fill (value + len + 1, item);
+	      len += 1 + item;
+	    }
+	}
+      break;
+    case IPV6_ADDR:
+      len = 16 * (1 + rnd (3));
+      rnd_fill (value, len);
+      break;
+    case IPV6_REACHABILITY:
+      for (n = rnd (10); n; n--)
+	{
+	  rnd_fill (value + len, 4);
+	  value[len + 4] = (rnd (4) ? 0 : CTRL_INFO_SUBTLVS)
+	    | (rnd (2) ? CTRL_INFO_DISTRIBUTION : 0);
+	  item = rnd (129);
+	  value[len + 5] = item;
+	  item = (item + 7) / 8;
+	  rnd_fill (value + len + 6, item);
+	  if (value[len + 4] & CTRL_INFO_SUBTLVS)
+	    {
+	      value[len + 6 + item] = rnd (8);
+	      rnd_fill (value + len + 7 + item, value[len + 6 + item]);
+	      item += 1 + value[len + 6 + item];
+	    }
+	  len += 6 + item;
+	}
+      break;
+    default:
+      /* 3-way hello, restart or unknown */
+      len = rnd (12);
+      rnd_fill (value, len);
+      break;
+    }
+
+  if (len > 255 || len + 2 > room)
+    return 0;
+
+  pnt[0] = type;
+  pnt[1] = len;
+  memcpy (pnt + 2, value, len);
+  return len + 2;
+}
+
+static const u_char types[] =
+{
+  AREA_ADDRESSES, IS_NEIGHBOURS, ES_NEIGHBOURS, LAN_NEIGHBOURS, PADDING,
+  LSP_ENTRIES, AUTH_INFO, CHECKSUM, TE_IS_NEIGHBOURS, IPV4_INT_REACHABILITY,
+  PROTOCOLS_SUPPORTED, IPV4_EXT_REACHABILITY, IPV4_ADDR, TE_ROUTER_ID,
+  TE_IPV4_REACHABILITY, DYNAMIC_HOSTNAME, GRACEFUL_RESTART, IPV6_ADDR,
+  IPV6_REACHABILITY, WAY3_HELLO, 229, 242,
+};
+
+/* The TLV part of a PDU, possibly damaged.  Returns its size. */
+static int
+make_pdu (u_char *buf, int size)
+{
+  int len = 0, added, n, i;
+
+  for (n = rnd (16); n; n--)
+    {
+      added = put_tlv (buf + len, size - len,
+		       types[rnd (sizeof (types))]);
+      len += added;
+    }
+
+  switch (rnd (4))
+    {
+    case 0:
+      /* flip some octets */
+      for (i = rnd (4); len && i >= 0; i--)
+	buf[rnd (len)] ^= 1 << rnd (8);
+      break;
+    case 1:
+      /* change the length of a TLV, or what is taken for one */
+      if (len)
+	buf[rnd (len)] = random ();
+      break;
+    case 2:
+      /* truncate */
+      if (len)
+	len = rnd (len + 1);
+      break;
+    }
+
+  return len;
+}
+
+static void
+compare (u_char *buf, int size, u_int32_t expected)
+{
+  struct tlvs tlvs;
+  struct tlv_view view;
+  struct tlv_iter iter;
+  struct listnode *node;
+  struct list *list;
+  u_int32_t found_list, found_view, exp_list, exp_view;
+  u_int32_t offset_list = 100, offset_view = 100;
+  int ret_list, ret_view;
+  unsigned int i;
+  void *item, *walked;
+
+  exp_list = exp_view = expected;
+  ret_list = parse_tlvs (areatag, buf, size, &exp_list, &found_list, &tlvs,
+			 &offset_list);
+  ret_view = parse_tlv_view (areatag, buf, size, &exp_view, &found_view,
+			     &view, &offset_view);
+
+  if (ret_list != ret_view || found_list != found_view
+      || offset_list != offset_view)
+    {
+      printf ("FAILED: result %d/%d, found 0x%x/0x%x, auth offset %u/%u\n",
+	      ret_list, ret_view, found_list, found_view,
+	      offset_list, offset_view);
+      failed++;
+    }
+
+  if (tlvs.checksum != view.checksum || tlvs.hostname != view.hostname
+      || tlvs.nlpids != view.nlpids || tlvs.router_id != view.router_id
+      || memcmp (&tlvs.auth_info, &view.auth_info,
+		 sizeof (struct isis_passwd)))
+    {
+      printf ("FAILED: single valued TLVs differ\n");
+      failed++;
+    }
+
+  for (i = 0; i < REPEATED; i++)
+    {
+      if (!(expected & repeated[i].flag))
+	continue;
+
+      list = *(struct list **) ((char *) &tlvs + repeated[i].offset);
+      node = list ? listhead (list) : NULL;
+      TLV_VIEW_FOREACH (&view, iter, repeated[i].type, walked)
+	{
+	  item = node ? listgetdata (node) : NULL;
+	  if (item != walked)
+	    break;
+	  node = listnextnode (node);
+	}
+      if (walked || node)
+	{
+	  printf ("FAILED: %s differ\n", repeated[i].name);
+	  failed++;
+	}
+    }
+
+  free_tlvs (&tlvs);
+}
+
+/* Neighbours and prefixes as in the LSP of a router of some size */
+static int
+make_lsp (u_char *buf, int size)
+{
+  int len = 0, i, n, item;
+  u_char *value;
+
+  len += put_tlv (buf + len, size - len, AREA_ADDRESSES);
+  len += put_tlv (buf + len, size - len, PROTOCOLS_SUPPORTED);
+  len += put_tlv (buf + len, size - len, DYNAMIC_HOSTNAME);
+  len += put_tlv (buf + len, size - len, IPV4_ADDR);
+  for (n = 0; n < 6; n++)
+    {
+      item = n < 2 ? IS_NEIGHBOURS_LEN : IPV4_REACH_LEN;
+      buf[len] = n < 2 ? IS_NEIGHBOURS : IPV4_INT_REACHABILITY;
+      buf[len + 1] = 20 * item + (n < 2);
+      value = buf + len + 2;
+      if (n < 2)
+	*value++ = 0;
+      for (i = 0; i < 20; i++, value += item)
+	rnd_fill (value, item);
+      len += 2 + buf[len + 1];
+    }
+  return len;
+}
+
+static void
+bench (void)
+{
+  u_char buf[1500];
+  struct tlvs tlvs;
+  struct tlv_view view;
+  struct tlv_iter iter;
+  struct listnode *node;
+  struct timeval start;
+  u_int32_t expected, found;
+  unsigned long usec, items = 0;
+  void *item;
+  int size, i;
+
+  size = make_lsp (buf, sizeof (buf));
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < LSP_WALKS; i++)
+    {
+      expected = 0xffffffff;
+      parse_tlvs (areatag, buf, size, &expected, &found, &tlvs, NULL);
+      for (ALL_LIST_ELEMENTS_RO (tlvs.is_neighs, node, item))
+	items++;
+      for (ALL_LIST_ELEMENTS_RO (tlvs.ipv4_int_reachs, node, item))
+	items++;
+      free_tlvs (&tlvs);
+    }
+  usec = elapsed_usec (&start);
+  printf ("%d LSPs of %d octets parsed into lists and walked "
+	  "in %lu usec\n", LSP_WALKS, size, usec);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < LSP_WALKS; i++)
+    {
+      expected = 0xffffffff;
+      parse_tlv_view (areatag, buf, size, &expected, &found, &view, NULL);
+      TLV_VIEW_FOREACH (&view, iter, IS_NEIGHBOURS, item)
+	items--;
+      TLV_VIEW_FOREACH (&view, iter, IPV4_INT_REACHABILITY, item)
+	items--;
+    }
+  usec = elapsed_usec (&start);
+  printf ("%d LSPs of %d octets parsed into views and walked "
+	  "in %lu usec\n", LSP_WALKS, size, usec);
+
+  if (items != 0)
+    {
+      printf ("FAILED: LSP items walked differ\n");
+      failed++;
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  u_char buf[1500];
+  int n = DEFAULT_PDUS, i, size;
+  u_int32_t expected;
+
+  if (argc > 1)
+    n = atoi (argv[1]);
+  srandom (argc > 2 ? atoi (argv[2]) : 1);
+
+  /* The damaged PDUs have parse_tlvs() warn a lot */
+  zlog_default = openzlog ("testisistlv", ZLOG_NONE,
+			   LOG_CONS|LOG_NDELAY|LOG_PID, LOG_DAEMON);
+  zlog_set_level (NULL, ZLOG_DEST_SYSLOG, ZLOG_DISABLED);
+  zlog_set_level (NULL, ZLOG_DEST_STDOUT, ZLOG_DISABLED);
+  zlog_set_level (NULL, ZLOG_DEST_MONITOR, ZLOG_DISABLED);
+
+  for (i = 0; i < n; i++)
+    {
+      size = make_pdu (buf, sizeof (buf));
+      expected = rnd (2) ? 0xffffffff : (u_int32_t) random ();
+      compare (buf, size, expected);
+    }
+  printf ("%d PDUs compared\n", n);
+
+  bench ();
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -0,0 +1,227 @@
+/*
+ * Micro-benchmark of synchronous against asynchronous logging.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Logs the same debug messages to a file, first synchronously and then
+ * through the logging ring, and reports messages per second for each.
+ * For the ring, the time spent in the logging calls themselves (what
+ * the daemon's hot paths see) is reported apart from the total, which
+ * includes the background writer.
+ *
+ * Usage: testlogasync [messages [file]]
+ */
+#include <zebra.h>
+
+#include "thread.h"
+#include "log.h"
+#include "memory.h"
+
+#include "timing.h"
+
+#define DEFAULT_MESSAGES 100000
+#define BURST 100
+
+struct thread_master *master;
+
+static int failed = 0;
+
+static void
+log_burst (int first, int count, int total)
+{
+  int i;
+
+  for (i = first; i < first + count; i++)
+    zlog_debug ("flooding: message %d of %d, LSA 0x%08x from %s", i, total,
+		(unsigned int) i * 2654435761U, "192.0.2.1");
+}
+
+/* Run the writer until the ring is empty. */
+static void
+run_writer (void)
+{
+  struct thread thread;
+
+  while (zlog_async_used (zlog_default))
+    if (thread_fetch (master, &thread))
+      thread_call (&thread);
+}
+
+static unsigned long
+count_lines (const char *path)
+{
+  FILE *fp;
+  unsigned long lines = 0;
+  int c;
+
+  if ((fp = fopen (path, "r")) == NULL)
+    return 0;
+  while ((c = getc (fp)) != EOF)
+    if (c == '\n')
+      lines++;
+  fclose (fp);
+  return lines;
+}
+
+#ifdef __GLIBC__
+static int refilled = 0;
+static int warnings_written = 0;
+
+/* Log file that, the first time it is written to, fills the ring up
+   again and logs a warning, as a monitor vty or a failing write might
+   while the ring is being written out. */
+static ssize_t
+refill_write (void *cookie, const char *buf, size_t size)
+{
+  unsigned long dropped;
+
+  if (memmem (buf, size, "warning while writing", 21))
+    warnings_written++;
+
+  if (!refilled)
+    {
+      refilled = 1;
+      dropped = zlog_default->dropped;
+      while (zlog_default->dropped == dropped)
+	zlog_debug ("refilling the ring");
+      zlog_warn ("warning while writing");
+    }
+  return size;
+}
+#endif /* __GLIBC__ */
+
+static void
+report (const char *what, int n, unsigned long usec)
+{
+  printf ("%-28s %8lu usec, %10.0f messages/sec\n", what, usec,
+	  usec ? n * 1e6 / usec : 0.0);
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *path = "/tmp/testlogasync.log";
+  struct timeval start, burst;
+  unsigned long usec, producer;
+  unsigned long lines, dropped;
+  int n = DEFAULT_MESSAGES;
+  int i;
+
+  if (argc > 1)
+    n = atoi (argv[1]);
+  if (argc > 2)
+    path = argv[2];
+  if (n < BURST)
+    n = BURST;
+
+  master = thread_master_create ();
+  zlog_default = openzlog ("testlogasync", ZLOG_NONE,
+			   LOG_CONS|LOG_NDELAY|LOG_PID, LOG_DAEMON);
+  zlog_set_level (NULL, ZLOG_DEST_MONITOR, ZLOG_DISABLED);
+  unlink (path);
+  if (!zlog_set_file (NULL, path, LOG_DEBUG))
+    {
+      printf ("cannot open %s\n", path);
+      return 1;
+    }
+
+  /* Synchronous: write and flush every line. */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  log_burst (0, n, n);
+  report ("synchronous", n, elapsed_usec (&start));
+
+  /* Asynchronous, with the writer running between bursts as it would
+     between events in a daemon. */
+  zlog_async_init (master);
+  if (!zlog_async_enable (NULL, ZLOG_ASYNC_SIZE_DEFAULT))
+    {
+      printf ("FAILED: cannot enable asynchronous logging\n");
+      return 1;
+    }
+  producer = 0;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < n; i += BURST)
+    {
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &burst);
+      log_burst (i, BURST, n);
+      producer += elapsed_usec (&burst);
+      run_writer ();
+    }
+  usec = elapsed_usec (&start);
+  report ("asynchronous, logging calls", n, producer);
+  report ("asynchronous, total", n, usec);
+
+  if (zlog_default->dropped)
+    {
+      printf ("FAILED: %lu messages dropped\n", zlog_default->dropped);
+      failed++;
+    }
+
+  /* Overflow: with no writer running, debugging messages are dropped
+     once the ring is full, warnings get through. */
+  zlog_async_enable (NULL, 0);
+  log_burst (0, n, n);
+  zlog_warn ("warning after overflow");
+  dropped = zlog_default->dropped;
+  printf ("%lu of %d messages dropped with the writer stalled\n", dropped, n);
+  if (dropped == 0 || dropped >= (unsigned long) n)
+    {
+      printf ("FAILED: overflow not handled\n");
+      failed++;
+    }
+
+  zlog_async_disable (NULL);
+  zlog_reset_file (NULL);
+
+  /* Every message written once, plus the warning and the drop notice. */
+  lines = count_lines (path);
+  if (lines != 3 * (unsigned long) n - dropped + 2)
+    {
+      printf ("FAILED: %lu lines logged, expected %lu\n", lines,
+	      3 * (unsigned long) n - dropped + 2);
+      failed++;
+    }
+  unlink (path);
+
+#ifdef __GLIBC__
+  /* A warning logged while the full ring is being written out can't
+     wait for it, it is written out synchronously. */
+  {
+    cookie_io_functions_t funcs = { NULL, refill_write, NULL, NULL };
+
+    zlog_default->fp = fopencookie (NULL, "w", funcs);
+    setvbuf (zlog_default->fp, NULL, _IONBF, 0);
+    zlog_default->maxlvl[ZLOG_DEST_FILE] = LOG_DEBUG;
+    zlog_async_enable (NULL, 0);
+    zlog_debug ("first message");
+    zlog_async_flush (NULL);
+    zlog_async_disable (NULL);
+    zlog_reset_file (NULL);
+    if (warnings_written != 1)
+      {
+	printf ("FAILED: warning logged while writing written %d times\n",
+		warnings_written);
+	failed++;
+      }
+  }
+#endif /* __GLIBC__ */
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
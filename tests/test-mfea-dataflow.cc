@@ -0,0 +1,319 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+//
+// Test the MFEA dataflow monitoring with the kernel MFC table read in bulk.
+//
+// A canned Linux MFC table is parsed and looked-up first.  Then a number
+// of dataflow entries are added, and a sequence of MFC tables is fed to
+// them, one per measurement.  The threshold events that result must match
+// the traffic in the tables.
+//
+
+#ifndef	XORP_MODULE_NAME
+#define XORP_MODULE_NAME	"TEST_MFEA_DATAFLOW"
+#endif
+#ifndef XORP_MODULE_VERSION
+#define XORP_MODULE_VERSION	"0.1"
+#endif
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/eventloop.hh"
+#include "libxorp/ipvx.hh"
+
+#include "fea/mfea_dataflow.hh"
+#include "fea/mfea_mrouter.hh"
+#include "fea/mfea_node.hh"
+
+#define SOURCES		20	// The number of dataflow entries
+#define ROUNDS		8	// The number of measurements
+
+static int failed = 0;
+
+//
+// A MFEA node that doesn't talk to anybody.
+//
+class TestMfeaNode : public MfeaNode {
+public:
+    TestMfeaNode(EventLoop& eventloop)
+	: MfeaNode(AF_INET, XORP_MODULE_MFEA, eventloop) {}
+
+    int send_add_config_vif(const string&, xorp_module_id, const string&,
+			    uint32_t) { return (XORP_OK); }
+    int send_delete_config_vif(const string&, xorp_module_id,
+			       const string&) { return (XORP_OK); }
+    int send_add_config_vif_addr(const string&, xorp_module_id,
+				 const string&, const IPvX&, const IPvXNet&,
+				 const IPvX&, const IPvX&) {
+	return (XORP_OK);
+    }
+    int send_delete_config_vif_addr(const string&, xorp_module_id,
+				    const string&, const IPvX&) {
+	return (XORP_OK);
+    }
+    int send_set_config_vif_flags(const string&, xorp_module_id,
+				  const string&, bool, bool, bool, bool, bool,
+				  bool, uint32_t) { return (XORP_OK); }
+    int send_set_config_all_vifs_done(const string&, xorp_module_id) {
+	return (XORP_OK);
+    }
+    int dataflow_signal_send(const string&, xorp_module_id, const IPvX&,
+			     const IPvX&, uint32_t, uint32_t, uint32_t,
+			     uint32_t, uint32_t, uint32_t, uint32_t, uint32_t,
+			     bool, bool, bool, bool) { return (XORP_OK); }
+    int proto_send(const string&, xorp_module_id, uint32_t, const IPvX&,
+		   const IPvX&, int, int, bool, const uint8_t *, size_t,
+		   string&) { return (XORP_OK); }
+    int signal_message_send(const string&, xorp_module_id, int, uint32_t,
+			    const IPvX&, const IPvX&, const uint8_t *,
+			    size_t) { return (XORP_OK); }
+    int raise_privileges() { return (XORP_OK); }
+    int lower_privileges() { return (XORP_OK); }
+};
+
+//
+// Format an IPv4 MFC table line the way the kernel does.
+//
+static string
+mfc_line(const IPvX& source, const IPvX& group, int iif, unsigned long pktcnt,
+	 unsigned long bytecnt, unsigned long wrong_if)
+{
+    struct in_addr s, g;
+
+    source.copy_out(s);
+    group.copy_out(g);
+    return (c_format("%08X %08X %-3d %8lu %8lu %8lu  1:1    2:1\n",
+		     (unsigned)g.s_addr, (unsigned)s.s_addr, iif,
+		     pktcnt, bytecnt, wrong_if));
+}
+
+static const char mfc_header[] =
+    "Group    Origin   Iif     Pkts    Bytes    Wrong Oifs\n";
+
+static void
+test_parse()
+{
+    IPvX s1(IPv4("10.0.0.1")), s2(IPv4("10.0.0.2"));
+    IPvX g1(IPv4("225.1.1.1")), g2(IPv4("239.255.0.1"));
+    SgCountTable table(AF_INET);
+    SgCount sg_count;
+
+    string text = mfc_header;
+    text += mfc_line(s2, g1, 0, 7, 700, 1);
+    text += mfc_line(s1, g2, 1, 5000000000UL, 1, 0);
+    text += mfc_line(s1, g1, 2, 3, 300, 0);
+    text += mfc_line(s2, g2, -1, 0, 0, 0);	// Unresolved
+
+    if ((table.parse_linux_mfc(text) != XORP_OK) || (table.size() != 3)) {
+	printf("FAILED: parse: %u entries\n", XORP_UINT_CAST(table.size()));
+	failed++;
+    }
+    if ((table.get_sg_count(s1, g1, sg_count) != XORP_OK)
+	|| (sg_count.pktcnt() != 3) || (sg_count.bytecnt() != 300)
+	|| (sg_count.wrong_if() != 0)) {
+	printf("FAILED: parse: wrong counters for %s\n", cstring(s1));
+	failed++;
+    }
+    if ((table.get_sg_count(s2, g1, sg_count) != XORP_OK)
+	|| (sg_count.pktcnt() != 7) || (sg_count.bytecnt() != 700)
+	|| (sg_count.wrong_if() != 1)) {
+	printf("FAILED: parse: wrong counters for %s\n", cstring(s2));
+	failed++;
+    }
+    if ((table.get_sg_count(s1, g2, sg_count) != XORP_OK)
+	|| ((sizeof(size_t) > 4)
+	    && (sg_count.pktcnt() != (size_t)5000000000UL))) {
+	printf("FAILED: parse: wrong 64-bit counter\n");
+	failed++;
+    }
+    if ((table.get_sg_count(s2, g2, sg_count) != XORP_ERROR)
+	|| (table.get_sg_count(g1, s1, sg_count) != XORP_ERROR)) {
+	printf("FAILED: parse: unresolved or unknown entry found\n");
+	failed++;
+    }
+
+    // A table with no entries
+    if ((table.parse_linux_mfc(mfc_header) != XORP_OK)
+	|| (table.size() != 0)) {
+	printf("FAILED: parse: empty table\n");
+	failed++;
+    }
+
+    // A damaged table
+    if (table.parse_linux_mfc(text + "0A000001 E1\n") != XORP_ERROR) {
+	printf("FAILED: parse: damaged table accepted\n");
+	failed++;
+    }
+
+#ifdef HAVE_IPV6
+    SgCountTable table6(AF_INET6);
+    const char text6[] =
+	"Group                            Origin                           "
+	"Iif      Pkts  Bytes     Wrong  Oifs\n"
+	"ff0e:0000:0000:0000:0000:0000:0000:0101 "
+	"2001:0db8:0000:0000:0000:0000:0000:0001 1         12     1200"
+	"        0  2:1\n"
+	"ff0e:0000:0000:0000:0000:0000:0000:0102 "
+	"2001:0db8:0000:0000:0000:0000:0000:0002 -1         0        0"
+	"        0\n";
+
+    if ((table6.parse_linux_mfc(text6) != XORP_OK) || (table6.size() != 1)
+	|| (table6.get_sg_count(IPvX(IPv6("2001:db8::1")),
+				IPvX(IPv6("ff0e::101")), sg_count) != XORP_OK)
+	|| (sg_count.pktcnt() != 12) || (sg_count.bytecnt() != 1200)) {
+	printf("FAILED: parse: IPv6 table\n");
+	failed++;
+    }
+#endif
+}
+
+//
+// The traffic of each source per measurement, and the threshold to test.
+// The threshold interval spans MFEA_DATAFLOW_TEST_FREQUENCY measurements.
+//
+static const struct {
+    unsigned long pktcnt;	// Packets per measurement
+    bool	is_geq_upcall;	// ">=" if true, otherwise "<="
+    uint32_t	threshold;	// Threshold in packets
+    int		first_event;	// First measurement with an event, or 0
+} flows[] = {
+    { 40, true, 100, 3 },	// 40, 80, 120...
+    { 10, true, 100, 0 },	// Never reaches 100
+    { 0, false, 10, MFEA_DATAFLOW_TEST_FREQUENCY },
+				// After the first complete interval
+    { 50, false, 10, 0 },	// Never below 10
+};
+#define FLOWS	(sizeof(flows) / sizeof(flows[0]))
+
+static void
+write_file(const string& file_name, const string& text)
+{
+    FILE *fp = fopen(file_name.c_str(), "w");
+
+    if ((fp == NULL) || (fwrite(text.data(), 1, text.size(), fp)
+			 != text.size())) {
+	XLOG_FATAL("Cannot write %s: %s", file_name.c_str(), strerror(errno));
+    }
+    fclose(fp);
+}
+
+static void
+test_dataflow()
+{
+    EventLoop eventloop;
+    TestMfeaNode mfea_node(eventloop);
+    MfeaDft& mfea_dft = mfea_node.mfea_dft();
+    IPvX group(IPv4("225.1.1.1"));
+    vector<IPvX> sources;
+    vector<MfeaDfe *> dfes;
+    string error_msg;
+    char file_name[] = "/tmp/test-mfea-dataflow.XXXXXX";
+    int fd;
+
+    fd = mkstemp(file_name);
+    if (fd < 0)
+	XLOG_FATAL("mkstemp() failed: %s", strerror(errno));
+    close(fd);
+    mfea_node.mfea_mrouter().set_sg_count_table_file(file_name);
+    // XXX: the mrouter is not started, so there is no other way to read
+    // the counters.
+    mfea_dft.set_sg_count_table_min_entries(1);
+
+    for (size_t i = 0; i < SOURCES; i++)
+	sources.push_back(IPvX(IPv4(htonl(0x0a000001 + i))));
+
+    // The initial counters
+    string text = mfc_header;
+    for (size_t i = 0; i < SOURCES; i++)
+	text += mfc_line(sources[i], group, 0, 1000, 100000, 0);
+    write_file(file_name, text);
+
+    for (size_t i = 0; i < SOURCES; i++) {
+	const size_t f = i % FLOWS;
+	if (mfea_dft.add_entry(sources[i], group, TimeVal(3, 0),
+			       flows[f].threshold, 0, true, false,
+			       flows[f].is_geq_upcall,
+			       ! flows[f].is_geq_upcall, true,
+			       error_msg) != XORP_OK) {
+	    printf("FAILED: cannot add entry for %s: %s\n",
+		   cstring(sources[i]), error_msg.c_str());
+	    failed++;
+	}
+	MfeaDfeLookup *mfea_dfe_lookup = mfea_dft.find(sources[i], group);
+	MfeaDfe *mfea_dfe = NULL;
+	if (mfea_dfe_lookup != NULL) {
+	    mfea_dfe = mfea_dfe_lookup->find(TimeVal(3, 0),
+					     flows[f].threshold, 0,
+					     true, false,
+					     flows[f].is_geq_upcall,
+					     ! flows[f].is_geq_upcall,
+					     true);
+	}
+	if (mfea_dfe == NULL) {
+	    printf("FAILED: entry for %s not found\n", cstring(sources[i]));
+	    failed++;
+	    return;
+	}
+	dfes.push_back(mfea_dfe);
+    }
+
+    for (int round = 1; round <= ROUNDS; round++) {
+	text = mfc_header;
+	for (size_t i = 0; i < SOURCES; i++) {
+	    const size_t f = i % FLOWS;
+	    unsigned long pktcnt = 1000 + round * flows[f].pktcnt;
+	    text += mfc_line(sources[i], group, 0, pktcnt, pktcnt * 100, 0);
+	}
+	write_file(file_name, text);
+
+	for (size_t i = 0; i < SOURCES; i++) {
+	    const size_t f = i % FLOWS;
+	    bool expected = ((flows[f].first_event != 0)
+			     && (round >= flows[f].first_event));
+
+	    if (i == SOURCES / 2) {
+		// The table was read once for all entries in this round
+		write_file(file_name, "damaged\n");
+	    }
+
+	    bool event = dfes[i]->test_sg_count();
+	    if (event != expected) {
+		printf("FAILED: round %d source %s: event %d expected %d\n",
+		       round, cstring(sources[i]), event, expected);
+		failed++;
+	    }
+	    if ((round >= MFEA_DATAFLOW_TEST_FREQUENCY)
+		&& (dfes[i]->measured_packets()
+		    != MFEA_DATAFLOW_TEST_FREQUENCY * flows[f].pktcnt)) {
+		printf("FAILED: round %d source %s: %u packets measured\n",
+		       round, cstring(sources[i]),
+		       XORP_UINT_CAST(dfes[i]->measured_packets()));
+		failed++;
+	    }
+	    dfes[i]->start_measurement();
+	}
+    }
+
+    unlink(file_name);
+}
+
+int
+main(int argc, char *argv[])
+{
+    UNUSED(argc);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    test_parse();
+    test_dataflow();
+
+    xlog_stop();
+    xlog_exit();
+
+    printf("failures: %d\n", failed);
+    return (failed);
+}
@@ -79,6 +79,7 @@ usage(int exit_value, const char *fmt, ...)
 	    "    -C, --dryrun       Check configuration for validity and exit\n"
 	    "    -4, --ipv4         Use IPv4 (default)\n"
 	    "    -6, --ipv6         Use IPv6\n"
+	    "    -S, --select       Wait for I/O with select() instead of epoll()\n"
 	    "    -h, --help         Display this help and exit\n");
 
     exit(exit_value);
@@ -118,7 +119,7 @@ multicast_main(bool daemonize, const char *config_file, const char *pid_file,
 	       const char *zebra_socket,
 	       const char *vty_addr, uint16_t vty_port,
 	       const char *user, const char *group, const char *vtysh_path,
-	       bool dryrun, int family)
+	       bool dryrun, int family, SelectorList::Backend backend)
 {
     zebra_capabilities_t caps[] = {
 	ZCAP_NET_ADMIN,
@@ -152,7 +153,7 @@ multicast_main(bool daemonize, const char *config_file, const char *pid_file,
 	},
     };
 
-    EventLoop eventloop;
+    EventLoop eventloop(backend);
 
     //
     // ZebraRouter Node
@@ -295,6 +296,7 @@ main(int argc, char *argv[])
     const char *vtysh_path = XPIMD_VTYSH_PATH; // XXX add command-line option?
     bool dryrun = false;
     int family = AF_INET;
+    SelectorList::Backend backend = SelectorList::default_backend();
 
     umask(0027);		// setup file creation permissions
 
@@ -327,11 +329,12 @@ main(int argc, char *argv[])
 	{"help",        no_argument,       NULL, 'h'},
 	{"ipv4",        no_argument,       NULL, '4'},
 	{"ipv6",        no_argument,       NULL, '6'},
+	{"select",      no_argument,       NULL, 'S'},
 	{},
     };
 
     for (;;) {
-	int ch = getopt_long(argc, argv, "df:i:z:A:P:u:g:vCh4"
+	int ch = getopt_long(argc, argv, "df:i:z:A:P:u:g:vCh4S"
 #ifdef HAVE_IPV6_MULTICAST
 			     "6"
 #endif	// HAVE_IPV6_MULTICAST
@@ -403,6 +406,10 @@ main(int argc, char *argv[])
 	    break;
 #endif	// HAVE_IPV6_MULTICAST
 
+	case 'S':
+	    backend = SelectorList::BACKEND_SELECT;
+	    break;
+
 	default:
 	    usage(1, NULL);
 	    // NOTREACHED
@@ -423,7 +430,7 @@ main(int argc, char *argv[])
     try {
 	multicast_main(daemonize, config_file, pid_file, zebra_socket,
 		       vty_addr, vty_port, user, group,
-		       vtysh_path, dryrun, family);
+		       vtysh_path, dryrun, family, backend);
     } catch(...) {
 	xorp_catch_standard_exceptions();
     }
@@ -0,0 +1,220 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+//
+// Measure the IGMP group membership processing under a report storm.
+//
+// A number of hosts on a single interface report membership in a number
+// of groups.  Half of the groups are ASM groups joined and left with
+// IGMPv2-style reports (IS_EX and TO_IN with no sources).  The other half
+// are SSM groups with IGMPv3 source lists (IS_IN, ALLOW, BLOCK and TO_IN).
+// After each round all group records are walked once, as the querier
+// does when it sends a General Query.
+//
+
+#ifndef	XORP_MODULE_NAME
+#define XORP_MODULE_NAME	"MLD6IGMP_BENCH"
+#endif
+#ifndef XORP_MODULE_VERSION
+#define XORP_MODULE_VERSION	"0.1"
+#endif
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/eventloop.hh"
+#include "libxorp/ipvx.hh"
+#include "libxorp/vif.hh"
+
+#include "mld6igmp/mld6igmp_group_record.hh"
+#include "mld6igmp/mld6igmp_node.hh"
+#include "mld6igmp/mld6igmp_vif.hh"
+
+#include <sys/time.h>
+#include <getopt.h>
+
+static unsigned long notifications;
+
+//
+// A MLD6IGMP node that doesn't talk to anybody.
+//
+class BenchMld6igmpNode : public Mld6igmpNode {
+public:
+    BenchMld6igmpNode(EventLoop& eventloop)
+	: Mld6igmpNode(AF_INET, XORP_MODULE_MLD6IGMP, eventloop) {}
+
+    int proto_send(const string&, xorp_module_id, uint32_t, const IPvX&,
+		   const IPvX&, int, int, bool, const uint8_t *, size_t,
+		   string&) { return (XORP_OK); }
+    int signal_message_recv(const string&, xorp_module_id, int, uint32_t,
+			    const IPvX&, const IPvX&, const uint8_t *,
+			    size_t) { return (XORP_OK); }
+    int signal_message_send(const string&, xorp_module_id, int, uint32_t,
+			    const IPvX&, const IPvX&, const uint8_t *,
+			    size_t) { return (XORP_OK); }
+    int start_protocol_kernel_vif(uint32_t) { return (XORP_OK); }
+    int stop_protocol_kernel_vif(uint32_t) { return (XORP_OK); }
+    int join_multicast_group(uint32_t, const IPvX&) { return (XORP_OK); }
+    int leave_multicast_group(uint32_t, const IPvX&) { return (XORP_OK); }
+    int send_add_membership(const string&, xorp_module_id, uint32_t,
+			    const IPvX&, const IPvX&) {
+	notifications++;
+	return (XORP_OK);
+    }
+    int send_delete_membership(const string&, xorp_module_id, uint32_t,
+			       const IPvX&, const IPvX&) {
+	notifications++;
+	return (XORP_OK);
+    }
+    void mfea_register_startup() {}
+    void mfea_register_shutdown() {}
+};
+
+static double
+now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [-g groups] [-s sources per SSM group] "
+	    "[-r rounds]\n", progname);
+    exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int ngroups = 8192;
+    int nsources = 16;
+    int rounds = 20;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "g:s:r:")) != -1) {
+	switch (ch) {
+	case 'g':
+	    ngroups = atoi(optarg);
+	    break;
+	case 's':
+	    nsources = atoi(optarg);
+	    break;
+	case 'r':
+	    rounds = atoi(optarg);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (ngroups <= 0 || ngroups > 65536 || nsources <= 1 || nsources > 256
+	|| rounds <= 0)
+	usage(argv[0]);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    EventLoop eventloop;
+    BenchMld6igmpNode mld6igmp_node(eventloop);
+    string error_msg;
+
+    Vif vif("eth0");
+    vif.set_vif_index(0);
+    if (mld6igmp_node.add_vif(vif, error_msg) != XORP_OK)
+	XLOG_FATAL("Cannot add vif: %s", error_msg.c_str());
+    Mld6igmpVif *mld6igmp_vif = mld6igmp_node.vif_find_by_vif_index(0);
+    XLOG_ASSERT(mld6igmp_vif != NULL);
+    mld6igmp_vif->add_protocol(XORP_MODULE_PIMSM, "pim");
+    Mld6igmpGroupSet& group_records = mld6igmp_vif->group_records();
+
+    //
+    // The groups, in the random order the reports arrive in
+    //
+    vector<IPvX> asm_groups, ssm_groups;
+    srandom(1);
+    for (int i = 0; i < ngroups; i++) {
+	uint32_t addr = (i % 2)? 0xe8000000 : 0xef000000;  // 232/8, 239/8
+	addr |= ((i / 2) << 8) | 1;
+	if (i % 2)
+	    ssm_groups.push_back(IPvX(IPv4(htonl(addr))));
+	else
+	    asm_groups.push_back(IPvX(IPv4(htonl(addr))));
+    }
+    for (size_t i = asm_groups.size(); i > 1; i--)
+	swap(asm_groups[i - 1], asm_groups[random() % i]);
+    for (size_t i = ssm_groups.size(); i > 1; i--)
+	swap(ssm_groups[i - 1], ssm_groups[random() % i]);
+
+    //
+    // The sources of each SSM group, split in two halves: the first
+    // half is kept, and the second half is added and removed each round.
+    //
+    set<IPvX> no_sources, kept_sources, changed_sources, all_sources;
+    for (int i = 0; i < nsources; i++) {
+	IPvX source(IPv4(htonl(0x0a000001 + i * 0x100)));
+	if (i < nsources / 2)
+	    kept_sources.insert(source);
+	else
+	    changed_sources.insert(source);
+	all_sources.insert(source);
+    }
+
+    IPvX host(IPv4("10.1.0.2"));
+    unsigned long reports = 0;
+    unsigned long walked = 0;
+    double start = now();
+
+    for (int r = 0; r < rounds; r++) {
+	for (size_t i = 0; i < asm_groups.size(); i++) {
+	    group_records.process_mode_is_exclude(asm_groups[i], no_sources,
+						  host);
+	    reports++;
+	}
+	for (size_t i = 0; i < ssm_groups.size(); i++) {
+	    const IPvX& group = ssm_groups[i];
+	    group_records.process_mode_is_include(group, kept_sources, host);
+	    group_records.process_allow_new_sources(group, changed_sources,
+						    host);
+	    group_records.process_block_old_sources(group, changed_sources,
+						    host);
+	    group_records.process_mode_is_include(group, all_sources, host);
+	    reports += 4;
+	}
+	// Some of the hosts leave
+	for (size_t i = r % 4; i < asm_groups.size(); i += 4) {
+	    group_records.process_change_to_include_mode(asm_groups[i],
+							 no_sources, host);
+	    reports++;
+	}
+	for (size_t i = r % 4; i < ssm_groups.size(); i += 4) {
+	    group_records.process_change_to_include_mode(ssm_groups[i],
+							 kept_sources, host);
+	    reports++;
+	}
+
+	// The General Query walk
+	Mld6igmpGroupSet::const_iterator group_iter;
+	for (group_iter = group_records.begin();
+	     group_iter != group_records.end();
+	     ++group_iter) {
+	    const Mld6igmpGroupRecord *group_record = group_iter->second;
+	    walked += 1 + group_record->do_forward_sources().size();
+	}
+    }
+    double elapsed = now() - start;
+
+    printf("%d groups %d sources: %8.0f group records/s, "
+	   "%lu notifications, %lu records walked\n",
+	   ngroups, nsources, reports / elapsed, notifications, walked);
+
+    group_records.delete_payload_and_clear();
+
+    xlog_stop();
+    xlog_exit();
+
+    return 0;
+}
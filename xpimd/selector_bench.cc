@@ -0,0 +1,175 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+//
+// Compare I/O dispatch through the EventLoop with the select() and
+// epoll() selector backends.
+//
+// A number of socket pairs are registered for reading, along with a
+// number of periodic timers.  Each round makes a few of the sockets
+// readable and runs the event loop until their callbacks have been
+// dispatched.
+//
+
+#ifndef	XORP_MODULE_NAME
+#define XORP_MODULE_NAME	"SELECTOR_BENCH"
+#endif
+#ifndef XORP_MODULE_VERSION
+#define XORP_MODULE_VERSION	"0.1"
+#endif
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/callback.hh"
+#include "libxorp/eventloop.hh"
+
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <getopt.h>
+
+static int dispatched;
+static int timer_fired;
+
+static void
+read_cb(XorpFd fd, IoEventType type)
+{
+    char buf[16];
+
+    UNUSED(type);
+    if (read(fd, buf, sizeof(buf)) > 0)
+	dispatched++;
+}
+
+static bool
+timer_cb()
+{
+    timer_fired++;
+    return true;
+}
+
+static double
+now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+bench(SelectorList::Backend backend, int npairs, int ntimers, int rounds,
+      int active)
+{
+    EventLoop eventloop(backend);
+    vector<int> fds(2 * npairs);
+    list<XorpTimer> timers;
+
+    for (int i = 0; i < npairs; i++) {
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, &fds[2 * i]) < 0)
+	    XLOG_FATAL("socketpair() failed: %s", strerror(errno));
+	if (!eventloop.add_ioevent_cb(XorpFd(fds[2 * i]), IOT_READ,
+				      callback(read_cb)))
+	    XLOG_FATAL("add_ioevent_cb() failed: fd = %d", fds[2 * i]);
+    }
+
+    for (int i = 0; i < ntimers; i++)
+	timers.push_back(eventloop.new_periodic_ms(100 + i % 900,
+						   callback(timer_cb)));
+
+    dispatched = 0;
+    timer_fired = 0;
+    srandom(1);
+
+    double start = now();
+    for (int r = 0; r < rounds; r++) {
+	int goal = dispatched + active;
+
+	for (int i = 0; i < active; i++) {
+	    int pair = random() % npairs;
+	    if (write(fds[2 * pair + 1], "x", 1) != 1)
+		XLOG_FATAL("write() failed: %s", strerror(errno));
+	}
+	// datagrams are read one per callback
+	while (dispatched < goal)
+	    eventloop.run();
+    }
+    double elapsed = now() - start;
+
+    printf("%-6s  %5d fds %5d timers: %8.0f dispatches/s, %d timer "
+	   "callbacks\n",
+	   backend == SelectorList::BACKEND_EPOLL ? "epoll" : "select",
+	   (int)eventloop.descriptor_count(), ntimers,
+	   dispatched / elapsed, timer_fired);
+
+    timers.clear();
+    for (int i = 0; i < npairs; i++) {
+	eventloop.remove_ioevent_cb(XorpFd(fds[2 * i]), IOT_READ);
+	close(fds[2 * i]);
+	close(fds[2 * i + 1]);
+    }
+}
+
+static void
+usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [-n socket pairs] [-t timers] [-r rounds] "
+	    "[-a active sockets per round]\n", progname);
+    exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int npairs = 500;
+    int ntimers = 200;
+    int rounds = 20000;
+    int active = 4;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "n:t:r:a:")) != -1) {
+	switch (ch) {
+	case 'n':
+	    npairs = atoi(optarg);
+	    break;
+	case 't':
+	    ntimers = atoi(optarg);
+	    break;
+	case 'r':
+	    rounds = atoi(optarg);
+	    break;
+	case 'a':
+	    active = atoi(optarg);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (npairs <= 0 || ntimers < 0 || rounds <= 0 || active <= 0)
+	usage(argv[0]);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    // select() cannot watch descriptors from FD_SETSIZE upwards
+    if (2 * npairs + 16 < FD_SETSIZE)
+	bench(SelectorList::BACKEND_SELECT, npairs, ntimers, rounds, active);
+    else
+	printf("select  skipped: %d fds is beyond FD_SETSIZE\n", 2 * npairs);
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0
+	&& rl.rlim_cur < (rlim_t)(2 * npairs + 16)) {
+	rl.rlim_cur = min(rl.rlim_max, (rlim_t)(2 * npairs + 16));
+	setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    if (SelectorList::default_backend() == SelectorList::BACKEND_EPOLL)
+	bench(SelectorList::BACKEND_EPOLL, npairs, ntimers, rounds, active);
+
+    xlog_stop();
+    xlog_exit();
+
+    return 0;
+}
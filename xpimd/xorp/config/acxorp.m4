@@ -1,6 +1,6 @@
-AC_CHECK_FUNCS([random])
+AC_CHECK_FUNCS([random recvmmsg])
 
-AC_CHECK_HEADERS([netinet/ip.h netinet/tcp.h])
+AC_CHECK_HEADERS([netinet/ip.h netinet/tcp.h sys/epoll.h])
 
 case "${host_os}" in
     bsdi* )
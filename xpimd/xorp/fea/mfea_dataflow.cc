@@ -50,10 +50,15 @@
 //
 // Local functions prototypes
 //
+static TimeVal align_time(const TimeVal& t, const TimeVal& interval);
 
 
 MfeaDft::MfeaDft(MfeaNode& mfea_node)
-    : _mfea_node(mfea_node)
+    : _mfea_node(mfea_node),
+      _sg_count_table(mfea_node.family()),
+      _sg_count_table_min_entries(MFEA_DATAFLOW_BULK_MIN_ENTRIES),
+      _sg_count_table_time(TimeVal::ZERO()),
+      _is_sg_count_table_valid(false)
 {
     
 }
@@ -220,6 +225,29 @@ MfeaDft::delete_entry(MfeaDfe *mfea_dfe)
     return (XORP_OK);
 }
 
+int
+MfeaDft::get_sg_count(const IPvX& source, const IPvX& group,
+		      const TimeVal& measurement_time, SgCount& sg_count)
+{
+    if (size() >= _sg_count_table_min_entries) {
+	if ((measurement_time != _sg_count_table_time)
+	    || (_sg_count_table_time == TimeVal::ZERO())) {
+	    // The first entry measured at this time: read the whole table
+	    _sg_count_table_time = measurement_time;
+	    _is_sg_count_table_valid =
+		(mfea_node().get_sg_count_table(_sg_count_table) == XORP_OK);
+	}
+	if (_is_sg_count_table_valid
+	    && (_sg_count_table.get_sg_count(source, group, sg_count)
+		== XORP_OK)) {
+	    return (XORP_OK);
+	}
+    }
+    
+    // Fallback to reading the counters of this entry alone
+    return (mfea_node().get_sg_count(source, group, sg_count));
+}
+
 MfeaDfeLookup::MfeaDfeLookup(MfeaDft& mfea_dft,
 			     const IPvX& source, const IPvX& group)
     : Mre<MfeaDfeLookup>(source, group),
@@ -303,6 +331,8 @@ MfeaDfe::MfeaDfe(MfeaDfeLookup& mfea_dfe_lookup,
     _delta_sg_count_index = 0;
     _is_bootstrap_completed = false;
     _measurement_interval = _threshold_interval / MFEA_DATAFLOW_TEST_FREQUENCY;
+    _measurement_time = TimeVal::ZERO();
+    _is_measurement_aligned = false;
     for (size_t i = 0; i < sizeof(_start_time)/sizeof(_start_time[0]); i++)
 	_start_time[i] = TimeVal::ZERO();
 }
@@ -371,8 +401,13 @@ MfeaDfe::is_same(const TimeVal& threshold_interval_test,
 void
 MfeaDfe::init_sg_count()
 {
-    mfea_dft().mfea_node().get_sg_count(source_addr(), group_addr(),
-					_last_sg_count);
+    TimeVal now;
+    
+    // XXX: share the reading with the entries measured most recently
+    eventloop().current_time(now);
+    _measurement_time = align_time(now, _measurement_interval);
+    mfea_dft().get_sg_count(source_addr(), group_addr(), _measurement_time,
+			    _last_sg_count);
 }
 
 //
@@ -390,8 +425,8 @@ MfeaDfe::test_sg_count()
     //
     // Perform the measurement
     //
-    if (mfea_dft().mfea_node().get_sg_count(source_addr(), group_addr(),
-					    _last_sg_count)
+    if (mfea_dft().get_sg_count(source_addr(), group_addr(),
+				_measurement_time, _last_sg_count)
 	< 0) {
 	// Error
 	return (false);		// TODO: what do we do when error occured?
@@ -489,14 +524,19 @@ MfeaDfe::test_sg_count()
 void
 MfeaDfe::start_measurement()
 {
-    _measurement_timer =
-	eventloop().new_oneoff_after(_measurement_interval,
-				     callback(this,
-					      &MfeaDfe::measurement_timer_timeout));
-    
-    TimeVal now;
+    TimeVal now, next;
     
     mfea_dft().mfea_node().eventloop().current_time(now);
+    next = align_time(now, _measurement_interval) + _measurement_interval;
+    if (next <= _measurement_time)
+	next = _measurement_time + _measurement_interval;
+    _measurement_time = next;
+    
+    _measurement_timer =
+	eventloop().new_oneoff_at(_measurement_time,
+				  callback(this,
+					   &MfeaDfe::measurement_timer_timeout));
+    
     _start_time[_delta_sg_count_index] = now;
 }
 
@@ -572,6 +612,19 @@ MfeaDfe::measured_bytes() const
 void
 MfeaDfe::measurement_timer_timeout()
 {
+    if (! _is_measurement_aligned) {
+	//
+	// XXX: the first measurement after the entry was added covers
+	// only part of the measurement interval, hence just use it as
+	// the starting point for the measurements that follow.
+	//
+	_is_measurement_aligned = true;
+	mfea_dft().get_sg_count(source_addr(), group_addr(),
+				_measurement_time, _last_sg_count);
+	start_measurement();
+	return;
+    }
+    
     if (test_sg_count()) {
 	// Time to deliver a signal
 	dataflow_signal_send();
@@ -580,3 +633,22 @@ MfeaDfe::measurement_timer_timeout()
     // Restart the measurements
     start_measurement();
 }
+
+//
+// Round down a time to a multiple of an interval.
+//
+static TimeVal
+align_time(const TimeVal& t, const TimeVal& interval)
+{
+    int64_t t_usec, interval_usec;
+    
+    t_usec = (int64_t)t.sec() * TimeVal::ONE_MILLION + t.usec();
+    interval_usec = (int64_t)interval.sec() * TimeVal::ONE_MILLION
+	+ interval.usec();
+    if (interval_usec <= 0)
+	return (t);
+    t_usec -= t_usec % interval_usec;
+    
+    return (TimeVal(t_usec / TimeVal::ONE_MILLION,
+		    t_usec % TimeVal::ONE_MILLION));
+}
@@ -36,6 +36,12 @@
 // Constants definitions
 //
 
+//
+// The minimum number of (S,G) entries in the dataflow table to read
+// the counters of all kernel MFC entries at once instead of one by one.
+//
+#define MFEA_DATAFLOW_BULK_MIN_ENTRIES	16
+
 
 //
 // Structures/classes, typedefs and macros
@@ -153,6 +159,34 @@ public:
      */
     int		delete_entry(const IPvX& source, const IPvX& group);
     
+    /**
+     * Get the counters of an (S,G) entry as of a measurement time.
+     * 
+     * All dataflow entries measured at the same time share a single
+     * read of the kernel MFC table when the table is large enough.
+     * Otherwise, or if the (S,G) entry is not found in the kernel MFC table,
+     * the counters of that entry alone are read from the kernel.
+     * 
+     * @param source the source address.
+     * @param group the group address.
+     * @param measurement_time the time of the measurement.
+     * @param sg_count a reference to a @ref SgCount class to place the result.
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int		get_sg_count(const IPvX& source, const IPvX& group,
+			     const TimeVal& measurement_time,
+			     SgCount& sg_count);
+    
+    /**
+     * Set the minimum number of (S,G) entries in the dataflow table to
+     * read the counters of all kernel MFC entries at once.
+     * 
+     * @param v the minimum number of (S,G) entries.
+     */
+    void	set_sg_count_table_min_entries(size_t v) {
+	_sg_count_table_min_entries = v;
+    }
+    
 private:
     /**
      * Delete a given @ref MfeaDfe dataflow entry.
@@ -163,6 +197,10 @@ private:
     int		delete_entry(MfeaDfe *mfea_dfe);
     
     MfeaNode&	_mfea_node;	// The Mfea node
+    SgCountTable _sg_count_table;	// The counters of all kernel entries
+    size_t	_sg_count_table_min_entries; // Min. entries to use the table
+    TimeVal	_sg_count_table_time;	// The measurement time of the table
+    bool	_is_sg_count_table_valid; // True if the table read succeeded
 };
 
 /**
@@ -421,6 +459,10 @@ public:
     
     /**
      * Start bandwidth measurement.
+     * 
+     * The measurements are aligned to multiples of the measurement
+     * interval, so all entries with the same threshold interval are
+     * measured at the same time.
      */
     void start_measurement();
     
@@ -527,6 +569,9 @@ private:
     bool	_is_bootstrap_completed;
     
     TimeVal	_measurement_interval;	// Interval between two measurements
+    TimeVal	_measurement_time;	// Time of the next measurement
+    bool	_is_measurement_aligned; // True after the first aligned
+					 // measurement
     XorpTimer	_measurement_timer;	// Timer to perform measurements
     
     // Time when current measurement window has started
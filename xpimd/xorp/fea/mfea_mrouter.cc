@@ -26,6 +26,9 @@
 #include "libxorp/ipvx.hh"
 #include "libxorp/utils.hh"
 
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
 #ifdef HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif
@@ -41,6 +44,9 @@
 #ifdef HAVE_NETINET_IN_SYSTM_H
 #include <netinet/in_systm.h>
 #endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
 #ifdef HAVE_NETINET_IP_H
 #include <netinet/ip.h>
 #endif
@@ -163,6 +169,26 @@ MfeaMrouter::MfeaMrouter(MfeaNode& mfea_node)
     _mrt_api_mrt_mfc_flags_border_vif = false;
     _mrt_api_mrt_mfc_rp = false;
     _mrt_api_mrt_mfc_bw_upcall = false;
+
+    _upcall_budget = MFEA_UPCALL_BUDGET_DEFAULT;
+    _upcalls_received = 0;
+    _upcalls_coalesced = 0;
+    _upcalls_dropped = 0;
+
+#ifdef HOST_OS_LINUX
+    switch (family()) {
+    case AF_INET:
+	_sg_count_table_file = "/proc/net/ip_mr_cache";
+	break;
+#ifdef HAVE_IPV6
+    case AF_INET6:
+	_sg_count_table_file = "/proc/net/ip6_mr_cache";
+	break;
+#endif // HAVE_IPV6
+    default:
+	break;
+    }
+#endif // HOST_OS_LINUX
 }
 
 MfeaMrouter::~MfeaMrouter()
@@ -395,8 +421,10 @@ MfeaMrouter::open_mrouter_socket()
 	if (proto_comm == NULL)
 	    break;
 	_mrouter_socket = proto_comm->proto_socket_in();
-	if (_mrouter_socket.is_valid())
+	if (_mrouter_socket.is_valid()) {
+	    enable_upcalls_dropped();
 	    return (_mrouter_socket);
+	}
 	break;
     } while (false);
     
@@ -485,6 +513,8 @@ MfeaMrouter::adopt_mrouter_socket()
 	return (badfd);
     }
     
+    enable_upcalls_dropped();
+    
     // Assign a method to read from this socket
     if (mfea_node().eventloop().add_ioevent_cb(_mrouter_socket, IOT_READ,
 				callback(this,
@@ -1968,6 +1998,60 @@ MfeaMrouter::get_sg_count(const IPvX& source, const IPvX& group,
 }
 
 
+/**
+ * MfeaMrouter::get_sg_count_table:
+ * @sg_count_table: A reference to a #SgCountTable class to place the result.
+ * 
+ * Get the number of packets and bytes forwarded by all Multicast
+ * Forwarding Cache (MFC) entries in the kernel, and the number of packets
+ * arrived on wrong interface for each entry.
+ * The whole kernel MFC table is read in a single pass, so this is cheaper
+ * than calling get_sg_count() for each entry when there are many of them.
+ * 
+ * Return value: %XORP_OK on success, otherwise %XORP_ERROR.
+ **/
+int
+MfeaMrouter::get_sg_count_table(SgCountTable& sg_count_table)
+{
+    char buf[4096];
+    ssize_t nread;
+    int fd;
+
+    sg_count_table.clear();
+    if (_sg_count_table_file.empty())
+	return (XORP_ERROR);
+
+    fd = open(_sg_count_table_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+	XLOG_ERROR("Cannot open %s: %s",
+		   _sg_count_table_file.c_str(), strerror(errno));
+	_sg_count_table_file.clear();	// XXX: don't try again
+	return (XORP_ERROR);
+    }
+
+    // XXX: the buffer is kept between calls to avoid reallocating it
+    _sg_count_table_buf.clear();
+    while ((nread = read(fd, buf, sizeof(buf))) != 0) {
+	if (nread < 0) {
+	    if (errno == EINTR)
+		continue;
+	    XLOG_ERROR("Cannot read %s: %s",
+		       _sg_count_table_file.c_str(), strerror(errno));
+	    close(fd);
+	    return (XORP_ERROR);
+	}
+	_sg_count_table_buf.append(buf, nread);
+    }
+    close(fd);
+
+    if (sg_count_table.parse_linux_mfc(_sg_count_table_buf) != XORP_OK) {
+	XLOG_ERROR("Cannot parse %s", _sg_count_table_file.c_str());
+	return (XORP_ERROR);
+    }
+
+    return (XORP_OK);
+}
+
 /**
  * MfeaMrouter::get_vif_count:
  * @vif_index: The vif index of the virtual multicast interface whose
@@ -2059,6 +2143,32 @@ MfeaMrouter::get_vif_count(uint32_t vif_index, VifCount& vif_count)
     return (XORP_OK);
 }
 
+/**
+ * MfeaMrouter::set_upcall_budget:
+ * @budget: The maximum number of kernel upcalls read per wakeup.
+ * @error_msg: The error message (if error).
+ * 
+ * Set the maximum number of kernel upcalls read from the mrouter socket
+ * each time it becomes readable.
+ * 
+ * Return value: %XORP_OK on success, otherwise %XORP_ERROR.
+ **/
+int
+MfeaMrouter::set_upcall_budget(size_t budget, string& error_msg)
+{
+    if ((budget < 1) || (budget > MFEA_UPCALL_BUDGET_MAX)) {
+	error_msg = c_format("invalid upcall budget %u: must be between "
+			     "1 and %u",
+			     XORP_UINT_CAST(budget),
+			     XORP_UINT_CAST(MFEA_UPCALL_BUDGET_MAX));
+	return (XORP_ERROR);
+    }
+
+    _upcall_budget = budget;
+
+    return (XORP_OK);
+}
+
 /**
  * MfeaMrouter::mrouter_socket_read:
  * @fd: file descriptor of arriving data.
@@ -2066,6 +2176,8 @@ MfeaMrouter::get_vif_count(uint32_t vif_index, VifCount& vif_count)
  * 
  * Read data from the mrouter socket, and then call the appropriate method
  * to process it.
+ * Up to _upcall_budget messages are read per call, so a burst of kernel
+ * upcalls doesn't overflow the socket receive queue.
  **/
 void
 MfeaMrouter::mrouter_socket_read(XorpFd fd, IoEventType type)
@@ -2076,77 +2188,190 @@ MfeaMrouter::mrouter_socket_read(XorpFd fd, IoEventType type)
     UNUSED(type);
  
 #ifndef HOST_OS_WINDOWS
-    // Zero and reset various fields
-    _rcvmh.msg_controllen = CMSG_BUF_SIZE;
+#ifdef HAVE_RECVMMSG
+    if (_upcall_budget > 1) {
+	mrouter_socket_read_burst();
+	return;
+    }
+#endif
 
-    // TODO: when resetting _from4 and _from6 do we need to set the address
-    // family and the sockaddr len?
-    switch (family()) {
-    case AF_INET:
-	memset(&_from4, 0, sizeof(_from4));
-	_rcvmh.msg_namelen = sizeof(_from4);
-	break;
+    start_upcall_burst();
+    for (size_t i = 0; i < _upcall_budget; i++) {
+	// Zero and reset various fields
+	_rcvmh.msg_controllen = CMSG_BUF_SIZE;
+
+	// TODO: when resetting _from4 and _from6 do we need to set the address
+	// family and the sockaddr len?
+	switch (family()) {
+	case AF_INET:
+	    memset(&_from4, 0, sizeof(_from4));
+	    _rcvmh.msg_namelen = sizeof(_from4);
+	    break;
 
 #ifdef HAVE_IPV6
-    case AF_INET6:
-    {
+	case AF_INET6:
+	{
 #ifndef HAVE_IPV6_MULTICAST_ROUTING
-	XLOG_FATAL("mrouter_socket_read() failed: "
-		   "IPv6 multicast routing not supported");
-	return;
+	    XLOG_FATAL("mrouter_socket_read() failed: "
+		       "IPv6 multicast routing not supported");
+	    return;
 #else
-	memset(&_from6, 0, sizeof(_from6));
-	_rcvmh.msg_namelen = sizeof(_from6);
+	    memset(&_from6, 0, sizeof(_from6));
+	    _rcvmh.msg_namelen = sizeof(_from6);
 #endif // HAVE_IPV6_MULTICAST_ROUTING
-    }
-    break;
+	}
+	break;
 #endif // HAVE_IPV6
 
-    default:
-	XLOG_UNREACHABLE();
-	return;			// Error
+	default:
+	    XLOG_UNREACHABLE();
+	    return;			// Error
+	}
+
+	// Read from the socket
+	nbytes = recvmsg(_mrouter_socket, &_rcvmh, (i == 0)? 0 : MSG_DONTWAIT);
+	if (nbytes < 0) {
+	    if ((errno == EINTR) || (errno == EAGAIN)
+		|| (errno == EWOULDBLOCK)) {
+		return;		// OK: restart receiving
+	    }
+	    XLOG_ERROR("recvmsg() on socket %p failed: %s",
+		       _mrouter_socket.str().c_str(), strerror(errno));
+	    return;			// Error
+	}
+
+	update_upcalls_dropped(_rcvmh);
+	if (is_kernel_call(_rcvbuf0, nbytes, _rcvmh.msg_controllen))
+	    kernel_upcall_process(_rcvbuf0, nbytes);
+    }
+
+#else // HOST_OS_WINDOWS
+    UNUSED(nbytes);
+    XLOG_FATAL("Multicast routing is not supported on Windows");
+#endif
+}
+
+#ifdef HAVE_RECVMMSG
+/**
+ * MfeaMrouter::mrouter_socket_read_burst:
+ * 
+ * Read up to _upcall_budget messages from the mrouter socket with a single
+ * system call, and then process the kernel upcalls among them.
+ **/
+void
+MfeaMrouter::mrouter_socket_read_burst()
+{
+    int n;
+
+    // Allocate the receive buffers
+    if (_upcall_slots.size() != _upcall_budget) {
+	_upcall_buf.resize(_upcall_budget * MFEA_UPCALL_BUF_SIZE);
+	_upcall_cmsgbuf.resize(_upcall_budget * MFEA_UPCALL_CMSG_BUF_SIZE);
+	_upcall_slots.resize(_upcall_budget);
+	_upcall_mmsgs.resize(_upcall_budget);
+	for (size_t i = 0; i < _upcall_slots.size(); i++) {
+	    UpcallSlot& slot = _upcall_slots[i];
+	    struct msghdr& mh = _upcall_mmsgs[i].msg_hdr;
+	    
+	    slot.iov.iov_base = (caddr_t)&_upcall_buf[i * MFEA_UPCALL_BUF_SIZE];
+	    slot.iov.iov_len = MFEA_UPCALL_BUF_SIZE;
+	    memset(&mh, 0, sizeof(mh));
+	    mh.msg_name = (caddr_t)&slot.from;
+	    mh.msg_iov = &slot.iov;
+	    mh.msg_iovlen = 1;
+	    mh.msg_control =
+		(caddr_t)&_upcall_cmsgbuf[i * MFEA_UPCALL_CMSG_BUF_SIZE];
+	}
+    }
+
+    // Zero and reset various fields
+    for (size_t i = 0; i < _upcall_mmsgs.size(); i++) {
+	struct msghdr& mh = _upcall_mmsgs[i].msg_hdr;
+	
+	mh.msg_namelen = sizeof(struct sockaddr_storage);
+	mh.msg_controllen = MFEA_UPCALL_CMSG_BUF_SIZE;
+	mh.msg_flags = 0;
+	_upcall_mmsgs[i].msg_len = 0;
     }
 
     // Read from the socket
-    nbytes = recvmsg(_mrouter_socket, &_rcvmh, 0);
-    if (nbytes < 0) {
-	if (errno == EINTR)
+    n = recvmmsg(_mrouter_socket, &_upcall_mmsgs[0], _upcall_mmsgs.size(),
+		 MSG_DONTWAIT, NULL);
+    if (n < 0) {
+	if ((errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK))
 	    return;		// OK: restart receiving
-	XLOG_ERROR("recvmsg() on socket %p failed: %s",
+	XLOG_ERROR("recvmmsg() on socket %p failed: %s",
 		   _mrouter_socket.str().c_str(), strerror(errno));
 	return;			// Error
     }
 
-#else // HOST_OS_WINDOWS
-    UNUSED(nbytes);
-    XLOG_FATAL("Multicast routing is not supported on Windows");
-#endif
-    
+    //
+    // Process the upcalls in the order they were received
+    //
+    start_upcall_burst();
+    for (int i = 0; i < n; i++) {
+	const struct msghdr& mh = _upcall_mmsgs[i].msg_hdr;
+	uint8_t *databuf = &_upcall_buf[i * MFEA_UPCALL_BUF_SIZE];
+	ssize_t nbytes = _upcall_mmsgs[i].msg_len;
+
+	update_upcalls_dropped(mh);
+	if (! is_kernel_call(databuf, nbytes, mh.msg_controllen))
+	    continue;
+	if (mh.msg_flags & MSG_TRUNC) {
+	    // XXX: only a "wholepkt" upcall can be that large
+	    XLOG_WARNING("Kernel upcall truncated to %u bytes: ignored "
+			 "(set the upcall budget to 1 to read it whole)",
+			 XORP_UINT_CAST(MFEA_UPCALL_BUF_SIZE));
+	    continue;
+	}
+	kernel_upcall_process(databuf, nbytes);
+    }
+}
+#endif // HAVE_RECVMMSG
+
+/**
+ * MfeaMrouter::is_kernel_call:
+ * @databuf: The data buffer with the message.
+ * @datalen: The length of the message.
+ * @controllen: The length of the control data received with the message.
+ * 
+ * Test if a message read from the mrouter socket is a kernel upcall
+ * (e.g., "nocache", "wrongiif", "wholepkt").
+ * 
+ * Return value: true if the message is a kernel upcall, otherwise false.
+ **/
+bool
+MfeaMrouter::is_kernel_call(const uint8_t *databuf, ssize_t datalen,
+			    size_t controllen) const
+{
+    UNUSED(controllen);
+
     // Check if it is a signal from the kernel to the user-level
     switch (family()) {
     case AF_INET:
     {
 #ifndef HAVE_IPV4_MULTICAST_ROUTING
+	UNUSED(databuf);
+	UNUSED(datalen);
 	XLOG_FATAL("mrouter_socket_read() failed: "
 		   "IPv4 multicast routing not supported");
-	return;
+	return (false);
 #else
-	if (nbytes < (ssize_t)sizeof(struct igmpmsg)) {
+	if (datalen < (ssize_t)sizeof(struct igmpmsg)) {
 	    XLOG_WARNING("mrouter_socket_read() failed: "
 			 "kernel signal packet size %d is smaller than minimum size %u",
-			 XORP_INT_CAST(nbytes),
+			 XORP_INT_CAST(datalen),
 			 XORP_UINT_CAST(sizeof(struct igmpmsg)));
-	    return;		// Error
+	    return (false);	// Error
 	}
 	struct igmpmsg igmpmsg;
-	memcpy(&igmpmsg, _rcvbuf0, sizeof(igmpmsg));
+	memcpy(&igmpmsg, databuf, sizeof(igmpmsg));
 	if (igmpmsg.im_mbz == 0) {
 	    //
 	    // XXX: Packets sent up from kernel to daemon have
 	    //      igmpmsg.im_mbz = ip->ip_p = 0
 	    //
-	    kernel_call_process(_rcvbuf0, nbytes);
-	    return;		// OK
+	    return (true);
 	}
 #endif // HAVE_IPV4_MULTICAST_ROUTING
     }
@@ -2158,20 +2383,20 @@ MfeaMrouter::mrouter_socket_read(XorpFd fd, IoEventType type)
 #ifndef HAVE_IPV6_MULTICAST_ROUTING
 	XLOG_FATAL("mrouter_socket_read() failed: "
 		   "IPv6 multicast routing not supported");
-	return;
+	return (false);
 #else
-	if ((nbytes < (ssize_t)sizeof(struct mrt6msg))
-	    && (nbytes < (ssize_t)MLD_MINLEN)) {
+	if ((datalen < (ssize_t)sizeof(struct mrt6msg))
+	    && (datalen < (ssize_t)MLD_MINLEN)) {
 	    XLOG_WARNING("mrouter_socket_read() failed: "
 			 "kernel signal packet size %d is smaller than minimum size %u",
-			 XORP_INT_CAST(nbytes),
+			 XORP_INT_CAST(datalen),
 			 XORP_UINT_CAST(min(sizeof(struct mrt6msg),
 					    (size_t)MLD_MINLEN)));
-	    return;		// Error
+	    return (false);	// Error
 	}
 	struct mrt6msg mrt6msg;
-	memcpy(&mrt6msg, _rcvbuf0, sizeof(mrt6msg));
-	if ((mrt6msg.im6_mbz == 0) || (_rcvmh.msg_controllen == 0)) {
+	memcpy(&mrt6msg, databuf, sizeof(mrt6msg));
+	if ((mrt6msg.im6_mbz == 0) || (controllen == 0)) {
 	    //
 	    // XXX: Packets sent up from kernel to daemon have
 	    //      mrt6msg.im6_mbz = icmp6_hdr->icmp6_type = 0
@@ -2185,8 +2410,7 @@ MfeaMrouter::mrouter_socket_read(XorpFd fd, IoEventType type)
 	    // April 2000, FreeBSD-4.0) which don't have the
 	    //     'icmp6_type = 0' mechanism.
 	    //
-	    kernel_call_process(_rcvbuf0, nbytes);
-	    return;		// OK
+	    return (true);
 	}
 #endif // HAVE_IPV6_MULTICAST_ROUTING
     }
@@ -2202,7 +2426,145 @@ MfeaMrouter::mrouter_socket_read(XorpFd fd, IoEventType type)
     // Not a kernel signal. Ignore it.
     //
     
-    return;			// OK
+    return (false);
+}
+
+/**
+ * MfeaMrouter::enable_upcalls_dropped:
+ * 
+ * Ask the kernel to report the number of messages dropped because the
+ * mrouter socket receive queue was full (if SO_RXQ_OVFL is supported).
+ **/
+void
+MfeaMrouter::enable_upcalls_dropped()
+{
+#if defined(SO_RXQ_OVFL) && !defined(HOST_OS_WINDOWS)
+    int on = 1;
+
+    if (setsockopt(_mrouter_socket, SOL_SOCKET, SO_RXQ_OVFL,
+		   (void *)&on, sizeof(on)) < 0) {
+	XLOG_WARNING("setsockopt(SO_RXQ_OVFL) failed: %s", strerror(errno));
+    }
+#endif
+}
+
+/**
+ * MfeaMrouter::update_upcalls_dropped:
+ * @mh: The msghdr structure a message was received with.
+ * 
+ * Update the number of messages dropped by the kernel because the mrouter
+ * socket receive queue was full.  The kernel reports the total number
+ * with each message received after a drop (if SO_RXQ_OVFL is enabled).
+ **/
+void
+MfeaMrouter::update_upcalls_dropped(const struct msghdr& mh)
+{
+#if defined(SO_RXQ_OVFL) && !defined(HOST_OS_WINDOWS)
+    struct msghdr& m = const_cast<struct msghdr&>(mh);
+    struct cmsghdr *cmsgp;
+
+    if (mh.msg_controllen < sizeof(struct cmsghdr))
+	return;
+
+    for (cmsgp = CMSG_FIRSTHDR(&m); cmsgp != NULL;
+	 cmsgp = CMSG_NXTHDR(&m, cmsgp)) {
+	if ((cmsgp->cmsg_level == SOL_SOCKET)
+	    && (cmsgp->cmsg_type == SO_RXQ_OVFL)
+	    && (cmsgp->cmsg_len >= CMSG_LEN(sizeof(uint32_t)))) {
+	    uint32_t dropped;
+	    memcpy(&dropped, CMSG_DATA(cmsgp), sizeof(dropped));
+	    _upcalls_dropped = dropped;
+	}
+    }
+#else
+    UNUSED(mh);
+#endif
+}
+
+/**
+ * MfeaMrouter::start_upcall_burst:
+ * 
+ * Start a new burst of kernel upcalls.  Duplicate upcalls are coalesced
+ * only within the same burst.
+ **/
+void
+MfeaMrouter::start_upcall_burst()
+{
+    _upcall_keys.clear();
+}
+
+/**
+ * MfeaMrouter::kernel_upcall_process:
+ * @databuf: The data buffer.
+ * @datalen: The length of the data in 'databuf'.
+ * 
+ * Process a kernel upcall read as part of the current burst.
+ * A "nocache" or "wrongvif" upcall that is same as an earlier upcall in the
+ * burst (the same message type, vif, source and destination address) is
+ * ignored: its processing would only repeat the earlier one.
+ * The "wholepkt" upcalls carry a data packet, hence are always processed.
+ * 
+ * Return value: %XORP_OK on success, otherwise %XORP_ERROR.
+ **/
+int
+MfeaMrouter::kernel_upcall_process(uint8_t *databuf, size_t datalen)
+{
+    int message_type = -1;
+    uint32_t vif_index = 0;
+    IPvX src(family()), dst(family());
+    bool is_coalescable = false;
+
+    _upcalls_received++;
+
+    switch (family()) {
+    case AF_INET:
+    {
+#ifdef HAVE_IPV4_MULTICAST_ROUTING
+	struct igmpmsg igmpmsg;
+	if (datalen < sizeof(igmpmsg))
+	    break;
+	memcpy(&igmpmsg, databuf, sizeof(igmpmsg));
+	message_type = igmpmsg.im_msgtype;
+	vif_index = igmpmsg.im_vif;
+	src.copy_in(igmpmsg.im_src);
+	dst.copy_in(igmpmsg.im_dst);
+	is_coalescable = ((message_type == IGMPMSG_NOCACHE)
+			  || (message_type == IGMPMSG_WRONGVIF));
+#endif
+	break;
+    }
+#ifdef HAVE_IPV6
+    case AF_INET6:
+    {
+#ifdef HAVE_IPV6_MULTICAST_ROUTING
+	struct mrt6msg mrt6msg;
+	if (datalen < sizeof(mrt6msg))
+	    break;
+	memcpy(&mrt6msg, databuf, sizeof(mrt6msg));
+	message_type = mrt6msg.im6_msgtype;
+	vif_index = mrt6msg.im6_mif;
+	src.copy_in(mrt6msg.im6_src);
+	dst.copy_in(mrt6msg.im6_dst);
+	is_coalescable = ((message_type == MRT6MSG_NOCACHE)
+			  || (message_type == MRT6MSG_WRONGMIF));
+#endif
+	break;
+    }
+#endif // HAVE_IPV6
+    default:
+	XLOG_UNREACHABLE();
+	return (XORP_ERROR);
+    }
+
+    if (is_coalescable) {
+	UpcallKey key(message_type, vif_index, src, dst);
+	if (! _upcall_keys.insert(make_pair(key, true)).second) {
+	    _upcalls_coalesced++;
+	    return (XORP_OK);
+	}
+    }
+
+    return (kernel_call_process(databuf, datalen));
 }
 
 /**
@@ -2418,3 +2780,126 @@ MfeaMrouter::kernel_call_process(uint8_t *databuf, size_t datalen)
     
     return (XORP_OK);
 }
+
+/**
+ * SgCountTable::parse_linux_mfc:
+ * @text: The text of the kernel MFC table.
+ * 
+ * Parse the text of a Linux kernel MFC table as found in
+ * /proc/net/ip_mr_cache (IPv4) or /proc/net/ip6_mr_cache (IPv6).
+ * Each line after the header contains the group and source address,
+ * the incoming interface, and the packet, byte and wrong-interface counters,
+ * followed by the outgoing interfaces.
+ * 
+ * Return value: %XORP_OK on success, otherwise %XORP_ERROR.
+ **/
+int
+SgCountTable::parse_linux_mfc(const string& text)
+{
+    const char *p = text.c_str();
+    const char *end = p + text.size();
+    char line[1024];
+    IPvX group_addr(_family), source_addr(_family);
+
+    _entries.clear();
+    while (p < end) {
+	const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+	if (eol == NULL)
+	    eol = end;
+	// XXX: only the leading fields are of interest
+	size_t len = min(static_cast<size_t>(eol - p), sizeof(line) - 1);
+	memcpy(line, p, len);
+	line[len] = '\0';
+	p = eol + 1;
+
+	if ((len == 0) || (strncmp(line, "Group", 5) == 0))
+	    continue;		// The header or an empty line
+
+	unsigned long pktcnt, bytecnt, wrong_if;
+	int iif;
+
+	switch (_family) {
+	case AF_INET:
+	{
+	    unsigned long group, source;
+	    struct in_addr in;
+
+	    if (sscanf(line, "%lx %lx %d %lu %lu %lu", &group, &source, &iif,
+		       &pktcnt, &bytecnt, &wrong_if) != 6) {
+		return (XORP_ERROR);
+	    }
+	    // XXX: the addresses are printed as integers in host order
+	    in.s_addr = group;
+	    group_addr = IPvX(in);
+	    in.s_addr = source;
+	    source_addr = IPvX(in);
+	    break;
+	}
+
+#ifdef HAVE_IPV6
+	case AF_INET6:
+	{
+	    char group[INET6_ADDRSTRLEN], source[INET6_ADDRSTRLEN];
+	    struct in6_addr in6;
+
+	    if (sscanf(line, "%45s %45s %d %lu %lu %lu", group, source, &iif,
+		       &pktcnt, &bytecnt, &wrong_if) != 6) {
+		return (XORP_ERROR);
+	    }
+	    if (inet_pton(AF_INET6, group, &in6) != 1)
+		return (XORP_ERROR);
+	    group_addr = IPvX(in6);
+	    if (inet_pton(AF_INET6, source, &in6) != 1)
+		return (XORP_ERROR);
+	    source_addr = IPvX(in6);
+	    break;
+	}
+#endif // HAVE_IPV6
+
+	default:
+	    XLOG_UNREACHABLE();
+	    return (XORP_ERROR);
+	}
+
+	if (iif < 0)
+	    continue;		// XXX: an unresolved entry has no counters
+
+	_entries.push_back(Entry(source_addr, group_addr));
+	_entries.back().sg_count.set_pktcnt(pktcnt);
+	_entries.back().sg_count.set_bytecnt(bytecnt);
+	_entries.back().sg_count.set_wrong_if(wrong_if);
+    }
+
+    sort(_entries.begin(), _entries.end());
+
+    return (XORP_OK);
+}
+
+/**
+ * SgCountTable::get_sg_count:
+ * @source: The MFC source address.
+ * @group: The MFC group address.
+ * @sg_count: A reference to a #SgCount class to place the result.
+ * 
+ * Get the counters of an (S,G) entry from the table.
+ * 
+ * Return value: %XORP_OK on success, otherwise %XORP_ERROR.
+ **/
+int
+SgCountTable::get_sg_count(const IPvX& source, const IPvX& group,
+			   SgCount& sg_count) const
+{
+    Entry key(source, group);
+    vector<Entry>::const_iterator iter;
+
+    iter = lower_bound(_entries.begin(), _entries.end(), key);
+    if ((iter == _entries.end())
+	|| (iter->source != source)
+	|| (iter->group != group)) {
+	return (XORP_ERROR);
+    }
+
+    sg_count = iter->sg_count;
+
+    return (XORP_OK);
+}
@@ -27,7 +27,11 @@
 #include <sys/uio.h>
 #endif
 
+#include <vector>
+
 #include "libxorp/eventloop.hh"
+#include "libxorp/hash_map.hh"
+#include "libxorp/ipvx.hh"
 #include "libproto/proto_register.hh"
 #include "libproto/proto_unit.hh"
 
@@ -36,14 +40,29 @@
 // Constants definitions
 //
 
+//
+// The default and the maximum number of kernel upcalls read from the
+// multicast routing socket per wakeup.
+//
+#define MFEA_UPCALL_BUDGET_DEFAULT	32
+#define MFEA_UPCALL_BUDGET_MAX		1024
+
+//
+// The receive buffer sizes of each upcall read in a burst.  The "nocache"
+// and "wrongvif" upcalls carry only the IP header, and a "wholepkt" upcall
+// carries a packet of up to an Ethernet MTU.
+//
+#define MFEA_UPCALL_BUF_SIZE		2048
+#define MFEA_UPCALL_CMSG_BUF_SIZE	256
+
 
 //
 // Structures/classes, typedefs and macros
 //
 
-class IPvX;
 class MfeaNode;
 class SgCount;
+class SgCountTable;
 class TimeVal;
 class VifCount;
 
@@ -308,6 +327,31 @@ public:
     int		get_sg_count(const IPvX& source, const IPvX& group,
 			     SgCount& sg_count);
     
+    /**
+     * Get various counters for all (S,G) entries.
+     * 
+     * Read the counters of all Multicast Forwarding Cache (MFC) entries
+     * in the kernel in a single pass.  This is available only on systems
+     * that export the MFC table (e.g., /proc/net/ip_mr_cache on Linux).
+     * 
+     * @param sg_count_table a reference to a @ref SgCountTable class
+     * to place the result.
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int		get_sg_count_table(SgCountTable& sg_count_table);
+    
+    /**
+     * Set the name of the file to read the kernel MFC table from.
+     * 
+     * By default the file is the system's MFC table for the address
+     * family; an empty name disables the reading of the table.
+     * 
+     * @param file_name the name of the file to read the MFC table from.
+     */
+    void	set_sg_count_table_file(const string& file_name) {
+	_sg_count_table_file = file_name;
+    }
+    
     /**
      * Get various counters per virtual interface.
      * 
@@ -382,6 +426,74 @@ public:
      */
     int		kernel_call_process(uint8_t *databuf, size_t datalen);
     
+    /**
+     * Get the maximum number of kernel upcalls read per wakeup.
+     * 
+     * @return the maximum number of kernel upcalls read per wakeup.
+     */
+    size_t	upcall_budget() const { return (_upcall_budget); }
+    
+    /**
+     * Set the maximum number of kernel upcalls read per wakeup.
+     * 
+     * @param budget the maximum number of kernel upcalls read per wakeup
+     * (between 1 and MFEA_UPCALL_BUDGET_MAX).
+     * @param error_msg the error message (if error).
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int		set_upcall_budget(size_t budget, string& error_msg);
+    
+    /**
+     * Get the number of kernel upcalls received.
+     * 
+     * @return the number of kernel upcalls received.
+     */
+    uint64_t	upcalls_received() const { return (_upcalls_received); }
+    
+    /**
+     * Get the number of kernel upcalls that were ignored because they
+     * duplicate an earlier upcall read in the same burst.
+     * 
+     * @return the number of coalesced kernel upcalls.
+     */
+    uint64_t	upcalls_coalesced() const { return (_upcalls_coalesced); }
+    
+    /**
+     * Get the number of messages the kernel dropped because the
+     * multicast routing socket receive queue was full.
+     * 
+     * @return the number of dropped messages, as last reported by
+     * the kernel.
+     */
+    uint64_t	upcalls_dropped() const { return (_upcalls_dropped); }
+    
+    /**
+     * Start a new burst of kernel upcalls.
+     * 
+     * Duplicate upcalls are coalesced only within the same burst.
+     */
+    void	start_upcall_burst();
+    
+    /**
+     * Process a kernel upcall read as part of the current burst.
+     * 
+     * A "nocache" or "wrongvif" upcall for the same (S,G) and vif as
+     * an earlier upcall in the burst is counted, but not processed again.
+     * 
+     * @param databuf the data buffer with the upcall.
+     * @param datalen the length of the data in @ref databuf.
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int		kernel_upcall_process(uint8_t *databuf, size_t datalen);
+    
+    /**
+     * Update the number of dropped messages from the control data
+     * received with a message from the multicast router socket.
+     * 
+     * @param mh the msghdr structure the message was received with.
+     */
+    void	update_upcalls_dropped(const struct msghdr& mh);
+    
 private:
     // Private functions
     MfeaNode&	mfea_node() const	{ return (_mfea_node);	}
@@ -396,6 +508,33 @@ private:
      */
     void	mrouter_socket_read(XorpFd fd, IoEventType m);
     
+    /**
+     * Test if a message read from the multicast router socket is a kernel
+     * upcall.
+     * 
+     * @param databuf the data buffer with the message.
+     * @param datalen the length of the message.
+     * @param controllen the length of the control data received with
+     * the message.
+     * @return true if the message is a kernel upcall, otherwise false.
+     */
+    bool	is_kernel_call(const uint8_t *databuf, ssize_t datalen,
+			       size_t controllen) const;
+    
+    /**
+     * Ask the kernel to report the number of messages dropped because
+     * the multicast router socket receive queue was full.
+     */
+    void	enable_upcalls_dropped();
+    
+#ifdef HAVE_RECVMMSG
+    /**
+     * Read a burst of kernel upcalls with a single system call,
+     * and process them.
+     */
+    void	mrouter_socket_read_burst();
+#endif
+    
     // Private state
     MfeaNode&	  _mfea_node;	// The MFEA node I belong to
     XorpFd	  _mrouter_socket; // The socket for multicast routing access
@@ -431,6 +570,47 @@ private:
     bool	_mrt_api_mrt_mfc_flags_border_vif;
     bool	_mrt_api_mrt_mfc_rp;
     bool	_mrt_api_mrt_mfc_bw_upcall;
+
+    //
+    // Kernel upcall processing
+    //
+    size_t	_upcall_budget;		// Max. upcalls read per wakeup
+    uint64_t	_upcalls_received;	// Upcalls received
+    uint64_t	_upcalls_coalesced;	// Duplicate upcalls ignored
+    uint64_t	_upcalls_dropped;	// Messages dropped by the kernel
+    struct UpcallKey {
+	int		message_type;
+	uint32_t	vif_index;
+	IPvX		src;
+	IPvX		dst;
+	
+	UpcallKey(int t, uint32_t v, const IPvX& s, const IPvX& d)
+	    : message_type(t), vif_index(v), src(s), dst(d) {}
+	uint32_t hash() const {
+	    return ((src.hash() * 31 + dst.hash()) ^ (vif_index << 8)
+		    ^ message_type);
+	}
+	bool operator==(const UpcallKey& other) const {
+	    return ((message_type == other.message_type)
+		    && (vif_index == other.vif_index)
+		    && (src == other.src)
+		    && (dst == other.dst));
+	}
+    };
+    HashMap<UpcallKey, bool> _upcall_keys; // The upcalls in the current burst
+#ifdef HAVE_RECVMMSG
+    struct UpcallSlot {
+	struct iovec		iov;		// The scatter/gatter array
+	struct sockaddr_storage	from;		// The source addr
+    };
+    vector<uint8_t>		_upcall_buf;	// The burst data buffers
+    vector<uint8_t>		_upcall_cmsgbuf; // The burst control buffers
+    vector<UpcallSlot>		_upcall_slots;	// The burst receive slots
+    vector<struct mmsghdr>	_upcall_mmsgs;	// The burst msghdr structures
+#endif // HAVE_RECVMMSG
+
+    string	_sg_count_table_file;	// The file with the kernel MFC table
+    string	_sg_count_table_buf;	// The buffer to read the table into
 };
 
 /**
@@ -548,6 +728,84 @@ private:
 				// on wrong iif
 };
 
+/**
+ * @short Class that contains the counters of all (S,G) entries.
+ * 
+ * The counters are a snapshot of the kernel Multicast Forwarding Cache
+ * (MFC) table, and can be looked-up per (S,G).
+ */
+class SgCountTable {
+public:
+    /**
+     * Constructor for a given address family.
+     * 
+     * @param family the address family (e.g., AF_INET or AF_INET6
+     * for IPv4 and IPv6 respectively).
+     */
+    SgCountTable(int family) : _family(family) {}
+    
+    /**
+     * Get the address family.
+     * 
+     * @return the address family.
+     */
+    int		family() const { return (_family); }
+    
+    /**
+     * Parse the text of a Linux kernel MFC table.
+     * 
+     * The text is in the format of /proc/net/ip_mr_cache (for IPv4) or
+     * /proc/net/ip6_mr_cache (for IPv6).  Any previous content of the
+     * table is discarded.  Unresolved entries are ignored.
+     * 
+     * @param text the text of the kernel MFC table.
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int		parse_linux_mfc(const string& text);
+    
+    /**
+     * Get the counters of an (S,G) entry.
+     * 
+     * @param source the MFC source address.
+     * @param group the MFC group address.
+     * @param sg_count a reference to a @ref SgCount class to place the result.
+     * @return XORP_OK on success, otherwise XORP_ERROR if the entry
+     * is not in the table.
+     */
+    int		get_sg_count(const IPvX& source, const IPvX& group,
+			     SgCount& sg_count) const;
+    
+    /**
+     * Get the number of (S,G) entries in the table.
+     * 
+     * @return the number of (S,G) entries in the table.
+     */
+    size_t	size() const { return (_entries.size()); }
+    
+    /**
+     * Remove all entries from the table.
+     */
+    void	clear() { _entries.clear(); }
+    
+private:
+    struct Entry {
+	IPvX	source;
+	IPvX	group;
+	SgCount	sg_count;
+	
+	Entry(const IPvX& s, const IPvX& g) : source(s), group(g) {}
+	
+	bool operator<(const Entry& other) const {
+	    if (group != other.group)
+		return (group < other.group);
+	    return (source < other.source);
+	}
+    };
+    
+    int			_family;	// The address family
+    vector<Entry>	_entries;	// The entries, sorted by (G,S)
+};
+
 //
 // A class that contains information about a vif in the kernel.
 //
@@ -2355,6 +2355,26 @@ MfeaNode::get_sg_count(const IPvX& source, const IPvX& group,
     return (XORP_OK);
 }
 
+/**
+ * MfeaNode::get_sg_count_table:
+ * @sg_count_table: A reference to a #SgCountTable class to place the result.
+ * 
+ * Get the number of packets and bytes forwarded by all Multicast Forwarding
+ * Cache (MFC) entries in the kernel, and the number of packets arrived on
+ * wrong interface for each entry.
+ * 
+ * Return value: %XORP_OK on success, otherwise %XORP_ERROR.
+ **/
+int
+MfeaNode::get_sg_count_table(SgCountTable& sg_count_table)
+{
+    if (_mfea_mrouter.get_sg_count_table(sg_count_table) < 0) {
+	return (XORP_ERROR);
+    }
+    
+    return (XORP_OK);
+}
+
 /**
  * MfeaNode::get_vif_count:
  * @vif_index: The vif index of the virtual multicast interface whose
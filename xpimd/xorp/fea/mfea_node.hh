@@ -54,6 +54,7 @@ class EventLoop;
 class MfeaVif;
 class ProtoComm;
 class SgCount;
+class SgCountTable;
 class VifCount;
 
 /**
@@ -1092,6 +1093,16 @@ public:
     int		get_sg_count(const IPvX& source, const IPvX& group,
 			     SgCount& sg_count);
     
+    /**
+     * Get multicast forwarding statistics for all (S,G) entries from
+     * the kernel in a single pass.
+     * 
+     * @param sg_count_table a reference to a @ref SgCountTable class to
+     * place the result.
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int		get_sg_count_table(SgCountTable& sg_count_table);
+    
     /**
      * Get interface multicast forwarding statistics from the kernel.
      * 
@@ -156,6 +156,10 @@ MfeaNodeCli::add_all_cli_commands()
 	add_cli_command("show mfea interface address",
 			"Display information about addresses of MFEA IPv4 interfaces",
 			callback(this, &MfeaNodeCli::cli_show_mfea_interface_address));
+
+	add_cli_command("show mfea upcalls",
+			"Display information about MFEA IPv4 kernel upcalls",
+			callback(this, &MfeaNodeCli::cli_show_mfea_upcalls));
     }
 
     if (mfea_node().is_ipv6()) {
@@ -173,6 +177,10 @@ MfeaNodeCli::add_all_cli_commands()
 	add_cli_command("show mfea6 interface address",
 			"Display information about addresses of MFEA IPv6 interfaces",
 			callback(this, &MfeaNodeCli::cli_show_mfea_interface_address));
+
+	add_cli_command("show mfea6 upcalls",
+			"Display information about MFEA IPv6 kernel upcalls",
+			callback(this, &MfeaNodeCli::cli_show_mfea_upcalls));
     }
 
     return (XORP_OK);
@@ -478,3 +486,31 @@ MfeaNodeCli::cli_show_mfea_interface_address(const vector<string>& argv)
     
     return (XORP_OK);
 }
+
+//
+// CLI COMMAND: "show mfea upcalls"
+// CLI COMMAND: "show mfea6 upcalls"
+//
+// Display information about the kernel upcalls the MFEA has received.
+//
+int
+MfeaNodeCli::cli_show_mfea_upcalls(const vector<string>& argv)
+{
+    const MfeaMrouter& mfea_mrouter = mfea_node().mfea_mrouter();
+    
+    if (argv.size()) {
+	cli_print(c_format("ERROR: Unexpected argument: %s\n",
+			   argv[0].c_str()));
+	return (XORP_ERROR);
+    }
+    
+    cli_print(c_format("%-12s %-12s %-12s %-6s\n",
+		       "Received", "Coalesced", "Dropped", "Budget"));
+    cli_print(c_format("%-12llu %-12llu %-12llu %-6u\n",
+		       (unsigned long long)mfea_mrouter.upcalls_received(),
+		       (unsigned long long)mfea_mrouter.upcalls_coalesced(),
+		       (unsigned long long)mfea_mrouter.upcalls_dropped(),
+		       XORP_UINT_CAST(mfea_mrouter.upcall_budget())));
+    
+    return (XORP_OK);
+}
@@ -104,6 +104,7 @@ private:
     int		cli_show_mfea_dataflow(const vector<string>& argv);
     int		cli_show_mfea_interface(const vector<string>& argv);
     int		cli_show_mfea_interface_address(const vector<string>& argv);
+    int		cli_show_mfea_upcalls(const vector<string>& argv);
 };
 
 //
@@ -1261,27 +1261,56 @@ ProtoComm::close_proto_sockets()
  * 
  * Read data from a protocol socket, and then call the appropriate protocol
  * module to process it.
+ * If the socket is also the mrouter socket, then up to the MFEA upcall
+ * budget of messages are read at once, so a burst of kernel upcalls
+ * doesn't overflow the socket receive queue.
  **/
 void
 ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 {
-    ssize_t	nbytes;
-    size_t	ip_hdr_len = 0;
-    size_t	ip_data_len = 0;
-    IPvX	src(family());
-    IPvX	dst(family());
-    int		int_val;
-    int		ip_ttl = -1;		// a.k.a. Hop-Limit in IPv6
-    int		ip_tos = -1;
-    bool	is_router_alert = false; // Router Alert option received
-    int		pif_index = 0;
-    MfeaVif	*mfea_vif = NULL;
-    void	*cmsg_data;	// XXX: CMSG_DATA() is aligned, hence void ptr
+    MfeaMrouter& mfea_mrouter = mfea_node().mfea_mrouter();
+    size_t budget = 1;
+    ssize_t nbytes;
 
     UNUSED(fd);
     UNUSED(type);
-    UNUSED(int_val);
-    UNUSED(cmsg_data);
+
+#ifndef HOST_OS_WINDOWS
+    if (_proto_socket_in == mfea_mrouter.mrouter_socket()) {
+	budget = mfea_mrouter.upcall_budget();
+	mfea_mrouter.start_upcall_burst();
+    }
+#endif
+
+    for (size_t i = 0; i < budget; i++) {
+	nbytes = proto_socket_recv((i == 0)? 0 : MSG_DONTWAIT);
+	if (nbytes < 0)
+	    return;
+#ifndef HOST_OS_WINDOWS
+	if (budget > 1)
+	    mfea_mrouter.update_upcalls_dropped(_rcvmh);
+#endif
+	proto_socket_process(nbytes);
+    }
+}
+
+/**
+ * ProtoComm::proto_socket_recv:
+ * @flags: The flags to pass to recvmsg().
+ * 
+ * Read a single message from a protocol socket into the receive buffer.
+ * 
+ * Return value: The length of the message, or -1 if there was no message
+ * to read or if error.
+ **/
+ssize_t
+ProtoComm::proto_socket_recv(int flags)
+{
+    ssize_t	nbytes;
+
+#ifdef HOST_OS_WINDOWS
+    UNUSED(flags);
+#endif
 
 #ifndef HOST_OS_WINDOWS
     // Zero and reset various fields
@@ -1302,16 +1331,16 @@ ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 #endif // HAVE_IPV6
     default:
 	XLOG_UNREACHABLE();
-	return;			// Error
+	return (-1);		// Error
     }
 
     // Read from the socket
-    nbytes = recvmsg(_proto_socket_in, &_rcvmh, 0);
+    nbytes = recvmsg(_proto_socket_in, &_rcvmh, flags);
     if (nbytes < 0) {
-	if (errno == EINTR)
-	    return;		// OK: restart receiving
+	if ((errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK))
+	    return (-1);	// OK: restart receiving
 	XLOG_ERROR("recvmsg() failed: %s", strerror(errno));
-	return;			// Error
+	return (-1);		// Error
     }
 
 #else // HOST_OS_WINDOWS
@@ -1330,7 +1359,7 @@ ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 		  _proto_socket_in.str().c_str(), XORP_INT_CAST(nbytes));
 	if (nbytes < 0) {
 	    // XLOG_ERROR("recvfrom() failed: %s", strerror(errno));
-	    return;			// Error
+	    return (-1);		// Error
 	}
     }
     break;
@@ -1351,7 +1380,7 @@ ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 
 	if (lpWSARecvMsg == NULL) {
 	    XLOG_ERROR("lpWSARecvMsg is NULL");
-	    return;			// Error
+	    return (-1);		// Error
 	}
 	error = lpWSARecvMsg(_proto_socket_in, &mh, &nrecvd, NULL, NULL);
 	nbytes = (ssize_t)nrecvd;
@@ -1359,17 +1388,44 @@ ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 		  _proto_socket_in.str().c_str(), XORP_INT_CAST(nbytes));
 	if (nbytes < 0) {
 	    // XLOG_ERROR("lpWSARecvMsg() failed: %s", strerror(errno));
-	    return;			// Error
+	    return (-1);		// Error
 	}
     }
     break;
 #endif // HAVE_IPV6
     default:
 	XLOG_UNREACHABLE();
-	return;			// Error
+	return (-1);		// Error
     }
 #endif // HOST_OS_WINDOWS
-    
+
+    return (nbytes);
+}
+
+/**
+ * ProtoComm::proto_socket_process:
+ * @nbytes: The length of the message in the receive buffer.
+ * 
+ * Process a message read from a protocol socket, and then call the
+ * appropriate protocol module to process it.
+ **/
+void
+ProtoComm::proto_socket_process(ssize_t nbytes)
+{
+    size_t	ip_hdr_len = 0;
+    size_t	ip_data_len = 0;
+    IPvX	src(family());
+    IPvX	dst(family());
+    int		int_val;
+    int		ip_ttl = -1;		// a.k.a. Hop-Limit in IPv6
+    int		ip_tos = -1;
+    bool	is_router_alert = false; // Router Alert option received
+    int		pif_index = 0;
+    MfeaVif	*mfea_vif = NULL;
+    void	*cmsg_data;	// XXX: CMSG_DATA() is aligned, hence void ptr
+
+    UNUSED(int_val);
+    UNUSED(cmsg_data);
     // Check whether this is a signal from the kernel to the user-level
     switch (_ip_protocol) {
     case IPPROTO_IGMP:
@@ -1393,7 +1449,7 @@ ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 	    // XXX: Packets sent up from kernel to daemon have
 	    //      igmpmsg.im_mbz = ip->ip_p = 0
 	    //
-	    mfea_node().mfea_mrouter().kernel_call_process(_rcvbuf, nbytes);
+	    mfea_node().mfea_mrouter().kernel_upcall_process(_rcvbuf, nbytes);
 	    return;		// OK
 	}
 #endif // HAVE_IPV4_MULTICAST_ROUTING
@@ -1434,7 +1490,7 @@ ProtoComm::proto_socket_read(XorpFd fd, IoEventType type)
 	    // April 2000, FreeBSD-4.0) which don't have the
 	    //     'icmp6_type = 0' mechanism.
 	    //
-	    mfea_node().mfea_mrouter().kernel_call_process(_rcvbuf, nbytes);
+	    mfea_node().mfea_mrouter().kernel_upcall_process(_rcvbuf, nbytes);
 	    return;		// OK
 	}
 #endif // HAVE_IPV6_MULTICAST_ROUTING
@@ -278,6 +278,23 @@ private:
     int		proto_socket_transmit(MfeaVif *mfea_vif, const IPvX& src,
 				      const IPvX& dst, string& error_msg);
 
+    /**
+     * Read a single message from a protocol socket into the receive buffer.
+     *
+     * @param flags the flags to pass to recvmsg().
+     * @return the length of the message, or -1 if there was no message
+     * to read or if error.
+     */
+    ssize_t	proto_socket_recv(int flags);
+
+    /**
+     * Process a message read from a protocol socket, and then call the
+     * appropriate protocol module to process it.
+     *
+     * @param nbytes the length of the message in the receive buffer.
+     */
+    void	proto_socket_process(ssize_t nbytes);
+
     // Private state
     MfeaNode&	_mfea_node;	// The MFEA node I belong to
     int		_ip_protocol;	// The protocol number (IPPROTO_*)
@@ -51,6 +51,17 @@ EventLoop::EventLoop()
     last_ev_run = 0;
 }
 
+#ifndef HOST_OS_WINDOWS
+EventLoop::EventLoop(SelectorList::Backend backend)
+    : _clock(new SystemClock), _timer_list(_clock),
+      _selector_list(_clock, backend)
+{
+    instance_count++;
+    XLOG_ASSERT(instance_count == 1);
+    last_ev_run = 0;
+}
+#endif
+
 EventLoop::~EventLoop()
 {
     instance_count--;
@@ -48,6 +48,16 @@ public:
      */
     EventLoop();
 
+#ifndef HOST_OS_WINDOWS
+    /**
+     * Constructor
+     *
+     * @param backend the system interface the @ref SelectorList waits
+     * for I/O events with.
+     */
+    EventLoop(SelectorList::Backend backend);
+#endif
+
     /**
      * Destructor.
      */
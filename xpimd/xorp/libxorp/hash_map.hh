@@ -0,0 +1,302 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2007 International Computer Science Institute
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software")
+// to deal in the Software without restriction, subject to the conditions
+// listed in the XORP LICENSE file. These conditions include: you must
+// preserve this copyright notice, and you cannot mention the copyright
+// holders in advertising related to the Software without their permission.
+// The Software is provided WITHOUT ANY WARRANTY, EXPRESS OR IMPLIED. This
+// notice is a summary of the XORP LICENSE file; the license in that file is
+// legally binding.
+
+#ifndef __LIBXORP_HASH_MAP_HH__
+#define __LIBXORP_HASH_MAP_HH__
+
+#include <utility>
+#include <vector>
+
+
+/**
+ * @short A hash-indexed map with stable iteration.
+ *
+ * The subset of the std::map interface needed by the users of this class
+ * is supported, but lookups hash the key instead of walking a tree.
+ * The key type must provide a "uint32_t hash() const" method and
+ * operator==.
+ *
+ * The entries are iterated in the order they were inserted.
+ * Inserting or erasing an entry doesn't move the other entries, hence
+ * it doesn't invalidate the iterators that point to them.
+ */
+template <class K, class V>
+class HashMap {
+private:
+    struct Node;
+
+public:
+    typedef K			key_type;
+    typedef V			mapped_type;
+    typedef pair<const K, V>	value_type;
+    typedef size_t		size_type;
+
+    /**
+     * A forward iterator.
+     */
+    class iterator {
+    public:
+	iterator() : _node(NULL) {}
+	value_type& operator*() const { return (_node->value); }
+	value_type* operator->() const { return (&_node->value); }
+	iterator& operator++() { _node = _node->next; return (*this); }
+	iterator operator++(int) {
+	    iterator tmp = *this;
+	    _node = _node->next;
+	    return (tmp);
+	}
+	bool operator==(const iterator& other) const {
+	    return (_node == other._node);
+	}
+	bool operator!=(const iterator& other) const {
+	    return (_node != other._node);
+	}
+
+    private:
+	friend class HashMap;
+	friend class const_iterator;
+	explicit iterator(Node* node) : _node(node) {}
+	Node*	_node;
+    };
+
+    /**
+     * A forward const iterator.
+     */
+    class const_iterator {
+    public:
+	const_iterator() : _node(NULL) {}
+	const_iterator(const iterator& iter) : _node(iter._node) {}
+	const value_type& operator*() const { return (_node->value); }
+	const value_type* operator->() const { return (&_node->value); }
+	const_iterator& operator++() { _node = _node->next; return (*this); }
+	const_iterator operator++(int) {
+	    const_iterator tmp = *this;
+	    _node = _node->next;
+	    return (tmp);
+	}
+	bool operator==(const const_iterator& other) const {
+	    return (_node == other._node);
+	}
+	bool operator!=(const const_iterator& other) const {
+	    return (_node != other._node);
+	}
+
+    private:
+	friend class HashMap;
+	explicit const_iterator(const Node* node) : _node(node) {}
+	const Node*	_node;
+    };
+
+    HashMap() : _head(NULL), _tail(NULL), _size(0) {}
+
+    HashMap(const HashMap& other) : _head(NULL), _tail(NULL), _size(0) {
+	copy_from(other);
+    }
+
+    ~HashMap() { clear(); }
+
+    HashMap& operator=(const HashMap& other) {
+	if (this != &other) {
+	    clear();
+	    copy_from(other);
+	}
+	return (*this);
+    }
+
+    iterator begin() { return (iterator(_head)); }
+    iterator end() { return (iterator()); }
+    const_iterator begin() const { return (const_iterator(_head)); }
+    const_iterator end() const { return (const_iterator()); }
+
+    size_type size() const { return (_size); }
+    bool empty() const { return (_size == 0); }
+
+    /**
+     * Find an entry.
+     *
+     * @param key the key to search for.
+     * @return an iterator to the entry if found, otherwise end().
+     */
+    iterator find(const K& key) { return (iterator(find_node(key))); }
+    const_iterator find(const K& key) const {
+	return (const_iterator(find_node(key)));
+    }
+
+    /**
+     * Count the entries with a given key.
+     *
+     * @param key the key to search for.
+     * @return 1 if there is an entry with that key, otherwise 0.
+     */
+    size_type count(const K& key) const {
+	return ((find_node(key) != NULL)? 1 : 0);
+    }
+
+    /**
+     * Insert an entry if there is no entry with the same key.
+     *
+     * @param value the entry to insert.
+     * @return a pair with an iterator to the entry with the same key as
+     * @ref value, and true if the entry was inserted.
+     */
+    pair<iterator, bool> insert(const value_type& value) {
+	uint32_t hash = value.first.hash();
+	Node* node = find_node(value.first, hash);
+
+	if (node != NULL)
+	    return (make_pair(iterator(node), false));
+
+	if (_size >= _buckets.size())
+	    rehash((_buckets.size() == 0)? MIN_BUCKETS : 2 * _buckets.size());
+
+	node = new Node(value, hash);
+	Node*& bucket = _buckets[hash & (_buckets.size() - 1)];
+	node->chain = bucket;
+	bucket = node;
+	node->prev = _tail;
+	if (_tail != NULL)
+	    _tail->next = node;
+	else
+	    _head = node;
+	_tail = node;
+	_size++;
+
+	return (make_pair(iterator(node), true));
+    }
+
+    /**
+     * Get the value for a key, and insert a default value if not found.
+     *
+     * @param key the key to search for.
+     * @return a reference to the value.
+     */
+    V& operator[](const K& key) {
+	return (insert(value_type(key, V())).first->second);
+    }
+
+    /**
+     * Erase an entry.
+     *
+     * @param iter an iterator to the entry to erase.
+     */
+    void erase(iterator iter) {
+	Node* node = iter._node;
+	Node** link = &_buckets[node->hash & (_buckets.size() - 1)];
+
+	while (*link != node)
+	    link = &(*link)->chain;
+	*link = node->chain;
+	if (node->prev != NULL)
+	    node->prev->next = node->next;
+	else
+	    _head = node->next;
+	if (node->next != NULL)
+	    node->next->prev = node->prev;
+	else
+	    _tail = node->prev;
+	_size--;
+	delete node;
+    }
+
+    /**
+     * Erase the entry with a given key.
+     *
+     * @param key the key of the entry to erase.
+     * @return the number of entries erased (0 or 1).
+     */
+    size_type erase(const K& key) {
+	iterator iter = find(key);
+
+	if (iter == end())
+	    return (0);
+	erase(iter);
+	return (1);
+    }
+
+    /**
+     * Erase all entries.
+     */
+    void clear() {
+	while (_head != NULL) {
+	    Node* node = _head;
+	    _head = node->next;
+	    delete node;
+	}
+	_tail = NULL;
+	_size = 0;
+	_buckets.clear();
+    }
+
+    /**
+     * Swap the contents with another map.
+     *
+     * @param other the map to swap the contents with.
+     */
+    void swap(HashMap& other) {
+	std::swap(_head, other._head);
+	std::swap(_tail, other._tail);
+	std::swap(_size, other._size);
+	_buckets.swap(other._buckets);
+    }
+
+private:
+    enum { MIN_BUCKETS = 8 };		// XXX: must be a power of 2
+
+    struct Node {
+	Node(const value_type& v, uint32_t h)
+	    : value(v), prev(NULL), next(NULL), chain(NULL), hash(h) {}
+
+	value_type	value;
+	Node*		prev;		// The previous entry in insertion order
+	Node*		next;		// The next entry in insertion order
+	Node*		chain;		// The next entry in the same bucket
+	uint32_t	hash;		// The hash value of the key
+    };
+
+    Node* find_node(const K& key) const {
+	return (find_node(key, key.hash()));
+    }
+
+    Node* find_node(const K& key, uint32_t hash) const {
+	if (_size == 0)
+	    return (NULL);
+	Node* node = _buckets[hash & (_buckets.size() - 1)];
+	for ( ; node != NULL; node = node->chain) {
+	    if ((node->hash == hash) && (node->value.first == key))
+		return (node);
+	}
+	return (NULL);
+    }
+
+    void rehash(size_t n) {
+	_buckets.assign(n, static_cast<Node*>(NULL));
+	for (Node* node = _head; node != NULL; node = node->next) {
+	    Node*& bucket = _buckets[node->hash & (n - 1)];
+	    node->chain = bucket;
+	    bucket = node;
+	}
+    }
+
+    void copy_from(const HashMap& other) {
+	for (const Node* node = other._head; node != NULL; node = node->next)
+	    insert(node->value);
+    }
+
+    Node*		_head;		// The first entry in insertion order
+    Node*		_tail;		// The last entry in insertion order
+    size_t		_size;		// The number of entries
+    vector<Node*>	_buckets;	// The hash buckets
+};
+
+#endif // __LIBXORP_HASH_MAP_HH__
@@ -122,8 +122,10 @@ Heap::push(Heap_Key k, HeapBase *p, int son)
 		  XORP_UINT_CAST(k.sec()), XORP_UINT_CAST(k.usec()), p);
         son = _elements;
         if (son == _size) {
-	    // need resize...
-            if (resize(_elements + 1))
+	    // need resize... grow geometrically, so that adding many
+	    // timers at once (e.g., on a membership report storm) doesn't
+	    // copy the whole heap each time.
+            if (resize(_elements + 1 + _elements / 2))
                 return;		// Failure...
 	}
         _p[son].object = p ;
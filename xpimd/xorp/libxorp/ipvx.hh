@@ -715,6 +715,24 @@ public:
      */
     inline bool is_ipv6() const { return (_af == AF_INET6); }
 
+    /**
+     * Get a hash value of the address.
+     *
+     * @return a hash value of the address, for use with hash tables
+     * (see @ref HashMap).
+     */
+    inline uint32_t hash() const {
+	size_t n = is_ipv4()? 1 : sizeof(_addr) / sizeof(_addr[0]);
+	uint32_t h = _af;
+
+	for (size_t i = 0; i < n; i++) {
+	    h ^= _addr[i];
+	    h *= 0x9e3779b1U;
+	    h ^= h >> 16;
+	}
+	return (h);
+    }
+
     /**
      * Get IPv4 address.
      *
@@ -68,6 +68,26 @@ map_ioevent_to_selectormask(const IoEventType type)
     return (mask);
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+static int
+map_epoll_to_selectormask(uint32_t events, int registered)
+{
+    int mask = 0;
+
+    if (events & EPOLLIN)
+	mask |= SEL_RD;
+    if (events & EPOLLOUT)
+	mask |= SEL_WR;
+    if (events & EPOLLPRI)
+	mask |= SEL_EX;
+    // select(2) reports errors and hangups as readable and writable
+    if (events & (EPOLLERR | EPOLLHUP))
+	mask |= SEL_RD | SEL_WR;
+
+    return (mask & registered);
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // SelectorList::Node methods
 
@@ -173,20 +193,150 @@ SelectorList::Node::is_empty()
 	    (_mask[SEL_EX_IDX] == 0));
 }
 
+inline int
+SelectorList::Node::mask() const
+{
+    return (_mask[SEL_RD_IDX] | _mask[SEL_WR_IDX] | _mask[SEL_EX_IDX]);
+}
+
 // ----------------------------------------------------------------------------
 // SelectorList implementation
 
 SelectorList::SelectorList(ClockBase *clock)
-    : _clock(clock), _observer(NULL), _maxfd(0), _descriptor_count(0)
+    : _clock(clock), _observer(NULL), _maxfd(0), _descriptor_count(0),
+      _epoll_fd(-1)
+{
+    init(default_backend());
+}
+
+SelectorList::SelectorList(ClockBase *clock, Backend backend)
+    : _clock(clock), _observer(NULL), _maxfd(0), _descriptor_count(0),
+      _epoll_fd(-1)
+{
+    init(backend);
+}
+
+SelectorList::~SelectorList()
+{
+    if (_epoll_fd >= 0)
+	close(_epoll_fd);
+}
+
+void
+SelectorList::init(Backend backend)
 {
     static_assert(SEL_RD == (1 << SEL_RD_IDX) && SEL_WR == (1 << SEL_WR_IDX)
 		  && SEL_EX == (1 << SEL_EX_IDX) && SEL_MAX_IDX == 3);
     for (int i = 0; i < SEL_MAX_IDX; i++)
 	FD_ZERO(&_fds[i]);
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (backend == BACKEND_EPOLL) {
+	_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll_fd < 0)
+	    XLOG_ERROR("epoll_create1() failed, using select() instead: %s",
+		       strerror(errno));
+    }
+#else
+    UNUSED(backend);
+#endif
 }
 
-SelectorList::~SelectorList()
+SelectorList::Backend
+SelectorList::default_backend()
 {
+#ifdef HAVE_SYS_EPOLL_H
+    return BACKEND_EPOLL;
+#else
+    return BACKEND_SELECT;
+#endif
+}
+
+SelectorList::Backend
+SelectorList::backend() const
+{
+    return (_epoll_fd >= 0 ? BACKEND_EPOLL : BACKEND_SELECT);
+}
+
+//
+// Bring the epoll(7) registration of fd from old_mask to new_mask.
+//
+bool
+SelectorList::epoll_update(int fd, int old_mask, int new_mask)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+    int op;
+
+    if (new_mask == old_mask)
+	return true;
+
+    memset(&ev, 0, sizeof(ev));
+    if (new_mask & SEL_RD)
+	ev.events |= EPOLLIN;
+    if (new_mask & SEL_WR)
+	ev.events |= EPOLLOUT;
+    if (new_mask & SEL_EX)
+	ev.events |= EPOLLPRI;
+    ev.data.fd = fd;
+
+    if (old_mask == 0)
+	op = EPOLL_CTL_ADD;
+    else if (new_mask == 0)
+	op = EPOLL_CTL_DEL;
+    else
+	op = EPOLL_CTL_MOD;
+
+    if (epoll_ctl(_epoll_fd, op, fd, &ev) == 0)
+	return true;
+
+    //
+    // Closing a descriptor takes it out of the epoll set, possibly
+    // before its callbacks are removed here.
+    //
+    if (op == EPOLL_CTL_DEL && (errno == EBADF || errno == ENOENT))
+	return true;
+    if (op == EPOLL_CTL_MOD && errno == ENOENT
+	&& epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0)
+	return true;
+
+    XLOG_ERROR("epoll_ctl() failed for fd = %d: %s", fd, strerror(errno));
+#else
+    UNUSED(fd);
+    UNUSED(old_mask);
+    UNUSED(new_mask);
+#endif
+    return false;
+}
+
+//
+// Wait for up to millisecs (forever if negative) for I/O events with
+// epoll(7).  Returns the number of events in _epoll_events, or -1.
+//
+int
+SelectorList::epoll_poll(int millisecs)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if (_epoll_events.size() < _descriptor_count || _epoll_events.empty())
+	_epoll_events.resize(_descriptor_count + 32);
+
+    int n = epoll_wait(_epoll_fd, &_epoll_events[0], _epoll_events.size(),
+		       millisecs);
+    if (n < 0) {
+	if (errno == EINTR) {
+	    // The system call was interrupted by a signal, hence return
+	    // immediately to the event loop without printing an error.
+	    debug_msg("SelectorList::epoll_poll() interrupted by a signal\n");
+	} else {
+	    XLOG_ERROR("SelectorList::epoll_poll() failed: %s",
+		       strerror(errno));
+	}
+    }
+    return n;
+#else
+    UNUSED(millisecs);
+    return -1;
+#endif
 }
 
 bool
@@ -207,6 +357,12 @@ SelectorList::add_ioevent_cb(XorpFd		fd,
 		   "descriptor (fd = %s)\n", fd.str().c_str());
     }
 
+    if (_epoll_fd < 0 && fd >= FD_SETSIZE) {
+	XLOG_ERROR("SelectorList::add_ioevent_cb: file descriptor %d is "
+		   "beyond FD_SETSIZE", (int)fd);
+	return false;
+    }
+
     bool resize = false;
     if (fd >= _maxfd) {
 	_maxfd = fd;
@@ -222,15 +378,22 @@ SelectorList::add_ioevent_cb(XorpFd		fd,
 	}
     }
     bool no_selectors_with_fd = _selector_entries[fd].is_empty();
+    int old_mask = _selector_entries[fd].mask();
     if (_selector_entries[fd].add_okay(mask, type, cb, priority) == false) {
 	return false;
     }
+    if (_epoll_fd >= 0
+	&& !epoll_update(fd, old_mask, _selector_entries[fd].mask())) {
+	_selector_entries[fd].clear(mask);
+	return false;
+    }
     if (no_selectors_with_fd)
 	_descriptor_count++;
 
     for (int i = 0; i < SEL_MAX_IDX; i++) {
 	if (mask & (1 << i)) {
-	    FD_SET(fd, &_fds[i]);
+	    if (fd < FD_SETSIZE)
+		FD_SET(fd, &_fds[i]);
 	    if (_observer) _observer->notify_added(fd, mask);
 	}
     }
@@ -251,11 +414,13 @@ SelectorList::remove_ioevent_cb(XorpFd fd, IoEventType type)
     }
 
     SelectorMask mask = map_ioevent_to_selectormask(type);
+    int old_mask = _selector_entries[fd].mask();
 
     for (int i = 0; i < SEL_MAX_IDX; i++) {
-	if (mask & (1 << i) && FD_ISSET(fd, &_fds[i])) {
+	if (mask & old_mask & (1 << i)) {
 	    found = true;
-	    FD_CLR(fd, &_fds[i]);
+	    if (fd < FD_SETSIZE)
+		FD_CLR(fd, &_fds[i]);
 	    if (_observer)
 		_observer->notify_removed(fd, ((SelectorMask) (1 << i)));
 	}
@@ -266,10 +431,14 @@ SelectorList::remove_ioevent_cb(XorpFd fd, IoEventType type)
     }
 
     _selector_entries[fd].clear(mask);
+    if (_epoll_fd >= 0)
+	epoll_update(fd, old_mask, _selector_entries[fd].mask());
     if (_selector_entries[fd].is_empty()) {
-	assert(FD_ISSET(fd, &_fds[SEL_RD_IDX]) == 0);
-	assert(FD_ISSET(fd, &_fds[SEL_WR_IDX]) == 0);
-	assert(FD_ISSET(fd, &_fds[SEL_EX_IDX]) == 0);
+	if (fd < FD_SETSIZE) {
+	    assert(FD_ISSET(fd, &_fds[SEL_RD_IDX]) == 0);
+	    assert(FD_ISSET(fd, &_fds[SEL_WR_IDX]) == 0);
+	    assert(FD_ISSET(fd, &_fds[SEL_EX_IDX]) == 0);
+	}
 	_descriptor_count--;
     }
 }
@@ -280,6 +449,9 @@ SelectorList::ready()
     fd_set testfds[SEL_MAX_IDX];
     int n = 0;
 
+    if (_epoll_fd >= 0)
+	return (epoll_poll(0) > 0);
+
     memcpy(testfds, _fds, sizeof(_fds));
     struct timeval tv_zero;
     tv_zero.tv_sec = 0;
@@ -322,6 +494,27 @@ SelectorList::get_ready_priority()
     fd_set testfds[SEL_MAX_IDX];
     int n = 0;
 
+#ifdef HAVE_SYS_EPOLL_H
+    if (_epoll_fd >= 0) {
+	int max_priority = XorpTask::PRIORITY_INFINITY;
+
+	n = epoll_poll(0);
+	for (int i = 0; i < n; i++) {
+	    int fd = _epoll_events[i].data.fd;
+	    int mask = map_epoll_to_selectormask(_epoll_events[i].events,
+						 _selector_entries[fd].mask());
+	    for (int sel_idx = 0; sel_idx < SEL_MAX_IDX; sel_idx++) {
+		if (mask & (1 << sel_idx)) {
+		    int p = _selector_entries[fd]._priority[sel_idx];
+		    if (p < max_priority)
+			max_priority = p;
+		}
+	    }
+	}
+	return max_priority;
+    }
+#endif
+
     memcpy(testfds, _fds, sizeof(_fds));
     struct timeval tv_zero;
     tv_zero.tv_sec = 0;
@@ -375,6 +568,34 @@ SelectorList::wait_and_dispatch(TimeVal* timeout)
     fd_set testfds[SEL_MAX_IDX];
     int n = 0;
 
+#ifdef HAVE_SYS_EPOLL_H
+    if (_epoll_fd >= 0) {
+	int millisecs = -1;
+
+	if (timeout != 0 && *timeout != TimeVal::MAXIMUM()) {
+	    if (*timeout == TimeVal::ZERO())
+		millisecs = 0;
+	    else if (timeout->sec() < INT_MAX / 1000)
+		millisecs = timeout->to_ms();
+	}
+
+	n = epoll_poll(millisecs);
+
+	_clock->advance_time();
+
+	for (int i = 0; i < n; i++) {
+	    int fd = _epoll_events[i].data.fd;
+	    // An earlier callback may have removed the descriptor
+	    int mask = map_epoll_to_selectormask(_epoll_events[i].events,
+						 _selector_entries[fd].mask());
+	    if (mask)
+		_selector_entries[fd].run_hooks(SelectorMask(mask), fd);
+	}
+
+	return (n < 0 ? 0 : n);
+    }
+#endif
+
     memcpy(testfds, _fds, sizeof(_fds));
 
     if (timeout == 0 || *timeout == TimeVal::MAXIMUM()) {
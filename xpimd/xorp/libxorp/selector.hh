@@ -31,6 +31,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #include <vector>
 
 #include "callback.hh"
@@ -94,15 +98,49 @@ private:
  * are invoked when one of the @ref wait_and_dispatch methods is called
  * and I/O is pending on the particular descriptors.
  *
+ * The pending descriptors are found with select(2), or with epoll(7)
+ * where available.  The latter scales with the number of ready
+ * descriptors rather than with the highest descriptor registered, and
+ * is not limited to FD_SETSIZE descriptors.
  */
 class SelectorList {
 public:
 
+    /**
+     * The system interface used to wait for I/O events.
+     */
+    enum Backend {
+	BACKEND_SELECT,		// select(2)
+	BACKEND_EPOLL		// epoll(7)
+    };
+
     /**
      * Default constructor.
      */
     SelectorList(ClockBase* clock);
 
+    /**
+     * Constructor.
+     *
+     * @param backend the system interface to use.  If it is not
+     * available, select(2) is used instead.
+     */
+    SelectorList(ClockBase* clock, Backend backend);
+
+    /**
+     * Get the system interface used by default.
+     *
+     * @return epoll(7) if it was found at build time, otherwise select(2).
+     */
+    static Backend default_backend();
+
+    /**
+     * Get the system interface in use.
+     *
+     * @return the system interface in use.
+     */
+    Backend backend() const;
+
     /**
      * Destructor.
      */
@@ -188,7 +226,8 @@ public:
 
     /**
      * Get a copy of the current list of monitored file descriptors in
-     * Unix fd_set format
+     * Unix fd_set format.  With epoll(7), descriptors from FD_SETSIZE
+     * upwards are left out.
      *
      * @param the selected mask as @ref SelectorMask (SEL_RD, SEL_WR, or SEL_EX)
      *
@@ -221,6 +260,11 @@ public:
 protected:
     void callback_bad_descriptors();
 
+private:
+    void init(Backend backend);
+    bool epoll_update(int fd, int old_mask, int new_mask);
+    int epoll_poll(int millisecs);
+
 private:
     SelectorList(const SelectorList&);			// not implemented
     SelectorList& operator=(const SelectorList&);	// not implemented
@@ -247,6 +291,7 @@ private:
 	inline int	run_hooks(SelectorMask m, XorpFd fd);
 	inline void	clear(SelectorMask m);
 	inline bool	is_empty();
+	inline int	mask() const;
     };
 
     ClockBase*		_clock;
@@ -256,6 +301,11 @@ private:
     vector<Node>	_selector_entries;
     int			_maxfd;
     size_t		_descriptor_count;
+
+    int			_epoll_fd;	// -1 if select(2) is used
+#ifdef HAVE_SYS_EPOLL_H
+    vector<struct epoll_event> _epoll_events;
+#endif
 };
 
 #endif // __LIBXORP_SELECTOR_HH__
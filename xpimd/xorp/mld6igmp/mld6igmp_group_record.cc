@@ -171,6 +171,7 @@ Mld6igmpGroupRecord::process_mode_is_include(const set<IPvX>& sources,
     bool old_is_include_mode = is_include_mode();
     set<IPvX> old_do_forward_sources = _do_forward_sources.extract_source_addresses();
     set<IPvX> old_dont_forward_sources = _dont_forward_sources.extract_source_addresses();
+    set<IPvX>::const_iterator iter;
 
     set_last_reported_host(last_reported_host);
 
@@ -181,15 +182,15 @@ Mld6igmpGroupRecord::process_mode_is_include(const set<IPvX>& sources,
 	// New Router State: INCLUDE (A + B)
 	// Actions: (B) = GMI
 	//
-	Mld6igmpSourceSet& a = _do_forward_sources;
 	const set<IPvX>& b = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_include_mode();
 
-	_do_forward_sources = a + b;			// (A + B)
-
-	_do_forward_sources.set_source_timer(b, gmi);	// (B) = GMI
+	for (iter = b.begin(); iter != b.end(); ++iter) {
+	    Mld6igmpSourceRecord* source_record = add_do_forward_source(*iter);
+	    source_record->set_source_timer(gmi);	// (B) = GMI
+	}
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -204,20 +205,16 @@ Mld6igmpGroupRecord::process_mode_is_include(const set<IPvX>& sources,
 	// New Router State: EXCLUDE (X + A, Y - A)
 	// Actions: (A) = GMI
 	//
-	Mld6igmpSourceSet& x = _do_forward_sources;
-	Mld6igmpSourceSet& y = _dont_forward_sources;
 	const set<IPvX>& a = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_exclude_mode();
 
-	// XXX: first transfer (Y * A) from (Y) to (X)
-	Mld6igmpSourceSet y_and_a = y * a;
-	_do_forward_sources = x + y_and_a;
-	_do_forward_sources = x + a;			// (X + A)
-	_dont_forward_sources = y - a;			// (Y - A)
-
-	_do_forward_sources.set_source_timer(a, gmi);	// (A) = GMI
+	// XXX: the sources in (Y * A) are transferred from (Y) to (X)
+	for (iter = a.begin(); iter != a.end(); ++iter) {
+	    Mld6igmpSourceRecord* source_record = add_do_forward_source(*iter);
+	    source_record->set_source_timer(gmi);	// (A) = GMI
+	}
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -252,19 +249,14 @@ Mld6igmpGroupRecord::process_mode_is_exclude(const set<IPvX>& sources,
 	//          Delete (A - B)
 	//          Group Timer = GMI
 	//
-	Mld6igmpSourceSet& a = _do_forward_sources;
 	const set<IPvX>& b = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_exclude_mode();
 
-	Mld6igmpSourceSet a_minus_b = a - b;			// A - B
-	_dont_forward_sources = _dont_forward_sources + b;	// B
-	_dont_forward_sources = _dont_forward_sources - a;	// B - A
-	_do_forward_sources = a * b;				// A * B
-
-	_dont_forward_sources.cancel_source_timer();		// (B - A) = 0
-	a_minus_b.delete_payload_and_clear();			// Delete (A-B)
+	_do_forward_sources.delete_payload_not_in(b);	// Delete (A - B)
+	add_dont_forward_sources(b);			// B - A
+	_dont_forward_sources.cancel_source_timer();	// (B - A) = 0
 	_group_timer = eventloop().new_oneoff_after(
 	    gmi,
 	    callback(this, &Mld6igmpGroupRecord::group_timer_timeout));
@@ -285,27 +277,15 @@ Mld6igmpGroupRecord::process_mode_is_exclude(const set<IPvX>& sources,
 	//          Delete (Y - A)
 	//          Group Timer = GMI
 	//
-	Mld6igmpSourceSet& x = _do_forward_sources;
-	Mld6igmpSourceSet x_copy = x;
-	Mld6igmpSourceSet& y = _dont_forward_sources;
 	const set<IPvX>& a = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_exclude_mode();
 
-	Mld6igmpSourceSet x_minus_a = x - a;			// X - A
-	Mld6igmpSourceSet y_minus_a = y - a;			// Y - A
-	// XXX: The (X * A) below is needed to preserve the original timers
-	_do_forward_sources = x * a;				// X * A
-	_do_forward_sources = _do_forward_sources + a;		// A
-	_do_forward_sources = _do_forward_sources - y;		// A - Y
-	_dont_forward_sources = y * a;				// Y * A
-	Mld6igmpSourceSet a_minus_x_minus_y(*this);
-	a_minus_x_minus_y = _do_forward_sources - x_copy;	// A - X - Y
-
-	a_minus_x_minus_y.set_source_timer(gmi);	// (A - X - Y) = GMI
-	x_minus_a.delete_payload_and_clear();		// Delete (X - A)
-	y_minus_a.delete_payload_and_clear();		// Delete (Y - A)
+	// XXX: the sources in (X * A) keep their original timers
+	add_new_do_forward_sources(a, gmi);		// (A - X - Y) = GMI
+	_do_forward_sources.delete_payload_not_in(a);	// Delete (X - A)
+	_dont_forward_sources.delete_payload_not_in(a);	// Delete (Y - A)
 	_group_timer = eventloop().new_oneoff_after(
 	    gmi,
 	    callback(this, &Mld6igmpGroupRecord::group_timer_timeout));
@@ -331,6 +311,7 @@ Mld6igmpGroupRecord::process_change_to_include_mode(const set<IPvX>& sources,
     bool old_is_include_mode = is_include_mode();
     set<IPvX> old_do_forward_sources = _do_forward_sources.extract_source_addresses();
     set<IPvX> old_dont_forward_sources = _dont_forward_sources.extract_source_addresses();
+    set<IPvX>::const_iterator iter;
     string dummy_error_msg;
 
     set_last_reported_host(last_reported_host);
@@ -343,22 +324,22 @@ Mld6igmpGroupRecord::process_change_to_include_mode(const set<IPvX>& sources,
 	// Actions: (B) = GMI
 	//          Send Q(G, A - B)
 	//
-	Mld6igmpSourceSet& a = _do_forward_sources;
 	const set<IPvX>& b = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_include_mode();
 
-	Mld6igmpSourceSet a_minus_b = a - b;		// A - B
-	_do_forward_sources = a + b;			// A + B
+	set<IPvX> a_minus_b =
+	    _do_forward_sources.extract_source_addresses_not_in(b); // A - B
 
-	_do_forward_sources.set_source_timer(b, gmi);	// (B) = GMI
+	for (iter = b.begin(); iter != b.end(); ++iter) {
+	    Mld6igmpSourceRecord* source_record = add_do_forward_source(*iter);
+	    source_record->set_source_timer(gmi);	// (B) = GMI
+	}
 
 	// Send Q(G, A - B) with a_minus_b
-	_mld6igmp_vif.mld6igmp_group_source_query_send(
-	    group(),
-	    a_minus_b.extract_source_addresses(),
-	    dummy_error_msg);
+	_mld6igmp_vif.mld6igmp_group_source_query_send(group(), a_minus_b,
+						       dummy_error_msg);
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -375,27 +356,23 @@ Mld6igmpGroupRecord::process_change_to_include_mode(const set<IPvX>& sources,
 	//          Send Q(G, X - A)
 	//          Send Q(G)
 	//
-	Mld6igmpSourceSet& x = _do_forward_sources;
-	Mld6igmpSourceSet& y = _dont_forward_sources;
 	const set<IPvX>& a = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_exclude_mode();
 
-	Mld6igmpSourceSet x_minus_a = x - a;		// X - A
-	// XXX: first transfer (Y * A) from (Y) to (X)
-	Mld6igmpSourceSet y_and_a = y * a;
-	_do_forward_sources = x + y_and_a;
-	_do_forward_sources = x + a;			// X + A
-	_dont_forward_sources = y - a;			// Y - A
+	set<IPvX> x_minus_a =
+	    _do_forward_sources.extract_source_addresses_not_in(a); // X - A
 
-	_do_forward_sources.set_source_timer(a, gmi);	// (A) = GMI
+	// XXX: the sources in (Y * A) are transferred from (Y) to (X)
+	for (iter = a.begin(); iter != a.end(); ++iter) {
+	    Mld6igmpSourceRecord* source_record = add_do_forward_source(*iter);
+	    source_record->set_source_timer(gmi);	// (A) = GMI
+	}
 
 	// Send Q(G, X - A) with x_minus_a
-	_mld6igmp_vif.mld6igmp_group_source_query_send(
-	    group(),
-	    x_minus_a.extract_source_addresses(),
-	    dummy_error_msg);
+	_mld6igmp_vif.mld6igmp_group_source_query_send(group(), x_minus_a,
+						       dummy_error_msg);
 
 	// Send Q(G)
 	_mld6igmp_vif.mld6igmp_group_query_send(group(), dummy_error_msg);
@@ -435,19 +412,14 @@ Mld6igmpGroupRecord::process_change_to_exclude_mode(const set<IPvX>& sources,
 	//          Send Q(G, A * B)
 	//          Group Timer = GMI
 	//
-	Mld6igmpSourceSet& a = _do_forward_sources;
 	const set<IPvX>& b = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_exclude_mode();
 
-	Mld6igmpSourceSet a_minus_b = a - b;			// A - B
-	_dont_forward_sources = _dont_forward_sources + b;	// B
-	_dont_forward_sources = _dont_forward_sources - a;	// B - A
-	_do_forward_sources = a * b;				// A * B
-
-	_dont_forward_sources.cancel_source_timer();		// (B - A) = 0
-	a_minus_b.delete_payload_and_clear();			// Delete (A-B)
+	_do_forward_sources.delete_payload_not_in(b);	// Delete (A - B)
+	add_dont_forward_sources(b);			// B - A
+	_dont_forward_sources.cancel_source_timer();	// (B - A) = 0
 	_group_timer = eventloop().new_oneoff_after(
 	    gmi,
 	    callback(this, &Mld6igmpGroupRecord::group_timer_timeout));
@@ -475,9 +447,6 @@ Mld6igmpGroupRecord::process_change_to_exclude_mode(const set<IPvX>& sources,
 	//          Send Q(G, A - Y)
 	//          Group Timer = GMI
 	//
-	Mld6igmpSourceSet& x = _do_forward_sources;
-	Mld6igmpSourceSet x_copy = x;
-	Mld6igmpSourceSet& y = _dont_forward_sources;
 	const set<IPvX>& a = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 	TimeVal gt;
@@ -485,19 +454,10 @@ Mld6igmpGroupRecord::process_change_to_exclude_mode(const set<IPvX>& sources,
 
 	set_exclude_mode();
 
-	Mld6igmpSourceSet x_minus_a = x - a;			// X - A
-	Mld6igmpSourceSet y_minus_a = y - a;			// Y - A
-	// XXX: The (X * A) below is needed to preserve the original timers
-	_do_forward_sources = x * a;				// X * A
-	_do_forward_sources = _do_forward_sources + a;		// A
-	_do_forward_sources = _do_forward_sources - y;		// A - Y
-	_dont_forward_sources = y * a;				// Y * A
-	Mld6igmpSourceSet a_minus_x_minus_y(*this);
-	a_minus_x_minus_y = _do_forward_sources - x_copy;	// A - X - Y
-
-	a_minus_x_minus_y.set_source_timer(gt);	// (A - X - Y) = Group Timer
-	x_minus_a.delete_payload_and_clear();		// Delete (X - A)
-	y_minus_a.delete_payload_and_clear();		// Delete (Y - A)
+	// XXX: the sources in (X * A) keep their original timers
+	add_new_do_forward_sources(a, gt);	// (A - X - Y) = Group Timer
+	_do_forward_sources.delete_payload_not_in(a);	// Delete (X - A)
+	_dont_forward_sources.delete_payload_not_in(a);	// Delete (Y - A)
 	_group_timer = eventloop().new_oneoff_after(
 	    gmi,
 	    callback(this, &Mld6igmpGroupRecord::group_timer_timeout));
@@ -529,6 +489,7 @@ Mld6igmpGroupRecord::process_allow_new_sources(const set<IPvX>& sources,
     bool old_is_include_mode = is_include_mode();
     set<IPvX> old_do_forward_sources = _do_forward_sources.extract_source_addresses();
     set<IPvX> old_dont_forward_sources = _dont_forward_sources.extract_source_addresses();
+    set<IPvX>::const_iterator iter;
 
     set_last_reported_host(last_reported_host);
 
@@ -539,15 +500,15 @@ Mld6igmpGroupRecord::process_allow_new_sources(const set<IPvX>& sources,
 	// New Router State: INCLUDE (A + B)
 	// Actions: (B) = GMI
 	//
-	Mld6igmpSourceSet& a = _do_forward_sources;
 	const set<IPvX>& b = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_include_mode();
 
-	_do_forward_sources = a + b;			// A + B
-
-	_do_forward_sources.set_source_timer(b, gmi);	// (B) = GMI
+	for (iter = b.begin(); iter != b.end(); ++iter) {
+	    Mld6igmpSourceRecord* source_record = add_do_forward_source(*iter);
+	    source_record->set_source_timer(gmi);	// (B) = GMI
+	}
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -562,20 +523,16 @@ Mld6igmpGroupRecord::process_allow_new_sources(const set<IPvX>& sources,
 	// New Router State: EXCLUDE (X + A, Y - A)
 	// Actions: (A) = GMI
 	//
-	Mld6igmpSourceSet& x = _do_forward_sources;
-	Mld6igmpSourceSet& y = _dont_forward_sources;
 	const set<IPvX>& a = sources;
 	TimeVal gmi = _mld6igmp_vif.group_membership_interval();
 
 	set_exclude_mode();
 
-	// XXX: first transfer (Y * A) from (Y) to (X)
-	Mld6igmpSourceSet y_and_a = y * a;
-	_do_forward_sources = x + y_and_a;
-	_do_forward_sources = x + a;			// X + A
-	_dont_forward_sources = y - a;			// Y - A
-
-	_do_forward_sources.set_source_timer(a, gmi);   // (A) = GMI
+	// XXX: the sources in (Y * A) are transferred from (Y) to (X)
+	for (iter = a.begin(); iter != a.end(); ++iter) {
+	    Mld6igmpSourceRecord* source_record = add_do_forward_source(*iter);
+	    source_record->set_source_timer(gmi);	// (A) = GMI
+	}
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -598,6 +555,7 @@ Mld6igmpGroupRecord::process_block_old_sources(const set<IPvX>& sources,
     bool old_is_include_mode = is_include_mode();
     set<IPvX> old_do_forward_sources = _do_forward_sources.extract_source_addresses();
     set<IPvX> old_dont_forward_sources = _dont_forward_sources.extract_source_addresses();
+    set<IPvX>::const_iterator iter;
     string dummy_error_msg;
 
     set_last_reported_host(last_reported_host);
@@ -609,18 +567,19 @@ Mld6igmpGroupRecord::process_block_old_sources(const set<IPvX>& sources,
 	// New Router State: INCLUDE (A)
 	// Actions: Send Q(G, A * B)
 	//
-	Mld6igmpSourceSet& a = _do_forward_sources;
 	const set<IPvX>& b = sources;
+	set<IPvX> a_and_b;
 
 	set_include_mode();
 
-	Mld6igmpSourceSet a_and_b = a * b;
+	for (iter = b.begin(); iter != b.end(); ++iter) {
+	    if (find_do_forward_source(*iter) != NULL)
+		a_and_b.insert(a_and_b.end(), *iter);	// A * B
+	}
 
 	// Send Q(G, A * B) with a_and_b
-	_mld6igmp_vif.mld6igmp_group_source_query_send(
-	    group(),
-	    a_and_b.extract_source_addresses(),
-	    dummy_error_msg);
+	_mld6igmp_vif.mld6igmp_group_source_query_send(group(), a_and_b,
+						       dummy_error_msg);
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -636,32 +595,22 @@ Mld6igmpGroupRecord::process_block_old_sources(const set<IPvX>& sources,
 	// Actions: (A - X - Y) = Group Timer
 	//          Send Q(G, A - Y)
 	//
-	Mld6igmpSourceSet& x = _do_forward_sources;
-	Mld6igmpSourceSet x_copy = x;
-	Mld6igmpSourceSet& y = _dont_forward_sources;
 	const set<IPvX>& a = sources;
+	set<IPvX> a_minus_y;
 	TimeVal gt;
 	_group_timer.time_remaining(gt);
 
 	set_exclude_mode();
 
-	Mld6igmpSourceSet a_minus_y(*this);
-	a_minus_y = a_minus_y + a;			// A
-	a_minus_y = a_minus_y - y;			// A - Y
-	_do_forward_sources = x + a_minus_y;		// X + (A - Y)
-
-	Mld6igmpSourceSet a_minus_x_minus_y = _do_forward_sources; // (X+(A-Y))
-	a_minus_x_minus_y = a_minus_x_minus_y - x_copy;	// A - X - Y
-	a_minus_x_minus_y = a_minus_x_minus_y - y;	// A - X - Y
-	Mld6igmpSourceSet y_minus_a = y - a;		// Y - A
-
-	a_minus_x_minus_y.set_source_timer(gt);	// (A - X - Y) = Group Timer
+	for (iter = a.begin(); iter != a.end(); ++iter) {
+	    if (find_dont_forward_source(*iter) == NULL)
+		a_minus_y.insert(a_minus_y.end(), *iter);	// A - Y
+	}
+	add_new_do_forward_sources(a, gt);	// (A - X - Y) = Group Timer
 
 	// Send Q(G, A - Y) with a_minus_y
-	_mld6igmp_vif.mld6igmp_group_source_query_send(
-	    group(),
-	    a_minus_y.extract_source_addresses(),
-	    dummy_error_msg);
+	_mld6igmp_vif.mld6igmp_group_source_query_send(group(), a_minus_y,
+						       dummy_error_msg);
 
 	calculate_forwarding_changes(old_is_include_mode,
 				     old_do_forward_sources,
@@ -670,6 +619,88 @@ Mld6igmpGroupRecord::process_block_old_sources(const set<IPvX>& sources,
     }
 }
 
+/**
+ * Add a source that should be forwarded.
+ *
+ * If the source is not forwarded yet, then its record is transferred
+ * from the sources that should not be forwarded, or is created.
+ *
+ * @param source the source address.
+ * @return the corresponding source record (@ref Mld6igmpSourceRecord).
+ */
+Mld6igmpSourceRecord*
+Mld6igmpGroupRecord::add_do_forward_source(const IPvX& source)
+{
+    Mld6igmpSourceRecord* source_record;
+
+    source_record = _do_forward_sources.find_source_record(source);
+    if (source_record != NULL)
+	return (source_record);
+
+    Mld6igmpSourceSet::iterator iter = _dont_forward_sources.find(source);
+    if (iter != _dont_forward_sources.end()) {
+	source_record = iter->second;
+	_dont_forward_sources.erase(iter);
+    } else {
+	source_record = new Mld6igmpSourceRecord(*this, source);
+    }
+    _do_forward_sources.insert(make_pair(source, source_record));
+
+    return (source_record);
+}
+
+/**
+ * Add the sources that are neither forwarded nor not forwarded to the
+ * sources that should be forwarded.
+ *
+ * @param sources the source addresses.
+ * @param timeval the timeout interval of the source timer of the
+ * added sources.
+ */
+void
+Mld6igmpGroupRecord::add_new_do_forward_sources(const set<IPvX>& sources,
+						const TimeVal& timeval)
+{
+    set<IPvX>::const_iterator iter;
+
+    for (iter = sources.begin(); iter != sources.end(); ++iter) {
+	const IPvX& ipvx = *iter;
+	if ((_do_forward_sources.find(ipvx) != _do_forward_sources.end())
+	    || (_dont_forward_sources.find(ipvx)
+		!= _dont_forward_sources.end())) {
+	    continue;
+	}
+	Mld6igmpSourceRecord* source_record;
+	source_record = new Mld6igmpSourceRecord(*this, ipvx);
+	_do_forward_sources.insert(make_pair(ipvx, source_record));
+	source_record->set_source_timer(timeval);
+    }
+}
+
+/**
+ * Add the sources that are not forwarded to the sources that should
+ * not be forwarded.
+ *
+ * @param sources the source addresses.
+ */
+void
+Mld6igmpGroupRecord::add_dont_forward_sources(const set<IPvX>& sources)
+{
+    set<IPvX>::const_iterator iter;
+
+    for (iter = sources.begin(); iter != sources.end(); ++iter) {
+	const IPvX& ipvx = *iter;
+	if ((_do_forward_sources.find(ipvx) != _do_forward_sources.end())
+	    || (_dont_forward_sources.find(ipvx)
+		!= _dont_forward_sources.end())) {
+	    continue;
+	}
+	Mld6igmpSourceRecord* source_record;
+	source_record = new Mld6igmpSourceRecord(*this, ipvx);
+	_dont_forward_sources.insert(make_pair(ipvx, source_record));
+    }
+}
+
 /**
  * Lower the group timer.
  *
@@ -23,9 +23,9 @@
 //
 
 
-#include <map>
 #include <set>
 
+#include "libxorp/hash_map.hh"
 #include "libxorp/ipvx.hh"
 #include "libxorp/timer.hh"
 
@@ -309,6 +309,36 @@ public:
     int		family() const { return _group.af(); }
 
 private:
+    /**
+     * Add a source that should be forwarded.
+     *
+     * If the source is not forwarded yet, then its record is transferred
+     * from the sources that should not be forwarded, or is created.
+     *
+     * @param source the source address.
+     * @return the corresponding source record (@ref Mld6igmpSourceRecord).
+     */
+    Mld6igmpSourceRecord* add_do_forward_source(const IPvX& source);
+
+    /**
+     * Add the sources that are neither forwarded nor not forwarded to the
+     * sources that should be forwarded.
+     *
+     * @param sources the source addresses.
+     * @param timeval the timeout interval of the source timer of the
+     * added sources.
+     */
+    void add_new_do_forward_sources(const set<IPvX>& sources,
+				    const TimeVal& timeval);
+
+    /**
+     * Add the sources that are not forwarded to the sources that should
+     * not be forwarded.
+     *
+     * @param sources the source addresses.
+     */
+    void add_dont_forward_sources(const set<IPvX>& sources);
+
     /**
      * Calculate the forwarding changes and notify the interested parties.
      *
@@ -366,7 +396,7 @@ private:
 /**
  * @short A class to store information about a set of multicast groups.
  */
-class Mld6igmpGroupSet : public map<IPvX, Mld6igmpGroupRecord *> {
+class Mld6igmpGroupSet : public HashMap<IPvX, Mld6igmpGroupRecord *> {
 public:
     /**
      * Constructor for a given vif.
@@ -52,6 +52,24 @@
 // Local functions prototypes
 //
 
+/**
+ * Get the records of a group or source set ordered by their address.
+ *
+ * @param records the group or source set.
+ * @return a map with the records ordered by their address.
+ */
+template <class S>
+static map<IPvX, typename S::mapped_type>
+sorted_records(const S& records)
+{
+    map<IPvX, typename S::mapped_type> result;
+    typename S::const_iterator iter;
+
+    for (iter = records.begin(); iter != records.end(); ++iter)
+	result.insert(make_pair(iter->first, iter->second));
+
+    return (result);
+}
 
 
 /**
@@ -350,12 +368,16 @@ Mld6igmpNodeCli::cli_show_mld6igmp_group(const vector<string>& argv)
 	const Mld6igmpVif *mld6igmp_vif = mld6igmp_node().vif_find_by_vif_index(i);
 	if (mld6igmp_vif == NULL)
 	    continue;
-	Mld6igmpGroupSet::const_iterator group_iter;
-	for (group_iter = mld6igmp_vif->group_records().begin();
-	     group_iter != mld6igmp_vif->group_records().end();
+	// XXX: print the groups and the sources in address order
+	map<IPvX, Mld6igmpGroupRecord *> group_records =
+	    sorted_records(mld6igmp_vif->group_records());
+	map<IPvX, Mld6igmpGroupRecord *>::const_iterator group_iter;
+	for (group_iter = group_records.begin();
+	     group_iter != group_records.end();
 	     ++group_iter) {
 	    const Mld6igmpGroupRecord *group_record = group_iter->second;
-	    Mld6igmpSourceSet::const_iterator source_iter;
+	    map<IPvX, Mld6igmpSourceRecord *> source_records;
+	    map<IPvX, Mld6igmpSourceRecord *>::const_iterator source_iter;
 	    int version = 0;
 	    string state;
 
@@ -425,8 +447,9 @@ Mld6igmpNodeCli::cli_show_mld6igmp_group(const vector<string>& argv)
 
 	    // Print the sources to forward
 	    state = "F";
-	    for (source_iter = group_record->do_forward_sources().begin();
-		 source_iter != group_record->do_forward_sources().end();
+	    source_records = sorted_records(group_record->do_forward_sources());
+	    for (source_iter = source_records.begin();
+		 source_iter != source_records.end();
 		 ++source_iter) {
 		const Mld6igmpSourceRecord *source_record = source_iter->second;
 		cli_print(c_format("%-12s %-15s %-15s %-12s %7d %1d %5s\n",
@@ -440,8 +463,9 @@ Mld6igmpNodeCli::cli_show_mld6igmp_group(const vector<string>& argv)
 
 	    // Print the sources not to forward
 	    state = "D";
-	    for (source_iter = group_record->dont_forward_sources().begin();
-		 source_iter != group_record->dont_forward_sources().end();
+	    source_records = sorted_records(group_record->dont_forward_sources());
+	    for (source_iter = source_records.begin();
+		 source_iter != source_records.end();
 		 ++source_iter) {
 		const Mld6igmpSourceRecord *source_record = source_iter->second;
 		cli_print(c_format("%-12s %-15s %-15s %-12s %7d %1d %5s\n",
@@ -210,6 +210,28 @@ Mld6igmpSourceSet::delete_payload_and_clear()
     this->clear();
 }
 
+/**
+ * Delete the source records whose address is not in a set of addresses,
+ * and remove them from the set.
+ *
+ * @param sources the set of source addresses to keep.
+ */
+void
+Mld6igmpSourceSet::delete_payload_not_in(const set<IPvX>& sources)
+{
+    Mld6igmpSourceSet::iterator iter;
+
+    for (iter = this->begin(); iter != this->end(); ) {
+	Mld6igmpSourceSet::iterator orig_iter = iter;
+	++iter;
+	if (sources.find(orig_iter->first) != sources.end())
+	    continue;
+	Mld6igmpSourceRecord* source_record = orig_iter->second;
+	this->erase(orig_iter);
+	delete source_record;
+    }
+}
+
 /**
  * Assignment operator for sets.
  *
@@ -512,3 +534,27 @@ Mld6igmpSourceSet::extract_source_addresses() const
 
     return (sources);
 }
+
+/**
+ * Extract the source addresses that are not in a set of addresses.
+ *
+ * @param sources the set of source addresses to exclude.
+ * @return the set with the source addresses that are not in @ref sources.
+ */
+set<IPvX>
+Mld6igmpSourceSet::extract_source_addresses_not_in(
+    const set<IPvX>& sources) const
+{
+    set<IPvX> result;
+    Mld6igmpSourceSet::const_iterator record_iter;
+
+    for (record_iter = this->begin();
+	 record_iter != this->end();
+	 ++record_iter) {
+	const IPvX& ipvx = record_iter->first;
+	if (sources.find(ipvx) == sources.end())
+	    result.insert(ipvx);
+    }
+
+    return (result);
+}
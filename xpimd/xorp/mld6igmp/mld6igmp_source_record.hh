@@ -23,9 +23,9 @@
 //
 
 
-#include <map>
 #include <set>
 
+#include "libxorp/hash_map.hh"
 #include "libxorp/ipvx.hh"
 #include "libxorp/timer.hh"
 
@@ -149,7 +149,7 @@ private:
 /**
  * @short A class to store information about a set of sources.
  */
-class Mld6igmpSourceSet : public map<IPvX, Mld6igmpSourceRecord *> {
+class Mld6igmpSourceSet : public HashMap<IPvX, Mld6igmpSourceRecord *> {
 public:
     /**
      * Constructor for a given group record.
@@ -177,6 +177,14 @@ public:
      */
     void delete_payload_and_clear();
 
+    /**
+     * Delete the source records whose address is not in a set of
+     * addresses, and remove them from the set.
+     *
+     * @param sources the set of source addresses to keep.
+     */
+    void delete_payload_not_in(const set<IPvX>& sources);
+
     /**
      * Assignment operator for sets.
      *
@@ -287,6 +295,15 @@ public:
      */
     set<IPvX> extract_source_addresses() const;
 
+    /**
+     * Extract the source addresses that are not in a set of addresses.
+     *
+     * @param sources the set of source addresses to exclude.
+     * @return the set with the source addresses that are not in
+     * @ref sources.
+     */
+    set<IPvX> extract_source_addresses_not_in(const set<IPvX>& sources) const;
+
 private:
     Mld6igmpGroupRecord& _group_record;	// The group record this set belongs to
 };
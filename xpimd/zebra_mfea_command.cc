@@ -17,6 +17,12 @@ extern "C" {
 #include "vty.h"
 }
 
+#ifndef STRINGIFY
+#define STRINGIFY(x) #x
+#endif	// STRINGIFY
+#ifndef XSTRINGIFY
+#define XSTRINGIFY(x) STRINGIFY(x)
+#endif	// XSTRINGIFY
 
 #ifndef VNL
 #define VNL VTY_NEWLINE
@@ -50,6 +56,12 @@ config_write_zmfea(struct vty *vty)
     if (_zmfea->MfeaNode::is_enabled())
     {
 	vty_out(vty, "router %s%s", _zmfea->zebra_protostr(), VNL);
+	if (_zmfea->mfea_mrouter().upcall_budget() !=
+	    MFEA_UPCALL_BUDGET_DEFAULT)
+	    vty_out(vty, " %s %s upcall-budget %u%s",
+		    _zmfea->zebra_ipstr(), _zmfea->zebra_protostr(),
+		    XORP_UINT_CAST(_zmfea->mfea_mrouter().upcall_budget()),
+		    VNL);
 	vty_out(vty, "!%s", VNL);
     }
 
@@ -118,6 +130,71 @@ ALIAS(no_router_mfea,
 
 #endif	// HAVE_IPV6_MULTICAST
 
+DEFUN(ip_mfea_upcall_budget,
+      ip_mfea_upcall_budget_cmd,
+      "ip mfea upcall-budget <1-" XSTRINGIFY(MFEA_UPCALL_BUDGET_MAX) ">",
+      IP_STR
+      ZMFEA_STR
+      "Maximum number of kernel upcalls read at once\n"
+      "Number of upcalls\n")
+{
+    XLOG_ASSERT(_zmfea != NULL);
+
+    string error_msg;
+    size_t budget = strtoul(argv[0], NULL, 10);
+    if (_zmfea->mfea_mrouter().set_upcall_budget(budget,
+						  error_msg) != XORP_OK)
+    {
+	vty_out(vty, "couldn't set upcall budget: %s%s",
+		error_msg.c_str(), VNL);
+	return CMD_WARNING;
+    }
+
+    return CMD_SUCCESS;
+}
+
+DEFUN(no_ip_mfea_upcall_budget,
+      no_ip_mfea_upcall_budget_cmd,
+      "no ip mfea upcall-budget",
+      NO_STR
+      IP_STR
+      ZMFEA_STR
+      "Maximum number of kernel upcalls read at once\n")
+{
+    XLOG_ASSERT(_zmfea != NULL);
+
+    string error_msg;
+    if (_zmfea->mfea_mrouter().set_upcall_budget(MFEA_UPCALL_BUDGET_DEFAULT,
+						  error_msg) != XORP_OK)
+    {
+	vty_out(vty, "couldn't reset upcall budget: %s%s",
+		error_msg.c_str(), VNL);
+	return CMD_WARNING;
+    }
+
+    return CMD_SUCCESS;
+}
+
+#ifdef HAVE_IPV6_MULTICAST
+
+ALIAS(ip_mfea_upcall_budget,
+      ipv6_mfea6_upcall_budget_cmd,
+      "ipv6 mfea6 upcall-budget <1-" XSTRINGIFY(MFEA_UPCALL_BUDGET_MAX) ">",
+      IP6_STR
+      ZMFEA6_STR
+      "Maximum number of kernel upcalls read at once\n"
+      "Number of upcalls\n");
+
+ALIAS(no_ip_mfea_upcall_budget,
+      no_ipv6_mfea6_upcall_budget_cmd,
+      "no ipv6 mfea6 upcall-budget",
+      NO_STR
+      IP6_STR
+      ZMFEA6_STR
+      "Maximum number of kernel upcalls read at once\n");
+
+#endif	// HAVE_IPV6_MULTICAST
+
 // zmfea interface configuration write
 int
 ZebraMfeaNode::zebra_config_write_interface(struct vty *vty)
@@ -430,6 +507,33 @@ ALIAS(show_ip_mfea_interface_address,
 
 #endif	// HAVE_IPV6_MULTICAST
 
+DEFUN(show_ip_mfea_upcalls,
+      show_ip_mfea_upcalls_cmd,
+      "show ip mfea upcalls",
+      SHOW_STR
+      IP_STR
+      ZMFEA_STR
+      "Kernel upcall information\n")
+{
+    XLOG_ASSERT(_zmfea != NULL);
+
+    return cli_process_command(_zmfea, string("show ") +
+			       _zmfea->xorp_protostr() + string(" upcalls"),
+			       "", vty);
+}
+
+#ifdef HAVE_IPV6_MULTICAST
+
+ALIAS(show_ip_mfea_upcalls,
+      show_ipv6_mfea6_upcalls_cmd,
+      "show ipv6 mfea6 upcalls",
+      SHOW_STR
+      IP6_STR
+      ZMFEA6_STR
+      "Kernel upcall information\n");
+
+#endif	// HAVE_IPV6_MULTICAST
+
 void
 ZebraMfeaNode::zebra_command_init()
 {
@@ -446,12 +550,16 @@ ZebraMfeaNode::zebra_command_init()
     {
 	install_element(CONFIG_NODE, &router_mfea_cmd);
 	install_element(CONFIG_NODE, &no_router_mfea_cmd);
+	install_element(MFEA_NODE, &ip_mfea_upcall_budget_cmd);
+	install_element(MFEA_NODE, &no_ip_mfea_upcall_budget_cmd);
     }
 #ifdef HAVE_IPV6_MULTICAST
     else if (MfeaNode::family() == AF_INET6)
     {
 	install_element(CONFIG_NODE, &router_mfea6_cmd);
 	install_element(CONFIG_NODE, &no_router_mfea6_cmd);
+	install_element(MFEA_NODE, &ipv6_mfea6_upcall_budget_cmd);
+	install_element(MFEA_NODE, &no_ipv6_mfea6_upcall_budget_cmd);
     }
 #endif	// HAVE_IPV6_MULTICAST
     else
@@ -505,6 +613,7 @@ ZebraMfeaNode::zebra_command_init()
 	ADD_SHOW_CMD(show_ip_mfea_dataflow_cmd);
 	ADD_SHOW_CMD(show_ip_mfea_interface_cmd);
 	ADD_SHOW_CMD(show_ip_mfea_interface_address_cmd);
+	ADD_SHOW_CMD(show_ip_mfea_upcalls_cmd);
     }
 #ifdef HAVE_IPV6_MULTICAST
     else if (MfeaNode::family() == AF_INET6)
@@ -512,6 +621,7 @@ ZebraMfeaNode::zebra_command_init()
 	ADD_SHOW_CMD(show_ipv6_mfea6_dataflow_cmd);
 	ADD_SHOW_CMD(show_ipv6_mfea6_interface_cmd);
 	ADD_SHOW_CMD(show_ipv6_mfea6_interface_address_cmd);
+	ADD_SHOW_CMD(show_ipv6_mfea6_upcalls_cmd);
     }
 #endif	// HAVE_IPV6_MULTICAST
     else
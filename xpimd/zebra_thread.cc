@@ -12,6 +12,55 @@
 #include "zebra_thread.hh"
 #include "zebra_router.hh"
 
+//
+// Freelist of ZthreadCb objects.  Each slot fits any of the callback
+// classes; slots are carved out of slabs that are never given back.
+//
+union ZthreadCbSlot {
+    ZthreadCbSlot *next;
+    char event[sizeof(ZthreadEventCb)];
+    char timer[sizeof(ZthreadTimerCb)];
+    char ioevent[sizeof(ZthreadIOEventCb)];
+    double align_double;
+    long long align_longlong;
+};
+
+#define ZTHREAD_CB_SLAB 64
+
+static ZthreadCbSlot *zthread_cb_free = NULL;
+
+void *
+ZthreadCb::operator new(size_t size)
+{
+    ZthreadCbSlot *slot;
+
+    XLOG_ASSERT(size <= sizeof(ZthreadCbSlot));
+
+    if (zthread_cb_free == NULL) {
+	slot = static_cast<ZthreadCbSlot *>
+	    (::operator new(ZTHREAD_CB_SLAB * sizeof(ZthreadCbSlot)));
+	for (int i = 0; i < ZTHREAD_CB_SLAB; i++) {
+	    slot[i].next = zthread_cb_free;
+	    zthread_cb_free = &slot[i];
+	}
+    }
+
+    slot = zthread_cb_free;
+    zthread_cb_free = slot->next;
+    return slot;
+}
+
+void
+ZthreadCb::operator delete(void *p)
+{
+    ZthreadCbSlot *slot = static_cast<ZthreadCbSlot *>(p);
+
+    if (slot == NULL)
+	return;
+    slot->next = zthread_cb_free;
+    zthread_cb_free = slot;
+}
+
 struct thread *
 funcname_thread_add_read(struct thread_master *m, zthread_func_t func,
 			 void *arg, int fd, const char *funcname)
@@ -104,6 +153,9 @@ thread_timer_remain_second(struct thread *thread)
 int
 thread_should_yield(struct thread *thread)
 {
-    XLOG_UNREACHABLE();		// XXX
-    return 0;
+    struct timeval now;
+
+    quagga_gettime(QUAGGA_CLK_MONOTONIC, &now);
+    return ((now.tv_sec - thread->ru.real.tv_sec) * 1000000L +
+	    (now.tv_usec - thread->ru.real.tv_usec) > THREAD_YIELD_TIME_SLOT);
 }
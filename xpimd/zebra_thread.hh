@@ -51,10 +51,17 @@ public:
 
     virtual ~ZthreadCb() {}
 
+    // one of these comes and goes with every packet, timer and event,
+    // so they are recycled through a freelist
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     struct thread *thread() {return &_thread;}
 
     void cbdelete()
     {
+	// for thread_should_yield()
+	quagga_gettime(QUAGGA_CLK_MONOTONIC, &_thread.ru.real);
 	_thread.func(&_thread);
 	delete this;
     }
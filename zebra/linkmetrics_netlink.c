@@ -370,7 +370,7 @@ lmgenl_datarate (uint16_t rate, uint8_t units)
  * Description:
  * ============
  * Parse a link metrics generic netlink message and call
- * zserv_send_linkmetrics() to process the update.
+ * zserv_queue_linkmetrics() to process the update.
  *
  * Input parameters:
  * ================
@@ -496,7 +496,7 @@ lmgenl_recv_metrics (struct nlmsghdr *nlh)
   if (IS_ZEBRA_DEBUG_KERNEL)
     zebra_linkmetrics_logdebug (&metrics);
 
-  zserv_send_linkmetrics (&metrics, NULL);
+  zserv_queue_linkmetrics (&metrics, NULL);
 
   return 0;
 }
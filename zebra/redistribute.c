@@ -153,7 +153,8 @@ zebra_redistribute (struct zserv *client, int type)
 	    && newrib->type == type 
 	    && newrib->distance != DISTANCE_INFINITY
 	    && zebra_check_addr (&rn->p))
-	  zsend_route_multipath (ZEBRA_IPV4_ROUTE_ADD, client, &rn->p, newrib);
+	  zsend_route_multipath_bulk (ZEBRA_IPV4_ROUTE_ADD, client, &rn->p,
+	                              newrib);
   
 #ifdef HAVE_IPV6
   table = vrf_table (AFI_IP6, SAFI_UNICAST, 0);
@@ -164,8 +165,11 @@ zebra_redistribute (struct zserv *client, int type)
 	    && newrib->type == type 
 	    && newrib->distance != DISTANCE_INFINITY
 	    && zebra_check_addr (&rn->p))
-	  zsend_route_multipath (ZEBRA_IPV6_ROUTE_ADD, client, &rn->p, newrib);
+	  zsend_route_multipath_bulk (ZEBRA_IPV6_ROUTE_ADD, client, &rn->p,
+	                              newrib);
 #endif /* HAVE_IPV6 */
+
+  zsend_route_bulk_flush (client);
 }
 
 void
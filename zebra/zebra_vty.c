@@ -806,6 +806,61 @@ vty_show_ip_route (struct vty *vty, struct route_node *rn, struct rib *rib)
     }
 }
 
+/* "show ip route" and "show ipv6 route" stream their output, walking
+   the table a few nodes at a time, see vty_walk (). */
+struct show_route_walk
+{
+  struct route_node *rn;
+  int first;
+};
+
+#define SHOW_ROUTE_WALK_NODES 64
+
+static void
+show_route_walk_free (void *arg)
+{
+  struct show_route_walk *walk = arg;
+
+  if (walk->rn)
+    route_unlock_node (walk->rn);
+  XFREE (MTYPE_TMP, walk);
+}
+
+static int
+show_route_walk_start (struct vty *vty, struct route_table *table,
+		       int (*func) (struct vty *, void *))
+{
+  struct show_route_walk *walk;
+
+  walk = XCALLOC (MTYPE_TMP, sizeof (struct show_route_walk));
+  walk->rn = route_top (table);
+  walk->first = 1;
+
+  return vty_walk (vty, func, show_route_walk_free, walk);
+}
+
+static int
+show_ip_route_walk (struct vty *vty, void *arg)
+{
+  struct show_route_walk *walk = arg;
+  struct rib *rib;
+  int n;
+
+  for (n = 0; walk->rn && n < SHOW_ROUTE_WALK_NODES;
+       n++, walk->rn = route_next (walk->rn))
+    for (rib = walk->rn->info; rib; rib = rib->next)
+      {
+	if (walk->first)
+	  {
+	    vty_out (vty, SHOW_ROUTE_V4_HEADER);
+	    walk->first = 0;
+	  }
+	vty_show_ip_route (vty, walk->rn, rib);
+      }
+
+  return (walk->rn != NULL);
+}
+
 DEFUN (show_ip_route,
        show_ip_route_cmd,
        "show ip route",
@@ -814,26 +869,13 @@ DEFUN (show_ip_route,
        "IP routing table\n")
 {
   struct route_table *table;
-  struct route_node *rn;
-  struct rib *rib;
-  int first = 1;
 
   table = vrf_table (AFI_IP, SAFI_UNICAST, 0);
   if (! table)
     return CMD_SUCCESS;
 
   /* Show all IPv4 routes. */
-  for (rn = route_top (table); rn; rn = route_next (rn))
-    for (rib = rn->info; rib; rib = rib->next)
-      {
-	if (first)
-	  {
-	    vty_out (vty, SHOW_ROUTE_V4_HEADER);
-	    first = 0;
-	  }
-	vty_show_ip_route (vty, rn, rib);
-      }
-  return CMD_SUCCESS;
+  return show_route_walk_start (vty, table, show_ip_route_walk);
 }
 
 DEFUN (show_ip_route_prefix_longer,
@@ -1745,6 +1787,28 @@ vty_show_ipv6_route (struct vty *vty, struct route_node *rn,
     }
 }
 
+static int
+show_ipv6_route_walk (struct vty *vty, void *arg)
+{
+  struct show_route_walk *walk = arg;
+  struct rib *rib;
+  int n;
+
+  for (n = 0; walk->rn && n < SHOW_ROUTE_WALK_NODES;
+       n++, walk->rn = route_next (walk->rn))
+    for (rib = walk->rn->info; rib; rib = rib->next)
+      {
+	if (walk->first)
+	  {
+	    vty_out (vty, SHOW_ROUTE_V6_HEADER);
+	    walk->first = 0;
+	  }
+	vty_show_ipv6_route (vty, walk->rn, rib);
+      }
+
+  return (walk->rn != NULL);
+}
+
 DEFUN (show_ipv6_route,
        show_ipv6_route_cmd,
        "show ipv6 route",
@@ -1753,26 +1817,13 @@ DEFUN (show_ipv6_route,
        "IPv6 routing table\n")
 {
   struct route_table *table;
-  struct route_node *rn;
-  struct rib *rib;
-  int first = 1;
 
   table = vrf_table (AFI_IP6, SAFI_UNICAST, 0);
   if (! table)
     return CMD_SUCCESS;
 
   /* Show all IPv6 route. */
-  for (rn = route_top (table); rn; rn = route_next (rn))
-    for (rib = rn->info; rib; rib = rib->next)
-      {
-	if (first)
-	  {
-	    vty_out (vty, SHOW_ROUTE_V6_HEADER);
-	    first = 0;
-	  }
-	vty_show_ipv6_route (vty, rn, rib);
-      }
-  return CMD_SUCCESS;
+  return show_route_walk_start (vty, table, show_ipv6_route_walk);
 }
 
 DEFUN (show_ipv6_route_prefix_longer,
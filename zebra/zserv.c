@@ -54,6 +54,7 @@ static void zebra_event (enum event event, int sock, struct zserv *client);
 extern struct zebra_privs_t zserv_privs;
 
 static void zebra_client_close (struct zserv *client);
+static int zebra_client_read_resume (struct thread *thread);
 
 static int
 zserv_delayed_close(struct thread *thread)
@@ -102,13 +103,13 @@ zserv_flush_data(struct thread *thread)
   return 0;
 }
 
-int
-zebra_server_send_message(struct zserv *client)
+static int
+zserv_send_stream(struct zserv *client, struct stream *s)
 {
   if (client->t_suicide)
     return -1;
-  switch (buffer_write(client->wb, client->sock, STREAM_DATA(client->obuf),
-		       stream_get_endp(client->obuf)))
+  switch (buffer_write(client->wb, client->sock, STREAM_DATA(s),
+		       stream_get_endp(s)))
     {
     case BUFFER_ERROR:
       zlog_warn("%s: buffer_write failed to zserv client fd %d, closing",
@@ -131,6 +132,12 @@ zebra_server_send_message(struct zserv *client)
   return 0;
 }
 
+int
+zebra_server_send_message(struct zserv *client)
+{
+  return zserv_send_stream (client, client->obuf);
+}
+
 static void
 zserv_create_header (struct stream *s, uint16_t cmd)
 {
@@ -349,34 +356,15 @@ zsend_interface_update (int cmd, struct zserv *client, struct interface *ifp)
  * zapi_ipv{4,6}_{add, delete} should be re-written to avoid code
  * duplication.
  */
-int
-zsend_route_multipath (int cmd, struct zserv *client, struct prefix *p,
-                       struct rib *rib)
+ /* Encode the part of the message following the prefix and return
+  * the message flags describing it. */
+static u_char
+zserv_encode_route_nexthops (struct stream *s, int cmd, struct rib *rib)
 {
-  int psize;
-  struct stream *s;
   struct nexthop *nexthop;
-  unsigned long nhnummark = 0, messmark = 0;
+  unsigned long nhnummark = 0;
   int nhnum = 0;
   u_char zapi_flags = 0;
-  
-  s = client->obuf;
-  stream_reset (s);
-  
-  zserv_create_header (s, cmd);
-  
-  /* Put type and nexthop. */
-  stream_putc (s, rib->type);
-  stream_putc (s, rib->flags);
-  
-  /* marker for message flags field */
-  messmark = stream_get_endp (s);
-  stream_putc (s, 0);
-
-  /* Prefix. */
-  psize = PSIZE (p->prefixlen);
-  stream_putc (s, p->prefixlen);
-  stream_write (s, (u_char *) & p->u.prefix, psize);
 
   /* 
    * XXX The message format sent by zebra below does not match the format
@@ -449,12 +437,44 @@ zsend_route_multipath (int cmd, struct zserv *client, struct prefix *p,
       stream_putl (s, rib->metric);
     }
   
-  /* write real message flags value */
-  stream_putc_at (s, messmark, zapi_flags);
-  
   /* Write next-hop number */
   if (nhnummark)
     stream_putc_at (s, nhnummark, nhnum);
+
+  return zapi_flags;
+}
+
+int
+zsend_route_multipath (int cmd, struct zserv *client, struct prefix *p,
+                       struct rib *rib)
+{
+  int psize;
+  struct stream *s;
+  unsigned long messmark = 0;
+  u_char zapi_flags;
+  
+  s = client->obuf;
+  stream_reset (s);
+  
+  zserv_create_header (s, cmd);
+  
+  /* Put type and nexthop. */
+  stream_putc (s, rib->type);
+  stream_putc (s, rib->flags);
+  
+  /* marker for message flags field */
+  messmark = stream_get_endp (s);
+  stream_putc (s, 0);
+
+  /* Prefix. */
+  psize = PSIZE (p->prefixlen);
+  stream_putc (s, p->prefixlen);
+  stream_write (s, (u_char *) & p->u.prefix, psize);
+
+  zapi_flags = zserv_encode_route_nexthops (s, cmd, rib);
+  
+  /* write real message flags value */
+  stream_putc_at (s, messmark, zapi_flags);
   
   /* Write packet size. */
   stream_putw_at (s, 0, stream_get_endp (s));
@@ -462,6 +482,113 @@ zsend_route_multipath (int cmd, struct zserv *client, struct prefix *p,
   return zebra_server_send_message(client);
 }
 
+/* Offsets of the fields shared by all prefixes of a bulk route message,
+ * see zapi_ipv4_route_bulk(). */
+#define ZSERV_BULK_CMD_OFFSET     4
+#define ZSERV_BULK_TYPE_OFFSET    (ZEBRA_HEADER_SIZE)
+#define ZSERV_BULK_FLAGS_OFFSET   (ZEBRA_HEADER_SIZE + 1)
+#define ZSERV_BULK_MSG_OFFSET     (ZEBRA_HEADER_SIZE + 2)
+#define ZSERV_BULK_COUNT_OFFSET   (ZEBRA_HEADER_SIZE + 5)
+
+/* Send the bulk route message pending for client, if any. */
+int
+zsend_route_bulk_flush (struct zserv *client)
+{
+  struct stream *s = client->bulk;
+
+  if (! client->bulk_count)
+    return 0;
+
+  stream_putw_at (s, ZSERV_BULK_COUNT_OFFSET, client->bulk_count);
+  stream_write (s, STREAM_DATA (client->bulk_tail),
+                stream_get_endp (client->bulk_tail));
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  client->bulk_count = 0;
+  return zserv_send_stream (client, s);
+}
+
+/*
+ * Like zsend_route_multipath(), but consecutive routes that share type,
+ * flags and nexthops are packed into one ZEBRA_IPV{4,6}_ROUTE_BULK_*
+ * message for clients that negotiated ZEBRA_CAPABILITY_BULK_ROUTE.
+ * The caller must call zsend_route_bulk_flush() once its walk is done.
+ */
+int
+zsend_route_multipath_bulk (int cmd, struct zserv *client, struct prefix *p,
+                            struct rib *rib)
+{
+  struct stream *s, *tail;
+  int bulk_cmd, psize;
+  u_char zapi_flags;
+
+  if (! CHECK_FLAG (client->capabilities, ZEBRA_CAPABILITY_BULK_ROUTE))
+    return zsend_route_multipath (cmd, client, p, rib);
+
+  switch (cmd)
+    {
+    case ZEBRA_IPV4_ROUTE_ADD:
+      bulk_cmd = ZEBRA_IPV4_ROUTE_BULK_ADD;
+      break;
+    case ZEBRA_IPV4_ROUTE_DELETE:
+      bulk_cmd = ZEBRA_IPV4_ROUTE_BULK_DELETE;
+      break;
+    case ZEBRA_IPV6_ROUTE_ADD:
+      bulk_cmd = ZEBRA_IPV6_ROUTE_BULK_ADD;
+      break;
+    case ZEBRA_IPV6_ROUTE_DELETE:
+      bulk_cmd = ZEBRA_IPV6_ROUTE_BULK_DELETE;
+      break;
+    default:
+      return zsend_route_multipath (cmd, client, p, rib);
+    }
+
+  /* Encode this route's nexthop part, using obuf as scratch. */
+  tail = client->obuf;
+  stream_reset (tail);
+  zapi_flags = zserv_encode_route_nexthops (tail, cmd, rib);
+
+  s = client->bulk;
+  psize = PSIZE (p->prefixlen);
+
+  /* Can the route join the pending message? */
+  if (client->bulk_count
+      && (stream_getw_from (s, ZSERV_BULK_CMD_OFFSET) != bulk_cmd
+          || stream_getc_from (s, ZSERV_BULK_TYPE_OFFSET) != rib->type
+          || stream_getc_from (s, ZSERV_BULK_FLAGS_OFFSET) != rib->flags
+          || stream_getc_from (s, ZSERV_BULK_MSG_OFFSET) != zapi_flags
+          || stream_get_endp (client->bulk_tail) != stream_get_endp (tail)
+          || memcmp (STREAM_DATA (client->bulk_tail), STREAM_DATA (tail),
+                     stream_get_endp (tail))
+          || client->bulk_count == UINT16_MAX
+          || STREAM_WRITEABLE (s) < 1 + psize + stream_get_endp (tail)))
+    {
+      if (zsend_route_bulk_flush (client) < 0)
+        return -1;
+    }
+
+  if (! client->bulk_count)
+    {
+      stream_reset (s);
+      zserv_create_header (s, bulk_cmd);
+      stream_putc (s, rib->type);
+      stream_putc (s, rib->flags);
+      stream_putc (s, zapi_flags);
+      stream_putw (s, SAFI_UNICAST);
+      stream_putw (s, 0);
+
+      stream_reset (client->bulk_tail);
+      stream_write (client->bulk_tail, STREAM_DATA (tail),
+                    stream_get_endp (tail));
+    }
+
+  stream_putc (s, p->prefixlen);
+  stream_write (s, (u_char *) &p->u.prefix, psize);
+  client->bulk_count++;
+
+  return 0;
+}
+
 #ifdef HAVE_IPV6
 static int
 zsend_ipv6_nexthop_lookup (struct zserv *client, struct in6_addr *addr)
@@ -713,26 +840,60 @@ zread_interface_delete (struct zserv *client, u_short length)
   return 0;
 }
 
+/* Route type, flags, message flags and SAFI, which lead every route
+ * message and are shared by all prefixes of a bulk route message. */
+struct zread_route_hdr
+{
+  u_char type;
+  u_char flags;
+  u_char message;
+  safi_t safi;
+};
+
+static void
+zread_route_hdr (struct stream *s, struct zread_route_hdr *hdr)
+{
+  hdr->type = stream_getc (s);
+  hdr->flags = stream_getc (s);
+  hdr->message = stream_getc (s);
+  hdr->safi = stream_getw (s);
+}
+
+/* Read a prefix of the given family; returns -1 on an invalid length. */
+static int
+zread_route_prefix (struct stream *s, int family, struct prefix *p)
+{
+  memset (p, 0, sizeof (struct prefix));
+  p->family = family;
+  p->prefixlen = stream_getc (s);
+  if (p->prefixlen > prefix_blen (p) * 8)
+    {
+      zlog_warn ("%s: invalid %s prefixlen: %d", __func__,
+                 family == AF_INET ? "ipv4" : "ipv6", p->prefixlen);
+      return -1;
+    }
+  stream_get (&p->u.prefix, s, PSIZE (p->prefixlen));
+  return 0;
+}
+
 /* This function support multiple nexthop. */
 /* 
- * Parse the ZEBRA_IPV4_ROUTE_ADD sent from client. Update rib and
- * add kernel route. 
+ * Parse the nexthops, distance and metric of a ZEBRA_IPV4_ROUTE_ADD
+ * (or ZEBRA_IPV4_ROUTE_BULK_ADD) sent from client for prefix p. Update
+ * rib and add kernel route.
  */
 static int
-zread_ipv4_add (struct zserv *client, u_short length)
+zread_ipv4_add_route (struct zserv *client, struct zread_route_hdr *hdr,
+                      struct prefix_ipv4 *p)
 {
   int i;
   struct rib *rib;
-  struct prefix_ipv4 p;
-  u_char message;
   struct in_addr nexthop;
   u_char nexthop_num;
   u_char nexthop_type;
   struct stream *s;
   unsigned int ifindex;
   u_char ifname_len;
-  safi_t safi;	
-
 
   /* Get input stream.  */
   s = client->ibuf;
@@ -740,27 +901,13 @@ zread_ipv4_add (struct zserv *client, u_short length)
   /* Allocate new rib. */
   rib = XCALLOC (MTYPE_RIB, sizeof (struct rib));
   
-  /* Type, flags, message. */
-  rib->type = stream_getc (s);
-  rib->flags = stream_getc (s);
-  message = stream_getc (s); 
-  safi = stream_getw (s);
+  /* Type, flags. */
+  rib->type = hdr->type;
+  rib->flags = hdr->flags;
   rib->uptime = time (NULL);
 
-  /* IPv4 prefix. */
-  memset (&p, 0, sizeof (struct prefix_ipv4));
-  p.family = AF_INET;
-  p.prefixlen = stream_getc (s);
-  if (p.prefixlen > IPV4_MAX_PREFIXLEN)
-    {
-      zlog_warn ("%s: invalid ipv4 prefixlen: %d", __func__, p.prefixlen);
-      XFREE (MTYPE_RIB, rib);
-      return -1;
-    }
-  stream_get (&p.prefix, s, PSIZE (p.prefixlen));
-
   /* Nexthop parse. */
-  if (CHECK_FLAG (message, ZAPI_MESSAGE_NEXTHOP))
+  if (CHECK_FLAG (hdr->message, ZAPI_MESSAGE_NEXTHOP))
     {
       nexthop_num = stream_getc (s);
 
@@ -798,29 +945,43 @@ zread_ipv4_add (struct zserv *client, u_short length)
     }
 
   /* Distance. */
-  if (CHECK_FLAG (message, ZAPI_MESSAGE_DISTANCE))
+  if (CHECK_FLAG (hdr->message, ZAPI_MESSAGE_DISTANCE))
     rib->distance = stream_getc (s);
 
   /* Metric. */
-  if (CHECK_FLAG (message, ZAPI_MESSAGE_METRIC))
+  if (CHECK_FLAG (hdr->message, ZAPI_MESSAGE_METRIC))
     rib->metric = stream_getl (s);
     
   /* Table */
   rib->table=zebrad.rtm_table_default;
-  rib_add_ipv4_multipath (&p, rib, safi);
+  rib_add_ipv4_multipath (p, rib, hdr->safi);
   return 0;
 }
 
+/* Parse the ZEBRA_IPV4_ROUTE_ADD sent from client. */
+static int
+zread_ipv4_add (struct zserv *client, u_short length)
+{
+  struct zread_route_hdr hdr;
+  struct prefix p;
+
+  zread_route_hdr (client->ibuf, &hdr);
+  if (zread_route_prefix (client->ibuf, AF_INET, &p) < 0)
+    return -1;
+
+  return zread_ipv4_add_route (client, &hdr, (struct prefix_ipv4 *) &p);
+}
+
 /* Zebra server IPv4 prefix delete function. */
 static int
-zread_ipv4_delete (struct zserv *client, u_short length)
+zread_ipv4_delete_route (struct zserv *client, struct zread_route_hdr *hdr,
+                         struct prefix_ipv4 *p)
 {
   int i;
   struct stream *s;
   struct zapi_ipv4 api;
   struct in_addr nexthop, *nexthop_p;
   unsigned long ifindex;
-  struct prefix_ipv4 p;
   u_char nexthop_num;
   u_char nexthop_type;
   u_char ifname_len;
@@ -831,21 +992,10 @@ zread_ipv4_delete (struct zserv *client, u_short length)
   nexthop_p = NULL;
 
   /* Type, flags, message. */
-  api.type = stream_getc (s);
-  api.flags = stream_getc (s);
-  api.message = stream_getc (s);
-  api.safi = stream_getw (s);
-
-  /* IPv4 prefix. */
-  memset (&p, 0, sizeof (struct prefix_ipv4));
-  p.family = AF_INET;
-  p.prefixlen = stream_getc (s);
-  if (p.prefixlen > IPV4_MAX_PREFIXLEN)
-    {
-      zlog_warn ("%s: invalid ipv4 prefixlen: %d", __func__, p.prefixlen);
-      return -1;
-    }
-  stream_get (&p.prefix, s, PSIZE (p.prefixlen));
+  api.type = hdr->type;
+  api.flags = hdr->flags;
+  api.message = hdr->message;
+  api.safi = hdr->safi;
 
   /* Nexthop, ifindex, distance, metric. */
   if (CHECK_FLAG (api.message, ZAPI_MESSAGE_NEXTHOP))
@@ -892,11 +1042,24 @@ zread_ipv4_delete (struct zserv *client, u_short length)
   else
     api.metric = 0;
     
-  rib_delete_ipv4 (api.type, api.flags, &p, nexthop_p, ifindex,
+  rib_delete_ipv4 (api.type, api.flags, p, nexthop_p, ifindex,
 		   client->rtm_table, api.safi);
   return 0;
 }
 
+static int
+zread_ipv4_delete (struct zserv *client, u_short length)
+{
+  struct zread_route_hdr hdr;
+  struct prefix p;
+
+  zread_route_hdr (client->ibuf, &hdr);
+  if (zread_route_prefix (client->ibuf, AF_INET, &p) < 0)
+    return -1;
+
+  return zread_ipv4_delete_route (client, &hdr, (struct prefix_ipv4 *) &p);
+}
+
 /* Nexthop lookup for IPv4. */
 static int
 zread_ipv4_nexthop_lookup (struct zserv *client, u_short length)
@@ -923,35 +1086,24 @@ zread_ipv4_import_lookup (struct zserv *client, u_short length)
 #ifdef HAVE_IPV6
 /* Zebra server IPv6 prefix add function. */
 static int
-zread_ipv6_add (struct zserv *client, u_short length)
+zread_ipv6_add_route (struct zserv *client, struct zread_route_hdr *hdr,
+                      struct prefix_ipv6 *p)
 {
   int i;
   struct stream *s;
   struct zapi_ipv6 api;
   struct in6_addr nexthop;
   unsigned long ifindex;
-  struct prefix_ipv6 p;
   
   s = client->ibuf;
   ifindex = 0;
   memset (&nexthop, 0, sizeof (struct in6_addr));
 
   /* Type, flags, message. */
-  api.type = stream_getc (s);
-  api.flags = stream_getc (s);
-  api.message = stream_getc (s);
-  api.safi = stream_getw (s);
-
-  /* IPv4 prefix. */
-  memset (&p, 0, sizeof (struct prefix_ipv6));
-  p.family = AF_INET6;
-  p.prefixlen = stream_getc (s);
-  if (p.prefixlen > IPV6_MAX_PREFIXLEN)
-    {
-      zlog_warn ("%s: invalid ipv6 prefixlen: %d", __func__, p.prefixlen);
-      return -1;
-    }
-  stream_get (&p.prefix, s, PSIZE (p.prefixlen));
+  api.type = hdr->type;
+  api.flags = hdr->flags;
+  api.message = hdr->message;
+  api.safi = hdr->safi;
 
   /* Nexthop, ifindex, distance, metric. */
   if (CHECK_FLAG (api.message, ZAPI_MESSAGE_NEXTHOP))
@@ -990,45 +1142,47 @@ zread_ipv6_add (struct zserv *client, u_short length)
     api.metric = 0;
     
   if (IN6_IS_ADDR_UNSPECIFIED (&nexthop))
-    rib_add_ipv6 (api.type, api.flags, &p, NULL, ifindex, zebrad.rtm_table_default, api.metric,
+    rib_add_ipv6 (api.type, api.flags, p, NULL, ifindex, zebrad.rtm_table_default, api.metric,
 		  api.distance, api.safi);
   else
-    rib_add_ipv6 (api.type, api.flags, &p, &nexthop, ifindex, zebrad.rtm_table_default, api.metric,
+    rib_add_ipv6 (api.type, api.flags, p, &nexthop, ifindex, zebrad.rtm_table_default, api.metric,
 		  api.distance, api.safi);
   return 0;
 }
 
+static int
+zread_ipv6_add (struct zserv *client, u_short length)
+{
+  struct zread_route_hdr hdr;
+  struct prefix p;
+
+  zread_route_hdr (client->ibuf, &hdr);
+  if (zread_route_prefix (client->ibuf, AF_INET6, &p) < 0)
+    return -1;
+
+  return zread_ipv6_add_route (client, &hdr, (struct prefix_ipv6 *) &p);
+}
+
 /* Zebra server IPv6 prefix delete function. */
 static int
-zread_ipv6_delete (struct zserv *client, u_short length)
+zread_ipv6_delete_route (struct zserv *client, struct zread_route_hdr *hdr,
+                         struct prefix_ipv6 *p)
 {
   int i;
   struct stream *s;
   struct zapi_ipv6 api;
   struct in6_addr nexthop;
   unsigned long ifindex;
-  struct prefix_ipv6 p;
   
   s = client->ibuf;
   ifindex = 0;
   memset (&nexthop, 0, sizeof (struct in6_addr));
 
   /* Type, flags, message. */
-  api.type = stream_getc (s);
-  api.flags = stream_getc (s);
-  api.message = stream_getc (s);
-  api.safi = stream_getw (s);
-
-  /* IPv4 prefix. */
-  memset (&p, 0, sizeof (struct prefix_ipv6));
-  p.family = AF_INET6;
-  p.prefixlen = stream_getc (s);
-  if (p.prefixlen > IPV6_MAX_PREFIXLEN)
-    {
-      zlog_warn ("%s: invalid ipv6 prefixlen: %d", __func__, p.prefixlen);
-      return -1;
-    }
-  stream_get (&p.prefix, s, PSIZE (p.prefixlen));
+  api.type = hdr->type;
+  api.flags = hdr->flags;
+  api.message = hdr->message;
+  api.safi = hdr->safi;
 
   /* Nexthop, ifindex, distance, metric. */
   if (CHECK_FLAG (api.message, ZAPI_MESSAGE_NEXTHOP))
@@ -1066,12 +1220,25 @@ zread_ipv6_delete (struct zserv *client, u_short length)
     api.metric = 0;
     
   if (IN6_IS_ADDR_UNSPECIFIED (&nexthop))
-    rib_delete_ipv6 (api.type, api.flags, &p, NULL, ifindex, client->rtm_table, api.safi);
+    rib_delete_ipv6 (api.type, api.flags, p, NULL, ifindex, client->rtm_table, api.safi);
   else
-    rib_delete_ipv6 (api.type, api.flags, &p, &nexthop, ifindex, client->rtm_table, api.safi);
+    rib_delete_ipv6 (api.type, api.flags, p, &nexthop, ifindex, client->rtm_table, api.safi);
   return 0;
 }
 
+static int
+zread_ipv6_delete (struct zserv *client, u_short length)
+{
+  struct zread_route_hdr hdr;
+  struct prefix p;
+
+  zread_route_hdr (client->ibuf, &hdr);
+  if (zread_route_prefix (client->ibuf, AF_INET6, &p) < 0)
+    return -1;
+
+  return zread_ipv6_delete_route (client, &hdr, (struct prefix_ipv6 *) &p);
+}
+
 static int
 zread_ipv6_nexthop_lookup (struct zserv *client, u_short length)
 {
@@ -1085,6 +1252,93 @@ zread_ipv6_nexthop_lookup (struct zserv *client, u_short length)
 }
 #endif /* HAVE_IPV6 */
 
+/* Parse a ZEBRA_IPV{4,6}_ROUTE_BULK_{ADD,DELETE} sent from client: a
+ * vector of prefixes sharing one set of nexthops, distance and metric
+ * (see zapi_ipv4_route_bulk).  Each prefix is processed exactly as if it
+ * had arrived in its own single-route message. */
+static int
+zread_route_bulk (struct zserv *client, uint16_t command, u_short length)
+{
+  struct stream *s;
+  struct zread_route_hdr hdr;
+  struct prefix p;
+  u_int16_t count, i;
+  u_char plen, maxlen;
+  size_t prefixp, tailp;
+  int family;
+
+  s = client->ibuf;
+
+  if (command == ZEBRA_IPV4_ROUTE_BULK_ADD
+      || command == ZEBRA_IPV4_ROUTE_BULK_DELETE)
+    {
+      family = AF_INET;
+      maxlen = IPV4_MAX_PREFIXLEN;
+    }
+  else
+    {
+      family = AF_INET6;
+      maxlen = IPV6_MAX_PREFIXLEN;
+    }
+
+  if (STREAM_READABLE (s) < 7)
+    goto malformed;
+
+  zread_route_hdr (s, &hdr);
+  count = stream_getw (s);
+
+  /* Skip over the prefixes to find the shared nexthop part. */
+  prefixp = tailp = stream_get_getp (s);
+  for (i = 0; i < count; i++)
+    {
+      if (tailp >= stream_get_endp (s))
+        goto malformed;
+      plen = stream_getc_from (s, tailp);
+      if (plen > maxlen || tailp + 1 + PSIZE (plen) > stream_get_endp (s))
+        goto malformed;
+      tailp += 1 + PSIZE (plen);
+    }
+
+  if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV)
+    zlog_debug ("zebra bulk message carries %u %s routes", count,
+                zebra_route_string (hdr.type));
+
+  for (i = 0; i < count; i++)
+    {
+      stream_set_getp (s, prefixp);
+      zread_route_prefix (s, family, &p);
+      prefixp = stream_get_getp (s);
+
+      /* Rewind to the shared nexthops for every prefix. */
+      stream_set_getp (s, tailp);
+
+      switch (command)
+        {
+        case ZEBRA_IPV4_ROUTE_BULK_ADD:
+          zread_ipv4_add_route (client, &hdr, (struct prefix_ipv4 *) &p);
+          break;
+        case ZEBRA_IPV4_ROUTE_BULK_DELETE:
+          zread_ipv4_delete_route (client, &hdr, (struct prefix_ipv4 *) &p);
+          break;
+#ifdef HAVE_IPV6
+        case ZEBRA_IPV6_ROUTE_BULK_ADD:
+          zread_ipv6_add_route (client, &hdr, (struct prefix_ipv6 *) &p);
+          break;
+        case ZEBRA_IPV6_ROUTE_BULK_DELETE:
+          zread_ipv6_delete_route (client, &hdr, (struct prefix_ipv6 *) &p);
+          break;
+#endif /* HAVE_IPV6 */
+        }
+    }
+
+  return 0;
+
+ malformed:
+  zlog_warn ("%s: socket %d malformed %s", __func__, client->sock,
+             zserv_command_string (command));
+  return -1;
+}
+
 /* Register zebra server router-id information.  Send current router-id */
 static int
 zread_router_id_add (struct zserv *client, u_short length)
@@ -1107,14 +1361,44 @@ zread_router_id_delete (struct zserv *client, u_short length)
   return 0;
 }
 
+/* Answer a client's hello with the capabilities we agreed to. */
+static int
+zsend_hello (struct zserv *client)
+{
+  struct stream *s;
+
+  s = client->obuf;
+  stream_reset (s);
+
+  zserv_create_header (s, ZEBRA_HELLO);
+  stream_putc (s, client->capabilities);
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zebra_server_send_message (client);
+}
+
 /* Tie up route-type and client->sock */
 static void
-zread_hello (struct zserv *client)
+zread_hello (struct zserv *client, u_short length)
 {
   /* type of protocol (lib/zebra.h) */
   u_char proto;
   proto = stream_getc (client->ibuf);
 
+  /* Clients predating capability negotiation send only the protocol,
+     and must not be sent anything they do not understand. */
+  if (length >= 2)
+    {
+      client->capabilities = stream_getc (client->ibuf) & ZEBRA_CAPABILITY_ALL;
+      if (CHECK_FLAG (client->capabilities, ZEBRA_CAPABILITY_BULK_ROUTE)
+          && ! client->bulk)
+        {
+          client->bulk = stream_new (ZEBRA_MAX_PACKET_SIZ);
+          client->bulk_tail = stream_new (ZEBRA_MAX_PACKET_SIZ);
+        }
+      zsend_hello (client);
+    }
+
   /* accept only dynamic routing protocols */
   if ((proto < ZEBRA_ROUTE_MAX)
   &&  (proto > ZEBRA_ROUTE_STATIC))
@@ -1154,6 +1438,8 @@ zebra_score_rib (int client_sock)
 static void
 zebra_client_close (struct zserv *client)
 {
+  zserv_linkmetrics_client_close (client);
+
   /* Close file descriptor. */
   if (client->sock)
     {
@@ -1167,6 +1453,10 @@ zebra_client_close (struct zserv *client)
     stream_free (client->ibuf);
   if (client->obuf)
     stream_free (client->obuf);
+  if (client->bulk)
+    stream_free (client->bulk);
+  if (client->bulk_tail)
+    stream_free (client->bulk_tail);
   if (client->wb)
     buffer_free(client->wb);
 
@@ -1193,7 +1483,7 @@ zebra_client_create (int sock)
 
   /* Make client input/output buffer. */
   client->sock = sock;
-  client->ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  client->ibuf = stream_new (ZEBRA_READ_BUFSIZ);
   client->obuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   client->wb = buffer_new(0);
 
@@ -1207,106 +1497,13 @@ zebra_client_create (int sock)
   zebra_event (ZEBRA_READ, sock, client);
 }
 
-/* Handler of zebra service request. */
-static int
-zebra_client_read (struct thread *thread)
+/* Handle one message from client. */
+static void
+zebra_client_dispatch (struct zserv *client, uint16_t command, uint16_t length)
 {
-  int sock;
-  struct zserv *client;
-  size_t already;
-  uint16_t length, command;
-  uint8_t marker, version;
-
-  /* Get thread data.  Reset reading thread because I'm running. */
-  sock = THREAD_FD (thread);
-  client = THREAD_ARG (thread);
-  client->t_read = NULL;
-
-  if (client->t_suicide)
-    {
-      zebra_client_close(client);
-      return -1;
-    }
-
-  /* Read length and command (if we don't have it already). */
-  if ((already = stream_get_endp(client->ibuf)) < ZEBRA_HEADER_SIZE)
-    {
-      ssize_t nbyte;
-      if (((nbyte = stream_read_try (client->ibuf, sock,
-				     ZEBRA_HEADER_SIZE-already)) == 0) ||
-	  (nbyte == -1))
-	{
-	  if (IS_ZEBRA_DEBUG_EVENT)
-	    zlog_debug ("connection closed socket [%d]", sock);
-	  zebra_client_close (client);
-	  return -1;
-	}
-      if (nbyte != (ssize_t)(ZEBRA_HEADER_SIZE-already))
-	{
-	  /* Try again later. */
-	  zebra_event (ZEBRA_READ, sock, client);
-	  return 0;
-	}
-      already = ZEBRA_HEADER_SIZE;
-    }
-
-  /* Reset to read from the beginning of the incoming packet. */
-  stream_set_getp(client->ibuf, 0);
-
-  /* Fetch header values */
-  length = stream_getw (client->ibuf);
-  marker = stream_getc (client->ibuf);
-  version = stream_getc (client->ibuf);
-  command = stream_getw (client->ibuf);
-
-  if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION)
-    {
-      zlog_err("%s: socket %d version mismatch, marker %d, version %d",
-               __func__, sock, marker, version);
-      zebra_client_close (client);
-      return -1;
-    }
-  if (length < ZEBRA_HEADER_SIZE) 
-    {
-      zlog_warn("%s: socket %d message length %u is less than header size %d",
-	        __func__, sock, length, ZEBRA_HEADER_SIZE);
-      zebra_client_close (client);
-      return -1;
-    }
-  if (length > STREAM_SIZE(client->ibuf))
-    {
-      zlog_warn("%s: socket %d message length %u exceeds buffer size %lu",
-	        __func__, sock, length, (u_long)STREAM_SIZE(client->ibuf));
-      zebra_client_close (client);
-      return -1;
-    }
-
-  /* Read rest of data. */
-  if (already < length)
-    {
-      ssize_t nbyte;
-      if (((nbyte = stream_read_try (client->ibuf, sock,
-				     length-already)) == 0) ||
-	  (nbyte == -1))
-	{
-	  if (IS_ZEBRA_DEBUG_EVENT)
-	    zlog_debug ("connection closed [%d] when reading zebra data", sock);
-	  zebra_client_close (client);
-	  return -1;
-	}
-      if (nbyte != (ssize_t)(length-already))
-        {
-	  /* Try again later. */
-	  zebra_event (ZEBRA_READ, sock, client);
-	  return 0;
-	}
-    }
-
-  length -= ZEBRA_HEADER_SIZE;
-
   /* Debug packet information. */
   if (IS_ZEBRA_DEBUG_EVENT)
-    zlog_debug ("zebra message comes from socket [%d]", sock);
+    zlog_debug ("zebra message comes from socket [%d]", client->sock);
 
   if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV)
     zlog_debug ("zebra message received [%s] %d", 
@@ -1376,24 +1573,159 @@ zebra_client_read (struct thread *thread)
     case ZEBRA_LINKMETRICS_METRICS_REQUEST:
       zserv_recv_linkmetrics_request (client, length);
       break;
+    case ZEBRA_IPV4_ROUTE_BULK_ADD:
+    case ZEBRA_IPV4_ROUTE_BULK_DELETE:
+#ifdef HAVE_IPV6
+    case ZEBRA_IPV6_ROUTE_BULK_ADD:
+    case ZEBRA_IPV6_ROUTE_BULK_DELETE:
+#endif /* HAVE_IPV6 */
+      zread_route_bulk (client, command, length);
+      break;
     case ZEBRA_HELLO:
-      zread_hello (client);
+      zread_hello (client, length);
       break;
     default:
       zlog_info ("Zebra received unknown command %d", command);
       break;
     }
+}
+
+/* Handle every complete message buffered in client->ibuf, in place.
+ * Each handler sees a stream ending with its own message.  A client
+ * may use at most a thread time slot per wakeup: whatever it has
+ * queued beyond that is left for an event, so that one chatty client
+ * cannot starve the others or zebra's own threads. */
+static int
+zebra_client_process (struct zserv *client, struct thread *thread)
+{
+  struct stream *s;
+  size_t frame, endp;
+  uint16_t length, command;
+  uint8_t marker, version;
+
+  s = client->ibuf;
+
+  while (STREAM_READABLE (s) >= ZEBRA_HEADER_SIZE)
+    {
+      /* Fetch header values */
+      frame = stream_get_getp (s);
+      length = stream_getw_from (s, frame);
+      marker = stream_getc_from (s, frame + 2);
+      version = stream_getc_from (s, frame + 3);
+      command = stream_getw_from (s, frame + 4);
+
+      if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION)
+	{
+	  zlog_err("%s: socket %d version mismatch, marker %d, version %d",
+		   __func__, client->sock, marker, version);
+	  zebra_client_close (client);
+	  return -1;
+	}
+      if (length < ZEBRA_HEADER_SIZE) 
+	{
+	  zlog_warn("%s: socket %d message length %u is less than header size %d",
+		    __func__, client->sock, length, ZEBRA_HEADER_SIZE);
+	  zebra_client_close (client);
+	  return -1;
+	}
+      if (length > ZEBRA_MAX_PACKET_SIZ)
+	{
+	  zlog_warn("%s: socket %d message length %u exceeds maximum %d",
+		    __func__, client->sock, length, ZEBRA_MAX_PACKET_SIZ);
+	  zebra_client_close (client);
+	  return -1;
+	}
+
+      /* Wait for the rest of the message. */
+      if (length > STREAM_READABLE (s))
+	break;
+
+      endp = stream_get_endp (s);
+      stream_set_getp (s, frame + ZEBRA_HEADER_SIZE);
+      stream_set_endp (s, frame + length);
+
+      zebra_client_dispatch (client, command, length - ZEBRA_HEADER_SIZE);
+
+      if (client->t_suicide)
+	{
+	  /* No need to wait for thread callback, just kill immediately. */
+	  zebra_client_close(client);
+	  return -1;
+	}
+
+      /* Step over the message, whatever the handler consumed. */
+      stream_set_getp (s, frame + length);
+      stream_forward_endp (s, endp - (frame + length));
+
+      if (STREAM_READABLE (s) >= ZEBRA_HEADER_SIZE
+	  && thread_should_yield (thread))
+	{
+	  if (IS_ZEBRA_DEBUG_EVENT)
+	    zlog_debug ("client %d used its time slot, %lu bytes pending",
+			client->sock, (u_long) STREAM_READABLE (s));
+	  client->t_read = thread_add_event (zebrad.master,
+					     zebra_client_read_resume,
+					     client, client->sock);
+	  return 0;
+	}
+    }
+
+  /* Keep the partial message, if any, at the front of the buffer. */
+  stream_pulldown (s);
+
+  zebra_event (ZEBRA_READ, client->sock, client);
+  return 0;
+}
+
+/* Continue with messages left over when zebra_client_process yielded. */
+static int
+zebra_client_read_resume (struct thread *thread)
+{
+  struct zserv *client;
+
+  client = THREAD_ARG (thread);
+  client->t_read = NULL;
 
   if (client->t_suicide)
     {
-      /* No need to wait for thread callback, just kill immediately. */
       zebra_client_close(client);
       return -1;
     }
 
-  stream_reset (client->ibuf);
-  zebra_event (ZEBRA_READ, sock, client);
-  return 0;
+  return zebra_client_process (client, thread);
+}
+
+/* Handler of zebra service request.  Reads as much as the socket has and
+ * the buffer can take, so a burst of messages costs a single read. */
+static int
+zebra_client_read (struct thread *thread)
+{
+  int sock;
+  struct zserv *client;
+  ssize_t nbyte;
+
+  /* Get thread data.  Reset reading thread because I'm running. */
+  sock = THREAD_FD (thread);
+  client = THREAD_ARG (thread);
+  client->t_read = NULL;
+
+  if (client->t_suicide)
+    {
+      zebra_client_close(client);
+      return -1;
+    }
+
+  nbyte = stream_read_try (client->ibuf, sock,
+			   STREAM_WRITEABLE (client->ibuf));
+  if (nbyte == 0 || nbyte == -1)
+    {
+      if (IS_ZEBRA_DEBUG_EVENT)
+	zlog_debug ("connection closed socket [%d]", sock);
+      zebra_client_close (client);
+      return -1;
+    }
+
+  return zebra_client_process (client, thread);
 }
 
 
@@ -69,6 +69,15 @@ struct zserv
 
   /* nonzero if subscribed to linkmetrics updates */
   u_char linkmetrics_subscribed;
+
+  /* Capabilities agreed to in the hello exchange. */
+  u_char capabilities;
+
+  /* Bulk route message being assembled for this client, and the
+     nexthop part shared by every prefix in it. */
+  struct stream *bulk;
+  struct stream *bulk_tail;
+  u_int16_t bulk_count;
 };
 
 /* Zebra instance */
@@ -110,6 +119,9 @@ extern int zsend_interface_address (int, struct zserv *, struct interface *,
 extern int zsend_interface_update (int, struct zserv *, struct interface *);
 extern int zsend_route_multipath (int, struct zserv *, struct prefix *, 
                                   struct rib *);
+extern int zsend_route_multipath_bulk (int, struct zserv *, struct prefix *,
+                                       struct rib *);
+extern int zsend_route_bulk_flush (struct zserv *);
 extern int zsend_router_id_update(struct zserv *, struct prefix *);
 
 extern pid_t pid;
@@ -26,6 +26,9 @@
 #include "stream.h"
 #include "command.h"
 #include "memory.h"
+#include "linklist.h"
+#include "thread.h"
+#include "zclient.h"
 #include "zebra_linkmetrics.h"
 #include "linkmetrics_netlink.h"
 
@@ -130,8 +133,8 @@ DEFUN (no_linkmetrics_netlink_group,
   return zserv_set_linkmetrics_netlink (vty, lmgenl_family, lmgenl_group);
 }
 
-void
-zserv_linkmetrics_init (void)
+static void
+zserv_linkmetrics_netlink_init (void)
 {
   install_element (CONFIG_NODE, &linkmetrics_netlink_family_cmd);
   install_element (CONFIG_NODE, &no_linkmetrics_netlink_family_cmd);
@@ -140,8 +143,8 @@ zserv_linkmetrics_init (void)
   install_element (CONFIG_NODE, &no_linkmetrics_netlink_group_cmd);
 }
 
-int
-zserv_linkmetrics_config_write (struct vty *vty)
+static void
+zserv_linkmetrics_netlink_config_write (struct vty *vty)
 {
   if (lmgenl_family && strcmp (lmgenl_family, LMGENL_FAMILY_NAME) != 0)
     {
@@ -154,25 +157,327 @@ zserv_linkmetrics_config_write (struct vty *vty)
       vty_out (vty, "netlink linkmetrics-group %s%s",
                lmgenl_group, VTY_NEWLINE);
     }
+}
+
+#endif	/* HAVE_LIBNLGENL */
+
+/* Link metrics updates are queued per interface and originating
+ * client, a later update for a neighbor replacing a queued one, and
+ * sent once per batch interval: as ZEBRA_LINKMETRICS_METRICS_BATCH
+ * frames to clients that negotiated ZEBRA_CAPABILITY_LINKMETRICS_BATCH
+ * and as individual ZEBRA_LINKMETRICS_METRICS messages to the rest.
+ * With an interval of zero, updates read together are sent together.
+ */
+struct zserv_linkmetrics_batch
+{
+  u_int32_t ifindex;
+  struct zserv *origin;		/* NULL when learned from the kernel */
+  struct timeval stamp;		/* when the oldest queued update arrived */
+  u_int16_t count;
+  u_int16_t size;
+  struct zebra_linkmetrics *metrics;
+};
+
+static struct
+{
+  struct list *batches;
+  struct thread *t_flush;
+  unsigned int interval;	/* msec */
+
+  /* statistics */
+  unsigned long updates;	/* updates queued */
+  unsigned long coalesced;	/* updates that replaced a queued one */
+  unsigned long flushed;	/* batches sent */
+  unsigned long frames;		/* batch frames written to clients */
+  unsigned long singles;	/* single updates written to clients */
+  struct thread_hist size;	/* updates per batch */
+  struct thread_hist delay;	/* usec from oldest update to send */
+} lmbatch;
+
+static struct zserv_linkmetrics_batch *
+zserv_linkmetrics_batch_get (u_int32_t ifindex, struct zserv *origin)
+{
+  struct listnode *node;
+  struct zserv_linkmetrics_batch *batch;
+
+  for (ALL_LIST_ELEMENTS_RO (lmbatch.batches, node, batch))
+    if (batch->ifindex == ifindex && batch->origin == origin)
+      return batch;
+
+  batch = XCALLOC (MTYPE_LINKMETRICS_BATCH, sizeof (*batch));
+  batch->ifindex = ifindex;
+  batch->origin = origin;
+  listnode_add (lmbatch.batches, batch);
+
+  return batch;
+}
+
+static void
+zserv_linkmetrics_batch_free (struct zserv_linkmetrics_batch *batch)
+{
+  if (batch->metrics)
+    XFREE (MTYPE_LINKMETRICS_BATCH, batch->metrics);
+  XFREE (MTYPE_LINKMETRICS_BATCH, batch);
+}
+
+static void
+zserv_linkmetrics_batch_send (struct zserv_linkmetrics_batch *batch)
+{
+  struct listnode *node;
+  struct zserv *client;
+  u_int16_t i, n;
+
+  for (ALL_LIST_ELEMENTS_RO (zebrad.client_list, node, client))
+    {
+      if (client == batch->origin || !client->linkmetrics_subscribed)
+        continue;
+
+      if (CHECK_FLAG (client->capabilities,
+                      ZEBRA_CAPABILITY_LINKMETRICS_BATCH))
+        {
+          for (i = 0; i < batch->count; i += n)
+            {
+              n = batch->count - i;
+              if (n > ZAPI_LINKMETRICS_BATCH_MAX)
+                n = ZAPI_LINKMETRICS_BATCH_MAX;
+
+              zapi_write_linkmetrics_batch (client->obuf, &batch->stamp,
+                                            batch->metrics + i, n);
+              if (zebra_server_send_message (client))
+                zlog_warn ("%s: zebra_server_send_message() failed for "
+                           "client on fd %d", __func__, client->sock);
+              lmbatch.frames++;
+            }
+        }
+      else
+        {
+          for (i = 0; i < batch->count; i++)
+            {
+              zapi_write_linkmetrics (client->obuf, &batch->metrics[i]);
+              if (zebra_server_send_message (client))
+                zlog_warn ("%s: zebra_server_send_message() failed for "
+                           "client on fd %d", __func__, client->sock);
+              lmbatch.singles++;
+            }
+        }
+    }
+}
+
+/* Send and free every batch, so that the list only ever holds batches
+ * with updates queued, whatever became of their interface or origin.
+ */
+static int
+zserv_linkmetrics_flush (struct thread *thread)
+{
+  struct listnode *node, *nnode;
+  struct zserv_linkmetrics_batch *batch;
+  struct timeval now;
+  long delay;
+
+  lmbatch.t_flush = NULL;
+  quagga_gettime (QUAGGA_CLK_REALTIME, &now);
+
+  for (ALL_LIST_ELEMENTS (lmbatch.batches, node, nnode, batch))
+    {
+      if (IS_ZEBRA_DEBUG_EVENT)
+        zlog_debug ("%s: sending %u link metrics updates for ifindex %u",
+                    __func__, batch->count, batch->ifindex);
+
+      zserv_linkmetrics_batch_send (batch);
+
+      delay = (now.tv_sec - batch->stamp.tv_sec) * 1000000L +
+        (now.tv_usec - batch->stamp.tv_usec);
+      thread_hist_add (&lmbatch.delay, delay > 0 ? delay : 0);
+      thread_hist_add (&lmbatch.size, batch->count);
+      lmbatch.flushed++;
+
+      list_delete_node (lmbatch.batches, node);
+      zserv_linkmetrics_batch_free (batch);
+    }
 
   return 0;
 }
 
-#else  /* HAVE_LIBNLGENL */
+/* Queue a link metrics update for subscribed zclients other than
+ * origin, which is NULL for updates learned from the kernel.
+ */
+void
+zserv_queue_linkmetrics (struct zebra_linkmetrics *metrics,
+                         struct zserv *origin)
+{
+  struct zserv_linkmetrics_batch *batch;
+  u_int16_t i;
+
+  if (IS_ZEBRA_DEBUG_EVENT)
+    {
+      zlog_debug ("%s: queueing link metrics update", __func__);
+      zebra_linkmetrics_logdebug (metrics);
+    }
+
+  batch = zserv_linkmetrics_batch_get (metrics->ifindex, origin);
+  lmbatch.updates++;
+
+  for (i = 0; i < batch->count; i++)
+    {
+      if (IN6_ARE_ADDR_EQUAL (&batch->metrics[i].nbr_addr6,
+                              &metrics->nbr_addr6) &&
+          batch->metrics[i].nbr_addr4.s_addr == metrics->nbr_addr4.s_addr)
+        {
+          batch->metrics[i] = *metrics;
+          lmbatch.coalesced++;
+          return;
+        }
+    }
+
+  if (batch->count == batch->size)
+    {
+      batch->size = batch->size ? batch->size * 2 : 8;
+      batch->metrics = XREALLOC (MTYPE_LINKMETRICS_BATCH, batch->metrics,
+                                 batch->size * sizeof (*batch->metrics));
+    }
+
+  if (batch->count == 0)
+    quagga_gettime (QUAGGA_CLK_REALTIME, &batch->stamp);
+  batch->metrics[batch->count++] = *metrics;
+
+  if (lmbatch.t_flush == NULL)
+    {
+      if (lmbatch.interval)
+        lmbatch.t_flush = thread_add_timer_msec (zebrad.master,
+                                                 zserv_linkmetrics_flush,
+                                                 NULL, lmbatch.interval);
+      else
+        lmbatch.t_flush = thread_add_event (zebrad.master,
+                                            zserv_linkmetrics_flush,
+                                            NULL, 0);
+    }
+}
+
+/* Drop updates queued on behalf of a client that is going away. */
+void
+zserv_linkmetrics_client_close (struct zserv *client)
+{
+  struct listnode *node, *nnode;
+  struct zserv_linkmetrics_batch *batch;
+
+  for (ALL_LIST_ELEMENTS (lmbatch.batches, node, nnode, batch))
+    {
+      if (batch->origin == client)
+        {
+          list_delete_node (lmbatch.batches, node);
+          zserv_linkmetrics_batch_free (batch);
+        }
+    }
+}
+
+DEFUN (linkmetrics_batch_interval,
+       linkmetrics_batch_interval_cmd,
+       "linkmetrics batch-interval <0-10000>",
+       "Link metrics configuration\n"
+       "Interval over which link metrics updates are batched\n"
+       "Milliseconds\n")
+{
+  VTY_GET_INTEGER_RANGE ("batch interval", lmbatch.interval, argv[0],
+                         0, 10000);
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_linkmetrics_batch_interval,
+       no_linkmetrics_batch_interval_cmd,
+       "no linkmetrics batch-interval",
+       NO_STR
+       "Link metrics configuration\n"
+       "Interval over which link metrics updates are batched\n")
+{
+  lmbatch.interval = 0;
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_linkmetrics_batch_interval,
+       no_linkmetrics_batch_interval_val_cmd,
+       "no linkmetrics batch-interval <0-10000>",
+       NO_STR
+       "Link metrics configuration\n"
+       "Interval over which link metrics updates are batched\n"
+       "Milliseconds\n")
+
+DEFUN (show_zebra_linkmetrics,
+       show_zebra_linkmetrics_cmd,
+       "show zebra linkmetrics",
+       SHOW_STR
+       "Zebra information\n"
+       "Link metrics batching statistics\n")
+{
+  struct listnode *node;
+  struct zserv *client;
+
+  vty_out (vty, "Link metrics batch interval %u msec%s",
+           lmbatch.interval, VTY_NEWLINE);
+  vty_out (vty, "  Updates queued %lu, coalesced %lu%s",
+           lmbatch.updates, lmbatch.coalesced, VTY_NEWLINE);
+  vty_out (vty, "  Batches sent %lu, as %lu batch frames and "
+           "%lu single updates%s", lmbatch.flushed, lmbatch.frames,
+           lmbatch.singles, VTY_NEWLINE);
+  vty_out (vty, "  %-18s %8s %8s %8s %8s %8s%s", "",
+           "count", "p50", "p99", "p99.9", "max", VTY_NEWLINE);
+  vty_out_thread_hist_row (vty, "Batch size", &lmbatch.size);
+  vty_out_thread_hist_row (vty, "Queue delay (usec)", &lmbatch.delay);
+
+  for (ALL_LIST_ELEMENTS_RO (zebrad.client_list, node, client))
+    if (client->linkmetrics_subscribed)
+      vty_out (vty, "  Subscribed client fd %d%s%s", client->sock,
+               CHECK_FLAG (client->capabilities,
+                           ZEBRA_CAPABILITY_LINKMETRICS_BATCH) ?
+               " (batch)" : "", VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (clear_zebra_linkmetrics,
+       clear_zebra_linkmetrics_cmd,
+       "clear zebra linkmetrics",
+       CLEAR_STR
+       "Zebra information\n"
+       "Link metrics batching statistics\n")
+{
+  lmbatch.updates = lmbatch.coalesced = 0;
+  lmbatch.flushed = lmbatch.frames = lmbatch.singles = 0;
+  memset (&lmbatch.size, 0, sizeof (lmbatch.size));
+  memset (&lmbatch.delay, 0, sizeof (lmbatch.delay));
+  return CMD_SUCCESS;
+}
 
 void
 zserv_linkmetrics_init (void)
 {
+  lmbatch.batches = list_new ();
+
+  install_element (CONFIG_NODE, &linkmetrics_batch_interval_cmd);
+  install_element (CONFIG_NODE, &no_linkmetrics_batch_interval_cmd);
+  install_element (CONFIG_NODE, &no_linkmetrics_batch_interval_val_cmd);
+  install_element (VIEW_NODE, &show_zebra_linkmetrics_cmd);
+  install_element (ENABLE_NODE, &show_zebra_linkmetrics_cmd);
+  install_element (ENABLE_NODE, &clear_zebra_linkmetrics_cmd);
+
+#ifdef HAVE_LIBNLGENL
+  zserv_linkmetrics_netlink_init ();
+#endif	/* HAVE_LIBNLGENL */
 }
 
 int
 zserv_linkmetrics_config_write (struct vty *vty)
 {
+#ifdef HAVE_LIBNLGENL
+  zserv_linkmetrics_netlink_config_write (vty);
+#endif	/* HAVE_LIBNLGENL */
+
+  if (lmbatch.interval)
+    vty_out (vty, "linkmetrics batch-interval %u%s",
+             lmbatch.interval, VTY_NEWLINE);
+
   return 0;
 }
 
-#endif	/* HAVE_LIBNLGENL */
-
 /* Send a link metrics update to subscribed zclients
  *
  * If provided, skip the excluded client
@@ -354,7 +659,7 @@ zserv_recv_linkmetrics (struct zserv *client, uint16_t length)
     }
 
   /* forward to subscribed zclients, but exclude sender */
-  zserv_send_linkmetrics (&metrics, client);
+  zserv_queue_linkmetrics (&metrics, client);
 
   return r;
 }
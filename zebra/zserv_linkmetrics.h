@@ -32,6 +32,9 @@ int zserv_linkmetrics_config_write (struct vty *vty);
 
 int zserv_send_linkmetrics (struct zebra_linkmetrics *metrics,
                             struct zserv *exclude_client);
+void zserv_queue_linkmetrics (struct zebra_linkmetrics *metrics,
+                              struct zserv *origin);
+void zserv_linkmetrics_client_close (struct zserv *client);
 int zserv_send_linkmetrics_request (struct zebra_linkmetrics_request *request,
                                     struct zserv *exclude_client);
 int zserv_send_linkstatus (struct zebra_linkstatus *status,